@@ -53,10 +53,24 @@ public:
     {
     public:
         using SharedPtr = std::shared_ptr<ReadTextureTask>;
-        static SharedPtr create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex);
+        static SharedPtr create(
+            CopyContext* pCtx,
+            const Texture* pTexture,
+            uint32_t subresourceIndex,
+            ref<Buffer> pStagingBuffer = nullptr
+        );
         void getData(void* pData, size_t size) const;
         std::vector<uint8_t> getData() const;
 
+        /// Returns the size of the data returned by getData() in bytes.
+        size_t getDataSize() const { return size_t(mRowCount) * mActualRowSize * mDepth; }
+
+        /// Returns true if the GPU has finished the copy, i.e. getData() will not block.
+        bool isReady() const;
+
+        /// Returns the readback buffer holding the data. It can be passed to a later read once getData() has returned.
+        const ref<Buffer>& getStagingBuffer() const { return mpBuffer; }
+
     private:
         ReadTextureTask() = default;
         ref<Fence> mpFence;
@@ -221,8 +235,15 @@ public:
 
     /**
      * Read texture data Asynchronously
+     * @param[in] pTexture Texture to read from.
+     * @param[in] subresourceIndex Subresource to read.
+     * @param[in] pStagingBuffer Optional readback buffer from a completed read to reuse. A new buffer is created if it is too small.
      */
-    ReadTextureTask::SharedPtr asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex);
+    ReadTextureTask::SharedPtr asyncReadTextureSubresource(
+        const Texture* pTexture,
+        uint32_t subresourceIndex,
+        ref<Buffer> pStagingBuffer = nullptr
+    );
 
     /**
      * Get the low-level context data
@@ -361,6 +361,28 @@ ref<Texture> Texture::createMippedFromFiles(
     return pTex;
 }
 
+ref<Texture> Texture::createFromBitmap(
+    ref<Device> pDevice,
+    const Bitmap& bitmap,
+    bool generateMipLevels,
+    bool loadAsSrgb,
+    ResourceBindFlags bindFlags,
+    Bitmap::ImportFlags importFlags
+)
+{
+    ResourceFormat texFormat = bitmap.getFormat();
+    if (loadAsSrgb)
+    {
+        texFormat = linearToSrgbFormat(texFormat);
+    }
+
+    ref<Texture> pTex = pDevice->createTexture2D(
+        bitmap.getWidth(), bitmap.getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, bitmap.getData(), bindFlags
+    );
+    pTex->mImportFlags = importFlags;
+    return pTex;
+}
+
 ref<Texture> Texture::createFromFile(
     ref<Device> pDevice,
     const std::filesystem::path& path,
@@ -393,21 +415,7 @@ ref<Texture> Texture::createFromFile(
         Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(path, kTopDown, importFlags);
         if (pBitmap)
         {
-            ResourceFormat texFormat = pBitmap->getFormat();
-            if (loadAsSrgb)
-            {
-                texFormat = linearToSrgbFormat(texFormat);
-            }
-
-            pTex = pDevice->createTexture2D(
-                pBitmap->getWidth(),
-                pBitmap->getHeight(),
-                texFormat,
-                1,
-                generateMipLevels ? Texture::kMaxPossible : 1,
-                pBitmap->getData(),
-                bindFlags
-            );
+            pTex = createFromBitmap(pDevice, *pBitmap, generateMipLevels, loadAsSrgb, bindFlags, importFlags);
         }
     }
 
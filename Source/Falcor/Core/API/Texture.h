@@ -195,6 +195,24 @@ public:
         Bitmap::ImportFlags importFlags = Bitmap::ImportFlags::None
     );
 
+    /**
+     * Create a new texture object from a bitmap.
+     * @param[in] bitmap Bitmap holding the image in top-down row order.
+     * @param[in] generateMipLevels Whether the mip-chain should be generated.
+     * @param[in] loadAsSrgb Create the texture using sRGB format. Only valid for 3 or 4 component textures.
+     * @param[in] bindFlags The bind flags to create the texture with.
+     * @param[in] importFlags Flags the bitmap was imported with, stored with the texture.
+     * @return A new texture.
+     */
+    static ref<Texture> createFromBitmap(
+        ref<Device> pDevice,
+        const Bitmap& bitmap,
+        bool generateMipLevels,
+        bool loadAsSrgb,
+        ResourceBindFlags bindFlags = ResourceBindFlags::ShaderResource,
+        Bitmap::ImportFlags importFlags = Bitmap::ImportFlags::None
+    );
+
     gfx::ITextureResource* getGfxTextureResource() const { return mGfxTextureResource; }
 
     virtual gfx::IResource* getGfxResource() const override;
@@ -29,7 +29,6 @@
 #include "EmissiveLightSampler.h"
 #include "Core/Macros.h"
 #include "Scene/Lights/LightCollection.h"
-#include <random>
 #include <vector>
 
 namespace Falcor
@@ -70,7 +69,7 @@ namespace Falcor
         virtual void bindShaderData(const ShaderVar& var) const override;
 
     protected:
-        /** Generate an alias table
+        /** Generate an alias table. The table is built with Falcor::AliasTable and packed into the compressed format.
             \param[in] weights  The weights we'd like to sample each entry proportional to
             \returns The alias table
         */
@@ -78,8 +77,6 @@ namespace Falcor
 
         // Internal state
         bool                            mNeedsRebuild = true;   ///< Trigger rebuild on the next call to update(). We should always build on the first call, so the initial value is true.
-
-        std::mt19937                    mAliasTableRng;
         AliasTable                      mTriangleTable;
     };
 }
@@ -36,9 +36,9 @@ namespace Falcor
     {
         const char kShaderFilenameSetup[] = "Rendering/Lights/EnvMapSamplerSetup.cs.slang";
 
-        // The defaults are 512x512 @ 64spp in the resampling step.
-        const uint32_t kDefaultDimension = 512;
-        const uint32_t kDefaultSpp = 64;
+        // The defaults are 512x512 @ 64spp in the resampling step. These match the defaults of the CPU-side builder.
+        const uint32_t kDefaultDimension = EnvMapImportanceMap::kDefaultDimension;
+        const uint32_t kDefaultSpp = EnvMapImportanceMap::kDefaultSamples;
     }
 
     EnvMapSampler::EnvMapSampler(ref<Device> pDevice, ref<EnvMap> pEnvMap)
@@ -47,9 +47,6 @@ namespace Falcor
     {
         FALCOR_ASSERT(pEnvMap);
 
-        // Create compute program for the setup phase.
-        mpSetupPass = ComputePass::create(mpDevice, kShaderFilenameSetup, "main");
-
         // Create sampler.
         Sampler::Desc samplerDesc;
         samplerDesc.setFilterMode(TextureFilteringMode::Point, TextureFilteringMode::Point, TextureFilteringMode::Point);
@@ -87,6 +84,19 @@ namespace Falcor
         FALCOR_ASSERT((1u << (mips - 1)) == dimension);
         FALCOR_ASSERT(mips > 1 && mips <= 12);     // Shader constant limits max resolution, increase if needed.
 
+        // Upload the importance map if it was built on the CPU when loading the environment map.
+        const auto& pCpuImportanceMap = mpEnvMap->getImportanceMap();
+        if (pCpuImportanceMap && pCpuImportanceMap->getDimension() == dimension)
+        {
+            FALCOR_ASSERT(pCpuImportanceMap->getMipCount() == mips);
+            const float* pData = pCpuImportanceMap->getData().data();
+            mpImportanceMap = mpDevice->createTexture2D(dimension, dimension, ResourceFormat::R32Float, 1, mips, pData, ResourceBindFlags::ShaderResource);
+            return mpImportanceMap != nullptr;
+        }
+
+        // Create compute program for the setup phase.
+        if (!mpSetupPass) mpSetupPass = ComputePass::create(mpDevice, kShaderFilenameSetup, "main");
+
         // Create importance map. We have to set the RTV flag to be able to use generateMips().
         mpImportanceMap = mpDevice->createTexture2D(dimension, dimension, ResourceFormat::R32Float, 1, mips, nullptr, ResourceBindFlags::ShaderResource | ResourceBindFlags::RenderTarget | ResourceBindFlags::UnorderedAccess);
         FALCOR_ASSERT(mpImportanceMap);
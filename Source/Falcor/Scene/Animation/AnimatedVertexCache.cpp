@@ -92,6 +92,44 @@ namespace Falcor
 
             return InterpolationInfo{ keyframeIndices, t };
         }
+
+        /** Assign two keyframes to the two keyframe slots of a streamed cache, keeping keyframes that are already held by a slot.
+            \param[in,out] slotKeyframes Keyframe held by each slot.
+            \param[in] keyframes Keyframes to interpolate between.
+            \param[out] load Set for each slot that needs to be loaded with its new keyframe.
+            \return Slot of each keyframe.
+        */
+        uint2 assignKeyframeSlots(uint2& slotKeyframes, uint2 keyframes, bool load[2])
+        {
+            auto findSlot = [&](uint32_t keyframe) { return slotKeyframes.x == keyframe ? 0 : (slotKeyframes.y == keyframe ? 1 : -1); };
+            int first = findSlot(keyframes.x);
+            int second = findSlot(keyframes.y);
+
+            if (keyframes.x == keyframes.y)
+            {
+                if (first < 0) first = 0;
+                second = first;
+            }
+            else if (first < 0 && second < 0)
+            {
+                first = 0;
+                second = 1;
+            }
+            else if (first < 0) first = 1 - second;
+            else if (second < 0) second = 1 - first;
+
+            uint2 slots(first, second);
+            load[0] = load[1] = false;
+            for (uint32_t i = 0; i < 2; i++)
+            {
+                if (slotKeyframes[slots[i]] != keyframes[i])
+                {
+                    slotKeyframes[slots[i]] = keyframes[i];
+                    load[slots[i]] = true;
+                }
+            }
+            return slots;
+        }
     }
 
     AnimatedVertexCache::AnimatedVertexCache(ref<Device> pDevice, Scene* pScene, const ref<Buffer>& pPrevVertexData, std::vector<CachedCurve>&& cachedCurves, std::vector<CachedMesh>&& cachedMeshes)
@@ -103,6 +141,8 @@ namespace Falcor
     {
         if (mCachedCurves.empty() && mCachedMeshes.empty()) return;
 
+        initStreams();
+
         if (!mCachedCurves.empty())
         {
             for (auto& cache : mCachedCurves)
@@ -146,6 +186,7 @@ namespace Falcor
         {
             double curveTime = mLoopAnimations ? std::fmod(time, mGlobalCurveAnimationLength) : time;
             InterpolationInfo interpolationInfo = calculateInterpolation(curveTime, mCurveKeyframeTimes, mPreInfinityBehavior, Animation::Behavior::Constant);
+            if (!mCurveStreams.empty()) interpolationInfo = uploadStreamedCurveKeyframes(interpolationInfo);
 
             if (mCurveLSSCount > 0)
             {
@@ -191,9 +232,126 @@ namespace Falcor
         for (size_t i = 0; i < mpMeshVertexBuffers.size(); i++) m += mpMeshVertexBuffers[i] ? mpMeshVertexBuffers[i]->getSize() : 0;
         m += mpMeshInterpolationBuffer ? mpMeshInterpolationBuffer->getSize() : 0;
         m += mpMeshMetadataBuffer ? mpMeshMetadataBuffer->getSize() : 0;
+        for (const auto& pStream : mCurveStreams) m += pStream->getMemoryUsageInBytes();
+        for (const auto& pStream : mMeshStreams) m += pStream ? pStream->getMemoryUsageInBytes() : 0;
         return m;
     }
 
+    VertexCacheStream::Stats AnimatedVertexCache::getStreamingStats() const
+    {
+        VertexCacheStream::Stats stats;
+        auto add = [&](const std::unique_ptr<VertexCacheStream>& pStream)
+        {
+            if (!pStream) return;
+            auto s = pStream->getStats();
+            stats.keyframesRequested += s.keyframesRequested;
+            stats.keyframesDecoded += s.keyframesDecoded;
+            stats.compressedBytes += s.compressedBytes;
+            stats.decodedBytes += s.decodedBytes;
+            stats.stallCount += s.stallCount;
+            stats.stallTime += s.stallTime;
+            stats.decodeTime += s.decodeTime;
+        };
+        for (const auto& pStream : mCurveStreams) add(pStream);
+        for (const auto& pStream : mMeshStreams) add(pStream);
+        return stats;
+    }
+
+    void AnimatedVertexCache::initStreams()
+    {
+        // Open the vertex cache files of streamed caches. The worker threads start decoding the first keyframes right away.
+        auto openStream = [](const std::filesystem::path& path, std::vector<double>& timeSamples, uint32_t vertexStride)
+        {
+            auto pStream = std::make_unique<VertexCacheStream>(path);
+            const auto& file = pStream->getFile();
+            if (file.getVertexStride() != vertexStride) FALCOR_THROW("Vertex cache file '{}' has vertex stride {}, expected {}.", path, file.getVertexStride(), vertexStride);
+            if (timeSamples.empty()) timeSamples = file.getTimeSamples();
+            if (timeSamples != file.getTimeSamples()) FALCOR_THROW("Vertex cache file '{}' has different time samples than the cache.", path);
+            return pStream;
+        };
+
+        size_t streamedCurveCount = std::count_if(mCachedCurves.begin(), mCachedCurves.end(), [](const CachedCurve& cache) { return !cache.streamPath.empty(); });
+        if (streamedCurveCount > 0)
+        {
+            FALCOR_CHECK(streamedCurveCount == mCachedCurves.size(), "Cached curves must either all be streamed or all be held in memory");
+            for (auto& cache : mCachedCurves)
+            {
+                mCurveStreams.push_back(openStream(cache.streamPath, cache.timeSamples, sizeof(DynamicCurveVertexData)));
+            }
+            for (const auto& cache : mCachedCurves)
+            {
+                // Streamed curves are uploaded per keyframe, so the curves can't be resampled to a merged list of time samples.
+                FALCOR_CHECK(cache.timeSamples == mCachedCurves.front().timeSamples, "Streamed cached curves must have the same time samples");
+            }
+        }
+        mCurveByteOffsets.resize(mCachedCurves.size());
+
+        mMeshStreams.resize(mCachedMeshes.size());
+        mMeshSlotKeyframes.resize(mCachedMeshes.size(), uint2(VertexCacheFile::State::kInvalidKeyframe));
+        for (size_t i = 0; i < mCachedMeshes.size(); i++)
+        {
+            auto& cache = mCachedMeshes[i];
+            if (cache.streamPath.empty()) continue;
+
+            mMeshStreams[i] = openStream(cache.streamPath, cache.timeSamples, sizeof(PackedStaticVertexData));
+            uint32_t vertexCount = mpScene->getMesh(cache.meshID).vertexCount;
+            if (mMeshStreams[i]->getFile().getVertexCount() != vertexCount) FALCOR_THROW("Vertex cache file '{}' has a vertex count mismatch.", cache.streamPath);
+        }
+    }
+
+    uint32_t AnimatedVertexCache::getCurveVertexCount(size_t curveIndex) const
+    {
+        return mCurveStreams.empty() ? (uint32_t)mCachedCurves[curveIndex].vertexData[0].size() : mCurveStreams[curveIndex]->getFile().getVertexCount();
+    }
+
+    InterpolationInfo AnimatedVertexCache::uploadStreamedCurveKeyframes(const InterpolationInfo& info)
+    {
+        bool load[2];
+        uint2 slots = assignKeyframeSlots(mCurveSlotKeyframes, info.keyframeIndices, load);
+
+        if (load[0] || load[1])
+        {
+            for (size_t i = 0; i < mCachedCurves.size(); i++)
+            {
+                auto [pFirst, pSecond] = mCurveStreams[i]->getKeyframes(info.keyframeIndices.x, info.keyframeIndices.y);
+                const void* pSlotData[2];
+                pSlotData[slots.x] = pFirst;
+                pSlotData[slots.y] = pSecond;
+
+                const auto& buffers = mCachedCurves[i].tessellationMode == CurveTessellationMode::LinearSweptSphere ? mpCurveVertexBuffers : mpCurvePolyTubeVertexBuffers;
+                uint32_t byteSize = getCurveVertexCount(i) * sizeof(DynamicCurveVertexData);
+                for (uint32_t slot = 0; slot < 2; slot++)
+                {
+                    if (load[slot]) buffers[slot]->setBlob(pSlotData[slot], mCurveByteOffsets[i], byteSize);
+                }
+            }
+        }
+
+        return InterpolationInfo{ slots, info.t };
+    }
+
+    InterpolationInfo AnimatedVertexCache::uploadStreamedMeshKeyframes(size_t meshIndex, const InterpolationInfo& info)
+    {
+        bool load[2];
+        uint2 slots = assignKeyframeSlots(mMeshSlotKeyframes[meshIndex], info.keyframeIndices, load);
+
+        if (load[0] || load[1])
+        {
+            auto [pFirst, pSecond] = mMeshStreams[meshIndex]->getKeyframes(info.keyframeIndices.x, info.keyframeIndices.y);
+            const void* pSlotData[2];
+            pSlotData[slots.x] = pFirst;
+            pSlotData[slots.y] = pSecond;
+
+            uint32_t byteSize = mMeshStreams[meshIndex]->getFile().getVertexCount() * sizeof(PackedStaticVertexData);
+            for (uint32_t slot = 0; slot < 2; slot++)
+            {
+                if (load[slot]) mpMeshVertexBuffers[mMeshKeyframeBufferOffsets[meshIndex] + slot]->setBlob(pSlotData[slot], 0, byteSize);
+            }
+        }
+
+        return InterpolationInfo{ slots, info.t };
+    }
+
     // We create a merged list of all timestamps and generate new frames for curves where those timestamps are missing.
     // This can lead to fairly heavy overhead if we have cached curves with vastly different total length.
     // Currently, our assets have cached curves with the same list of timestamps.
@@ -220,14 +378,14 @@ namespace Falcor
         {
             if (mCachedCurves[i].tessellationMode != CurveTessellationMode::LinearSweptSphere) continue;
 
-            mCurveVertexCount += (uint32_t)mCachedCurves[i].vertexData[0].size();
+            mCurveVertexCount += getCurveVertexCount(i);
             mCurveIndexCount += (uint32_t)mCachedCurves[i].indexData.size();
         }
 
         // Create buffers for vertex positions in curve vertex caches.
         ResourceBindFlags vbBindFlags = ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess;
-        mpCurveVertexBuffers.resize(mCurveKeyframeTimes.size());
-        for (uint32_t i = 0; i < mCurveKeyframeTimes.size(); i++)
+        mpCurveVertexBuffers.resize(getCurveKeyframeSlotCount());
+        for (uint32_t i = 0; i < mpCurveVertexBuffers.size(); i++)
         {
             mpCurveVertexBuffers[i] = mpDevice->createStructuredBuffer(sizeof(DynamicCurveVertexData), mCurveVertexCount, vbBindFlags, MemoryType::DeviceLocal, nullptr, false);
             mpCurveVertexBuffers[i]->setName("AnimatedVertexCache::mpCurveVertexBuffers[" + std::to_string(i) + "]");
@@ -243,10 +401,19 @@ namespace Falcor
         {
             if (mCachedCurves[i].tessellationMode != CurveTessellationMode::LinearSweptSphere) continue;
 
-            size_t vertexCount = mCachedCurves[i].vertexData[0].size();
+            size_t vertexCount = getCurveVertexCount(i);
             uint32_t bufSize = uint32_t(vertexCount * sizeof(DynamicCurveVertexData));
             uint32_t k = 0;
             const auto& timeSamples = mCachedCurves[i].timeSamples;
+            mCurveByteOffsets[i] = offset;
+
+            // Streamed keyframes are uploaded during playback.
+            if (!mCurveStreams.empty())
+            {
+                mpPrevCurveVertexBuffer->setBlob(mCurveStreams[i]->getKeyframes(0, 0).first, offset, bufSize);
+                offset += bufSize;
+                continue;
+            }
 
             for (uint32_t j = 0; j < mCurveKeyframeTimes.size(); j++)
             {
@@ -315,7 +482,7 @@ namespace Falcor
             PerCurveMetadata curveMeta;
             curveMeta.indexCount = (uint32_t)cache.indexData.size();
             curveMeta.indexOffset = mCurvePolyTubeIndexCount;
-            curveMeta.vertexCount = (uint32_t)cache.vertexData[0].size();
+            curveMeta.vertexCount = getCurveVertexCount(i);
             curveMeta.vertexOffset = mCurvePolyTubeVertexCount;
             curveMetadata.push_back(curveMeta);
 
@@ -339,8 +506,8 @@ namespace Falcor
 
         // Create buffers for vertex positions in curve vertex caches.
         ResourceBindFlags vbBindFlags = ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess;
-        mpCurvePolyTubeVertexBuffers.resize(mCurveKeyframeTimes.size());
-        for (uint32_t i = 0; i < mCurveKeyframeTimes.size(); i++)
+        mpCurvePolyTubeVertexBuffers.resize(getCurveKeyframeSlotCount());
+        for (uint32_t i = 0; i < mpCurvePolyTubeVertexBuffers.size(); i++)
         {
             mpCurvePolyTubeVertexBuffers[i] = mpDevice->createStructuredBuffer(sizeof(DynamicCurveVertexData), mCurvePolyTubeVertexCount, vbBindFlags, MemoryType::DeviceLocal, nullptr, false);
             mpCurvePolyTubeVertexBuffers[i]->setName("AnimatedVertexCache::mpCurvePolyTubeVertexBuffers[" + std::to_string(i) + "]");
@@ -352,10 +519,18 @@ namespace Falcor
         {
             if (mCachedCurves[i].tessellationMode != CurveTessellationMode::PolyTube) continue;
 
-            size_t vertexCount = mCachedCurves[i].vertexData[0].size();
+            size_t vertexCount = getCurveVertexCount(i);
             uint32_t bufSize = uint32_t(vertexCount * sizeof(DynamicCurveVertexData));
             uint32_t k = 0;
             const auto& timeSamples = mCachedCurves[i].timeSamples;
+            mCurveByteOffsets[i] = offset;
+
+            // Streamed keyframes are uploaded during playback.
+            if (!mCurveStreams.empty())
+            {
+                offset += bufSize;
+                continue;
+            }
 
             for (uint32_t j = 0; j < mCurveKeyframeTimes.size(); j++)
             {
@@ -425,11 +600,13 @@ namespace Falcor
 
     void AnimatedVertexCache::initMeshKeyframes()
     {
-        for (const auto& cache : mCachedMeshes)
+        for (size_t i = 0; i < mCachedMeshes.size(); i++)
         {
+            const auto& cache = mCachedMeshes[i];
             mGlobalMeshAnimationLength = std::max(mGlobalMeshAnimationLength, cache.timeSamples.back());
-            mMeshKeyframeCount += (uint32_t)cache.timeSamples.size();
-            mMaxMeshVertexCount = std::max((uint32_t)cache.vertexData.front().size(), mMaxMeshVertexCount);
+            mMeshKeyframeBufferOffsets.push_back(mMeshKeyframeCount);
+            mMeshKeyframeCount += mMeshStreams[i] ? kStreamedKeyframeSlotCount : (uint32_t)cache.timeSamples.size();
+            mMaxMeshVertexCount = std::max(mpScene->getMesh(cache.meshID).vertexCount, mMaxMeshVertexCount);
         }
     }
 
@@ -439,18 +616,32 @@ namespace Falcor
         std::vector<PerMeshMetadata> meshMetadata;
         meshMetadata.reserve(mCachedMeshes.size());
 
-        uint32_t keyframeOffset = 0;
-        for (auto& cache : mCachedMeshes)
+        for (size_t meshIndex = 0; meshIndex < mCachedMeshes.size(); meshIndex++)
         {
-            FALCOR_ASSERT(cache.vertexData.front().size() == mpScene->getMesh(cache.meshID).vertexCount);
+            auto& cache = mCachedMeshes[meshIndex];
+            uint32_t keyframeOffset = mMeshKeyframeBufferOffsets[meshIndex];
 
             PerMeshMetadata meta;
             meta.keyframeBufferOffset = keyframeOffset;
-            meta.vertexCount = (uint32_t)cache.vertexData.front().size();
+            meta.vertexCount = mpScene->getMesh(cache.meshID).vertexCount;
             meta.sceneVbOffset = mpScene->getMesh(cache.meshID).vbOffset;
             meta.prevVbOffset = mpScene->getMesh(cache.meshID).prevVbOffset;
             meshMetadata.push_back(meta);
 
+            // Streamed keyframes are uploaded to the keyframe slots during playback.
+            if (mMeshStreams[meshIndex])
+            {
+                for (uint32_t slot = 0; slot < kStreamedKeyframeSlotCount; slot++)
+                {
+                    size_t index = keyframeOffset + slot;
+                    mpMeshVertexBuffers[index] = mpDevice->createStructuredBuffer(sizeof(PackedStaticVertexData), meta.vertexCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, nullptr, false);
+                    mpMeshVertexBuffers[index]->setName("AnimatedVertexCache::mpMeshVertexBuffers[" + std::to_string(index) + "]");
+                }
+                continue;
+            }
+
+            FALCOR_ASSERT(cache.vertexData.front().size() == meta.vertexCount);
+
             // Create vertex buffer for each keyframe on this mesh
             for (size_t i = 0; i < cache.vertexData.size(); i++)
             {
@@ -459,8 +650,6 @@ namespace Falcor
                 mpMeshVertexBuffers[index] = mpDevice->createStructuredBuffer(sizeof(PackedStaticVertexData), (uint32_t)data.size(), ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, data.data(), false);
                 mpMeshVertexBuffers[index]->setName("AnimatedVertexCache::mpMeshVertexBuffers[" + std::to_string(index) + "]");
             }
-
-            keyframeOffset += (uint32_t)cache.timeSamples.size();
         }
 
         mpMeshMetadataBuffer = mpDevice->createStructuredBuffer(sizeof(PerMeshMetadata), (uint32_t)meshMetadata.size(), ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, meshMetadata.data(), false);
@@ -495,7 +684,7 @@ namespace Falcor
         FALCOR_ASSERT(mCurveLSSCount > 0);
 
         DefineList defines;
-        defines.add("CURVE_KEYFRAME_COUNT", std::to_string(mCurveKeyframeTimes.size()));
+        defines.add("CURVE_KEYFRAME_COUNT", std::to_string(getCurveKeyframeSlotCount()));
         mpScene->getMeshStaticData().getShaderDefines(defines);
         mpCurveVertexUpdatePass = ComputePass::create(mpDevice, kUpdateCurveVerticesFilename, "main", defines);
 
@@ -503,7 +692,7 @@ namespace Falcor
         auto var = block["curvePerKeyframe"];
 
         // Bind curve vertex data.
-        for (uint32_t i = 0; i < mCurveKeyframeTimes.size(); i++) var[i]["vertexData"] = mpCurveVertexBuffers[i];
+        for (uint32_t i = 0; i < mpCurveVertexBuffers.size(); i++) var[i]["vertexData"] = mpCurveVertexBuffers[i];
     }
 
     void AnimatedVertexCache::createCurveLSSAABBUpdatePass()
@@ -521,7 +710,7 @@ namespace Falcor
         FALCOR_ASSERT(mCurvePolyTubeCount > 0);
 
         DefineList defines;
-        defines.add("CURVE_KEYFRAME_COUNT", std::to_string(mCurveKeyframeTimes.size()));
+        defines.add("CURVE_KEYFRAME_COUNT", std::to_string(getCurveKeyframeSlotCount()));
         mpScene->getMeshStaticData().getShaderDefines(defines);
         mpCurvePolyTubeVertexUpdatePass = ComputePass::create(mpDevice, kUpdateCurvePolyTubeVerticesFilename, "main", defines);
 
@@ -532,7 +721,7 @@ namespace Falcor
         auto var = block["curvePerKeyframe"];
 
         // Bind curve vertex data.
-        for (uint32_t i = 0; i < mCurveKeyframeTimes.size(); i++) var[i]["vertexData"] = mpCurvePolyTubeVertexBuffers[i];
+        for (uint32_t i = 0; i < mpCurvePolyTubeVertexBuffers.size(); i++) var[i]["vertexData"] = mpCurvePolyTubeVertexBuffers[i];
     }
 
 
@@ -547,6 +736,12 @@ namespace Falcor
         {
             auto postInfinityBehavior = mLoopAnimations ? Animation::Behavior::Cycle : Animation::Behavior::Constant;
             mMeshInterpolationInfo[i] = calculateInterpolation(t, mCachedMeshes[i].timeSamples, mPreInfinityBehavior, postInfinityBehavior);
+
+            // Streamed meshes interpolate between their keyframe slots. Keyframes are not read when copying the previous vertices.
+            if (mMeshStreams[i])
+            {
+                mMeshInterpolationInfo[i] = copyPrev ? InterpolationInfo{ uint2(0), 0.f } : uploadStreamedMeshKeyframes(i, mMeshInterpolationInfo[i]);
+            }
         }
 
         mpMeshInterpolationBuffer->setBlob(mMeshInterpolationInfo.data(), 0, mpMeshInterpolationBuffer->getSize());
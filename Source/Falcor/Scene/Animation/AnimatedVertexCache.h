@@ -28,6 +28,7 @@
 #pragma once
 #include "Animation.h"
 #include "SharedTypes.slang"
+#include "VertexCacheStream.h"
 #include "Core/API/Buffer.h"
 #include "Core/Pass/ComputePass.h"
 #include "Scene/Curves/CurveConfig.h"
@@ -36,7 +37,9 @@
 #include "Utils/Sampling/SampleGenerator.h"
 
 #include <algorithm>
+#include <filesystem>
 #include <limits>
+#include <memory>
 #include <vector>
 
 namespace Falcor
@@ -58,6 +61,10 @@ namespace Falcor
 
         // vertexData[i][j] represents at the i-th keyframe, the cache data of the j-th vertex.
         std::vector<std::vector<DynamicCurveVertexData>> vertexData;
+
+        // If set, vertexData is empty and the keyframes are streamed from this vertex cache file (see VertexCacheFile) during playback.
+        // The time samples are read from the file if empty. Curves are either all streamed or all held in memory.
+        std::filesystem::path streamPath;
     };
 
     struct CachedMesh
@@ -68,6 +75,10 @@ namespace Falcor
 
         // vertexData[i][j] represents at the i-th keyframe, the cache data of the j-th vertex.
         std::vector<std::vector<PackedStaticVertexData>> vertexData;
+
+        // If set, vertexData is empty and the keyframes are streamed from this vertex cache file (see VertexCacheFile) during playback.
+        // The time samples are read from the file if empty.
+        std::filesystem::path streamPath;
     };
 
     class FALCOR_API AnimatedVertexCache
@@ -98,7 +109,22 @@ namespace Falcor
 
         uint64_t getMemoryUsageInBytes() const;
 
+        bool hasStreamedCaches() const { return !mCurveStreams.empty() || std::any_of(mMeshStreams.begin(), mMeshStreams.end(), [](const auto& pStream) { return pStream != nullptr; }); }
+
+        /** Get the statistics of all streamed vertex caches combined.
+        */
+        VertexCacheStream::Stats getStreamingStats() const;
+
     private:
+        /// Streamed vertex caches only hold the two keyframes being interpolated on the GPU.
+        static constexpr uint32_t kStreamedKeyframeSlotCount = 2;
+
+        void initStreams();
+        uint32_t getCurveVertexCount(size_t curveIndex) const;
+        uint32_t getCurveKeyframeSlotCount() const { return mCurveStreams.empty() ? (uint32_t)mCurveKeyframeTimes.size() : kStreamedKeyframeSlotCount; }
+        InterpolationInfo uploadStreamedCurveKeyframes(const InterpolationInfo& info);
+        InterpolationInfo uploadStreamedMeshKeyframes(size_t meshIndex, const InterpolationInfo& info);
+
         void initCurveKeyframes();
         void bindCurveLSSBuffers();
         void bindCurvePolyTubeBuffers();
@@ -137,6 +163,11 @@ namespace Falcor
         uint32_t mCurveLSSCount = 0;
         uint32_t mCurvePolyTubeCount = 0;
         std::vector<double> mCurveKeyframeTimes;
+        std::vector<uint32_t> mCurveByteOffsets; ///< Byte offset of each cached curve in the keyframe buffers of its tessellation mode.
+
+        // Streamed curves. Keyframes are uploaded to the keyframe slots of both tessellation modes.
+        std::vector<std::unique_ptr<VertexCacheStream>> mCurveStreams; ///< Stream per cached curve, empty if curves are held in memory.
+        uint2 mCurveSlotKeyframes = uint2(VertexCacheFile::State::kInvalidKeyframe); ///< Keyframe held by each keyframe slot.
 
         // Cached curve (LSS) animation.
         ref<ComputePass> mpCurveVertexUpdatePass;
@@ -170,6 +201,11 @@ namespace Falcor
         std::vector<InterpolationInfo> mMeshInterpolationInfo;
         uint32_t mMeshKeyframeCount = 0; ///< Total count of all keyframes for all meshes
         uint32_t mMaxMeshVertexCount = 0; ///< Greatest vertex count a mesh has
+        std::vector<uint32_t> mMeshKeyframeBufferOffsets; ///< Offset of the first keyframe buffer of each mesh in mpMeshVertexBuffers.
+
+        // Streamed meshes.
+        std::vector<std::unique_ptr<VertexCacheStream>> mMeshStreams; ///< Stream per cached mesh, nullptr for meshes held in memory.
+        std::vector<uint2> mMeshSlotKeyframes; ///< Keyframe held by each keyframe slot of each streamed mesh.
 
         std::vector<ref<Buffer>> mpMeshVertexBuffers;
         ref<Buffer> mpMeshInterpolationBuffer;
@@ -136,12 +136,21 @@ namespace Falcor
             \param[in] time Time of the keyframe.
             \return Returns the keyframe.
         */
-        const Keyframe& getKeyframe(double time) const;
+        Keyframe getKeyframe(double time) const;
 
         /** Gets all the keyframes in the animation.
-            \return Returns span of keyframes.
+            Keyframes are stored as separate channels internally, this assembles them in time order.
+            \return Returns list of keyframes.
         */
-        fstd::span<const Keyframe> getKeyframes() const { return mKeyframes; }
+        std::vector<Keyframe> getKeyframes() const;
+
+        /** Get the number of keyframes.
+        */
+        size_t getKeyframeCount() const { return mTimes.size(); }
+
+        /** Get the keyframe times in increasing order.
+        */
+        fstd::span<const double> getKeyframeTimes() const { return mTimes; }
 
         /** Check if a keyframe exists at the specified time.
             \param[in] time Time of the keyframe.
@@ -160,6 +169,8 @@ namespace Falcor
         void renderUI(Gui::Widgets& widget);
 
     private:
+        Keyframe getKeyframeAt(size_t index) const { return { mTimes[index], mTranslations[index], mScalings[index], mRotations[index] }; }
+        size_t findFrameIndex(double time) const;
         Keyframe interpolate(InterpolationMode mode, double time) const;
         double calcSampleTime(double currentTime);
 
@@ -173,7 +184,11 @@ namespace Falcor
         InterpolationMode mInterpolationMode = InterpolationMode::Linear;
         bool mEnableWarping = false;
 
-        std::vector<Keyframe> mKeyframes;
+        // Keyframe channels, stored as structure-of-arrays sorted by time so that searching only touches the times.
+        std::vector<double> mTimes;
+        std::vector<float3> mTranslations;
+        std::vector<float3> mScalings;
+        std::vector<quatf> mRotations;
         mutable size_t mCachedFrameIndex = 0;
 
         friend class SceneCache;
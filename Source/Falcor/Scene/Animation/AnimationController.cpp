@@ -29,6 +29,8 @@
 #include "Core/API/RenderContext.h"
 #include "Utils/Timing/Profiler.h"
 #include "Scene/Scene.h"
+#include "Utils/TaskManager.h"
+#include <algorithm>
 #include <fstream>
 
 namespace Falcor
@@ -39,6 +41,9 @@ namespace Falcor
         const std::string kInverseTransposeWorldMatrices = "inverseTransposeWorldMatrices";
         const std::string kPrevWorldMatrices = "prevWorldMatrices";
         const std::string kPrevInverseTransposeWorldMatrices = "prevInverseTransposeWorldMatrices";
+
+        const size_t kAnimationsPerTask = 64;
+        const size_t kNodesPerTask = 256;
     }
 
     AnimationController::AnimationController(ref<Device> pDevice, Scene* pScene, const SkinningVertexVector& skinningVertexData, uint32_t prevVertexCount, const std::vector<ref<Animation>>& animations)
@@ -84,6 +89,7 @@ namespace Falcor
             mpPrevVertexData->setName("AnimationController::mpPrevVertexData");
         }
 
+        initHierarchy();
         createSkinningPass(skinningVertexData);
 
         // Determine length of global animation loop.
@@ -119,7 +125,8 @@ namespace Falcor
             for (auto& cache : cachedMeshes)
             {
                 uint32_t offset = mpScene->getMesh(cache.meshID).vbOffset;
-                for (size_t i = 0; i < cache.vertexData.front().size(); i++)
+                uint32_t vertexCount = mpScene->getMesh(cache.meshID).vertexCount;
+                for (size_t i = 0; i < vertexCount; i++)
                 {
                     prevVertexData.push_back({ staticVertexData[offset + i].position });
                 }
@@ -184,6 +191,55 @@ namespace Falcor
         }
     }
 
+    void AnimationController::initHierarchy()
+    {
+        const auto& sceneGraph = mpScene->mSceneGraph;
+        const size_t nodeCount = sceneGraph.size();
+
+        // Build the child lists.
+        mChildOffsets.assign(nodeCount + 1, 0);
+        for (const auto& node : sceneGraph)
+        {
+            if (node.parent != NodeID::Invalid()) mChildOffsets[node.parent.get() + 1]++;
+        }
+        for (size_t i = 0; i < nodeCount; i++) mChildOffsets[i + 1] += mChildOffsets[i];
+
+        mChildren.resize(mChildOffsets.back());
+        std::vector<uint32_t> childCounts(nodeCount, 0);
+        for (size_t i = 0; i < nodeCount; i++)
+        {
+            NodeID parent = sceneGraph[i].parent;
+            if (parent != NodeID::Invalid()) mChildren[mChildOffsets[parent.get()] + childCounts[parent.get()]++] = (uint32_t)i;
+        }
+
+        // Sort the nodes by level with a breadth-first traversal from the root nodes.
+        mNodeLevels.assign(nodeCount, 0);
+        mLevelNodes.clear();
+        mLevelNodes.reserve(nodeCount);
+        for (size_t i = 0; i < nodeCount; i++)
+        {
+            if (sceneGraph[i].parent == NodeID::Invalid()) mLevelNodes.push_back((uint32_t)i);
+        }
+
+        mLevelOffsets.clear();
+        for (size_t i = 0; i < mLevelNodes.size(); i++)
+        {
+            uint32_t nodeID = mLevelNodes[i];
+            if (i == 0 || mNodeLevels[nodeID] != mNodeLevels[mLevelNodes[i - 1]]) mLevelOffsets.push_back((uint32_t)i);
+
+            for (uint32_t j = mChildOffsets[nodeID]; j < mChildOffsets[nodeID + 1]; j++)
+            {
+                uint32_t childID = mChildren[j];
+                mNodeLevels[childID] = mNodeLevels[nodeID] + 1;
+                mLevelNodes.push_back(childID);
+            }
+        }
+        mLevelOffsets.push_back((uint32_t)mLevelNodes.size());
+
+        FALCOR_CHECK(mLevelNodes.size() == nodeCount, "Scene graph contains cycles");
+        mDirtyLevelNodes.resize(mLevelOffsets.size() - 1);
+    }
+
     void AnimationController::initLocalMatrices()
     {
         for (size_t i = 0; i < mLocalMatrices.size(); i++)
@@ -197,6 +253,8 @@ namespace Falcor
         FALCOR_PROFILE(pRenderContext, "animate");
 
         std::fill(mMatricesChanged.begin(), mMatricesChanged.end(), false);
+        mChangedNodes.clear();
+        mAllMatricesChanged = false;
 
         // Check for edited scene nodes and update local matrices.
         const auto& sceneGraph = mpScene->mSceneGraph;
@@ -208,6 +266,7 @@ namespace Falcor
                 mLocalMatrices[i] = sceneGraph[i].transform;
                 mNodesEdited[i] = false;
                 mMatricesChanged[i] = true;
+                mDirtyNodes.push_back((uint32_t)i);
                 edited = true;
             }
         }
@@ -291,44 +350,101 @@ namespace Falcor
 
     void AnimationController::updateLocalMatrices(double time)
     {
-        for (auto& pAnimation : mAnimations)
+        // Evaluate the animations in parallel batches. Each animation only updates its own keyframe cursor,
+        // the results are then scattered to the nodes in order so that the last animation of a node wins.
+        mAnimatedMatrices.resize(mAnimations.size());
+        parallelForRange(0, mAnimations.size(), [&](size_t first, size_t end)
+        {
+            for (size_t i = first; i < end; i++) mAnimatedMatrices[i] = mAnimations[i]->animate(time);
+        }, kAnimationsPerTask);
+
+        for (size_t i = 0; i < mAnimations.size(); i++)
         {
-            NodeID nodeID = pAnimation->getNodeID();
+            NodeID nodeID = mAnimations[i]->getNodeID();
             FALCOR_ASSERT(nodeID.get() < mLocalMatrices.size());
-            mLocalMatrices[nodeID.get()] = pAnimation->animate(time);
-            mMatricesChanged[nodeID.get()] = true;
+            mLocalMatrices[nodeID.get()] = mAnimatedMatrices[i];
+            if (!mMatricesChanged[nodeID.get()])
+            {
+                mMatricesChanged[nodeID.get()] = true;
+                mDirtyNodes.push_back(nodeID.get());
+            }
         }
     }
 
     void AnimationController::updateWorldMatrices(bool updateAll)
     {
-        const auto& sceneGraph = mpScene->mSceneGraph;
+        // Nodes only depend on their parent, so all nodes of a level can be updated in parallel once the level above is done.
+        const size_t levelCount = mLevelOffsets.size() - 1;
 
-        for (size_t i = 0; i < mGlobalMatrices.size(); i++)
+        if (updateAll)
         {
-            // Propagate matrix change flag to children.
-            if (sceneGraph[i].parent != NodeID::Invalid())
+            for (size_t level = 0; level < levelCount; level++)
             {
-                mMatricesChanged[i] = mMatricesChanged[i] || mMatricesChanged[sceneGraph[i].parent.get()];
+                updateNodeWorldMatrices(&mLevelNodes[mLevelOffsets[level]], mLevelOffsets[level + 1] - mLevelOffsets[level]);
             }
+            mDirtyNodes.clear();
+            mAllMatricesChanged = true;
+            return;
+        }
 
-            if (!mMatricesChanged[i] && !updateAll) continue;
+        // Walk down the changed subtrees only. Nodes with a changed local matrix are bucketed by level,
+        // and the children of each updated level are flagged as changed and queued for the next level.
+        for (uint32_t nodeID : mDirtyNodes) mDirtyLevelNodes[mNodeLevels[nodeID]].push_back(nodeID);
+        mDirtyNodes.clear();
 
-            mGlobalMatrices[i] = mLocalMatrices[i];
+        for (size_t level = 0; level < levelCount; level++)
+        {
+            auto& nodeIDs = mDirtyLevelNodes[level];
+            if (nodeIDs.empty()) continue;
 
-            if (mpScene->mSceneGraph[i].parent != NodeID::Invalid())
+            updateNodeWorldMatrices(nodeIDs.data(), nodeIDs.size());
+
+            if (level + 1 < levelCount)
             {
-                mGlobalMatrices[i] = mul(mGlobalMatrices[sceneGraph[i].parent.get()], mGlobalMatrices[i]);
+                auto& childIDs = mDirtyLevelNodes[level + 1];
+                for (uint32_t nodeID : nodeIDs)
+                {
+                    for (uint32_t j = mChildOffsets[nodeID]; j < mChildOffsets[nodeID + 1]; j++)
+                    {
+                        uint32_t childID = mChildren[j];
+                        if (mMatricesChanged[childID]) continue; // Already queued.
+                        mMatricesChanged[childID] = true;
+                        childIDs.push_back(childID);
+                    }
+                }
             }
 
-            mInvTransposeGlobalMatrices[i] = transpose(inverse(mGlobalMatrices[i]));
+            mChangedNodes.insert(mChangedNodes.end(), nodeIDs.begin(), nodeIDs.end());
+            nodeIDs.clear();
+        }
+    }
+
+    void AnimationController::updateNodeWorldMatrices(const uint32_t* pNodeIDs, size_t count)
+    {
+        const auto& sceneGraph = mpScene->mSceneGraph;
 
-            if (mpSkinningPass)
+        parallelForRange(0, count, [&](size_t first, size_t end)
+        {
+            for (size_t j = first; j < end; j++)
             {
-                mSkinningMatrices[i] = mul(mGlobalMatrices[i], sceneGraph[i].localToBindSpace);
-                mInvTransposeSkinningMatrices[i] = transpose(inverse(mSkinningMatrices[i]));
+                uint32_t i = pNodeIDs[j];
+
+                mGlobalMatrices[i] = mLocalMatrices[i];
+
+                if (sceneGraph[i].parent != NodeID::Invalid())
+                {
+                    mGlobalMatrices[i] = mul(mGlobalMatrices[sceneGraph[i].parent.get()], mGlobalMatrices[i]);
+                }
+
+                mInvTransposeGlobalMatrices[i] = transpose(inverse(mGlobalMatrices[i]));
+
+                if (mpSkinningPass)
+                {
+                    mSkinningMatrices[i] = mul(mGlobalMatrices[i], sceneGraph[i].localToBindSpace);
+                    mInvTransposeSkinningMatrices[i] = transpose(inverse(mSkinningMatrices[i]));
+                }
             }
-        }
+        }, kNodesPerTask);
     }
 
     void AnimationController::uploadWorldMatrices(bool uploadAll)
@@ -401,6 +517,7 @@ namespace Falcor
             mSkinningMatrices.resize(mpScene->mSceneGraph.size());
             mInvTransposeSkinningMatrices.resize(mSkinningMatrices.size());
             mMeshBindMatrices.resize(mpScene->mSceneGraph.size());
+            mMeshInvBindMatrices.resize(mMeshBindMatrices.size());
 
             DefineList defines;
             staticVertexData.getShaderDefines(defines);
@@ -409,15 +526,23 @@ namespace Falcor
             auto block = mpSkinningPass->getRootVar()["gData"];
 
             // Initialize mesh bind transforms
-            std::vector<float4x4> meshInvBindMatrices(mMeshBindMatrices.size());
             for (size_t i = 0; i < mpScene->mSceneGraph.size(); i++)
             {
                 mMeshBindMatrices[i] = mpScene->mSceneGraph[i].meshBind;
-                meshInvBindMatrices[i] = inverse(mMeshBindMatrices[i]);
+                mMeshInvBindMatrices[i] = inverse(mMeshBindMatrices[i]);
             }
 
             // Clone the static vertex data into a second set of buffers
             FALCOR_ASSERT(staticVertexData.hasCpuData(), "Cannot clone without CPU data");
+
+            // Keep the unskinned vertices of the skinned meshes for CPU skinning.
+            std::vector<PackedStaticVertexData> skinningStaticVertices(skinningVertexData.size());
+            for (size_t i = 0; i < skinningVertexData.size(); i++)
+            {
+                skinningStaticVertices[i] = staticVertexData[skinningVertexData[i].staticIndex];
+            }
+            mpCpuSkinning = std::make_unique<CpuSkinning>(skinningVertexData, std::move(skinningStaticVertices));
+
             mStaticVertexData = staticVertexData;
             mStaticVertexData.setName("AnimationController::mStaticVertexData");
             mStaticVertexData.createGpuBuffers(mpDevice, ResourceBindFlags::ShaderResource);
@@ -437,7 +562,7 @@ namespace Falcor
             FALCOR_ASSERT(mSkinningMatrices.size() < std::numeric_limits<uint32_t>::max());
             mpMeshBindMatricesBuffer = mpDevice->createStructuredBuffer(sizeof(float4x4), (uint32_t)mSkinningMatrices.size(), ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, mMeshBindMatrices.data(), false);
             mpMeshBindMatricesBuffer->setName("AnimationController::mpMeshBindMatricesBuffer");
-            mpMeshInvBindMatricesBuffer = mpDevice->createStructuredBuffer(sizeof(float4x4), (uint32_t)mSkinningMatrices.size(), ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, meshInvBindMatrices.data(), false);
+            mpMeshInvBindMatricesBuffer = mpDevice->createStructuredBuffer(sizeof(float4x4), (uint32_t)mSkinningMatrices.size(), ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, mMeshInvBindMatrices.data(), false);
             mpMeshInvBindMatricesBuffer->setName("AnimationController::mpMeshInvBindMatricesBuffer");
             mpSkinningMatricesBuffer = mpDevice->createStructuredBuffer(sizeof(float4x4), (uint32_t)mSkinningMatrices.size(), ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, nullptr, false);
             mpSkinningMatricesBuffer->setName("AnimationController::mpSkinningMatricesBuffer");
@@ -470,6 +595,34 @@ namespace Falcor
         mpSkinningPass->execute(pRenderContext, mSkinningDispatchSize, 1, 1);
     }
 
+    void AnimationController::updateCpuSkinningPalette()
+    {
+        FALCOR_CHECK(mpCpuSkinning, "Scene has no skinned meshes");
+
+        CpuSkinning::Matrices matrices;
+        matrices.pBoneMatrices = mSkinningMatrices.data();
+        matrices.pInverseTransposeBoneMatrices = mInvTransposeSkinningMatrices.data();
+        matrices.pWorldMatrices = mGlobalMatrices.data();
+        matrices.pInverseTransposeWorldMatrices = mInvTransposeGlobalMatrices.data();
+        matrices.pMeshBindMatrices = mMeshBindMatrices.data();
+        matrices.pMeshInvBindMatrices = mMeshInvBindMatrices.data();
+        mpCpuSkinning->updatePalette(matrices);
+    }
+
+    void AnimationController::skinVerticesCPU(std::vector<PackedStaticVertexData>& vertices)
+    {
+        updateCpuSkinningPalette();
+        vertices.resize(mpCpuSkinning->getVertexCount());
+        mpCpuSkinning->skinVertices(vertices.data());
+    }
+
+    void AnimationController::skinPositionsCPU(std::vector<float3>& positions)
+    {
+        updateCpuSkinningPalette();
+        positions.resize(mpCpuSkinning->getVertexCount());
+        mpCpuSkinning->skinPositions(positions.data());
+    }
+
     void AnimationController::renderUI(Gui::Widgets& widget)
     {
         if (widget.checkbox("Loop Animations", mLoopAnimations))
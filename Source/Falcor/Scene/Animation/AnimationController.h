@@ -28,6 +28,7 @@
 #pragma once
 #include "Animation.h"
 #include "AnimatedVertexCache.h"
+#include "CpuSkinning.h"
 #include "Core/Macros.h"
 #include "Core/API/Buffer.h"
 #include "Core/Pass/ComputePass.h"
@@ -112,6 +113,16 @@ namespace Falcor
         */
         bool isMatrixChanged(NodeID matrixID) const { return mMatricesChanged[matrixID.get()]; }
 
+        /** Check if all matrices were recomputed by the last call to animate().
+            If false, the changed matrices are exactly the ones listed by getChangedNodes().
+        */
+        bool areAllMatricesChanged() const { return mAllMatricesChanged; }
+
+        /** Get the IDs of the nodes whose world matrix changed in the last call to animate(), in no particular order.
+            Only valid if areAllMatricesChanged() returns false.
+        */
+        const std::vector<uint32_t>& getChangedNodes() const { return mChangedNodes; }
+
         /** Get the local matrices.
             These represent the current local transform for each scene graph node.
         */
@@ -140,6 +151,22 @@ namespace Falcor
         */
         ref<Buffer> getPrevCurveVertexData() const { return mpVertexCache ? mpVertexCache->getPrevCurveVertexData() : nullptr; }
 
+        /** Get the CPU skinning of the skinned meshes.
+            \return CPU skinning, or nullptr if no skinned meshes exist.
+        */
+        const CpuSkinning* getCpuSkinning() const { return mpCpuSkinning.get(); }
+
+        /** Skin the skinned vertices on the CPU with the current matrices.
+            Produces the same vertex data as the skinning pass, e.g. for validation without a GPU or for CPU-side consumers.
+            \param[out] vertices Skinned vertex data in the order of the skinning vertex data, see CpuSkinning::getStaticIndices().
+        */
+        void skinVerticesCPU(std::vector<PackedStaticVertexData>& vertices);
+
+        /** Skin the positions of the skinned vertices on the CPU with the current matrices, e.g. for bounding boxes or CPU ray casting.
+            \param[out] positions Skinned positions in the order of the skinning vertex data, see CpuSkinning::getStaticIndices().
+        */
+        void skinPositionsCPU(std::vector<float3>& positions);
+
         /** Get the total GPU memory usage in bytes.
         */
         uint64_t getMemoryUsageInBytes() const;
@@ -148,15 +175,18 @@ namespace Falcor
         friend class SceneBuilder;
         friend class Scene;
 
+        void initHierarchy();
         void initLocalMatrices();
         void updateLocalMatrices(double time);
         void updateWorldMatrices(bool updateAll = false);
+        void updateNodeWorldMatrices(const uint32_t* pNodeIDs, size_t count);
         void uploadWorldMatrices(bool uploadAll = false);
 
         void bindBuffers();
 
         void createSkinningPass(const SkinningVertexVector& skinningVertexData);
         void executeSkinningPass(RenderContext* pRenderContext, bool initPrev = false);
+        void updateCpuSkinningPalette();
 
         ref<Device> mpDevice;
 
@@ -167,6 +197,18 @@ namespace Falcor
         std::vector<float4x4> mGlobalMatrices;
         std::vector<float4x4> mInvTransposeGlobalMatrices;
         std::vector<bool> mMatricesChanged;         ///< Flag per matrix, true if matrix changed since last frame.
+        std::vector<uint32_t> mDirtyNodes;          ///< Nodes whose local matrix changed since the last world matrix update.
+        std::vector<uint32_t> mChangedNodes;        ///< Nodes whose world matrix changed in the last call to animate().
+        bool mAllMatricesChanged = false;           ///< True if all world matrices were recomputed in the last call to animate().
+        std::vector<float4x4> mAnimatedMatrices;    ///< Scratch buffer holding the evaluated matrix of each animation.
+
+        // Scene graph hierarchy, used for updating world matrices level by level.
+        std::vector<uint32_t> mNodeLevels;          ///< Depth of each node in the scene graph (0 for root nodes).
+        std::vector<uint32_t> mLevelNodes;          ///< Node IDs sorted by level.
+        std::vector<uint32_t> mLevelOffsets;        ///< Offset of each level in mLevelNodes, followed by the total node count.
+        std::vector<uint32_t> mChildOffsets;        ///< Offset of each node's children in mChildren, followed by the total child count.
+        std::vector<uint32_t> mChildren;            ///< Child node IDs grouped by parent node.
+        std::vector<std::vector<uint32_t>> mDirtyLevelNodes; ///< Scratch lists of changed nodes per level.
 
         bool mFirstUpdate = true;       ///< True if this is the first update.
         bool mEnabled = true;           ///< True if animations are enabled.
@@ -186,6 +228,7 @@ namespace Falcor
         // Skinning
         ref<ComputePass> mpSkinningPass;
         std::vector<float4x4> mMeshBindMatrices; // Optimization TODO: These are only needed per mesh
+        std::vector<float4x4> mMeshInvBindMatrices;
         std::vector<float4x4> mSkinningMatrices;
         std::vector<float4x4> mInvTransposeSkinningMatrices;
         uint32_t mSkinningDispatchSize = 0;
@@ -197,6 +240,7 @@ namespace Falcor
         ref<Buffer> mpSkinningVertexData;
         ref<Buffer> mpPrevVertexData;
         SplitVertexBuffer mStaticVertexData;
+        std::unique_ptr<CpuSkinning> mpCpuSkinning;
 
         // Animated vertex caches
         std::unique_ptr<AnimatedVertexCache> mpVertexCache;
@@ -0,0 +1,284 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "CpuSkinning.h"
+#include "Core/Error.h"
+#include "Utils/TaskManager.h"
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FALCOR_CPU_SKINNING_AVX2 1
+#include <immintrin.h>
+#if FALCOR_MSVC
+#include <intrin.h>
+#endif
+#else
+#define FALCOR_CPU_SKINNING_AVX2 0
+#endif
+
+// GCC and Clang need the instruction set enabled per function, MSVC allows intrinsics in any function.
+#if FALCOR_MSVC
+#define FALCOR_TARGET_AVX2
+#else
+#define FALCOR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace Falcor
+{
+    namespace
+    {
+        const size_t kVerticesPerTask = 4096;
+        const size_t kPaletteEntriesPerTask = 256;
+        const size_t kBatchSize = 64; ///< Number of vertices blended at a time.
+        const size_t kPaletteMatrixFloatCount = 24;
+
+        /** Blends the palette matrices of a batch of vertices. Matrices are kPaletteMatrixFloatCount floats, 32-byte aligned.
+        */
+        using BlendFunc = void (*)(const float* pPalette, const uint4* pIndices, const float4* pWeights, size_t count, float* pResult);
+
+        void blendScalar(const float* pPalette, const uint4* pIndices, const float4* pWeights, size_t count, float* pResult)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const float* p0 = pPalette + pIndices[i].x * kPaletteMatrixFloatCount;
+                const float* p1 = pPalette + pIndices[i].y * kPaletteMatrixFloatCount;
+                const float* p2 = pPalette + pIndices[i].z * kPaletteMatrixFloatCount;
+                const float* p3 = pPalette + pIndices[i].w * kPaletteMatrixFloatCount;
+                const float4 w = pWeights[i];
+                float* pDst = pResult + i * kPaletteMatrixFloatCount;
+                for (size_t j = 0; j < kPaletteMatrixFloatCount; j++)
+                {
+                    pDst[j] = p0[j] * w.x + p1[j] * w.y + p2[j] * w.z + p3[j] * w.w;
+                }
+            }
+        }
+
+#if FALCOR_CPU_SKINNING_AVX2
+        // Uses separate multiplies and adds in the same order as blendScalar() so that both produce identical results.
+        FALCOR_TARGET_AVX2 void blendAVX2(const float* pPalette, const uint4* pIndices, const float4* pWeights, size_t count, float* pResult)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const float* p0 = pPalette + pIndices[i].x * kPaletteMatrixFloatCount;
+                const float* p1 = pPalette + pIndices[i].y * kPaletteMatrixFloatCount;
+                const float* p2 = pPalette + pIndices[i].z * kPaletteMatrixFloatCount;
+                const float* p3 = pPalette + pIndices[i].w * kPaletteMatrixFloatCount;
+                const __m256 w0 = _mm256_set1_ps(pWeights[i].x);
+                const __m256 w1 = _mm256_set1_ps(pWeights[i].y);
+                const __m256 w2 = _mm256_set1_ps(pWeights[i].z);
+                const __m256 w3 = _mm256_set1_ps(pWeights[i].w);
+                float* pDst = pResult + i * kPaletteMatrixFloatCount;
+                for (size_t j = 0; j < kPaletteMatrixFloatCount; j += 8)
+                {
+                    __m256 m = _mm256_mul_ps(_mm256_load_ps(p0 + j), w0);
+                    m = _mm256_add_ps(m, _mm256_mul_ps(_mm256_load_ps(p1 + j), w1));
+                    m = _mm256_add_ps(m, _mm256_mul_ps(_mm256_load_ps(p2 + j), w2));
+                    m = _mm256_add_ps(m, _mm256_mul_ps(_mm256_load_ps(p3 + j), w3));
+                    _mm256_store_ps(pDst + j, m);
+                }
+            }
+        }
+#endif
+
+        bool detectSimdSupport()
+        {
+#if FALCOR_CPU_SKINNING_AVX2
+#if FALCOR_MSVC
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+            __cpuid(info, 1);
+            const bool osxsave = info[2] & (1 << 27);
+            const bool avx = info[2] & (1 << 28);
+            if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+            __cpuidex(info, 7, 0);
+            return info[1] & (1 << 5);
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+#else
+            return false;
+#endif
+        }
+
+        std::atomic<bool>& getSimdEnabled()
+        {
+            static std::atomic<bool> enabled{CpuSkinning::isSimdSupported()};
+            return enabled;
+        }
+
+        BlendFunc selectBlendFunc()
+        {
+#if FALCOR_CPU_SKINNING_AVX2
+            if (CpuSkinning::isSimdEnabled()) return blendAVX2;
+#endif
+            return blendScalar;
+        }
+    }
+
+    CpuSkinning::CpuSkinning(const std::vector<SkinningVertexData>& skinningData, std::vector<PackedStaticVertexData> staticVertices)
+        : mStaticVertices(std::move(staticVertices))
+    {
+        FALCOR_CHECK(mStaticVertices.size() == skinningData.size(), "Static vertex count ({}) does not match skinning vertex count ({})", mStaticVertices.size(), skinningData.size());
+
+        mStaticIndices.resize(skinningData.size());
+        mPaletteIndices.resize(skinningData.size());
+        mBoneWeights.resize(skinningData.size());
+
+        // Vertices of a mesh share the mesh bind and skeleton matrices, so there is one palette entry per bone used by each mesh.
+        std::unordered_map<uint64_t, uint32_t> bindings; // (bind matrix, skeleton matrix) -> binding index.
+        std::unordered_map<uint64_t, uint32_t> entries; // (binding index, bone) -> palette entry.
+        for (size_t i = 0; i < skinningData.size(); i++)
+        {
+            const SkinningVertexData& s = skinningData[i];
+            mStaticIndices[i] = s.staticIndex;
+            mBoneWeights[i] = s.boneWeight;
+
+            uint64_t bindingKey = (uint64_t(s.bindMatrixID) << 32) | s.skeletonMatrixID;
+            uint32_t binding = bindings.try_emplace(bindingKey, (uint32_t)bindings.size()).first->second;
+
+            for (uint32_t j = 0; j < 4; j++)
+            {
+                uint64_t entryKey = (uint64_t(binding) << 32) | s.boneID[j];
+                auto [it, inserted] = entries.try_emplace(entryKey, (uint32_t)mPaletteEntries.size());
+                if (inserted) mPaletteEntries.push_back({ s.boneID[j], s.bindMatrixID, s.skeletonMatrixID });
+                mPaletteIndices[i][j] = it->second;
+            }
+        }
+    }
+
+    bool CpuSkinning::isSimdSupported()
+    {
+        static const bool supported = detectSimdSupport();
+        return supported;
+    }
+
+    void CpuSkinning::setSimdEnabled(bool enabled)
+    {
+        getSimdEnabled() = enabled && isSimdSupported();
+    }
+
+    bool CpuSkinning::isSimdEnabled()
+    {
+        return getSimdEnabled();
+    }
+
+    void CpuSkinning::updatePalette(const Matrices& matrices)
+    {
+        FALCOR_CHECK(matrices.pBoneMatrices && matrices.pInverseTransposeBoneMatrices && matrices.pWorldMatrices &&
+            matrices.pInverseTransposeWorldMatrices && matrices.pMeshBindMatrices && matrices.pMeshInvBindMatrices, "All skinning matrices must be set");
+
+        mPalette.resize(mPaletteEntries.size());
+        parallelForRange(0, mPaletteEntries.size(), [&](size_t first, size_t end)
+        {
+            for (size_t i = first; i < end; i++)
+            {
+                const PaletteEntry& entry = mPaletteEntries[i];
+
+                // Same transforms as getBlendedMatrix() and getInverseTransposeBlendedMatrix() in Skinning.slang, applied per bone.
+                float4x4 inverseWorld = transpose(matrices.pInverseTransposeWorldMatrices[entry.skeletonMatrixID]);
+                float4x4 transform = mul(matrices.pBoneMatrices[entry.boneID], matrices.pMeshBindMatrices[entry.bindMatrixID]);
+                transform = mul(matrices.pMeshInvBindMatrices[entry.bindMatrixID], mul(inverseWorld, transform));
+                float4x4 normalTransform = mul(transpose(matrices.pWorldMatrices[entry.skeletonMatrixID]), matrices.pInverseTransposeBoneMatrices[entry.boneID]);
+
+                PaletteMatrix& m = mPalette[i];
+                for (int r = 0; r < 3; r++)
+                {
+                    m.rows[r] = transform.getRow(r);
+                    m.normalRows[r] = float4(normalTransform.getRow(r).xyz(), 0.f);
+                }
+            }
+        }, kPaletteEntriesPerTask);
+    }
+
+    template<bool kPositionsOnly, typename T>
+    void CpuSkinning::skin(T* pOutput) const
+    {
+        static_assert(sizeof(PaletteMatrix) == kPaletteMatrixFloatCount * sizeof(float));
+        FALCOR_CHECK(mPalette.size() == mPaletteEntries.size(), "The palette must be updated before skinning");
+
+        const BlendFunc blend = selectBlendFunc();
+        const float* pPalette = reinterpret_cast<const float*>(mPalette.data());
+
+        parallelForRange(0, getVertexCount(), [&](size_t first, size_t end)
+        {
+            PaletteMatrix blended[kBatchSize];
+            for (size_t batch = first; batch < end; batch += kBatchSize)
+            {
+                size_t count = std::min(kBatchSize, end - batch);
+                blend(pPalette, &mPaletteIndices[batch], &mBoneWeights[batch], count, reinterpret_cast<float*>(blended));
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    const PaletteMatrix& m = blended[i];
+                    const size_t vertexID = batch + i;
+
+                    if constexpr (kPositionsOnly)
+                    {
+                        float4 p = float4(mStaticVertices[vertexID].position, 1.f);
+                        pOutput[vertexID] = float3(dot(m.rows[0], p), dot(m.rows[1], p), dot(m.rows[2], p));
+                    }
+                    else
+                    {
+                        StaticVertexData s = mStaticVertices[vertexID].unpack();
+                        float4 p = float4(s.position, 1.f);
+                        float3 t = s.tangent.xyz();
+                        s.position = float3(dot(m.rows[0], p), dot(m.rows[1], p), dot(m.rows[2], p));
+                        s.tangent = float4(dot(m.rows[0].xyz(), t), dot(m.rows[1].xyz(), t), dot(m.rows[2].xyz(), t), s.tangent.w);
+                        s.normal = float3(dot(m.normalRows[0].xyz(), s.normal), dot(m.normalRows[1].xyz(), s.normal), dot(m.normalRows[2].xyz(), s.normal));
+                        pOutput[vertexID].pack(s);
+                    }
+                }
+            }
+        }, kVerticesPerTask);
+    }
+
+    void CpuSkinning::skinVertices(PackedStaticVertexData* pVertices) const
+    {
+        skin<false>(pVertices);
+    }
+
+    void CpuSkinning::skinPositions(float3* pPositions) const
+    {
+        skin<true>(pPositions);
+    }
+
+    uint64_t CpuSkinning::getMemoryUsageInBytes() const
+    {
+        uint64_t m = 0;
+        m += mStaticIndices.size() * sizeof(uint32_t);
+        m += mStaticVertices.size() * sizeof(PackedStaticVertexData);
+        m += mPaletteIndices.size() * sizeof(uint4);
+        m += mBoneWeights.size() * sizeof(float4);
+        m += mPaletteEntries.size() * sizeof(PaletteEntry);
+        m += mPalette.size() * sizeof(PaletteMatrix);
+        return m;
+    }
+
+}
@@ -0,0 +1,136 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Utils/Math/Matrix.h"
+#include "Utils/Math/Vector.h"
+#include "Scene/SceneTypes.slang"
+#include <vector>
+
+namespace Falcor
+{
+    /** CPU implementation of the skinning pass (Skinning.slang).
+
+        Skins the same SkinningVertexData with the same bone matrices and writes the same vertex layout as the GPU pass,
+        so it can run skinned-character validation without a GPU, be diffed against the GPU output, and provide skinned
+        vertices to CPU-side consumers such as bounding box updates or CPU ray casting.
+
+        Instead of blending the bone matrices and multiplying them with the mesh bind and skeleton matrices per vertex,
+        the matrix chain is folded into a palette of one matrix per unique (bone, mesh bind matrix, skeleton matrix) triple
+        at each update. Vertices then blend four palette matrices, which is done with AVX2 when supported, in batches processed in parallel.
+    */
+    class FALCOR_API CpuSkinning
+    {
+    public:
+        /** Matrices used by skinning, indexed by scene graph node. The same matrices as bound to the skinning pass.
+        */
+        struct Matrices
+        {
+            const float4x4* pBoneMatrices = nullptr;                    ///< Skinning matrices (global matrix times local-to-bind-space matrix).
+            const float4x4* pInverseTransposeBoneMatrices = nullptr;    ///< Inverse transpose of the skinning matrices.
+            const float4x4* pWorldMatrices = nullptr;                   ///< Global matrices.
+            const float4x4* pInverseTransposeWorldMatrices = nullptr;   ///< Inverse transpose of the global matrices.
+            const float4x4* pMeshBindMatrices = nullptr;                ///< Mesh bind matrices.
+            const float4x4* pMeshInvBindMatrices = nullptr;             ///< Inverse of the mesh bind matrices.
+        };
+
+        /** Constructor.
+            \param[in] skinningData Skinning data of all skinned vertices.
+            \param[in] staticVertices Unskinned vertex data of each skinned vertex, in the same order as skinningData.
+        */
+        CpuSkinning(const std::vector<SkinningVertexData>& skinningData, std::vector<PackedStaticVertexData> staticVertices);
+
+        /** Check if the vectorized blending is supported by the CPU.
+        */
+        static bool isSimdSupported();
+
+        /** Enable or disable the vectorized blending (enabled by default if supported). Used for testing and benchmarking.
+        */
+        static void setSimdEnabled(bool enabled);
+
+        static bool isSimdEnabled();
+
+        /** Get the number of skinned vertices.
+        */
+        size_t getVertexCount() const { return mStaticIndices.size(); }
+
+        /** Get the index of each skinned vertex in the global static vertex buffer (SkinningVertexData::staticIndex).
+            Skinned vertices are returned in this order, whereas the skinning pass writes them at these indices.
+        */
+        const std::vector<uint32_t>& getStaticIndices() const { return mStaticIndices; }
+
+        /** Get the number of matrices in the palette.
+        */
+        size_t getPaletteSize() const { return mPaletteEntries.size(); }
+
+        /** Update the palette from the current matrices. Must be called before skinning whenever the matrices changed.
+            \param[in] matrices Matrices indexed by scene graph node.
+        */
+        void updatePalette(const Matrices& matrices);
+
+        /** Skin all vertices.
+            \param[out] pVertices Skinned vertex data of getVertexCount() vertices, in the order of the skinning data.
+        */
+        void skinVertices(PackedStaticVertexData* pVertices) const;
+
+        /** Skin the positions of all vertices. Faster than skinVertices() for consumers that don't need normals and tangents.
+            \param[out] pPositions Skinned positions of getVertexCount() vertices, in the order of the skinning data.
+        */
+        void skinPositions(float3* pPositions) const;
+
+        uint64_t getMemoryUsageInBytes() const;
+
+    private:
+        /** Bone and mesh matrices folded into one transform.
+        */
+        struct PaletteEntry
+        {
+            uint32_t boneID;
+            uint32_t bindMatrixID;
+            uint32_t skeletonMatrixID;
+        };
+
+        /** Folded matrices of a palette entry, laid out for blending with 256-bit vectors.
+        */
+        struct alignas(32) PaletteMatrix
+        {
+            float4 rows[3];         ///< Rows of the position and tangent transform.
+            float4 normalRows[3];   ///< Rows of the normal transform, w unused.
+        };
+
+        template<bool kPositionsOnly, typename T>
+        void skin(T* pOutput) const;
+
+        std::vector<uint32_t> mStaticIndices;
+        std::vector<PackedStaticVertexData> mStaticVertices;
+        std::vector<uint4> mPaletteIndices;     ///< Palette entries of the bones of each vertex.
+        std::vector<float4> mBoneWeights;       ///< Bone weights of each vertex.
+        std::vector<PaletteEntry> mPaletteEntries;
+        std::vector<PaletteMatrix> mPalette;
+    };
+}
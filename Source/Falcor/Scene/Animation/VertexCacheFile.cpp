@@ -0,0 +1,324 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "VertexCacheFile.h"
+#include "Core/Error.h"
+#include "Utils/Logger.h"
+#include "Utils/TaskManager.h"
+#include "Utils/Math/Common.h"
+#include <lz4.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kMagic = 0x46435656; // "VVCF"
+        const uint32_t kVersion = 1;
+
+        static_assert(sizeof(VertexCacheFile::Header) == 56);
+        static_assert(sizeof(VertexCacheFile::BlockEntry) == 16);
+
+        /// Number of byte planes of the quantized position of a vertex (3 components of 2 bytes).
+        const uint32_t kPositionPlaneCount = 6;
+
+        // Map small signed deltas to small unsigned values, so that the high byte plane is mostly zero.
+        uint16_t zigzag(uint16_t d) { return uint16_t((d << 1) ^ uint16_t(int16_t(d) >> 15)); }
+        uint16_t unzigzag(uint16_t z) { return uint16_t((z >> 1) ^ uint16_t(0 - (z & 1))); }
+
+        uint16_t quantize(float value, float boundsMin, float scale)
+        {
+            float q = (value - boundsMin) * scale;
+            return q > 0.f ? uint16_t(std::min(q, 65535.f) + 0.5f) : 0;
+        }
+
+        template<typename F>
+        void forEachBlock(uint32_t blockCount, F func)
+        {
+            parallelFor(0, blockCount, func);
+        }
+    }
+
+    bool VertexCacheFile::write(const std::filesystem::path& path, const std::vector<double>& timeSamples, uint32_t vertexCount, uint32_t vertexStride, const KeyframeFunc& getKeyframe, uint32_t keyframeInterval)
+    {
+        FALCOR_CHECK(vertexStride >= sizeof(float3) && vertexStride % sizeof(uint32_t) == 0, "'vertexStride' ({}) must be at least 12 and a multiple of 4", vertexStride);
+        FALCOR_CHECK(std::is_sorted(timeSamples.begin(), timeSamples.end()), "'timeSamples' must be in increasing order");
+
+        Header header;
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.vertexCount = vertexCount;
+        header.vertexStride = vertexStride;
+        header.keyframeCount = (uint32_t)timeSamples.size();
+        header.keyframeInterval = std::max(keyframeInterval, 1u);
+        header.blockVertexCount = kDefaultBlockVertexCount;
+
+        const uint32_t wordCount = (vertexStride - sizeof(float3)) / sizeof(uint32_t);
+        const uint32_t planeCount = kPositionPlaneCount + wordCount * sizeof(uint32_t);
+        const uint32_t blockCount = div_round_up(vertexCount, header.blockVertexCount);
+        auto getBlockVertexCount = [&](uint32_t block) { return std::min(header.blockVertexCount, vertexCount - block * header.blockVertexCount); };
+
+        // Compute the bounds of the positions over all keyframes.
+        if (vertexCount > 0 && header.keyframeCount > 0)
+        {
+            header.boundsMin = float3(std::numeric_limits<float>::max());
+            header.boundsMax = float3(-std::numeric_limits<float>::max());
+            std::vector<float3> blockMin(blockCount), blockMax(blockCount);
+            for (uint32_t keyframe = 0; keyframe < header.keyframeCount; keyframe++)
+            {
+                const uint8_t* pVertices = static_cast<const uint8_t*>(getKeyframe(keyframe));
+                forEachBlock(blockCount, [&](uint32_t block)
+                {
+                    float3 boundsMin = header.boundsMin;
+                    float3 boundsMax = header.boundsMax;
+                    size_t first = size_t(block) * header.blockVertexCount;
+                    for (size_t i = first; i < first + getBlockVertexCount(block); i++)
+                    {
+                        float3 p;
+                        std::memcpy(&p, pVertices + i * vertexStride, sizeof(float3));
+                        boundsMin = min(boundsMin, p);
+                        boundsMax = max(boundsMax, p);
+                    }
+                    blockMin[block] = boundsMin;
+                    blockMax[block] = boundsMax;
+                });
+                for (uint32_t block = 0; block < blockCount; block++)
+                {
+                    header.boundsMin = min(header.boundsMin, blockMin[block]);
+                    header.boundsMax = max(header.boundsMax, blockMax[block]);
+                }
+            }
+        }
+
+        const float3 extent = header.boundsMax - header.boundsMin;
+        const float3 scale = float3(extent.x > 0.f ? 65535.f / extent.x : 0.f, extent.y > 0.f ? 65535.f / extent.y : 0.f, extent.z > 0.f ? 65535.f / extent.z : 0.f);
+
+        std::ofstream file(path, std::ios::out | std::ios::binary);
+        if (!file.is_open())
+        {
+            logWarning("Failed to open vertex cache file '{}' for writing.", path);
+            return false;
+        }
+
+        // Write the header and times, and reserve space for the block table which is written last.
+        std::vector<BlockEntry> blockTable(size_t(blockCount) * header.keyframeCount);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(timeSamples.data()), timeSamples.size() * sizeof(double));
+        const std::streamoff blockTableOffset = file.tellp();
+        file.write(reinterpret_cast<const char*>(blockTable.data()), blockTable.size() * sizeof(BlockEntry));
+
+        State prevState, state;
+        prevState.positions.resize(size_t(vertexCount) * 3);
+        prevState.words.resize(size_t(vertexCount) * wordCount);
+        state = prevState;
+        std::vector<std::vector<char>> compressedBlocks(blockCount);
+
+        for (uint32_t keyframe = 0; keyframe < header.keyframeCount; keyframe++)
+        {
+            const uint8_t* pVertices = static_cast<const uint8_t*>(getKeyframe(keyframe));
+            const bool isIndependent = keyframe % header.keyframeInterval == 0;
+
+            forEachBlock(blockCount, [&](uint32_t block)
+            {
+                const uint32_t n = getBlockVertexCount(block);
+                const size_t first = size_t(block) * header.blockVertexCount;
+                std::vector<uint8_t> planes(size_t(n) * planeCount);
+
+                for (uint32_t v = 0; v < n; v++)
+                {
+                    const size_t i = first + v;
+                    const uint8_t* pVertex = pVertices + i * vertexStride;
+
+                    float3 p;
+                    std::memcpy(&p, pVertex, sizeof(float3));
+                    for (uint32_t c = 0; c < 3; c++)
+                    {
+                        uint16_t q = quantize(p[c], header.boundsMin[c], scale[c]);
+                        uint16_t d = zigzag(isIndependent ? q : uint16_t(q - prevState.positions[i * 3 + c]));
+                        planes[(2 * c) * n + v] = uint8_t(d);
+                        planes[(2 * c + 1) * n + v] = uint8_t(d >> 8);
+                        state.positions[i * 3 + c] = q;
+                    }
+
+                    for (uint32_t w = 0; w < wordCount; w++)
+                    {
+                        uint32_t word;
+                        std::memcpy(&word, pVertex + sizeof(float3) + w * sizeof(uint32_t), sizeof(uint32_t));
+                        uint32_t d = isIndependent ? word : word ^ prevState.words[i * wordCount + w];
+                        for (uint32_t b = 0; b < 4; b++) planes[(kPositionPlaneCount + w * 4 + b) * n + v] = uint8_t(d >> (8 * b));
+                        state.words[i * wordCount + w] = word;
+                    }
+                }
+
+                auto& compressed = compressedBlocks[block];
+                compressed.resize(LZ4_compressBound((int)planes.size()));
+                int size = LZ4_compress_default(reinterpret_cast<const char*>(planes.data()), compressed.data(), (int)planes.size(), (int)compressed.size());
+                FALCOR_CHECK(size > 0, "Failed to compress vertex cache block");
+                compressed.resize(size);
+            });
+
+            for (uint32_t block = 0; block < blockCount; block++)
+            {
+                BlockEntry& entry = blockTable[size_t(keyframe) * blockCount + block];
+                entry.offset = (uint64_t)file.tellp();
+                entry.size = (uint32_t)compressedBlocks[block].size();
+                file.write(compressedBlocks[block].data(), compressedBlocks[block].size());
+            }
+
+            std::swap(prevState, state);
+        }
+
+        file.seekp(blockTableOffset);
+        file.write(reinterpret_cast<const char*>(blockTable.data()), blockTable.size() * sizeof(BlockEntry));
+        return file.good();
+    }
+
+    VertexCacheFile::VertexCacheFile(const std::filesystem::path& path)
+        : mPath(path)
+    {
+        if (!mFile.open(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan))
+        {
+            FALCOR_THROW("Failed to open vertex cache file '{}'.", path);
+        }
+
+        const uint8_t* pData = static_cast<const uint8_t*>(mFile.getData());
+        const size_t fileSize = mFile.getMappedSize();
+        if (fileSize < sizeof(Header)) FALCOR_THROW("Vertex cache file '{}' is truncated.", path);
+
+        std::memcpy(&mHeader, pData, sizeof(Header));
+        if (mHeader.magic != kMagic || mHeader.version != kVersion) FALCOR_THROW("'{}' is not a vertex cache file or has an unsupported version.", path);
+        if (mHeader.vertexStride < sizeof(float3) || mHeader.vertexStride % sizeof(uint32_t) != 0 || mHeader.keyframeInterval == 0 || mHeader.blockVertexCount == 0)
+        {
+            FALCOR_THROW("Vertex cache file '{}' has an invalid header.", path);
+        }
+
+        mWordCount = (mHeader.vertexStride - sizeof(float3)) / sizeof(uint32_t);
+        mBlockCount = div_round_up(mHeader.vertexCount, mHeader.blockVertexCount);
+
+        const size_t timesOffset = sizeof(Header);
+        const size_t blockTableOffset = timesOffset + size_t(mHeader.keyframeCount) * sizeof(double);
+        const size_t blockTableSize = size_t(mHeader.keyframeCount) * mBlockCount * sizeof(BlockEntry);
+        if (fileSize < blockTableOffset + blockTableSize) FALCOR_THROW("Vertex cache file '{}' is truncated.", path);
+
+        mTimeSamples.resize(mHeader.keyframeCount);
+        std::memcpy(mTimeSamples.data(), pData + timesOffset, mTimeSamples.size() * sizeof(double));
+        mpBlockTable = reinterpret_cast<const BlockEntry*>(pData + blockTableOffset);
+
+        for (size_t i = 0; i < size_t(mHeader.keyframeCount) * mBlockCount; i++)
+        {
+            if (mpBlockTable[i].offset + mpBlockTable[i].size > fileSize) FALCOR_THROW("Vertex cache file '{}' is truncated.", path);
+        }
+    }
+
+    uint64_t VertexCacheFile::getCompressedSize(uint32_t keyframe) const
+    {
+        FALCOR_CHECK(keyframe < mHeader.keyframeCount, "'keyframe' ({}) is out of range", keyframe);
+        uint64_t size = 0;
+        for (uint32_t block = 0; block < mBlockCount; block++) size += mpBlockTable[size_t(keyframe) * mBlockCount + block].size;
+        return size;
+    }
+
+    void VertexCacheFile::decodeKeyframe(uint32_t keyframe, State& state, void* pVertices) const
+    {
+        FALCOR_CHECK(keyframe < mHeader.keyframeCount, "'keyframe' ({}) is out of range", keyframe);
+
+        // Continue from the state if it holds a keyframe since the last independently encoded keyframe, otherwise start over from there.
+        const uint32_t independentKeyframe = keyframe - keyframe % mHeader.keyframeInterval;
+        if (state.keyframe != keyframe)
+        {
+            bool canContinue = state.keyframe != State::kInvalidKeyframe && state.keyframe >= independentKeyframe && state.keyframe < keyframe;
+            for (uint32_t i = canContinue ? state.keyframe + 1 : independentKeyframe; i < keyframe; i++) decodeDelta(i, state, nullptr);
+        }
+        decodeDelta(keyframe, state, pVertices);
+    }
+
+    void VertexCacheFile::decodeDelta(uint32_t keyframe, State& state, void* pVertices) const
+    {
+        const uint32_t vertexCount = mHeader.vertexCount;
+        const uint32_t wordCount = mWordCount;
+        const uint32_t planeCount = kPositionPlaneCount + wordCount * sizeof(uint32_t);
+        const bool isIndependent = keyframe % mHeader.keyframeInterval == 0;
+        // If the state already holds the keyframe, only the vertices are written.
+        const bool isDecoded = state.keyframe == keyframe;
+
+        state.positions.resize(size_t(vertexCount) * 3);
+        state.words.resize(size_t(vertexCount) * wordCount);
+
+        const float3 step = (mHeader.boundsMax - mHeader.boundsMin) / 65535.f;
+        const uint8_t* pData = static_cast<const uint8_t*>(mFile.getData());
+        uint8_t* pOutput = static_cast<uint8_t*>(pVertices);
+
+        forEachBlock(mBlockCount, [&](uint32_t block)
+        {
+            const uint32_t n = std::min(mHeader.blockVertexCount, vertexCount - block * mHeader.blockVertexCount);
+            const size_t first = size_t(block) * mHeader.blockVertexCount;
+
+            std::vector<uint8_t> planes;
+            if (!isDecoded)
+            {
+                const BlockEntry& entry = mpBlockTable[size_t(keyframe) * mBlockCount + block];
+                planes.resize(size_t(n) * planeCount);
+                int size = LZ4_decompress_safe(reinterpret_cast<const char*>(pData + entry.offset), reinterpret_cast<char*>(planes.data()), (int)entry.size, (int)planes.size());
+                if (size != (int)planes.size()) FALCOR_THROW("Vertex cache file '{}' is corrupt.", mPath);
+            }
+
+            for (uint32_t v = 0; v < n; v++)
+            {
+                const size_t i = first + v;
+                uint16_t* pPosition = &state.positions[i * 3];
+                uint32_t* pWords = state.words.data() + i * wordCount;
+
+                if (!isDecoded)
+                {
+                    for (uint32_t c = 0; c < 3; c++)
+                    {
+                        uint16_t d = unzigzag(uint16_t(planes[(2 * c) * n + v] | (planes[(2 * c + 1) * n + v] << 8)));
+                        pPosition[c] = isIndependent ? d : uint16_t(pPosition[c] + d);
+                    }
+                    for (uint32_t w = 0; w < wordCount; w++)
+                    {
+                        uint32_t d = 0;
+                        for (uint32_t b = 0; b < 4; b++) d |= uint32_t(planes[(kPositionPlaneCount + w * 4 + b) * n + v]) << (8 * b);
+                        pWords[w] = isIndependent ? d : pWords[w] ^ d;
+                    }
+                }
+
+                if (pOutput)
+                {
+                    uint8_t* pVertex = pOutput + i * mHeader.vertexStride;
+                    float3 p = mHeader.boundsMin + float3(pPosition[0], pPosition[1], pPosition[2]) * step;
+                    std::memcpy(pVertex, &p, sizeof(float3));
+                    std::memcpy(pVertex + sizeof(float3), pWords, wordCount * sizeof(uint32_t));
+                }
+            }
+        });
+
+        state.keyframe = keyframe;
+    }
+}
@@ -0,0 +1,159 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Utils/Math/Vector.h"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+namespace Falcor
+{
+    /** Compressed vertex cache file for streaming animated vertex caches from disk.
+
+        A vertex cache stores the vertices of a mesh or curve at each keyframe. Vertices are fixed-size records that start with a float3 position
+        followed by 32-bit words, e.g. PackedStaticVertexData or DynamicCurveVertexData.
+
+        Positions are quantized to 16 bits per component in the bounding box of all keyframes, the remaining words are stored losslessly.
+        Each keyframe is stored as a delta from the previous keyframe, as differences of quantized positions and XOR of words.
+        Every keyframeInterval-th keyframe is stored as a delta from zero so that playback can seek without decoding from the first keyframe.
+        The deltas of each block of blockVertexCount vertices are split into byte planes and LZ4 compressed, so that blocks can be decoded in parallel.
+
+        File layout:
+        - Header.
+        - Keyframe times (double per keyframe).
+        - Block table, one BlockEntry per block of each keyframe, keyframe major.
+        - Compressed blocks.
+    */
+    class FALCOR_API VertexCacheFile
+    {
+    public:
+        static constexpr uint32_t kDefaultKeyframeInterval = 16;
+        static constexpr uint32_t kDefaultBlockVertexCount = 16384;
+
+        struct Header
+        {
+            uint32_t magic = 0;
+            uint32_t version = 0;
+            uint32_t vertexCount = 0;       ///< Number of vertices per keyframe.
+            uint32_t vertexStride = 0;      ///< Size of a vertex record in bytes.
+            uint32_t keyframeCount = 0;     ///< Number of keyframes.
+            uint32_t keyframeInterval = 0;  ///< Keyframes at multiples of this interval don't depend on the previous keyframe.
+            uint32_t blockVertexCount = 0;  ///< Number of vertices per compressed block.
+            uint32_t reserved = 0;
+            float3 boundsMin;               ///< Minimum of the positions over all keyframes.
+            float3 boundsMax;               ///< Maximum of the positions over all keyframes.
+        };
+
+        struct BlockEntry
+        {
+            uint64_t offset = 0;            ///< Byte offset of the compressed block in the file.
+            uint32_t size = 0;              ///< Size of the compressed block in bytes.
+            uint32_t reserved = 0;
+        };
+
+        /** Decoder state holding the quantized vertices of the last decoded keyframe.
+        */
+        struct State
+        {
+            static constexpr uint32_t kInvalidKeyframe = 0xffffffff;
+
+            uint32_t keyframe = kInvalidKeyframe;   ///< Keyframe held by the state.
+            std::vector<uint16_t> positions;        ///< Quantized positions, 3 per vertex.
+            std::vector<uint32_t> words;            ///< Words following the position, wordCount per vertex.
+        };
+
+        /** Function returning the vertex records of a keyframe. The returned pointer only needs to stay valid until the next call.
+        */
+        using KeyframeFunc = std::function<const void*(uint32_t keyframe)>;
+
+        /** Write a vertex cache file.
+            The keyframes are requested twice, once for computing the bounds and once for encoding, and only one keyframe is held in memory at a time.
+            \param[in] path The path of the output file.
+            \param[in] timeSamples The keyframe times in increasing order.
+            \param[in] vertexCount The number of vertices per keyframe.
+            \param[in] vertexStride The size of a vertex record in bytes. Must be at least 12 and a multiple of 4.
+            \param[in] getKeyframe Function returning the vertex records of a keyframe.
+            \param[in] keyframeInterval Interval of keyframes that are encoded independently of the previous keyframe.
+            \return true if the file could be written, otherwise false.
+        */
+        static bool write(const std::filesystem::path& path, const std::vector<double>& timeSamples, uint32_t vertexCount, uint32_t vertexStride, const KeyframeFunc& getKeyframe, uint32_t keyframeInterval = kDefaultKeyframeInterval);
+
+        /** Write a vertex cache file from keyframes held in memory.
+            \param[in] path The path of the output file.
+            \param[in] timeSamples The keyframe times in increasing order.
+            \param[in] vertexData The vertex records of each keyframe, e.g. CachedMesh::vertexData.
+            \param[in] keyframeInterval Interval of keyframes that are encoded independently of the previous keyframe.
+            \return true if the file could be written, otherwise false.
+        */
+        template<typename T>
+        static bool write(const std::filesystem::path& path, const std::vector<double>& timeSamples, const std::vector<std::vector<T>>& vertexData, uint32_t keyframeInterval = kDefaultKeyframeInterval)
+        {
+            static_assert(sizeof(T) >= sizeof(float3) && sizeof(T) % sizeof(uint32_t) == 0, "Vertex records must start with a float3 position followed by 32-bit words");
+            uint32_t vertexCount = vertexData.empty() ? 0 : (uint32_t)vertexData[0].size();
+            return write(path, timeSamples, vertexCount, sizeof(T), [&](uint32_t keyframe) { return (const void*)vertexData[keyframe].data(); }, keyframeInterval);
+        }
+
+        /** Open a vertex cache file. The file is memory-mapped. Throws an exception if the file is not a valid vertex cache file.
+            \param[in] path The path of the vertex cache file.
+        */
+        VertexCacheFile(const std::filesystem::path& path);
+
+        const std::filesystem::path& getPath() const { return mPath; }
+        const Header& getHeader() const { return mHeader; }
+        const std::vector<double>& getTimeSamples() const { return mTimeSamples; }
+        uint32_t getVertexCount() const { return mHeader.vertexCount; }
+        uint32_t getVertexStride() const { return mHeader.vertexStride; }
+        uint32_t getKeyframeCount() const { return mHeader.keyframeCount; }
+
+        /** Get the compressed size of a keyframe in bytes.
+        */
+        uint64_t getCompressedSize(uint32_t keyframe) const;
+
+        /** Decode a keyframe.
+            If the state doesn't hold the previous keyframe, the keyframes since the last independently encoded keyframe are decoded first.
+            \param[in] keyframe The keyframe to decode.
+            \param[in,out] state Decoder state. Holds the decoded keyframe on return.
+            \param[out] pVertices Optional buffer receiving vertexCount vertex records with dequantized positions.
+        */
+        void decodeKeyframe(uint32_t keyframe, State& state, void* pVertices) const;
+
+    private:
+        void decodeDelta(uint32_t keyframe, State& state, void* pVertices) const;
+
+        std::filesystem::path mPath;
+        MemoryMappedFile mFile;
+        Header mHeader;
+        uint32_t mWordCount = 0;
+        uint32_t mBlockCount = 0;
+        std::vector<double> mTimeSamples;
+        const BlockEntry* mpBlockTable = nullptr;
+    };
+}
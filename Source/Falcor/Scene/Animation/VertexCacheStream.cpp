@@ -0,0 +1,300 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "VertexCacheStream.h"
+#include "Core/Error.h"
+#include "Utils/Logger.h"
+#include <algorithm>
+#include <deque>
+#include <thread>
+
+namespace Falcor
+{
+    namespace
+    {
+        /// Maximum number of decode threads shared by all streams.
+        const uint32_t kMaxDecodeThreadCount = 4;
+
+        double toSeconds(std::chrono::steady_clock::duration duration)
+        {
+            return std::chrono::duration<double>(duration).count();
+        }
+    }
+
+    /** Queue of streams with keyframes to decode, served by the shared decode threads.
+        A stream is queued at most once. A decode thread decodes one keyframe of the stream and queues it again at the back
+        if it has more work, so the streams take turns.
+    */
+    class VertexCacheStream::Scheduler
+    {
+    public:
+        static Scheduler& get()
+        {
+            static Scheduler sScheduler;
+            return sScheduler;
+        }
+
+        ~Scheduler()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mTerminate = true;
+            }
+            mCondition.notify_all();
+            for (auto& thread : mThreads) thread.join();
+        }
+
+        /** Queue a stream. The threads are started on first use.
+        */
+        void schedule(VertexCacheStream* pStream)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (mThreads.empty())
+                {
+                    uint32_t threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, kMaxDecodeThreadCount);
+                    for (uint32_t i = 0; i < threadCount; i++) mThreads.emplace_back(&Scheduler::run, this);
+                }
+                mQueue.push_back(pStream);
+            }
+            mCondition.notify_one();
+        }
+
+        /** Remove a stream from the queue.
+            eturn True if the stream was queued, false if it is not queued or a decode thread already took it.
+        */
+        bool cancel(VertexCacheStream* pStream)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto it = std::find(mQueue.begin(), mQueue.end(), pStream);
+            if (it == mQueue.end()) return false;
+            mQueue.erase(it);
+            return true;
+        }
+
+    private:
+        Scheduler() = default;
+
+        void run()
+        {
+            while (true)
+            {
+                VertexCacheStream* pStream = nullptr;
+                {
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    mCondition.wait(lock, [&]() { return mTerminate || !mQueue.empty(); });
+                    if (mTerminate) return;
+                    pStream = mQueue.front();
+                    mQueue.pop_front();
+                }
+                pStream->decodeNext();
+            }
+        }
+
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::deque<VertexCacheStream*> mQueue;
+        std::vector<std::thread> mThreads;
+        bool mTerminate = false;
+    };
+
+    VertexCacheStream::VertexCacheStream(const std::filesystem::path& path, uint32_t windowSize)
+        : mFile(path)
+    {
+        FALCOR_CHECK(mFile.getKeyframeCount() > 0, "Vertex cache file '{}' has no keyframes", path);
+
+        // Slot memory is allocated on first use, so a window larger than the keyframe count only costs empty slots.
+        mSlots.resize(std::max(windowSize, 2u));
+    }
+
+    VertexCacheStream::~VertexCacheStream()
+    {
+        // Lock order is stream before scheduler, the decode threads don't hold the scheduler lock while decoding.
+        std::unique_lock<std::mutex> lock(mMutex);
+        mTerminate = true;
+        if (mScheduled && Scheduler::get().cancel(this)) mScheduled = false;
+        mIdleCondition.wait(lock, [&]() { return !mScheduled; });
+    }
+
+    std::pair<const void*, const void*> VertexCacheStream::getKeyframes(uint32_t first, uint32_t second)
+    {
+        const uint32_t keyframeCount = mFile.getKeyframeCount();
+        FALCOR_CHECK(first < keyframeCount && second < keyframeCount, "Keyframes ({}, {}) are out of range", first, second);
+
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        // Move the window to the requested keyframes followed by the next keyframes in playback order.
+        mWanted.clear();
+        mWanted.push_back(first);
+        if (second != first) mWanted.push_back(second);
+        for (uint32_t i = 1; i < keyframeCount && mWanted.size() < mSlots.size(); i++)
+        {
+            uint32_t keyframe = (first + i) % keyframeCount;
+            if (keyframe != second) mWanted.push_back(keyframe);
+        }
+        if (!mScheduled && hasWork())
+        {
+            mScheduled = true;
+            Scheduler::get().schedule(this);
+        }
+        mStats.keyframesRequested += first == second ? 1 : 2;
+
+        auto isReady = [&]() { return mException || (findSlot(first) && findSlot(second)); };
+        if (!isReady())
+        {
+            auto stallStart = Clock::now();
+            mDecodedCondition.wait(lock, isReady);
+            mStats.stallCount++;
+            mStats.stallTime += toSeconds(Clock::now() - stallStart);
+        }
+        if (mException) std::rethrow_exception(mException);
+
+        return { findSlot(first)->data.data(), findSlot(second)->data.data() };
+    }
+
+    uint64_t VertexCacheStream::getMemoryUsageInBytes() const
+    {
+        const auto& header = mFile.getHeader();
+        uint64_t m = uint64_t(header.vertexCount) * (3 * sizeof(uint16_t) + header.vertexStride - sizeof(float3));
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto& slot : mSlots) m += slot.data.capacity();
+        return m;
+    }
+
+    VertexCacheStream::Stats VertexCacheStream::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
+    void VertexCacheStream::resetStats()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats = {};
+    }
+
+    bool VertexCacheStream::isWanted(uint32_t keyframe) const
+    {
+        return std::find(mWanted.begin(), mWanted.end(), keyframe) != mWanted.end();
+    }
+
+    const VertexCacheStream::Slot* VertexCacheStream::findSlot(uint32_t keyframe) const
+    {
+        for (const auto& slot : mSlots)
+        {
+            if (slot.keyframe == keyframe && !slot.isDecoding) return &slot;
+        }
+        return nullptr;
+    }
+
+    bool VertexCacheStream::findWork(uint32_t& keyframe, Slot*& pSlot)
+    {
+        // Find the first wanted keyframe that is not decoded.
+        auto it = std::find_if(mWanted.begin(), mWanted.end(), [&](uint32_t k)
+        {
+            return std::none_of(mSlots.begin(), mSlots.end(), [k](const Slot& slot) { return slot.keyframe == k; });
+        });
+        if (it == mWanted.end()) return false;
+
+        // There are at least as many slots as wanted keyframes, so one of the slots holds a keyframe that is no longer wanted.
+        auto slotIt = std::find_if(mSlots.begin(), mSlots.end(), [&](const Slot& slot) { return !isWanted(slot.keyframe); });
+        FALCOR_ASSERT(slotIt != mSlots.end());
+
+        keyframe = *it;
+        pSlot = &*slotIt;
+        return true;
+    }
+
+    bool VertexCacheStream::hasWork()
+    {
+        uint32_t keyframe = 0;
+        Slot* pSlot = nullptr;
+        return !mTerminate && !mException && findWork(keyframe, pSlot);
+    }
+
+    void VertexCacheStream::decodeNext()
+    {
+        const auto& header = mFile.getHeader();
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        uint32_t keyframe = 0;
+        Slot* pSlot = nullptr;
+        if (mTerminate || mException || !findWork(keyframe, pSlot))
+        {
+            mScheduled = false;
+            mIdleCondition.notify_all();
+            return;
+        }
+
+        // Reserve the slot. Requests don't read slots that are being decoded and the slot is no longer wanted, so nothing else touches it.
+        pSlot->keyframe = keyframe;
+        pSlot->isDecoding = true;
+        lock.unlock();
+
+        auto decodeStart = Clock::now();
+        std::exception_ptr exception;
+        try
+        {
+            pSlot->data.resize(size_t(header.vertexCount) * header.vertexStride);
+            mFile.decodeKeyframe(keyframe, mState, pSlot->data.data());
+        }
+        catch (const std::exception& e)
+        {
+            logError("Failed to decode keyframe {} of vertex cache '{}': {}", keyframe, mFile.getPath(), e.what());
+            exception = std::current_exception();
+        }
+        auto decodeEnd = Clock::now();
+
+        lock.lock();
+        pSlot->isDecoding = false;
+        if (exception)
+        {
+            pSlot->keyframe = VertexCacheFile::State::kInvalidKeyframe;
+            mState = {};
+            mException = exception;
+        }
+        else
+        {
+            mStats.keyframesDecoded++;
+            mStats.compressedBytes += mFile.getCompressedSize(keyframe);
+            mStats.decodedBytes += pSlot->data.size();
+        }
+        mStats.decodeTime += toSeconds(decodeEnd - decodeStart);
+        mDecodedCondition.notify_all();
+
+        // Give the other queued streams a turn before decoding the next keyframe.
+        if (hasWork())
+        {
+            Scheduler::get().schedule(this);
+        }
+        else
+        {
+            mScheduled = false;
+            mIdleCondition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,134 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "VertexCacheFile.h"
+#include "Core/Macros.h"
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Falcor
+{
+    /** Streams the keyframes of a vertex cache file during playback.
+
+        A window of upcoming keyframes is decoded ahead of the playback position into a bounded number of slots.
+        Decoding runs on a small set of decode threads shared by all streams, which take turns decoding one keyframe of
+        each stream with pending work, so scenes with many cached meshes don't start a thread per mesh.
+        Keyframes are decoded in playback order (wrapping around at the end for looped playback), so each keyframe is usually
+        a delta from the keyframe decoded before it. Requesting a keyframe that is not decoded yet blocks and counts as a stall.
+    */
+    class FALCOR_API VertexCacheStream
+    {
+    public:
+        static constexpr uint32_t kDefaultWindowSize = 8;
+
+        struct Stats
+        {
+            uint64_t keyframesRequested = 0;    ///< Number of keyframes requested through getKeyframes().
+            uint64_t keyframesDecoded = 0;      ///< Number of keyframes decoded for the stream.
+            uint64_t compressedBytes = 0;       ///< Compressed size of the decoded keyframes.
+            uint64_t decodedBytes = 0;          ///< Uncompressed size of the decoded keyframes.
+            uint64_t stallCount = 0;            ///< Number of requests that had to wait for a keyframe to be decoded.
+            double stallTime = 0.0;             ///< Total time requests waited for keyframes in seconds.
+            double decodeTime = 0.0;            ///< Total time spent decoding in seconds.
+
+            /// Returns the decoded (uncompressed) bytes per second of decode time.
+            double getDecodedBytesPerSecond() const { return decodeTime > 0.0 ? double(decodedBytes) / decodeTime : 0.0; }
+        };
+
+        /** Constructor. Throws an exception if the file can't be opened.
+            \param[in] path Path of the vertex cache file.
+            \param[in] windowSize Number of decoded keyframes held in memory, including the requested ones. At least 2.
+        */
+        VertexCacheStream(const std::filesystem::path& path, uint32_t windowSize = kDefaultWindowSize);
+
+        /** Destructor. Waits for a keyframe being decoded for the stream to finish.
+        */
+        ~VertexCacheStream();
+
+        VertexCacheStream(const VertexCacheStream&) = delete;
+        VertexCacheStream& operator=(const VertexCacheStream&) = delete;
+
+        const VertexCacheFile& getFile() const { return mFile; }
+
+        /** Get the decoded vertex data of two keyframes, typically the keyframes to interpolate between.
+            Moves the decode window to start at the first keyframe and blocks until both keyframes are decoded.
+            The returned pointers stay valid until the next call.
+            \param[in] first First keyframe. Decoding continues with the keyframes following it.
+            \param[in] second Second keyframe.
+            \return Pointers to vertexCount vertex records of each keyframe.
+        */
+        std::pair<const void*, const void*> getKeyframes(uint32_t first, uint32_t second);
+
+        /** Get the memory used by decoded keyframes and decoder state in bytes.
+        */
+        uint64_t getMemoryUsageInBytes() const;
+
+        Stats getStats() const;
+
+        void resetStats();
+
+    private:
+        struct Slot
+        {
+            uint32_t keyframe = VertexCacheFile::State::kInvalidKeyframe;
+            bool isDecoding = false;
+            std::vector<uint8_t> data;
+        };
+
+        using Clock = std::chrono::steady_clock;
+
+        bool isWanted(uint32_t keyframe) const;
+        const Slot* findSlot(uint32_t keyframe) const;
+        bool findWork(uint32_t& keyframe, Slot*& pSlot);
+        bool hasWork();
+        void decodeNext();
+
+        class Scheduler;
+
+        VertexCacheFile mFile;
+        VertexCacheFile::State mState;      ///< Decoder state. Only accessed by the decode thread holding the stream.
+
+        mutable std::mutex mMutex;
+        std::condition_variable mDecodedCondition;  ///< Condition variable for requests to wait on decoded keyframes.
+        std::condition_variable mIdleCondition;     ///< Condition variable for the destructor to wait on the decode threads.
+
+        // Internal state. Do not access outside of critical section.
+        std::vector<Slot> mSlots;
+        std::vector<uint32_t> mWanted;      ///< Keyframes to hold in the slots, in decode order.
+        bool mScheduled = false;            ///< True while the stream is queued or being decoded on a decode thread.
+        bool mTerminate = false;
+        std::exception_ptr mException;     ///< Exception thrown by decoding, rethrown by getKeyframes().
+        Stats mStats;
+    };
+}
@@ -32,6 +32,8 @@
 #include "Utils/Math/CubicSpline.h"
 #include "Utils/Math/Matrix.h"
 #include "Utils/Math/Quaternion.h"
+#include "Utils/TaskManager.h"
+#include <algorithm>
 #include <cmath>
 
 namespace Falcor
@@ -98,7 +100,81 @@ namespace Falcor
             return std::max(w, (float)std::numeric_limits<float16_t>::min());
         }
 
-        void optimizeStrandGeometry(CubicSplineCache& splineCache, const CurveArrays& curveArrays, StrandArrays& strandArrays, StrandArrays& optimizedStrandArrays, uint32_t pointOffset, uint32_t subdivPerSegment, uint32_t keepOneEveryXVerticesPerStrand, float widthScale)
+        /// Strands are tessellated in parallel in tasks of this many strands, each task reusing its own scratch arrays.
+        const uint32_t kStrandsPerTask = 256;
+
+        /// Per-strand offsets into the input and output arrays, so that strands can be tessellated in parallel.
+        struct StrandLayout
+        {
+            uint32_t strandCount = 0;                 ///< Number of kept strands.
+            std::vector<uint32_t> pointOffsets;       ///< Offset of the first control point of each kept strand.
+            std::vector<uint32_t> outputPointOffsets; ///< Offset of the first tessellated point of each kept strand, followed by the total number of points.
+        };
+
+        /// Number of control points left after removing consecutive duplicates.
+        uint32_t countUniqueControlPoints(const float3* controlPoints, uint32_t vertexCount)
+        {
+            uint32_t count = 1;
+            for (uint32_t j = 0; j < vertexCount - 1; j++)
+            {
+                if (any(controlPoints[j] != controlPoints[j + 1])) count++;
+            }
+            return count;
+        }
+
+        /** Compute the input and output offsets of the kept strands.
+            The number of tessellated points of a strand depends on its number of unique control points, which is computed in parallel.
+        */
+        StrandLayout computeStrandLayout(uint32_t strandCount, const uint32_t* vertexCountsPerStrand, const float3* controlPoints, uint32_t subdivPerSegment, uint32_t keepOneEveryXStrands, uint32_t keepOneEveryXVerticesPerStrand)
+        {
+            StrandLayout layout;
+            layout.strandCount = div_round_up(strandCount, keepOneEveryXStrands);
+
+            std::vector<uint32_t> allPointOffsets(strandCount);
+            parallelExclusiveScan(vertexCountsPerStrand, vertexCountsPerStrand + strandCount, allPointOffsets.begin(), 0u);
+
+            std::vector<uint32_t> pointCounts(layout.strandCount + 1, 0);
+            layout.pointOffsets.resize(layout.strandCount);
+            parallelFor(0, layout.strandCount, [&](uint32_t i)
+            {
+                uint32_t strand = i * keepOneEveryXStrands;
+                layout.pointOffsets[i] = allPointOffsets[strand];
+                uint32_t uniqueCount = countUniqueControlPoints(controlPoints + layout.pointOffsets[i], vertexCountsPerStrand[strand]);
+                pointCounts[i] = div_round_up(subdivPerSegment * (uniqueCount - 1), keepOneEveryXVerticesPerStrand) + 1;
+            });
+            layout.outputPointOffsets.resize(layout.strandCount + 1);
+            parallelExclusiveScan(pointCounts.begin(), pointCounts.end(), layout.outputPointOffsets.begin(), 0u);
+
+            return layout;
+        }
+
+        /// Run func(firstStrand, endStrand) for the kept strands in parallel tasks.
+        template<typename F>
+        void forEachStrandTask(uint32_t strandCount, F func)
+        {
+            parallelForRange(0, strandCount, [&](size_t first, size_t end) { func((uint32_t)first, (uint32_t)end); }, kStrandsPerTask);
+        }
+
+        /** Evaluate a spline at the kept sub-segment points followed by the end point.
+            This matches keeping one of every keepOneEveryXVerticesPerStrand samples along the whole strand.
+        */
+        template<typename T, typename F>
+        void forEachSample(const CubicSpline<T>& spline, uint32_t vertexCount, uint32_t subdivPerSegment, uint32_t keepOneEveryXVerticesPerStrand, F func)
+        {
+            const uint32_t sampleCount = (vertexCount - 1) * subdivPerSegment;
+            for (uint32_t sample = 0; sample < sampleCount; sample += keepOneEveryXVerticesPerStrand)
+            {
+                uint32_t j = sample / subdivPerSegment;
+                uint32_t k = sample % subdivPerSegment;
+                float t = (float)k / (float)subdivPerSegment;
+                func(spline.interpolate(j, t));
+            }
+
+            // Always keep the last vertex.
+            func(spline.interpolate(vertexCount - 2, 1.f));
+        }
+
+        void removeDuplicateControlPoints(const CurveArrays& curveArrays, StrandArrays& strandArrays, uint32_t pointOffset)
         {
             strandArrays.controlPoints.clear();
             strandArrays.UVs.clear();
@@ -119,51 +195,37 @@ namespace Falcor
             strandArrays.controlPoints.push_back(curveArrays.controlPoints[pointOffset + strandArrays.vertexCount - 1]);
             strandArrays.widths.push_back(curveArrays.widths[pointOffset + strandArrays.vertexCount - 1]);
             if (curveArrays.UVs) strandArrays.UVs.push_back(curveArrays.UVs[pointOffset + strandArrays.vertexCount - 1]);
+        }
+
+        void optimizeStrandGeometry(CubicSplineCache& splineCache, const CurveArrays& curveArrays, StrandArrays& strandArrays, StrandArrays& optimizedStrandArrays, uint32_t pointOffset, uint32_t subdivPerSegment, uint32_t keepOneEveryXVerticesPerStrand, float widthScale)
+        {
+            removeDuplicateControlPoints(curveArrays, strandArrays, pointOffset);
 
+            optimizedStrandArrays.controlPoints.clear();
+            optimizedStrandArrays.UVs.clear();
+            optimizedStrandArrays.widths.clear();
             optimizedStrandArrays.vertexCount = static_cast<uint32_t>(strandArrays.controlPoints.size());
 
             const CubicSpline<float3>& splinePoints = splineCache.optSplinePoints.setup(strandArrays.controlPoints.data(), optimizedStrandArrays.vertexCount);
             const CubicSpline<float>& splineWidths = splineCache.optSplineWidths.setup(strandArrays.widths.data(), optimizedStrandArrays.vertexCount);
 
-            uint32_t tmpCount = 0;
-            for (uint32_t j = 0; j < optimizedStrandArrays.vertexCount - 1; j++)
+            forEachSample(splinePoints, optimizedStrandArrays.vertexCount, subdivPerSegment, keepOneEveryXVerticesPerStrand, [&](const float3& point)
             {
-                for (uint32_t k = 0; k < subdivPerSegment; k++)
-                {
-                    if (tmpCount % keepOneEveryXVerticesPerStrand == 0)
-                    {
-                        float t = (float)k / (float)subdivPerSegment;
-                        optimizedStrandArrays.controlPoints.push_back(splinePoints.interpolate(j, t));
-                        optimizedStrandArrays.widths.push_back(sanitizeWidth(kMeshCompensationScale * widthScale * splineWidths.interpolate(j, t)));
-                    }
-                    tmpCount++;
-                }
-            }
-
-            // Always keep the last vertex.
-            optimizedStrandArrays.controlPoints.push_back(splinePoints.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f));
-            optimizedStrandArrays.widths.push_back(sanitizeWidth(kMeshCompensationScale * widthScale * splineWidths.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f)));
+                optimizedStrandArrays.controlPoints.push_back(point);
+            });
+            forEachSample(splineWidths, optimizedStrandArrays.vertexCount, subdivPerSegment, keepOneEveryXVerticesPerStrand, [&](float width)
+            {
+                optimizedStrandArrays.widths.push_back(sanitizeWidth(kMeshCompensationScale * widthScale * width));
+            });
 
             // Texture coordinates.
             if (curveArrays.UVs)
             {
                 const CubicSpline<float2>& splineUVs = splineCache.optSplineUVs.setup(strandArrays.UVs.data(), optimizedStrandArrays.vertexCount);
-                tmpCount = 0;
-                for (uint32_t j = 0; j < optimizedStrandArrays.vertexCount - 1; j++)
+                forEachSample(splineUVs, optimizedStrandArrays.vertexCount, subdivPerSegment, keepOneEveryXVerticesPerStrand, [&](const float2& uv)
                 {
-                    for (uint32_t k = 0; k < subdivPerSegment; k++)
-                    {
-                        if (tmpCount % keepOneEveryXVerticesPerStrand == 0)
-                        {
-                            float t = (float)k / (float)subdivPerSegment;
-                            optimizedStrandArrays.UVs.push_back(splineUVs.interpolate(j, t));
-                        }
-                        tmpCount++;
-                    }
-                }
-
-                // Always keep the last vertex.
-                optimizedStrandArrays.UVs.push_back(splineUVs.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f));
+                    optimizedStrandArrays.UVs.push_back(uv);
+                });
             }
         }
 
@@ -203,40 +265,56 @@ namespace Falcor
             FALCOR_ASSERT_LT(std::abs(length(t) - 1.f), 1e-3f);
         }
 
-        void updateMeshResultBuffers(CurveTessellation::MeshResult& result, const CurveArrays& curveArrays, StrandArrays& optimizedStrandArrays, const float3& fwd, const float3& s, const float3& t, uint32_t pointCountPerCrossSection, uint32_t j)
+        /// Cosine and sine of the angles of the points in a cross-section, these are the same for all cross-sections.
+        std::vector<float2> computeCrossSectionAngles(uint32_t pointCountPerCrossSection)
         {
-            // Mesh vertices, normals, tangents, and texCrds (if any).
+            std::vector<float2> angles(pointCountPerCrossSection);
             for (uint32_t k = 0; k < pointCountPerCrossSection; k++)
             {
                 float phi = (float)k / (float)pointCountPerCrossSection * (float)M_PI * 2.f;
-                float3 vNormal = std::cos(phi) * s + std::sin(phi) * t;
+                angles[k] = float2(std::cos(phi), std::sin(phi));
+            }
+            return angles;
+        }
 
+        void updateMeshResultBuffers(CurveTessellation::MeshResult& result, const CurveArrays& curveArrays, StrandArrays& optimizedStrandArrays, const float3& fwd, const float3& s, const float3& t, const std::vector<float2>& crossSectionAngles, uint32_t meshVertexOffset, uint32_t j)
+        {
+            const uint32_t pointCountPerCrossSection = (uint32_t)crossSectionAngles.size();
+
+            // Mesh vertices, normals, tangents, and texCrds (if any).
+            for (uint32_t k = 0; k < pointCountPerCrossSection; k++)
+            {
+                float3 vNormal = crossSectionAngles[k].x * s + crossSectionAngles[k].y * t;
+
+                const uint32_t vertex = meshVertexOffset + j * pointCountPerCrossSection + k;
                 float curveRadius = 0.5f * optimizedStrandArrays.widths[j];
-                result.vertices.push_back(optimizedStrandArrays.controlPoints[j] + curveRadius * vNormal);
-                result.normals.push_back(vNormal);
-                result.tangents.push_back(float4(fwd.x, fwd.y, fwd.z, 1));
-                result.radii.push_back(curveRadius);
+                result.vertices[vertex] = optimizedStrandArrays.controlPoints[j] + curveRadius * vNormal;
+                result.normals[vertex] = vNormal;
+                result.tangents[vertex] = float4(fwd.x, fwd.y, fwd.z, 1);
+                result.radii[vertex] = curveRadius;
 
                 if (curveArrays.UVs)
                 {
-                    result.texCrds.push_back(optimizedStrandArrays.UVs[j]);
+                    result.texCrds[vertex] = optimizedStrandArrays.UVs[j];
                 }
             }
         }
 
-        void connectFaceVertices(CurveTessellation::MeshResult& result, uint32_t meshVertexOffset, uint32_t pointCountPerCrossSection, uint32_t quadCountLimit, uint32_t nextCrossSectionVertexOffset, uint32_t multiplier, uint32_t j)
+        void connectFaceVertices(CurveTessellation::MeshResult& result, uint32_t meshVertexOffset, uint32_t faceOffset, uint32_t pointCountPerCrossSection, uint32_t quadCountLimit, uint32_t nextCrossSectionVertexOffset, uint32_t multiplier, uint32_t j)
         {
+            uint32_t* pFaceVertexCounts = result.faceVertexCounts.data() + faceOffset;
+            uint32_t* pFaceVertexIndices = result.faceVertexIndices.data() + 3 * faceOffset;
             for (uint32_t k = 0; k < quadCountLimit; k++)
             {
-                result.faceVertexCounts.push_back(3);
-                result.faceVertexIndices.push_back(meshVertexOffset + multiplier * j * pointCountPerCrossSection + k);
-                result.faceVertexIndices.push_back(meshVertexOffset + multiplier * j * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection);
-                result.faceVertexIndices.push_back(meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection);
-
-                result.faceVertexCounts.push_back(3);
-                result.faceVertexIndices.push_back(meshVertexOffset + multiplier * j * pointCountPerCrossSection + k);
-                result.faceVertexIndices.push_back(meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection);
-                result.faceVertexIndices.push_back(meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + k);
+                *pFaceVertexCounts++ = 3;
+                *pFaceVertexIndices++ = meshVertexOffset + multiplier * j * pointCountPerCrossSection + k;
+                *pFaceVertexIndices++ = meshVertexOffset + multiplier * j * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection;
+                *pFaceVertexIndices++ = meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection;
+
+                *pFaceVertexCounts++ = 3;
+                *pFaceVertexIndices++ = meshVertexOffset + multiplier * j * pointCountPerCrossSection + k;
+                *pFaceVertexIndices++ = meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection;
+                *pFaceVertexIndices++ = meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + k;
             }
         }
     }
@@ -250,93 +328,61 @@ namespace Falcor
         FALCOR_ASSERT(degree == 1);
         result.degree = degree;
 
-        uint32_t pointCounts = 0;
-        uint32_t segCounts = 0;
-        uint32_t maxVertexCountsPerStrand = 0;
-        for (uint32_t i = 0; i < strandCount; i += keepOneEveryXStrands)
-        {
-            uint32_t tmpPointCount = div_round_up(subdivPerSegment * (vertexCountsPerStrand[i] - 1), keepOneEveryXVerticesPerStrand) + 1;
-            pointCounts += tmpPointCount;
-            segCounts += tmpPointCount - 1;
-            maxVertexCountsPerStrand = std::max(maxVertexCountsPerStrand, vertexCountsPerStrand[i]);
-        }
-        result.indices.reserve(segCounts);
-        result.points.reserve(pointCounts);
-        result.radius.reserve(pointCounts);
-        result.texCrds.reserve(pointCounts);
+        // First pass: compute where each strand is written, so that the strands can be tessellated in parallel.
+        StrandLayout layout = computeStrandLayout(strandCount, vertexCountsPerStrand, controlPoints, subdivPerSegment, keepOneEveryXStrands, keepOneEveryXVerticesPerStrand);
+        const uint32_t pointCount = layout.outputPointOffsets[layout.strandCount];
 
-        uint32_t pointOffset = 0;
+        // Each strand has one segment less than points.
+        result.indices.resize(pointCount - layout.strandCount);
+        result.points.resize(pointCount);
+        result.radius.resize(pointCount);
+        if (UVs) result.texCrds.resize(pointCount);
 
-        StrandArrays strandArrays;
-        strandArrays.controlPoints.reserve(maxVertexCountsPerStrand);
-        strandArrays.widths.reserve(maxVertexCountsPerStrand);
-        strandArrays.UVs.reserve(maxVertexCountsPerStrand);
+        // Second pass: tessellate the strands.
         CurveArrays curveArrays(controlPoints, widths, UVs);
-
-        StrandArrays optimizedStrandArrays;
-        CubicSplineCache splineCache;
-        for (uint32_t i = 0; i < strandCount; i += keepOneEveryXStrands)
+        forEachStrandTask(layout.strandCount, [&](uint32_t firstStrand, uint32_t endStrand)
         {
-            optimizedStrandArrays.controlPoints.clear();
-            optimizedStrandArrays.UVs.clear();
-            optimizedStrandArrays.widths.clear();
-            optimizedStrandArrays.vertexCount = 0;
-            strandArrays.vertexCount = vertexCountsPerStrand[i];
-
-            optimizeStrandGeometry(splineCache, curveArrays, strandArrays, optimizedStrandArrays, pointOffset, subdivPerSegment, keepOneEveryXVerticesPerStrand, widthScale);
-
-            const CubicSpline<float3>& splinePoints = splineCache.splinePoints.setup(strandArrays.controlPoints.data(), optimizedStrandArrays.vertexCount);
-            const CubicSpline<float>& splineWidths = splineCache.splineWidths.setup(strandArrays.widths.data(), optimizedStrandArrays.vertexCount);
-
-            uint32_t tmpCount = 0;
-            for (uint32_t j = 0; j < optimizedStrandArrays.vertexCount - 1; j++)
+            StrandArrays strandArrays;
+            CubicSplineCache splineCache;
+            for (uint32_t i = firstStrand; i < endStrand; i++)
             {
-                for (uint32_t k = 0; k < subdivPerSegment; k++)
-                {
-                    if (tmpCount % keepOneEveryXVerticesPerStrand == 0)
-                    {
-                        float t = (float)k / (float)subdivPerSegment;
-                        result.indices.push_back((uint32_t)result.points.size());
+                strandArrays.vertexCount = vertexCountsPerStrand[i * keepOneEveryXStrands];
+                removeDuplicateControlPoints(curveArrays, strandArrays, layout.pointOffsets[i]);
+                const uint32_t vertexCount = static_cast<uint32_t>(strandArrays.controlPoints.size());
 
-                        // Pre-transform curve points.
-                        float4 sph = transformSphere(xform, float4(splinePoints.interpolate(j, t), sanitizeWidth(splineWidths.interpolate(j, t) * 0.5f * widthScale)));
+                const CubicSpline<float3>& splinePoints = splineCache.splinePoints.setup(strandArrays.controlPoints.data(), vertexCount);
+                const CubicSpline<float>& splineWidths = splineCache.splineWidths.setup(strandArrays.widths.data(), vertexCount);
 
-                        result.points.push_back(sph.xyz());
-                        result.radius.push_back(sph.w);
-                    }
-                    tmpCount++;
-                }
-            }
+                const uint32_t strandPointOffset = layout.outputPointOffsets[i];
+                const uint32_t strandPointCount = layout.outputPointOffsets[i + 1] - strandPointOffset;
+                for (uint32_t j = 0; j < strandPointCount - 1; j++) result.indices[strandPointOffset - i + j] = strandPointOffset + j;
 
-            // Always keep the last vertex.
-            float4 sph = transformSphere(xform, float4(splinePoints.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f), sanitizeWidth(splineWidths.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f) * 0.5f * widthScale)));
-            result.points.push_back(sph.xyz());
-            result.radius.push_back(sph.w);
+                // Pre-transform curve points.
+                uint32_t point = strandPointOffset;
+                forEachSample(splinePoints, vertexCount, subdivPerSegment, keepOneEveryXVerticesPerStrand, [&](const float3& p)
+                {
+                    result.points[point++] = p;
+                });
+                point = strandPointOffset;
+                forEachSample(splineWidths, vertexCount, subdivPerSegment, keepOneEveryXVerticesPerStrand, [&](float width)
+                {
+                    float4 sph = transformSphere(xform, float4(result.points[point], sanitizeWidth(width * 0.5f * widthScale)));
+                    result.points[point] = sph.xyz();
+                    result.radius[point++] = sph.w;
+                });
 
-            // Texture coordinates.
-            if (UVs)
-            {
-                const CubicSpline<float2>& splineUVs = splineCache.splineUVs.setup(strandArrays.UVs.data(), optimizedStrandArrays.vertexCount);
-                tmpCount = 0;
-                for (uint32_t j = 0; j < optimizedStrandArrays.vertexCount - 1; j++)
+                // Texture coordinates.
+                if (UVs)
                 {
-                    for (uint32_t k = 0; k < subdivPerSegment; k++)
+                    const CubicSpline<float2>& splineUVs = splineCache.splineUVs.setup(strandArrays.UVs.data(), vertexCount);
+                    point = strandPointOffset;
+                    forEachSample(splineUVs, vertexCount, subdivPerSegment, keepOneEveryXVerticesPerStrand, [&](const float2& uv)
                     {
-                        if (tmpCount % keepOneEveryXVerticesPerStrand == 0)
-                        {
-                            float t = (float)k / (float)subdivPerSegment;
-                            result.texCrds.push_back(splineUVs.interpolate(j, t));
-                        }
-                        tmpCount++;
-                    }
+                        result.texCrds[point++] = uv;
+                    });
                 }
-
-                // Always keep the last vertex.
-                result.texCrds.push_back(splineUVs.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f));
             }
-
-            for (uint32_t j = i; j < std::min(strandCount, i + keepOneEveryXStrands); j++) pointOffset += vertexCountsPerStrand[j];
-        }
+        });
 
         return result;
     }
@@ -344,73 +390,64 @@ namespace Falcor
     CurveTessellation::MeshResult CurveTessellation::convertToPolytube(uint32_t strandCount, const uint32_t* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, uint32_t subdivPerSegment, uint32_t keepOneEveryXStrands, uint32_t keepOneEveryXVerticesPerStrand, float widthScale, uint32_t pointCountPerCrossSection)
     {
         MeshResult result;
-        uint32_t vertexCounts = 0;
-        uint32_t faceCounts = 0;
-        uint32_t maxVertexCountsPerStrand = 0;
-        for (uint32_t i = 0; i < strandCount; i += keepOneEveryXStrands)
-        {
-            uint32_t tmpPointCount = div_round_up(subdivPerSegment * (vertexCountsPerStrand[i] - 1), keepOneEveryXVerticesPerStrand) + 1;
-            vertexCounts += pointCountPerCrossSection * tmpPointCount;
-            faceCounts += 2 * pointCountPerCrossSection * (tmpPointCount - 1);
-            maxVertexCountsPerStrand = std::max(maxVertexCountsPerStrand, vertexCountsPerStrand[i]);
-        }
-        result.vertices.reserve(vertexCounts);
-        result.normals.reserve(vertexCounts);
-        result.tangents.reserve(vertexCounts);
-        result.texCrds.reserve(vertexCounts);
-        result.radii.reserve(vertexCounts);
-        result.faceVertexCounts.reserve(faceCounts);
-        result.faceVertexIndices.reserve(faceCounts * 3);
-
-        uint32_t pointOffset = 0;
-        uint32_t meshVertexOffset = 0;
-
-        StrandArrays strandArrays;
-        strandArrays.controlPoints.reserve(maxVertexCountsPerStrand);
-        strandArrays.widths.reserve(maxVertexCountsPerStrand);
-        strandArrays.UVs.reserve(maxVertexCountsPerStrand);
-        CurveArrays curveArrays(controlPoints, widths, UVs);
 
-        StrandArrays optimizedStrandArrays;
-        CubicSplineCache splineCache;
-        for (uint32_t i = 0; i < strandCount; i += keepOneEveryXStrands)
+        // First pass: compute where each strand is written, so that the strands can be tessellated in parallel.
+        // A strand with N points has N cross-sections and 2 triangles per point in the cross-sections between them.
+        StrandLayout layout = computeStrandLayout(strandCount, vertexCountsPerStrand, controlPoints, subdivPerSegment, keepOneEveryXStrands, keepOneEveryXVerticesPerStrand);
+        const uint32_t pointCount = layout.outputPointOffsets[layout.strandCount];
+        const uint32_t vertexCount = pointCountPerCrossSection * pointCount;
+        const uint32_t faceCount = 2 * pointCountPerCrossSection * (pointCount - layout.strandCount);
+
+        result.vertices.resize(vertexCount);
+        result.normals.resize(vertexCount);
+        result.tangents.resize(vertexCount);
+        if (UVs) result.texCrds.resize(vertexCount);
+        result.radii.resize(vertexCount);
+        result.faceVertexCounts.resize(faceCount);
+        result.faceVertexIndices.resize(faceCount * 3);
+
+        // Second pass: tessellate the strands.
+        CurveArrays curveArrays(controlPoints, widths, UVs);
+        const std::vector<float2> crossSectionAngles = computeCrossSectionAngles(pointCountPerCrossSection);
+        forEachStrandTask(layout.strandCount, [&](uint32_t firstStrand, uint32_t endStrand)
         {
-            optimizedStrandArrays.controlPoints.clear();
-            optimizedStrandArrays.UVs.clear();
-            optimizedStrandArrays.widths.clear();
-            optimizedStrandArrays.vertexCount = 0;
-
-            strandArrays.vertexCount = vertexCountsPerStrand[i];
+            StrandArrays strandArrays;
+            StrandArrays optimizedStrandArrays;
+            CubicSplineCache splineCache;
+            for (uint32_t i = firstStrand; i < endStrand; i++)
+            {
+                strandArrays.vertexCount = vertexCountsPerStrand[i * keepOneEveryXStrands];
 
-            optimizeStrandGeometry(splineCache, curveArrays, strandArrays, optimizedStrandArrays, pointOffset, subdivPerSegment, keepOneEveryXVerticesPerStrand, widthScale);
+                optimizeStrandGeometry(splineCache, curveArrays, strandArrays, optimizedStrandArrays, layout.pointOffsets[i], subdivPerSegment, keepOneEveryXVerticesPerStrand, widthScale);
+                FALCOR_ASSERT(optimizedStrandArrays.controlPoints.size() == layout.outputPointOffsets[i + 1] - layout.outputPointOffsets[i]);
 
-            for (uint32_t j = i; j < std::min(strandCount, i + keepOneEveryXStrands); j++) pointOffset += vertexCountsPerStrand[j];
+                const uint32_t meshVertexOffset = pointCountPerCrossSection * layout.outputPointOffsets[i];
+                const uint32_t faceOffset = 2 * pointCountPerCrossSection * (layout.outputPointOffsets[i] - i);
 
-            // Build the initial frame.
-            float3 fwd, s, t;
-            fwd = normalize(optimizedStrandArrays.controlPoints[1] - optimizedStrandArrays.controlPoints[0]);
-            FALCOR_ASSERT_LT(std::abs(length(fwd) - 1.f), 1e-3f);
-            buildFrame(fwd, s, t);
+                // Build the initial frame.
+                float3 fwd, s, t;
+                fwd = normalize(optimizedStrandArrays.controlPoints[1] - optimizedStrandArrays.controlPoints[0]);
+                FALCOR_ASSERT_LT(std::abs(length(fwd) - 1.f), 1e-3f);
+                buildFrame(fwd, s, t);
 
-            // Create mesh.
-            for (uint32_t j = 0; j < optimizedStrandArrays.controlPoints.size(); j++)
-            {
-                // Update the curve's frame vectors: [fwd, s, t]
-                updateCurveFrame(optimizedStrandArrays, fwd, s, t, j);
+                // Create mesh.
+                for (uint32_t j = 0; j < optimizedStrandArrays.controlPoints.size(); j++)
+                {
+                    // Update the curve's frame vectors: [fwd, s, t]
+                    updateCurveFrame(optimizedStrandArrays, fwd, s, t, j);
 
-                // Mesh vertices, normals, tangents, and texCrds (if any).
-                updateMeshResultBuffers(result, curveArrays, optimizedStrandArrays, fwd, s, t, pointCountPerCrossSection, j);
+                    // Mesh vertices, normals, tangents, and texCrds (if any).
+                    updateMeshResultBuffers(result, curveArrays, optimizedStrandArrays, fwd, s, t, crossSectionAngles, meshVertexOffset, j);
 
-                // Mesh faces.
-                if (j < optimizedStrandArrays.controlPoints.size() - 1)
-                {
-                    uint32_t quadCountLimit = pointCountPerCrossSection;
-                    connectFaceVertices(result, meshVertexOffset, pointCountPerCrossSection, quadCountLimit, 1, 1, j);
+                    // Mesh faces.
+                    if (j < optimizedStrandArrays.controlPoints.size() - 1)
+                    {
+                        uint32_t quadCountLimit = pointCountPerCrossSection;
+                        connectFaceVertices(result, meshVertexOffset, faceOffset + 2 * quadCountLimit * j, pointCountPerCrossSection, quadCountLimit, 1, 1, j);
+                    }
                 }
             }
-
-            meshVertexOffset += pointCountPerCrossSection * (uint32_t)optimizedStrandArrays.controlPoints.size();
-        }
+        });
 
         return result;
     }
@@ -0,0 +1,74 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "InstanceBoundsTree.h"
+
+namespace Falcor
+{
+    void InstanceBoundsTree::buildInnerNodes()
+    {
+        if (mNodes.empty()) return;
+
+        // Reduce one level at a time, each level only depends on the level below.
+        for (size_t levelOffset = mLeafOffset / 2; levelOffset >= 1; levelOffset /= 2)
+        {
+            parallelForRange(0, levelOffset, [&](size_t first, size_t end)
+            {
+                for (size_t i = levelOffset + first; i < levelOffset + end; i++) mNodes[i] = mNodes[2 * i] | mNodes[2 * i + 1];
+            }, kNodesPerTask);
+        }
+    }
+
+    void InstanceBoundsTree::updateAncestors(const std::vector<uint32_t>& instanceIDs)
+    {
+        if (instanceIDs.empty()) return;
+
+        // Walk up the tree one level at a time. The node IDs stay sorted, so parents shared by siblings are adjacent.
+        mScratch.resize(instanceIDs.size());
+        for (size_t i = 0; i < instanceIDs.size(); i++) mScratch[i] = uint32_t(mLeafOffset + instanceIDs[i]);
+
+        while (mScratch.front() > 1)
+        {
+            size_t parentCount = 0;
+            for (size_t i = 0; i < mScratch.size(); i++)
+            {
+                uint32_t parent = mScratch[i] / 2;
+                if (parentCount == 0 || mScratch[parentCount - 1] != parent) mScratch[parentCount++] = parent;
+            }
+            mScratch.resize(parentCount);
+
+            parallelForRange(0, parentCount, [&](size_t first, size_t end)
+            {
+                for (size_t i = first; i < end; i++)
+                {
+                    uint32_t nodeID = mScratch[i];
+                    mNodes[nodeID] = mNodes[2 * nodeID] | mNodes[2 * nodeID + 1];
+                }
+            }, kNodesPerTask);
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Utils/Math/AABB.h"
+#include "Utils/TaskManager.h"
+#include <algorithm>
+#include <vector>
+
+namespace Falcor
+{
+    /** World-space bounding boxes of instances with a reduction tree over them, for incrementally updating their union.
+
+        The tree is a complete binary tree stored in an array: node 1 is the root, node i has children 2i and 2i+1,
+        and instance i is the leaf at node leafOffset + i, where leafOffset is the smallest power of two not less than the instance count.
+        Unused leaves hold empty boxes. Updating the bounds of k instances recomputes only their ancestors, i.e. O(k log n) unions,
+        one tree level at a time so that large updates are reduced in parallel.
+    */
+    class FALCOR_API InstanceBoundsTree
+    {
+    public:
+        /** Compute the bounds of all instances and build the tree.
+            \param[in] instanceCount Number of instances.
+            \param[in] getBounds Function returning the bounds of an instance, called in parallel.
+        */
+        template<typename F>
+        void build(size_t instanceCount, F getBounds)
+        {
+            mInstanceCount = instanceCount;
+            mLeafOffset = 1;
+            while (mLeafOffset < instanceCount) mLeafOffset *= 2;
+            mNodes.assign(instanceCount > 0 ? 2 * mLeafOffset : 0, AABB());
+
+            parallelForRange(0, instanceCount, [&](size_t first, size_t end)
+            {
+                for (size_t i = first; i < end; i++) mNodes[mLeafOffset + i] = getBounds(i);
+            }, kNodesPerTask);
+            buildInnerNodes();
+        }
+
+        /** Recompute the bounds of a set of instances and update the tree.
+            \param[in,out] instanceIDs IDs of the instances to update. Sorted and made unique by the call.
+            \param[in] getBounds Function returning the bounds of an instance, called in parallel.
+        */
+        template<typename F>
+        void update(std::vector<uint32_t>& instanceIDs, F getBounds)
+        {
+            std::sort(instanceIDs.begin(), instanceIDs.end());
+            instanceIDs.erase(std::unique(instanceIDs.begin(), instanceIDs.end()), instanceIDs.end());
+
+            parallelForRange(0, instanceIDs.size(), [&](size_t first, size_t end)
+            {
+                for (size_t i = first; i < end; i++)
+                {
+                    FALCOR_ASSERT(instanceIDs[i] < mInstanceCount);
+                    mNodes[mLeafOffset + instanceIDs[i]] = getBounds(instanceIDs[i]);
+                }
+            }, kNodesPerTask);
+            updateAncestors(instanceIDs);
+        }
+
+        size_t getInstanceCount() const { return mInstanceCount; }
+
+        /** Get the bounds of an instance.
+        */
+        const AABB& getInstanceBounds(uint32_t instanceID) const { return mNodes[mLeafOffset + instanceID]; }
+
+        /** Get the union of the bounds of all instances. Empty if there are no instances.
+        */
+        AABB getBounds() const { return mNodes.empty() ? AABB() : mNodes[1]; }
+
+        uint64_t getMemoryUsageInBytes() const { return mNodes.size() * sizeof(AABB) + mScratch.capacity() * sizeof(uint32_t); }
+
+    private:
+        static constexpr size_t kNodesPerTask = 4096;
+
+        void buildInnerNodes();
+        void updateAncestors(const std::vector<uint32_t>& instanceIDs);
+
+        size_t mInstanceCount = 0;
+        size_t mLeafOffset = 1;
+        std::vector<AABB> mNodes;           ///< Tree nodes. Node 0 is unused.
+        std::vector<uint32_t> mScratch;     ///< Node IDs of the current level during updates.
+    };
+}
@@ -28,6 +28,9 @@
 #include "EnvMap.h"
 #include "Core/API/Device.h"
 #include "Core/Program/ShaderVar.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+#include "Utils/Image/Bitmap.h"
 #include "Utils/Scripting/ScriptBindings.h"
 #include "GlobalState.h"
 
@@ -38,12 +41,38 @@ namespace Falcor
         return ref<EnvMap>(new EnvMap(pDevice, pTexture));
     }
 
-    ref<EnvMap> EnvMap::createFromFile(ref<Device> pDevice, const std::filesystem::path& path)
+    ref<EnvMap> EnvMap::createFromFile(ref<Device> pDevice, const std::filesystem::path& path, bool buildImportanceMap)
     {
-        // Load environment map from file. Set it to generate mips and use linear color.
-        auto pTexture = Texture::createFromFile(pDevice, path, true, false);
+        // DDS files are loaded directly as textures. The importance map is built on the GPU by EnvMapSampler.
+        if (!buildImportanceMap || hasExtension(path, "dds") || !std::filesystem::exists(path))
+        {
+            // Load environment map from file. Set it to generate mips and use linear color.
+            auto pTexture = Texture::createFromFile(pDevice, path, true, false);
+            if (!pTexture) return nullptr;
+            return create(pDevice, pTexture);
+        }
+
+        // Decode the image once, and use it both for the texture and for building the importance map.
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(path, true);
+        if (!pBitmap) return nullptr;
+
+        auto pTexture = Texture::createFromBitmap(pDevice, *pBitmap, true, false);
         if (!pTexture) return nullptr;
-        return create(pDevice, pTexture);
+        pTexture->setSourcePath(path);
+
+        ref<EnvMap> pEnvMap = create(pDevice, pTexture);
+        if (EnvMapImportanceMap::isFormatSupported(pBitmap->getFormat()))
+        {
+            try
+            {
+                pEnvMap->mpImportanceMap = std::make_shared<const EnvMapImportanceMap>(EnvMapImportanceMap::build(*pBitmap));
+            }
+            catch (const std::exception& e)
+            {
+                logWarning("Failed to build importance map for environment map '{}': {}", path, e.what());
+            }
+        }
+        return pEnvMap;
     }
 
     void EnvMap::renderUI(Gui::Widgets& widgets)
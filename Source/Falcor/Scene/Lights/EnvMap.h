@@ -27,6 +27,7 @@
  **************************************************************************/
 #pragma once
 #include "EnvMapData.slang"
+#include "EnvMapImportanceMap.h"
 #include "Core/Macros.h"
 #include "Core/Object.h"
 #include "Core/API/Texture.h"
@@ -56,11 +57,14 @@ namespace Falcor
         static ref<EnvMap> create(ref<Device> pDevice, const ref<Texture>& texture);
 
         /** Create a new environment map from file.
+            The importance map used for sampling is built on the CPU from the decoded image, unless the file is a DDS file
+            or buildImportanceMap is false. In that case EnvMapSampler builds it on the GPU.
             \param[in] pDevice GPU device.
             \param[in] path The environment map texture file path (absolute or relative to working directory).
+            \param[in] buildImportanceMap Build the importance map on the CPU.
             \return A new object, or nullptr if the environment map failed to load.
         */
-        static ref<EnvMap> createFromFile(ref<Device> pDevice, const std::filesystem::path& path);
+        static ref<EnvMap> createFromFile(ref<Device> pDevice, const std::filesystem::path& path, bool buildImportanceMap = true);
 
         /** Render the GUI.
         */
@@ -102,6 +106,10 @@ namespace Falcor
         const ref<Texture>& getEnvMap() const { return mpEnvMap; }
         const ref<Sampler>& getEnvSampler() const { return mpEnvSampler; }
 
+        /** Get the importance map built on the CPU, or nullptr if it was not built.
+        */
+        const std::shared_ptr<const EnvMapImportanceMap>& getImportanceMap() const { return mpImportanceMap; }
+
         /** Bind the environment map to a given shader variable.
             \param[in] var Shader variable.
         */
@@ -132,6 +140,7 @@ namespace Falcor
         ref<Device>             mpDevice;
         ref<Texture>            mpEnvMap;           ///< Loaded environment map (RGB).
         ref<Sampler>            mpEnvSampler;       ///< Texture sampler for the environment map.
+        std::shared_ptr<const EnvMapImportanceMap> mpImportanceMap; ///< Importance map built on the CPU (optional).
 
         EnvMapData              mData;
         EnvMapData              mPrevData;
@@ -0,0 +1,336 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "EnvMapImportanceMap.h"
+#include "Core/Error.h"
+#include "Utils/Image/Bitmap.h"
+#include "Utils/Image/PixelConversion.h"
+#include "Utils/Math/Common.h"
+#include "Utils/Math/MathConstants.slangh"
+#include "Utils/Math/PackedFormats.h"
+#include "Utils/TaskManager.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Falcor
+{
+namespace
+{
+/// Number of environment map rows converted to luminance per parallel task.
+const uint32_t kRowsPerTask = 16;
+
+/// Converts a direction to the latitude-longitude map. Matches world_to_latlong_map() in MathHelpers.slang.
+float2 world_to_latlong_map(float3 dir)
+{
+    float3 p = normalize(dir);
+    float2 uv;
+    uv.x = std::atan2(p.x, -p.z) * float(M_1_2PI) + 0.5f;
+    uv.y = std::acos(std::clamp(p.y, -1.f, 1.f)) * float(M_1_PI);
+    return uv;
+}
+
+/// Converts a row of texels of a supported format to RGBA float. Missing channels are zero.
+void convertRow(ResourceFormat format, const uint8_t* pSrc, float* pDst, uint32_t width)
+{
+    switch (format)
+    {
+    case ResourceFormat::RGBA32Float:
+        std::memcpy(pDst, pSrc, size_t(width) * 4 * sizeof(float));
+        break;
+    case ResourceFormat::RGB32Float:
+        PixelConversion::expandRGBToRGBA(reinterpret_cast<const float*>(pSrc), pDst, width);
+        break;
+    case ResourceFormat::RGBA16Float:
+        PixelConversion::float16ToRGBA32Float(reinterpret_cast<const uint16_t*>(pSrc), 4, pDst, width);
+        break;
+    case ResourceFormat::RGBA16Unorm:
+        PixelConversion::normalizedToRGBA32Float(reinterpret_cast<const uint16_t*>(pSrc), 4, pDst, width);
+        break;
+    case ResourceFormat::R16Unorm:
+        PixelConversion::normalizedToRGBA32Float(reinterpret_cast<const uint16_t*>(pSrc), 1, pDst, width);
+        break;
+    case ResourceFormat::RGBA8Unorm:
+    case ResourceFormat::BGRA8Unorm:
+    case ResourceFormat::BGRX8Unorm:
+        PixelConversion::normalizedToRGBA32Float(pSrc, 4, pDst, width);
+        break;
+    case ResourceFormat::RG8Unorm:
+        PixelConversion::normalizedToRGBA32Float(pSrc, 2, pDst, width);
+        break;
+    case ResourceFormat::R8Unorm:
+        PixelConversion::normalizedToRGBA32Float(pSrc, 1, pDst, width);
+        break;
+    default:
+        FALCOR_UNREACHABLE();
+    }
+}
+
+/// Converts the environment map to luminance with one value per texel.
+std::vector<float> computeLuminance(const Bitmap& envMap)
+{
+    const uint32_t width = envMap.getWidth();
+    const uint32_t height = envMap.getHeight();
+    const ResourceFormat format = envMap.getFormat();
+
+    // Use swizzled luminance weights for BGR formats instead of reordering the channels.
+    const bool isBGR = format == ResourceFormat::BGRA8Unorm || format == ResourceFormat::BGRX8Unorm;
+    const float3 weights = isBGR ? float3(0.0722f, 0.7152f, 0.2126f) : float3(0.2126f, 0.7152f, 0.0722f);
+
+    std::vector<float> luminance(size_t(width) * height);
+    parallelFor(
+        0,
+        div_round_up(height, kRowsPerTask),
+        [&](uint32_t task)
+        {
+            std::vector<float> rgba(size_t(width) * 4);
+            const uint32_t endRow = std::min(height, (task + 1) * kRowsPerTask);
+            for (uint32_t y = task * kRowsPerTask; y < endRow; ++y)
+            {
+                convertRow(format, envMap.getData() + size_t(y) * envMap.getRowPitch(), rgba.data(), width);
+                const float* pSrc = rgba.data();
+                float* pDst = luminance.data() + size_t(y) * width;
+                for (uint32_t x = 0; x < width; ++x)
+                    pDst[x] = weights.x * pSrc[4 * x] + weights.y * pSrc[4 * x + 1] + weights.z * pSrc[4 * x + 2];
+            }
+        }
+    );
+    return luminance;
+}
+
+/// Samples the luminance with bilinear filtering, wrapping horizontally and clamping vertically.
+float sampleBilinear(const std::vector<float>& luminance, uint32_t width, uint32_t height, float2 uv)
+{
+    const float x = uv.x * width - 0.5f;
+    const float y = uv.y * height - 0.5f;
+    const float fx = std::floor(x);
+    const float fy = std::floor(y);
+    const float tx = x - fx;
+    const float ty = y - fy;
+
+    auto wrap = [width](int64_t i) { return uint32_t(((i % width) + width) % width); };
+    auto clampRow = [height](int64_t i) { return uint32_t(std::clamp<int64_t>(i, 0, height - 1)); };
+    const uint32_t x0 = wrap(int64_t(fx));
+    const uint32_t x1 = wrap(int64_t(fx) + 1);
+    const float* pRow0 = luminance.data() + size_t(clampRow(int64_t(fy))) * width;
+    const float* pRow1 = luminance.data() + size_t(clampRow(int64_t(fy) + 1)) * width;
+
+    const float l0 = pRow0[x0] + (pRow0[x1] - pRow0[x0]) * tx;
+    const float l1 = pRow1[x0] + (pRow1[x1] - pRow1[x0]) * tx;
+    return l0 + (l1 - l0) * ty;
+}
+} // namespace
+
+EnvMapImportanceMap::EnvMapImportanceMap(uint32_t dimension, uint32_t samples, std::vector<float> data)
+    : mDimension(dimension), mSamples(samples), mData(std::move(data))
+{
+    FALCOR_CHECK(
+        isPowerOf2(dimension) && dimension >= 2 && dimension <= kMaxDimension,
+        "Importance map dimension must be a power of two in [2, {}]",
+        kMaxDimension
+    );
+
+    // We have log2(N)+1 mips from NxN...1x1 texels resolution.
+    mMipCount = uint32_t(std::log2(dimension)) + 1;
+    size_t size = 0;
+    for (uint32_t mip = 0; mip < mMipCount; ++mip)
+    {
+        mMipOffsets.push_back(size);
+        size += size_t(dimension >> mip) * (dimension >> mip);
+    }
+    FALCOR_CHECK(mData.size() == size, "Importance map data has {} values, expected {}", mData.size(), size);
+}
+
+EnvMapImportanceMap EnvMapImportanceMap::build(const Bitmap& envMap, uint32_t dimension, uint32_t samples)
+{
+    FALCOR_CHECK(isFormatSupported(envMap.getFormat()), "Environment map format {} is not supported", to_string(envMap.getFormat()));
+    FALCOR_CHECK(
+        isPowerOf2(dimension) && dimension >= 2 && dimension <= kMaxDimension,
+        "Importance map dimension must be a power of two in [2, {}]",
+        kMaxDimension
+    );
+    FALCOR_CHECK(isPowerOf2(samples), "Importance map sample count must be a power of two");
+
+    const uint32_t width = envMap.getWidth();
+    const uint32_t height = envMap.getHeight();
+    const std::vector<float> luminance = computeLuminance(envMap);
+
+    const uint32_t samplesX = std::max(1u, (uint32_t)std::sqrt(samples));
+    const uint32_t samplesY = samples / samplesX;
+    FALCOR_ASSERT(samples == samplesX * samplesY);
+    const float2 dimInSamples = float2(float(dimension * samplesX), float(dimension * samplesY));
+    const float invSamples = 1.f / (samplesX * samplesY);
+
+    const uint32_t mipCount = uint32_t(std::log2(dimension)) + 1;
+    size_t size = 0;
+    for (uint32_t mip = 0; mip < mipCount; ++mip)
+        size += size_t(dimension >> mip) * (dimension >> mip);
+    std::vector<float> data(size);
+
+    // Compute the base level. Each texel holds the average luminance at stratified points in the octahedral map.
+    parallelFor(
+        0,
+        dimension,
+        [&](uint32_t y)
+        {
+            for (uint32_t x = 0; x < dimension; ++x)
+            {
+                float L = 0.f;
+                for (uint32_t sy = 0; sy < samplesY; ++sy)
+                {
+                    for (uint32_t sx = 0; sx < samplesX; ++sx)
+                    {
+                        float2 p = (float2(float(x * samplesX + sx), float(y * samplesY + sy)) + 0.5f) / dimInSamples;
+                        float2 uv = world_to_latlong_map(oct_to_ndir_equal_area_unorm(p));
+                        L += sampleBilinear(luminance, width, height, uv);
+                    }
+                }
+                data[size_t(y) * dimension + x] = L * invSamples;
+            }
+        }
+    );
+
+    // Compute the coarser levels as averages of 2x2 texels.
+    size_t srcOffset = 0;
+    for (uint32_t mip = 1; mip < mipCount; ++mip)
+    {
+        const uint32_t srcDim = dimension >> (mip - 1);
+        const uint32_t dstDim = srcDim / 2;
+        const float* pSrc = data.data() + srcOffset;
+        float* pDst = data.data() + srcOffset + size_t(srcDim) * srcDim;
+        for (uint32_t y = 0; y < dstDim; ++y)
+        {
+            const float* pRow0 = pSrc + size_t(2 * y) * srcDim;
+            const float* pRow1 = pRow0 + srcDim;
+            for (uint32_t x = 0; x < dstDim; ++x)
+                pDst[size_t(y) * dstDim + x] = (pRow0[2 * x] + pRow0[2 * x + 1] + pRow1[2 * x] + pRow1[2 * x + 1]) * 0.25f;
+        }
+        srcOffset += size_t(srcDim) * srcDim;
+    }
+
+    return EnvMapImportanceMap(dimension, samples, std::move(data));
+}
+
+bool EnvMapImportanceMap::isFormatSupported(ResourceFormat format)
+{
+    switch (format)
+    {
+    case ResourceFormat::RGBA32Float:
+    case ResourceFormat::RGB32Float:
+    case ResourceFormat::RGBA16Float:
+    case ResourceFormat::RGBA16Unorm:
+    case ResourceFormat::R16Unorm:
+    case ResourceFormat::RGBA8Unorm:
+    case ResourceFormat::BGRA8Unorm:
+    case ResourceFormat::BGRX8Unorm:
+    case ResourceFormat::RG8Unorm:
+    case ResourceFormat::R8Unorm:
+        return true;
+    default:
+        return false;
+    }
+}
+
+const float* EnvMapImportanceMap::getMip(uint32_t mip) const
+{
+    FALCOR_CHECK(mip < mMipCount, "Mip level {} is out of range", mip);
+    return mData.data() + mMipOffsets[mip];
+}
+
+EnvMapImportanceMap::Sample EnvMapImportanceMap::sample(float2 rnd) const
+{
+    float2 p = rnd; // Random sample in [0,1)^2.
+    uint2 pos(0);   // Top-left texel pos of current 2x2 region.
+
+    // Iterate over mips of 2x2...NxN resolution.
+    for (int mip = int(mMipCount) - 2; mip >= 0; mip--)
+    {
+        // Scale position to current mip.
+        pos *= 2u;
+
+        // Load the four texels at the current position.
+        const uint32_t dim = mDimension >> mip;
+        const float* pMip = getMip(mip);
+        const float* pRow0 = pMip + size_t(pos.y) * dim + pos.x;
+        const float* pRow1 = pRow0 + dim;
+        const float w[4] = {pRow0[0], pRow0[1], pRow1[0], pRow1[1]};
+
+        const float q[2] = {w[0] + w[2], w[1] + w[3]};
+
+        uint2 off;
+
+        // Horizontal warp.
+        float d = q[0] / (q[0] + q[1]);
+
+        if (p.x < d) // left
+        {
+            off.x = 0;
+            p.x = p.x / d;
+        }
+        else // right
+        {
+            off.x = 1;
+            p.x = (p.x - d) / (1.f - d);
+        }
+
+        // Vertical warp.
+        float e = w[off.x] / q[off.x];
+
+        if (p.y < e) // bottom
+        {
+            off.y = 0;
+            p.y = p.y / e;
+        }
+        else // top
+        {
+            off.y = 1;
+            p.y = (p.y - e) / (1.f - e);
+        }
+
+        pos += off;
+    }
+
+    // Compute final sample position and map to direction.
+    float2 uv = (float2(pos) + p) * (1.f / mDimension);
+
+    // We sample exactly according to the intensity of where the final samples lies in the octahedral map,
+    // normalized to its average intensity.
+    Sample result;
+    result.dir = oct_to_ndir_equal_area_unorm(uv);
+    result.pdf = getMip(0)[size_t(pos.y) * mDimension + pos.x] / getAverage() * float(M_1_4PI);
+    return result;
+}
+
+float EnvMapImportanceMap::evalPdf(float3 dir) const
+{
+    // Point sampling with clamp to edge.
+    float2 uv = ndir_to_oct_equal_area_unorm(dir);
+    uint32_t x = std::min(uint32_t(std::max(uv.x * mDimension, 0.f)), mDimension - 1);
+    uint32_t y = std::min(uint32_t(std::max(uv.y * mDimension, 0.f)), mDimension - 1);
+    return getMip(0)[size_t(y) * mDimension + x] / getAverage() * float(M_1_4PI);
+}
+} // namespace Falcor
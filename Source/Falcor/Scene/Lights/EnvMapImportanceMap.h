@@ -0,0 +1,122 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Core/API/Formats.h"
+#include "Utils/Math/Vector.h"
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+class Bitmap;
+
+/**
+ * Hierarchical importance map for sampling an environment map, built on the CPU.
+ *
+ * The layout is identical to the importance map built by EnvMapSamplerSetup.cs.slang: a square mip chain over the
+ * equal-area octahedral map of the sphere. Each texel of the base level holds the average luminance of the environment
+ * map at samples stratified points, and each coarser level holds the average of 2x2 texels of the finer level.
+ * The data can be uploaded as the importance map of EnvMapSampler as is.
+ *
+ * sample() and evalPdf() mirror EnvMapSampler.slang. Directions are in the local frame of the environment map,
+ * i.e., before applying the environment map transform.
+ */
+class FALCOR_API EnvMapImportanceMap
+{
+public:
+    /// Default resolution of the base level.
+    static constexpr uint32_t kDefaultDimension = 512;
+    /// Default number of samples per texel of the base level.
+    static constexpr uint32_t kDefaultSamples = 64;
+    /// Maximum resolution of the base level (limited by EnvMapSampler.slang).
+    static constexpr uint32_t kMaxDimension = 2048;
+
+    struct Sample
+    {
+        float3 dir; ///< Sampled direction in the local frame of the environment map.
+        float pdf;  ///< Probability density function with respect to solid angle.
+    };
+
+    /**
+     * Create an importance map from existing data.
+     * @param[in] dimension Resolution of the base level. Must be a power of two.
+     * @param[in] samples Number of samples per texel that were used to build the base level.
+     * @param[in] data Values of all mip levels in row-major order, starting with the base level.
+     */
+    EnvMapImportanceMap(uint32_t dimension, uint32_t samples, std::vector<float> data);
+
+    /**
+     * Build an importance map from a latitude-longitude environment map.
+     * The environment map is sampled with bilinear filtering that wraps horizontally and clamps vertically, matching
+     * the sampler of EnvMap. The luminance of the environment map is converted once and the base level is built in
+     * parallel over rows.
+     * @param[in] envMap Environment map with top-down row order. The format must be supported, see isFormatSupported().
+     * @param[in] dimension Resolution of the base level. Must be a power of two in [2, kMaxDimension].
+     * @param[in] samples Number of samples per texel. Must be a power of two.
+     */
+    static EnvMapImportanceMap build(const Bitmap& envMap, uint32_t dimension = kDefaultDimension, uint32_t samples = kDefaultSamples);
+
+    /// Returns true if build() supports environment maps in the given format.
+    static bool isFormatSupported(ResourceFormat format);
+
+    uint32_t getDimension() const { return mDimension; }
+    uint32_t getSampleCount() const { return mSamples; }
+    uint32_t getMipCount() const { return mMipCount; }
+
+    /// Returns the values of all mip levels in row-major order, starting with the base level.
+    const std::vector<float>& getData() const { return mData; }
+
+    /// Returns the values of a mip level in row-major order. The resolution of the level is getDimension() >> mip.
+    const float* getMip(uint32_t mip) const;
+
+    /// Returns the average importance over the map (the value of the coarsest mip level).
+    float getAverage() const { return mData.back(); }
+
+    /**
+     * Importance sample a direction. Mirrors EnvMapSampler::sample().
+     * @param[in] rnd Uniform random numbers in [0,1)^2.
+     * @return Sampled direction and its pdf.
+     */
+    Sample sample(float2 rnd) const;
+
+    /**
+     * Evaluate the probability density function for a direction. Mirrors EnvMapSampler::evalPdf().
+     * @param[in] dir Normalized direction in the local frame of the environment map.
+     * @return Probability density function with respect to solid angle.
+     */
+    float evalPdf(float3 dir) const;
+
+private:
+    uint32_t mDimension;
+    uint32_t mSamples;
+    uint32_t mMipCount;
+    std::vector<float> mData;
+    std::vector<size_t> mMipOffsets;
+};
+} // namespace Falcor
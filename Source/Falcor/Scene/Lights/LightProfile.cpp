@@ -29,9 +29,17 @@
 #include "Core/Platform/OS.h"
 #include "Core/API/RenderContext.h"
 #include "Utils/Logger.h"
+#include "Utils/CryptoUtils.h"
+#include "Utils/TaskManager.h"
+#include "Utils/SharedCache.h"
 #include "Utils/Algorithm/ParallelReduction.h"
+#include "Utils/Image/PixelConversion.h"
+#include "Utils/Math/MathConstants.slangh"
 #include "Core/Pass/ComputePass.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 
@@ -53,6 +61,21 @@ namespace Falcor
             "ERCO Leuchten GmbH"
         };
 
+        // Layout of the canonical table. The header holds the values of the lines following the TILT line.
+        const size_t kHeaderSize = 13;
+        const size_t kVerticalAngleCountIndex = 3;
+        const size_t kHorizontalAngleCountIndex = 4;
+        const size_t kPhotometricTypeIndex = 5;
+
+        // Photometric types.
+        const int kPhotometricTypeC = 1;
+        const int kPhotometricTypeB = 2;
+        const int kPhotometricTypeA = 3;
+
+        // Resolution of the type C table that type A and B profiles are resampled to (1 degree steps).
+        const uint32_t kResampledVerticalAngles = 181;
+        const uint32_t kResampledHorizontalAngles = 361;
+
         // See https://docs.agi32.com/PhotometricToolbox/Content/Open_Tool/iesna_lm-63_format.htm for the format reference. Pasted below.
 
         /*
@@ -87,100 +110,181 @@ namespace Falcor
         <candela values for all vertical angles at last horizontal angle>
         */
 
-        enum class IesStatus
+        /** Splits the text into lines, skipping empty lines.
+        */
+        class LineReader
         {
-            Success,
-            UnsupportedProfile,
-            UnsupportedTilt,
-            WrongDataSize,
-            InvalidData
-        };
+        public:
+            LineReader(std::string_view text) : mText(text) {}
 
-        IesStatus parseIesFile(char* fileData, std::vector<float>& numericData, float& maxCandelas)
-        {
-            // count whitespace to get a rough estimate of the number of floats stored
-            int numWhitespace = 0;
-            for (char* p = fileData; *p; p++)
+            bool next(std::string_view& line)
             {
-                if (*p == ' ')
-                    ++numWhitespace;
+                while (mPos < mText.size())
+                {
+                    size_t end = mText.find_first_of("\r\n", mPos);
+                    if (end == std::string_view::npos) end = mText.size();
+                    line = mText.substr(mPos, end - mPos);
+                    mPos = end + 1;
+                    if (!line.empty()) return true;
+                }
+                return false;
             }
 
-            // parse the header line by line
-            const char* lineDelimiters = "\r\n";
-            const char* dataDelimiters = "\r\n\t ";
-            char* line = strtok(fileData, lineDelimiters);
-            int lineNumber = 1;
+            std::string_view remaining() const { return mPos < mText.size() ? mText.substr(mPos) : std::string_view(); }
 
-            while (line)
-            {
-                if (lineNumber == 1)
-                {
-                    bool profileFound = false;
-                    for (const char* profile : kSupportedProfiles)
-                    {
-                        if (strstr(line, profile))
-                        {
-                            profileFound = true;
-                            break;
-                        }
-                    }
+        private:
+            std::string_view mText;
+            size_t mPos = 0;
+        };
 
-                    if (!profileFound)
-                    {
-                        return IesStatus::UnsupportedProfile;
-                    }
-                }
-                else
-                {
-                    if (strstr(line, "TILT=NONE") == line)
-                    {
-                        break;
-                    }
-                    else if (strstr(line, "TILT=") == line)
-                    {
-                        return IesStatus::UnsupportedTilt;
-                    }
-                }
+        /** Reads whitespace or comma separated numbers using std::from_chars.
+        */
+        class NumberReader
+        {
+        public:
+            NumberReader(std::string_view text) : mPtr(text.data()), mEnd(text.data() + text.size()) {}
 
-                line = strtok(NULL, lineDelimiters);
-                ++lineNumber;
+            float next()
+            {
+                skipSeparators();
+                if (mPtr < mEnd && *mPtr == '+') mPtr++;
+                float value = 0.f;
+                auto [ptr, ec] = std::from_chars(mPtr, mEnd, value);
+                if (ec != std::errc()) FALCOR_THROW("Invalid or missing numeric data.");
+                mPtr = ptr;
+                return value;
             }
 
-            numericData.reserve(numWhitespace);
-            line = strtok(NULL, dataDelimiters);
-            while (line)
+            bool atEnd()
             {
-                float value = 0.f;
-                if (sscanf(line, "%f", &value) == 1)
-                    numericData.push_back(value);
-                line = strtok(NULL, dataDelimiters);
+                skipSeparators();
+                return mPtr == mEnd;
             }
 
-            if (numericData.size() < 16)
+        private:
+            void skipSeparators()
             {
-                return IesStatus::WrongDataSize;
+                while (mPtr < mEnd && (*mPtr == ' ' || *mPtr == '\t' || *mPtr == '\r' || *mPtr == '\n' || *mPtr == ',' || *mPtr == '\0')) mPtr++;
             }
 
-            int numLamps = int(numericData[0]);
-            int numVerticalAngles = int(numericData[3]);
-            int numHorizontalAngles = int(numericData[4]);
-            int headerSize = 13;
+            const char* mPtr;
+            const char* mEnd;
+        };
 
-            int expectedDataSize = headerSize + numHorizontalAngles + numVerticalAngles + numHorizontalAngles * numVerticalAngles;
-            if (numericData.size() != expectedDataSize)
+        /** Find the fractional index of an angle in a sorted list of angles. Matches findAngleIndex() in BakeIesProfile.cs.slang.
+        */
+        float findAngleIndex(float angle, const float* angles, int count)
+        {
+            if (count == 1) return 0;
+
+            float left;
+            float right = angles[0];
+
+            if (angle <= right) return 0;
+
+            for (int i = 1; i < count; i++)
             {
-                return IesStatus::WrongDataSize;
+                left = right;
+                right = angles[i];
+
+                if (angle >= left && angle <= right)
+                {
+                    return float(i - 1) + ((right > left) ? (angle - left) / (right - left) : 0.f);
+                }
             }
 
-            maxCandelas = 0.f;
-            for (int index = headerSize + numHorizontalAngles + numVerticalAngles; index < expectedDataSize; index++)
-                maxCandelas = std::max(maxCandelas, numericData[index]);
+            return float(count - 1);
+        }
 
-            return IesStatus::Success;
+        /** Bilinearly interpolate the candela values at fractional angle indices.
+        */
+        float interpolateCandelas(const float* candelas, int numVerticalAngles, float verticalAngleIndex, float horizontalAngleIndex)
+        {
+            auto frac = [](float x) { return x - std::floor(x); };
+            int v0 = int(std::floor(verticalAngleIndex));
+            int v1 = int(std::ceil(verticalAngleIndex));
+            int h0 = int(std::floor(horizontalAngleIndex));
+            int h1 = int(std::ceil(horizontalAngleIndex));
+
+            float a = candelas[h0 * numVerticalAngles + v0];
+            float b = candelas[h0 * numVerticalAngles + v1];
+            float c = candelas[h1 * numVerticalAngles + v0];
+            float d = candelas[h1 * numVerticalAngles + v1];
+
+            float fv = frac(verticalAngleIndex);
+            float ab = a + (b - a) * fv;
+            float cd = c + (d - c) * fv;
+            return ab + (cd - ab) * frac(horizontalAngleIndex);
+        }
+
+        /** Resample a profile with type A or B photometry to type C photometry.
+            Type C uses a vertical polar axis: vertical angles are measured from nadir, horizontal angles around the polar axis.
+            Types A and B measure angles from the aiming direction, which is mapped to nadir. Type A uses a polar axis that is
+            perpendicular to the aiming direction (vertical for a horizontally aimed luminaire), type B uses the lateral axis
+            of the luminaire. In both cases, vertical angles are latitudes and horizontal angles longitudes around the polar axis.
+        */
+        std::vector<float> resampleToTypeC(const std::vector<float>& data, int photometricType)
+        {
+            const int numVerticalAngles = int(data[kVerticalAngleCountIndex]);
+            const int numHorizontalAngles = int(data[kHorizontalAngleCountIndex]);
+            const float* verticalAngles = data.data() + kHeaderSize;
+            const float* horizontalAngles = verticalAngles + numVerticalAngles;
+            const float* candelas = horizontalAngles + numHorizontalAngles;
+
+            // Profiles with horizontal angles starting at 0 are symmetric about the aiming plane.
+            const bool symmetric = horizontalAngles[0] >= 0.f;
+
+            std::vector<float> result(kHeaderSize + kResampledVerticalAngles + kResampledHorizontalAngles + kResampledVerticalAngles * kResampledHorizontalAngles);
+            std::copy(data.begin(), data.begin() + kHeaderSize, result.begin());
+            result[kVerticalAngleCountIndex] = float(kResampledVerticalAngles);
+            result[kHorizontalAngleCountIndex] = float(kResampledHorizontalAngles);
+            result[kPhotometricTypeIndex] = float(kPhotometricTypeC);
+
+            float* resultVerticalAngles = result.data() + kHeaderSize;
+            float* resultHorizontalAngles = resultVerticalAngles + kResampledVerticalAngles;
+            float* resultCandelas = resultHorizontalAngles + kResampledHorizontalAngles;
+            for (uint32_t i = 0; i < kResampledVerticalAngles; i++) resultVerticalAngles[i] = float(i);
+            for (uint32_t i = 0; i < kResampledHorizontalAngles; i++) resultHorizontalAngles[i] = float(i);
+
+            const float kDegToRad = float(M_PI) / 180.f;
+            const float kRadToDeg = 180.f / float(M_PI);
+            for (uint32_t h = 0; h < kResampledHorizontalAngles; h++)
+            {
+                for (uint32_t v = 0; v < kResampledVerticalAngles; v++)
+                {
+                    // Direction in a frame where nadir is -z.
+                    float theta = resultVerticalAngles[v] * kDegToRad;
+                    float phi = resultHorizontalAngles[h] * kDegToRad;
+                    float3 dir(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), -std::cos(theta));
+
+                    // Type A uses y as polar axis, type B uses x.
+                    float polar = photometricType == kPhotometricTypeA ? dir.y : dir.x;
+                    float lateral = photometricType == kPhotometricTypeA ? dir.x : dir.y;
+                    float verticalAngle = std::asin(std::clamp(polar, -1.f, 1.f)) * kRadToDeg;
+                    float horizontalAngle = std::atan2(lateral, -dir.z) * kRadToDeg;
+                    if (symmetric) horizontalAngle = std::abs(horizontalAngle);
+
+                    float value = 0.f;
+                    if (verticalAngle >= verticalAngles[0] && verticalAngle <= verticalAngles[numVerticalAngles - 1] &&
+                        horizontalAngle >= horizontalAngles[0] && horizontalAngle <= horizontalAngles[numHorizontalAngles - 1])
+                    {
+                        float verticalAngleIndex = findAngleIndex(verticalAngle, verticalAngles, numVerticalAngles);
+                        float horizontalAngleIndex = findAngleIndex(horizontalAngle, horizontalAngles, numHorizontalAngles);
+                        value = interpolateCandelas(candelas, numVerticalAngles, verticalAngleIndex, horizontalAngleIndex);
+                    }
+                    resultCandelas[h * kResampledVerticalAngles + v] = value;
+                }
+            }
+
+            return result;
         }
     }
 
+    struct LightProfile::SharedData
+    {
+        BakedProfile baked;
+        ref<Texture> pTexture;
+    };
 
     LightProfile::LightProfile(ref<Device> pDevice, const std::string& name, const std::vector<float>& rawData)
         : mpDevice(pDevice)
@@ -190,7 +294,7 @@ namespace Falcor
 
     ref<LightProfile> LightProfile::createFromIesProfile(ref<Device> pDevice, const std::filesystem::path& path, bool normalize)
     {
-        std::ifstream ifs(path);
+        std::ifstream ifs(path, std::ios::binary);
         if (!ifs.good())
         {
             logWarning("Error when loading light profile. Can't open file '{}'", path);
@@ -199,32 +303,191 @@ namespace Falcor
 
         std::string str;
         ifs.seekg(0, std::ios::end);
-        str.reserve(ifs.tellg());
+        str.resize(ifs.tellg());
         ifs.seekg(0, std::ios::beg);
-        str.assign((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        ifs.read(str.data(), str.size());
 
         std::vector<float> numericData;
-        float maxCandelas;
-        IesStatus status = parseIesFile(str.data(), numericData, maxCandelas);
-        switch (status)
+        try
+        {
+            numericData = parseIesProfile(str, normalize);
+        }
+        catch (const std::exception& e)
         {
-        case IesStatus::UnsupportedProfile:
-        case IesStatus::UnsupportedTilt:
-        case IesStatus::WrongDataSize:
-        case IesStatus::InvalidData:
-            logWarning("Error while loading IES profile from '{}'.", path);
+            logWarning("Error while loading IES profile from '{}': {}", path, e.what());
             return nullptr;
         }
 
-        // Stash the normalization factor in data[0], we don't use that anyway
-        numericData[0] = normalize ? (1.f / maxCandelas) : 1.f;
-
         std::string name = path.filename().string();
 
         return ref<LightProfile>(new LightProfile(pDevice, name, numericData));
     }
 
+    std::vector<float> LightProfile::parseIesProfile(std::string_view text, bool normalize)
+    {
+        // Parse the header line by line.
+        LineReader lines(text);
+        std::string_view line;
+        if (!lines.next(line)) FALCOR_THROW("Empty file.");
+
+        bool profileFound = false;
+        for (const char* profile : kSupportedProfiles)
+        {
+            if (line.find(profile) != std::string_view::npos)
+            {
+                profileFound = true;
+                break;
+            }
+        }
+        if (!profileFound) FALCOR_THROW("Unsupported profile '{}'.", line);
+
+        bool tiltInclude = false;
+        while (true)
+        {
+            if (!lines.next(line)) FALCOR_THROW("Missing TILT line.");
+            if (line.rfind("TILT=", 0) == 0)
+            {
+                std::string_view tilt = line.substr(5);
+                while (!tilt.empty() && std::isspace((unsigned char)tilt.back())) tilt.remove_suffix(1);
+                if (tilt == "INCLUDE") tiltInclude = true;
+                else if (tilt != "NONE") FALCOR_THROW("Unsupported tilt '{}'.", tilt);
+                break;
+            }
+        }
+
+        NumberReader numbers(lines.remaining());
+
+        // The tilt data only describes how the lamp output changes with the tilt of the luminaire, skip it.
+        if (tiltInclude)
+        {
+            numbers.next(); // Lamp to luminaire geometry.
+            int tiltCount = int(numbers.next());
+            if (tiltCount < 0) FALCOR_THROW("Invalid tilt data.");
+            for (int i = 0; i < 2 * tiltCount; i++) numbers.next();
+        }
+
+        std::vector<float> data(kHeaderSize);
+        for (float& value : data) value = numbers.next();
+
+        int numVerticalAngles = int(data[kVerticalAngleCountIndex]);
+        int numHorizontalAngles = int(data[kHorizontalAngleCountIndex]);
+        int photometricType = int(data[kPhotometricTypeIndex]);
+        if (numVerticalAngles < 1 || numHorizontalAngles < 1) FALCOR_THROW("Invalid number of angles.");
+        if (photometricType != kPhotometricTypeC && photometricType != kPhotometricTypeB && photometricType != kPhotometricTypeA)
+            FALCOR_THROW("Invalid photometric type {}.", photometricType);
+
+        size_t expectedDataSize = kHeaderSize + numHorizontalAngles + numVerticalAngles + size_t(numHorizontalAngles) * numVerticalAngles;
+        data.resize(expectedDataSize);
+        for (size_t i = kHeaderSize; i < expectedDataSize; i++) data[i] = numbers.next();
+        if (!numbers.atEnd()) FALCOR_THROW("Unexpected data after the candela values.");
+
+        if (photometricType != kPhotometricTypeC) data = resampleToTypeC(data, photometricType);
+
+        float maxCandelas = 0.f;
+        for (size_t index = kHeaderSize + size_t(data[kVerticalAngleCountIndex]) + size_t(data[kHorizontalAngleCountIndex]); index < data.size(); index++)
+            maxCandelas = std::max(maxCandelas, data[index]);
+
+        // Stash the normalization factor in data[0], we don't use that anyway
+        data[0] = normalize ? (1.f / maxCandelas) : 1.f;
+
+        return data;
+    }
+
+    LightProfile::BakedProfile LightProfile::bakeIesProfile(const std::vector<float>& data)
+    {
+        FALCOR_CHECK(data.size() > kHeaderSize, "Invalid light profile data.");
+        const int numVerticalAngles = int(data[kVerticalAngleCountIndex]);
+        const int numHorizontalAngles = int(data[kHorizontalAngleCountIndex]);
+        FALCOR_CHECK(data.size() == kHeaderSize + numVerticalAngles + numHorizontalAngles + size_t(numVerticalAngles) * numHorizontalAngles, "Invalid light profile data.");
+
+        const float* verticalAngles = data.data() + kHeaderSize;
+        const float* horizontalAngles = verticalAngles + numVerticalAngles;
+        const float* candelas = horizontalAngles + numHorizontalAngles;
+        const float lastVerticalAngle = verticalAngles[numVerticalAngles - 1];
+        const float lastHorizontalAngle = horizontalAngles[numHorizontalAngles - 1];
+        const float normalization = data[0];
+
+        BakedProfile baked;
+        baked.texels.resize(kBakeResolution * kBakeResolution);
+        std::vector<double> rowFlux(kBakeResolution, 0.0);
+
+        // The vertical angle only depends on the column. Look up the angle indices and flux weights once.
+        // The flux factor is the integral of the profile over the directions of the sphere.
+        // The weights are scaled such that the weighted sum of all texels equals the integral.
+        std::vector<float> verticalAngleIndices(kBakeResolution);
+        std::vector<double> fluxWeights(kBakeResolution);
+        for (uint32_t x = 0; x < kBakeResolution; x++)
+        {
+            float verticalAngle = float(x) * (180.f / float(kBakeResolution));
+            float theta = verticalAngle / 180.f * float(M_PI);
+            verticalAngleIndices[x] = findAngleIndex(verticalAngle, verticalAngles, numVerticalAngles);
+            fluxWeights[x] = std::sin(theta) * 2.0 * M_PI * M_PI / (kBakeResolution * kBakeResolution);
+        }
+
+        // Bake the rows in parallel. Each row holds one horizontal angle.
+        parallelFor(0, kBakeResolution, [&](uint32_t y)
+        {
+            float horizontalAngle = float(y) * (360.f / float(kBakeResolution)) - 180.f;
+            if (lastHorizontalAngle <= 180.f)
+            {
+                // Apply symmetry
+                horizontalAngle = std::abs(horizontalAngle);
+                if (lastHorizontalAngle == 90.f && horizontalAngle > 90.f) horizontalAngle = 180.f - horizontalAngle;
+            }
+            else
+            {
+                // No symmetry, but the profile has data in 0..360 degree range, convert our -180..180 range to that
+                if (horizontalAngle < 0) horizontalAngle += 360.f;
+            }
+            float horizontalAngleIndex = findAngleIndex(horizontalAngle, horizontalAngles, numHorizontalAngles);
+
+            float row[kBakeResolution];
+            double flux = 0.0;
+            for (uint32_t x = 0; x < kBakeResolution; x++)
+            {
+                float verticalAngle = float(x) * (180.f / float(kBakeResolution));
+                if (verticalAngle > lastVerticalAngle)
+                {
+                    row[x] = 0.f;
+                    continue;
+                }
+
+                float result = interpolateCandelas(candelas, numVerticalAngles, verticalAngleIndices[x], horizontalAngleIndex) * normalization;
+                row[x] = result;
+                flux += result * fluxWeights[x];
+            }
+            PixelConversion::float32ToFloat16(row, baked.texels.data() + y * kBakeResolution, kBakeResolution);
+            rowFlux[y] = flux;
+        });
+
+        double fluxFactor = 0.0;
+        for (double flux : rowFlux) fluxFactor += flux;
+        baked.fluxFactor = float(fluxFactor);
+
+        return baked;
+    }
+
     void LightProfile::bake(RenderContext* pRenderContext)
+    {
+        // Baked profiles are shared per device among all light profiles with identical data.
+        static SharedCache<SharedData, std::pair<Device*, SHA1::MD>> sBakeCache;
+
+        auto key = std::make_pair(mpDevice.get(), SHA1::compute(mRawData.data(), mRawData.size() * sizeof(float)));
+        mpSharedData = sBakeCache.acquire(key, [this]()
+        {
+            auto pData = std::make_shared<SharedData>();
+            pData->baked = mpPrebaked ? std::move(*mpPrebaked) : bakeIesProfile(mRawData);
+            pData->pTexture = mpDevice->createTexture2D(kBakeResolution, kBakeResolution, ResourceFormat::R16Float, 1, 1, pData->baked.texels.data(), ResourceBindFlags::ShaderResource);
+            return pData;
+        });
+        mpPrebaked.reset();
+
+        mpTexture = mpSharedData->pTexture;
+        mFluxFactor = mpSharedData->baked.fluxFactor;
+        createSampler();
+    }
+
+    void LightProfile::bakeOnGpu(RenderContext* pRenderContext)
     {
         auto pBakePass = ComputePass::create(mpDevice, kBakeIesProfileFile, "main");
         auto pBuffer = mpDevice->createTypedBuffer<float>((uint32_t)mRawData.size(), ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, mRawData.data());
@@ -243,10 +506,22 @@ namespace Falcor
         reduction.execute<float4>(pRenderContext, pFluxTexture, ParallelReduction::Type::Sum, &fluxFactor);
         mFluxFactor = fluxFactor.x;
 
+        mpSharedData.reset();
+        createSampler();
+    }
+
+    void LightProfile::createSampler()
+    {
         Sampler::Desc desc;
         desc.setFilterMode(TextureFilteringMode::Linear, TextureFilteringMode::Linear, TextureFilteringMode::Linear);
         mpSampler = mpDevice->createSampler(desc);
     }
+    LightProfile::BakedProfile LightProfile::getBakedProfile() const
+    {
+        if (mpSharedData) return mpSharedData->baked;
+        if (mpPrebaked) return *mpPrebaked;
+        return bakeIesProfile(mRawData);
+    }
 
     void LightProfile::bindShaderData(const ShaderVar& var) const
     {
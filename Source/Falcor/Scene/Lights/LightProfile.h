@@ -34,7 +34,9 @@
 #include "Utils/UI/Gui.h"
 
 #include <filesystem>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace Falcor
@@ -45,10 +47,42 @@ namespace Falcor
     {
         FALCOR_OBJECT(LightProfile)
     public:
+        /** Light profile baked to the runtime texture.
+            The texels are stored in row-major order, with vertical angles along the columns and horizontal angles along the rows.
+        */
+        struct BakedProfile
+        {
+            std::vector<uint16_t> texels;   ///< Texels of the R16Float texture.
+            float fluxFactor = 0.f;         ///< Integral of the profile over the sphere.
+        };
+
         static ref<LightProfile> createFromIesProfile(ref<Device> pDevice, const std::filesystem::path& path, bool normalize);
 
+        /** Parse an IES profile into the canonical table used for baking.
+            The table holds the 13 header values, the vertical angles, the horizontal angles and the candela values.
+            Profiles with type A and B photometry are resampled to type C photometry. The first header value is replaced
+            with the normalization factor. Throws an exception if the profile is not supported or malformed.
+            \param[in] text Contents of the IES file.
+            \param[in] normalize Normalize the profile to a maximum of one.
+            \return The canonical table.
+        */
+        static std::vector<float> parseIesProfile(std::string_view text, bool normalize);
+
+        /** Bake a canonical table on the CPU. The result matches BakeIesProfile.cs.slang.
+            \param[in] data Canonical table returned by parseIesProfile().
+            \return The baked profile.
+        */
+        static BakedProfile bakeIesProfile(const std::vector<float>& data);
+
+        /** Bake the light profile to its runtime texture.
+            Baking is done on the CPU. Profiles with identical data share the baked texture.
+        */
         void bake(RenderContext* pRenderContext);
 
+        /** Bake the light profile on the GPU using BakeIesProfile.cs.slang. Used as reference for the CPU baker.
+        */
+        void bakeOnGpu(RenderContext* pRenderContext);
+
         /** Set the light profile into a shader var.
         */
         void bindShaderData(const ShaderVar& var) const;
@@ -57,14 +91,31 @@ namespace Falcor
         */
         void renderUI(Gui::Widgets& widget) const;
 
+        const std::string& getName() const { return mName; }
+        const std::vector<float>& getRawData() const { return mRawData; }
+        const ref<Texture>& getTexture() const { return mpTexture; }
+        float getFluxFactor() const { return mFluxFactor; }
+
     private:
+        struct SharedData;
+
         LightProfile(ref<Device> pDevice, const std::string& name, const std::vector<float>& rawData);
 
+        void createSampler();
+
+        /** Get the baked profile, baking it on the CPU if it has not been baked yet.
+        */
+        BakedProfile getBakedProfile() const;
+
         ref<Device> mpDevice;
         std::string mName;
         std::vector<float> mRawData;
+        std::unique_ptr<BakedProfile> mpPrebaked;   ///< Baked profile restored from the scene cache, consumed by bake().
+        std::shared_ptr<SharedData> mpSharedData;   ///< Baked profile and texture, shared among profiles with identical data.
         ref<Texture> mpTexture;
         ref<Sampler> mpSampler;
         float mFluxFactor = 0.f;
+
+        friend class SceneCache;
     };
 }
@@ -401,35 +401,59 @@ namespace Falcor
 
         if (textures.empty()) return;
 
-        // Analyze the textures.
-        logInfo("Analyzing {} material textures.", textures.size());
-
-        RenderContext* pRenderContext = mpDevice->getRenderContext();
-
-        TextureAnalyzer analyzer(mpDevice);
-        auto pResults = mpDevice->createBuffer(textures.size() * TextureAnalyzer::getResultSize(), ResourceBindFlags::UnorderedAccess);
-        analyzer.analyze(pRenderContext, textures, pResults);
-
-        // Copy result to staging buffer for readback.
-        // This is mostly to avoid a full flush and the associated perf warning.
-        // We do not have any other useful GPU work, but unrelated GPU tasks can be in flight.
-        auto pResultsStaging = mpDevice->createBuffer(textures.size() * TextureAnalyzer::getResultSize(), ResourceBindFlags::None, MemoryType::ReadBack);
-        pRenderContext->copyResource(pResultsStaging.get(), pResults.get());
-        pRenderContext->submit(false);
-        pRenderContext->signal(mpFence.get());
-
-        // Wait for results to become available. Then optimize the materials.
-        mpFence->wait();
-        const TextureAnalyzer::Result* results = static_cast<const TextureAnalyzer::Result*>(pResultsStaging->map());
-        Material::TextureOptimizationStats stats = {};
+        // Use the analysis computed while loading where available.
+        // The remaining textures are analyzed on the GPU.
+        std::vector<TextureAnalyzer::Result> results(textures.size());
+        std::vector<size_t> gpuIndices;
+        std::vector<ref<Texture>> gpuTextures;
+        for (size_t i = 0; i < textures.size(); i++)
+        {
+            if (auto analysis = mpTextureManager->getTextureAnalysis(textures[i]))
+            {
+                results[i] = *analysis;
+            }
+            else
+            {
+                gpuIndices.push_back(i);
+                gpuTextures.push_back(textures[i]);
+            }
+        }
 
+        logInfo("Analyzing {} material textures ({} analyzed while loading).", textures.size(), textures.size() - gpuTextures.size());
+
+        if (!gpuTextures.empty())
+        {
+            RenderContext* pRenderContext = mpDevice->getRenderContext();
+
+            TextureAnalyzer analyzer(mpDevice);
+            auto pResults = mpDevice->createBuffer(gpuTextures.size() * TextureAnalyzer::getResultSize(), ResourceBindFlags::UnorderedAccess);
+            analyzer.analyze(pRenderContext, gpuTextures, pResults);
+
+            // Copy result to staging buffer for readback.
+            // This is mostly to avoid a full flush and the associated perf warning.
+            // We do not have any other useful GPU work, but unrelated GPU tasks can be in flight.
+            auto pResultsStaging = mpDevice->createBuffer(gpuTextures.size() * TextureAnalyzer::getResultSize(), ResourceBindFlags::None, MemoryType::ReadBack);
+            pRenderContext->copyResource(pResultsStaging.get(), pResults.get());
+            pRenderContext->submit(false);
+            pRenderContext->signal(mpFence.get());
+
+            // Wait for results to become available.
+            mpFence->wait();
+            const TextureAnalyzer::Result* gpuResults = static_cast<const TextureAnalyzer::Result*>(pResultsStaging->map());
+            for (size_t i = 0; i < gpuIndices.size(); i++)
+            {
+                results[gpuIndices[i]] = gpuResults[i];
+            }
+            pResultsStaging->unmap();
+        }
+
+        // Optimize the materials.
+        Material::TextureOptimizationStats stats = {};
         for (size_t i = 0; i < textures.size(); i++)
         {
             materialSlots[i].first->optimizeTexture(materialSlots[i].second, results[i], stats);
         }
 
-        pResultsStaging->unmap();
-
         // Log optimization stats.
         if (size_t totalRemoved = std::accumulate(stats.texturesRemoved.begin(), stats.texturesRemoved.end(), 0ull); totalRemoved > 0)
         {
@@ -517,6 +541,10 @@ namespace Falcor
         updateFlags |= mMaterialUpdates;
         mMaterialUpdates = Material::UpdateFlags::None;
 
+        // Stream texture mip levels. Streamed textures are replaced when their resident mips change.
+        if (mpTextureManager->updateStreaming())
+            updateFlags |= Material::UpdateFlags::ResourcesChanged;
+
         // Create parameter block if needed.
         if (!mpMaterialsBlock)
         {
@@ -669,6 +697,8 @@ namespace Falcor
         s.textureTexelCount = textureStats.textureTexelCount;
         s.textureTexelChannelCount = textureStats.textureTexelChannelCount;
         s.textureMemoryInBytes = textureStats.textureMemoryInBytes;
+        s.textureTranscodeCacheHits = textureStats.transcodeCacheHits;
+        s.textureTranscodeCacheMisses = textureStats.transcodeCacheMisses;
 
         return s;
     }
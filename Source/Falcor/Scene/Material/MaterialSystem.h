@@ -70,6 +70,8 @@ namespace Falcor
             uint64_t textureTexelCount = 0;             ///< Total number of texels in all textures.
             uint64_t textureTexelChannelCount = 0;      ///< Total number of texel channels in all textures.
             uint64_t textureMemoryInBytes = 0;          ///< Total memory in bytes used by the textures.
+            uint64_t textureTranscodeCacheHits = 0;     ///< Number of textures loaded from the transcode cache.
+            uint64_t textureTranscodeCacheMisses = 0;   ///< Number of textures transcoded into the cache.
         };
 
         /** Constructor. Throws an exception if creation failed.
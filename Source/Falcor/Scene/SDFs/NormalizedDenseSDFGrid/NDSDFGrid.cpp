@@ -32,6 +32,11 @@
 
 namespace Falcor
 {
+    namespace
+    {
+        const uint32_t kCoarsestAllowedGridWidth = 8;
+    }
+
     struct NDSDFGrid::SharedData
     {
         ref<Sampler> pSampler;
@@ -134,8 +139,6 @@ namespace Falcor
 
     void NDSDFGrid::setValuesInternal(const std::vector<float>& cornerValues)
     {
-        const uint32_t kCoarsestAllowedGridWidth = 8;
-
         if (kCoarsestAllowedGridWidth > mGridWidth)
         {
             FALCOR_THROW("NDSDFGrid::setValues() grid width must be larger than {}.", kCoarsestAllowedGridWidth);
@@ -178,6 +181,13 @@ namespace Falcor
         }
     }
 
+    float NDSDFGrid::getNarrowBandWidth() const
+    {
+        // The coarsest LOD stores the largest distances.
+        uint32_t lodCount = bitScanReverse(std::max(mGridWidth / kCoarsestAllowedGridWidth, 1u)) + 1;
+        return calculateNormalizationFactor(mGridWidth >> (lodCount - 1));
+    }
+
     float NDSDFGrid::calculateNormalizationFactor(uint32_t gridWidth) const
     {
         return 0.5f * float(M_SQRT3) * mNarrowBandThickness / gridWidth;
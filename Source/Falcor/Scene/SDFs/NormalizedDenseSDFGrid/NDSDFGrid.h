@@ -59,6 +59,7 @@ namespace Falcor
 
     protected:
         virtual void setValuesInternal(const std::vector<float>& cornerValues) override;
+        virtual float getNarrowBandWidth() const override;
 
         float calculateNormalizationFactor(uint32_t gridWidth) const;
 
@@ -74,5 +75,7 @@ namespace Falcor
         // GPU data.
         std::vector<ref<Texture>> mNDSDFTextures;
         std::shared_ptr<SharedData> mpSharedData; ///< Shared data among all instances.
+
+        friend class SceneCache;
     };
 }
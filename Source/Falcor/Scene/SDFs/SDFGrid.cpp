@@ -26,6 +26,8 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "SDFGrid.h"
+#include "SDFGridFile.h"
+#include "SDFMeshGenerator.h"
 #include "GlobalState.h"
 #include "NormalizedDenseSDFGrid/NDSDFGrid.h"
 #include "SparseVoxelSet/SDFSVS.h"
@@ -40,8 +42,10 @@
 #include "Utils/Math/MatrixJson.h"
 #include "Utils/Math/VectorJson.h"
 #include "Utils/Scripting/ScriptBindings.h"
+#include "Scene/TriangleMesh.h"
 #include "GlobalState.h"
 #include <nlohmann/json.hpp>
+#include <limits>
 #include <random>
 #include <fstream>
 
@@ -62,6 +66,9 @@ namespace Falcor
 
         const char kPrimitiveTranslationJSONKey[] = "translation";
         const char kPrimitiveInvRotationScaleJSONKey[] = "inv_rot_scale";
+
+        // The grids store their corner values densely, warn before allocating more than this for a mesh.
+        const uint64_t kMeshDenseValuesWarningBytes = 1ull << 30;
     }
 
     NLOHMANN_JSON_SERIALIZE_ENUM(SDF3DShapeType, {
@@ -270,6 +277,38 @@ namespace Falcor
 
     bool SDFGrid::loadValuesFromFile(const std::filesystem::path& path)
     {
+        if (SDFGridFile::isSparseFile(path))
+        {
+            SDFGridFile::Header header;
+            std::vector<int8_t> normalizedValues;
+            if (!SDFGridFile::readSparse(path, header, normalizedValues)) return false;
+
+            Type type = getType();
+            if (type != Type::SparseBrickSet)
+            {
+                FALCOR_CHECK(isPowerOf2(header.gridWidth), "'gridWidth' ({}) must be a power of 2 for SDFGrid type of {}", header.gridWidth, getTypeName(type));
+            }
+
+            mGridWidth = header.gridWidth;
+
+            // Values quantized with the band width of the grid can be used as is, otherwise they are rescaled through floats.
+            float bandWidth = getNarrowBandWidth();
+            if (std::abs(header.bandWidth - bandWidth) <= 1e-6f * bandWidth)
+            {
+                setNormalizedValuesInternal(std::move(normalizedValues));
+            }
+            else
+            {
+                std::vector<float> cornerValues(normalizedValues.size());
+                float scale = header.bandWidth / float(INT8_MAX);
+                for (size_t v = 0; v < normalizedValues.size(); v++) cornerValues[v] = normalizedValues[v] * scale;
+                setValuesInternal(cornerValues);
+            }
+
+            mInitializedWithPrimitives = false;
+            return true;
+        }
+
         std::ifstream file(path, std::ios::in | std::ios::binary);
 
         if (file.is_open())
@@ -292,6 +331,76 @@ namespace Falcor
         return false;
     }
 
+    void SDFGrid::setValuesFromMesh(const TriangleMesh& mesh, uint32_t gridWidth)
+    {
+        const auto& vertices = mesh.getVertices();
+        std::vector<float3> positions(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++) positions[i] = vertices[i].position;
+
+        // The generator expects counter-clockwise front faces.
+        std::vector<uint32_t> indices = mesh.getIndices();
+        if (mesh.getFrontFaceCW())
+        {
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) std::swap(indices[i + 1], indices[i + 2]);
+        }
+
+        // All types except SBS need to have a gridWidth that is a power of 2.
+        Type type = getType();
+        if (type != Type::SparseBrickSet)
+        {
+            FALCOR_CHECK(isPowerOf2(gridWidth), "'gridWidth' ({}) must be a power of 2 for SDFGrid type of {}", gridWidth, getTypeName(type));
+        }
+
+        // The grid types index their corner values with 32-bit integers.
+        uint64_t gridWidthInValues = uint64_t(gridWidth) + 1;
+        uint64_t valueCount = gridWidthInValues * gridWidthInValues * gridWidthInValues;
+        FALCOR_CHECK(valueCount <= std::numeric_limits<uint32_t>::max(), "'gridWidth' ({}) is too large, the grid would have {} corner values.", gridWidth, valueCount);
+
+        // The sparse types take snorm8 values directly, only the dense grid needs the values as floats.
+        bool normalized = type != Type::NormalizedDenseGrid;
+        uint64_t denseBytes = valueCount * (normalized ? sizeof(int8_t) : sizeof(float));
+        if (denseBytes > kMeshDenseValuesWarningBytes)
+        {
+            logWarning("SDFGrid::setValuesFromMesh() allocates {} MB of corner values for a grid width of {}.", denseBytes >> 20, gridWidth);
+        }
+
+        mGridWidth = gridWidth;
+
+        SDFMeshGenerator generator(positions, indices);
+        SDFMeshGenerator::NarrowBand narrowBand = generator.generate(gridWidth, getNarrowBandWidth());
+        if (normalized) setNormalizedValuesInternal(narrowBand.toNormalized(getNarrowBandWidth()));
+        else setValuesInternal(narrowBand.toDense());
+
+        mInitializedWithPrimitives = false;
+    }
+
+    bool SDFGrid::loadValuesFromMesh(const std::filesystem::path& path, uint32_t gridWidth)
+    {
+        ref<TriangleMesh> pMesh = TriangleMesh::createFromFile(path);
+        if (!pMesh)
+        {
+            logWarning("SDFGrid::loadValuesFromMesh() mesh '{}' could not be loaded!", path);
+            return false;
+        }
+
+        // Fit the mesh inside the grid, leaving a margin of two voxels for the narrow band.
+        AABB bounds;
+        for (const auto& vertex : pMesh->getVertices()) bounds.include(vertex.position);
+        float3 extent = bounds.extent();
+        float maxExtent = std::max(std::max(extent.x, extent.y), extent.z);
+        if (!bounds.valid() || maxExtent <= 0.f)
+        {
+            logWarning("SDFGrid::loadValuesFromMesh() mesh '{}' is empty!", path);
+            return false;
+        }
+
+        float scale = std::max(1.f - 4.f / gridWidth, 0.5f) / maxExtent;
+        pMesh->applyTransform(math::mul(math::matrixFromScaling(float3(scale)), math::matrixFromTranslation(-bounds.center())));
+
+        setValuesFromMesh(*pMesh, gridWidth);
+        return true;
+    }
+
     void SDFGrid::generateCheeseValues(uint32_t gridWidth, uint32_t seed)
     {
         const float kHalfCheeseExtent = 0.4f;
@@ -344,7 +453,7 @@ namespace Falcor
         setValues(cornerValues, gridWidth);
     }
 
-    bool SDFGrid::writeValuesFromPrimitivesToFile(const std::filesystem::path& path, RenderContext* pRenderContext)
+    bool SDFGrid::writeValuesFromPrimitivesToFile(const std::filesystem::path& path, RenderContext* pRenderContext, bool sparse)
     {
         FALCOR_ASSERT(pRenderContext);
 
@@ -365,6 +474,8 @@ namespace Falcor
         mpEvaluatePrimitivesPass->execute(pRenderContext, uint3(gridWidthInValues));
         std::vector<float> values = pValuesBuffer->getElements<float>();
 
+        if (sparse) return SDFGridFile::writeSparse(path, values, mGridWidth, getNarrowBandWidth());
+
         std::ofstream file(path, std::ios::out | std::ios::binary);
 
         if (file.is_open())
@@ -421,6 +532,20 @@ namespace Falcor
         return true;
     }
 
+    void SDFGrid::setNormalizedValuesInternal(std::vector<int8_t>&& normalizedValues)
+    {
+        std::vector<float> cornerValues(normalizedValues.size());
+        float scale = getNarrowBandWidth() / float(INT8_MAX);
+        for (size_t v = 0; v < normalizedValues.size(); v++) cornerValues[v] = normalizedValues[v] * scale;
+        setValuesInternal(cornerValues);
+    }
+
+    float SDFGrid::getNarrowBandWidth() const
+    {
+        // Values are normalized so that a value of 1 represents half of a voxel diagonal.
+        return 0.5f * float(M_SQRT3) / mGridWidth;
+    }
+
     const SDF3DPrimitive& SDFGrid::getPrimitive(uint32_t primitiveID) const
     {
         auto it = mPrimitiveIDToIndex.find(primitiveID);
@@ -496,6 +621,10 @@ namespace Falcor
             [](SDFGrid& self, const std::filesystem::path& path, uint32_t gridWidth) { return self.loadPrimitivesFromFile(getActiveAssetResolver().resolvePath(path), gridWidth); },
             "path"_a, "gridWidth"_a
         ); // PYTHONDEPRECATED
+        sdfGrid.def("loadValuesFromMesh",
+            [](SDFGrid& self, const std::filesystem::path& path, uint32_t gridWidth) { return self.loadValuesFromMesh(getActiveAssetResolver().resolvePath(path), gridWidth); },
+            "path"_a, "gridWidth"_a
+        );
         sdfGrid.def("generateCheeseValues", &SDFGrid::generateCheeseValues, "gridWidth"_a, "seed"_a);
         sdfGrid.def_property("name", &SDFGrid::getName, &SDFGrid::setName);
     }
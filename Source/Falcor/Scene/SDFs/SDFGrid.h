@@ -41,6 +41,7 @@
 namespace Falcor
 {
     class RenderContext;
+    class TriangleMesh;
     struct ShaderVar;
 
     /** SDF grid base class, stored by distance values at grid cell/voxel corners.
@@ -124,11 +125,27 @@ namespace Falcor
         void setValues(const std::vector<float>& cornerValues, uint32_t gridWidth);
 
         /** Set the signed distance values of the SDF grid from a file.
+            Both dense .sdfg files and sparse files written by SDFGridFile are supported.
             \param[in] path The path of a .sdfg file.
             \return true if the values could be set, otherwise false.
         */
         bool loadValuesFromFile(const std::filesystem::path& path);
 
+        /** Set the signed distance values of the SDF grid from a triangle mesh.
+            The distances are computed on the CPU in the narrow band that the SDF grid representation can store, see SDFMeshGenerator.
+            The grids still store (gridWidth + 1)^3 corner values, one byte each for the sparse types and a float each while building the dense grid.
+            \param[in] mesh A closed triangle mesh in the local space of the SDF grid, i.e., [-0.5, 0.5]^3.
+            \param[in] gridWidth The grid width in voxels.
+        */
+        void setValuesFromMesh(const TriangleMesh& mesh, uint32_t gridWidth);
+
+        /** Set the signed distance values of the SDF grid from a triangle mesh file. The mesh is uniformly scaled and translated to fit inside the grid.
+            \param[in] path The path of a mesh file.
+            \param[in] gridWidth The grid width in voxels.
+            \return true if the values could be set, otherwise false.
+        */
+        bool loadValuesFromMesh(const std::filesystem::path& path, uint32_t gridWidth);
+
         /** Set the signed distance values of the SDF grid to represent a swiss cheese like shape.
             \param[in] gridWidth The grid width, note that this represents the grid width in voxels, not in values, i.e., cornerValues should have a size of (gridWidth + 1)^3.
             \param[in] seed Set the seed used to create the random holes in the swiss cheese..
@@ -137,9 +154,10 @@ namespace Falcor
 
         /** Evaluates the SDF grid primitives on to a grid and writes the grid to a file.
             \param[in] path A path to the file that should store the values.
+            \param[in] sparse Write a sparse file with quantized narrow band bricks (see SDFGridFile) instead of dense float values.
             \return true if the values could be written, otherwise false.
         */
-        bool writeValuesFromPrimitivesToFile(const std::filesystem::path& path, RenderContext* pRenderContext);
+        bool writeValuesFromPrimitivesToFile(const std::filesystem::path& path, RenderContext* pRenderContext, bool sparse = false);
 
         /** Reads primitives from file and initializes the SDF grid.
             \param[in] path The path to the input file.
@@ -236,6 +254,16 @@ namespace Falcor
     protected:
         virtual void setValuesInternal(const std::vector<float>& cornerValues) = 0;
 
+        /** Set the corner values from snorm8 values, where a value of INT8_MAX represents getNarrowBandWidth().
+            The default implementation dequantizes the values and calls setValuesInternal().
+        */
+        virtual void setNormalizedValuesInternal(std::vector<int8_t>&& normalizedValues);
+
+        /** Returns the distance in grid local space beyond which the representation clamps the values.
+            Only values within this distance of the surface need to be computed exactly.
+        */
+        virtual float getNarrowBandWidth() const;
+
         void createEvaluatePrimitivesPass(bool writeToTexture3D, bool mergeWithSDField);
 
         void updatePrimitivesBuffer();
@@ -261,6 +289,7 @@ namespace Falcor
         ref<ComputePass>        mpEvaluatePrimitivesPass;
 
         friend class Scene;
+        friend class SceneCache;
     };
 
     FALCOR_ENUM_CLASS_OPERATORS(SDFGrid::UpdateFlags);
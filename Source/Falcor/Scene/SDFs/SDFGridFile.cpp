@@ -0,0 +1,283 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "SDFGridFile.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Utils/Logger.h"
+#include "Utils/TaskManager.h"
+#include "Utils/Math/Common.h"
+#include "Utils/Math/MathConstants.slangh"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kMagic = 0x53464453; // "SDFS"
+        const uint32_t kVersion = 1;
+        const uint32_t kNoBrick = 0xffffffff;
+
+        static_assert(sizeof(SDFGridFile::Header) == 24);
+
+        /** Layout of a sparse file with a given grid width and number of stored bricks.
+        */
+        struct Layout
+        {
+            uint32_t brickGridWidth = 0;
+            size_t brickCount = 0;
+            size_t maskOffset = 0;
+            size_t indexOffset = 0;
+            size_t valueOffset = 0;
+            size_t size = 0;
+
+            Layout(uint32_t gridWidth, uint32_t storedBrickCount)
+            {
+                brickGridWidth = div_round_up(gridWidth + 1, SDFGridFile::kBrickWidth);
+                brickCount = size_t(brickGridWidth) * brickGridWidth * brickGridWidth;
+                maskOffset = sizeof(SDFGridFile::Header);
+                indexOffset = maskOffset + div_round_up(brickCount, size_t(32)) * sizeof(uint32_t);
+                valueOffset = indexOffset + size_t(storedBrickCount) * sizeof(uint32_t);
+                size = valueOffset + size_t(storedBrickCount) * SDFGridFile::kBrickValueCount;
+            }
+        };
+
+        /** Quantizes the values of a brick. Values outside the grid repeat the closest value in the grid.
+        */
+        void quantizeBrick(const float* pCornerValues, uint32_t gridWidth, uint32_t brickGridWidth, size_t brickIndex, float bandWidth, int8_t* pBrick)
+        {
+            const size_t gridWidthInValues = gridWidth + 1;
+            uint32_t brickX = uint32_t(brickIndex % brickGridWidth);
+            uint32_t brickY = uint32_t((brickIndex / brickGridWidth) % brickGridWidth);
+            uint32_t brickZ = uint32_t(brickIndex / (size_t(brickGridWidth) * brickGridWidth));
+
+            for (uint32_t z = 0; z < SDFGridFile::kBrickWidth; z++)
+            {
+                size_t gz = std::min(brickZ * SDFGridFile::kBrickWidth + z, gridWidth);
+                for (uint32_t y = 0; y < SDFGridFile::kBrickWidth; y++)
+                {
+                    size_t gy = std::min(brickY * SDFGridFile::kBrickWidth + y, gridWidth);
+                    const float* pRow = pCornerValues + gridWidthInValues * (gy + gridWidthInValues * gz);
+                    for (uint32_t x = 0; x < SDFGridFile::kBrickWidth; x++)
+                    {
+                        uint32_t gx = std::min(brickX * SDFGridFile::kBrickWidth + x, gridWidth);
+                        *pBrick++ = SDFGridFile::quantize(pRow[gx], bandWidth);
+                    }
+                }
+            }
+        }
+
+        bool writeSparseFile(const std::filesystem::path& path, const float* pCornerValues, uint32_t gridWidth, float bandWidth)
+        {
+            if (bandWidth <= 0.f) bandWidth = SDFGridFile::getDefaultBandWidth(gridWidth);
+
+            // Classify the bricks in parallel: 0 for saturated outside, 1 for saturated inside, 2 for stored bricks.
+            Layout layout(gridWidth, 0);
+            std::vector<uint8_t> brickTypes(layout.brickCount);
+            {
+                parallelFor(0, layout.brickCount, [&](size_t brickIndex)
+                {
+                    int8_t brick[SDFGridFile::kBrickValueCount];
+                    quantizeBrick(pCornerValues, gridWidth, layout.brickGridWidth, brickIndex, bandWidth, brick);
+
+                    bool outside = std::all_of(brick, brick + SDFGridFile::kBrickValueCount, [](int8_t v) { return v == INT8_MAX; });
+                    bool inside = std::all_of(brick, brick + SDFGridFile::kBrickValueCount, [](int8_t v) { return v == -INT8_MAX; });
+                    brickTypes[brickIndex] = outside ? 0 : (inside ? 1 : 2);
+                });
+            }
+
+            std::vector<uint32_t> insideMask(div_round_up(layout.brickCount, size_t(32)), 0);
+            std::vector<uint32_t> brickIndices;
+            for (size_t brickIndex = 0; brickIndex < layout.brickCount; brickIndex++)
+            {
+                if (brickTypes[brickIndex] == 1) insideMask[brickIndex / 32] |= 1u << (brickIndex % 32);
+                else if (brickTypes[brickIndex] == 2) brickIndices.push_back((uint32_t)brickIndex);
+            }
+
+            std::vector<int8_t> brickValues(brickIndices.size() * SDFGridFile::kBrickValueCount);
+            {
+                parallelFor(0, brickIndices.size(), [&](size_t slot)
+                {
+                    int8_t* pBrick = brickValues.data() + slot * SDFGridFile::kBrickValueCount;
+                    quantizeBrick(pCornerValues, gridWidth, layout.brickGridWidth, brickIndices[slot], bandWidth, pBrick);
+                });
+            }
+
+            std::ofstream file(path, std::ios::out | std::ios::binary);
+            if (!file.is_open())
+            {
+                logWarning("Failed to open sparse SDF grid file '{}' for writing.", path);
+                return false;
+            }
+
+            SDFGridFile::Header header;
+            header.magic = kMagic;
+            header.version = kVersion;
+            header.gridWidth = gridWidth;
+            header.brickWidth = SDFGridFile::kBrickWidth;
+            header.bandWidth = bandWidth;
+            header.brickCount = (uint32_t)brickIndices.size();
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(insideMask.data()), insideMask.size() * sizeof(uint32_t));
+            file.write(reinterpret_cast<const char*>(brickIndices.data()), brickIndices.size() * sizeof(uint32_t));
+            file.write(reinterpret_cast<const char*>(brickValues.data()), brickValues.size());
+            return file.good();
+        }
+    }
+
+    float SDFGridFile::getDefaultBandWidth(uint32_t gridWidth)
+    {
+        return 0.5f * float(M_SQRT3) / gridWidth;
+    }
+
+    int8_t SDFGridFile::quantize(float distance, float bandWidth)
+    {
+        float normalizedValue = std::clamp(distance / bandWidth, -1.0f, 1.0f);
+        float integerScale = normalizedValue * float(INT8_MAX);
+        return integerScale >= 0.0f ? int8_t(integerScale + 0.5f) : int8_t(integerScale - 0.5f);
+    }
+
+    bool SDFGridFile::isSparseFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        uint32_t magic = 0;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        return file.good() && magic == kMagic;
+    }
+
+    bool SDFGridFile::writeSparse(const std::filesystem::path& path, const std::vector<float>& cornerValues, uint32_t gridWidth, float bandWidth)
+    {
+        size_t gridWidthInValues = gridWidth + 1;
+        if (gridWidth == 0 || cornerValues.size() != gridWidthInValues * gridWidthInValues * gridWidthInValues)
+        {
+            logWarning("SDFGridFile::writeSparse() expects (gridWidth + 1)^3 values.");
+            return false;
+        }
+
+        return writeSparseFile(path, cornerValues.data(), gridWidth, bandWidth);
+    }
+
+    bool SDFGridFile::convertDenseToSparse(const std::filesystem::path& densePath, const std::filesystem::path& sparsePath, float bandWidth)
+    {
+        MemoryMappedFile file(densePath, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+        if (!file.isOpen())
+        {
+            logWarning("Failed to open SDF grid file '{}' for reading.", densePath);
+            return false;
+        }
+
+        const uint8_t* pData = reinterpret_cast<const uint8_t*>(file.getData());
+        uint32_t gridWidth = 0;
+        if (file.getSize() >= sizeof(uint32_t)) std::memcpy(&gridWidth, pData, sizeof(uint32_t));
+
+        size_t gridWidthInValues = size_t(gridWidth) + 1;
+        if (gridWidth == 0 || file.getSize() < sizeof(uint32_t) + gridWidthInValues * gridWidthInValues * gridWidthInValues * sizeof(float))
+        {
+            logWarning("SDF grid file '{}' is not a valid dense SDF grid file.", densePath);
+            return false;
+        }
+
+        return writeSparseFile(sparsePath, reinterpret_cast<const float*>(pData + sizeof(uint32_t)), gridWidth, bandWidth);
+    }
+
+    bool SDFGridFile::readSparse(const std::filesystem::path& path, Header& header, std::vector<int8_t>& cornerValues)
+    {
+        MemoryMappedFile file(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+        if (!file.isOpen())
+        {
+            logWarning("Failed to open sparse SDF grid file '{}' for reading.", path);
+            return false;
+        }
+
+        const uint8_t* pData = reinterpret_cast<const uint8_t*>(file.getData());
+        if (file.getSize() < sizeof(Header))
+        {
+            logWarning("Sparse SDF grid file '{}' is truncated.", path);
+            return false;
+        }
+        std::memcpy(&header, pData, sizeof(Header));
+
+        if (header.magic != kMagic || header.version != kVersion || header.brickWidth != kBrickWidth || header.gridWidth == 0 || !(header.bandWidth > 0.f))
+        {
+            logWarning("Sparse SDF grid file '{}' has an invalid header.", path);
+            return false;
+        }
+
+        Layout layout(header.gridWidth, header.brickCount);
+        if (file.getSize() < layout.size)
+        {
+            logWarning("Sparse SDF grid file '{}' is truncated.", path);
+            return false;
+        }
+
+        const uint32_t* pInsideMask = reinterpret_cast<const uint32_t*>(pData + layout.maskOffset);
+        const uint32_t* pBrickIndices = reinterpret_cast<const uint32_t*>(pData + layout.indexOffset);
+        const int8_t* pBrickValues = reinterpret_cast<const int8_t*>(pData + layout.valueOffset);
+
+        std::vector<uint32_t> brickSlots(layout.brickCount, kNoBrick);
+        for (uint32_t slot = 0; slot < header.brickCount; slot++)
+        {
+            if (pBrickIndices[slot] >= layout.brickCount || (slot > 0 && pBrickIndices[slot] <= pBrickIndices[slot - 1]))
+            {
+                logWarning("Sparse SDF grid file '{}' has an invalid brick index.", path);
+                return false;
+            }
+            brickSlots[pBrickIndices[slot]] = slot;
+        }
+
+        // Decode the bricks in parallel, each brick writes a disjoint region of the grid.
+        const uint32_t gridWidth = header.gridWidth;
+        const size_t gridWidthInValues = gridWidth + 1;
+        cornerValues.resize(gridWidthInValues * gridWidthInValues * gridWidthInValues);
+
+        parallelFor(0, layout.brickCount, [&](size_t brickIndex)
+        {
+            uint32_t brickX = uint32_t(brickIndex % layout.brickGridWidth) * kBrickWidth;
+            uint32_t brickY = uint32_t((brickIndex / layout.brickGridWidth) % layout.brickGridWidth) * kBrickWidth;
+            uint32_t brickZ = uint32_t(brickIndex / (size_t(layout.brickGridWidth) * layout.brickGridWidth)) * kBrickWidth;
+            uint32_t rowLength = std::min(kBrickWidth, gridWidth + 1 - brickX);
+
+            uint32_t slot = brickSlots[brickIndex];
+            bool inside = (pInsideMask[brickIndex / 32] >> (brickIndex % 32)) & 1;
+            const int8_t* pBrick = slot != kNoBrick ? pBrickValues + size_t(slot) * kBrickValueCount : nullptr;
+
+            for (uint32_t z = 0; z < kBrickWidth && brickZ + z <= gridWidth; z++)
+            {
+                for (uint32_t y = 0; y < kBrickWidth && brickY + y <= gridWidth; y++)
+                {
+                    int8_t* pRow = cornerValues.data() + brickX + gridWidthInValues * ((brickY + y) + gridWidthInValues * (brickZ + z));
+                    if (pBrick) std::memcpy(pRow, pBrick + kBrickWidth * (y + kBrickWidth * z), rowLength);
+                    else std::memset(pRow, inside ? -INT8_MAX : INT8_MAX, rowLength);
+                }
+            }
+        });
+
+        return true;
+    }
+}
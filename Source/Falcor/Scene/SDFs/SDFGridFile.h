@@ -0,0 +1,102 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace Falcor
+{
+    /** Reading and writing of sparse SDF grid value files.
+
+        Dense value files (.sdfg) store the grid width followed by (gridWidth + 1)^3 float corner values.
+        Most of these values are far from the surface and are saturated when the grid is normalized, so sparse files only store bricks of
+        kBrickWidth^3 corner values that contain unsaturated values. The values are quantized to snorm8, where a value of 1 represents
+        the band width stored in the file. The remaining bricks are stored as a single bit, telling if the brick is inside or outside.
+
+        File layout:
+        - Header.
+        - One bit per brick in the brick grid, set for saturated bricks that are inside the surface, packed into 32-bit words.
+        - The indices of the unsaturated bricks in the brick grid, in increasing order.
+        - kBrickWidth^3 snorm8 values per unsaturated brick, x varies fastest. Values outside the grid repeat the closest value in the grid.
+    */
+    class FALCOR_API SDFGridFile
+    {
+    public:
+        static constexpr uint32_t kBrickWidth = 8;
+        static constexpr uint32_t kBrickValueCount = kBrickWidth * kBrickWidth * kBrickWidth;
+
+        struct Header
+        {
+            uint32_t magic = 0;
+            uint32_t version = 0;
+            uint32_t gridWidth = 0;         ///< Grid width in voxels.
+            uint32_t brickWidth = 0;        ///< Brick width in corner values.
+            float bandWidth = 0.f;          ///< Distance in grid local space represented by a normalized value of 1.
+            uint32_t brickCount = 0;        ///< Number of stored (unsaturated) bricks.
+        };
+
+        /** Returns the band width used by the sparse SDF grids, where a normalized value of 1 represents half of a voxel diagonal.
+        */
+        static float getDefaultBandWidth(uint32_t gridWidth);
+
+        /** Quantizes a distance to snorm8 in the same way as the SDF grids.
+        */
+        static int8_t quantize(float distance, float bandWidth);
+
+        /** Check if a file is a sparse SDF grid file.
+        */
+        static bool isSparseFile(const std::filesystem::path& path);
+
+        /** Write a sparse SDF grid file from dense corner values.
+            \param[in] path The path of the output file.
+            \param[in] cornerValues The corner values for all voxels in the grid, (gridWidth + 1)^3 values.
+            \param[in] gridWidth The grid width in voxels.
+            \param[in] bandWidth The distance represented by a normalized value of 1, or 0 to use getDefaultBandWidth().
+            \return true if the file could be written, otherwise false.
+        */
+        static bool writeSparse(const std::filesystem::path& path, const std::vector<float>& cornerValues, uint32_t gridWidth, float bandWidth = 0.f);
+
+        /** Convert a dense SDF grid file (.sdfg) to a sparse file.
+            \param[in] densePath The path of the dense file.
+            \param[in] sparsePath The path of the sparse output file.
+            \param[in] bandWidth The distance represented by a normalized value of 1, or 0 to use getDefaultBandWidth().
+            \return true if the file could be converted, otherwise false.
+        */
+        static bool convertDenseToSparse(const std::filesystem::path& densePath, const std::filesystem::path& sparsePath, float bandWidth = 0.f);
+
+        /** Read a sparse SDF grid file into dense snorm8 corner values.
+            \param[in] path The path of the sparse file.
+            \param[out] header The file header, containing the grid width and band width.
+            \param[out] cornerValues The normalized corner values for all voxels in the grid, (gridWidth + 1)^3 values.
+            \return true if the file could be read, otherwise false.
+        */
+        static bool readSparse(const std::filesystem::path& path, Header& header, std::vector<int8_t>& cornerValues);
+    };
+}
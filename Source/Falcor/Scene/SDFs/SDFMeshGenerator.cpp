@@ -0,0 +1,621 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "SDFMeshGenerator.h"
+#include "SDFGridFile.h"
+#include "Core/Error.h"
+#include "Utils/Math/Common.h"
+#include "Utils/Math/MathConstants.slangh"
+#include "Utils/Math/ScalarMath.h"
+#include "Utils/Math/VectorMath.h"
+#include "Utils/TaskManager.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace Falcor
+{
+    namespace
+    {
+        const float kWeldTolerance = 1e-6f;             ///< Vertices closer than this fraction of the mesh diagonal are welded.
+        const uint32_t kMaxTrianglesPerLeaf = 4;
+        const uint32_t kMaxTraversalDepth = 64;
+        const uint32_t kUnknownBrick = 0xfffffffd;
+
+        /** Closest feature of a triangle.
+        */
+        enum class Feature
+        {
+            Vertex0, Vertex1, Vertex2,
+            Edge01, Edge12, Edge20,
+            Face,
+        };
+
+        /** Computes the closest point on a triangle, see Ericson, Real-Time Collision Detection, section 5.1.5.
+        */
+        float3 closestPointOnTriangle(const float3& p, const float3& a, const float3& b, const float3& c, Feature& feature)
+        {
+            float3 ab = b - a;
+            float3 ac = c - a;
+            float3 ap = p - a;
+            float d1 = dot(ab, ap);
+            float d2 = dot(ac, ap);
+            if (d1 <= 0.f && d2 <= 0.f)
+            {
+                feature = Feature::Vertex0;
+                return a;
+            }
+
+            float3 bp = p - b;
+            float d3 = dot(ab, bp);
+            float d4 = dot(ac, bp);
+            if (d3 >= 0.f && d4 <= d3)
+            {
+                feature = Feature::Vertex1;
+                return b;
+            }
+
+            float vc = d1 * d4 - d3 * d2;
+            if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+            {
+                feature = Feature::Edge01;
+                return a + ab * (d1 / (d1 - d3));
+            }
+
+            float3 cp = p - c;
+            float d5 = dot(ab, cp);
+            float d6 = dot(ac, cp);
+            if (d6 >= 0.f && d5 <= d6)
+            {
+                feature = Feature::Vertex2;
+                return c;
+            }
+
+            float vb = d5 * d2 - d1 * d6;
+            if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+            {
+                feature = Feature::Edge20;
+                return a + ac * (d2 / (d2 - d6));
+            }
+
+            float va = d3 * d6 - d5 * d4;
+            if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+            {
+                feature = Feature::Edge12;
+                return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+            }
+
+            feature = Feature::Face;
+            float denom = 1.f / (va + vb + vc);
+            return a + ab * (vb * denom) + ac * (vc * denom);
+        }
+
+        float distanceSquaredToBox(const float3& p, const AABB& box)
+        {
+            float3 d = max(max(box.minPoint - p, p - box.maxPoint), float3(0.f));
+            return dot(d, d);
+        }
+
+        uint32_t getBrickIndex(uint3 brick, uint3 brickGridDim)
+        {
+            return brick.x + brickGridDim.x * (brick.y + brickGridDim.y * brick.z);
+        }
+    }
+
+    float SDFMeshGenerator::NarrowBand::getValue(uint3 corner) const
+    {
+        uint3 brick = corner / kBrickWidth;
+        uint3 local = corner % kBrickWidth;
+        uint32_t slot = brickSlots[getBrickIndex(brick, brickGridDim)];
+        if (slot == kInsideBrick) return -bandWidth;
+        if (slot == kOutsideBrick) return bandWidth;
+        return brickValues[size_t(slot) * kBrickValueCount + local.x + kBrickWidth * (local.y + kBrickWidth * local.z)];
+    }
+
+    std::vector<float> SDFMeshGenerator::NarrowBand::toDense() const
+    {
+        size_t gridWidthInValues = gridWidth + 1;
+        std::vector<float> values(gridWidthInValues * gridWidthInValues * gridWidthInValues);
+
+        parallelFor(0, gridWidth + 1, [&](uint32_t z)
+        {
+            float* pValues = values.data() + gridWidthInValues * gridWidthInValues * z;
+            for (uint32_t y = 0; y <= gridWidth; y++)
+            {
+                for (uint32_t x = 0; x <= gridWidth; x++)
+                {
+                    *pValues++ = getValue(uint3(x, y, z));
+                }
+            }
+        });
+
+        return values;
+    }
+
+    std::vector<int8_t> SDFMeshGenerator::NarrowBand::toNormalized(float normalizationWidth) const
+    {
+        size_t gridWidthInValues = gridWidth + 1;
+        std::vector<int8_t> values(gridWidthInValues * gridWidthInValues * gridWidthInValues);
+
+        parallelFor(0, gridWidth + 1, [&](uint32_t z)
+        {
+            int8_t* pValues = values.data() + gridWidthInValues * gridWidthInValues * z;
+            for (uint32_t y = 0; y <= gridWidth; y++)
+            {
+                for (uint32_t x = 0; x <= gridWidth; x++)
+                {
+                    *pValues++ = SDFGridFile::quantize(getValue(uint3(x, y, z)), normalizationWidth);
+                }
+            }
+        });
+
+        return values;
+    }
+
+    SDFMeshGenerator::SDFMeshGenerator(const std::vector<float3>& positions, const std::vector<uint32_t>& indices)
+    {
+        FALCOR_CHECK(indices.size() % 3 == 0, "Triangle index count ({}) must be a multiple of 3.", indices.size());
+
+        // Weld vertices that are closer than a small fraction of the mesh diagonal, so that pseudo normals are computed across seams
+        // and tessellation poles are collapsed.
+        AABB meshBounds;
+        for (const float3& p : positions) meshBounds.include(p);
+        float weldDistance = positions.empty() ? 1.f : std::max(math::length(meshBounds.extent()) * kWeldTolerance, std::numeric_limits<float>::min());
+
+        std::vector<int3> weldKeys(positions.size());
+        std::vector<uint32_t> order(positions.size());
+        for (uint32_t i = 0; i < order.size(); i++)
+        {
+            weldKeys[i] = int3(math::round((positions[i] - meshBounds.minPoint) / weldDistance));
+            order[i] = i;
+        }
+        auto lessKey = [&](uint32_t a, uint32_t b)
+        {
+            const int3& ka = weldKeys[a];
+            const int3& kb = weldKeys[b];
+            return ka.x != kb.x ? ka.x < kb.x : (ka.y != kb.y ? ka.y < kb.y : (ka.z != kb.z ? ka.z < kb.z : a < b));
+        };
+        parallelSort(order.begin(), order.end(), lessKey);
+
+        std::vector<uint32_t> weldedIndex(positions.size());
+        std::vector<float3> weldedPositions;
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            if (i == 0 || any(weldKeys[order[i]] != weldKeys[order[i - 1]])) weldedPositions.push_back(positions[order[i]]);
+            weldedIndex[order[i]] = (uint32_t)weldedPositions.size() - 1;
+        }
+
+        // Create triangles, skipping degenerate ones.
+        std::vector<uint3> triangleVertices;
+        mTriangles.reserve(indices.size() / 3);
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            FALCOR_CHECK(indices[i] < positions.size() && indices[i + 1] < positions.size() && indices[i + 2] < positions.size(), "Invalid triangle index.");
+
+            uint3 vertices = uint3(weldedIndex[indices[i]], weldedIndex[indices[i + 1]], weldedIndex[indices[i + 2]]);
+            if (vertices.x == vertices.y || vertices.y == vertices.z || vertices.z == vertices.x) continue;
+
+            Triangle triangle;
+            for (uint32_t j = 0; j < 3; j++) triangle.vertices[j] = weldedPositions[vertices[j]];
+            float3 normal = cross(triangle.vertices[1] - triangle.vertices[0], triangle.vertices[2] - triangle.vertices[0]);
+            float area = length(normal);
+            if (!(area > 0.f)) continue;
+
+            triangle.faceNormal = normal / area;
+            mTriangles.push_back(triangle);
+            triangleVertices.push_back(vertices);
+        }
+
+        // Accumulate the angle-weighted vertex normals and the edge normals.
+        std::vector<float3> vertexNormals(weldedPositions.size(), float3(0.f));
+        std::unordered_map<uint64_t, float3> edgeNormals;
+        edgeNormals.reserve(mTriangles.size() * 2);
+        auto getEdgeKey = [](uint32_t a, uint32_t b) { return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a; };
+
+        for (size_t t = 0; t < mTriangles.size(); t++)
+        {
+            const Triangle& triangle = mTriangles[t];
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                float3 e0 = normalize(triangle.vertices[(j + 1) % 3] - triangle.vertices[j]);
+                float3 e1 = normalize(triangle.vertices[(j + 2) % 3] - triangle.vertices[j]);
+                float angle = std::acos(std::clamp(dot(e0, e1), -1.f, 1.f));
+                vertexNormals[triangleVertices[t][j]] += angle * triangle.faceNormal;
+
+                uint64_t edgeKey = getEdgeKey(triangleVertices[t][j], triangleVertices[t][(j + 1) % 3]);
+                edgeNormals.try_emplace(edgeKey, float3(0.f)).first->second += triangle.faceNormal;
+            }
+        }
+
+        for (size_t t = 0; t < mTriangles.size(); t++)
+        {
+            Triangle& triangle = mTriangles[t];
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                triangle.vertexNormals[j] = vertexNormals[triangleVertices[t][j]];
+                triangle.edgeNormals[j] = edgeNormals[getEdgeKey(triangleVertices[t][j], triangleVertices[t][(j + 1) % 3])];
+            }
+        }
+
+        buildBVH();
+    }
+
+    SDFMeshGenerator::NarrowBand SDFMeshGenerator::generate(uint32_t gridWidth, float bandWidth) const
+    {
+        FALCOR_CHECK(gridWidth > 0, "'gridWidth' must be larger than 0.");
+
+        const float voxelWidth = 1.f / gridWidth;
+        const float brickHalfDiagonal = 0.5f * float(M_SQRT3) * (kBrickWidth - 1) * voxelWidth;
+
+        NarrowBand result;
+        result.gridWidth = gridWidth;
+        result.bandWidth = std::max(bandWidth, 2.f * voxelWidth);
+        result.brickGridDim = uint3(div_round_up(gridWidth + 1, kBrickWidth));
+
+        const uint3 brickGridDim = result.brickGridDim;
+        const size_t brickCount = size_t(brickGridDim.x) * brickGridDim.y * brickGridDim.z;
+        const float band = result.bandWidth;
+
+        auto getBrickCenter = [&](uint3 brick)
+        {
+            return (float3(brick * kBrickWidth) + 0.5f * (kBrickWidth - 1)) * voxelWidth - 0.5f;
+        };
+
+        // Mark the bricks that have a triangle closer than the band width to any of their corners.
+        // A triangle within (band + half diagonal) of the brick center is a conservative test for this.
+        std::vector<std::atomic<uint8_t>> activeBricks(brickCount);
+        {
+            parallelFor(0, (uint32_t)mTriangles.size(), [&](uint32_t t)
+            {
+                const Triangle& triangle = mTriangles[t];
+                float3 minPoint = min(min(triangle.vertices[0], triangle.vertices[1]), triangle.vertices[2]) - band;
+                float3 maxPoint = max(max(triangle.vertices[0], triangle.vertices[1]), triangle.vertices[2]) + band;
+
+                // Range of bricks whose corners may be within the band.
+                int3 minCorner = int3(math::ceil((minPoint + 0.5f) * float(gridWidth)));
+                int3 maxCorner = int3(math::floor((maxPoint + 0.5f) * float(gridWidth)));
+                minCorner = clamp(minCorner, int3(0), int3(gridWidth));
+                maxCorner = clamp(maxCorner, int3(0), int3(gridWidth));
+                if (any(minCorner > maxCorner)) return;
+                uint3 minBrick = uint3(minCorner) / kBrickWidth;
+                uint3 maxBrick = uint3(maxCorner) / kBrickWidth;
+
+                const float maxDistance = band + brickHalfDiagonal;
+                for (uint32_t z = minBrick.z; z <= maxBrick.z; z++)
+                {
+                    for (uint32_t y = minBrick.y; y <= maxBrick.y; y++)
+                    {
+                        for (uint32_t x = minBrick.x; x <= maxBrick.x; x++)
+                        {
+                            uint32_t brickIndex = getBrickIndex(uint3(x, y, z), brickGridDim);
+                            if (activeBricks[brickIndex].load(std::memory_order_relaxed)) continue;
+
+                            float3 center = getBrickCenter(uint3(x, y, z));
+                            Feature feature;
+                            float3 closest = closestPointOnTriangle(center, triangle.vertices[0], triangle.vertices[1], triangle.vertices[2], feature);
+                            float3 d = closest - center;
+                            if (dot(d, d) <= maxDistance * maxDistance) activeBricks[brickIndex].store(1, std::memory_order_relaxed);
+                        }
+                    }
+                }
+            });
+        }
+
+        // Assign slots to the bricks in the narrow band.
+        std::vector<uint32_t> bandBricks;
+        result.brickSlots.resize(brickCount);
+        for (size_t i = 0; i < brickCount; i++)
+        {
+            if (activeBricks[i].load(std::memory_order_relaxed))
+            {
+                result.brickSlots[i] = (uint32_t)bandBricks.size();
+                bandBricks.push_back((uint32_t)i);
+            }
+            else
+            {
+                result.brickSlots[i] = kUnknownBrick;
+            }
+        }
+
+        // Compute the signed distances of the bricks in the narrow band.
+        // Corners further than the band width from the surface only need a sign. Since they are more than one voxel away from the surface,
+        // they have the same sign as their neighbors, which is propagated from the corners within the band.
+        result.brickValues.resize(bandBricks.size() * kBrickValueCount);
+        {
+            parallelFor(0, (uint32_t)bandBricks.size(), [&](uint32_t slot)
+            {
+                uint32_t brickIndex = bandBricks[slot];
+                uint3 brickCorner = uint3(
+                    brickIndex % brickGridDim.x,
+                    (brickIndex / brickGridDim.x) % brickGridDim.y,
+                    brickIndex / (brickGridDim.x * brickGridDim.y)
+                ) * kBrickWidth;
+                auto getCornerPosition = [&](uint32_t i)
+                {
+                    uint3 local = uint3(i % kBrickWidth, (i / kBrickWidth) % kBrickWidth, i / (kBrickWidth * kBrickWidth));
+                    return float3(brickCorner + local) * voxelWidth - 0.5f;
+                };
+
+                // Corners without a sign are marked with infinity.
+                const float kNoSign = std::numeric_limits<float>::infinity();
+                float* pValues = result.brickValues.data() + size_t(slot) * kBrickValueCount;
+                bool hasSign = false;
+                for (uint32_t i = 0; i < kBrickValueCount; i++)
+                {
+                    float distance = findSignedDistance(getCornerPosition(i), band);
+                    pValues[i] = std::abs(distance) < band ? distance : kNoSign;
+                    hasSign |= pValues[i] != kNoSign;
+                }
+
+                // The brick may only be close to the surface outside of its corners, search further to find the sign of one corner.
+                if (!hasSign) pValues[0] = findSignedDistance(getCornerPosition(0), (band + 2.f * brickHalfDiagonal) * 1.001f) < 0.f ? -band : band;
+
+                const uint32_t strides[3] = { 1, kBrickWidth, kBrickWidth * kBrickWidth };
+                bool changed = true;
+                while (changed)
+                {
+                    changed = false;
+                    for (uint32_t i = 0; i < kBrickValueCount; i++)
+                    {
+                        if (pValues[i] != kNoSign) continue;
+                        for (uint32_t axis = 0; axis < 3 && pValues[i] == kNoSign; axis++)
+                        {
+                            uint32_t coord = (i / strides[axis]) % kBrickWidth;
+                            float neighbor = kNoSign;
+                            if (coord > 0 && pValues[i - strides[axis]] != kNoSign) neighbor = pValues[i - strides[axis]];
+                            else if (coord + 1 < kBrickWidth && pValues[i + strides[axis]] != kNoSign) neighbor = pValues[i + strides[axis]];
+                            if (neighbor != kNoSign) pValues[i] = neighbor < 0.f ? -band : band;
+                        }
+                        changed |= pValues[i] != kNoSign;
+                    }
+                }
+            });
+        }
+
+        // Bricks outside the narrow band are entirely inside or outside the surface.
+        // Seed their signs from adjacent bricks in the narrow band, using the corner next to the center of the shared face.
+        // Since that corner is one voxel away from a corner that is further than the band width from the surface, its sign is reliable.
+        {
+            parallelFor(0, (uint32_t)brickCount, [&](uint32_t brickIndex)
+            {
+                if (result.brickSlots[brickIndex] != kUnknownBrick) return;
+
+                int3 brick = int3(
+                    brickIndex % brickGridDim.x,
+                    (brickIndex / brickGridDim.x) % brickGridDim.y,
+                    brickIndex / (brickGridDim.x * brickGridDim.y)
+                );
+                for (uint32_t axis = 0; axis < 3; axis++)
+                {
+                    for (int dir : {-1, 1})
+                    {
+                        int3 neighbor = brick;
+                        neighbor[axis] += dir;
+                        if (neighbor[axis] < 0 || neighbor[axis] >= int(brickGridDim[axis])) continue;
+
+                        uint32_t slot = result.brickSlots[getBrickIndex(uint3(neighbor), brickGridDim)];
+                        if (slot >= kUnknownBrick) continue;
+
+                        uint3 local = uint3(kBrickWidth / 2);
+                        local[axis] = dir > 0 ? 0 : kBrickWidth - 1;
+                        float value = result.brickValues[size_t(slot) * kBrickValueCount + local.x + kBrickWidth * (local.y + kBrickWidth * local.z)];
+                        result.brickSlots[brickIndex] = value < 0.f ? NarrowBand::kInsideBrick : NarrowBand::kOutsideBrick;
+                        return;
+                    }
+                }
+            });
+        }
+
+        // Propagate the signs along lines of bricks outside the narrow band, sweeping along each axis in both directions until no signs change.
+        // Lines along the same axis are disjoint and processed in parallel.
+        {
+            std::atomic<bool> changed{true};
+            while (changed)
+            {
+                changed = false;
+                for (uint32_t axis = 0; axis < 3; axis++)
+                {
+                    uint32_t axisU = (axis + 1) % 3;
+                    uint32_t axisV = (axis + 2) % 3;
+                    uint32_t lineCount = brickGridDim[axisU] * brickGridDim[axisV];
+                    parallelFor(0, lineCount, [&](uint32_t line)
+                    {
+                        uint3 brick;
+                        brick[axisU] = line % brickGridDim[axisU];
+                        brick[axisV] = line / brickGridDim[axisU];
+
+                        bool lineChanged = false;
+                        auto sweep = [&](int start, int end, int step)
+                        {
+                            uint32_t sign = kUnknownBrick;
+                            for (int i = start; i != end; i += step)
+                            {
+                                brick[axis] = i;
+                                uint32_t& slot = result.brickSlots[getBrickIndex(brick, brickGridDim)];
+                                if (slot < kUnknownBrick) sign = kUnknownBrick;
+                                else if (slot != kUnknownBrick) sign = slot;
+                                else if (sign != kUnknownBrick)
+                                {
+                                    slot = sign;
+                                    lineChanged = true;
+                                }
+                            }
+                        };
+                        sweep(0, int(brickGridDim[axis]), 1);
+                        sweep(int(brickGridDim[axis]) - 1, -1, -1);
+
+                        if (lineChanged) changed.store(true, std::memory_order_relaxed);
+                    });
+                }
+            }
+        }
+
+        // Bricks that are not connected to the narrow band can only exist if there is no surface in the grid.
+        for (uint32_t& slot : result.brickSlots)
+        {
+            if (slot == kUnknownBrick) slot = NarrowBand::kOutsideBrick;
+        }
+
+        return result;
+    }
+
+    void SDFMeshGenerator::buildBVH()
+    {
+        mNodes.clear();
+        if (mTriangles.empty()) return;
+
+        std::vector<float3> centroids(mTriangles.size());
+        std::vector<uint32_t> order(mTriangles.size());
+        for (uint32_t t = 0; t < mTriangles.size(); t++)
+        {
+            centroids[t] = (mTriangles[t].vertices[0] + mTriangles[t].vertices[1] + mTriangles[t].vertices[2]) / 3.f;
+            order[t] = t;
+        }
+
+        // Build top-down by splitting at the median centroid along the largest axis.
+        struct BuildItem
+        {
+            uint32_t nodeIndex;
+            uint32_t begin;
+            uint32_t end;
+        };
+        std::vector<BuildItem> stack = { { 0, 0, (uint32_t)mTriangles.size() } };
+        mNodes.reserve(2 * mTriangles.size() / kMaxTrianglesPerLeaf + 1);
+        mNodes.emplace_back();
+
+        while (!stack.empty())
+        {
+            BuildItem item = stack.back();
+            stack.pop_back();
+
+            AABB bounds;
+            AABB centroidBounds;
+            for (uint32_t i = item.begin; i < item.end; i++)
+            {
+                const Triangle& triangle = mTriangles[order[i]];
+                bounds.include(triangle.vertices[0]).include(triangle.vertices[1]).include(triangle.vertices[2]);
+                centroidBounds.include(centroids[order[i]]);
+            }
+            mNodes[item.nodeIndex].bounds = bounds;
+
+            uint32_t count = item.end - item.begin;
+            float3 extent = centroidBounds.extent();
+            if (count <= kMaxTrianglesPerLeaf || (extent.x <= 0.f && extent.y <= 0.f && extent.z <= 0.f))
+            {
+                mNodes[item.nodeIndex].offset = item.begin;
+                mNodes[item.nodeIndex].triangleCount = count;
+                continue;
+            }
+
+            uint32_t axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+            uint32_t mid = item.begin + count / 2;
+            std::nth_element(order.begin() + item.begin, order.begin() + mid, order.begin() + item.end,
+                [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+            uint32_t childIndex = (uint32_t)mNodes.size();
+            mNodes[item.nodeIndex].offset = childIndex;
+            mNodes.emplace_back();
+            mNodes.emplace_back();
+            stack.push_back({ childIndex, item.begin, mid });
+            stack.push_back({ childIndex + 1, mid, item.end });
+        }
+
+        // Store the triangles in leaf order.
+        std::vector<Triangle> triangles(mTriangles.size());
+        for (size_t i = 0; i < order.size(); i++) triangles[i] = mTriangles[order[i]];
+        mTriangles = std::move(triangles);
+    }
+
+    float SDFMeshGenerator::findSignedDistance(const float3& p, float maxDistance) const
+    {
+        if (mNodes.empty()) return maxDistance;
+
+        float bestDistanceSquared = maxDistance * maxDistance;
+        const Triangle* pBestTriangle = nullptr;
+        Feature bestFeature = Feature::Face;
+        float3 bestPoint;
+
+        uint32_t stack[kMaxTraversalDepth];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0)
+        {
+            const Node& node = mNodes[stack[--stackSize]];
+            if (distanceSquaredToBox(p, node.bounds) >= bestDistanceSquared) continue;
+
+            if (node.triangleCount > 0)
+            {
+                for (uint32_t t = node.offset; t < node.offset + node.triangleCount; t++)
+                {
+                    const Triangle& triangle = mTriangles[t];
+                    Feature feature;
+                    float3 closest = closestPointOnTriangle(p, triangle.vertices[0], triangle.vertices[1], triangle.vertices[2], feature);
+                    float3 d = p - closest;
+                    float distanceSquared = dot(d, d);
+                    if (distanceSquared < bestDistanceSquared)
+                    {
+                        bestDistanceSquared = distanceSquared;
+                        pBestTriangle = &triangle;
+                        bestFeature = feature;
+                        bestPoint = closest;
+                    }
+                }
+            }
+            else
+            {
+                // Visit the closer child first.
+                float distance0 = distanceSquaredToBox(p, mNodes[node.offset].bounds);
+                float distance1 = distanceSquaredToBox(p, mNodes[node.offset + 1].bounds);
+                uint32_t first = distance0 <= distance1 ? node.offset : node.offset + 1;
+                uint32_t second = distance0 <= distance1 ? node.offset + 1 : node.offset;
+                FALCOR_ASSERT(stackSize + 2 <= kMaxTraversalDepth);
+                if (std::max(distance0, distance1) < bestDistanceSquared) stack[stackSize++] = second;
+                if (std::min(distance0, distance1) < bestDistanceSquared) stack[stackSize++] = first;
+            }
+        }
+
+        if (!pBestTriangle) return maxDistance;
+
+        float3 normal;
+        switch (bestFeature)
+        {
+        case Feature::Vertex0: normal = pBestTriangle->vertexNormals[0]; break;
+        case Feature::Vertex1: normal = pBestTriangle->vertexNormals[1]; break;
+        case Feature::Vertex2: normal = pBestTriangle->vertexNormals[2]; break;
+        case Feature::Edge01: normal = pBestTriangle->edgeNormals[0]; break;
+        case Feature::Edge12: normal = pBestTriangle->edgeNormals[1]; break;
+        case Feature::Edge20: normal = pBestTriangle->edgeNormals[2]; break;
+        default: normal = pBestTriangle->faceNormal; break;
+        }
+
+        float distance = std::sqrt(bestDistanceSquared);
+        return dot(p - bestPoint, normal) < 0.f ? -distance : distance;
+    }
+}
@@ -0,0 +1,125 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Utils/Math/AABB.h"
+#include "Utils/Math/Vector.h"
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Generates SDF grid values from a triangle mesh on the CPU.
+
+        Distances are only computed in a narrow band around the surface, where a BVH over the triangles is used to find the closest triangle.
+        The grid corners are grouped into bricks of kBrickWidth^3 values, and only bricks that overlap the narrow band are evaluated.
+        Inside the narrow band, the sign is given by the angle-weighted pseudo normal of the closest feature (Baerentzen and Aanaes 2005).
+        The sign of the remaining bricks is propagated from the narrow band by parallel sweeps over the brick grid.
+
+        The mesh is expected to be closed and to have counter-clockwise front faces, duplicated vertices are welded by position.
+    */
+    class FALCOR_API SDFMeshGenerator
+    {
+    public:
+        static constexpr uint32_t kBrickWidth = 8;
+        static constexpr uint32_t kBrickValueCount = kBrickWidth * kBrickWidth * kBrickWidth;
+
+        /** Signed distance values in a narrow band around the surface.
+        */
+        struct NarrowBand
+        {
+            static constexpr uint32_t kInsideBrick = 0xfffffffe;    ///< Brick slot of a brick that is entirely inside the surface.
+            static constexpr uint32_t kOutsideBrick = 0xffffffff;   ///< Brick slot of a brick that is entirely outside the surface.
+
+            uint32_t gridWidth = 0;                 ///< Grid width in voxels, the grid has (gridWidth + 1)^3 corner values.
+            float bandWidth = 0.f;                  ///< Width of the narrow band in grid local space. Values are clamped to [-bandWidth, bandWidth].
+            uint3 brickGridDim = uint3(0);          ///< Number of bricks along each axis.
+            std::vector<uint32_t> brickSlots;       ///< Slot in brickValues of each brick in the brick grid, or kInsideBrick/kOutsideBrick.
+            std::vector<float> brickValues;         ///< kBrickValueCount values per brick in the narrow band, x varies fastest.
+
+            /** Returns the number of bricks in the narrow band.
+            */
+            uint32_t getBrickCount() const { return uint32_t(brickValues.size() / kBrickValueCount); }
+
+            /** Returns the value at a grid corner.
+            */
+            float getValue(uint3 corner) const;
+
+            /** Expands the narrow band to the dense layout expected by SDFGrid::setValues().
+                \return (gridWidth + 1)^3 corner values.
+            */
+            std::vector<float> toDense() const;
+
+            /** Expands the narrow band to dense snorm8 values, quantized in the same way as SDFGridFile::quantize().
+                This needs a quarter of the memory of toDense() and the result can be moved into the sparse grid types.
+                \param[in] normalizationWidth Distance represented by a normalized value of 1.
+                \return (gridWidth + 1)^3 normalized corner values.
+            */
+            std::vector<int8_t> toNormalized(float normalizationWidth) const;
+        };
+
+        /** Create a generator for a triangle mesh.
+            \param[in] positions Vertex positions in the local space of the SDF grid, i.e., [-0.5, 0.5]^3.
+            \param[in] indices Vertex indices, three per triangle.
+        */
+        SDFMeshGenerator(const std::vector<float3>& positions, const std::vector<uint32_t>& indices);
+
+        /** Compute the signed distances at the corners of a grid.
+            \param[in] gridWidth Grid width in voxels.
+            \param[in] bandWidth Width of the narrow band in grid local space. The band is at least two voxels wide.
+            \return Values in the narrow band.
+        */
+        NarrowBand generate(uint32_t gridWidth, float bandWidth) const;
+
+        /** Returns the number of non-degenerate triangles.
+        */
+        uint32_t getTriangleCount() const { return (uint32_t)mTriangles.size(); }
+
+    private:
+        struct Triangle
+        {
+            float3 vertices[3];
+            float3 faceNormal;
+            float3 edgeNormals[3];      ///< Pseudo normals of the edges (v0,v1), (v1,v2) and (v2,v0).
+            float3 vertexNormals[3];    ///< Angle-weighted pseudo normals of the vertices.
+        };
+
+        struct Node
+        {
+            AABB bounds;
+            uint32_t offset = 0;        ///< Index of the first triangle for leaves, or of the first of two consecutive children.
+            uint32_t triangleCount = 0; ///< Number of triangles for leaves, zero for interior nodes.
+        };
+
+        void buildBVH();
+        float findSignedDistance(const float3& p, float maxDistance) const;
+
+        std::vector<Triangle> mTriangles;
+        std::vector<Node> mNodes;
+    };
+}
@@ -29,10 +29,13 @@
 #include "Core/API/Device.h"
 #include "Core/API/RenderContext.h"
 #include "Core/API/IndirectCommands.h"
+#include "Utils/TaskManager.h"
 #include "Utils/Math/MathHelpers.h"
 #include "Utils/Math/MathConstants.slangh"
 #include "Utils/SharedCache.h"
 #include "Scene/SDFs/SDFVoxelTypes.slang"
+#include <algorithm>
+#include <cstring>
 
 namespace Falcor
 {
@@ -56,6 +59,104 @@ namespace Falcor
 
         // Chunk width must be equal to 4 for now.
         const uint32_t kChunkWidth = 4;
+
+        // BC4 compression of 4x4 blocks of snorm8 values, this must match BC4Encode.slang.
+        const uint32_t kCompressionWidth = 4;
+
+        void fixRange(int& minValue, int& maxValue, int steps)
+        {
+            if (maxValue - minValue < steps)
+            {
+                maxValue = std::min(minValue + steps, 127);
+                minValue = maxValue - minValue < steps ? std::max(-128, maxValue - steps) : minValue;
+            }
+        }
+
+        int fitCodes(const int block[16], const int codes[8], uint32_t indices[16])
+        {
+            int err = 0;
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                int least = INT32_MAX;
+                uint32_t index = 0;
+                for (uint32_t j = 0; j < 8; j++)
+                {
+                    int dist = block[i] - codes[j];
+                    dist *= dist;
+                    if (dist < least)
+                    {
+                        least = dist;
+                        index = j;
+                    }
+                }
+                indices[i] = index;
+                err += least;
+            }
+            return err;
+        }
+
+        uint64_t writeAlphaBlock(int alpha0, int alpha1, const uint32_t indices[16])
+        {
+            uint64_t compressedBlock = uint64_t(alpha0 & 0xff) | (uint64_t(alpha1 & 0xff) << 8);
+            for (uint32_t i = 0; i < 16; i++) compressedBlock |= uint64_t(indices[i] & 0x7) << (3 * (i % 8) + 24 * (i / 8) + 16);
+            return compressedBlock;
+        }
+
+        uint64_t compressBlock(const int block[16])
+        {
+            // Get the range for 5-alpha and 7-alpha interpolation.
+            int min5 = 127;
+            int max5 = -128;
+            int min7 = 127;
+            int max7 = -128;
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                min7 = std::min(block[i], min7);
+                max7 = std::max(block[i], max7);
+                if (block[i] != -128 && block[i] < min5) min5 = block[i];
+                if (block[i] != 127 && block[i] > max5) max5 = block[i];
+            }
+
+            min5 = std::min(min5, max5);
+            min7 = std::min(min7, max7);
+
+            fixRange(min5, max5, 5);
+            fixRange(min7, max7, 7);
+
+            int codes5[8] = { min5, max5, 0, 0, 0, 0, -128, 127 };
+            for (int i = 1; i < 5; i++) codes5[1 + i] = ((5 - i) * min5 + i * max5) / 5;
+
+            int codes7[8] = { min7, max7 };
+            for (int i = 1; i < 7; i++) codes7[1 + i] = ((7 - i) * min7 + i * max7) / 7;
+
+            uint32_t indices5[16];
+            uint32_t indices7[16];
+            int err5 = fitCodes(block, codes5, indices5);
+            int err7 = fitCodes(block, codes7, indices7);
+
+            // Write the block with the least error, swapping the endpoints to select the 5-alpha or 7-alpha mode.
+            uint32_t swappedIndices[16];
+            if (err5 <= err7)
+            {
+                if (min5 <= max5) return writeAlphaBlock(min5, max5, indices5);
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    uint32_t index = indices5[i];
+                    swappedIndices[i] = index == 0 ? 1 : (index == 1 ? 0 : (index <= 5 ? 7 - index : index));
+                }
+                return writeAlphaBlock(max5, min5, swappedIndices);
+            }
+            else
+            {
+                if (min7 >= max7) return writeAlphaBlock(min7, max7, indices7);
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    uint32_t index = indices7[i];
+                    swappedIndices[i] = index == 0 ? 1 : (index == 1 ? 0 : 9 - index);
+                }
+                return writeAlphaBlock(max7, min7, swappedIndices);
+            }
+        }
     }
 
     struct SDFSBS::SharedData
@@ -129,7 +230,8 @@ namespace Falcor
         }
         else if (mPrimitives.empty() && mpSDFGridTexture != nullptr)
         {
-            createResourcesFromSDField(pRenderContext, deleteScratchData);
+            if (mHasCPUBricks) createResourcesFromCPUBricks();
+            else createResourcesFromSDField(pRenderContext, deleteScratchData);
         }
         else
         {
@@ -354,6 +456,153 @@ namespace Falcor
         mWasEmpty = false;
     }
 
+    void SDFSBS::createResourcesFromCPUBricks()
+    {
+        FALCOR_ASSERT(mHasCPUBricks);
+
+        mVirtualBricksPerAxis = mCPUBricks.virtualBricksPerAxis;
+        mBrickCount = mCPUBricks.brickCount;
+        mBricksPerAxis = mCPUBricks.bricksPerAxis;
+        mBrickTextureDimensions = mCPUBricks.brickTextureDimensions;
+
+        mpIndirectionTexture = mpDevice->createTexture3D(mVirtualBricksPerAxis, mVirtualBricksPerAxis, mVirtualBricksPerAxis, ResourceFormat::R32Uint, 1, mCPUBricks.indirection.data(), ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess);
+        mpIndirectionTexture->setName("SDFSBS::IndirectionTextureValues");
+
+        if (mCompressed)
+        {
+            mpBrickTexture = mpDevice->createTexture2D(mBrickTextureDimensions.x, mBrickTextureDimensions.y, ResourceFormat::BC4Snorm, 1, 1, mCPUBricks.brickTexture.data());
+        }
+        else
+        {
+            mpBrickTexture = mpDevice->createTexture2D(mBrickTextureDimensions.x, mBrickTextureDimensions.y, ResourceFormat::R8Snorm, 1, 1, mCPUBricks.brickTexture.data(), ResourceBindFlags::UnorderedAccess | ResourceBindFlags::ShaderResource);
+        }
+
+        mpBrickAABBsBuffer = mpDevice->createStructuredBuffer(sizeof(AABB), mBrickCount, ResourceBindFlags::UnorderedAccess | ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, mCPUBricks.brickAABBs.data(), false);
+
+        mCPUBricks = {};
+        mHasCPUBricks = false;
+        mWasEmpty = false;
+    }
+
+    void SDFSBS::buildBricksOnCPU()
+    {
+        FALCOR_CHECK(mPrimitives.empty(), "SDFSBS::buildBricksOnCPU() does not support grids with primitives.");
+
+        const uint32_t gridWidthInValues = mGridWidth + 1;
+        FALCOR_CHECK(mSDField.size() == size_t(gridWidthInValues) * gridWidthInValues * gridWidthInValues, "SDFSBS::buildBricksOnCPU() requires the grid values to be set.");
+
+        // Values are read through an R8Snorm texture on the GPU, which maps -128 to -1.
+        auto getValue = [&](uint3 coords) { return std::max(int(mSDField[coords.x + gridWidthInValues * (coords.y + size_t(gridWidthInValues) * coords.z)]), -INT8_MAX); };
+
+        CPUBricks& bricks = mCPUBricks;
+        bricks.virtualBricksPerAxis = (uint32_t)std::ceil(float(mGridWidth) / mBrickWidth);
+        const uint32_t virtualBricksPerAxis = bricks.virtualBricksPerAxis;
+        const uint32_t virtualBrickCount = virtualBricksPerAxis * virtualBricksPerAxis * virtualBricksPerAxis;
+
+        auto getVirtualBrickCoords = [&](uint32_t virtualBrickID)
+        {
+            return uint3(virtualBrickID % virtualBricksPerAxis, (virtualBrickID / virtualBricksPerAxis) % virtualBricksPerAxis, virtualBrickID / (virtualBricksPerAxis * virtualBricksPerAxis));
+        };
+
+        // A brick is valid if any of its voxels contains the surface.
+        std::vector<uint32_t> brickValidity(virtualBrickCount);
+        parallelFor(0, virtualBrickCount, [&](uint32_t virtualBrickID)
+        {
+            uint3 voxelMin = getVirtualBrickCoords(virtualBrickID) * mBrickWidth;
+            uint3 voxelMax = min(voxelMin + mBrickWidth, uint3(mGridWidth));
+
+            for (uint32_t z = voxelMin.z; z < voxelMax.z; z++)
+            {
+                for (uint32_t y = voxelMin.y; y < voxelMax.y; y++)
+                {
+                    for (uint32_t x = voxelMin.x; x < voxelMax.x; x++)
+                    {
+                        bool hasNegative = false;
+                        bool hasPositive = false;
+                        for (uint32_t i = 0; i < 8; i++)
+                        {
+                            int value = getValue(uint3(x + ((i >> 2) & 1), y + ((i >> 1) & 1), z + (i & 1)));
+                            hasNegative |= value <= 0;
+                            hasPositive |= value >= 0;
+                        }
+
+                        if (hasNegative && hasPositive)
+                        {
+                            brickValidity[virtualBrickID] = 1;
+                            return;
+                        }
+                    }
+                }
+            }
+        });
+
+        // Assign brick IDs to the valid bricks in order.
+        bricks.indirection.resize(virtualBrickCount);
+        bricks.brickCount = parallelExclusiveScan(brickValidity.begin(), brickValidity.end(), bricks.indirection.begin(), 0u);
+        for (uint32_t virtualBrickID = 0; virtualBrickID < virtualBrickCount; virtualBrickID++)
+        {
+            if (!brickValidity[virtualBrickID]) bricks.indirection[virtualBrickID] = UINT32_MAX;
+        }
+
+        // Lay out the bricks in a roughly square texture, see createResourcesFromSDField().
+        const uint32_t brickWidthInValues = mBrickWidth + 1;
+        uint32_t bricksAlongX = (uint32_t)std::ceil(std::sqrt((float)bricks.brickCount / brickWidthInValues));
+        uint32_t bricksAlongY = bricksAlongX > 0 ? (uint32_t)std::ceil((float)bricks.brickCount / bricksAlongX) : 0;
+        bricks.bricksPerAxis = uint2(bricksAlongX, bricksAlongY);
+        bricks.brickTextureDimensions = uint2(brickWidthInValues * brickWidthInValues * bricksAlongX, brickWidthInValues * bricksAlongY);
+        if (mCompressed) bricks.brickTextureDimensions = (bricks.brickTextureDimensions + (kCompressionWidth - 1)) / kCompressionWidth * kCompressionWidth;
+
+        const uint2 blockDimensions = bricks.brickTextureDimensions / kCompressionWidth;
+        bricks.brickAABBs.resize(bricks.brickCount);
+        bricks.brickTexture.assign(mCompressed ? size_t(blockDimensions.x) * blockDimensions.y * sizeof(uint64_t) : size_t(bricks.brickTextureDimensions.x) * bricks.brickTextureDimensions.y, 0);
+
+        // Write the brick AABBs and values, values outside of the grid are set to the maximum distance.
+        const float oneOverGridWidth = 1.0f / float(mGridWidth);
+        parallelFor(0, virtualBrickCount, [&](uint32_t virtualBrickID)
+        {
+            uint32_t brickID = bricks.indirection[virtualBrickID];
+            if (brickID == UINT32_MAX) return;
+
+            uint3 brickGridCoords = getVirtualBrickCoords(virtualBrickID) * mBrickWidth;
+            float3 brickAABBMin = -0.5f + float3(brickGridCoords) * oneOverGridWidth;
+            float3 brickAABBMax = min(brickAABBMin + float(mBrickWidth) * oneOverGridWidth, float3(0.5f));
+            bricks.brickAABBs[brickID] = AABB(brickAABBMin, brickAABBMax);
+
+            uint2 brickTextureCoords = uint2(brickID % bricksAlongX, brickID / bricksAlongX) * uint2(brickWidthInValues * brickWidthInValues, brickWidthInValues);
+            auto getBrickValue = [&](uint3 coords) { return all(coords < uint3(mGridWidth)) ? getValue(coords) : INT8_MAX; };
+
+            for (uint32_t z = 0; z < brickWidthInValues; z++)
+            {
+                if (mCompressed)
+                {
+                    for (uint32_t y = 0; y < brickWidthInValues; y += kCompressionWidth)
+                    {
+                        for (uint32_t x = 0; x < brickWidthInValues; x += kCompressionWidth)
+                        {
+                            int block[16];
+                            for (uint32_t i = 0; i < 16; i++) block[i] = getBrickValue(brickGridCoords + uint3(x + i % 4, y + i / 4, z));
+
+                            uint2 blockCoords = (brickTextureCoords + uint2(x + z * brickWidthInValues, y)) / kCompressionWidth;
+                            uint64_t compressedBlock = compressBlock(block);
+                            std::memcpy(&bricks.brickTexture[(blockCoords.x + size_t(blockDimensions.x) * blockCoords.y) * sizeof(uint64_t)], &compressedBlock, sizeof(uint64_t));
+                        }
+                    }
+                }
+                else
+                {
+                    for (uint32_t y = 0; y < brickWidthInValues; y++)
+                    {
+                        uint2 texelCoords = brickTextureCoords + uint2(z * brickWidthInValues, y);
+                        uint8_t* pRow = &bricks.brickTexture[texelCoords.x + size_t(bricks.brickTextureDimensions.x) * texelCoords.y];
+                        for (uint32_t x = 0; x < brickWidthInValues; x++) pRow[x] = uint8_t(getBrickValue(brickGridCoords + uint3(x, y, z)));
+                    }
+                }
+            }
+        });
+
+        mHasCPUBricks = true;
+    }
+
     SDFGrid::UpdateFlags SDFSBS::createResourcesFromPrimitivesAndSDField(RenderContext* pRenderContext, bool deleteScratchData)
     {
         // Assume AABBs will change.
@@ -977,6 +1226,8 @@ namespace Falcor
         uint32_t gridWidthInValues = mGridWidth + 1;
         uint32_t valueCount = gridWidthInValues * gridWidthInValues * gridWidthInValues;
         mSDField.resize(valueCount);
+        mCPUBricks = {};
+        mHasCPUBricks = false;
 
         // The grid is in the size [-1, 1] thus the longest distance that can be stored is sqrt(3) (the length from corner to corner)
         float normalizationFactor = 2.0f * mGridWidth / float(M_SQRT3);
@@ -988,6 +1239,13 @@ namespace Falcor
         }
     }
 
+    void SDFSBS::setNormalizedValuesInternal(std::vector<int8_t>&& normalizedValues)
+    {
+        mSDField = std::move(normalizedValues);
+        mCPUBricks = {};
+        mHasCPUBricks = false;
+    }
+
     void SDFSBS::createSDFGridTexture(RenderContext* pRenderContext, const std::vector<int8_t>& sdField)
     {
         FALCOR_CHECK(!sdField.empty(), "Cannot create SDF grid texture from empty values vector");
@@ -30,6 +30,7 @@
 #include "Core/Pass/ComputePass.h"
 #include "Scene/SDFs/SDFGrid.h"
 #include "Utils/Algorithm/PrefixSum.h"
+#include "Utils/Math/AABB.h"
 
 namespace Falcor
 {
@@ -40,6 +41,19 @@ namespace Falcor
     public:
         struct SharedData;
 
+        /** Bricks built on the CPU from the grid values, holding the contents of the GPU resources created by createResources().
+        */
+        struct CPUBricks
+        {
+            uint32_t virtualBricksPerAxis = 0;
+            uint32_t brickCount = 0;
+            uint2 bricksPerAxis = uint2(0);
+            uint2 brickTextureDimensions = uint2(0);
+            std::vector<uint32_t> indirection;      ///< Brick ID of each virtual brick, UINT32_MAX for empty virtual bricks.
+            std::vector<AABB> brickAABBs;           ///< AABB of each brick.
+            std::vector<uint8_t> brickTexture;      ///< Brick texture, R8Snorm texels or BC4 blocks if the bricks are compressed.
+        };
+
         static ref<SDFSBS> create(ref<Device> pDevice, uint32_t brickWidth = 7, bool compressed = false, uint32_t defaultGridWidth = 256) { return make_ref<SDFSBS>(pDevice, brickWidth, compressed, defaultGridWidth); }
 
         /** Create an empty SDF sparse brick set.
@@ -69,8 +83,21 @@ namespace Falcor
         virtual float getResolutionScalingFactor() const override { return mResolutionScalingFactor; };
         virtual void resetResolutionScalingFactor() override { mResolutionScalingFactor = 1.0f; };
 
+        /** Build the bricks on the CPU from the grid values. Grids with primitives are built on the GPU.
+            The bricks are identical to the ones built on the GPU, and createResources() uploads them instead of building them on the GPU.
+        */
+        void buildBricksOnCPU();
+
+        /** Get the bricks built by buildBricksOnCPU(). The CPU copy is released when the bricks are uploaded by createResources().
+        */
+        const CPUBricks& getCPUBricks() const { return mCPUBricks; }
+
+        const ref<Texture>& getIndirectionTexture() const { return mpIndirectionTexture; }
+        const ref<Texture>& getBrickTexture() const { return mpBrickTexture; }
+
     protected:
         void createResourcesFromSDField(RenderContext* pRenderContext, bool deleteScratchData);
+        void createResourcesFromCPUBricks();
         SDFGrid::UpdateFlags createResourcesFromPrimitivesAndSDField(RenderContext* pRenderContext, bool deleteScratchData);
 
         void expandSDFGridTexture(RenderContext* pRenderContext, bool deleteScratchData, uint32_t oldGridWidthInSDField, uint32_t gridWidthInSDField);
@@ -79,6 +106,7 @@ namespace Falcor
         void allocatePrimitiveBits();
 
         virtual void setValuesInternal(const std::vector<float>& cornerValues) override;
+        virtual void setNormalizedValuesInternal(std::vector<int8_t>&& normalizedValues) override;
 
         void createSDFGridTexture(RenderContext* pRenderContext, const std::vector<int8_t>& sdField);
 
@@ -89,6 +117,8 @@ namespace Falcor
     private:
         // CPU data.
         std::vector<int8_t> mSDField;
+        CPUBricks mCPUBricks;                           ///< Bricks built on the CPU, uploaded by createResources().
+        bool mHasCPUBricks = false;                     ///< True if mCPUBricks holds the bricks of the current values.
 
         // Specs.
         uint32_t mDefaultGridWidth = 0;                 ///< The grid width used if the grid was not loaded from a file (it is empty).
@@ -155,5 +185,7 @@ namespace Falcor
         ref<Texture> mpSDFGridTextureModified;
         std::vector<ref<Texture>> mIntervalSDFieldMaps;
         ref<Buffer> mpCountStagingBuffer;
+
+        friend class SceneCache;
     };
 }
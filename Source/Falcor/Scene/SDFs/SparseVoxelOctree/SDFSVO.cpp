@@ -28,10 +28,12 @@
 #include "SDFSVO.h"
 #include "Core/API/Device.h"
 #include "Core/API/RenderContext.h"
+#include "Utils/TaskManager.h"
 #include "Utils/Math/MathHelpers.h"
 #include "Utils/Math/MathConstants.slangh"
 #include "Utils/SharedCache.h"
 #include "Scene/SDFs/SDFVoxelTypes.slang"
+#include <algorithm>
 
 namespace Falcor
 {
@@ -55,6 +57,56 @@ namespace Falcor
             v |= v >> 16;
             return ++v;
         }
+
+        // These must match SDFVoxelCommon.
+        const uint32_t kMaxLevel = 19;
+        const uint32_t kLocationCodeLevelOffset = 3 * kMaxLevel;
+
+        /** Spreads the low 21 bits of x to every third bit, see SDFVoxelCommon::shiftCoord().
+        */
+        uint64_t shiftCoord(uint32_t x)
+        {
+            uint64_t y = uint64_t(x);
+            y = (y | y << 32) & 0x1f00000000ffffull;
+            y = (y | y << 16) & 0x1f0000ff0000ffull;
+            y = (y | y << 8) & 0x100f00f00f00f00full;
+            y = (y | y << 4) & 0x10c30c30c30c30c3ull;
+            y = (y | y << 2) & 0x1249249249249249ull;
+            return y;
+        }
+
+        /** Compacts every third bit of x into the low 21 bits, see SDFVoxelCommon::unshiftCoord().
+        */
+        uint32_t unshiftCoord(uint64_t x)
+        {
+            uint64_t y = x & 0x1249249249249249ull;
+            y = (y | (y >> 2)) & 0x10c30c30c30c30c3ull;
+            y = (y | (y >> 4)) & 0x100f00f00f00f00full;
+            y = (y | (y >> 8)) & 0x1f0000ff0000ffull;
+            y = (y | (y >> 16)) & 0x1f00000000ffffull;
+            y = (y | (y >> 32)) & 0x1fffffull;
+            return uint32_t(y);
+        }
+
+        /** Morton code of level local voxel coordinates, interleaved in the same order as location codes.
+        */
+        uint64_t encodeMorton(uint32_t x, uint32_t y, uint32_t z)
+        {
+            return (shiftCoord(x) << 2) | (shiftCoord(y) << 1) | shiftCoord(z);
+        }
+
+        uint3 decodeMorton(uint64_t code)
+        {
+            return uint3(unshiftCoord(code >> 2), unshiftCoord(code >> 1), unshiftCoord(code));
+        }
+
+        /** Location code with the valid bit set, see SDFVoxelCommon::encodeLocation().
+        */
+        uint2 encodeLocationCode(uint64_t morton, uint32_t level)
+        {
+            uint64_t locationCode = (1ull << 63) | (uint64_t(level) << kLocationCodeLevelOffset) | (morton << (3 * (kMaxLevel - level)));
+            return uint2(uint32_t(locationCode), uint32_t(locationCode >> 32));
+        }
     }
 
     struct SDFSVO::SharedData
@@ -97,6 +149,17 @@ namespace Falcor
             FALCOR_THROW("An SDFSVO instance cannot be created from primitives!");
         }
 
+        // Upload the octree if it was built on the CPU.
+        if (mHasCPUOctree)
+        {
+            mSVOElementCount = (uint32_t)mCPUOctree.size();
+            mpSVOBuffer = mpDevice->createBuffer(mSVOElementCount * sizeof(SDFSVOVoxel), ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess, MemoryType::DeviceLocal, mCPUOctree.data());
+
+            mCPUOctree = {};
+            mHasCPUOctree = false;
+            return;
+        }
+
         // Create source grid texture to read from.
         if (mpSDFGridTexture && mpSDFGridTexture->getWidth() == mGridWidth + 1)
         {
@@ -392,6 +455,113 @@ namespace Falcor
         }
     }
 
+    void SDFSVO::buildOctreeOnCPU()
+    {
+        if (!mPrimitives.empty())
+        {
+            FALCOR_THROW("An SDFSVO instance cannot be created from primitives!");
+        }
+
+        const uint32_t gridWidthInValues = mGridWidth + 1;
+        FALCOR_CHECK(mValues.size() == size_t(gridWidthInValues) * gridWidthInValues * gridWidthInValues, "SDFSVO::buildOctreeOnCPU() requires the grid values to be set.");
+
+        // Returns the packed corner values of a voxel, see SDFVoxelCommon::packValues().
+        auto packValues = [&](uint3 gridCoords, uint32_t voxelWidth, bool& containsSurface)
+        {
+            uint64_t packedValues = 0;
+            bool hasNegative = false;
+            bool hasPositive = false;
+            for (uint32_t i = 0; i < 8; i++)
+            {
+                uint3 cornerCoords = gridCoords + voxelWidth * uint3((i >> 2) & 1, (i >> 1) & 1, i & 1);
+                int8_t value = std::max(mValues[cornerCoords.x + gridWidthInValues * (cornerCoords.y + size_t(gridWidthInValues) * cornerCoords.z)], int8_t(-INT8_MAX));
+                hasNegative |= value <= 0;
+                hasPositive |= value >= 0;
+                packedValues |= uint64_t(uint8_t(value)) << (8 * i);
+            }
+            containsSurface = hasNegative && hasPositive;
+            return uint2(uint32_t(packedValues), uint32_t(packedValues >> 32));
+        };
+
+        // Collect the finest level voxels that contain the surface, one slice at a time.
+        std::vector<std::vector<uint64_t>> levelCodes(mLevelCount);
+        {
+            std::vector<std::vector<uint64_t>> sliceCodes(mGridWidth);
+            parallelFor(0, mGridWidth, [&](uint32_t z)
+            {
+                for (uint32_t y = 0; y < mGridWidth; y++)
+                {
+                    for (uint32_t x = 0; x < mGridWidth; x++)
+                    {
+                        bool containsSurface;
+                        packValues(uint3(x, y, z), 1, containsSurface);
+                        if (containsSurface) sliceCodes[z].push_back(encodeMorton(x, y, z));
+                    }
+                }
+            });
+
+            std::vector<uint64_t>& finestLevelCodes = levelCodes.back();
+            for (const auto& codes : sliceCodes) finestLevelCodes.insert(finestLevelCodes.end(), codes.begin(), codes.end());
+            parallelSort(finestLevelCodes.begin(), finestLevelCodes.end());
+        }
+
+        // Build the coarser levels bottom-up. A voxel exists if any of its children exists, and as the children are sorted
+        // by Morton code the children of a voxel are consecutive and start with its first valid child.
+        std::vector<std::vector<uint32_t>> levelFirstChildren(mLevelCount);
+        for (int32_t l = (int32_t)mLevelCount - 2; l >= 0; l--)
+        {
+            const std::vector<uint64_t>& childCodes = levelCodes[l + 1];
+
+            std::vector<uint32_t> isFirstChild(childCodes.size());
+            std::vector<uint32_t> parentIndices(childCodes.size());
+            parallelFor(0, childCodes.size(), [&](size_t i)
+            {
+                isFirstChild[i] = (i == 0 || (childCodes[i] >> 3) != (childCodes[i - 1] >> 3)) ? 1 : 0;
+            });
+            size_t parentCount = parallelExclusiveScan(isFirstChild.begin(), isFirstChild.end(), parentIndices.begin(), 0u);
+            levelCodes[l].resize(parentCount);
+            levelFirstChildren[l].resize(parentCount);
+            parallelFor(0, childCodes.size(), [&](size_t i)
+            {
+                if (!isFirstChild[i]) return;
+                levelCodes[l][parentIndices[i]] = childCodes[i] >> 3;
+                levelFirstChildren[l][parentIndices[i]] = (uint32_t)i;
+            });
+        }
+
+        // Write the voxels, the octree stores all levels from the root and down.
+        std::vector<uint32_t> levelOffsets(mLevelCount + 1, 0);
+        for (uint32_t l = 0; l < mLevelCount; l++) levelOffsets[l + 1] = levelOffsets[l] + (uint32_t)levelCodes[l].size();
+
+        mCPUOctree.resize(levelOffsets.back());
+        for (uint32_t l = 0; l < mLevelCount; l++)
+        {
+            const uint32_t voxelWidth = 1 << (mLevelCount - l - 1);
+            const std::vector<uint64_t>& codes = levelCodes[l];
+
+            parallelFor(0, codes.size(), [&](size_t i)
+            {
+                SDFSVOVoxel& voxel = mCPUOctree[levelOffsets[l] + i];
+                voxel.locationCode = encodeLocationCode(codes[i], l);
+
+                bool containsSurface;
+                voxel.packedValues = packValues(decodeMorton(codes[i]) * voxelWidth, voxelWidth, containsSurface);
+
+                voxel.relationData = 0;
+                if (l + 1 < mLevelCount)
+                {
+                    const std::vector<uint64_t>& childCodes = levelCodes[l + 1];
+                    uint32_t firstChild = levelFirstChildren[l][i];
+                    uint32_t endChild = i + 1 < codes.size() ? levelFirstChildren[l][i + 1] : (uint32_t)childCodes.size();
+                    for (uint32_t c = firstChild; c < endChild; c++) voxel.relationData |= 1 << (childCodes[c] & 0x7);
+                    voxel.relationData |= (levelOffsets[l + 1] + firstChild) << 8;
+                }
+            });
+        }
+
+        mHasCPUOctree = true;
+    }
+
     const ref<Buffer>& SDFSVO::getAABBBuffer() const
     {
         return mpSharedData->pUnitAABBBuffer;
@@ -413,6 +583,9 @@ namespace Falcor
         uint32_t valueCount = gridWidthInValues * gridWidthInValues * gridWidthInValues;
         mValues.resize(valueCount);
 
+        mCPUOctree = {};
+        mHasCPUOctree = false;
+
         float normalizationMultipler = mGridWidth / (0.5f * float(M_SQRT3));
         for (uint32_t v = 0; v < valueCount; v++)
         {
@@ -422,4 +595,12 @@ namespace Falcor
             mValues[v] = integerScale >= 0.0f ? int8_t(integerScale + 0.5f) : int8_t(integerScale - 0.5f);
         }
     }
+
+    void SDFSVO::setNormalizedValuesInternal(std::vector<int8_t>&& normalizedValues)
+    {
+        mLevelCount = bitScanReverse(mGridWidth) + 1;
+        mValues = std::move(normalizedValues);
+        mCPUOctree = {};
+        mHasCPUOctree = false;
+    }
 }
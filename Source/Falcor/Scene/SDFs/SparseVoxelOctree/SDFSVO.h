@@ -28,6 +28,7 @@
 #pragma once
 
 #include "Scene/SDFs/SDFGrid.h"
+#include "Scene/SDFs/SDFVoxelTypes.slang"
 #include "Core/API/Buffer.h"
 #include "Core/API/Texture.h"
 #include "Core/Pass/ComputePass.h"
@@ -60,12 +61,29 @@ namespace Falcor
 
         virtual void bindShaderData(const ShaderVar& var) const override;
 
+        /** Build the octree on the CPU from the grid values.
+            The octree is identical to the one built on the GPU, and createResources() uploads it instead of building it on the GPU.
+        */
+        void buildOctreeOnCPU();
+
+        /** Get the octree built by buildOctreeOnCPU(). Voxels are sorted by level and then by Morton code.
+            The CPU copy is released when the octree is uploaded by createResources().
+        */
+        const std::vector<SDFSVOVoxel>& getCPUOctree() const { return mCPUOctree; }
+
+        /** Get the buffer holding the octree on the GPU, valid after createResources() has been called.
+        */
+        const ref<Buffer>& getSVOBuffer() const { return mpSVOBuffer; }
+
     protected:
         virtual void setValuesInternal(const std::vector<float>& cornerValues) override;
+        virtual void setNormalizedValuesInternal(std::vector<int8_t>&& normalizedValues) override;
 
     private:
         // CPU data.
         std::vector<int8_t> mValues;
+        std::vector<SDFSVOVoxel> mCPUOctree;        ///< Octree built on the CPU, uploaded by createResources().
+        bool mHasCPUOctree = false;                 ///< True if mCPUOctree holds the octree of the current values.
 
         // Specs.
         uint32_t mLevelCount = 0;
@@ -94,5 +112,7 @@ namespace Falcor
         ref<Buffer> mpHashTableBuffer;
         ref<Buffer> mpLocationCodesBuffer;
         ref<Fence> mpReadbackFence;
+
+        friend class SceneCache;
     };
 }
@@ -174,4 +174,9 @@ namespace Falcor
             mValues[v] = integerScale >= 0.0f ? int8_t(integerScale + 0.5f) : int8_t(integerScale - 0.5f);
         }
     }
+
+    void SDFSVS::setNormalizedValuesInternal(std::vector<int8_t>&& normalizedValues)
+    {
+        mValues = std::move(normalizedValues);
+    }
 }
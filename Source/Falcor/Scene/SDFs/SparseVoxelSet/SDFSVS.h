@@ -57,6 +57,7 @@ namespace Falcor
 
     protected:
         virtual void setValuesInternal(const std::vector<float>& cornerValues) override;
+        virtual void setNormalizedValuesInternal(std::vector<int8_t>&& normalizedValues) override;
 
     private:
         // CPU data.
@@ -74,5 +75,7 @@ namespace Falcor
         // Scratch data used for building.
         ref<Buffer> mpSurfaceVoxelCounter;
         ref<Texture> mpSDFGridTexture;
+
+        friend class SceneCache;
     };
 }
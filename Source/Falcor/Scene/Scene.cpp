@@ -47,13 +47,12 @@
 #include "Utils/Timing/Profiler.h"
 #include "Utils/UI/InputTypes.h"
 #include "Utils/Scripting/ScriptWriter.h"
-#include "Utils/NumericRange.h"
+#include "Utils/TaskManager.h"
 
 #include <fstream>
 #include <numeric>
 #include <sstream>
 #include <algorithm>
-#include <execution>
 
 namespace Falcor
 {
@@ -248,6 +247,8 @@ namespace Falcor
         for (const auto &mesh : sceneData.cachedMeshes)
         {
             if (!mMeshDesc[mesh.meshID.get()].isAnimated()) FALCOR_THROW("Cached Mesh Animation: Referenced mesh ID is not dynamic");
+            // Streamed caches are validated against their vertex cache file when it is opened.
+            if (!mesh.streamPath.empty()) continue;
             if (mesh.timeSamples.size() != mesh.vertexData.size()) FALCOR_THROW("Cached Mesh Animation: Time sample count mismatch.");
             for (const auto &vertices : mesh.vertexData)
             {
@@ -628,8 +629,7 @@ namespace Falcor
                 result.push_back(largeTriangleTile);
         };
 
-        auto range = NumericRange<size_t>(0, meshDescs.size());
-        std::for_each(std::execution::par_unseq, range.begin(), range.end(), processMeshTile);
+        parallelFor(0, meshDescs.size(), processMeshTile);
     }
 
     void Scene::setSDFGridConfig()
@@ -853,43 +853,89 @@ namespace Falcor
             getCamera()->bindShaderData(mpSceneBlock->getRootVar()[kCamera]);
     }
 
-    void Scene::updateBounds()
+    void Scene::createNodeInstanceMap()
+    {
+        // Group the geometry instances by the scene graph node holding their transform.
+        const size_t nodeCount = mSceneGraph.size();
+        mNodeInstanceOffsets.assign(nodeCount + 1, 0);
+        for (const auto& inst : mGeometryInstanceData)
+        {
+            FALCOR_ASSERT(inst.globalMatrixID < nodeCount);
+            mNodeInstanceOffsets[inst.globalMatrixID + 1]++;
+        }
+        for (size_t i = 0; i < nodeCount; i++) mNodeInstanceOffsets[i + 1] += mNodeInstanceOffsets[i];
+
+        std::vector<uint32_t> cursors(mNodeInstanceOffsets.begin(), mNodeInstanceOffsets.end() - 1);
+        mNodeInstances.resize(mGeometryInstanceData.size());
+        for (uint32_t instanceID = 0; instanceID < (uint32_t)mGeometryInstanceData.size(); instanceID++)
+        {
+            mNodeInstances[cursors[mGeometryInstanceData[instanceID].globalMatrixID]++] = instanceID;
+        }
+    }
+
+    bool Scene::findMovedGeometryInstances()
+    {
+        mMovedGeometryInstances.clear();
+        mAllGeometryInstancesMoved = mpAnimationController->areAllMatricesChanged();
+        if (mAllGeometryInstancesMoved) return !mGeometryInstanceData.empty();
+
+        // Each instance belongs to a single node and the changed nodes are unique, so the list has no duplicates.
+        for (uint32_t nodeID : mpAnimationController->getChangedNodes())
+        {
+            FALCOR_ASSERT(nodeID + 1 < mNodeInstanceOffsets.size());
+            mMovedGeometryInstances.insert(mMovedGeometryInstances.end(),
+                mNodeInstances.begin() + mNodeInstanceOffsets[nodeID], mNodeInstances.begin() + mNodeInstanceOffsets[nodeID + 1]);
+        }
+        std::sort(mMovedGeometryInstances.begin(), mMovedGeometryInstances.end());
+
+        return !mMovedGeometryInstances.empty();
+    }
+
+    AABB Scene::computeInstanceBounds(const GeometryInstanceData& inst, const float4x4& transform) const
+    {
+        switch (inst.getType())
+        {
+        case GeometryType::TriangleMesh:
+        case GeometryType::DisplacedTriangleMesh:
+            return mMeshBBs[inst.geometryID].transform(transform);
+        case GeometryType::Curve:
+            return mCurveBBs[inst.geometryID].transform(transform);
+        case GeometryType::SDFGrid:
+        {
+            float3x3 transform3x3 = float3x3(transform);
+            transform3x3[0] = abs(transform3x3[0]);
+            transform3x3[1] = abs(transform3x3[1]);
+            transform3x3[2] = abs(transform3x3[2]);
+            float3 center = transform.getCol(3).xyz();
+            float3 halfExtent = transformVector(transform3x3, float3(0.5f));
+            return AABB(center - halfExtent, center + halfExtent);
+        }
+        default:
+            return AABB();
+        }
+    }
+
+    void Scene::updateBounds(bool forceUpdate)
     {
         const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
 
-        mSceneBB = AABB();
+        // The per-instance world bounds are cached in a reduction tree, so only the moved instances and their ancestors are recomputed.
+        auto getInstanceBounds = [&](size_t instanceID)
+        {
+            const auto& inst = mGeometryInstanceData[instanceID];
+            return computeInstanceBounds(inst, globalMatrices[inst.globalMatrixID]);
+        };
 
-        for (const auto& inst : mGeometryInstanceData)
+        if (forceUpdate || mAllGeometryInstancesMoved || mInstanceBounds.getInstanceCount() != mGeometryInstanceData.size())
         {
-            const float4x4& transform = globalMatrices[inst.globalMatrixID];
-            switch (inst.getType())
-            {
-            case GeometryType::TriangleMesh:
-            case GeometryType::DisplacedTriangleMesh:
-            {
-                const AABB& meshBB = mMeshBBs[inst.geometryID];
-                mSceneBB |= meshBB.transform(transform);
-                break;
-            }
-            case GeometryType::Curve:
-            {
-                const AABB& curveBB = mCurveBBs[inst.geometryID];
-                mSceneBB |= curveBB.transform(transform);
-                break;
-            }
-            case GeometryType::SDFGrid:
-            {
-                float3x3 transform3x3 = float3x3(transform);
-                transform3x3[0] = abs(transform3x3[0]);
-                transform3x3[1] = abs(transform3x3[1]);
-                transform3x3[2] = abs(transform3x3[2]);
-                float3 center = transform.getCol(3).xyz();
-                float3 halfExtent = transformVector(transform3x3, float3(0.5f));
-                mSceneBB |= AABB(center - halfExtent, center + halfExtent);
-                break;
-            }
-            }
+            mInstanceBounds.build(mGeometryInstanceData.size(), getInstanceBounds);
         }
+        else
+        {
+            mInstanceBounds.update(mMovedGeometryInstances, getInstanceBounds);
+        }
+
+        mSceneBB = mInstanceBounds.getBounds();
 
         for (const auto& aabb : mCustomPrimitiveAABBs)
         {
@@ -906,11 +952,17 @@ namespace Falcor
     {
         if (mGeometryInstanceData.empty()) return;
 
-        bool dataChanged = false;
         const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
 
-        for (auto& inst : mGeometryInstanceData)
+        // Only the instances whose transform changed need their flags recomputed.
+        const bool updateAll = forceUpdate || mAllGeometryInstancesMoved;
+        const size_t count = updateAll ? mGeometryInstanceData.size() : mMovedGeometryInstances.size();
+        auto getInstanceID = [&](size_t i) { return updateAll ? (uint32_t)i : mMovedGeometryInstances[i]; };
+
+        mGeometryInstancesChanged.assign(count, 0);
+        auto updateInstance = [&](size_t i)
         {
+            auto& inst = mGeometryInstanceData[getInstanceID(i)];
             if (inst.getType() == GeometryType::TriangleMesh || inst.getType() == GeometryType::DisplacedTriangleMesh)
             {
                 uint32_t prevFlags = inst.flags;
@@ -930,14 +982,29 @@ namespace Falcor
                 if (isWorldFrontFaceCW) inst.flags |= (uint32_t)GeometryInstanceFlags::IsWorldFrontFaceCW;
                 else inst.flags &= ~(uint32_t)GeometryInstanceFlags::IsWorldFrontFaceCW;
 
-                dataChanged |= (inst.flags != prevFlags);
+                mGeometryInstancesChanged[i] = inst.flags != prevFlags;
             }
-        }
+        };
+
+        parallelFor(0, count, updateInstance);
 
-        if (forceUpdate || dataChanged)
+        if (forceUpdate)
         {
             uint32_t byteSize = (uint32_t)(mGeometryInstanceData.size() * sizeof(GeometryInstanceData));
             mpGeometryInstancesBuffer->setBlob(mGeometryInstanceData.data(), 0, byteSize);
+            return;
+        }
+
+        // Upload runs of consecutive changed instances.
+        for (size_t i = 0; i < count;)
+        {
+            if (!mGeometryInstancesChanged[i]) { i++; continue; }
+
+            uint32_t firstID = getInstanceID(i);
+            uint32_t endID = firstID + 1;
+            for (i++; i < count && mGeometryInstancesChanged[i] && getInstanceID(i) == endID; i++) endID++;
+
+            mpGeometryInstancesBuffer->setBlob(&mGeometryInstanceData[firstID], firstID * sizeof(GeometryInstanceData), (endID - firstID) * sizeof(GeometryInstanceData));
         }
     }
 
@@ -1253,11 +1320,12 @@ namespace Falcor
         createParameterBlock(); // Requires scene defines
         bindParameterBlock(); // Bind current data.
 
+        createNodeInstanceMap();
         mpAnimationController->animate(pRenderContext, 0); // Requires Scene block to exist
         updateGeometry(pRenderContext, true); // Requires scene defines
         updateGeometryInstances(true);
 
-        updateBounds();
+        updateBounds(true);
         createDrawList();
         if (mCameras.size() == 0)
         {
@@ -1869,13 +1937,7 @@ namespace Falcor
             mUpdates |= IScene::UpdateFlags::SceneGraphChanged;
             if (mpAnimationController->hasSkinnedMeshes()) mUpdates |= IScene::UpdateFlags::MeshesChanged;
 
-            for (const auto& inst : mGeometryInstanceData)
-            {
-                if (mpAnimationController->isMatrixChanged(NodeID{ inst.globalMatrixID }))
-                {
-                    mUpdates |= IScene::UpdateFlags::GeometryMoved;
-                }
-            }
+            if (findMovedGeometryInstances()) mUpdates |= IScene::UpdateFlags::GeometryMoved;
 
             // We might end up setting the flag even if curves haven't changed (if looping is disabled for example).
             if (mpAnimationController->hasAnimatedCurveCaches()) mUpdates |= IScene::UpdateFlags::CurvesMoved;
@@ -1898,7 +1960,14 @@ namespace Falcor
         if (is_set(mUpdates, IScene::UpdateFlags::GeometryMoved))
         {
             invalidateTlasCache();
-            updateGeometryInstances(false);
+            {
+                FALCOR_PROFILE(pRenderContext, "updateGeometryInstances");
+                updateGeometryInstances(false);
+            }
+            {
+                FALCOR_PROFILE(pRenderContext, "updateBounds");
+                updateBounds(false);
+            }
         }
 
         // Update existing BLASes if skinned animation and/or procedural primitives moved.
@@ -2210,6 +2279,8 @@ namespace Falcor
                 << "  Texture count (compressed): " << s.materials.textureCompressedCount << std::endl
                 << "  Texture texel count: " << s.materials.textureTexelCount << std::endl
                 << "  Texture memory: " << formatByteSize(s.materials.textureMemoryInBytes) << std::endl
+                << "  Texture transcode cache hits: " << s.materials.textureTranscodeCacheHits << std::endl
+                << "  Texture transcode cache misses: " << s.materials.textureTranscodeCacheMisses << std::endl
                 << "  Bytes/texel (average): " << std::fixed << std::setprecision(2) << bytesPerTexel << std::endl
                 << "  Channels/texel (average): " << std::fixed << std::setprecision(2) << channelsPerTexel << std::endl
                 << std::endl;
@@ -4147,6 +4218,8 @@ namespace Falcor
         d["textureTexelCount"] = stats.materials.textureTexelCount;
         d["textureTexelChannelCount"] = stats.materials.textureTexelChannelCount;
         d["textureMemoryInBytes"] = stats.materials.textureMemoryInBytes;
+        d["textureTranscodeCacheHits"] = stats.materials.textureTranscodeCacheHits;
+        d["textureTranscodeCacheMisses"] = stats.materials.textureTranscodeCacheMisses;
 
         // Raytracing stats
         d["blasGroupCount"] = stats.blasGroupCount;
@@ -29,6 +29,7 @@
 #include "SceneIDs.h"
 #include "SceneTypes.slang"
 #include "HitInfo.h"
+#include "InstanceBoundsTree.h"
 #include "IScene.h"
 #include "Animation/Animation.h"
 #include "Animation/AnimationController.h"
@@ -1129,11 +1130,26 @@ namespace Falcor
         */
         void uploadGeometry();
 
+        /** Create the mapping from scene graph nodes to the geometry instances they transform.
+        */
+        void createNodeInstanceMap();
+
+        /** Find the geometry instances whose transform changed in the last animation update.
+            \return True if any geometry instance moved.
+        */
+        bool findMovedGeometryInstances();
+
+        /** Compute the world space bounding box of a geometry instance.
+        */
+        AABB computeInstanceBounds(const GeometryInstanceData& inst, const float4x4& transform) const;
+
         /** Update the scene's global bounding box.
+            \param[in] forceUpdate Recompute the bounds of all instances, otherwise only of the moved ones.
         */
-        void updateBounds();
+        void updateBounds(bool forceUpdate);
 
         /** Update geometry instances.
+            Unless forced, only the moved instances are updated and only changed instance data is uploaded.
         */
         void updateGeometryInstances(bool forceUpdate);
 
@@ -1314,6 +1330,12 @@ namespace Falcor
         std::vector<std::vector<uint32_t>> mCurveIdToInstanceIds;   ///< Mapping of what instances belong to which curve.
         HitInfo mHitInfo;                                           ///< Geometry hit info requirements.
         AABB mSceneBB;                                              ///< Bounding boxes of the entire scene in world space.
+        InstanceBoundsTree mInstanceBounds;                         ///< World space bounding boxes of the geometry instances.
+        std::vector<uint32_t> mNodeInstanceOffsets;                 ///< Offset of each scene graph node's instances in mNodeInstances, followed by the instance count.
+        std::vector<uint32_t> mNodeInstances;                       ///< Geometry instance IDs grouped by scene graph node.
+        std::vector<uint32_t> mMovedGeometryInstances;              ///< Sorted IDs of the geometry instances moved in the last update.
+        bool mAllGeometryInstancesMoved = false;                    ///< True if all geometry instances moved in the last update.
+        std::vector<uint8_t> mGeometryInstancesChanged;             ///< Scratch flags marking updated instances whose data changed.
         SceneStats mSceneStats;                                     ///< Scene statistics.
         Metadata mMetadata;                                         ///< Importer-provided metadata.
         RenderSettings mRenderSettings;                             ///< Render settings.
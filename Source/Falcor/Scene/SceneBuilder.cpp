@@ -37,11 +37,11 @@
 #include "Utils/Scripting/ScriptBindings.h"
 #include "Utils/Math/MathHelpers.h"
 #include "Utils/ObjectIDPython.h"
-#include "Utils/NumericRange.h"
+#include "Utils/TaskManager.h"
 #include <mikktspace.h>
 #include <filesystem>
 #include <cmath>
-#include <execution>
+#include <optional>
 
 namespace Falcor
 {
@@ -177,6 +177,25 @@ namespace Falcor
             return true;
         }
 
+        /** Get the transform applied to the texture coordinates of meshes using a material.
+            \return The transform, or an empty optional if the texture transform is the identity.
+        */
+        std::optional<math::matrix<float, 2, 3>> getTexCoordTransform(const Material& material)
+        {
+            const float4x4 xform = material.getTextureTransform().getMatrix();
+            if (xform == float4x4::identity()) return {};
+
+            // The given matrix transforms the texture (e.g., scaling > 1 enlarges the texture).
+            // Because we're transforming the input coordinates, apply the inverse.
+            const float4x4 invXform = inverse(xform);
+            // Because texture transforms are 2D and affine, we only need apply the corresponding 3x2 matrix
+            return matrixFromColumns(
+                invXform.getCol(0).xy(),
+                invXform.getCol(1).xy(),
+                invXform.getCol(3).xy()
+            );
+        }
+
         std::vector<uint32_t> compact16BitIndices(const std::vector<uint32_t>& indices)
         {
             if (indices.empty()) return {};
@@ -449,6 +468,36 @@ namespace Falcor
         return addMesh(mesh);
     }
 
+    bool SceneBuilder::compareTriangleMesh(MeshID meshID, const TriangleMesh& triangleMesh) const
+    {
+        FALCOR_CHECK(meshID.get() < mMeshes.size(), "'meshID' ({}) is out of range", meshID);
+        const MeshSpec& spec = mMeshes[meshID.get()];
+
+        const auto& indices = triangleMesh.getIndices();
+        const auto& vertices = triangleMesh.getVertices();
+        const bool isIndexed = !is_set(mFlags, Flags::NonIndexedVertices);
+
+        if (spec.topology != Vao::Topology::TriangleList || spec.isFrontFaceCW != triangleMesh.getFrontFaceCW()) return false;
+        if ((isIndexed ? spec.indexCount : spec.vertexCount) != indices.size()) return false;
+
+        // Compare the vertices of all triangles, as processMesh() may have merged and renumbered the vertices.
+        // Attributes other than the position are compared with the same threshold used for merging vertices.
+        const float threshold = 1e-6f;
+        const auto coordTransform = getTexCoordTransform(*mSceneData.pMaterials->getMaterial(spec.materialId));
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            const StaticVertexData& s = spec.staticData[isIndexed ? spec.getIndex(i) : i];
+            const TriangleMesh::Vertex& v = vertices[indices[i]];
+            const float2 texCrd = coordTransform ? mul(*coordTransform, float3(v.texCoord, 1.f)) : v.texCoord;
+
+            if (any(s.position != v.position)) return false;
+            if (any(abs(s.normal - v.normal) > float3(threshold))) return false;
+            if (any(abs(s.texCrd - texCrd) > float2(threshold))) return false;
+        }
+
+        return true;
+    }
+
     SceneBuilder::ProcessedMesh SceneBuilder::processMesh(const Mesh& mesh_, MeshAttributeIndices* pAttributeIndices, std::vector<float4>* pTangents) const
     {
         // This function preprocesses a mesh into the final runtime representation.
@@ -512,24 +561,13 @@ namespace Falcor
         std::vector<float2> transformedTexCoords;
         if (mesh.texCrds.pData != nullptr)
         {
-            const float4x4 xform = mesh.pMaterial->getTextureTransform().getMatrix();
-            if (xform != float4x4::identity())
+            if (auto coordTransform = getTexCoordTransform(*mesh.pMaterial))
             {
                 size_t texCoordCount = mesh.getAttributeCount(mesh.texCrds);
                 transformedTexCoords.resize(texCoordCount);
-                // The given matrix transforms the texture (e.g., scaling > 1 enlarges the texture).
-                // Because we're transforming the input coordinates, apply the inverse.
-                const float4x4 invXform = inverse(xform);
-                // Because texture transforms are 2D and affine, we only need apply the corresponding 3x2 matrix
-                math::matrix<float, 2, 3> coordTransform = matrixFromColumns(
-                    invXform.getCol(0).xy(),
-                    invXform.getCol(1).xy(),
-                    invXform.getCol(3).xy()
-                );
-
                 for (size_t i = 0; i < texCoordCount; ++i)
                 {
-                    transformedTexCoords[i] = mul(coordTransform, float3(mesh.texCrds.pData[i], 1.f));
+                    transformedTexCoords[i] = mul(*coordTransform, float3(mesh.texCrds.pData[i], 1.f));
                 }
                 mesh.texCrds.pData = transformedTexCoords.data();
             }
@@ -712,8 +750,7 @@ namespace Falcor
             if (mesh.tangents.pData)
             {
                 FALCOR_ASSERT(mesh.tangents.frequency == Mesh::AttributeFrequency::FaceVarying);
-                NumericRange<uint32_t> range(0, mesh.indexCount);
-                std::for_each(std::execution::par_unseq, range.begin(), range.end(), [&](uint32_t fvIndex)
+                parallelFor(0, mesh.indexCount, [&](uint32_t fvIndex)
                 {
                     if (!any(isnan(mesh.tangents.pData[fvIndex])))
                         return;
@@ -942,7 +979,16 @@ namespace Falcor
         FALCOR_CHECK(pMaterial != nullptr, "'pMaterial' is missing");
         if (!mpMaterialTextureLoader)
         {
-            mpMaterialTextureLoader.reset(new MaterialTextureLoader(mSceneData.pMaterials->getTextureManager(), !is_set(mFlags, Flags::AssumeLinearSpaceTextures)));
+            auto& textureManager = mSceneData.pMaterials->getTextureManager();
+            if (mSettings.getOption("TextureManager:transcodeCache", false))
+                textureManager.setTranscodeCacheEnabled(true);
+            if (int budgetInMB = mSettings.getOption("TextureManager:streamingBudgetMB", 0); budgetInMB > 0)
+            {
+                TextureStreamer::Config config = TextureManager::getDefaultStreamingConfig();
+                config.budgetInBytes = uint64_t(budgetInMB) * 1024 * 1024;
+                textureManager.setStreamingEnabled(true, config);
+            }
+            mpMaterialTextureLoader.reset(new MaterialTextureLoader(textureManager, !is_set(mFlags, Flags::AssumeLinearSpaceTextures)));
         }
         std::filesystem::path resolvedPath = mAssetResolver.resolvePath(path);
         mpMaterialTextureLoader->loadTexture(pMaterial, slot, resolvedPath);
@@ -423,6 +423,15 @@ namespace Falcor
         */
         MeshID addTriangleMesh(const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, bool isAnimated = false);
 
+        /** Check if a triangle mesh has the same geometry as a mesh that was added to the scene builder.
+            The triangle mesh is compared against the pre-processed mesh data, so the added triangle mesh does not need to be kept.
+            This must be called before the scene is created, and does not compare the material.
+            \param meshID The ID of the mesh to compare against.
+            \param triangleMesh The triangle mesh to compare.
+            \return True if the triangle mesh would be added with the same vertices, indices and winding.
+        */
+        bool compareTriangleMesh(MeshID meshID, const TriangleMesh& triangleMesh) const;
+
         /** Pre-process a mesh into the data format that is used in the global scene buffers.
             Throws an exception if something went wrong.
             \param mesh The mesh to pre-process.
@@ -28,8 +28,8 @@
 #include "SceneBuilderDump.h"
 #include "Scene/SceneBuilder.h"
 #include "Utils/Math/FNVHash.h"
+#include "Utils/TaskManager.h"
 #include <fmt/format.h>
-#include <BS_thread_pool/BS_thread_pool.hpp>
 
 /// SceneBuilder printing is split off to its own file to avoid polluting the SceneBuilder.cpp with debug prints
 
@@ -286,14 +286,13 @@ std::map<std::string, std::string> SceneBuilderDump::getDebugContent(const Scene
         result[name] = std::move(res);
     };
 
-    BS::thread_pool threadPool;
-
-    for (size_t i = 0; i < sortedMeshes.size(); ++i)
-        threadPool.push_task([&,i]{ genMesh(i); });
-    for (size_t i = 0; i < sortedCurves.size(); ++i)
-        threadPool.push_task([&,i]{ genCurve(i); });
-
-    threadPool.wait_for_tasks();
+    parallelFor(0, sortedMeshes.size() + sortedCurves.size(), [&](size_t i)
+    {
+        if (i < sortedMeshes.size())
+            genMesh(i);
+        else
+            genCurve(i - sortedMeshes.size());
+    }, 1);
 
     return result;
 }
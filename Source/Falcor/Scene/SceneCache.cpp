@@ -30,6 +30,10 @@
 #include "Material/HairMaterial.h"
 #include "Material/ClothMaterial.h"
 #include "Material/MaterialTextureLoader.h"
+#include "SDFs/NormalizedDenseSDFGrid/NDSDFGrid.h"
+#include "SDFs/SparseVoxelSet/SDFSVS.h"
+#include "SDFs/SparseBrickSet/SDFSBS.h"
+#include "SDFs/SparseVoxelOctree/SDFSVO.h"
 #include "Utils/Logger.h"
 
 #include <lz4_stream/lz4_stream.h>
@@ -43,7 +47,7 @@ namespace Falcor
         /** Specfies the current cache file version.
             This needs to be incremented every time the file format changes!
         */
-        const uint32_t kVersion = 25;
+        const uint32_t kVersion = 30;
 
         /** Scene cache directory (subdirectory in the application data directory).
         */
@@ -368,6 +372,7 @@ namespace Falcor
         {
             stream.write(cachedMesh.meshID);
             stream.write(cachedMesh.timeSamples);
+            stream.write(cachedMesh.streamPath);
             stream.write((uint32_t)cachedMesh.vertexData.size());
             for (const auto& data : cachedMesh.vertexData) stream.write(data);
         }
@@ -392,11 +397,25 @@ namespace Falcor
             stream.write(cachedCurve.tessellationMode);
             stream.write(cachedCurve.geometryID);
             stream.write(cachedCurve.timeSamples);
+            stream.write(cachedCurve.streamPath);
             stream.write(cachedCurve.indexData);
             stream.write((uint32_t)cachedCurve.vertexData.size());
             for (const auto& data : cachedCurve.vertexData) stream.write(data);
         }
 
+        writeMarker(stream, "SDFGrids");
+        stream.write((uint32_t)sceneData.sdfGrids.size());
+        for (const auto& pSDFGrid : sceneData.sdfGrids) writeSDFGrid(stream, pSDFGrid);
+        stream.write((uint32_t)sceneData.sdfGridDesc.size());
+        for (const auto& desc : sceneData.sdfGridDesc)
+        {
+            stream.write(desc.sdfGridID);
+            stream.write(desc.materialID);
+            stream.write(desc.instances);
+        }
+        stream.write(sceneData.sdfGridInstances);
+        stream.write(sceneData.sdfGridMaxLODCount);
+
         writeMarker(stream, "CustomPrimitives");
         stream.write(sceneData.customPrimitiveDesc);
         stream.write(sceneData.customPrimitiveAABBs);
@@ -494,6 +513,7 @@ namespace Falcor
         {
             stream.read(cachedMesh.meshID);
             stream.read(cachedMesh.timeSamples);
+            stream.read(cachedMesh.streamPath);
             cachedMesh.vertexData.resize(stream.read<uint32_t>());
             for (auto& data : cachedMesh.vertexData) stream.read(data);
         }
@@ -518,11 +538,25 @@ namespace Falcor
             stream.read(cachedCurve.tessellationMode);
             stream.read(cachedCurve.geometryID);
             stream.read(cachedCurve.timeSamples);
+            stream.read(cachedCurve.streamPath);
             stream.read(cachedCurve.indexData);
             cachedCurve.vertexData.resize(stream.read<uint32_t>());
             for (auto& data : cachedCurve.vertexData) stream.read(data);
         }
 
+        readMarker(stream, "SDFGrids");
+        sceneData.sdfGrids.resize(stream.read<uint32_t>());
+        for (auto& pSDFGrid : sceneData.sdfGrids) pSDFGrid = readSDFGrid(stream, pDevice);
+        sceneData.sdfGridDesc.resize(stream.read<uint32_t>());
+        for (auto& desc : sceneData.sdfGridDesc)
+        {
+            stream.read(desc.sdfGridID);
+            stream.read(desc.materialID);
+            stream.read(desc.instances);
+        }
+        stream.read(sceneData.sdfGridInstances);
+        stream.read(sceneData.sdfGridMaxLODCount);
+
         readMarker(stream, "CustomPrimitives");
         stream.read(sceneData.customPrimitiveDesc);
         stream.read(sceneData.customPrimitiveAABBs);
@@ -692,6 +726,18 @@ namespace Falcor
             auto pMaterial = materialSystem.getMaterial(materialID);
             writeMaterial(stream, pMaterial);
         }
+
+        // Write the light profile together with its baked data so it does not need to be baked when loading the cache.
+        const auto& pLightProfile = materialSystem.mpLightProfile;
+        stream.write(pLightProfile != nullptr);
+        if (pLightProfile)
+        {
+            stream.write(pLightProfile->mName);
+            stream.write(pLightProfile->mRawData);
+            auto baked = pLightProfile->getBakedProfile();
+            stream.write(baked.texels);
+            stream.write(baked.fluxFactor);
+        }
     }
 
     void SceneCache::writeMaterial(OutputStream& stream, const ref<Material>& pMaterial)
@@ -747,6 +793,23 @@ namespace Falcor
             auto pMaterial = readMaterial(stream, materialTextureLoader, pDevice);
             materialSystem.addMaterial(pMaterial);
         }
+
+        auto hasLightProfile = stream.read<bool>();
+        if (hasLightProfile)
+        {
+            auto name = stream.read<std::string>();
+            std::vector<float> rawData;
+            stream.read(rawData);
+            auto pBaked = std::make_unique<LightProfile::BakedProfile>();
+            stream.read(pBaked->texels);
+            stream.read(pBaked->fluxFactor);
+
+            // The texture is created when the profile is baked in MaterialSystem::update().
+            ref<LightProfile> pLightProfile(new LightProfile(pDevice, name, rawData));
+            pLightProfile->mpPrebaked = std::move(pBaked);
+            materialSystem.mpLightProfile = pLightProfile;
+            materialSystem.mLightProfileBaked = false;
+        }
     }
 
     ref<Material> SceneCache::readMaterial(InputStream& stream, MaterialTextureLoader& materialTextureLoader, ref<Device> pDevice)
@@ -902,6 +965,187 @@ namespace Falcor
         return ref<Grid>(new Grid(pDevice, nanovdb::GridHandle<nanovdb::HostBuffer>(std::move(buffer))));
     }
 
+    // SDFGrid
+
+    void SceneCache::writeSDFGrid(OutputStream& stream, const ref<SDFGrid>& pSDFGrid)
+    {
+        const SDFGrid::Type type = pSDFGrid->getType();
+        stream.write(type);
+
+        // Write the construction parameters.
+        if (type == SDFGrid::Type::NormalizedDenseGrid)
+        {
+            stream.write(static_cast<const NDSDFGrid*>(pSDFGrid.get())->mNarrowBandThickness);
+        }
+        else if (type == SDFGrid::Type::SparseBrickSet)
+        {
+            const SDFSBS* pSBS = static_cast<const SDFSBS*>(pSDFGrid.get());
+            stream.write(pSBS->mBrickWidth);
+            stream.write(pSBS->mCompressed);
+            stream.write(pSBS->mDefaultGridWidth);
+        }
+
+        stream.write(pSDFGrid->mName);
+        stream.write(pSDFGrid->mGridWidth);
+        stream.write(pSDFGrid->mPrimitives);
+        stream.write((uint32_t)pSDFGrid->mPrimitiveIDToIndex.size());
+        for (const auto& [primitiveID, index] : pSDFGrid->mPrimitiveIDToIndex)
+        {
+            stream.write(primitiveID);
+            stream.write(index);
+        }
+        stream.write(pSDFGrid->mNextPrimitiveID);
+        stream.write(pSDFGrid->mPrimitivesDirty);
+        stream.write(pSDFGrid->mBakedPrimitiveCount);
+        stream.write(pSDFGrid->mBakePrimitives);
+        stream.write(pSDFGrid->mHasGridRepresentation);
+        stream.write(pSDFGrid->mInitializedWithPrimitives);
+
+        // Write the values, and the acceleration structure built on the CPU so that it does not need to be built when loading the cache.
+        switch (type)
+        {
+        case SDFGrid::Type::NormalizedDenseGrid:
+        {
+            const NDSDFGrid* pNDSDFGrid = static_cast<const NDSDFGrid*>(pSDFGrid.get());
+            stream.write((uint32_t)pNDSDFGrid->mValues.size());
+            for (const auto& values : pNDSDFGrid->mValues) stream.write(values);
+            stream.write(pNDSDFGrid->mCoarsestLODGridWidth);
+            stream.write(pNDSDFGrid->mCoarsestLODNormalizationFactor);
+            break;
+        }
+        case SDFGrid::Type::SparseVoxelSet:
+            stream.write(static_cast<const SDFSVS*>(pSDFGrid.get())->mValues);
+            break;
+        case SDFGrid::Type::SparseBrickSet:
+        {
+            SDFSBS* pSBS = static_cast<SDFSBS*>(pSDFGrid.get());
+            stream.write(pSBS->mSDField);
+            stream.write(pSBS->mSDFieldUpdated);
+
+            if (!pSBS->mHasCPUBricks && pSBS->mPrimitives.empty() && !pSBS->mSDField.empty()) pSBS->buildBricksOnCPU();
+            stream.write(pSBS->mHasCPUBricks);
+            if (pSBS->mHasCPUBricks)
+            {
+                const SDFSBS::CPUBricks& bricks = pSBS->mCPUBricks;
+                stream.write(bricks.virtualBricksPerAxis);
+                stream.write(bricks.brickCount);
+                stream.write(bricks.bricksPerAxis);
+                stream.write(bricks.brickTextureDimensions);
+                stream.write(bricks.indirection);
+                stream.write(bricks.brickAABBs);
+                stream.write(bricks.brickTexture);
+            }
+            break;
+        }
+        case SDFGrid::Type::SparseVoxelOctree:
+        {
+            SDFSVO* pSVO = static_cast<SDFSVO*>(pSDFGrid.get());
+            stream.write(pSVO->mLevelCount);
+            stream.write(pSVO->mValues);
+
+            if (!pSVO->mHasCPUOctree && !pSVO->mValues.empty()) pSVO->buildOctreeOnCPU();
+            stream.write(pSVO->mHasCPUOctree);
+            if (pSVO->mHasCPUOctree) stream.write(pSVO->mCPUOctree);
+            break;
+        }
+        default:
+            FALCOR_THROW("Unsupported SDF grid type '{}'.", to_string(type));
+        }
+    }
+
+    ref<SDFGrid> SceneCache::readSDFGrid(InputStream& stream, ref<Device> pDevice)
+    {
+        const auto type = stream.read<SDFGrid::Type>();
+
+        ref<SDFGrid> pSDFGrid;
+        switch (type)
+        {
+        case SDFGrid::Type::NormalizedDenseGrid:
+            pSDFGrid = NDSDFGrid::create(pDevice, stream.read<float>());
+            break;
+        case SDFGrid::Type::SparseVoxelSet:
+            pSDFGrid = SDFSVS::create(pDevice);
+            break;
+        case SDFGrid::Type::SparseBrickSet:
+        {
+            auto brickWidth = stream.read<uint32_t>();
+            auto compressed = stream.read<bool>();
+            auto defaultGridWidth = stream.read<uint32_t>();
+            pSDFGrid = SDFSBS::create(pDevice, brickWidth, compressed, defaultGridWidth);
+            break;
+        }
+        case SDFGrid::Type::SparseVoxelOctree:
+            pSDFGrid = SDFSVO::create(pDevice);
+            break;
+        default:
+            FALCOR_THROW("Unsupported SDF grid type '{}'.", to_string(type));
+        }
+
+        stream.read(pSDFGrid->mName);
+        stream.read(pSDFGrid->mGridWidth);
+        stream.read(pSDFGrid->mPrimitives);
+        auto primitiveCount = stream.read<uint32_t>();
+        for (uint32_t i = 0; i < primitiveCount; i++)
+        {
+            auto primitiveID = stream.read<uint32_t>();
+            pSDFGrid->mPrimitiveIDToIndex[primitiveID] = stream.read<uint32_t>();
+        }
+        stream.read(pSDFGrid->mNextPrimitiveID);
+        stream.read(pSDFGrid->mPrimitivesDirty);
+        stream.read(pSDFGrid->mBakedPrimitiveCount);
+        stream.read(pSDFGrid->mBakePrimitives);
+        stream.read(pSDFGrid->mHasGridRepresentation);
+        stream.read(pSDFGrid->mInitializedWithPrimitives);
+
+        switch (type)
+        {
+        case SDFGrid::Type::NormalizedDenseGrid:
+        {
+            NDSDFGrid* pNDSDFGrid = static_cast<NDSDFGrid*>(pSDFGrid.get());
+            pNDSDFGrid->mValues.resize(stream.read<uint32_t>());
+            for (auto& values : pNDSDFGrid->mValues) stream.read(values);
+            stream.read(pNDSDFGrid->mCoarsestLODGridWidth);
+            stream.read(pNDSDFGrid->mCoarsestLODNormalizationFactor);
+            break;
+        }
+        case SDFGrid::Type::SparseVoxelSet:
+            stream.read(static_cast<SDFSVS*>(pSDFGrid.get())->mValues);
+            break;
+        case SDFGrid::Type::SparseBrickSet:
+        {
+            SDFSBS* pSBS = static_cast<SDFSBS*>(pSDFGrid.get());
+            stream.read(pSBS->mSDField);
+            stream.read(pSBS->mSDFieldUpdated);
+            stream.read(pSBS->mHasCPUBricks);
+            if (pSBS->mHasCPUBricks)
+            {
+                SDFSBS::CPUBricks& bricks = pSBS->mCPUBricks;
+                stream.read(bricks.virtualBricksPerAxis);
+                stream.read(bricks.brickCount);
+                stream.read(bricks.bricksPerAxis);
+                stream.read(bricks.brickTextureDimensions);
+                stream.read(bricks.indirection);
+                stream.read(bricks.brickAABBs);
+                stream.read(bricks.brickTexture);
+            }
+            break;
+        }
+        case SDFGrid::Type::SparseVoxelOctree:
+        {
+            SDFSVO* pSVO = static_cast<SDFSVO*>(pSDFGrid.get());
+            stream.read(pSVO->mLevelCount);
+            stream.read(pSVO->mValues);
+            stream.read(pSVO->mHasCPUOctree);
+            if (pSVO->mHasCPUOctree) stream.read(pSVO->mCPUOctree);
+            break;
+        }
+        default:
+            FALCOR_UNREACHABLE();
+        }
+
+        return pSDFGrid;
+    }
+
     // EnvMap
 
     void SceneCache::writeEnvMap(OutputStream& stream, const ref<EnvMap>& pEnvMap)
@@ -910,15 +1154,35 @@ namespace Falcor
         stream.write(path);
         stream.write(pEnvMap->mData);
         stream.write(pEnvMap->mRotation);
+
+        // Write the importance map built on the CPU so it does not need to be rebuilt when loading the cache.
+        const auto& pImportanceMap = pEnvMap->mpImportanceMap;
+        stream.write(pImportanceMap != nullptr);
+        if (pImportanceMap)
+        {
+            stream.write(pImportanceMap->getDimension());
+            stream.write(pImportanceMap->getSampleCount());
+            stream.write(pImportanceMap->getData());
+        }
     }
 
     ref<EnvMap> SceneCache::readEnvMap(InputStream& stream, ref<Device> pDevice)
     {
         auto path = stream.read<std::filesystem::path>();
-        auto pEnvMap = EnvMap::createFromFile(pDevice, path);
+        auto pEnvMap = EnvMap::createFromFile(pDevice, path, false);
         if (!pEnvMap) FALCOR_THROW("Failed to load environment map");
         stream.read(pEnvMap->mData);
         stream.read(pEnvMap->mRotation);
+
+        auto hasImportanceMap = stream.read<bool>();
+        if (hasImportanceMap)
+        {
+            auto dimension = stream.read<uint32_t>();
+            auto samples = stream.read<uint32_t>();
+            std::vector<float> data;
+            stream.read(data);
+            pEnvMap->mpImportanceMap = std::make_shared<const EnvMapImportanceMap>(dimension, samples, std::move(data));
+        }
         return pEnvMap;
     }
 
@@ -951,7 +1215,10 @@ namespace Falcor
         stream.write(pAnimation->mPostInfinityBehavior);
         stream.write(pAnimation->mInterpolationMode);
         stream.write(pAnimation->mEnableWarping);
-        stream.write(pAnimation->mKeyframes);
+        stream.write(pAnimation->mTimes);
+        stream.write(pAnimation->mTranslations);
+        stream.write(pAnimation->mScalings);
+        stream.write(pAnimation->mRotations);
     }
 
     ref<Animation> SceneCache::readAnimation(InputStream& stream)
@@ -964,7 +1231,10 @@ namespace Falcor
         stream.read(pAnimation->mPostInfinityBehavior);
         stream.read(pAnimation->mInterpolationMode);
         stream.read(pAnimation->mEnableWarping);
-        stream.read(pAnimation->mKeyframes);
+        stream.read(pAnimation->mTimes);
+        stream.read(pAnimation->mTranslations);
+        stream.read(pAnimation->mScalings);
+        stream.read(pAnimation->mRotations);
         return pAnimation;
     }
 
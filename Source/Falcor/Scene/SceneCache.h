@@ -112,6 +112,9 @@ namespace Falcor
         static void writeGrid(OutputStream& stream, const ref<Grid>& pGrid);
         static ref<Grid> readGrid(InputStream& stream, ref<Device> pDevice);
 
+        static void writeSDFGrid(OutputStream& stream, const ref<SDFGrid>& pSDFGrid);
+        static ref<SDFGrid> readSDFGrid(InputStream& stream, ref<Device> pDevice);
+
         static void writeEnvMap(OutputStream& stream, const ref<EnvMap>& pEnvMap);
         static ref<EnvMap> readEnvMap(InputStream& stream, ref<Device> pDevice);
 
@@ -304,6 +304,8 @@ inline int32_t runTestsParallel(const RunOptions& options)
 
     std::vector<TestResult> results(tests.size());
 
+    // Tests run on their own threads rather than on the shared ThreadPool. Tests wait for tasks they submit to the pool,
+    // which would deadlock if the tests occupied all of its workers.
     BS::thread_pool_light threadPool(options.parallel);
 
     reportLine("[==========] Running {} test{}.", tests.size(), plural(tests.size(), "s"));
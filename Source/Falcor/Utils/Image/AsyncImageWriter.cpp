@@ -0,0 +1,195 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "AsyncImageWriter.h"
+#include "Utils/Logger.h"
+#include <algorithm>
+
+namespace Falcor
+{
+namespace
+{
+double toSeconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+} // namespace
+
+AsyncImageWriter::AsyncImageWriter(size_t threadCount, size_t maxQueuedImages, WriteFunc writeFunc)
+    : mWriteFunc(std::move(writeFunc)), mMaxQueuedImages(std::max<size_t>(maxQueuedImages, 1))
+{
+    if (!mWriteFunc)
+    {
+        mWriteFunc = [](Image& image)
+        {
+            Bitmap::saveImage(
+                image.path,
+                image.width,
+                image.height,
+                image.fileFormat,
+                image.exportFlags,
+                image.resourceFormat,
+                image.isTopDown,
+                image.data.data()
+            );
+        };
+    }
+
+    threadCount = std::max<size_t>(threadCount, 1);
+    for (size_t i = 0; i < threadCount; ++i)
+        mThreads.emplace_back(&AsyncImageWriter::runWorker, this);
+}
+
+AsyncImageWriter::~AsyncImageWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTerminate = true;
+    }
+
+    mWorkCondition.notify_all();
+
+    // Workers drain the queue before terminating.
+    for (auto& thread : mThreads)
+        thread.join();
+}
+
+void AsyncImageWriter::write(Image image)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mStats.imagesQueued == 0)
+        mFirstWriteTime = Clock::now();
+    mStats.imagesQueued++;
+
+    // Apply back-pressure if the workers can't keep up.
+    if (mQueue.size() >= mMaxQueuedImages)
+    {
+        auto stallStart = Clock::now();
+        mDoneCondition.wait(lock, [&]() { return mQueue.size() < mMaxQueuedImages; });
+        mStats.stallCount++;
+        mStats.stallTime += toSeconds(Clock::now() - stallStart);
+    }
+
+    mQueue.push(std::move(image));
+    mWorkCondition.notify_one();
+}
+
+void AsyncImageWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDoneCondition.wait(lock, [&]() { return mQueue.empty() && mActiveCount == 0; });
+}
+
+size_t AsyncImageWriter::getPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mQueue.size() + mActiveCount;
+}
+
+AsyncImageWriter::Stats AsyncImageWriter::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    Stats stats = mStats;
+    if (stats.imagesWritten + stats.imagesFailed > 0)
+        stats.elapsedTime = std::max(0.0, toSeconds(mLastCompletionTime - mFirstWriteTime));
+    return stats;
+}
+
+void AsyncImageWriter::resetStats()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    // Keep counting images that are still in flight.
+    mStats = {};
+    mStats.imagesQueued = mQueue.size() + mActiveCount;
+    mFirstWriteTime = Clock::now();
+}
+
+void AsyncImageWriter::runWorker()
+{
+    // This function is the entry point for worker threads.
+    // The workers wait on the queue and write an image when woken up.
+
+    while (true)
+    {
+        // Wait on condition until more work is ready.
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWorkCondition.wait(lock, [&]() { return mTerminate || !mQueue.empty(); });
+
+        // Terminate thread unless there is more work to do.
+        if (mQueue.empty())
+            break;
+
+        // Pop next image from queue and notify producers waiting on queue space.
+        Image image = std::move(mQueue.front());
+        mQueue.pop();
+        mActiveCount++;
+        mDoneCondition.notify_all();
+
+        lock.unlock();
+
+        // Encode and write the image (this part is running in parallel).
+        auto writeStart = Clock::now();
+        bool success = true;
+        try
+        {
+            mWriteFunc(image);
+        }
+        catch (const std::exception& e)
+        {
+            logError("Failed to write image '{}': {}", image.path, e.what());
+            success = false;
+        }
+        catch (...)
+        {
+            logError("Failed to write image '{}'.", image.path);
+            success = false;
+        }
+        auto writeEnd = Clock::now();
+
+        if (image.callback)
+            image.callback(success);
+
+        lock.lock();
+
+        mActiveCount--;
+        if (success)
+        {
+            mStats.imagesWritten++;
+            mStats.bytesWritten += image.data.size();
+        }
+        else
+        {
+            mStats.imagesFailed++;
+        }
+        mStats.writeTime += toSeconds(writeEnd - writeStart);
+        mLastCompletionTime = writeEnd;
+
+        mDoneCondition.notify_all();
+    }
+}
+} // namespace Falcor
@@ -0,0 +1,149 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Bitmap.h"
+#include "Core/Macros.h"
+#include "Core/API/Formats.h"
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Falcor
+{
+/**
+ * Utility class to encode and write images to disk asynchronously using multiple worker threads.
+ *
+ * Images are placed in a bounded queue. When the queue is full, write() blocks until a worker has taken an image,
+ * which applies back-pressure to the producer when encoding or the disk can't keep up.
+ * The workers are dedicated threads rather than tasks on the shared ThreadPool (see Utils/TaskManager.h),
+ * since they spend much of their time blocked on disk writes, which would hold up the pool's workers.
+ */
+class FALCOR_API AsyncImageWriter
+{
+public:
+    /// Callback invoked on a worker thread after an image was written (or failed to be written).
+    using WriteCallback = std::function<void(bool success)>;
+
+    /// Image to write. The arguments correspond to those of Bitmap::saveImage().
+    struct Image
+    {
+        std::filesystem::path path;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        Bitmap::FileFormat fileFormat = Bitmap::FileFormat::PngFile;
+        Bitmap::ExportFlags exportFlags = Bitmap::ExportFlags::None;
+        ResourceFormat resourceFormat = ResourceFormat::Unknown;
+        bool isTopDown = true;
+        std::vector<uint8_t> data;
+        WriteCallback callback;
+    };
+
+    /// Function that writes an image. The default calls Bitmap::saveImage(). Exceptions are reported as failed writes.
+    using WriteFunc = std::function<void(Image& image)>;
+
+    struct Stats
+    {
+        uint64_t imagesQueued = 0;  ///< Number of images passed to write().
+        uint64_t imagesWritten = 0; ///< Number of images written successfully.
+        uint64_t imagesFailed = 0;  ///< Number of images that failed to write.
+        uint64_t bytesWritten = 0;  ///< Size of the uncompressed image data of written images.
+        uint64_t stallCount = 0;    ///< Number of times write() blocked on a full queue.
+        double stallTime = 0.0;     ///< Total time write() blocked on a full queue in seconds.
+        double writeTime = 0.0;     ///< Total time spent in the write function summed over all workers in seconds.
+        double elapsedTime = 0.0;   ///< Time from the first write() to the last completed write in seconds.
+
+        /// Returns the number of completed images per second.
+        double getImagesPerSecond() const
+        {
+            return elapsedTime > 0.0 ? double(imagesWritten + imagesFailed) / elapsedTime : 0.0;
+        }
+    };
+
+    /**
+     * Constructor.
+     * @param[in] threadCount Number of worker threads.
+     * @param[in] maxQueuedImages Maximum number of images waiting in the queue before write() blocks.
+     * @param[in] writeFunc Function used to write images. If empty, images are written with Bitmap::saveImage().
+     */
+    AsyncImageWriter(size_t threadCount = std::thread::hardware_concurrency(), size_t maxQueuedImages = 8, WriteFunc writeFunc = {});
+
+    /**
+     * Destructor.
+     * Blocks until all queued images are written and all threads have terminated.
+     */
+    ~AsyncImageWriter();
+
+    AsyncImageWriter(const AsyncImageWriter&) = delete;
+    AsyncImageWriter& operator=(const AsyncImageWriter&) = delete;
+
+    /**
+     * Queue an image for writing.
+     * Blocks while the queue is full.
+     * @param[in] image Image to write.
+     */
+    void write(Image image);
+
+    /**
+     * Block until all queued images have been written.
+     */
+    void flush();
+
+    /// Returns the number of images queued or being written.
+    size_t getPendingCount() const;
+
+    Stats getStats() const;
+
+    void resetStats();
+
+private:
+    void runWorker();
+
+    using Clock = std::chrono::steady_clock;
+
+    WriteFunc mWriteFunc;
+    size_t mMaxQueuedImages;
+
+    mutable std::mutex mMutex;              ///< Mutex for synchronizing access to shared resources.
+    std::condition_variable mWorkCondition; ///< Condition variable for workers to wait on new images.
+    std::condition_variable mDoneCondition; ///< Condition variable for producers to wait on queue space or completion.
+    std::vector<std::thread> mThreads;      ///< Worker threads.
+
+    // Internal state. Do not access outside of critical section.
+    std::queue<Image> mQueue; ///< Images waiting to be written.
+    size_t mActiveCount = 0;  ///< Number of images currently being written.
+    bool mTerminate = false;  ///< Flag to terminate worker threads.
+    Stats mStats;
+    Clock::time_point mFirstWriteTime;
+    Clock::time_point mLastCompletionTime;
+};
+} // namespace Falcor
@@ -26,6 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "AsyncTextureLoader.h"
+#include "Core/Error.h"
 #include "Core/API/Device.h"
 #include "Utils/Threading.h"
 
@@ -77,6 +78,18 @@ std::future<ref<Texture>> AsyncTextureLoader::loadFromFile(
     return mLoadRequestQueue.back().promise.get_future();
 }
 
+std::future<ref<Texture>> AsyncTextureLoader::load(LoadFunction loadFunction, LoadCallback callback)
+{
+    FALCOR_CHECK(loadFunction, "Load function must be set.");
+    std::lock_guard<std::mutex> lock(mMutex);
+    LoadRequest request = {};
+    request.callback = std::move(callback);
+    request.loadFunction = std::move(loadFunction);
+    mLoadRequestQueue.push(std::move(request));
+    mCondition.notify_one();
+    return mLoadRequestQueue.back().promise.get_future();
+}
+
 void AsyncTextureLoader::runWorkers(size_t threadCount)
 {
     // Create a barrier to synchronize worker threads before issuing a global flush.
@@ -134,7 +147,11 @@ void AsyncTextureLoader::runWorker()
 
         // Load the textures (this part is running in parallel).
         ref<Texture> pTexture;
-        if (request.paths.size() == 1)
+        if (request.loadFunction)
+        {
+            pTexture = request.loadFunction();
+        }
+        else if (request.paths.size() == 1)
         {
             pTexture = Texture::createFromFile(
                 mpDevice, request.paths[0], request.generateMipLevels, request.loadAsSRGB, request.bindFlags, request.importFlags
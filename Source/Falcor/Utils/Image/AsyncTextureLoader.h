@@ -51,6 +51,7 @@ class FALCOR_API AsyncTextureLoader
 {
 public:
     using LoadCallback = std::function<void(ref<Texture> pTexture)>;
+    using LoadFunction = std::function<ref<Texture>()>;
 
     /**
      * Constructor.
@@ -100,6 +101,15 @@ public:
         LoadCallback callback = {}
     );
 
+    /**
+     * Request loading a texture using a custom load function.
+     * The function is called on a worker thread and participates in the regular GPU upload flushing.
+     * @param[in] loadFunction Function creating the texture, returning nullptr if the texture failed to load.
+     * @param[in] callback Function called after the texture load has finished.
+     * @return A future to a new texture, or nullptr if the texture failed to load.
+     */
+    std::future<ref<Texture>> load(LoadFunction loadFunction, LoadCallback callback = {});
+
 private:
     void runWorkers(size_t threadCount);
     void runWorker();
@@ -114,6 +124,7 @@ private:
         Bitmap::ImportFlags importFlags;
         LoadCallback callback;
         std::promise<ref<Texture>> promise;
+        LoadFunction loadFunction; ///< Custom load function. If set, the parameters above are unused.
     };
 
     ref<Device> mpDevice;
@@ -26,6 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "Bitmap.h"
+#include "PixelConversion.h"
 #include "Core/Macros.h"
 #include "Core/API/Texture.h"
 #include "Core/Platform/MemoryMappedFile.h"
@@ -37,7 +38,14 @@
 #include <ImfIO.h>
 #include <ImfInputFile.h>
 #include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
 #include <ImfHeader.h>
+#include <ImfThreading.h>
+#include <IexBaseExc.h>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
 
 #if FALCOR_WINDOWS
 #ifndef WINDOWS_LEAN_AND_MEAN
@@ -51,6 +59,8 @@ namespace Falcor
 {
 namespace
 {
+constexpr uint32_t kExrRowsPerThread = 32;             ///< Number of rows decoded per thread between row callbacks.
+constexpr size_t kExrMaxStagingSize = 64 * 1024 * 1024; ///< Maximum size of the staging buffer for cropped or flipped images.
 
 /// Wraps MemoryMappedFile in an OpenEXR interface
 class OpenExrStream : public Imf::IStream
@@ -70,6 +80,17 @@ public:
         return true;
     }
 
+    virtual bool isMemoryMapped() const { return true; }
+
+    virtual char* readMemoryMapped(int n)
+    {
+        if (mOffset + size_t(n) > mFile.getSize())
+            throw Iex::InputExc("Reading past end of file.");
+        char* pData = const_cast<char*>(reinterpret_cast<const char*>(mFileData + mOffset));
+        mOffset += n;
+        return pData;
+    }
+
     virtual uint64_t tellg() { return mOffset; }
 
     virtual void seekg(uint64_t pos) { mOffset = pos; }
@@ -93,6 +114,36 @@ bool isFloat16Exr(const MemoryMappedFile& inputFile)
     return true;
 }
 
+/**
+ * Returns the number of threads to use for decoding OpenEXR files.
+ * OpenEXR decodes blocks in its global thread pool, which is empty by default, so it is created on first use.
+ */
+uint32_t getExrThreadCount(uint32_t threadCount)
+{
+    static std::once_flag flag;
+    const uint32_t hardwareThreadCount = std::max(1u, std::thread::hardware_concurrency());
+    std::call_once(flag, [&]() { Imf::setGlobalThreadCount((int)hardwareThreadCount); });
+    return threadCount == 0 ? hardwareThreadCount : threadCount;
+}
+
+/// Fill a component of RGBA texels with a constant value.
+void fillComponent(uint8_t* pTexels, uint32_t count, uint32_t component, bool isHalf, float value)
+{
+    if (isHalf)
+    {
+        const uint16_t bits = float16_t(value).toBits();
+        uint16_t* pDst = reinterpret_cast<uint16_t*>(pTexels) + component;
+        for (uint32_t i = 0; i < count; i++)
+            pDst[i * 4] = bits;
+    }
+    else
+    {
+        float* pDst = reinterpret_cast<float*>(pTexels) + component;
+        for (uint32_t i = 0; i < count; i++)
+            pDst[i * 4] = value;
+    }
+}
+
 } // namespace
 
 static bool isRGB32fSupported()
@@ -115,45 +166,25 @@ static bool isConvertibleToRGBA32Float(ResourceFormat format)
 
 /**
  * Converts half float image to RGBA float image.
+ * Missing color channels are set to 0, a missing alpha channel is set to 1.
  */
 static std::vector<float> convertHalfToRGBA32Float(uint32_t width, uint32_t height, uint32_t channelCount, const void* pData)
 {
-    std::vector<float> newData(width * height * 4u, 0.f);
-    const float16_t* pSrc = reinterpret_cast<const float16_t*>(pData);
-    float* pDst = newData.data();
-
-    for (uint32_t i = 0; i < width * height; ++i)
-    {
-        for (uint32_t c = 0; c < channelCount; ++c)
-        {
-            *pDst++ = float(*pSrc++);
-        }
-        pDst += (4 - channelCount);
-    }
-
+    std::vector<float> newData(width * height * 4u);
+    PixelConversion::float16ToRGBA32Float(reinterpret_cast<const uint16_t*>(pData), channelCount, newData.data(), width * height);
     return newData;
 }
 
 /**
  * Converts integer image to RGBA float image.
  * Unsigned integers are normalized to [0,1], signed integers to [-1,1].
+ * Missing color channels are set to 0, a missing alpha channel is set to 1.
  */
 template<typename SrcT>
 static std::vector<float> convertIntToRGBA32Float(uint32_t width, uint32_t height, uint32_t channelCount, const void* pData)
 {
-    std::vector<float> newData(width * height * 4u, 0.f);
-    const SrcT* pSrc = reinterpret_cast<const SrcT*>(pData);
-    float* pDst = newData.data();
-
-    for (uint32_t i = 0; i < width * height; ++i)
-    {
-        for (uint32_t c = 0; c < channelCount; ++c)
-        {
-            *pDst++ = float(*pSrc++) / float(std::numeric_limits<SrcT>::max());
-        }
-        pDst += (4 - channelCount);
-    }
-
+    std::vector<float> newData(width * height * 4u);
+    PixelConversion::normalizedToRGBA32Float(reinterpret_cast<const SrcT*>(pData), channelCount, newData.data(), width * height);
     return newData;
 }
 
@@ -195,13 +226,6 @@ static std::vector<float> convertToRGBA32Float(ResourceFormat format, uint32_t w
         FALCOR_UNREACHABLE();
     }
 
-    // Default alpha channel to 1.
-    if (channelCount < 4)
-    {
-        for (uint32_t i = 0; i < width * height; ++i)
-            floatData[i * 4 + 3] = 1.f;
-    }
-
     return floatData;
 }
 
@@ -225,17 +249,8 @@ static FIBITMAP* convertToRGBAF(FIBITMAP* pDib)
 
     for (unsigned y = 0; y < height; y++)
     {
-        const FIRGBF* src_pixel = (FIRGBF*)src_bits;
-        FIRGBAF* dst_pixel = (FIRGBAF*)dst_bits;
-
-        for (unsigned x = 0; x < width; x++)
-        {
-            // Convert pixels directly, while adding a "dummy" alpha of 1.0
-            dst_pixel[x].red = src_pixel[x].red;
-            dst_pixel[x].green = src_pixel[x].green;
-            dst_pixel[x].blue = src_pixel[x].blue;
-            dst_pixel[x].alpha = 1.0F;
-        }
+        // Convert pixels directly, while adding a "dummy" alpha of 1.0
+        PixelConversion::expandRGBToRGBA((const float*)src_bits, (float*)dst_bits, width, 1.f);
         src_bits += src_pitch;
         dst_bits += dst_pitch;
     }
@@ -265,19 +280,18 @@ static FIBITMAP* convertToRGBA16Float(FIBITMAP* pDib)
     const BYTE* src_bits = (BYTE*)FreeImage_GetBits(pDib);
     BYTE* dst_bits = (BYTE*)FreeImage_GetBits(pNew);
 
+    // Source rows without alpha are first expanded to RGBA with a "dummy" alpha of 1.0.
+    std::vector<float> rgbaRow(type == FIT_RGBF ? width * 4 : 0);
+
     for (uint32_t y = 0; y < height; y++)
     {
-        const FIRGBAF* src_pixel = (FIRGBAF*)src_bits;
-        FIRGBA16* dst_pixel = (tagFIRGBA16*)dst_bits;
-
-        for (uint32_t x = 0; x < width; x++)
+        const float* pSrcRow = (const float*)src_bits;
+        if (type == FIT_RGBF)
         {
-            // Convert pixels to float16_t directly, while adding a "dummy" alpha of 1.0 if source format doesn't have alpha.
-            dst_pixel[x].red = float16_t(src_pixel[x].red).toBits();
-            dst_pixel[x].green = float16_t(src_pixel[x].green).toBits();
-            dst_pixel[x].blue = float16_t(src_pixel[x].blue).toBits();
-            dst_pixel[x].alpha = float16_t(type == FIT_RGBAF ? src_pixel[x].alpha : 1.0f).toBits();
+            PixelConversion::expandRGBToRGBA(pSrcRow, rgbaRow.data(), width, 1.f);
+            pSrcRow = rgbaRow.data();
         }
+        PixelConversion::float32ToFloat16(pSrcRow, (uint16_t*)dst_bits, width * 4);
         src_bits += src_pitch;
         dst_bits += dst_pitch;
     }
@@ -328,6 +342,17 @@ Bitmap::UniqueConstPtr Bitmap::createFromFile(const std::filesystem::path& path,
 
     if (fifFormat == FIF_EXR)
     {
+        // Decode with OpenEXR directly. This is multithreaded and keeps half-float images in half-float.
+        // Files without RGBA channels or with subsampled channels fall back to FreeImage.
+        try
+        {
+            return createFromExr(file, isTopDown, importFlags, ExrLoadOptions());
+        }
+        catch (const std::exception& e)
+        {
+            logDebug("Loading '{}' with FreeImage: {}", path, e.what());
+        }
+
         if (isFloat16Exr(file))
             importFlags |= ImportFlags::ConvertToFloat16;
     }
@@ -448,6 +473,136 @@ Bitmap::UniqueConstPtr Bitmap::createFromFile(const std::filesystem::path& path,
     return pBmp;
 }
 
+Bitmap::UniqueConstPtr Bitmap::createFromExrFile(
+    const std::filesystem::path& path,
+    bool isTopDown,
+    ImportFlags importFlags,
+    const ExrLoadOptions& options
+)
+{
+    if (!std::filesystem::exists(path))
+    {
+        logWarning("Error when loading image file. File '{}' does not exist.", path);
+        return nullptr;
+    }
+
+    MemoryMappedFile file(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+    if (!file.isOpen())
+    {
+        genWarning("Can't open image file", path);
+        return nullptr;
+    }
+
+    try
+    {
+        return createFromExr(file, isTopDown, importFlags, options);
+    }
+    catch (const std::exception& e)
+    {
+        genWarning(e.what(), path);
+        return nullptr;
+    }
+}
+
+Bitmap::UniqueConstPtr Bitmap::createFromExr(
+    const MemoryMappedFile& file,
+    bool isTopDown,
+    ImportFlags importFlags,
+    const ExrLoadOptions& options
+)
+{
+    const uint32_t threadCount = getExrThreadCount(options.threadCount);
+
+    OpenExrStream stream(file);
+    Imf::InputFile exrFile(stream, threadCount > 1 ? (int)threadCount : 0);
+    const Imf::Header& header = exrFile.header();
+    const Imath::Box2i dataWindow = header.dataWindow();
+    const uint2 dataSize = uint2(dataWindow.max.x - dataWindow.min.x + 1, dataWindow.max.y - dataWindow.min.y + 1);
+
+    // Resolve the region to load.
+    const uint2 offset = options.windowOffset;
+    FALCOR_CHECK(all(offset < dataSize), "Window offset ({}, {}) is outside the data window.", offset.x, offset.y);
+    const uint2 size = uint2(
+        options.windowSize.x == 0 ? dataSize.x - offset.x : options.windowSize.x,
+        options.windowSize.y == 0 ? dataSize.y - offset.y : options.windowSize.y
+    );
+    FALCOR_CHECK(all(offset + size <= dataSize), "Window of size ({}, {}) is outside the data window.", size.x, size.y);
+
+    // Resolve the channels to load. Half-float channels are decoded directly into a half-float image.
+    std::array<bool, 4> hasChannel = {};
+    bool allHalf = true;
+    for (uint32_t c = 0; c < 4; c++)
+    {
+        const Imf::Channel* pChannel = options.channels[c].empty() ? nullptr : header.channels().findChannel(options.channels[c]);
+        if (!pChannel)
+            continue;
+        FALCOR_CHECK(
+            pChannel->xSampling == 1 && pChannel->ySampling == 1, "Subsampled channel '{}' is not supported.", options.channels[c]
+        );
+        hasChannel[c] = true;
+        allHalf = allHalf && pChannel->type == Imf::HALF;
+    }
+    FALCOR_CHECK(std::any_of(hasChannel.begin(), hasChannel.end(), [](bool b) { return b; }), "None of the requested channels exist.");
+
+    const bool isHalf = allHalf || is_set(importFlags, ImportFlags::ConvertToFloat16);
+    const ResourceFormat format = isHalf ? ResourceFormat::RGBA16Float : ResourceFormat::RGBA32Float;
+    const Imf::PixelType pixelType = isHalf ? Imf::HALF : Imf::FLOAT;
+    const size_t componentSize = isHalf ? sizeof(uint16_t) : sizeof(float);
+    const size_t texelSize = 4 * componentSize;
+
+    UniquePtr pBmp = UniquePtr(new Bitmap(size.x, size.y, format));
+
+    // OpenEXR always writes full rows of the data window. Rows are decoded into a staging buffer first
+    // if the region is narrower than the data window or if the rows have to be flipped.
+    const bool useStaging = size.x != dataSize.x || !isTopDown;
+    const size_t stagingPitch = dataSize.x * texelSize;
+    uint32_t rowsPerChunk = kExrRowsPerThread * threadCount;
+    if (useStaging)
+        rowsPerChunk = std::clamp(uint32_t(kExrMaxStagingSize / stagingPitch), 1u, rowsPerChunk);
+    std::vector<uint8_t> staging(useStaging ? stagingPitch * rowsPerChunk : 0);
+
+    // Decode chunks of rows. OpenEXR decodes the scanline blocks or tiles of each chunk in parallel.
+    for (uint32_t firstRow = 0; firstRow < size.y; firstRow += rowsPerChunk)
+    {
+        const uint32_t rowCount = std::min(rowsPerChunk, size.y - firstRow);
+        const int y = dataWindow.min.y + (int)(offset.y + firstRow);
+
+        uint8_t* pDst = useStaging ? staging.data() : pBmp->getData() + firstRow * size_t(pBmp->getRowPitch());
+        const size_t dstPitch = useStaging ? stagingPitch : pBmp->getRowPitch();
+
+        // Slices are addressed with absolute pixel coordinates.
+        Imf::FrameBuffer frameBuffer;
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            if (!hasChannel[c])
+                continue;
+            char* pBase = reinterpret_cast<char*>(pDst + c * componentSize) - ptrdiff_t(dataWindow.min.x) * ptrdiff_t(texelSize) -
+                          ptrdiff_t(y) * ptrdiff_t(dstPitch);
+            frameBuffer.insert(options.channels[c], Imf::Slice(pixelType, pBase, texelSize, dstPitch));
+        }
+        exrFile.setFrameBuffer(frameBuffer);
+        exrFile.readPixels(y, y + (int)rowCount - 1);
+
+        for (uint32_t row = firstRow; row < firstRow + rowCount; row++)
+        {
+            uint8_t* pRow = pBmp->getData() + (isTopDown ? row : size.y - 1 - row) * size_t(pBmp->getRowPitch());
+            if (useStaging)
+                std::memcpy(pRow, staging.data() + (row - firstRow) * stagingPitch + offset.x * texelSize, size.x * texelSize);
+
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                if (!hasChannel[c])
+                    fillComponent(pRow, size.x, c, isHalf, c == 3 ? 1.f : 0.f);
+            }
+        }
+
+        if (options.rowCallback)
+            options.rowCallback(firstRow, rowCount);
+    }
+
+    return pBmp;
+}
+
 Bitmap::Bitmap(uint32_t width, uint32_t height, ResourceFormat format)
     : mWidth(width), mHeight(height), mRowPitch(getFormatRowPitch(format, width)), mFormat(format)
 {
@@ -615,17 +770,8 @@ void Bitmap::saveImage(
     if (resourceFormat == ResourceFormat::RGBA8Unorm || resourceFormat == ResourceFormat::RGBA8Snorm ||
         resourceFormat == ResourceFormat::RGBA8UnormSrgb)
     {
-        for (uint32_t a = 0; a < width * height; a++)
-        {
-            uint32_t* pPixel = (uint32_t*)pData;
-            pPixel += a;
-            uint8_t* ch = (uint8_t*)pPixel;
-            std::swap(ch[0], ch[2]);
-            if (is_set(exportFlags, ExportFlags::ExportAlpha) == false)
-            {
-                ch[3] = 0xff;
-            }
-        }
+        const uint8_t alpha = is_set(exportFlags, ExportFlags::ExportAlpha) ? 3 : PixelConversion::kSwizzleOne;
+        PixelConversion::swizzle8((uint8_t*)pData, (uint8_t*)pData, width * height, {2, 1, 0, alpha});
     }
 
     if (fileFormat == Bitmap::FileFormat::PfmFile || fileFormat == Bitmap::FileFormat::ExrFile)
@@ -669,12 +815,7 @@ void Bitmap::saveImage(
             else
             {
                 FALCOR_ASSERT(exportAlpha == false);
-                for (unsigned x = 0; x < width; x++)
-                {
-                    dstBits[x * 3 + 0] = (((float*)head)[x * 4 + 0]);
-                    dstBits[x * 3 + 1] = (((float*)head)[x * 4 + 1]);
-                    dstBits[x * 3 + 2] = (((float*)head)[x * 4 + 2]);
-                }
+                PixelConversion::dropAlpha((const float*)head, dstBits, width);
             }
             head += bytesPerPixel * width;
         }
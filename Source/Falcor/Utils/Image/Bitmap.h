@@ -29,12 +29,17 @@
 #include "Core/Macros.h"
 #include "Core/Platform/OS.h"
 #include "Core/API/Formats.h"
+#include "Utils/Math/Vector.h"
+#include <array>
+#include <functional>
 #include <memory>
 #include <filesystem>
+#include <string>
 
 namespace Falcor
 {
 class Texture;
+class MemoryMappedFile;
 
 /**
  * A class representing a memory bitmap
@@ -72,6 +77,29 @@ public:
     using UniquePtr = std::unique_ptr<Bitmap>;
     using UniqueConstPtr = std::unique_ptr<const Bitmap>;
 
+    /// Function called when a range of rows [firstRow, firstRow + rowCount) has been decoded. Rows are counted from the top.
+    using RowCallback = std::function<void(uint32_t firstRow, uint32_t rowCount)>;
+
+    /**
+     * Options for loading OpenEXR files.
+     * Images are decoded into RGBA16Float if all loaded channels are 16-bit float (or ImportFlags::ConvertToFloat16 is set),
+     * and into RGBA32Float otherwise.
+     */
+    struct ExrLoadOptions
+    {
+        /// Names of the channels to load into the R, G, B and A components. Components with an empty name or a name
+        /// that does not exist in the file are set to 0, or 1 for alpha. At least one channel must exist.
+        std::array<std::string, 4> channels = {"R", "G", "B", "A"};
+        /// Offset of the region to load, relative to the data window origin.
+        uint2 windowOffset = uint2(0);
+        /// Size of the region to load. Zero components load the remainder of the data window.
+        uint2 windowSize = uint2(0);
+        /// Number of threads decoding scanline blocks or tiles. Zero uses the hardware concurrency, one decodes on the calling thread.
+        uint32_t threadCount = 0;
+        /// Optional function called as rows are decoded, in top-down order. Decoded rows can be read while later rows are decoding.
+        RowCallback rowCallback;
+    };
+
     /**
      * Create from memory.
      * @param[in] width Width in pixels.
@@ -92,6 +120,23 @@ public:
      */
     static UniqueConstPtr createFromFile(const std::filesystem::path& path, bool isTopDown, ImportFlags importFlags = ImportFlags::None);
 
+    /**
+     * Create a new object from an OpenEXR file.
+     * This decodes the file with multiple threads, optionally only loading a part of the image.
+     * createFromFile() uses this with the default options for EXR files.
+     * @param[in] path Path to load from (absolute or relative to working directory).
+     * @param[in] isTopDown Control the memory layout of the image. See createFromFile().
+     * @param[in] importFlags Flags to control how the file is imported. See ImportFlags above.
+     * @param[in] options Options selecting channels, region and threading. See ExrLoadOptions above.
+     * @return If loading was successful, a new object. Otherwise, nullptr.
+     */
+    static UniqueConstPtr createFromExrFile(
+        const std::filesystem::path& path,
+        bool isTopDown,
+        ImportFlags importFlags,
+        const ExrLoadOptions& options
+    );
+
     /**
      * Store a memory buffer to a file.
      * @param[in] path Path to write to.
@@ -162,6 +207,14 @@ protected:
     Bitmap(uint32_t width, uint32_t height, ResourceFormat format);
     Bitmap(uint32_t width, uint32_t height, ResourceFormat format, const uint8_t* pData);
 
+    /// Decode an OpenEXR file. Throws an exception on failure.
+    static UniqueConstPtr createFromExr(
+        const MemoryMappedFile& file,
+        bool isTopDown,
+        ImportFlags importFlags,
+        const ExrLoadOptions& options
+    );
+
     std::unique_ptr<uint8_t[]> mpData;
     uint32_t mWidth = 0;    ///< Width in pixels.
     uint32_t mHeight = 0;   ///< Height in pixels.
@@ -26,11 +26,13 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "ImageIO.h"
+#include "PixelConversion.h"
 #include "Core/Error.h"
 #include "Core/API/Device.h"
 #include "Core/API/CopyContext.h"
 #include "Core/API/NativeFormats.h"
 #include "Core/Platform/MemoryMappedFile.h"
+#include "Utils/Math/Common.h"
 #include "Utils/Math/ScalarMath.h"
 #include "Utils/Logger.h"
 
@@ -38,6 +40,7 @@
 #include <nvtt/nvtt.h>
 
 #include <filesystem>
+#include <type_traits>
 
 namespace Falcor
 {
@@ -277,6 +280,27 @@ void setImage(
     T* dst = (T*)modified.data();
     for (uint32_t h = 0; h < image.height; ++h)
     {
+        // Fast paths for the common layouts that only reorder channels.
+        if constexpr (sizeof(T) == 1)
+        {
+            if (channelCount == 4)
+            {
+                std::array<uint8_t, 4> order = reverseRB ? std::array<uint8_t, 4>{2, 1, 0, 3} : std::array<uint8_t, 4>{0, 1, 2, 3};
+                const uint8_t* pSrcRow = (const uint8_t*)(src + 4 * h * srcWidth);
+                uint8_t* pDstRow = (uint8_t*)(dst + 4 * h * image.width);
+                PixelConversion::swizzle8(pSrcRow, pDstRow, image.width, order);
+                continue;
+            }
+        }
+        if constexpr (std::is_same_v<T, float>)
+        {
+            if (channelCount == 3)
+            {
+                PixelConversion::expandRGBToRGBA(src + 3 * h * srcWidth, dst + 4 * h * image.width, image.width, 0.f);
+                continue;
+            }
+        }
+
         for (uint32_t w = 0; w < image.width; ++w)
         {
             uint32_t i = h * srcWidth + w;    // Source data index
@@ -519,8 +543,17 @@ void readDDSHeader(ImportData& data, const void* pHeaderData, size_t& headerSize
     }
 }
 
+// Returns the size in bytes of a single 2D image of the given format and dimensions.
+size_t getImageSize(ResourceFormat format, uint32_t width, uint32_t height)
+{
+    size_t widthInBlocks = div_round_up(width, getFormatWidthCompressionRatio(format));
+    size_t heightInBlocks = div_round_up(height, getFormatHeightCompressionRatio(format));
+    return widthInBlocks * heightInBlocks * getFormatBytesPerBlock(format);
+}
+
 // Loads the information and data for the specified image. This function does not handle creation of the texture for the image.
-void loadDDS(const std::filesystem::path& path, bool loadAsSrgb, ImportData& data)
+// If mostDetailedMip is non-zero, the data of the finer mip levels is skipped (only supported for non-array 2D textures).
+void loadDDS(const std::filesystem::path& path, bool loadAsSrgb, ImportData& data, uint32_t mostDetailedMip = 0)
 {
     MemoryMappedFile file(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
     if (!file.isOpen())
@@ -547,10 +580,51 @@ void loadDDS(const std::filesystem::path& path, bool loadAsSrgb, ImportData& dat
         FALCOR_THROW("No image data after DDS header.");
     }
 
+    // Skip the data of mip levels finer than the requested one.
+    size_t skipSize = 0;
+    if (mostDetailedMip > 0)
+    {
+        if (data.type != Resource::Type::Texture2D || data.arraySize != 1)
+        {
+            FALCOR_THROW("Loading from a mip level other than 0 is only supported for non-array 2D textures.");
+        }
+        if (mostDetailedMip >= data.mipLevels)
+        {
+            FALCOR_THROW("Mip level {} is out of range (texture has {} mip levels).", mostDetailedMip, data.mipLevels);
+        }
+        for (uint32_t mip = 0; mip < mostDetailedMip; ++mip)
+        {
+            skipSize += getImageSize(data.format, std::max(1u, data.width >> mip), std::max(1u, data.height >> mip));
+        }
+        data.width = std::max(1u, data.width >> mostDetailedMip);
+        data.height = std::max(1u, data.height >> mostDetailedMip);
+        data.mipLevels -= mostDetailedMip;
+
+        // The most detailed level of a block-compressed texture needs to be a multiple of the block size.
+        const uint32_t blockWidth = getFormatWidthCompressionRatio(data.format);
+        const uint32_t blockHeight = getFormatHeightCompressionRatio(data.format);
+        if (data.width % blockWidth != 0 || data.height % blockHeight != 0)
+        {
+            FALCOR_THROW(
+                "Mip level {} ({}x{}) is not a multiple of the block size ({}x{}).",
+                mostDetailedMip,
+                data.width,
+                data.height,
+                blockWidth,
+                blockHeight
+            );
+        }
+    }
+
+    if (file.getSize() <= headerSize + skipSize)
+    {
+        FALCOR_THROW("No image data for the requested mip levels.");
+    }
+
     // Read image data.
-    size_t imageSize = file.getSize() - headerSize;
+    size_t imageSize = file.getSize() - headerSize - skipSize;
     data.imageData.resize(imageSize);
-    std::memcpy(data.imageData.data(), reinterpret_cast<const uint8_t*>(file.getData()) + headerSize, imageSize);
+    std::memcpy(data.imageData.data(), reinterpret_cast<const uint8_t*>(file.getData()) + headerSize + skipSize, imageSize);
 }
 } // namespace
 
@@ -577,12 +651,17 @@ Bitmap::UniqueConstPtr ImageIO::loadBitmapFromDDS(const std::filesystem::path& p
     return Bitmap::create(data.width, data.height, data.format, data.imageData.data());
 }
 
-ref<Texture> ImageIO::loadTextureFromDDS(ref<Device> pDevice, const std::filesystem::path& path, bool loadAsSrgb)
+ref<Texture> ImageIO::loadTextureFromDDS(
+    ref<Device> pDevice,
+    const std::filesystem::path& path,
+    bool loadAsSrgb,
+    uint32_t mostDetailedMip
+)
 {
     ImportData data;
     try
     {
-        loadDDS(path, loadAsSrgb, data);
+        loadDDS(path, loadAsSrgb, data, mostDetailedMip);
     }
     catch (const RuntimeError& e)
     {
@@ -619,6 +698,50 @@ ref<Texture> ImageIO::loadTextureFromDDS(ref<Device> pDevice, const std::filesys
     return pTex;
 }
 
+std::vector<uint64_t> ImageIO::getDDSMipSizes(const std::filesystem::path& path)
+{
+    ImportData data;
+    try
+    {
+        MemoryMappedFile file(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+        if (!file.isOpen() || file.getSize() < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
+            return {};
+
+        const size_t maxHeaderSize = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+        uint8_t header[maxHeaderSize] = {};
+        size_t headerSize = maxHeaderSize;
+        std::memcpy(header, file.getData(), std::min<size_t>(file.getSize(), headerSize));
+        readDDSHeader(data, header, headerSize, false);
+    }
+    catch (const RuntimeError& e)
+    {
+        logWarning("Failed to read DDS header from '{}': {}", path, e.what());
+        return {};
+    }
+
+    if (data.type != Resource::Type::Texture2D || data.arraySize != 1)
+        return {};
+
+    // Block-compressed levels that are not a multiple of the block size can't be the most detailed level of a texture.
+    // They and all coarser levels are counted as part of the last level that can.
+    std::vector<uint64_t> mipSizes;
+    const uint32_t blockWidth = getFormatWidthCompressionRatio(data.format);
+    const uint32_t blockHeight = getFormatHeightCompressionRatio(data.format);
+    bool isLoadable = true;
+    for (uint32_t mip = 0; mip < data.mipLevels; ++mip)
+    {
+        const uint32_t width = std::max(1u, data.width >> mip);
+        const uint32_t height = std::max(1u, data.height >> mip);
+        const uint64_t size = getImageSize(data.format, width, height);
+        isLoadable = isLoadable && (mip == 0 || (width % blockWidth == 0 && height % blockHeight == 0));
+        if (isLoadable)
+            mipSizes.push_back(size);
+        else
+            mipSizes.back() += size;
+    }
+    return mipSizes;
+}
+
 void ImageIO::saveToDDS(const std::filesystem::path& path, const Bitmap& bitmap, CompressionMode mode, bool generateMips)
 {
     if (!hasExtension(path, "dds"))
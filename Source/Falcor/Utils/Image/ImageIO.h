@@ -30,6 +30,7 @@
 #include "Core/Macros.h"
 #include "Core/API/Texture.h"
 #include <filesystem>
+#include <vector>
 
 namespace Falcor
 {
@@ -86,9 +87,26 @@ public:
      * @param[in] path Path of file to load.
      * @param[in] loadAsSrgb If true, convert the image format property to a corresponding sRGB format if available. Image data is not
      * changed.
+     * @param[in] mostDetailedMip Most detailed mip level to load. Finer levels are skipped and the texture is created with the remaining
+     * mip chain. Values other than 0 are only supported for non-array 2D textures. For block-compressed formats, the size of the mip
+     * level must be a multiple of the block size.
      * @return Texture object containing image data if loading was successful. Otherwise, nullptr.
      */
-    static ref<Texture> loadTextureFromDDS(ref<Device> pDevice, const std::filesystem::path& path, bool loadAsSrgb);
+    static ref<Texture> loadTextureFromDDS(
+        ref<Device> pDevice,
+        const std::filesystem::path& path,
+        bool loadAsSrgb,
+        uint32_t mostDetailedMip = 0
+    );
+
+    /**
+     * Get the size in bytes of each mip level of a 2D DDS texture. Only the header is read.
+     * Only mip levels that can be loaded as the most detailed level are listed. For block-compressed formats, coarser levels that are
+     * not a multiple of the block size are included in the size of the last listed level.
+     * @param[in] path Path of file to read.
+     * @return Mip level sizes, most detailed first, or an empty list if the file can't be read or is not a non-array 2D texture.
+     */
+    static std::vector<uint64_t> getDDSMipSizes(const std::filesystem::path& path);
 
     /**
      * Saves a bitmap to a DDS file.
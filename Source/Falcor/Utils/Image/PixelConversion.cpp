@@ -0,0 +1,679 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "PixelConversion.h"
+#include "Core/Error.h"
+#include "Utils/Math/Common.h"
+#include "Utils/Math/Float16.h"
+#include "Utils/TaskManager.h"
+#include "Utils/Color/ColorHelpers.slang"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FALCOR_PIXEL_CONVERSION_AVX2 1
+#include <immintrin.h>
+#if FALCOR_MSVC
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#else
+#define FALCOR_PIXEL_CONVERSION_AVX2 0
+#endif
+
+// GCC and Clang need the instruction set enabled per function, MSVC allows intrinsics in any function.
+#if FALCOR_MSVC
+#define FALCOR_TARGET_AVX2
+#else
+#define FALCOR_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#endif
+
+namespace Falcor
+{
+namespace PixelConversion
+{
+namespace
+{
+/// Number of elements per parallel block.
+constexpr size_t kBlockSize = 1 << 16;
+
+template<typename S, typename D>
+using Kernel = void (*)(const S*, D*, size_t);
+
+bool detectSimdSupport()
+{
+#if FALCOR_PIXEL_CONVERSION_AVX2
+#if FALCOR_MSVC
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    const bool osxsave = info[2] & (1 << 27);
+    const bool avx = info[2] & (1 << 28);
+    const bool f16c = info[2] & (1 << 29);
+    if (!osxsave || !avx || !f16c || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 5);
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_F16C))
+        return false;
+    return __builtin_cpu_supports("avx2");
+#endif
+#else
+    return false;
+#endif
+}
+
+std::atomic<bool>& getSimdEnabled()
+{
+    static std::atomic<bool> enabled{isSimdSupported()};
+    return enabled;
+}
+
+/// Call func(begin, end) for blocks of elements, in parallel for large counts.
+template<typename F>
+void forEachBlock(size_t count, F func)
+{
+    if (count <= kBlockSize)
+    {
+        func(size_t(0), count);
+        return;
+    }
+
+    parallelFor(
+        0,
+        div_round_up(count, kBlockSize),
+        [&](size_t block)
+        {
+            size_t begin = block * kBlockSize;
+            func(begin, std::min(begin + kBlockSize, count));
+        }
+    );
+}
+
+template<typename T>
+struct Identity
+{
+    using type = T;
+};
+
+/// Select the vectorized kernel if available and enabled.
+template<typename F>
+F selectKernel(F scalarKernel, typename Identity<F>::type simdKernel)
+{
+    return (simdKernel && isSimdEnabled()) ? simdKernel : scalarKernel;
+}
+
+template<typename S, typename D>
+void run(const S* pSrc, D* pDst, size_t count, Kernel<S, D> scalarKernel, Kernel<S, D> simdKernel)
+{
+    Kernel<S, D> kernel = selectKernel(scalarKernel, simdKernel);
+    forEachBlock(count, [&](size_t begin, size_t end) { kernel(pSrc + begin, pDst + begin, end - begin); });
+}
+
+/// Lookup table for sRGB decoding of unorm8 values.
+const float* getSrgbDecodeTable()
+{
+    static const std::array<float, 256> table = []()
+    {
+        std::array<float, 256> t;
+        for (uint32_t i = 0; i < 256; ++i)
+            t[i] = sRGBToLinear(i / 255.f);
+        return t;
+    }();
+    return table.data();
+}
+
+/// Thresholds for sRGB encoding to unorm8. Entry k - 1 holds the smallest linear value encoded as k.
+const float* getSrgbEncodeThresholds()
+{
+    static const std::array<float, 255> table = []()
+    {
+        std::array<float, 255> t;
+        for (uint32_t k = 1; k < 256; ++k)
+        {
+            double srgb = (k - 0.5) / 255.0;
+            double linear = srgb <= 0.04045 ? srgb / 12.92 : std::pow((srgb + 0.055) / 1.055, 2.4);
+            t[k - 1] = (float)linear;
+        }
+        return t;
+    }();
+    return table.data();
+}
+
+namespace scalar
+{
+void float16ToFloat32(const uint16_t* pSrc, float* pDst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        pDst[i] = math::float16ToFloat32(pSrc[i]);
+}
+
+void float32ToFloat16(const float* pSrc, uint16_t* pDst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        pDst[i] = math::float32ToFloat16(pSrc[i]);
+}
+
+template<typename T>
+void normalizedToFloat32(const T* pSrc, float* pDst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        pDst[i] = float(pSrc[i]) / float(std::numeric_limits<T>::max());
+}
+
+template<typename T>
+void float32ToUnorm(const float* pSrc, T* pDst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        float value = pSrc[i] > 0.f ? std::min(pSrc[i], 1.f) : 0.f;
+        pDst[i] = T(value * float(std::numeric_limits<T>::max()) + 0.5f);
+    }
+}
+
+void srgb8ToLinearFloat32(const uint8_t* pSrc, float* pDst, size_t count)
+{
+    const float* pTable = getSrgbDecodeTable();
+    for (size_t i = 0; i < count; ++i)
+        pDst[i] = pTable[pSrc[i]];
+}
+
+void linearFloat32ToSrgb8(const float* pSrc, uint8_t* pDst, size_t count)
+{
+    const float* pThresholds = getSrgbEncodeThresholds();
+    for (size_t i = 0; i < count; ++i)
+    {
+        // Count the thresholds below the value by binary search. NaN fails all comparisons and maps to 0.
+        uint32_t code = 0;
+        for (uint32_t step = 128; step > 0; step >>= 1)
+        {
+            if (pSrc[i] >= pThresholds[code + step - 1])
+                code += step;
+        }
+        pDst[i] = uint8_t(code);
+    }
+}
+
+void expandRGBToRGBA(const float* pSrc, float* pDst, size_t pixelCount, float alpha)
+{
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        pDst[4 * i + 0] = pSrc[3 * i + 0];
+        pDst[4 * i + 1] = pSrc[3 * i + 1];
+        pDst[4 * i + 2] = pSrc[3 * i + 2];
+        pDst[4 * i + 3] = alpha;
+    }
+}
+
+void dropAlpha(const float* pSrc, float* pDst, size_t pixelCount)
+{
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        pDst[3 * i + 0] = pSrc[4 * i + 0];
+        pDst[3 * i + 1] = pSrc[4 * i + 1];
+        pDst[3 * i + 2] = pSrc[4 * i + 2];
+    }
+}
+
+void swizzle8(const uint8_t* pSrc, uint8_t* pDst, size_t pixelCount, const std::array<uint8_t, 4>& order)
+{
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        uint8_t pixel[5] = {pSrc[4 * i + 0], pSrc[4 * i + 1], pSrc[4 * i + 2], pSrc[4 * i + 3], 0xff};
+        for (size_t c = 0; c < 4; ++c)
+            pDst[4 * i + c] = pixel[order[c]];
+    }
+}
+} // namespace scalar
+
+#if FALCOR_PIXEL_CONVERSION_AVX2
+namespace avx2
+{
+FALCOR_TARGET_AVX2 void float16ToFloat32(const uint16_t* pSrc, float* pDst, size_t count)
+{
+    const __m128i absMask = _mm_set1_epi16(0x7fff);
+    const __m128i infBits = _mm_set1_epi16(0x7c00);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i h = _mm_loadu_si128((const __m128i*)(pSrc + i));
+        // F16C quiets signaling NaNs while the reference preserves all NaN bits, so use scalar code for NaNs.
+        __m128i isNan = _mm_cmpgt_epi16(_mm_and_si128(h, absMask), infBits);
+        if (_mm_movemask_epi8(isNan) == 0)
+            _mm256_storeu_ps(pDst + i, _mm256_cvtph_ps(h));
+        else
+            scalar::float16ToFloat32(pSrc + i, pDst + i, 8);
+    }
+    scalar::float16ToFloat32(pSrc + i, pDst + i, count - i);
+}
+
+FALCOR_TARGET_AVX2 void float32ToFloat16(const float* pSrc, uint16_t* pDst, size_t count)
+{
+    // F16C rounds ties to even and handles denormals differently from the reference,
+    // so this emulates math::float32ToFloat16() with integer operations.
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i signMask = _mm256_set1_epi32(0x8000);
+    const __m256i exponentMask = _mm256_set1_epi32(0xff);
+    const __m256i significandMask = _mm256_set1_epi32(0x7fffff);
+    const __m256i implicitOne = _mm256_set1_epi32(0x800000);
+    const __m256i roundBit = _mm256_set1_epi32(0x1000);
+    const __m256i infBits = _mm256_set1_epi32(0x7c00);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(pSrc + i));
+        __m256i s = _mm256_and_si256(_mm256_srli_epi32(x, 16), signMask);
+        __m256i e = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(x, 23), exponentMask), _mm256_set1_epi32(127 - 15));
+        __m256i m = _mm256_and_si256(x, significandMask);
+
+        // Normalized half. Round to nearest with ties up, carrying significand overflow into the exponent.
+        __m256i mr = _mm256_add_epi32(m, _mm256_slli_epi32(_mm256_and_si256(m, roundBit), 1));
+        __m256i er = _mm256_add_epi32(e, _mm256_srli_epi32(mr, 23));
+        __m256i mn = _mm256_srli_epi32(_mm256_and_si256(mr, significandMask), 13);
+        __m256i result = _mm256_or_si256(s, _mm256_or_si256(_mm256_slli_epi32(er, 10), mn));
+        result = _mm256_blendv_epi8(result, _mm256_or_si256(s, infBits), _mm256_cmpgt_epi32(er, _mm256_set1_epi32(30)));
+
+        // Infinity or NaN. NaNs keep their 10 leftmost significand bits, with at least one bit set.
+        __m256i mNan = _mm256_srli_epi32(m, 13);
+        __m256i nanBit = _mm256_andnot_si256(_mm256_cmpeq_epi32(m, zero), _mm256_and_si256(_mm256_cmpeq_epi32(mNan, zero), one));
+        __m256i special = _mm256_or_si256(_mm256_or_si256(s, infBits), _mm256_or_si256(mNan, nanBit));
+        result = _mm256_blendv_epi8(result, special, _mm256_cmpeq_epi32(e, _mm256_set1_epi32(0xff - (127 - 15))));
+
+        // Denormalized half (e <= 0) and zero (e < -10).
+        __m256i md = _mm256_srlv_epi32(_mm256_or_si256(m, implicitOne), _mm256_sub_epi32(one, e));
+        md = _mm256_add_epi32(md, _mm256_slli_epi32(_mm256_and_si256(md, roundBit), 1));
+        result = _mm256_blendv_epi8(result, _mm256_or_si256(s, _mm256_srli_epi32(md, 13)), _mm256_cmpgt_epi32(one, e));
+        result = _mm256_blendv_epi8(result, s, _mm256_cmpgt_epi32(_mm256_set1_epi32(-10), e));
+
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(result, result), 0x08);
+        _mm_storeu_si128((__m128i*)(pDst + i), _mm256_castsi256_si128(packed));
+    }
+    scalar::float32ToFloat16(pSrc + i, pDst + i, count - i);
+}
+
+FALCOR_TARGET_AVX2 void uint8ToFloat32(const uint8_t* pSrc, float* pDst, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(float(std::numeric_limits<uint8_t>::max()));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(pSrc + i)));
+        _mm256_storeu_ps(pDst + i, _mm256_div_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    scalar::normalizedToFloat32(pSrc + i, pDst + i, count - i);
+}
+
+FALCOR_TARGET_AVX2 void uint16ToFloat32(const uint16_t* pSrc, float* pDst, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(float(std::numeric_limits<uint16_t>::max()));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(pSrc + i)));
+        _mm256_storeu_ps(pDst + i, _mm256_div_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    scalar::normalizedToFloat32(pSrc + i, pDst + i, count - i);
+}
+
+FALCOR_TARGET_AVX2 void uint32ToFloat32(const uint32_t* pSrc, float* pDst, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(float(std::numeric_limits<uint32_t>::max()));
+    const __m256i lowMask = _mm256_set1_epi32(0xffff);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        // There is no unsigned conversion in AVX2. Both halves and the scaled high half are exact,
+        // so the sum is rounded once, like a direct conversion.
+        __m256i v = _mm256_loadu_si256((const __m256i*)(pSrc + i));
+        __m256 high = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(v, 16)), _mm256_set1_ps(65536.f));
+        __m256 low = _mm256_cvtepi32_ps(_mm256_and_si256(v, lowMask));
+        _mm256_storeu_ps(pDst + i, _mm256_div_ps(_mm256_add_ps(high, low), scale));
+    }
+    scalar::normalizedToFloat32(pSrc + i, pDst + i, count - i);
+}
+
+FALCOR_TARGET_AVX2 void int16ToFloat32(const int16_t* pSrc, float* pDst, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(float(std::numeric_limits<int16_t>::max()));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(pSrc + i)));
+        _mm256_storeu_ps(pDst + i, _mm256_div_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    scalar::normalizedToFloat32(pSrc + i, pDst + i, count - i);
+}
+
+FALCOR_TARGET_AVX2 void int32ToFloat32(const int32_t* pSrc, float* pDst, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(float(std::numeric_limits<int32_t>::max()));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(pSrc + i));
+        _mm256_storeu_ps(pDst + i, _mm256_div_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    scalar::normalizedToFloat32(pSrc + i, pDst + i, count - i);
+}
+
+/// Clamp to [0, 1] and scale to integers with rounding. NaN maps to 0 as max returns the second operand for NaN.
+FALCOR_TARGET_AVX2 inline __m256i float32ToUnorm(__m256 value, float maxValue)
+{
+    value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, _mm256_set1_ps(maxValue)), _mm256_set1_ps(0.5f)));
+}
+
+FALCOR_TARGET_AVX2 void float32ToUnorm8(const float* pSrc, uint8_t* pDst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = float32ToUnorm(_mm256_loadu_ps(pSrc + i), 255.f);
+        v = _mm256_packus_epi32(v, v);
+        v = _mm256_packus_epi16(v, v);
+        uint32_t low = (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(v));
+        uint32_t high = (uint32_t)_mm_cvtsi128_si32(_mm256_extracti128_si256(v, 1));
+        std::memcpy(pDst + i, &low, 4);
+        std::memcpy(pDst + i + 4, &high, 4);
+    }
+    scalar::float32ToUnorm(pSrc + i, pDst + i, count - i);
+}
+
+FALCOR_TARGET_AVX2 void float32ToUnorm16(const float* pSrc, uint16_t* pDst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = float32ToUnorm(_mm256_loadu_ps(pSrc + i), 65535.f);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), 0x08);
+        _mm_storeu_si128((__m128i*)(pDst + i), _mm256_castsi256_si128(packed));
+    }
+    scalar::float32ToUnorm(pSrc + i, pDst + i, count - i);
+}
+
+FALCOR_TARGET_AVX2 void srgb8ToLinearFloat32(const uint8_t* pSrc, float* pDst, size_t count)
+{
+    const float* pTable = getSrgbDecodeTable();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(pSrc + i)));
+        _mm256_storeu_ps(pDst + i, _mm256_i32gather_ps(pTable, index, 4));
+    }
+    scalar::srgb8ToLinearFloat32(pSrc + i, pDst + i, count - i);
+}
+
+FALCOR_TARGET_AVX2 void linearFloat32ToSrgb8(const float* pSrc, uint8_t* pDst, size_t count)
+{
+    const float* pThresholds = getSrgbEncodeThresholds();
+    const __m256i one = _mm256_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 value = _mm256_loadu_ps(pSrc + i);
+        __m256i code = _mm256_setzero_si256();
+        for (int step = 128; step > 0; step >>= 1)
+        {
+            __m256i candidate = _mm256_add_epi32(code, _mm256_set1_epi32(step));
+            __m256 threshold = _mm256_i32gather_ps(pThresholds, _mm256_sub_epi32(candidate, one), 4);
+            __m256 isAbove = _mm256_cmp_ps(value, threshold, _CMP_GE_OQ);
+            code = _mm256_blendv_epi8(code, candidate, _mm256_castps_si256(isAbove));
+        }
+        code = _mm256_packus_epi32(code, code);
+        code = _mm256_packus_epi16(code, code);
+        uint32_t low = (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(code));
+        uint32_t high = (uint32_t)_mm_cvtsi128_si32(_mm256_extracti128_si256(code, 1));
+        std::memcpy(pDst + i, &low, 4);
+        std::memcpy(pDst + i + 4, &high, 4);
+    }
+    scalar::linearFloat32ToSrgb8(pSrc + i, pDst + i, count - i);
+}
+
+FALCOR_TARGET_AVX2 void expandRGBToRGBA(const float* pSrc, float* pDst, size_t pixelCount, float alpha)
+{
+    const __m128 a = _mm_set1_ps(alpha);
+    size_t i = 0;
+    // Loads four floats per pixel, so the last pixel is handled by scalar code to not read past the end.
+    for (; i + 1 < pixelCount; ++i)
+        _mm_storeu_ps(pDst + 4 * i, _mm_blend_ps(_mm_loadu_ps(pSrc + 3 * i), a, 0x8));
+    scalar::expandRGBToRGBA(pSrc + 3 * i, pDst + 4 * i, pixelCount - i, alpha);
+}
+
+FALCOR_TARGET_AVX2 void dropAlpha(const float* pSrc, float* pDst, size_t pixelCount)
+{
+    size_t i = 0;
+    // Stores four floats per pixel, the fourth is overwritten by the next pixel. The last pixel is handled by scalar code.
+    for (; i + 1 < pixelCount; ++i)
+        _mm_storeu_ps(pDst + 3 * i, _mm_loadu_ps(pSrc + 4 * i));
+    scalar::dropAlpha(pSrc + 4 * i, pDst + 3 * i, pixelCount - i);
+}
+
+FALCOR_TARGET_AVX2 void swizzle8(const uint8_t* pSrc, uint8_t* pDst, size_t pixelCount, const std::array<uint8_t, 4>& order)
+{
+    alignas(32) int8_t shuffle[32];
+    alignas(32) int8_t ones[32];
+    for (int i = 0; i < 32; ++i)
+    {
+        uint8_t channel = order[i % 4];
+        shuffle[i] = channel == kSwizzleOne ? int8_t(-128) : int8_t((i & ~3) % 16 + channel);
+        ones[i] = channel == kSwizzleOne ? int8_t(-1) : 0;
+    }
+    const __m256i shuffleMask = _mm256_load_si256((const __m256i*)shuffle);
+    const __m256i onesMask = _mm256_load_si256((const __m256i*)ones);
+
+    size_t i = 0;
+    for (; i + 8 <= pixelCount; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(pSrc + 4 * i));
+        v = _mm256_or_si256(_mm256_shuffle_epi8(v, shuffleMask), onesMask);
+        _mm256_storeu_si256((__m256i*)(pDst + 4 * i), v);
+    }
+    scalar::swizzle8(pSrc + 4 * i, pDst + 4 * i, pixelCount - i, order);
+}
+} // namespace avx2
+#define FALCOR_SIMD_KERNEL(name) avx2::name
+#else
+#define FALCOR_SIMD_KERNEL(name) nullptr
+#endif
+
+template<typename S>
+void toRGBA32Float(const S* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount, Kernel<S, float> kernel)
+{
+    FALCOR_CHECK(channelCount >= 1 && channelCount <= 4, "Channel count must be between 1 and 4.");
+
+    if (channelCount == 4)
+    {
+        forEachBlock(pixelCount * 4, [&](size_t begin, size_t end) { kernel(pSrc + begin, pDst + begin, end - begin); });
+        return;
+    }
+
+    forEachBlock(
+        pixelCount,
+        [&](size_t begin, size_t end)
+        {
+            // Convert the block's channel values, then expand to RGBA.
+            std::vector<float> values((end - begin) * channelCount);
+            kernel(pSrc + begin * channelCount, values.data(), values.size());
+
+            float* pBlockDst = pDst + 4 * begin;
+            if (channelCount == 3)
+            {
+                expandRGBToRGBA(values.data(), pBlockDst, end - begin, 1.f);
+                return;
+            }
+            for (size_t i = 0; i < end - begin; ++i)
+            {
+                for (uint32_t c = 0; c < 4; ++c)
+                    pBlockDst[4 * i + c] = c < channelCount ? values[i * channelCount + c] : (c == 3 ? 1.f : 0.f);
+            }
+        }
+    );
+}
+} // namespace
+
+bool isSimdSupported()
+{
+    static const bool supported = detectSimdSupport();
+    return supported;
+}
+
+void setSimdEnabled(bool enabled)
+{
+    getSimdEnabled() = enabled && isSimdSupported();
+}
+
+bool isSimdEnabled()
+{
+    return getSimdEnabled();
+}
+
+void float16ToFloat32(const uint16_t* pSrc, float* pDst, size_t count)
+{
+    run<uint16_t, float>(pSrc, pDst, count, scalar::float16ToFloat32, FALCOR_SIMD_KERNEL(float16ToFloat32));
+}
+
+void float32ToFloat16(const float* pSrc, uint16_t* pDst, size_t count)
+{
+    run<float, uint16_t>(pSrc, pDst, count, scalar::float32ToFloat16, FALCOR_SIMD_KERNEL(float32ToFloat16));
+}
+
+void normalizedToFloat32(const uint8_t* pSrc, float* pDst, size_t count)
+{
+    run<uint8_t, float>(pSrc, pDst, count, scalar::normalizedToFloat32<uint8_t>, FALCOR_SIMD_KERNEL(uint8ToFloat32));
+}
+
+void normalizedToFloat32(const uint16_t* pSrc, float* pDst, size_t count)
+{
+    run<uint16_t, float>(pSrc, pDst, count, scalar::normalizedToFloat32<uint16_t>, FALCOR_SIMD_KERNEL(uint16ToFloat32));
+}
+
+void normalizedToFloat32(const uint32_t* pSrc, float* pDst, size_t count)
+{
+    run<uint32_t, float>(pSrc, pDst, count, scalar::normalizedToFloat32<uint32_t>, FALCOR_SIMD_KERNEL(uint32ToFloat32));
+}
+
+void normalizedToFloat32(const int16_t* pSrc, float* pDst, size_t count)
+{
+    run<int16_t, float>(pSrc, pDst, count, scalar::normalizedToFloat32<int16_t>, FALCOR_SIMD_KERNEL(int16ToFloat32));
+}
+
+void normalizedToFloat32(const int32_t* pSrc, float* pDst, size_t count)
+{
+    run<int32_t, float>(pSrc, pDst, count, scalar::normalizedToFloat32<int32_t>, FALCOR_SIMD_KERNEL(int32ToFloat32));
+}
+
+void float32ToUnorm8(const float* pSrc, uint8_t* pDst, size_t count)
+{
+    run<float, uint8_t>(pSrc, pDst, count, scalar::float32ToUnorm<uint8_t>, FALCOR_SIMD_KERNEL(float32ToUnorm8));
+}
+
+void float32ToUnorm16(const float* pSrc, uint16_t* pDst, size_t count)
+{
+    run<float, uint16_t>(pSrc, pDst, count, scalar::float32ToUnorm<uint16_t>, FALCOR_SIMD_KERNEL(float32ToUnorm16));
+}
+
+void srgb8ToLinearFloat32(const uint8_t* pSrc, float* pDst, size_t count)
+{
+    run<uint8_t, float>(pSrc, pDst, count, scalar::srgb8ToLinearFloat32, FALCOR_SIMD_KERNEL(srgb8ToLinearFloat32));
+}
+
+void linearFloat32ToSrgb8(const float* pSrc, uint8_t* pDst, size_t count)
+{
+    run<float, uint8_t>(pSrc, pDst, count, scalar::linearFloat32ToSrgb8, FALCOR_SIMD_KERNEL(linearFloat32ToSrgb8));
+}
+
+void float16ToRGBA32Float(const uint16_t* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount)
+{
+    auto kernel = selectKernel<Kernel<uint16_t, float>>(scalar::float16ToFloat32, FALCOR_SIMD_KERNEL(float16ToFloat32));
+    toRGBA32Float(pSrc, channelCount, pDst, pixelCount, kernel);
+}
+
+void normalizedToRGBA32Float(const uint8_t* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount)
+{
+    auto kernel = selectKernel<Kernel<uint8_t, float>>(scalar::normalizedToFloat32<uint8_t>, FALCOR_SIMD_KERNEL(uint8ToFloat32));
+    toRGBA32Float(pSrc, channelCount, pDst, pixelCount, kernel);
+}
+
+void normalizedToRGBA32Float(const uint16_t* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount)
+{
+    auto kernel = selectKernel<Kernel<uint16_t, float>>(scalar::normalizedToFloat32<uint16_t>, FALCOR_SIMD_KERNEL(uint16ToFloat32));
+    toRGBA32Float(pSrc, channelCount, pDst, pixelCount, kernel);
+}
+
+void normalizedToRGBA32Float(const uint32_t* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount)
+{
+    auto kernel = selectKernel<Kernel<uint32_t, float>>(scalar::normalizedToFloat32<uint32_t>, FALCOR_SIMD_KERNEL(uint32ToFloat32));
+    toRGBA32Float(pSrc, channelCount, pDst, pixelCount, kernel);
+}
+
+void normalizedToRGBA32Float(const int16_t* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount)
+{
+    auto kernel = selectKernel<Kernel<int16_t, float>>(scalar::normalizedToFloat32<int16_t>, FALCOR_SIMD_KERNEL(int16ToFloat32));
+    toRGBA32Float(pSrc, channelCount, pDst, pixelCount, kernel);
+}
+
+void normalizedToRGBA32Float(const int32_t* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount)
+{
+    auto kernel = selectKernel<Kernel<int32_t, float>>(scalar::normalizedToFloat32<int32_t>, FALCOR_SIMD_KERNEL(int32ToFloat32));
+    toRGBA32Float(pSrc, channelCount, pDst, pixelCount, kernel);
+}
+
+void expandRGBToRGBA(const float* pSrc, float* pDst, size_t pixelCount, float alpha)
+{
+    auto kernel = selectKernel(scalar::expandRGBToRGBA, FALCOR_SIMD_KERNEL(expandRGBToRGBA));
+    forEachBlock(pixelCount, [&](size_t begin, size_t end) { kernel(pSrc + 3 * begin, pDst + 4 * begin, end - begin, alpha); });
+}
+
+void dropAlpha(const float* pSrc, float* pDst, size_t pixelCount)
+{
+    auto kernel = selectKernel(scalar::dropAlpha, FALCOR_SIMD_KERNEL(dropAlpha));
+    forEachBlock(pixelCount, [&](size_t begin, size_t end) { kernel(pSrc + 4 * begin, pDst + 3 * begin, end - begin); });
+}
+
+void swizzle8(const uint8_t* pSrc, uint8_t* pDst, size_t pixelCount, std::array<uint8_t, 4> order)
+{
+    for (uint8_t channel : order)
+        FALCOR_CHECK(channel <= kSwizzleOne, "Invalid channel index {}.", channel);
+
+    auto kernel = selectKernel(scalar::swizzle8, FALCOR_SIMD_KERNEL(swizzle8));
+    forEachBlock(pixelCount, [&](size_t begin, size_t end) { kernel(pSrc + 4 * begin, pDst + 4 * begin, end - begin, order); });
+}
+} // namespace PixelConversion
+} // namespace Falcor
@@ -0,0 +1,119 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Falcor
+{
+/**
+ * Pixel format conversion kernels.
+ *
+ * The kernels convert contiguous arrays of channel values. They are vectorized with AVX2/F16C when the CPU supports it
+ * (detected at runtime) and fall back to scalar code otherwise. Large arrays are split into blocks processed in parallel.
+ *
+ * All results are bit-exact to the scalar reference given for each function, independent of the code path taken.
+ * Source and destination arrays must not overlap unless noted otherwise.
+ */
+namespace PixelConversion
+{
+/// Returns true if the CPU supports the vectorized kernels.
+FALCOR_API bool isSimdSupported();
+
+/// Enable or disable the vectorized kernels (enabled by default if supported). Used for testing and benchmarking.
+FALCOR_API void setSimdEnabled(bool enabled);
+
+FALCOR_API bool isSimdEnabled();
+
+/// Convert half floats to floats. Reference: math::float16ToFloat32().
+FALCOR_API void float16ToFloat32(const uint16_t* pSrc, float* pDst, size_t count);
+
+/**
+ * Convert floats to half floats. Reference: math::float32ToFloat16().
+ * Note that overflow to infinity does not raise the floating-point overflow exception in the vectorized code path.
+ */
+FALCOR_API void float32ToFloat16(const float* pSrc, uint16_t* pDst, size_t count);
+
+/// Convert normalized integers to floats. Reference: float(value) / float(std::numeric_limits<T>::max()).
+FALCOR_API void normalizedToFloat32(const uint8_t* pSrc, float* pDst, size_t count);
+FALCOR_API void normalizedToFloat32(const uint16_t* pSrc, float* pDst, size_t count);
+FALCOR_API void normalizedToFloat32(const uint32_t* pSrc, float* pDst, size_t count);
+FALCOR_API void normalizedToFloat32(const int16_t* pSrc, float* pDst, size_t count);
+FALCOR_API void normalizedToFloat32(const int32_t* pSrc, float* pDst, size_t count);
+
+/// Convert floats to unorm8. Reference: uint8_t(clamp(value, 0, 1) * 255 + 0.5), with NaN mapping to 0.
+FALCOR_API void float32ToUnorm8(const float* pSrc, uint8_t* pDst, size_t count);
+
+/// Convert floats to unorm16. Reference: uint16_t(clamp(value, 0, 1) * 65535 + 0.5), with NaN mapping to 0.
+FALCOR_API void float32ToUnorm16(const float* pSrc, uint16_t* pDst, size_t count);
+
+/// Decode sRGB encoded unorm8 values to linear floats. Reference: sRGBToLinear(value / 255.f).
+FALCOR_API void srgb8ToLinearFloat32(const uint8_t* pSrc, float* pDst, size_t count);
+
+/**
+ * Encode linear floats to sRGB encoded unorm8 values.
+ * Each value is rounded to the nearest code on the exact sRGB curve: the result is the number of codes k in [1, 255]
+ * for which the value is at least sRGBToLinear((k - 0.5) / 255), with thresholds evaluated in double precision.
+ * NaN maps to 0.
+ */
+FALCOR_API void linearFloat32ToSrgb8(const float* pSrc, uint8_t* pDst, size_t count);
+
+/**
+ * Convert images with 1-4 channels per pixel to RGBA float. Missing color channels are set to 0 and missing alpha to 1.
+ * Channel values are converted with float16ToFloat32() for half floats and normalizedToFloat32() for integers.
+ * @param[in] pSrc Source pixels with channelCount values each.
+ * @param[in] channelCount Number of channels in the source (1-4).
+ * @param[out] pDst Destination pixels with 4 floats each.
+ * @param[in] pixelCount Number of pixels.
+ */
+FALCOR_API void float16ToRGBA32Float(const uint16_t* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount);
+FALCOR_API void normalizedToRGBA32Float(const uint8_t* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount);
+FALCOR_API void normalizedToRGBA32Float(const uint16_t* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount);
+FALCOR_API void normalizedToRGBA32Float(const uint32_t* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount);
+FALCOR_API void normalizedToRGBA32Float(const int16_t* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount);
+FALCOR_API void normalizedToRGBA32Float(const int32_t* pSrc, uint32_t channelCount, float* pDst, size_t pixelCount);
+
+/// Expand RGB float pixels to RGBA, setting alpha to the given value.
+FALCOR_API void expandRGBToRGBA(const float* pSrc, float* pDst, size_t pixelCount, float alpha = 1.f);
+
+/// Drop the alpha channel of RGBA float pixels.
+FALCOR_API void dropAlpha(const float* pSrc, float* pDst, size_t pixelCount);
+
+/// Value for swizzle8() to set a channel to 255.
+constexpr uint8_t kSwizzleOne = 4;
+
+/**
+ * Reorder the channels of pixels with four 8-bit channels: dst[c] = src[order[c]], or 255 if order[c] is kSwizzleOne.
+ * Source and destination may be the same array.
+ * Example: order {2, 1, 0, 3} converts RGBA to BGRA.
+ */
+FALCOR_API void swizzle8(const uint8_t* pSrc, uint8_t* pDst, size_t pixelCount, std::array<uint8_t, 4> order);
+} // namespace PixelConversion
+} // namespace Falcor
@@ -26,7 +26,21 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "TextureAnalyzer.h"
+#include "PixelConversion.h"
 #include "Core/API/RenderContext.h"
+#include "Utils/Math/Common.h"
+#include "Utils/TaskManager.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FALCOR_TEXTURE_ANALYZER_SSE 1
+#include <immintrin.h>
+#else
+#define FALCOR_TEXTURE_ANALYZER_SSE 0
+#endif
 
 namespace Falcor
 {
@@ -39,6 +53,175 @@ static_assert((uint32_t)TextureChannelFlags::Blue == 0x4);
 static_assert((uint32_t)TextureChannelFlags::Alpha == 0x8);
 
 const char kShaderFilename[] = "Utils/Image/TextureAnalyzer.cs.slang";
+
+const uint32_t kCpuRowsPerBlock = 64; ///< Number of rows analyzed together by one thread on the CPU.
+
+/// Partial analysis result of a block of texels.
+struct TexelStats
+{
+    uint32_t varying = 0; ///< Bit i set if channel i differs from the reference texel.
+    uint32_t pos = 0;     ///< Bit i set if channel i has positive values.
+    uint32_t neg = 0;     ///< Bit i set if channel i has negative values.
+    uint32_t inf = 0;     ///< Bit i set if channel i has +/-inf values.
+    uint32_t nan = 0;     ///< Bit i set if channel i has NaN values.
+    float4 minValue = float4(FLT_MAX);
+    float4 maxValue = float4(0.f);
+
+    void combine(const TexelStats& other)
+    {
+        varying |= other.varying;
+        pos |= other.pos;
+        neg |= other.neg;
+        inf |= other.inf;
+        nan |= other.nan;
+        minValue = min(minValue, other.minValue);
+        maxValue = max(maxValue, other.maxValue);
+    }
+
+    /// Returns the mask in the format of TextureAnalyzer::Result::mask.
+    uint32_t getMask() const
+    {
+        uint32_t mask = varying;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            uint32_t range = 0;
+            range |= (pos >> i) & 1 ? (uint32_t)TextureAnalyzer::Result::RangeFlags::Pos : 0;
+            range |= (neg >> i) & 1 ? (uint32_t)TextureAnalyzer::Result::RangeFlags::Neg : 0;
+            range |= (inf >> i) & 1 ? (uint32_t)TextureAnalyzer::Result::RangeFlags::Inf : 0;
+            range |= (nan >> i) & 1 ? (uint32_t)TextureAnalyzer::Result::RangeFlags::NaN : 0;
+            mask |= range << (4 + 4 * i);
+        }
+        return mask;
+    }
+};
+
+/**
+ * Convert texels to RGBA float the same way as the shader reads them.
+ * Missing color channels are set to 0 and missing alpha channels to 1.
+ */
+void loadTexels(ResourceFormat format, const uint8_t* pSrc, uint32_t count, float* pDst, std::vector<uint8_t>& scratch)
+{
+    switch (format)
+    {
+    case ResourceFormat::R8Unorm:
+    case ResourceFormat::RG8Unorm:
+    case ResourceFormat::RGBA8Unorm:
+        PixelConversion::normalizedToRGBA32Float(pSrc, getFormatChannelCount(format), pDst, count);
+        break;
+    case ResourceFormat::BGRA8Unorm:
+    case ResourceFormat::BGRX8Unorm:
+    case ResourceFormat::BGRA8UnormSrgb:
+    case ResourceFormat::BGRX8UnormSrgb:
+    {
+        // Reorder to RGBA and handle the sRGB formats below.
+        const bool hasAlpha = format == ResourceFormat::BGRA8Unorm || format == ResourceFormat::BGRA8UnormSrgb;
+        scratch.resize(count * 4);
+        PixelConversion::swizzle8(pSrc, scratch.data(), count, {2, 1, 0, hasAlpha ? uint8_t(3) : PixelConversion::kSwizzleOne});
+        const ResourceFormat rgbaFormat = isSrgbFormat(format) ? ResourceFormat::RGBA8UnormSrgb : ResourceFormat::RGBA8Unorm;
+        loadTexels(rgbaFormat, scratch.data(), count, pDst, scratch);
+        break;
+    }
+    case ResourceFormat::RGBA8UnormSrgb:
+        // Only the color channels are sRGB encoded.
+        PixelConversion::srgb8ToLinearFloat32(pSrc, pDst, count * 4);
+        for (uint32_t i = 0; i < count; i++)
+            pDst[i * 4 + 3] = float(pSrc[i * 4 + 3]) / 255.f;
+        break;
+    case ResourceFormat::R16Unorm:
+    case ResourceFormat::RG16Unorm:
+    case ResourceFormat::RGBA16Unorm:
+        PixelConversion::normalizedToRGBA32Float(reinterpret_cast<const uint16_t*>(pSrc), getFormatChannelCount(format), pDst, count);
+        break;
+    case ResourceFormat::R16Float:
+    case ResourceFormat::RG16Float:
+    case ResourceFormat::RGBA16Float:
+        PixelConversion::float16ToRGBA32Float(reinterpret_cast<const uint16_t*>(pSrc), getFormatChannelCount(format), pDst, count);
+        break;
+    case ResourceFormat::RGBA32Float:
+        std::memcpy(pDst, pSrc, count * sizeof(float4));
+        break;
+    case ResourceFormat::RGB32Float:
+        PixelConversion::expandRGBToRGBA(reinterpret_cast<const float*>(pSrc), pDst, count, 1.f);
+        break;
+    case ResourceFormat::R32Float:
+    case ResourceFormat::RG32Float:
+    {
+        const uint32_t channelCount = getFormatChannelCount(format);
+        const float* pSrcFloat = reinterpret_cast<const float*>(pSrc);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+                pDst[i * 4 + c] = c < channelCount ? pSrcFloat[i * channelCount + c] : (c == 3 ? 1.f : 0.f);
+        }
+        break;
+    }
+    default:
+        FALCOR_UNREACHABLE();
+    }
+}
+
+/**
+ * Accumulate stats of RGBA float texels.
+ * This matches the shader: a channel is varying if it compares unequal to the reference texel (so NaN is always varying),
+ * and min/max values are computed on values clamped to zero, ignoring NaNs.
+ */
+void accumulateTexels(const float* pTexels, uint32_t count, const float4& ref, TexelStats& stats)
+{
+#if FALCOR_TEXTURE_ANALYZER_SSE
+    // Each texel fits into one SSE register.
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 inf = _mm_set1_ps(INFINITY);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 refValue = _mm_loadu_ps(&ref.x);
+
+    __m128 varying = zero, pos = zero, neg = zero, isInf = zero, isNaN = zero;
+    __m128 minValue = _mm_loadu_ps(&stats.minValue.x);
+    __m128 maxValue = _mm_loadu_ps(&stats.maxValue.x);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        __m128 v = _mm_loadu_ps(pTexels + i * 4);
+        varying = _mm_or_ps(varying, _mm_cmpneq_ps(v, refValue));
+        pos = _mm_or_ps(pos, _mm_cmpgt_ps(v, zero));
+        neg = _mm_or_ps(neg, _mm_cmplt_ps(v, zero));
+        isInf = _mm_or_ps(isInf, _mm_cmpeq_ps(_mm_and_ps(v, absMask), inf));
+        isNaN = _mm_or_ps(isNaN, _mm_cmpunord_ps(v, v));
+
+        // The min/max instructions return the second operand if either is NaN.
+        // Order the operands so that NaNs propagate to the clamped value but not into the running min/max.
+        __m128 clamped = _mm_max_ps(zero, v);
+        minValue = _mm_min_ps(clamped, minValue);
+        maxValue = _mm_max_ps(clamped, maxValue);
+    }
+
+    stats.varying |= _mm_movemask_ps(varying);
+    stats.pos |= _mm_movemask_ps(pos);
+    stats.neg |= _mm_movemask_ps(neg);
+    stats.inf |= _mm_movemask_ps(isInf);
+    stats.nan |= _mm_movemask_ps(isNaN);
+    _mm_storeu_ps(&stats.minValue.x, minValue);
+    _mm_storeu_ps(&stats.maxValue.x, maxValue);
+#else
+    for (uint32_t i = 0; i < count; i++)
+    {
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            float v = pTexels[i * 4 + c];
+            stats.varying |= !(v == ref[c]) ? 1u << c : 0;
+            stats.pos |= v > 0.f ? 1u << c : 0;
+            stats.neg |= v < 0.f ? 1u << c : 0;
+            stats.inf |= std::isinf(v) ? 1u << c : 0;
+            stats.nan |= std::isnan(v) ? 1u << c : 0;
+
+            if (std::isnan(v))
+                continue;
+            float clamped = v > 0.f ? v : 0.f;
+            stats.minValue[c] = std::min(stats.minValue[c], clamped);
+            stats.maxValue[c] = std::max(stats.maxValue[c], clamped);
+        }
+    }
+#endif
+}
 } // namespace
 
 // Verify that the result struct matches the size expected by the shader.
@@ -126,6 +309,85 @@ void TextureAnalyzer::clear(RenderContext* pRenderContext, ref<Buffer> pResult,
     mpClearPass->execute(pRenderContext, uint3(resultCount, 1, 1));
 }
 
+TextureAnalyzer::Result TextureAnalyzer::analyzeTexels(
+    ResourceFormat format,
+    uint32_t width,
+    uint32_t height,
+    size_t rowPitch,
+    const void* pData
+)
+{
+    if (!isCpuFormatSupported(format))
+        FALCOR_THROW("Format {} is not supported", to_string(format));
+    FALCOR_CHECK(width > 0 && height > 0, "Texture must not be empty");
+    FALCOR_CHECK(rowPitch >= width * getFormatBytesPerBlock(format), "Row pitch is too small");
+
+    const uint8_t* pTexels = static_cast<const uint8_t*>(pData);
+
+    // Read reference value from top-left texel.
+    float4 ref;
+    std::vector<uint8_t> scratch;
+    loadTexels(format, pTexels, 1, &ref.x, scratch);
+
+    // Analyze blocks of rows in parallel.
+    const uint32_t blockCount = div_round_up(height, kCpuRowsPerBlock);
+    std::vector<TexelStats> blockStats(blockCount);
+    parallelFor(
+        0,
+        blockCount,
+        [&](uint32_t block)
+        {
+            std::vector<float> rowTexels(width * 4);
+            std::vector<uint8_t> rowScratch;
+            const uint32_t endRow = std::min(height, (block + 1) * kCpuRowsPerBlock);
+            for (uint32_t y = block * kCpuRowsPerBlock; y < endRow; y++)
+            {
+                loadTexels(format, pTexels + y * rowPitch, width, rowTexels.data(), rowScratch);
+                accumulateTexels(rowTexels.data(), width, ref, blockStats[block]);
+            }
+        }
+    );
+
+    TexelStats stats;
+    for (const auto& s : blockStats)
+        stats.combine(s);
+
+    Result result = {};
+    result.mask = stats.getMask();
+    result.value = ref;
+    result.minValue = stats.minValue;
+    result.maxValue = stats.maxValue;
+    return result;
+}
+
+bool TextureAnalyzer::isCpuFormatSupported(ResourceFormat format)
+{
+    switch (format)
+    {
+    case ResourceFormat::R8Unorm:
+    case ResourceFormat::RG8Unorm:
+    case ResourceFormat::RGBA8Unorm:
+    case ResourceFormat::RGBA8UnormSrgb:
+    case ResourceFormat::BGRA8Unorm:
+    case ResourceFormat::BGRA8UnormSrgb:
+    case ResourceFormat::BGRX8Unorm:
+    case ResourceFormat::BGRX8UnormSrgb:
+    case ResourceFormat::R16Unorm:
+    case ResourceFormat::RG16Unorm:
+    case ResourceFormat::RGBA16Unorm:
+    case ResourceFormat::R16Float:
+    case ResourceFormat::RG16Float:
+    case ResourceFormat::RGBA16Float:
+    case ResourceFormat::R32Float:
+    case ResourceFormat::RG32Float:
+    case ResourceFormat::RGB32Float:
+    case ResourceFormat::RGBA32Float:
+        return true;
+    default:
+        return false;
+    }
+}
+
 void TextureAnalyzer::checkFormatSupport(const ref<Texture> pInput, uint32_t mipLevel, uint32_t arraySlice) const
 {
     // Validate that input is supported.
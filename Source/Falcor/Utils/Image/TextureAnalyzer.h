@@ -131,6 +131,26 @@ public:
      */
     void analyze(RenderContext* pRenderContext, const std::vector<ref<Texture>>& inputs, ref<Buffer> pResult, bool clearResult = true);
 
+    /**
+     * Analyze 2D texel data on the CPU.
+     * This is used to analyze textures while they are decoded, without uploading them first.
+     * The result is the same as analyze() produces for a texture of the given format and contents.
+     * Throws an exception if the format is not supported, see isCpuFormatSupported().
+     * @param[in] format Texel format.
+     * @param[in] width Width in texels.
+     * @param[in] height Height in texels.
+     * @param[in] rowPitch Row pitch in bytes.
+     * @param[in] pData Texel data, starting with the top-left texel.
+     * @return Analysis result.
+     */
+    static Result analyzeTexels(ResourceFormat format, uint32_t width, uint32_t height, size_t rowPitch, const void* pData);
+
+    /**
+     * Check if a format is supported by analyzeTexels().
+     * Uncompressed 8/16-bit unorm, 16-bit float and 32-bit float formats are supported.
+     */
+    static bool isCpuFormatSupported(ResourceFormat format);
+
     /**
      * Helper function to clear the results buffer.
      * @param[in] pRenderContext The context.
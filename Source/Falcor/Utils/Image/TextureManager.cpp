@@ -26,12 +26,13 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "TextureManager.h"
+#include "ImageIO.h"
 #include "Core/AssetResolver.h"
 #include "Core/API/Device.h"
+#include "Core/Platform/OS.h"
 #include "Utils/Logger.h"
-#include "Utils/NumericRange.h"
+#include "Utils/TaskManager.h"
 
-#include <execution>
 
 // Temporarily disable asynchronous texture loader until Falcor supports parallel GPU work submission.
 // Until then `TextureManager` should only called from the main thread.
@@ -293,6 +294,10 @@ TextureManager::CpuTextureHandle TextureManager::loadTexture(
         // Add to key-to-handle map.
         mKeyToHandle[textureKey] = handle;
 
+        // Function loading the texture on a worker thread. The image is decoded and analyzed there.
+        auto pLoadResult = std::make_shared<LoadResult>();
+        auto load = [=, options = getLoadOptions()]() { return createTextureFromFiles(textureKey, options, pLoadResult.get()); };
+
         // Function called by the async texture loader when loading finishes.
         // It's called by a worker thread so needs to acquire the mutex before changing any state.
         auto callback = [=](ref<Texture> pTexture)
@@ -303,38 +308,28 @@ TextureManager::CpuTextureHandle TextureManager::loadTexture(
             auto& desc = getDesc(handle);
             desc.state = TextureState::Loaded;
             desc.pTexture = pTexture;
+            desc.analysis = pLoadResult->analysis;
 
             // Add to texture-to-handle map.
             if (pTexture)
                 mTextureToHandle[pTexture.get()] = handle;
 
+            if (pTexture && !pLoadResult->streamingSource.ddsPath.empty())
+                addStreamedTexture(handle, pTexture, loadAsSRGB, std::move(pLoadResult->streamingSource));
+
             mLoadRequestsInProgress--;
             mCondition.notify_all();
         };
 
         // Issue load request to texture loader.
-        if (paths.size() > 1)
-        {
-            mAsyncTextureLoader.loadMippedFromFiles(paths, loadAsSRGB, bindFlags, importFlags, callback);
-        }
-        else
-        {
-            mAsyncTextureLoader.loadFromFile(paths[0], generateMipLevels, loadAsSRGB, bindFlags, importFlags, callback);
-        }
+        mAsyncTextureLoader.load(load, callback);
 #else
         // Load texture from main thread.
-        ref<Texture> pTexture;
-        if (paths.size() > 1)
-        {
-            pTexture = Texture::createMippedFromFiles(mpDevice, paths, loadAsSRGB, bindFlags, importFlags);
-        }
-        else
-        {
-            pTexture = Texture::createFromFile(mpDevice, paths[0], generateMipLevels, loadAsSRGB, bindFlags, importFlags);
-        }
+        LoadResult loadResult;
+        ref<Texture> pTexture = createTextureFromFiles(textureKey, getLoadOptions(), &loadResult);
 
         // Add new texture desc.
-        TextureDesc desc = {TextureState::Loaded, pTexture};
+        TextureDesc desc = {TextureState::Loaded, pTexture, loadResult.analysis};
         handle = addDesc(desc);
 
         // Add to key-to-handle map.
@@ -344,6 +339,9 @@ TextureManager::CpuTextureHandle TextureManager::loadTexture(
         if (pTexture)
             mTextureToHandle[pTexture.get()] = handle;
 
+        if (pTexture && !loadResult.streamingSource.ddsPath.empty())
+            addStreamedTexture(handle, pTexture, loadAsSRGB, std::move(loadResult.streamingSource));
+
         mCondition.notify_all();
 #endif
     }
@@ -359,6 +357,74 @@ TextureManager::CpuTextureHandle TextureManager::loadTexture(
     return handle;
 }
 
+void TextureManager::setTranscodeCacheEnabled(bool enable, const std::filesystem::path& directory)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!enable)
+        mpTranscodeCache.reset();
+    else if (directory.empty())
+        mpTranscodeCache = std::make_shared<TextureTranscodeCache>();
+    else
+        mpTranscodeCache = std::make_shared<TextureTranscodeCache>(directory);
+}
+
+bool TextureManager::isTranscodeCacheEnabled() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mpTranscodeCache != nullptr;
+}
+
+void TextureManager::setStreamingEnabled(bool enable, const TextureStreamer::Config& config)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!enable)
+        mpStreamer.reset();
+    else if (mpStreamer)
+        mpStreamer->setConfig(config);
+    else
+        mpStreamer = std::make_unique<TextureStreamer>(mStreamingBackend, config);
+}
+
+TextureStreamer::Config TextureManager::getDefaultStreamingConfig()
+{
+    TextureStreamer::Config config;
+    config.requestLifetime = 0;
+    return config;
+}
+
+bool TextureManager::isStreamingEnabled() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mpStreamer != nullptr;
+}
+
+void TextureManager::requestTextureMip(const CpuTextureHandle& handle, uint32_t mip)
+{
+    if (!handle || handle.isUdim())
+        return;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mpStreamer)
+        mpStreamer->requestMip(handle.getID(), mip);
+}
+
+bool TextureManager::updateStreaming()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    bool changed = std::exchange(mStreamedTexturesChanged, false);
+    if (mpStreamer)
+        mpStreamer->update();
+    // While the async texture loader is disabled, streamed versions of textures are loaded by the update itself.
+    // Otherwise textures replaced right away are reported now, and textures finishing their loads later by the next update.
+    return changed || std::exchange(mStreamedTexturesChanged, false);
+}
+
+TextureStreamer::Stats TextureManager::getStreamingStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mpStreamer ? mpStreamer->getStats() : TextureStreamer::Stats{};
+}
+
 void TextureManager::waitForTextureLoading(const CpuTextureHandle& handle)
 {
     if (!handle)
@@ -391,6 +457,7 @@ void TextureManager::endDeferredLoading()
     {
         TextureKey key;
         CpuTextureHandle handle;
+        LoadResult loadResult;
     };
 
     // Get a list of textures to load.
@@ -399,7 +466,7 @@ void TextureManager::endDeferredLoading()
     {
         auto& desc = getDesc(handle);
         if (desc.state == TextureState::Referenced)
-            jobs.push_back(Job{key, handle});
+            jobs.push_back(Job{key, handle, {}});
     }
 
     // Early out if there are no textures to load.
@@ -408,45 +475,42 @@ void TextureManager::endDeferredLoading()
         return;
 
     // Load textures in parallel.
+    LoadOptions options;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        options = getLoadOptions();
+    }
     std::atomic<size_t> texturesLoaded;
-    NumericRange<size_t> jobRange(0, jobs.size());
-    std::for_each(
-        std::execution::par_unseq,
-        jobRange.begin(),
-        jobRange.end(),
+    parallelFor(
+        0,
+        jobs.size(),
         [&](size_t i)
         {
-            const auto& job = jobs[i];
+            auto& job = jobs[i];
             auto& desc = getDesc(job.handle);
-            if (job.key.fullPaths.size() == 1)
-            {
-                desc.pTexture = Texture::createFromFile(
-                    mpDevice, job.key.fullPaths[0], job.key.generateMipLevels, job.key.loadAsSRGB, job.key.bindFlags, job.key.importFlags
-                );
-                logDebug("Loading texture from '{}'", job.key.fullPaths[0]);
-            }
-            else
-            {
-                desc.pTexture =
-                    Texture::createMippedFromFiles(mpDevice, job.key.fullPaths, job.key.loadAsSRGB, job.key.bindFlags, job.key.importFlags);
-                logDebug("Loading mipped texture from '{}'", job.key.fullPaths[0]);
-            }
+            desc.pTexture = createTextureFromFiles(job.key, options, &job.loadResult);
+            desc.analysis = job.loadResult.analysis;
+            logDebug("Loading {}texture from '{}'", job.key.fullPaths.size() > 1 ? "mipped " : "", job.key.fullPaths[0]);
             if (texturesLoaded.fetch_add(1) % 10 == 9)
             {
                 logDebug("Flush");
                 std::lock_guard<std::mutex> lock(mpDevice->getGlobalGfxMutex());
                 mpDevice->wait();
             }
-        }
+        },
+        1 // Texture loads vary a lot in cost, so balance them one by one.
     );
     mpDevice->wait();
 
     // Mark loaded textures and add them to lookup table.
-    for (const auto& job : jobs)
+    for (auto& job : jobs)
     {
         auto& desc = getDesc(job.handle);
         desc.state = desc.pTexture ? TextureState::Loaded : TextureState::Invalid;
         mTextureToHandle[desc.pTexture.get()] = job.handle;
+
+        if (desc.pTexture && !job.loadResult.streamingSource.ddsPath.empty())
+            addStreamedTexture(job.handle, desc.pTexture, job.key.loadAsSRGB, std::move(job.loadResult.streamingSource));
     }
 }
 
@@ -492,6 +556,16 @@ void TextureManager::removeNonUdimTexture(const CpuTextureHandle& handle)
     if (it != mKeyToHandle.end())
         mKeyToHandle.erase(it);
 
+    if (auto streamedIt = mStreamedTextures.find(handle.getID()); streamedIt != mStreamedTextures.end())
+    {
+        // The mip tail texture stays mapped to the handle while streamed versions replace it.
+        if (streamedIt->second.pTailTexture != desc.pTexture)
+            mTextureToHandle.erase(streamedIt->second.pTailTexture.get());
+        mStreamedTextures.erase(streamedIt);
+        if (mpStreamer)
+            mpStreamer->removeTexture(handle.getID());
+    }
+
     if (desc.pTexture)
     {
         FALCOR_ASSERT(mTextureToHandle.find(desc.pTexture.get()) != mTextureToHandle.end());
@@ -550,6 +624,15 @@ TextureManager::TextureDesc TextureManager::getTextureDesc(const CpuTextureHandl
     return mTextureDescs[handle.getID()];
 }
 
+std::optional<TextureAnalyzer::Result> TextureManager::getTextureAnalysis(const ref<Texture>& pTexture) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mTextureToHandle.find(pTexture.get());
+    if (it == mTextureToHandle.end())
+        return std::nullopt;
+    return mTextureDescs[it->second.getID()].analysis;
+}
+
 size_t TextureManager::getTextureDescCount() const
 {
     std::lock_guard<std::mutex> lock(mMutex);
@@ -641,10 +724,221 @@ TextureManager::Stats TextureManager::getStats() const
         s.textureMemoryInBytes += t.pTexture->getTextureSizeInBytes();
         if (isCompressedFormat(t.pTexture->getFormat()))
             s.textureCompressedCount++;
+        if (t.analysis)
+        {
+            s.textureAnalyzedCount++;
+            if (t.analysis->isConstant(TextureChannelFlags::RGBA))
+                s.textureConstantCount++;
+        }
+    }
+    if (mpTranscodeCache)
+    {
+        const auto cacheStats = mpTranscodeCache->getStats();
+        s.transcodeCacheHits = cacheStats.hits;
+        s.transcodeCacheMisses = cacheStats.misses;
     }
     return s;
 }
 
+TextureManager::LoadOptions TextureManager::getLoadOptions() const
+{
+    LoadOptions options{mpTranscodeCache};
+    if (mpStreamer)
+        options.streamingMipTailBytes = mpStreamer->getConfig().mipTailBytes;
+    return options;
+}
+
+ref<Texture> TextureManager::createTextureFromFiles(const TextureKey& key, const LoadOptions& options, LoadResult* pLoadResult) const
+{
+    if (key.fullPaths.size() > 1)
+        return Texture::createMippedFromFiles(mpDevice, key.fullPaths, key.loadAsSRGB, key.bindFlags, key.importFlags);
+
+    // The transcode cache stores a full mip chain and DDS textures are created with default bind flags,
+    // so only use it for mipped shader resources.
+    std::filesystem::path cachePath;
+    if (options.pTranscodeCache && key.generateMipLevels && key.bindFlags == ResourceBindFlags::ShaderResource)
+        cachePath = options.pTranscodeCache->getOrCreate(key.fullPaths[0], key.loadAsSRGB, key.importFlags);
+
+    // Streamed textures are created with only their mip tail. The streamer loads finer mip levels later.
+    if (options.streamingMipTailBytes && pLoadResult && key.bindFlags == ResourceBindFlags::ShaderResource)
+    {
+        std::filesystem::path ddsPath = cachePath;
+        if (ddsPath.empty() && hasExtension(key.fullPaths[0], "dds"))
+            ddsPath = key.fullPaths[0];
+
+        if (!ddsPath.empty())
+        {
+            auto mipSizes = ImageIO::getDDSMipSizes(ddsPath);
+            uint32_t tailMip = TextureStreamer::computeTailMip(mipSizes, *options.streamingMipTailBytes);
+            if (tailMip > 0)
+            {
+                if (auto pTexture = ImageIO::loadTextureFromDDS(mpDevice, ddsPath, key.loadAsSRGB, tailMip))
+                {
+                    pTexture->setSourcePath(key.fullPaths[0]);
+                    pLoadResult->streamingSource = {ddsPath, std::move(mipSizes), tailMip};
+                    return pTexture;
+                }
+            }
+        }
+    }
+
+    if (!cachePath.empty())
+    {
+        if (auto pTexture = Texture::createFromFile(mpDevice, cachePath, false, key.loadAsSRGB, key.bindFlags, key.importFlags))
+        {
+            pTexture->setSourcePath(key.fullPaths[0]);
+            return pTexture;
+        }
+    }
+
+    // Decode other images here, so the texels can be analyzed while they are in memory.
+    const std::filesystem::path& path = key.fullPaths[0];
+    if (pLoadResult && !hasExtension(path, "dds") && std::filesystem::exists(path))
+    {
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(path, true, key.importFlags);
+        if (!pBitmap)
+            return nullptr;
+
+        // Analyze the texels as the shader reads them, i.e. with sRGB decoding.
+        const ResourceFormat format = key.loadAsSRGB ? linearToSrgbFormat(pBitmap->getFormat()) : pBitmap->getFormat();
+        if (TextureAnalyzer::isCpuFormatSupported(format))
+        {
+            pLoadResult->analysis = TextureAnalyzer::analyzeTexels(
+                format, pBitmap->getWidth(), pBitmap->getHeight(), pBitmap->getRowPitch(), pBitmap->getData()
+            );
+
+            // Constant textures are created with a single texel to avoid uploading the full image.
+            // Only do this for shader resources, as other bind flags indicate the texture is written to.
+            if (pLoadResult->analysis->isConstant(TextureChannelFlags::RGBA) && key.bindFlags == ResourceBindFlags::ShaderResource)
+                pBitmap = Bitmap::create(1, 1, pBitmap->getFormat(), pBitmap->getData());
+        }
+
+        ref<Texture> pTexture =
+            Texture::createFromBitmap(mpDevice, *pBitmap, key.generateMipLevels, key.loadAsSRGB, key.bindFlags, key.importFlags);
+        pTexture->setSourcePath(path);
+        return pTexture;
+    }
+
+    return Texture::createFromFile(mpDevice, key.fullPaths[0], key.generateMipLevels, key.loadAsSRGB, key.bindFlags, key.importFlags);
+}
+
+void TextureManager::addStreamedTexture(
+    const CpuTextureHandle& handle,
+    const ref<Texture>& pTexture,
+    bool loadAsSRGB,
+    StreamingSource&& source
+)
+{
+    // The texture keeps its full mip chain if streaming was disabled or reconfigured while it was loading.
+    if (!mpStreamer || TextureStreamer::computeTailMip(source.mipSizes, mpStreamer->getConfig().mipTailBytes) != source.tailMip)
+        return;
+
+    // The mip tail is already resident, so the streamer's initial residency change is a no-op.
+    const uint32_t id = handle.getID();
+    mStreamedTextures[id] = StreamedTexture{source.ddsPath, loadAsSRGB, pTexture, source.tailMip};
+    if (!mpStreamer->addTexture(id, std::move(source.mipSizes)))
+    {
+        mStreamedTextures.erase(id);
+        return;
+    }
+
+    // Without other feedback, stream in the full mip chain as the budget allows.
+    mpStreamer->requestMip(id, 0);
+}
+
+bool TextureManager::setResidentMips(uint32_t id, uint32_t mostDetailedMip)
+{
+    // Called by the streamer with the mutex held. While the async texture loader is disabled, finer mip levels are
+    // read and uploaded synchronously here. Otherwise they are loaded on the async texture loader and swapped in when
+    // the load finishes, so that updates don't wait for file reads and uploads.
+    auto it = mStreamedTextures.find(id);
+    if (it == mStreamedTextures.end())
+        return false;
+
+    auto& streamed = it->second;
+    const uint64_t loadID = mNextStreamingLoadID++;
+    streamed.loadID = loadID;
+
+    // The mip tail is always resident.
+    if (mostDetailedMip == streamed.tailMip)
+    {
+        finishStreamedLoad(id, loadID, streamed.pTailTexture);
+        return true;
+    }
+
+    auto load = [pDevice = mpDevice,
+                 ddsPath = streamed.ddsPath,
+                 loadAsSRGB = streamed.loadAsSRGB,
+                 sourcePath = streamed.pTailTexture->getSourcePath(),
+                 mostDetailedMip]()
+    {
+        ref<Texture> pTexture = ImageIO::loadTextureFromDDS(pDevice, ddsPath, loadAsSRGB, mostDetailedMip);
+        if (pTexture)
+            pTexture->setSourcePath(sourcePath);
+        return pTexture;
+    };
+
+#ifndef DISABLE_ASYNC_TEXTURE_LOADER
+    auto callback = [=](ref<Texture> pTexture)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        finishStreamedLoad(id, loadID, pTexture);
+    };
+    streamed.loading = true;
+    mAsyncTextureLoader.load(load, callback);
+#else
+    ref<Texture> pTexture = load();
+    if (!pTexture)
+        return false;
+    finishStreamedLoad(id, loadID, pTexture);
+#endif
+    return true;
+}
+
+bool TextureManager::isStreamedTextureLoading(uint32_t id) const
+{
+    // Called by the streamer with the mutex held.
+    auto it = mStreamedTextures.find(id);
+    return it != mStreamedTextures.end() && it->second.loading;
+}
+
+void TextureManager::finishStreamedLoad(uint32_t id, uint64_t loadID, const ref<Texture>& pTexture)
+{
+    // Called with the mutex held. Drop the results of loads superseded by a later residency change,
+    // or of textures removed in the meantime.
+    auto it = mStreamedTextures.find(id);
+    if (it == mStreamedTextures.end() || it->second.loadID != loadID)
+        return;
+
+    auto& streamed = it->second;
+    streamed.loading = false;
+    if (pTexture)
+    {
+        setStreamedTexture(id, pTexture);
+        return;
+    }
+
+    logWarning("Failed to stream texture '{}'.", streamed.ddsPath);
+    setStreamedTexture(id, streamed.pTailTexture);
+    if (mpStreamer)
+        mpStreamer->markFailed(id);
+}
+
+void TextureManager::setStreamedTexture(uint32_t id, const ref<Texture>& pTexture)
+{
+    const CpuTextureHandle handle(id);
+    auto& desc = getDesc(handle);
+    if (desc.pTexture == pTexture)
+        return;
+
+    // The mip tail texture stays mapped to the handle as materials reference it.
+    if (desc.pTexture != mStreamedTextures.at(id).pTailTexture)
+        mTextureToHandle.erase(desc.pTexture.get());
+    desc.pTexture = pTexture;
+    mTextureToHandle[pTexture.get()] = handle;
+    mStreamedTexturesChanged = true;
+}
+
 TextureManager::CpuTextureHandle TextureManager::addDesc(const TextureDesc& desc)
 {
     CpuTextureHandle handle;
@@ -27,6 +27,9 @@
  **************************************************************************/
 #pragma once
 #include "AsyncTextureLoader.h"
+#include "TextureAnalyzer.h"
+#include "TextureStreamer.h"
+#include "TextureTranscodeCache.h"
 #include "Core/Macros.h"
 #include "Core/API/fwd.h"
 #include "Core/API/Resource.h"
@@ -39,6 +42,7 @@
 #include <set>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <thread>
 
 namespace Falcor
@@ -73,6 +77,10 @@ public:
         uint64_t textureTexelCount = 0;        ///< Total number of texels in all textures.
         uint64_t textureTexelChannelCount = 0; ///< Total number of texel channels in all textures.
         uint64_t textureMemoryInBytes = 0;     ///< Total memory in bytes used by the textures.
+        uint64_t transcodeCacheHits = 0;       ///< Number of textures loaded from the transcode cache.
+        uint64_t transcodeCacheMisses = 0;     ///< Number of textures transcoded into the cache.
+        uint64_t textureAnalyzedCount = 0;     ///< Number of textures analyzed on the CPU while loading.
+        uint64_t textureConstantCount = 0;     ///< Number of analyzed textures found to be constant and loaded as a single texel.
     };
 
     /**
@@ -132,8 +140,9 @@ public:
     /// Struct describing a managed texture.
     struct TextureDesc
     {
-        TextureState state = TextureState::Invalid; ///< Current state of the texture.
-        ref<Texture> pTexture;                      ///< Valid texture object when state is 'Loaded', or nullptr if loading failed.
+        TextureState state = TextureState::Invalid;      ///< Current state of the texture.
+        ref<Texture> pTexture;                           ///< Valid texture object when state is 'Loaded', or nullptr if loading failed.
+        std::optional<TextureAnalyzer::Result> analysis; ///< Analysis of the texels computed on the CPU while loading, if available.
 
         bool isValid() const { return state != TextureState::Invalid; }
     };
@@ -183,6 +192,58 @@ public:
         const Object* owner = nullptr
     );
 
+    /**
+     * Enable or disable the texture transcode cache.
+     * When enabled, mipped 8-bit textures loaded from image files are block compressed once and stored in a disk cache.
+     * Later loads read the cached DDS file directly instead of decoding the image and generating mips on the GPU.
+     * See TextureTranscodeCache for details.
+     * @param[in] enable Enable the cache.
+     * @param[in] directory Cache directory, or empty for the default directory.
+     */
+    void setTranscodeCacheEnabled(bool enable, const std::filesystem::path& directory = {});
+
+    bool isTranscodeCacheEnabled() const;
+
+    /**
+     * Enable or disable progressive texture streaming.
+     * When enabled, mipped shader resource textures loaded from DDS files (directly or through the transcode cache)
+     * are created with only their mip tail. Finer mip levels are streamed in by updateStreaming() as requested by
+     * requestTextureMip(), within the memory budget. Newly loaded textures request mip 0 until other feedback is given.
+     * Textures keep their current mip levels when streaming is disabled. See TextureStreamer for details.
+     * @param[in] enable Enable streaming.
+     * @param[in] config Streaming configuration. Changes take effect on the next call to updateStreaming().
+     */
+    void setStreamingEnabled(bool enable, const TextureStreamer::Config& config = getDefaultStreamingConfig());
+
+    /**
+     * Get the default streaming configuration.
+     * Requests don't expire, as there is no feedback from rendering yet and textures only request mip 0 when loaded.
+     */
+    static TextureStreamer::Config getDefaultStreamingConfig();
+
+    bool isStreamingEnabled() const;
+
+    /**
+     * Request a mip level of a streamed texture. The most detailed mip requested since the last call to
+     * updateStreaming() is used. UDIM handles must be resolved first; handles of textures that are not streamed are ignored.
+     * @param[in] handle Texture handle.
+     * @param[in] mip Requested mip level.
+     */
+    void requestTextureMip(const CpuTextureHandle& handle, uint32_t mip);
+
+    /**
+     * Stream in and evict mip levels of streamed textures according to the requests since the last call.
+     * Textures are replaced when their mip levels change, so shader data needs to be rebound. Finer mip levels
+     * are currently loaded synchronously by this call, as the async texture loader is disabled.
+     * @return True if any texture was replaced since the last call.
+     */
+    bool updateStreaming();
+
+    /**
+     * Returns stats for texture streaming.
+     */
+    TextureStreamer::Stats getStreamingStats() const;
+
     /**
      * Wait for a requested texture to load.
      * If the handle is valid, the call blocks until the texture is loaded (or failed to load).
@@ -243,6 +304,14 @@ public:
         return getTextureDesc(resolveUdimTexture(handle, udimID));
     }
 
+    /**
+     * Get the analysis of a texture computed on the CPU while loading.
+     * Textures that were analyzed and found to be constant are created with a single texel.
+     * @param[in] pTexture The texture.
+     * @return Analysis result, or std::nullopt if the texture is not managed or was not analyzed while loading.
+     */
+    std::optional<TextureAnalyzer::Result> getTextureAnalysis(const ref<Texture>& pTexture) const;
+
     /**
      * Get list of UDIM IDs for a texture.
      * If the texture is not using UDIMs, an empty list is returned.
@@ -339,6 +408,61 @@ private:
         }
     };
 
+    /// DDS file of a texture loaded with only its mip tail.
+    struct StreamingSource
+    {
+        std::filesystem::path ddsPath;
+        std::vector<uint64_t> mipSizes;
+        uint32_t tailMip = 0;
+    };
+
+    /// State of a streamed texture.
+    struct StreamedTexture
+    {
+        std::filesystem::path ddsPath;
+        bool loadAsSRGB = false;
+        ref<Texture> pTailTexture; ///< Texture holding only the mip tail. Stays mapped to the handle as materials reference it.
+        uint32_t tailMip = 0;
+        uint64_t loadID = 0;  ///< ID of the latest residency change. Results of superseded loads are dropped.
+        bool loading = false; ///< True while the latest residency change is loading.
+    };
+
+    /// Streaming backend replacing textures with versions holding a different number of mip levels.
+    class StreamingBackend : public TextureStreamer::Backend
+    {
+    public:
+        StreamingBackend(TextureManager& textureManager) : mTextureManager(textureManager) {}
+        bool setResidentMips(TextureStreamer::TextureID id, uint32_t mostDetailedMip) override
+        {
+            return mTextureManager.setResidentMips(id, mostDetailedMip);
+        }
+        bool isLoading(TextureStreamer::TextureID id) const override { return mTextureManager.isStreamedTextureLoading(id); }
+
+    private:
+        TextureManager& mTextureManager;
+    };
+
+    /// Additional results of loading a texture.
+    struct LoadResult
+    {
+        StreamingSource streamingSource;                 ///< Streaming source if only the mip tail was loaded.
+        std::optional<TextureAnalyzer::Result> analysis; ///< Analysis of the texels if the image was decoded on the CPU.
+    };
+
+    /// Settings for loading a texture, captured while holding the mutex so that loads can run without it.
+    struct LoadOptions
+    {
+        std::shared_ptr<TextureTranscodeCache> pTranscodeCache; ///< Transcode cache, or nullptr if disabled.
+        std::optional<uint64_t> streamingMipTailBytes;         ///< Size of the mip tail of streamed textures, if streaming is enabled.
+    };
+
+    LoadOptions getLoadOptions() const; ///< Requires the mutex to be held.
+    ref<Texture> createTextureFromFiles(const TextureKey& key, const LoadOptions& options, LoadResult* pLoadResult = nullptr) const;
+    void addStreamedTexture(const CpuTextureHandle& handle, const ref<Texture>& pTexture, bool loadAsSRGB, StreamingSource&& source);
+    bool setResidentMips(uint32_t id, uint32_t mostDetailedMip);
+    bool isStreamedTextureLoading(uint32_t id) const;
+    void finishStreamedLoad(uint32_t id, uint64_t loadID, const ref<Texture>& pTexture);
+    void setStreamedTexture(uint32_t id, const ref<Texture>& pTexture);
     CpuTextureHandle addDesc(const TextureDesc& desc);
     TextureDesc& getDesc(const CpuTextureHandle& handle);
     void registerOwner(const CpuTextureHandle& handle, const Object* owner);
@@ -370,6 +494,14 @@ private:
 
     bool mUseDeferredLoading = false;
 
+    std::shared_ptr<TextureTranscodeCache> mpTranscodeCache; ///< Disk cache of transcoded textures, or nullptr if disabled.
+
+    StreamingBackend mStreamingBackend{*this};
+    std::unique_ptr<TextureStreamer> mpStreamer;          ///< Texture streaming scheduler, or nullptr if disabled.
+    std::map<uint32_t, StreamedTexture> mStreamedTextures; ///< Streamed textures, indexed by handle ID.
+    uint64_t mNextStreamingLoadID = 1;                     ///< ID of the next residency change of a streamed texture.
+    bool mStreamedTexturesChanged = false;                 ///< True if streamed textures were replaced since the last update.
+
     AsyncTextureLoader mAsyncTextureLoader; ///< Utility for asynchronous texture loading.
     size_t mLoadRequestsInProgress = 0;     ///< Number of load requests currently in progress.
 
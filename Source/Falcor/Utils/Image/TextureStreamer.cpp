@@ -0,0 +1,301 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "TextureStreamer.h"
+#include "Core/Error.h"
+#include <algorithm>
+#include <tuple>
+
+namespace Falcor
+{
+TextureStreamer::TextureStreamer(Backend& backend, const Config& config) : mBackend(backend), mConfig(config) {}
+
+uint32_t TextureStreamer::computeTailMip(fstd::span<const uint64_t> mipSizes, uint64_t mipTailBytes)
+{
+    if (mipSizes.empty())
+        return 0;
+
+    uint32_t tailMip = (uint32_t)mipSizes.size() - 1;
+    uint64_t tailBytes = mipSizes[tailMip];
+    while (tailMip > 0 && tailBytes + mipSizes[tailMip - 1] <= mipTailBytes)
+        tailBytes += mipSizes[--tailMip];
+    return tailMip;
+}
+
+bool TextureStreamer::addTexture(TextureID id, std::vector<uint64_t> mipSizes)
+{
+    FALCOR_CHECK(!mipSizes.empty(), "Texture must have at least one mip level.");
+    FALCOR_CHECK(!hasTexture(id), "Texture {} is already streamed.", id);
+
+    TextureState state;
+    state.residentBytes.resize(mipSizes.size() + 1, 0);
+    for (size_t mip = mipSizes.size(); mip-- > 0;)
+        state.residentBytes[mip] = state.residentBytes[mip + 1] + mipSizes[mip];
+    state.tailMip = computeTailMip(mipSizes, mConfig.mipTailBytes);
+    state.residentMip = state.tailMip;
+    state.desiredMip = state.tailMip;
+    state.pendingMip = state.tailMip;
+
+    // Load the mip tail up front so the texture can be sampled right away.
+    if (!mBackend.setResidentMips(id, state.tailMip))
+    {
+        mStats.failureCount++;
+        return false;
+    }
+
+    mResidentBytes += state.residentBytes[state.tailMip];
+    mTextures.emplace(id, std::move(state));
+    return true;
+}
+
+void TextureStreamer::removeTexture(TextureID id)
+{
+    auto it = mTextures.find(id);
+    if (it == mTextures.end())
+        return;
+
+    mResidentBytes -= it->second.residentBytes[it->second.residentMip];
+    mTextures.erase(it);
+}
+
+void TextureStreamer::requestMip(TextureID id, uint32_t mip)
+{
+    auto it = mTextures.find(id);
+    if (it == mTextures.end())
+        return;
+
+    auto& state = it->second;
+    mip = std::min(mip, state.tailMip);
+    state.pendingMip = state.hasPendingRequest ? std::min(state.pendingMip, mip) : mip;
+    state.hasPendingRequest = true;
+}
+
+void TextureStreamer::markFailed(TextureID id)
+{
+    auto it = mTextures.find(id);
+    if (it == mTextures.end())
+        return;
+
+    auto& state = it->second;
+    mResidentBytes = mResidentBytes - state.residentBytes[state.residentMip] + state.residentBytes[state.tailMip];
+    state.residentMip = state.tailMip;
+    state.desiredMip = state.tailMip;
+    mStats.failureCount++;
+}
+
+uint32_t TextureStreamer::getResidentMip(TextureID id) const
+{
+    auto it = mTextures.find(id);
+    FALCOR_CHECK(it != mTextures.end(), "Texture {} is not streamed.", id);
+    return it->second.residentMip;
+}
+
+uint32_t TextureStreamer::getTailMip(TextureID id) const
+{
+    auto it = mTextures.find(id);
+    FALCOR_CHECK(it != mTextures.end(), "Texture {} is not streamed.", id);
+    return it->second.tailMip;
+}
+
+uint32_t TextureStreamer::update()
+{
+    uint32_t changeCount = 0;
+
+    // Apply the feedback recorded since the last update. Expired requests are coarsened by one level per update,
+    // so that textures no longer in use are trimmed before others are evicted.
+    for (auto& [id, state] : mTextures)
+    {
+        if (state.hasPendingRequest)
+        {
+            state.desiredMip = state.pendingMip;
+            state.lastUsedUpdate = mUpdateIndex;
+            state.hasPendingRequest = false;
+        }
+        else if (mConfig.requestLifetime > 0 && mUpdateIndex - state.lastUsedUpdate >= mConfig.requestLifetime)
+        {
+            state.desiredMip = std::min(state.desiredMip + 1, state.tailMip);
+        }
+    }
+
+    // Enforce the budget in case it was reduced. Textures requested in this update are kept.
+    if (mResidentBytes > mConfig.budgetInBytes)
+        evict(mResidentBytes - mConfig.budgetInBytes, mUpdateIndex, changeCount);
+
+    // Collect textures that want finer mips than are resident and sort them by priority:
+    // most recently requested first, then largest difference between requested and resident mip.
+    struct Candidate
+    {
+        uint64_t lastUsed;
+        uint32_t missingMips;
+        TextureID id;
+    };
+    std::vector<Candidate> candidates;
+    for (const auto& [id, state] : mTextures)
+    {
+        if (state.desiredMip < state.residentMip && !mBackend.isLoading(id))
+            candidates.push_back({state.lastUsedUpdate, state.residentMip - state.desiredMip, id});
+    }
+    std::sort(
+        candidates.begin(),
+        candidates.end(),
+        [](const Candidate& a, const Candidate& b)
+        { return std::tie(b.lastUsed, b.missingMips, a.id) < std::tie(a.lastUsed, a.missingMips, b.id); }
+    );
+
+    // Stream in one mip level per texture, within the per-update limits and the budget.
+    uint32_t uploadCount = 0;
+    uint64_t uploadBytes = 0;
+    for (const auto& candidate : candidates)
+    {
+        if (uploadCount >= mConfig.maxUploadsPerUpdate)
+            break;
+
+        auto& state = mTextures.at(candidate.id);
+        uint32_t mip = state.residentMip - 1;
+        uint64_t addedBytes = state.residentBytes[mip] - state.residentBytes[state.residentMip];
+        uint64_t cost = state.residentBytes[mip]; // The backend uploads the whole chain from the new level.
+
+        // Always allow one upload per update so that mip levels larger than the limit are eventually streamed.
+        if (uploadCount > 0 && uploadBytes + cost > mConfig.maxUploadBytesPerUpdate)
+            continue;
+
+        // Make room if needed. Stop at the first request that doesn't fit, so that lower priority
+        // textures don't take memory that a higher priority texture is waiting for.
+        if (mResidentBytes + addedBytes > mConfig.budgetInBytes)
+        {
+            evict(mResidentBytes + addedBytes - mConfig.budgetInBytes, candidate.lastUsed, changeCount);
+            if (mResidentBytes + addedBytes > mConfig.budgetInBytes)
+                break;
+        }
+
+        if (setResidentMip(candidate.id, state, mip))
+        {
+            uploadCount++;
+            uploadBytes += cost;
+            changeCount++;
+        }
+        else
+        {
+            // Stop streaming the texture until it is requested again.
+            state.desiredMip = state.residentMip;
+        }
+    }
+
+    mUpdateIndex++;
+    return changeCount;
+}
+
+TextureStreamer::Stats TextureStreamer::getStats() const
+{
+    Stats stats = mStats;
+    stats.textureCount = mTextures.size();
+    stats.residentBytes = mResidentBytes;
+    return stats;
+}
+
+bool TextureStreamer::setResidentMip(TextureID id, TextureState& state, uint32_t mip)
+{
+    if (mip == state.residentMip)
+        return true;
+
+    if (!mBackend.setResidentMips(id, mip))
+    {
+        mStats.failureCount++;
+        return false;
+    }
+
+    uint64_t oldBytes = state.residentBytes[state.residentMip];
+    uint64_t newBytes = state.residentBytes[mip];
+    if (mip < state.residentMip)
+    {
+        mStats.uploadCount += state.residentMip - mip;
+        mStats.uploadedBytes += newBytes - oldBytes;
+    }
+    else
+    {
+        mStats.evictionCount++;
+        mStats.evictedBytes += oldBytes - newBytes;
+    }
+
+    mResidentBytes = mResidentBytes - oldBytes + newBytes;
+    state.residentMip = mip;
+    return true;
+}
+
+uint64_t TextureStreamer::evict(uint64_t bytesNeeded, uint64_t requesterLastUsed, uint32_t& changeCount)
+{
+    uint64_t bytesFreed = 0;
+
+    // Release mip levels from the given textures in least recently used order, but only as many as needed.
+    auto evictTextures = [&](auto isEvictable, auto getMinResidentMip)
+    {
+        std::vector<std::pair<uint64_t, TextureID>> order;
+        for (const auto& [id, state] : mTextures)
+        {
+            if (isEvictable(state))
+                order.emplace_back(state.lastUsedUpdate, id);
+        }
+        std::sort(order.begin(), order.end());
+
+        for (const auto& [lastUsed, id] : order)
+        {
+            if (bytesFreed >= bytesNeeded)
+                break;
+
+            auto& state = mTextures.at(id);
+            const uint64_t residentBytes = state.residentBytes[state.residentMip];
+            const uint32_t minResidentMip = getMinResidentMip(state);
+            uint32_t targetMip = state.residentMip;
+            while (targetMip < minResidentMip && bytesFreed + residentBytes - state.residentBytes[targetMip] < bytesNeeded)
+                targetMip++;
+            if (targetMip == state.residentMip)
+                continue;
+
+            uint64_t freed = residentBytes - state.residentBytes[targetMip];
+            if (setResidentMip(id, state, targetMip))
+            {
+                bytesFreed += freed;
+                changeCount++;
+            }
+        }
+    };
+
+    // First trim textures that hold finer mip levels than requested.
+    evictTextures(
+        [](const TextureState& state) { return state.residentMip < state.desiredMip; },
+        [](const TextureState& state) { return state.desiredMip; }
+    );
+
+    // Then evict textures used less recently than the requester down to their mip tail.
+    evictTextures(
+        [&](const TextureState& state) { return state.lastUsedUpdate < requesterLastUsed && state.residentMip < state.tailMip; },
+        [](const TextureState& state) { return state.tailMip; }
+    );
+
+    return bytesFreed;
+}
+} // namespace Falcor
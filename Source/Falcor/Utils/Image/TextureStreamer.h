@@ -0,0 +1,194 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include <fstd/span.h>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <vector>
+
+namespace Falcor
+{
+/**
+ * CPU-side scheduler for progressive texture streaming.
+ *
+ * Each texture is described by the sizes of its mip levels. When a texture is added, only its mip tail
+ * (the coarsest mip levels that together fit in Config::mipTailBytes) is made resident. Finer mip levels are
+ * streamed in on demand, one level per texture and update, as requested by feedback through requestMip().
+ * Requests expire after Config::requestLifetime updates, after which the requested mip level of a texture
+ * is coarsened by one level per update until the next request.
+ *
+ * Textures requested more recently have priority, then textures furthest from their requested mip.
+ * When the resident size exceeds the budget, textures holding finer mips than requested are trimmed first,
+ * followed by the least recently used textures, which are evicted down to their mip tail. Textures used more
+ * recently than the one being streamed are never evicted, and mip tails are always resident.
+ *
+ * The actual uploads and evictions are performed by a Backend, which allows the policy to be tested in isolation.
+ * This class is not thread-safe.
+ */
+class FALCOR_API TextureStreamer
+{
+public:
+    using TextureID = uint32_t;
+
+    /// Interface for changing the residency of a texture.
+    class Backend
+    {
+    public:
+        virtual ~Backend() = default;
+
+        /**
+         * Change the resident mip levels of a texture. Mip levels finer than mostDetailedMip are released,
+         * all levels from mostDetailedMip to the end of the mip chain are made resident. Streaming in a level
+         * uploads the whole chain from that level, which is what Config::maxUploadBytesPerUpdate counts.
+         * The change may complete asynchronously, in which case failures are reported with markFailed().
+         * @param[in] id Texture ID.
+         * @param[in] mostDetailedMip Most detailed resident mip level.
+         * @return True if successful or started.
+         */
+        virtual bool setResidentMips(TextureID id, uint32_t mostDetailedMip) = 0;
+
+        /**
+         * Check if an asynchronous residency change of a texture is still in progress.
+         * Finer mip levels of the texture are not streamed in until it has finished.
+         * @param[in] id Texture ID.
+         * @return True if a residency change is in progress.
+         */
+        virtual bool isLoading(TextureID id) const = 0;
+    };
+
+    struct Config
+    {
+        uint64_t budgetInBytes = std::numeric_limits<uint64_t>::max(); ///< Memory budget for all resident mip levels.
+        uint64_t mipTailBytes = 64 * 1024;                             ///< Maximum size of the mip tail loaded up front.
+        uint32_t maxUploadsPerUpdate = 16;                             ///< Maximum number of uploads per call to update().
+        uint64_t maxUploadBytesPerUpdate = 64 * 1024 * 1024; ///< Maximum number of bytes uploaded per call to update().
+        uint32_t requestLifetime = 120; ///< Number of updates a request stays in effect, 0 to keep it until the next request.
+    };
+
+    struct Stats
+    {
+        uint64_t textureCount = 0;  ///< Number of streamed textures.
+        uint64_t residentBytes = 0; ///< Total size of all resident mip levels.
+        uint64_t uploadCount = 0;   ///< Number of mip levels streamed in.
+        uint64_t uploadedBytes = 0; ///< Number of bytes streamed in.
+        uint64_t evictionCount = 0; ///< Number of evictions.
+        uint64_t evictedBytes = 0;  ///< Number of bytes evicted.
+        uint64_t failureCount = 0;  ///< Number of failed residency changes.
+    };
+
+    /**
+     * Constructor.
+     * @param[in] backend Backend performing the residency changes. Must outlive the streamer.
+     * @param[in] config Configuration.
+     */
+    TextureStreamer(Backend& backend, const Config& config);
+
+    /**
+     * Compute the first mip level of the mip tail.
+     * @param[in] mipSizes Size in bytes of each mip level, finest first.
+     * @param[in] mipTailBytes Maximum size of the mip tail. The coarsest mip level is always part of the tail.
+     * @return Most detailed mip level of the tail.
+     */
+    static uint32_t computeTailMip(fstd::span<const uint64_t> mipSizes, uint64_t mipTailBytes);
+
+    const Config& getConfig() const { return mConfig; }
+
+    /// Set the configuration. A reduced budget is enforced on the next update().
+    void setConfig(const Config& config) { mConfig = config; }
+
+    /**
+     * Add a texture and make its mip tail resident.
+     * @param[in] id Texture ID. Must not already be added.
+     * @param[in] mipSizes Size in bytes of each mip level, finest first.
+     * @return True if the mip tail was made resident. Otherwise the texture is not added.
+     */
+    bool addTexture(TextureID id, std::vector<uint64_t> mipSizes);
+
+    /**
+     * Remove a texture. The backend is not called; the caller is expected to release the texture.
+     * @param[in] id Texture ID. Unknown IDs are ignored.
+     */
+    void removeTexture(TextureID id);
+
+    bool hasTexture(TextureID id) const { return mTextures.find(id) != mTextures.end(); }
+
+    /**
+     * Record feedback for the current update. Multiple requests for the same texture keep the most detailed mip.
+     * The requested mip stays in effect for Config::requestLifetime updates, or until a texture is requested again.
+     * @param[in] id Texture ID. Unknown IDs are ignored.
+     * @param[in] mip Requested mip level. Clamped to the mip tail.
+     */
+    void requestMip(TextureID id, uint32_t mip);
+
+    /**
+     * Report that a residency change accepted by the backend failed to complete.
+     * The texture is reset to its mip tail, which is always resident, and not streamed until requested again.
+     * @param[in] id Texture ID. Unknown IDs are ignored.
+     */
+    void markFailed(TextureID id);
+
+    /// Get the most detailed resident mip level of a texture.
+    uint32_t getResidentMip(TextureID id) const;
+
+    /// Get the most detailed mip level of the mip tail of a texture.
+    uint32_t getTailMip(TextureID id) const;
+
+    /**
+     * Apply the feedback recorded since the last update. Streams in and evicts mip levels within the budget.
+     * @return Number of residency changes.
+     */
+    uint32_t update();
+
+    Stats getStats() const;
+
+private:
+    struct TextureState
+    {
+        std::vector<uint64_t> residentBytes; ///< Size of all mip levels from the given level to the end of the chain.
+        uint32_t tailMip = 0;                ///< Most detailed mip level of the mip tail.
+        uint32_t residentMip = 0;            ///< Most detailed resident mip level.
+        uint32_t desiredMip = 0;             ///< Most detailed requested mip level.
+        uint32_t pendingMip = 0;             ///< Most detailed mip level requested since the last update.
+        bool hasPendingRequest = false;      ///< True if the texture was requested since the last update.
+        uint64_t lastUsedUpdate = 0;         ///< Last update in which the texture was requested.
+    };
+
+    bool setResidentMip(TextureID id, TextureState& state, uint32_t mip);
+    uint64_t evict(uint64_t bytesNeeded, uint64_t requesterLastUsed, uint32_t& changeCount);
+
+    Backend& mBackend;
+    Config mConfig;
+
+    std::map<TextureID, TextureState> mTextures;
+    uint64_t mUpdateIndex = 1;
+    uint64_t mResidentBytes = 0;
+    Stats mStats;
+};
+} // namespace Falcor
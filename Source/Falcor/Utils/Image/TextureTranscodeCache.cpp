@@ -0,0 +1,192 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "TextureTranscodeCache.h"
+#include "Core/Error.h"
+#include "Core/Platform/OS.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Utils/CryptoUtils.h"
+#include "Utils/Logger.h"
+
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace Falcor
+{
+namespace
+{
+/// Cache version. This needs to be incremented every time the transcoding changes!
+const uint32_t kVersion = 1;
+
+/// Cache directory (subdirectory in the application data directory).
+const std::string kDirectory = "NVIDIA/Falcor/TextureCache";
+
+/// Extension of marker files for images that are not cached.
+const std::string kSkipExtension = ".skip";
+
+/// File extensions of formats that are never cached (already compressed or HDR).
+const char* kUncachedExtensions[] = {"dds", "exr", "hdr", "pfm"};
+
+bool isOpaque(const Bitmap& bitmap)
+{
+    const uint8_t* pData = bitmap.getData();
+    const size_t pixelCount = size_t(bitmap.getWidth()) * bitmap.getHeight();
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        if (pData[4 * i + 3] != 0xff)
+            return false;
+    }
+    return true;
+}
+
+void touchFile(const std::filesystem::path& path)
+{
+    std::ofstream(path, std::ios::binary);
+}
+
+std::filesystem::path getTempPath(const std::filesystem::path& path)
+{
+    auto tempPath = path;
+    tempPath += fmt::format(".{}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return tempPath;
+}
+} // namespace
+
+TextureTranscodeCache::TextureTranscodeCache(std::filesystem::path directory) : mDirectory(std::move(directory)) {}
+
+std::filesystem::path TextureTranscodeCache::getDefaultDirectory()
+{
+    return getAppDataDirectory() / kDirectory;
+}
+
+std::filesystem::path TextureTranscodeCache::getOrCreate(
+    const std::filesystem::path& path,
+    bool loadAsSrgb,
+    Bitmap::ImportFlags importFlags
+)
+{
+    for (const char* ext : kUncachedExtensions)
+    {
+        if (hasExtension(path, ext))
+        {
+            mSkipped++;
+            return {};
+        }
+    }
+
+    // Compute the cache key from the file content.
+    SHA1 sha1;
+    {
+        MemoryMappedFile file(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+        if (!file.isOpen())
+        {
+            mFailures++;
+            return {};
+        }
+        sha1.update(kVersion);
+        sha1.update(loadAsSrgb);
+        sha1.update(static_cast<uint32_t>(importFlags));
+        sha1.update(file.getData(), file.getSize());
+    }
+    const auto cachePath = mDirectory / (SHA1::toString(sha1.finalize()) + ".dds");
+    auto skipPath = cachePath;
+    skipPath.replace_extension(kSkipExtension);
+
+    if (std::filesystem::exists(cachePath))
+    {
+        mHits++;
+        return cachePath;
+    }
+    if (std::filesystem::exists(skipPath))
+    {
+        mSkipped++;
+        return {};
+    }
+
+    try
+    {
+        std::filesystem::create_directories(mDirectory);
+
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(path, true /* top-down */, importFlags);
+        if (!pBitmap)
+        {
+            mFailures++;
+            return {};
+        }
+
+        ImageIO::CompressionMode mode = selectCompressionMode(*pBitmap);
+        if (mode == ImageIO::CompressionMode::None)
+        {
+            // Remember the decision so later loads don't decode the image twice.
+            touchFile(skipPath);
+            mSkipped++;
+            return {};
+        }
+
+        // Write to a temporary file first, concurrent transcodes of the same content then race benignly on the rename.
+        const auto tempPath = getTempPath(cachePath);
+        ImageIO::saveToDDS(tempPath, *pBitmap, mode, true /* generate mips */);
+        std::filesystem::rename(tempPath, cachePath);
+
+        logDebug("Transcoded texture '{}' to '{}'.", path, cachePath);
+        mMisses++;
+        return cachePath;
+    }
+    catch (const std::exception& e)
+    {
+        logWarning("Failed to transcode texture '{}': {}", path, e.what());
+        mFailures++;
+        return {};
+    }
+}
+
+ImageIO::CompressionMode TextureTranscodeCache::selectCompressionMode(const Bitmap& bitmap)
+{
+    // Block compression requires the base level to be a multiple of 4. Don't cache images that would be cropped.
+    if (bitmap.getWidth() % 4 != 0 || bitmap.getHeight() % 4 != 0)
+        return ImageIO::CompressionMode::None;
+
+    switch (bitmap.getFormat())
+    {
+    case ResourceFormat::BGRA8Unorm:
+    case ResourceFormat::RGBA8Unorm:
+        return isOpaque(bitmap) ? ImageIO::CompressionMode::BC1 : ImageIO::CompressionMode::BC7;
+    case ResourceFormat::BGRX8Unorm:
+        return ImageIO::CompressionMode::BC1;
+    case ResourceFormat::RG8Unorm:
+        return ImageIO::CompressionMode::BC5;
+    default:
+        return ImageIO::CompressionMode::None;
+    }
+}
+
+TextureTranscodeCache::Stats TextureTranscodeCache::getStats() const
+{
+    return Stats{mHits.load(), mMisses.load(), mSkipped.load(), mFailures.load()};
+}
+} // namespace Falcor
@@ -0,0 +1,97 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Bitmap.h"
+#include "ImageIO.h"
+#include "Core/Macros.h"
+#include <atomic>
+#include <filesystem>
+
+namespace Falcor
+{
+/**
+ * Disk cache of block-compressed, pre-mipped DDS versions of image files.
+ *
+ * Entries are keyed by the SHA-1 of the source file content together with the sRGB state and import flags,
+ * so renamed or moved files still hit the cache and edited files miss it. On a miss, the image is decoded,
+ * block compressed with a mode chosen by channel usage (see selectCompressionMode()) and written to the cache
+ * with a full mip chain. Images that cannot be transcoded without loss of range or resolution (HDR formats,
+ * single channel images, dimensions not a multiple of 4) are not cached.
+ *
+ * All operations are thread-safe.
+ */
+class FALCOR_API TextureTranscodeCache
+{
+public:
+    struct Stats
+    {
+        uint64_t hits = 0;     ///< Number of lookups served from the cache.
+        uint64_t misses = 0;   ///< Number of lookups that transcoded a new cache entry.
+        uint64_t skipped = 0;  ///< Number of lookups for images that are not cached.
+        uint64_t failures = 0; ///< Number of failed transcodes.
+    };
+
+    /**
+     * Constructor.
+     * @param[in] directory Cache directory. Created on first write.
+     */
+    TextureTranscodeCache(std::filesystem::path directory = getDefaultDirectory());
+
+    /// Default cache directory (subdirectory in the application data directory).
+    static std::filesystem::path getDefaultDirectory();
+
+    const std::filesystem::path& getDirectory() const { return mDirectory; }
+
+    /**
+     * Get the cached DDS file for an image file, transcoding it on a miss.
+     * @param[in] path Path of the source image file.
+     * @param[in] loadAsSrgb Whether the texture is loaded as sRGB.
+     * @param[in] importFlags Import flags of the texture.
+     * @return Path of the cached DDS file, or an empty path if the image is not cached.
+     */
+    std::filesystem::path getOrCreate(const std::filesystem::path& path, bool loadAsSrgb, Bitmap::ImportFlags importFlags);
+
+    /**
+     * Select the block compression mode for a bitmap based on its format and channel usage.
+     * Opaque RGB(A) images use BC1, images with alpha use BC7 and two channel images use BC5.
+     * @param[in] bitmap Bitmap to analyze.
+     * @return Compression mode, or CompressionMode::None if the bitmap should not be transcoded.
+     */
+    static ImageIO::CompressionMode selectCompressionMode(const Bitmap& bitmap);
+
+    Stats getStats() const;
+
+private:
+    std::filesystem::path mDirectory;
+
+    std::atomic<uint64_t> mHits{0};
+    std::atomic<uint64_t> mMisses{0};
+    std::atomic<uint64_t> mSkipped{0};
+    std::atomic<uint64_t> mFailures{0};
+};
+} // namespace Falcor
@@ -29,18 +29,39 @@
 #include "Core/Error.h"
 #include "Core/Platform/OS.h"
 #include "Utils/Scripting/ScriptBindings.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <mutex>
 #include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if FALCOR_WINDOWS
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif FALCOR_LINUX
+#include <unistd.h>
+#endif
 
 namespace Falcor
 {
 namespace
 {
 std::mutex sMutex;
-Logger::Level sVerbosity = Logger::Level::Info;
-Logger::OutputFlags sOutputs = Logger::OutputFlags::Console | Logger::OutputFlags::File | Logger::OutputFlags::DebugWindow;
+std::atomic<Logger::Level> sVerbosity{Logger::Level::Info};
+std::atomic<Logger::OutputFlags> sOutputs{Logger::OutputFlags::Console | Logger::OutputFlags::File | Logger::OutputFlags::DebugWindow};
+std::atomic<uint32_t> sRepeatLimit{100};
 std::filesystem::path sLogFilePath;
 
 bool sInitialized = false;
@@ -76,6 +97,7 @@ FILE* openLogFile()
 
 void printToLogFile(const std::string& s)
 {
+    std::lock_guard<std::mutex> lock(sMutex);
     if (!sInitialized)
     {
         sLogFile = openLogFile();
@@ -84,13 +106,13 @@ void printToLogFile(const std::string& s)
 
     if (sLogFile)
     {
-        std::fprintf(sLogFile, "%s", s.c_str());
+        std::fwrite(s.data(), 1, s.size(), sLogFile);
         std::fflush(sLogFile);
     }
 }
-} // namespace
 
-void Logger::shutdown()
+/// Close the log file. Requires sMutex to be held.
+void closeLogFile()
 {
     if (sLogFile)
     {
@@ -99,6 +121,7 @@ void Logger::shutdown()
         sInitialized = false;
     }
 }
+} // namespace
 
 inline const char* getLogLevelString(Logger::Level level)
 {
@@ -146,71 +169,479 @@ private:
     std::set<std::string, std::less<>> mStrings;
 };
 
-void Logger::log(Level level, const std::string_view msg, Frequency frequency)
+namespace
 {
-    std::lock_guard<std::mutex> lock(sMutex);
-    if (level <= sVerbosity)
+struct LogMessage
+{
+    uint64_t sequence = 0;
+    Logger::Level level = Logger::Level::Info;
+    Logger::Frequency frequency = Logger::Frequency::Always;
+    std::string text;
+};
+
+/**
+ * Single-producer single-consumer ring buffer holding the messages of one thread.
+ * The owning thread pushes messages without locking, the messages are consumed while holding the write lock.
+ */
+class MessageRing
+{
+public:
+    static constexpr size_t kCapacity = 1024;
+
+    bool tryPush(LogMessage&& message)
+    {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        if (head - mTail.load(std::memory_order_acquire) == kCapacity)
+            return false;
+        mSlots[head % kCapacity] = std::move(message);
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Move all queued messages to the end of a list. Their slots are only freed by release().
+    size_t collect(std::vector<LogMessage>& messages)
     {
-        std::string s = fmt::format("{} {}\n", getLogLevelString(level), msg);
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        size_t head = mHead.load(std::memory_order_acquire);
+        for (size_t i = tail; i < head; i++)
+            messages.push_back(std::move(mSlots[i % kCapacity]));
+        return head;
+    }
+
+    void release(size_t tail) { mTail.store(tail, std::memory_order_release); }
+
+    bool isEmpty() const { return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire); }
+
+    std::atomic<bool> ownerExited{false};
 
-        if (frequency == Frequency::Once && MessageDeduplicator::instance().isDuplicate(s))
+private:
+    std::array<LogMessage, kCapacity> mSlots;
+    std::atomic<size_t> mHead{0}; ///< Number of messages pushed.
+    std::atomic<size_t> mTail{0}; ///< Number of messages written out.
+};
+
+/**
+ * Drops repeats of a message beyond the repeat limit within one second, and reports how many were dropped.
+ * Messages are counted in a fixed size table indexed by the hash of their text, which keeps counting cheap
+ * when many distinct messages are logged. A message evicted from the table by another one starts counting anew.
+ */
+class RepeatLimiter
+{
+public:
+    RepeatLimiter() : mEntries(kTableSize) {}
+
+    /// Start a new one second window if the current one has passed. Appends summaries of the dropped messages to a list.
+    void update(std::chrono::steady_clock::time_point now, std::vector<LogMessage>& summaries)
+    {
+        if (now - mWindowStart < std::chrono::seconds(1))
             return;
+        for (auto& entry : mEntries)
+            reset(entry, summaries);
+        mWindowStart = now;
+    }
 
-        // Write to console.
-        if (is_set(sOutputs, OutputFlags::Console))
+    /// Returns true if the message should be printed. Appends the summary of an evicted message to a list.
+    bool accept(const LogMessage& message, uint32_t limit, std::vector<LogMessage>& summaries)
+    {
+        if (limit == 0)
+            return true;
+        size_t hash = std::hash<std::string>()(message.text);
+        Entry& entry = mEntries[hash % kTableSize];
+        if (entry.count == 0 || entry.hash != hash)
         {
-            auto& os = level > Logger::Level::Error ? std::cout : std::cerr;
-            os << s;
-            os.flush();
+            reset(entry, summaries);
+            entry.hash = hash;
         }
+        entry.level = message.level;
+        entry.limit = limit;
+        if (++entry.count <= limit)
+            return true;
+        if (entry.text.empty())
+            entry.text = message.text;
+        return false;
+    }
 
-        // Write to file.
-        if (is_set(sOutputs, OutputFlags::File))
+private:
+    static constexpr size_t kTableSize = 4096;
+
+    struct Entry
+    {
+        size_t hash = 0;
+        Logger::Level level = Logger::Level::Info;
+        uint32_t limit = 0;
+        uint32_t count = 0;
+        std::string text; ///< Only stored once the message is dropped.
+    };
+
+    static void reset(Entry& entry, std::vector<LogMessage>& summaries)
+    {
+        if (entry.count > entry.limit)
+            summaries.push_back(
+                {0, entry.level, Logger::Frequency::Always, fmt::format("Suppressed {} repeats of: {}", entry.count - entry.limit, entry.text)}
+            );
+        entry.count = 0;
+        entry.text.clear();
+    }
+
+    std::chrono::steady_clock::time_point mWindowStart = std::chrono::steady_clock::now();
+    std::vector<Entry> mEntries;
+};
+
+void installCrashHandlers();
+
+/**
+ * Background writer for the message rings.
+ * The state is never destroyed, so that threads can keep logging while the process exits.
+ */
+class LogWriter
+{
+public:
+    static LogWriter& get()
+    {
+        static LogWriter* spWriter = new LogWriter();
+        return *spWriter;
+    }
+
+    void push(LogMessage&& message)
+    {
+        MessageRing& ring = getThreadRing();
+        message.sequence = mNextSequence.fetch_add(1, std::memory_order_relaxed);
+        ensureThreadStarted();
+        while (!ring.tryPush(std::move(message)))
+        {
+            // The ring is full, write it out on this thread. This throttles threads logging faster than the output can take.
+            write();
+        }
+        if (!mPending.exchange(true, std::memory_order_acq_rel))
+            mWake.notify_one();
+    }
+
+    /// Write all queued messages on the calling thread.
+    void write()
+    {
+        std::lock_guard<std::mutex> lock(mWriteMutex);
+        writePending();
+    }
+
+    /// Stop the writer thread after writing all queued messages.
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mThreadMutex);
+            if (!mThread.joinable())
+                return;
+            mStop = true;
+        }
+        mWake.notify_one();
+        mThread.join();
+        std::lock_guard<std::mutex> lock(mThreadMutex);
+        mStop = false;
+        mThreadStarted = false;
+    }
+
+    /// Write all queued messages when exiting or crashing. Gives up if another thread does not finish writing in time.
+    void writeAtExit()
+    {
+        std::unique_lock<std::mutex> lock(mWriteMutex, std::defer_lock);
+        for (int i = 0; i < 100 && !lock.try_lock(); i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (lock.owns_lock())
+            writePending();
+    }
+
+private:
+    /// Time between batches while messages are queued.
+    static constexpr auto kBatchInterval = std::chrono::milliseconds(5);
+    /// Longest time between checks for queued messages. Producers notify without locking, so a wakeup can be missed.
+    static constexpr auto kIdleInterval = std::chrono::milliseconds(50);
+
+    LogWriter()
+    {
+        // Keep the pending messages when the process exits. Threads may already be gone at this point,
+        // so the messages are written from the exiting thread.
+        std::atexit([]() { LogWriter::get().writeAtExit(); });
+        std::at_quick_exit([]() { LogWriter::get().writeAtExit(); });
+        installCrashHandlers();
+    }
+
+    struct RingOwner
+    {
+        std::shared_ptr<MessageRing> pRing;
+        ~RingOwner()
+        {
+            if (pRing)
+                pRing->ownerExited = true;
+        }
+    };
+
+    MessageRing& getThreadRing()
+    {
+        thread_local RingOwner tOwner;
+        if (!tOwner.pRing)
+        {
+            tOwner.pRing = std::make_shared<MessageRing>();
+            std::lock_guard<std::mutex> lock(mRingsMutex);
+            mRings.push_back(tOwner.pRing);
+        }
+        return *tOwner.pRing;
+    }
+
+    void ensureThreadStarted()
+    {
+        if (mThreadStarted.load(std::memory_order_acquire))
+            return;
+        std::lock_guard<std::mutex> lock(mThreadMutex);
+        if (!mThread.joinable())
+        {
+            mThread = std::thread(&LogWriter::run, this);
+            mThreadStarted = true;
+        }
+    }
+
+    void run()
+    {
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mThreadMutex);
+                mWake.wait_for(lock, kIdleInterval, [&]() { return mStop || mPending.load(std::memory_order_acquire); });
+                if (mStop)
+                    break;
+            }
+            // Give other threads a moment to add to the batch.
+            std::this_thread::sleep_for(kBatchInterval);
+            write();
+        }
+        write();
+    }
+
+    /// Write all queued messages. Requires the write lock to be held.
+    void writePending()
+    {
+
+        mPending.store(false, std::memory_order_release);
+
+        // Gather the messages of all threads and restore their logging order.
+        std::vector<std::pair<std::shared_ptr<MessageRing>, size_t>> collected;
+        {
+            std::lock_guard<std::mutex> lock(mRingsMutex);
+            for (const auto& pRing : mRings)
+                collected.emplace_back(pRing, pRing->collect(mMessages));
+        }
+        std::sort(mMessages.begin(), mMessages.end(), [](const LogMessage& a, const LogMessage& b) { return a.sequence < b.sequence; });
+
+        const uint32_t repeatLimit = sRepeatLimit.load(std::memory_order_relaxed);
+        mOutputs.clear();
+        mRepeatLimiter.update(std::chrono::steady_clock::now(), mOutputs);
+        for (auto& message : mMessages)
         {
-            printToLogFile(s);
+            if (message.frequency == Logger::Frequency::Once &&
+                MessageDeduplicator::instance().isDuplicate(fmt::format("{} {}\n", getLogLevelString(message.level), message.text)))
+                continue;
+            if (mRepeatLimiter.accept(message, repeatLimit, mOutputs))
+                mOutputs.push_back(std::move(message));
         }
+        output(mOutputs);
+        mMessages.clear();
+
+        // Free the ring slots only after writing, and drop the rings of exited threads.
+        for (const auto& [pRing, tail] : collected)
+            pRing->release(tail);
+        std::lock_guard<std::mutex> lock(mRingsMutex);
+        mRings.erase(
+            std::remove_if(mRings.begin(), mRings.end(), [](const auto& pRing) { return pRing->ownerExited && pRing->isEmpty(); }),
+            mRings.end()
+        );
+    }
+
+    /// Print a batch of messages to the selected outputs.
+    static void output(const std::vector<LogMessage>& messages)
+    {
+        if (messages.empty())
+            return;
+
+        const Logger::OutputFlags outputs = sOutputs.load(std::memory_order_relaxed);
+        const bool debugWindow = is_set(outputs, Logger::OutputFlags::DebugWindow) && isDebuggerPresent();
+
+        std::string fileText;
+        std::string consoleText;
+        bool consoleIsError = false;
+        auto flushConsole = [&]()
+        {
+            if (consoleText.empty())
+                return;
+            auto& os = consoleIsError ? std::cerr : std::cout;
+            os << consoleText;
+            os.flush();
+            consoleText.clear();
+        };
 
-        // Write to debug window if debugger is attached.
-        if (is_set(sOutputs, OutputFlags::DebugWindow) && isDebuggerPresent())
+        for (const auto& message : messages)
         {
-            printToDebugWindow(s);
+            std::string s = fmt::format("{} {}\n", getLogLevelString(message.level), message.text);
+
+            // Write to console. Consecutive messages to the same stream are written together.
+            if (is_set(outputs, Logger::OutputFlags::Console))
+            {
+                bool isError = message.level <= Logger::Level::Error;
+                if (isError != consoleIsError)
+                    flushConsole();
+                consoleIsError = isError;
+                consoleText += s;
+            }
+
+            // Write to debug window if debugger is attached.
+            if (debugWindow)
+                printToDebugWindow(s);
+
+            if (is_set(outputs, Logger::OutputFlags::File))
+                fileText += s;
         }
+        flushConsole();
+
+        // Write to file.
+        if (!fileText.empty())
+            printToLogFile(fileText);
+    }
+
+    std::mutex mRingsMutex;
+    std::vector<std::shared_ptr<MessageRing>> mRings;
+    std::atomic<uint64_t> mNextSequence{0};
+
+    std::mutex mWriteMutex; ///< Held while writing. Protects the members below.
+    std::vector<LogMessage> mMessages;
+    std::vector<LogMessage> mOutputs;
+    RepeatLimiter mRepeatLimiter;
+
+    std::mutex mThreadMutex;
+    std::condition_variable mWake;
+    std::thread mThread;
+    std::atomic<bool> mThreadStarted{false};
+    std::atomic<bool> mPending{false};
+    bool mStop = false;
+};
+
+/**
+ * Best-effort crash handling: write the queued messages, then pass the crash on to the previously installed handler.
+ * Writing is not async-signal-safe, it can fail or block if the crash happened inside the logger or the allocator.
+ */
+constexpr int kCrashSignals[] = {SIGSEGV, SIGABRT, SIGFPE, SIGILL};
+using SignalHandler = void (*)(int);
+SignalHandler sPreviousSignalHandlers[std::size(kCrashSignals)];
+std::atomic<bool> sCrashed{false};
+
+void writeOnCrash()
+{
+    if (sCrashed.exchange(true))
+        return;
+#if FALCOR_LINUX
+    // Terminate through SIGALRM if writing blocks, rather than leaving a hung process behind.
+    alarm(2);
+#endif
+    LogWriter::get().writeAtExit();
+#if FALCOR_LINUX
+    alarm(0);
+#endif
+}
+
+void onCrashSignal(int signal)
+{
+    writeOnCrash();
+    for (size_t i = 0; i < std::size(kCrashSignals); i++)
+    {
+        if (kCrashSignals[i] == signal)
+            std::signal(signal, sPreviousSignalHandlers[i]);
     }
+    std::raise(signal);
 }
 
-void Logger::setVerbosity(Level level)
+#if FALCOR_WINDOWS
+LPTOP_LEVEL_EXCEPTION_FILTER sPreviousExceptionFilter = nullptr;
+
+LONG WINAPI onUnhandledException(EXCEPTION_POINTERS* pExceptionInfo)
 {
+    writeOnCrash();
+    return sPreviousExceptionFilter ? sPreviousExceptionFilter(pExceptionInfo) : EXCEPTION_CONTINUE_SEARCH;
+}
+#endif
+
+void installCrashHandlers()
+{
+    for (size_t i = 0; i < std::size(kCrashSignals); i++)
+    {
+        SignalHandler previous = std::signal(kCrashSignals[i], onCrashSignal);
+        sPreviousSignalHandlers[i] = previous == SIG_ERR ? SIG_DFL : previous;
+    }
+#if FALCOR_WINDOWS
+    // Structured exceptions such as access violations do not raise signals on Windows.
+    sPreviousExceptionFilter = SetUnhandledExceptionFilter(onUnhandledException);
+#endif
+}
+} // namespace
+
+void Logger::shutdown()
+{
+    LogWriter::get().stop();
     std::lock_guard<std::mutex> lock(sMutex);
+    closeLogFile();
+}
+
+void Logger::log(Level level, const std::string_view msg, Frequency frequency)
+{
+    if (level > sVerbosity.load(std::memory_order_relaxed))
+        return;
+
+    LogWriter& writer = LogWriter::get();
+    writer.push({0, level, frequency, std::string(msg)});
+
+    // Write errors out right away, so they are not lost if the process terminates.
+    if (level <= Level::Error)
+        writer.write();
+}
+
+void Logger::flush()
+{
+    LogWriter::get().write();
+}
+
+void Logger::setRepeatLimit(uint32_t limit)
+{
+    sRepeatLimit = limit;
+}
+
+uint32_t Logger::getRepeatLimit()
+{
+    return sRepeatLimit;
+}
+
+void Logger::setVerbosity(Level level)
+{
     sVerbosity = level;
 }
 
 Logger::Level Logger::getVerbosity()
 {
-    std::lock_guard<std::mutex> lock(sMutex);
     return sVerbosity;
 }
 
 void Logger::setOutputs(OutputFlags outputs)
 {
-    std::lock_guard<std::mutex> lock(sMutex);
+    // Messages queued so far go to the previous outputs.
+    flush();
     sOutputs = outputs;
 }
 
 Logger::OutputFlags Logger::getOutputs()
 {
-    std::lock_guard<std::mutex> lock(sMutex);
     return sOutputs;
 }
 
 void Logger::setLogFilePath(const std::filesystem::path& path)
 {
+    // Messages queued so far go to the previous log file.
+    flush();
     std::lock_guard<std::mutex> lock(sMutex);
-    if (sLogFile)
-    {
-        fclose(sLogFile);
-        sLogFile = nullptr;
-        sInitialized = false;
-    }
+    closeLogFile();
     sLogFilePath = path;
 }
 
@@ -255,6 +686,11 @@ FALCOR_SCRIPT_BINDING(Logger)
         [](pybind11::object) { return Logger::getLogFilePath(); },
         [](pybind11::object, std::filesystem::path path) { Logger::setLogFilePath(path); }
     );
+    logger.def_property_static(
+        "repeat_limit",
+        [](pybind11::object) { return Logger::getRepeatLimit(); },
+        [](pybind11::object, uint32_t limit) { Logger::setRepeatLimit(limit); }
+    );
 
     logger.def_static(
         "log",
@@ -262,6 +698,7 @@ FALCOR_SCRIPT_BINDING(Logger)
         "level"_a,
         "msg"_a
     );
+    logger.def_static("flush", &Logger::flush);
 }
 
 } // namespace Falcor
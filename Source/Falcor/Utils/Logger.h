@@ -29,6 +29,7 @@
 #include "Core/Macros.h"
 #include "Utils/StringFormatters.h"
 #include <fmt/core.h>
+#include <cstdint>
 #include <string_view>
 #include <filesystem>
 
@@ -37,6 +38,14 @@ namespace Falcor
 /**
  * Container class for logging messages.
  * Messages are only printed to the selected outputs if they match the verbosity level.
+ *
+ * Logging is asynchronous: each thread queues its messages in its own lock-free buffer and a
+ * background thread writes them out in batches, ordered by the time they were logged. Errors and fatal
+ * messages are written out before the log call returns, along with all messages queued before them.
+ * Pending messages are also written at exit and quick_exit. On crashes (SIGSEGV, SIGABRT, SIGFPE, SIGILL
+ * and unhandled structured exceptions on Windows), a handler tries to write them before passing the crash
+ * on to the previous handler. This is best effort: messages can still be lost if the crash happens inside
+ * the logger or the allocator, or if the handler is replaced by the application.
  */
 class FALCOR_API Logger
 {
@@ -109,6 +118,19 @@ public:
      */
     static std::filesystem::path getLogFilePath();
 
+    /**
+     * Set the maximum number of times the same message is printed per second.
+     * Further repeats are dropped and reported with a summary once the second has passed.
+     * @param[in] limit Maximum repeats per second, or 0 to print all messages.
+     */
+    static void setRepeatLimit(uint32_t limit);
+
+    /**
+     * Get the maximum number of times the same message is printed per second.
+     * @return Returns the repeat limit, 0 if disabled.
+     */
+    static uint32_t getRepeatLimit();
+
     /**
      * Log a message.
      * @param[in] level Log level.
@@ -116,6 +138,11 @@ public:
      */
     static void log(Level level, const std::string_view msg, Frequency frequency = Frequency::Always);
 
+    /**
+     * Write out all queued messages. Blocks until done.
+     */
+    static void flush();
+
 private:
     Logger() = delete;
 };
@@ -75,6 +75,57 @@ inline float3 oct_to_ndir_snorm(float2 p)
     return normalize(n);
 }
 
+/**
+ * Converts normalized direction to the octahedral map (equal-area, unsigned normalized).
+ * @param[in] n Normalized direction.
+ * @return Position in octahedral map in [0,1] for each component.
+ */
+inline float2 ndir_to_oct_equal_area_unorm(float3 n)
+{
+    // Use atan2 to avoid explicit div-by-zero check in atan(y/x).
+    float r = std::sqrt(1.f - std::abs(n.z));
+    float phi = std::atan2(std::abs(n.y), std::abs(n.x));
+
+    // Compute p = (u,v) in the first quadrant.
+    float2 p;
+    p.y = r * phi * float(M_2_PI);
+    p.x = r - p.y;
+
+    // Reflect p over the diagonals, and move to the correct quadrant.
+    if (n.z < 0.f)
+        p = float2(1.f - p.y, 1.f - p.x);
+    p.x *= n.x > 0.f ? 1.f : (n.x < 0.f ? -1.f : 0.f);
+    p.y *= n.y > 0.f ? 1.f : (n.y < 0.f ? -1.f : 0.f);
+
+    return p * 0.5f + 0.5f;
+}
+
+/**
+ * Converts point in the octahedral map to normalized direction (equal area, unsigned normalized).
+ * @param[in] p Position in octahedral map in [0,1] for each component.
+ * @return Normalized direction.
+ */
+inline float3 oct_to_ndir_equal_area_unorm(float2 p)
+{
+    p = p * 2.f - 1.f;
+
+    // Compute radius r without branching. The radius r=0 at +z (center) and at -z (corners).
+    float d = 1.f - (std::abs(p.x) + std::abs(p.y));
+    float r = 1.f - std::abs(d);
+
+    // Compute phi in [0,pi/2] (first quadrant) and sin/cos without branching.
+    float phi = (r > 0.f) ? ((std::abs(p.y) - std::abs(p.x)) / r + 1.f) * float(M_PI_4) : 0.f;
+
+    // Convert to Cartesian coordinates. Note that sign(x)=0 for x=0, but that's fine here.
+    auto sign = [](float x) { return x > 0.f ? 1.f : (x < 0.f ? -1.f : 0.f); };
+    float f = r * std::sqrt(2.f - r * r);
+    float x = f * sign(p.x) * std::cos(phi);
+    float y = f * sign(p.y) * std::sin(phi);
+    float z = sign(d) * (1.f - r * r);
+
+    return float3(x, y, z);
+}
+
 /**
  * Encode a normal packed as 2x 16-bit snorms in the octahedral mapping.
  */
@@ -28,118 +28,263 @@
 #include "AliasTable.h"
 #include "Core/Error.h"
 #include "Core/API/Device.h"
+#include "Utils/Math/Common.h"
+#include "Utils/TaskManager.h"
+#include <algorithm>
+#include <numeric>
 
 namespace Falcor
 {
-// This builds an alias table via the O(N) algorithm from Vose 1991, "A linear algorithm for generating random
-// numbers with a given distribution," IEEE Transactions on Software Engineering 17(9), 972-975.
-//
-// Basic idea:  creating each alias table entry combines one overweighted sample and one underweighted sample
-// into one alias table entry plus a residual sample (the overweighted sample minus some of its weight).
-//
-// By first separating all inputs into 2 temporary buffer (one overweighted set, with weights above the
-// average; one underweighted set, with weights below average), we can simply walk through the lists once,
-// merging the first elements in each temporary buffer.  The residual sample is interted into either the
-// overweighted or underweighted set, depending on its residual weight.
-//
-// The main complexity is dealing with corner cases, thanks to numerical precision issues, where you don't
-// have 2 valid entries to combine.  By definition, in these corner cases, all remaining unhandled samples
-// actually have the average weight (within numerical precision limits)
-AliasTable::AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt19937& rng) : mCount((uint32_t)weights.size())
+namespace
 {
-    // Use >= since we reserve 0xFFFFFFFFu as an invalid flag marker during construction.
-    if (weights.size() >= std::numeric_limits<uint32_t>::max())
-        FALCOR_THROW("Too many entries for alias table.");
+/// Number of elements processed per parallel task. This is also the number of table items per independently built section.
+const uint32_t kBlockSize = 1 << 16;
 
-    std::uniform_int_distribution<uint32_t> rngDist;
+/// Calls func(block, begin, end) in parallel for blocks of kBlockSize elements covering [0, count).
+template<typename Func>
+void forEachBlock(uint32_t count, Func func)
+{
+    parallelFor(
+        0,
+        div_round_up(count, kBlockSize),
+        [&](uint32_t block)
+        {
+            uint32_t begin = block * kBlockSize;
+            func(block, begin, std::min(count, begin + kBlockSize));
+        }
+    );
+}
 
-    mpWeights =
-        pDevice->createStructuredBuffer(sizeof(float), mCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, weights.data());
+/// Computes the exclusive prefix sums of the weights of the given indices in double precision. Returns indices.size() + 1 values.
+std::vector<double> computePrefixSums(const std::vector<uint32_t>& indices, const std::vector<float>& weights)
+{
+    uint32_t count = (uint32_t)indices.size();
+    std::vector<double> blockSums(div_round_up(count, kBlockSize) + 1, 0.0);
+    forEachBlock(
+        count,
+        [&](uint32_t block, uint32_t begin, uint32_t end)
+        {
+            double sum = 0.0;
+            for (uint32_t i = begin; i < end; ++i)
+                sum += weights[indices[i]];
+            blockSums[block + 1] = sum;
+        }
+    );
+    std::partial_sum(blockSums.begin(), blockSums.end(), blockSums.begin());
 
-    // Our working set / intermediate buffers (underweight & overweight); initialize to "invalid"
-    std::vector<uint32_t> lowIdx(mCount, 0xFFFFFFFFu);
-    std::vector<uint32_t> highIdx(mCount, 0xFFFFFFFFu);
+    std::vector<double> prefixSums(count + 1);
+    forEachBlock(
+        count,
+        [&](uint32_t block, uint32_t begin, uint32_t end)
+        {
+            double sum = blockSums[block];
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                prefixSums[i] = sum;
+                sum += weights[indices[i]];
+            }
+        }
+    );
+    prefixSums[count] = blockSums.back();
+    return prefixSums;
+}
+} // namespace
+
+AliasTable::AliasTable(std::vector<float> weights) : mCount((uint32_t)weights.size()), mWeights(std::move(weights))
+{
+    // Use >= since we reserve 0xFFFFFFFFu as an invalid index.
+    if (mWeights.size() >= std::numeric_limits<uint32_t>::max())
+        FALCOR_THROW("Too many entries for alias table.");
+    FALCOR_CHECK(!mWeights.empty(), "Alias table must have at least one entry.");
+
+    build();
+}
+
+AliasTable::AliasTable(std::vector<float> weights, std::vector<Item> items)
+    : mCount((uint32_t)weights.size()), mWeights(std::move(weights)), mItems(std::move(items))
+{
+    if (mWeights.size() >= std::numeric_limits<uint32_t>::max())
+        FALCOR_THROW("Too many entries for alias table.");
+    FALCOR_CHECK(!mWeights.empty(), "Alias table must have at least one entry.");
+    FALCOR_CHECK(mItems.size() == mWeights.size(), "Alias table has {} items, expected {}.", mItems.size(), mWeights.size());
 
-    // Sum element weights, use double to minimize precision issues
     mWeightSum = 0.0;
-    for (float f : weights)
+    for (float f : mWeights)
         mWeightSum += f;
+}
 
-    // Find the average weight
-    float avgWeight = float(mWeightSum / double(mCount));
+// This builds an alias table with the sweeping algorithm from Vose 1991, "A linear algorithm for generating random
+// numbers with a given distribution," IEEE Transactions on Software Engineering 17(9), 972-975, parallelized with
+// the splitting scheme from Huebschle-Schneider and Sanders 2019, "Parallel Weighted Random Sampling".
+//
+// Basic idea:  creating each alias table entry combines one underweighted item with the overweighted item that is
+// currently being consumed. Items are separated into a list of underweighted (light) items, with weights below
+// average, and a list of overweighted (heavy) items. The sweep walks through both lists in order. Each light item
+// fills its entry with some weight from the current heavy item. Once the residual weight of the current heavy item
+// drops below average, it gets an entry of its own, which is filled from the next heavy item.
+//
+// After i light items and j heavy items got their entries, exactly i + j entries of average weight are filled.
+// The residual weight of heavy item j is therefore sumL(i) + sumH(j + 1) - (i + j) * avg, where sumL and sumH are
+// prefix sums over the light and heavy lists. This lets us compute the state of the sweep at any entry m without
+// running the sweep up to m: j is the largest count such that sumL(m - j) + sumH(j) <= m * avg. The table is split
+// into sections that are filled in parallel, each starting from the state computed for its first entry.
+//
+// Computing the residual weights from prefix sums in double precision also avoids accumulating numerical errors
+// along the sweep. Any remaining inaccuracy only affects the thresholds, never the validity of the table.
+void AliasTable::build()
+{
+    const uint32_t blockCount = div_round_up(mCount, kBlockSize);
+
+    // Sum element weights, use double to minimize precision issues
+    std::vector<double> blockSums(blockCount, 0.0);
+    forEachBlock(
+        mCount,
+        [&](uint32_t block, uint32_t begin, uint32_t end)
+        {
+            double sum = 0.0;
+            for (uint32_t i = begin; i < end; ++i)
+                sum += mWeights[i];
+            blockSums[block] = sum;
+        }
+    );
+    mWeightSum = std::accumulate(blockSums.begin(), blockSums.end(), 0.0);
+
+    mItems.resize(mCount);
 
-    // Initialize working set. Inset inputs into our lists of above-average or below-average weight elements.
-    int lowCount = 0;
-    int highCount = 0;
-    for (uint32_t i = 0; i < mCount; ++i)
+    // If all weights are zero, fall back to uniform sampling.
+    if (mWeightSum <= 0.0)
     {
-        if (weights[i] < avgWeight)
-            lowIdx[lowCount++] = i;
-        else
-            highIdx[highCount++] = i;
+        forEachBlock(
+            mCount,
+            [&](uint32_t block, uint32_t begin, uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; ++i)
+                    mItems[i] = {1.f, i, i, 0};
+            }
+        );
+        return;
     }
 
-    // Create alias table entries by merging above- and below-average samples
-    std::vector<AliasTable::Item> items(mCount);
-    for (uint32_t i = 0; i < mCount; ++i)
-    {
-        // Usual case:  We have an above-average and below-average sample we can combine into one alias table entry
-        if ((lowIdx[i] != 0xFFFFFFFFu) && (highIdx[i] != 0xFFFFFFFFu))
-        {
-            // Create an alias table tuple:
-            items[i] = {weights[lowIdx[i]] / avgWeight, highIdx[i], lowIdx[i], 0};
-
-            // We've removed some weight from element highIdx[i]; update it's weight, then re-enter it
-            // on the end of either the above-average or below-average lists.
-            float updatedWeight = (weights[lowIdx[i]] + weights[highIdx[i]]) - avgWeight;
-            weights[highIdx[i]] = updatedWeight;
-            if (updatedWeight < avgWeight)
-                lowIdx[lowCount++] = highIdx[i];
-            else
-                highIdx[highCount++] = highIdx[i];
-        }
+    // Find the average weight
+    const double avgWeight = mWeightSum / double(mCount);
 
-        // The next two cases can only occur towards the end of table creation, because either:
-        //    (a) all the remaining possible alias table entries have weight *exactly* equal to avgWeight,
-        //        which means these alias table entries only have one input item that is selected
-        //        with 100% probability
-        //    (b) all the remaining alias table entires have *almost* avgWeight, but due to (compounding)
-        //        precision issues throughout the process, they don't have *quite* that value.  In this case
-        //        treating these entries as having exactly avgWeight (as in case (a)) is the only right
-        //        thing to do mathematically (other than re-generating the alias table using higher precision
-        //        or trying to reduce catasrophic numerical cancellation in the "updatedWeight" computation above).
-        else if (highIdx[i] != 0xFFFFFFFFu)
+    // Partition the items into lists of below-average (light) and above-average (heavy) weight items.
+    // Count the light items per block, then scatter the items to preserve their order.
+    std::vector<uint32_t> blockLightOffsets(blockCount + 1, 0);
+    forEachBlock(
+        mCount,
+        [&](uint32_t block, uint32_t begin, uint32_t end)
         {
-            items[i] = {1.0f, highIdx[i], highIdx[i], 0};
+            uint32_t lightCount = 0;
+            for (uint32_t i = begin; i < end; ++i)
+                lightCount += mWeights[i] < avgWeight ? 1 : 0;
+            blockLightOffsets[block + 1] = lightCount;
         }
-        else if (lowIdx[i] != 0xFFFFFFFFu)
+    );
+    std::partial_sum(blockLightOffsets.begin(), blockLightOffsets.end(), blockLightOffsets.begin());
+
+    const uint32_t lightCount = blockLightOffsets.back();
+    const uint32_t heavyCount = mCount - lightCount;
+    std::vector<uint32_t> lightIdx(lightCount);
+    std::vector<uint32_t> heavyIdx(heavyCount);
+    forEachBlock(
+        mCount,
+        [&](uint32_t block, uint32_t begin, uint32_t end)
         {
-            items[i] = {1.0f, lowIdx[i], lowIdx[i], 0};
+            uint32_t light = blockLightOffsets[block];
+            uint32_t heavy = begin - light;
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                if (mWeights[i] < avgWeight)
+                    lightIdx[light++] = i;
+                else
+                    heavyIdx[heavy++] = i;
+            }
         }
+    );
 
-        // If there is neither a highIdx[i] or lowIdx[i] for some array element(s).  By construction,
-        // this cannot occur (without some logic bug above).
-        else
+    const std::vector<double> sumL = computePrefixSums(lightIdx, mWeights);
+    const std::vector<double> sumH = computePrefixSums(heavyIdx, mWeights);
+
+    // Find the number of heavy items that got their entries before the start of each section.
+    // The search range is restricted so that the number of light and heavy items per section is never negative.
+    std::vector<uint32_t> sectionHeavy(blockCount + 1, 0);
+    for (uint32_t section = 1; section <= blockCount; ++section)
+    {
+        const uint32_t m = std::min(mCount, section * kBlockSize);
+        const uint32_t prevM = (section - 1) * kBlockSize;
+        const uint32_t prevJ = sectionHeavy[section - 1];
+        const double target = m * avgWeight;
+
+        uint32_t lo = std::max(prevJ, m > lightCount ? m - lightCount : 0u);
+        uint32_t hi = std::min(prevJ + (m - prevM), heavyCount);
+        FALCOR_ASSERT(lo <= hi);
+
+        // Binary search for the largest j in [lo, hi] with sumL(m - j) + sumH(j) <= m * avg. The sum is non-decreasing in j.
+        while (lo < hi)
         {
-            FALCOR_ASSERT(false); // Should not occur
+            uint32_t j = lo + (hi - lo + 1) / 2;
+            if (sumL[m - j] + sumH[j] <= target)
+                lo = j;
+            else
+                hi = j - 1;
         }
+        sectionHeavy[section] = lo;
     }
 
-    // TODO: We can simplify the alias table to implicitly store indexB (aka lowIdx[i]), so the AliasTable::Item
-    // structure would be 1 float + 1 uint32_t, rather than 128 bits.  This, of course, would change usage in shaders
-    // and elsewhere.  To do this, here you'd need to sort elements by indexB so that when looking up mpItems[j],
-    // indexB==j.  This works since, by construction, only one element in the table has indexB==j (for any j
-    // in [0...mCount-1]).  Alternatively, during the loop above, you could directly enter elements into the
-    // correct location in the alias table.
+    // Create alias table entries by sweeping over each section in parallel.
+    auto toThreshold = [&](double weight) { return (float)std::clamp(weight / avgWeight, 0.0, 1.0); };
+    forEachBlock(
+        mCount,
+        [&](uint32_t section, uint32_t begin, uint32_t end)
+        {
+            uint32_t j = sectionHeavy[section];
+            uint32_t i = begin - j;
+            const uint32_t endJ = sectionHeavy[section + 1];
+            const uint32_t endI = end - endJ;
+
+            for (uint32_t m = begin; m < end; ++m)
+            {
+                FALCOR_ASSERT(m == i + j);
+
+                // Residual weight of the current heavy item.
+                double residual = j < heavyCount ? sumL[i] + sumH[j + 1] - double(m) * avgWeight : 0.0;
 
-    // Stash the alias table in our GPU buffer
+                if (j < endJ && (i == endI || residual < avgWeight))
+                {
+                    // The current heavy item dropped below average. Fill its entry from the next heavy item.
+                    // The last heavy item can only be left with (almost) exactly average weight, so it gets an entry on its own.
+                    uint32_t h = heavyIdx[j];
+                    mItems[m] = j + 1 < heavyCount ? Item{toThreshold(residual), heavyIdx[j + 1], h, 0} : Item{1.f, h, h, 0};
+                    j++;
+                }
+                else
+                {
+                    // Fill the entry of the next light item from the current heavy item. If there are no heavy items left,
+                    // all remaining light items have (almost) exactly average weight due to numerical precision.
+                    uint32_t l = lightIdx[i];
+                    mItems[m] = j < heavyCount ? Item{toThreshold(mWeights[l]), heavyIdx[j], l, 0} : Item{1.f, l, l, 0};
+                    i++;
+                }
+            }
+            FALCOR_ASSERT(i == endI && j == endJ);
+        }
+    );
+}
+
+void AliasTable::createBuffers(ref<Device> pDevice)
+{
+    mpWeights =
+        pDevice->createStructuredBuffer(sizeof(float), mCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, mWeights.data());
     mpItems = pDevice->createStructuredBuffer(
-        sizeof(AliasTable::Item), mCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, items.data()
+        sizeof(AliasTable::Item), mCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, mItems.data()
     );
 }
 
 void AliasTable::bindShaderData(const ShaderVar& var) const
 {
+    FALCOR_CHECK(mpItems && mpWeights, "Alias table buffers have not been created. Call createBuffers() first.");
+
     var["items"] = mpItems;
     var["weights"] = mpWeights;
     var["count"] = mCount;
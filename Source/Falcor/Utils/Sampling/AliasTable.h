@@ -29,25 +29,50 @@
 #include "Core/Macros.h"
 #include "Core/API/Buffer.h"
 #include "Core/Program/ShaderVar.h"
+#include "Utils/Math/Vector.h"
+#include <algorithm>
 #include <memory>
-#include <random>
+#include <vector>
 
 namespace Falcor
 {
 /**
  * Implements the alias method for sampling from a discrete probability distribution.
+ *
+ * The table is built on the CPU in parallel and can be used for sampling on the CPU.
+ * The GPU buffers used by AliasTable.slang are created separately by createBuffers().
  */
 class FALCOR_API AliasTable
 {
 public:
+    // Item structure for the table. Matches AliasTable::Item in AliasTable.slang.
+    struct Item
+    {
+        float threshold; ///< If rand() < threshold, pick indexB (else pick indexA)
+        uint32_t indexA; ///< The "redirect" index, if uniform sampling would overweight indexB.
+        uint32_t indexB; ///< The original / permutation index. Each index appears as indexB in exactly one item.
+        uint32_t _pad;
+    };
+
     /**
-     * Create an alias table.
+     * Create an alias table on the CPU.
      * The weights don't need to be normalized to sum up to 1.
-     * @param[in] pDevice GPU device.
      * @param[in] weights The weights we'd like to sample each entry proportional to.
-     * @param[in] rng The random number generator to use when creating the table.
      */
-    AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt19937& rng);
+    explicit AliasTable(std::vector<float> weights);
+
+    /**
+     * Create an alias table from previously built items, e.g., loaded from a cache.
+     * @param[in] weights The weights the table was built from.
+     * @param[in] items The items returned by getItems() of the original table.
+     */
+    AliasTable(std::vector<float> weights, std::vector<Item> items);
+
+    /**
+     * Create the GPU buffers holding the table. Must be called before bindShaderData().
+     * @param[in] pDevice GPU device.
+     */
+    void createBuffers(ref<Device> pDevice);
 
     /**
      * Bind the alias table data to a given shader var.
@@ -65,19 +90,50 @@ public:
      */
     double getWeightSum() const { return mWeightSum; }
 
-private:
-    // Item structure for the mpItems buffer.
-    struct Item
+    /**
+     * Get the table items.
+     */
+    const std::vector<Item>& getItems() const { return mItems; }
+
+    /**
+     * Get the original weight at a given index.
+     */
+    float getWeight(uint32_t index) const { return mWeights[index]; }
+
+    /**
+     * Sample from the table proportional to the weights. Matches AliasTable::sample() in AliasTable.slang.
+     * @param[in] index Uniform random index in [0..count).
+     * @param[in] rnd Uniform random number in [0..1).
+     * @return Returns the sampled item index.
+     */
+    uint32_t sample(uint32_t index, float rnd) const
     {
-        float threshold; ///< If rand() < threshold, pick indexB (else pick indexA)
-        uint32_t indexA; ///< The "redirect" index, if uniform sampling would overweight indexB.
-        uint32_t indexB; ///< The original / permutation index, sampled uniformly in [0...mCount-1]
-        uint32_t _pad;
-    };
+        const Item& item = mItems[index];
+        return rnd >= item.threshold ? item.indexA : item.indexB;
+    }
+
+    /**
+     * Sample from the table proportional to the weights. Matches AliasTable::sample() in AliasTable.slang.
+     * @param[in] rnd Two uniform random number in [0..1).
+     * @return Returns the sampled item index.
+     */
+    uint32_t sample(float2 rnd) const { return sample(std::min(mCount - 1, (uint32_t)(rnd.x * mCount)), rnd.y); }
+
+    /**
+     * Evaluate the probability of sampling a given index.
+     * @param[in] index Table index.
+     * @return Returns the probability weight / weightSum.
+     */
+    double evalPdf(uint32_t index) const { return mWeights[index] / mWeightSum; }
+
+private:
+    void build();
 
-    uint32_t mCount;       ///< Number of items in the alias table.
-    double mWeightSum;     ///< Total weight of all elements used to create the alias table.
-    ref<Buffer> mpItems;   ///< Buffer containing table items.
-    ref<Buffer> mpWeights; ///< Buffer containing item weights.
+    uint32_t mCount;             ///< Number of items in the alias table.
+    double mWeightSum;           ///< Total weight of all elements used to create the alias table.
+    std::vector<float> mWeights; ///< Item weights.
+    std::vector<Item> mItems;    ///< Table items.
+    ref<Buffer> mpItems;         ///< Buffer containing table items.
+    ref<Buffer> mpWeights;       ///< Buffer containing item weights.
 };
 } // namespace Falcor
@@ -26,34 +26,321 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "TaskManager.h"
+#include "Core/Error.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <memory>
+#include <queue>
+#include <thread>
 
 namespace Falcor
 {
+namespace
+{
+thread_local bool tIsWorkerThread = false;
 
-TaskManager::TaskManager(bool startPaused)
+uint32_t getDefaultThreadCount()
 {
-    if (startPaused)
-        mThreadPool.pause();
+    uint32_t logicalThreadCount = std::thread::hardware_concurrency();
+    return logicalThreadCount > 1 ? logicalThreadCount - 1 : 1;
 }
 
-void TaskManager::addTask(CpuTask&& task)
+/// State of a parallel loop shared between the calling thread and the helper tasks.
+/// Helper tasks may start after the loop has finished, so they only touch the shared state.
+struct ParallelLoop
+{
+    const ThreadPool::ChunkFunc* pFunc = nullptr;
+    size_t chunkCount = 0;
+    std::atomic<size_t> nextChunk{0};
+    std::atomic<size_t> finishedChunks{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr exception;
+
+    void work()
+    {
+        size_t chunk;
+        while ((chunk = nextChunk.fetch_add(1, std::memory_order_relaxed)) < chunkCount)
+        {
+            try
+            {
+                (*pFunc)(chunk);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!exception)
+                    exception = std::current_exception();
+            }
+
+            if (finishedChunks.fetch_add(1, std::memory_order_acq_rel) + 1 == chunkCount)
+            {
+                // Lock to not lose the wakeup between the waiter's check and wait.
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+};
+
+/// State of a task graph execution shared between the calling thread and the helper tasks.
+struct TaskGraphExecution
+{
+    std::vector<std::function<void()>*> funcs;
+    std::vector<const char*> names;
+    std::vector<uint32_t> dependentOffsets; ///< Offset of each task's dependents in dependents, followed by the total count.
+    std::vector<uint32_t> dependents;
+    std::vector<uint32_t> pendingDependencies;
+    std::vector<bool> skipped; ///< True for tasks depending on a failed task.
+    std::queue<uint32_t> readyTasks;
+    size_t finishedTasks = 0;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::exception_ptr exception;
+
+    /// Pop a ready task, returns false if there is none.
+    bool pop(uint32_t& taskID)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (readyTasks.empty())
+            return false;
+        taskID = readyTasks.front();
+        readyTasks.pop();
+        return true;
+    }
+
+    void execute(const std::shared_ptr<TaskGraphExecution>& self, uint32_t taskID)
+    {
+        auto& pool = ThreadPool::get();
+        bool observe = pool.hasTaskObserver();
+        auto start = observe ? CpuTimer::getCurrentTimePoint() : CpuTimer::TimePoint();
+        bool failed = false;
+        try
+        {
+            (*funcs[taskID])();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!exception)
+                exception = std::current_exception();
+            failed = true;
+        }
+        if (observe)
+            pool.notifyTaskFinished(names[taskID], CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()));
+
+        // Release the dependents. Tasks depending on a failed task are skipped, but still counted as finished.
+        size_t releasedCount = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<uint32_t> stack = {taskID};
+            while (!stack.empty())
+            {
+                uint32_t id = stack.back();
+                stack.pop_back();
+                bool skipDependents = failed || skipped[id];
+                finishedTasks++;
+                for (uint32_t i = dependentOffsets[id]; i < dependentOffsets[id + 1]; i++)
+                {
+                    uint32_t dependent = dependents[i];
+                    if (skipDependents)
+                        skipped[dependent] = true;
+                    if (--pendingDependencies[dependent] != 0)
+                        continue;
+                    if (skipped[dependent])
+                    {
+                        stack.push_back(dependent);
+                    }
+                    else
+                    {
+                        readyTasks.push(dependent);
+                        releasedCount++;
+                    }
+                }
+            }
+        }
+        changed.notify_all();
+
+        // The calling thread picks up one of the released tasks, the others are handed to the pool.
+        for (size_t i = 1; i < releasedCount; i++)
+            pool.submit([self]() { self->help(self); });
+    }
+
+    void help(const std::shared_ptr<TaskGraphExecution>& self)
+    {
+        uint32_t taskID;
+        while (pop(taskID))
+            execute(self, taskID);
+    }
+};
+} // namespace
+
+ThreadPool& ThreadPool::get()
+{
+    static ThreadPool sThreadPool;
+    return sThreadPool;
+}
+
+ThreadPool::ThreadPool() : mThreadPool(getDefaultThreadCount()) {}
+
+void ThreadPool::setThreadCount(uint32_t threadCount)
+{
+    FALCOR_CHECK(!isWorkerThread(), "Cannot change the thread count from a worker thread.");
+    mThreadPool.reset(threadCount > 0 ? threadCount : getDefaultThreadCount());
+}
+
+uint32_t ThreadPool::getThreadCount() const
+{
+    return mThreadPool.get_thread_count();
+}
+
+bool ThreadPool::isWorkerThread()
+{
+    return tIsWorkerThread;
+}
+
+void ThreadPool::setTaskObserver(TaskObserver observer)
+{
+    std::lock_guard<std::mutex> lock(mObserverMutex);
+    mHasTaskObserver = bool(observer);
+    mTaskObserver = std::move(observer);
+}
+
+void ThreadPool::notifyTaskFinished(const char* name, double durationMs)
+{
+    if (!name || !hasTaskObserver())
+        return;
+    std::lock_guard<std::mutex> lock(mObserverMutex);
+    if (mTaskObserver)
+        mTaskObserver(name, durationMs);
+}
+
+void ThreadPool::submit(std::function<void()> task)
 {
-    std::lock_guard<std::mutex> l(mTaskMutex);
-    ++mCurrentlyScheduled;
     mThreadPool.push_task(
-        [task = std::move(task), this]() mutable
+        [task = std::move(task)]()
         {
-            ++mCurrentlyRunning;
-            --mCurrentlyScheduled;
-            executeCpuTask(std::move(task));
-            size_t running = --mCurrentlyRunning;
-            // If nothing is running, lets wake up and try to exit.
-            if (running == 0)
-                mGpuTaskCond.notify_all();
+            bool wasWorkerThread = tIsWorkerThread;
+            tIsWorkerThread = true;
+            task();
+            tIsWorkerThread = wasWorkerThread;
         }
     );
 }
 
+void ThreadPool::run(size_t chunkCount, const ChunkFunc& func, const char* name)
+{
+    if (chunkCount == 0)
+        return;
+
+    bool observe = name && hasTaskObserver();
+    auto start = observe ? CpuTimer::getCurrentTimePoint() : CpuTimer::TimePoint();
+
+    auto pLoop = std::make_shared<ParallelLoop>();
+    pLoop->pFunc = &func;
+    pLoop->chunkCount = chunkCount;
+
+    // Wake up at most one helper per chunk, the calling thread takes the first chunk.
+    size_t helperCount = std::min<size_t>(getThreadCount(), chunkCount - 1);
+    for (size_t i = 0; i < helperCount; i++)
+        submit([pLoop]() { pLoop->work(); });
+    pLoop->work();
+
+    // Wait for the chunks claimed by other threads. These are already running, so this cannot deadlock when nested.
+    {
+        std::unique_lock<std::mutex> lock(pLoop->mutex);
+        pLoop->finished.wait(lock, [&]() { return pLoop->finishedChunks.load(std::memory_order_acquire) == chunkCount; });
+    }
+
+    if (observe)
+        notifyTaskFinished(name, CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()));
+    if (pLoop->exception)
+        std::rethrow_exception(pLoop->exception);
+}
+
+TaskGraph::TaskID TaskGraph::addTask(std::string name, std::function<void()> func, const std::vector<TaskID>& dependencies)
+{
+    TaskID taskID = (TaskID)mTasks.size();
+    for (TaskID dependency : dependencies)
+        FALCOR_CHECK(dependency < taskID, "Task '{}' depends on unknown task {}.", name, dependency);
+    mTasks.push_back({std::move(name), std::move(func), dependencies});
+    return taskID;
+}
+
+void TaskGraph::run()
+{
+    if (mTasks.empty())
+        return;
+
+    const size_t taskCount = mTasks.size();
+    auto pExecution = std::make_shared<TaskGraphExecution>();
+    auto& execution = *pExecution;
+    execution.funcs.resize(taskCount);
+    execution.names.resize(taskCount);
+    execution.pendingDependencies.resize(taskCount);
+    execution.skipped.assign(taskCount, false);
+    execution.dependentOffsets.assign(taskCount + 1, 0);
+    for (size_t i = 0; i < taskCount; i++)
+    {
+        execution.funcs[i] = &mTasks[i].func;
+        execution.names[i] = mTasks[i].name.c_str();
+        execution.pendingDependencies[i] = (uint32_t)mTasks[i].dependencies.size();
+        for (TaskID dependency : mTasks[i].dependencies)
+            execution.dependentOffsets[dependency + 1]++;
+    }
+    for (size_t i = 0; i < taskCount; i++)
+        execution.dependentOffsets[i + 1] += execution.dependentOffsets[i];
+    execution.dependents.resize(execution.dependentOffsets.back());
+    std::vector<uint32_t> cursors(execution.dependentOffsets.begin(), execution.dependentOffsets.end() - 1);
+    for (size_t i = 0; i < taskCount; i++)
+    {
+        for (TaskID dependency : mTasks[i].dependencies)
+            execution.dependents[cursors[dependency]++] = (uint32_t)i;
+    }
+
+    size_t readyCount = 0;
+    for (uint32_t i = 0; i < (uint32_t)taskCount; i++)
+    {
+        if (execution.pendingDependencies[i] == 0)
+        {
+            execution.readyTasks.push(i);
+            readyCount++;
+        }
+    }
+    for (size_t i = 1; i < readyCount; i++)
+        ThreadPool::get().submit([pExecution]() { pExecution->help(pExecution); });
+
+    // Execute ready tasks on the calling thread until all tasks are done.
+    std::unique_lock<std::mutex> lock(execution.mutex);
+    while (execution.finishedTasks < taskCount)
+    {
+        if (execution.readyTasks.empty())
+        {
+            execution.changed.wait(lock);
+            continue;
+        }
+        uint32_t taskID = execution.readyTasks.front();
+        execution.readyTasks.pop();
+        lock.unlock();
+        execution.execute(pExecution, taskID);
+        lock.lock();
+    }
+
+    if (execution.exception)
+        std::rethrow_exception(execution.exception);
+}
+
+TaskManager::TaskManager(bool startPaused) : mPaused(startPaused) {}
+
+void TaskManager::addTask(CpuTask&& task)
+{
+    std::lock_guard<std::mutex> l(mTaskMutex);
+    ++mCurrentlyScheduled;
+    if (mPaused)
+        mPausedCpuTasks.push_back(std::move(task));
+    else
+        submitCpuTask(std::move(task));
+}
+
 void TaskManager::addTask(GpuTask&& task)
 {
     std::lock_guard<std::mutex> l(mTaskMutex);
@@ -64,7 +351,14 @@ void TaskManager::addTask(GpuTask&& task)
 
 void TaskManager::finish(RenderContext* renderContext)
 {
-    mThreadPool.unpause();
+    {
+        std::lock_guard<std::mutex> l(mTaskMutex);
+        mPaused = false;
+        for (auto& task : mPausedCpuTasks)
+            submitCpuTask(std::move(task));
+        mPausedCpuTasks.clear();
+    }
+
     while (true)
     {
         while (true)
@@ -100,6 +394,22 @@ void TaskManager::finish(RenderContext* renderContext)
     rethrowException();
 }
 
+void TaskManager::submitCpuTask(CpuTask&& task)
+{
+    ThreadPool::get().submit(
+        [task = std::move(task), this]() mutable
+        {
+            ++mCurrentlyRunning;
+            --mCurrentlyScheduled;
+            executeCpuTask(std::move(task));
+            size_t running = --mCurrentlyRunning;
+            // If nothing is running, lets wake up and try to exit.
+            if (running == 0)
+                mGpuTaskCond.notify_all();
+        }
+    );
+}
+
 void TaskManager::storeException()
 {
     std::lock_guard<std::mutex> l(mExceptionMutex);
@@ -31,9 +31,12 @@
 
 #include <BS_thread_pool/BS_thread_pool.hpp>
 
+#include <algorithm>
 #include <functional>
+#include <iterator>
 #include <mutex>
 #include <condition_variable>
+#include <string>
 #include <vector>
 #include <atomic>
 #include <exception>
@@ -41,6 +44,306 @@
 namespace Falcor
 {
 class RenderContext;
+
+/**
+ * Process-wide CPU thread pool.
+ *
+ * All CPU parallelism in the engine (parallelFor, parallelReduce, TaskGraph and TaskManager)
+ * runs on this single pool, so that independent systems do not oversubscribe the CPU.
+ * Parallel loops split their work into chunks that are claimed dynamically by the pool workers
+ * and the calling thread. The calling thread always takes part, so parallel loops can be nested
+ * (e.g. called from within a task) without deadlocking. Tasks that block for long periods
+ * (e.g. on file I/O) should use Threading::dispatchTask instead.
+ */
+class FALCOR_API ThreadPool
+{
+public:
+    /// Function called after each named task or parallel loop with its name and duration in ms.
+    using TaskObserver = std::function<void(const char* name, double durationMs)>;
+    /// Function executing the chunk with the given index.
+    using ChunkFunc = std::function<void(size_t chunk)>;
+
+    /// Get the process-wide thread pool.
+    static ThreadPool& get();
+
+    /**
+     * Set the number of worker threads. Waits for all queued tasks to finish first.
+     * @param[in] threadCount Number of worker threads, or 0 to use one less than the number of logical cores
+     * (the thread issuing parallel work takes part in it).
+     */
+    void setThreadCount(uint32_t threadCount);
+
+    /// Get the number of worker threads.
+    uint32_t getThreadCount() const;
+
+    /// Returns true if the calling thread is one of the pool's worker threads.
+    static bool isWorkerThread();
+
+    /// Set the function called after each named task or parallel loop. Pass an empty function to disable.
+    void setTaskObserver(TaskObserver observer);
+
+    /// Queue a task for asynchronous execution on a worker thread.
+    void submit(std::function<void()> task);
+
+    /**
+     * Execute func(chunk) for chunk = 0..chunkCount-1 on the worker threads and the calling thread.
+     * Blocks until all chunks are done. If a chunk throws, the first exception is rethrown once all chunks are done.
+     * @param[in] chunkCount Number of chunks.
+     * @param[in] func Function executing a chunk.
+     * @param[in] name Optional name reported to the task observer.
+     */
+    void run(size_t chunkCount, const ChunkFunc& func, const char* name = nullptr);
+
+    /// Report a finished task to the task observer, if any.
+    void notifyTaskFinished(const char* name, double durationMs);
+
+    /// Returns true if a task observer is set.
+    bool hasTaskObserver() const { return mHasTaskObserver.load(std::memory_order_relaxed); }
+
+private:
+    ThreadPool();
+
+    BS::thread_pool mThreadPool;
+    std::mutex mObserverMutex;
+    TaskObserver mTaskObserver;
+    std::atomic<bool> mHasTaskObserver{false};
+};
+
+namespace detail
+{
+/// Pick a grain size giving a few chunks per thread to balance the load.
+inline size_t getDefaultGrainSize(size_t count)
+{
+    const size_t chunkCount = 4 * (size_t(ThreadPool::get().getThreadCount()) + 1);
+    return std::max<size_t>(count / chunkCount, 1);
+}
+} // namespace detail
+
+/**
+ * Call func(first, end) on consecutive index ranges covering [begin, end) in parallel.
+ * @param[in] begin First index.
+ * @param[in] end One past the last index.
+ * @param[in] func Function processing the indices [first, end).
+ * @param[in] grainSize Maximum number of indices per range, or 0 to pick it based on the thread count.
+ * Loops with at most this many indices run on the calling thread.
+ * @param[in] name Optional name reported to the task observer.
+ */
+template<typename F>
+void parallelForRange(size_t begin, size_t end, F&& func, size_t grainSize = 0, const char* name = nullptr)
+{
+    if (begin >= end)
+        return;
+    const size_t count = end - begin;
+    if (grainSize == 0)
+        grainSize = detail::getDefaultGrainSize(count);
+    if (count <= grainSize && !name)
+    {
+        func(begin, end);
+        return;
+    }
+
+    const size_t chunkCount = (count + grainSize - 1) / grainSize;
+    ThreadPool::get().run(
+        chunkCount,
+        [&](size_t chunk)
+        {
+            size_t first = begin + chunk * grainSize;
+            func(first, std::min(first + grainSize, end));
+        },
+        name
+    );
+}
+
+/**
+ * Call func(i) for every index in [begin, end) in parallel.
+ * @param[in] begin First index.
+ * @param[in] end One past the last index.
+ * @param[in] func Function processing an index.
+ * @param[in] grainSize Number of indices processed per chunk, or 0 to pick it based on the thread count.
+ * @param[in] name Optional name reported to the task observer.
+ */
+template<typename F>
+void parallelFor(size_t begin, size_t end, F&& func, size_t grainSize = 0, const char* name = nullptr)
+{
+    parallelForRange(
+        begin,
+        end,
+        [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; i++)
+                func(i);
+        },
+        grainSize,
+        name
+    );
+}
+
+/**
+ * Reduce the index range [begin, end) in parallel.
+ * Each range of grainSize indices is mapped to a value with map(first, end), and the values are combined
+ * in index order with combine(a, b), so the result is deterministic for a fixed grain size.
+ * @param[in] begin First index.
+ * @param[in] end One past the last index.
+ * @param[in] identity Result for an empty range.
+ * @param[in] map Function returning the value of the indices [first, end).
+ * @param[in] combine Function combining two values.
+ * @param[in] grainSize Maximum number of indices per range.
+ * @return The reduced value.
+ */
+template<typename T, typename Map, typename Combine>
+T parallelReduce(size_t begin, size_t end, T identity, Map&& map, Combine&& combine, size_t grainSize)
+{
+    if (begin >= end)
+        return identity;
+    grainSize = std::max<size_t>(grainSize, 1);
+    const size_t chunkCount = (end - begin + grainSize - 1) / grainSize;
+    std::vector<T> partials(chunkCount, identity);
+    parallelForRange(
+        begin, end, [&](size_t first, size_t last) { partials[(first - begin) / grainSize] = map(first, last); }, grainSize
+    );
+
+    T result = identity;
+    for (const T& partial : partials)
+        result = combine(result, partial);
+    return result;
+}
+
+/**
+ * Compute the exclusive prefix sum of [first, last) in parallel, as std::exclusive_scan(first, last, out, init).
+ * The input is summed in blocks, the block sums are scanned on the calling thread, and the blocks are then scanned
+ * in parallel starting from their offsets. The result equals the serial scan for associative additions (e.g. integers).
+ * @param[in] first Begin of the input.
+ * @param[in] last End of the input.
+ * @param[out] out Begin of the output. May be equal to first.
+ * @param[in] init Initial value.
+ * @return The sum of init and all input values.
+ */
+template<typename InputIt, typename OutputIt, typename T>
+T parallelExclusiveScan(InputIt first, InputIt last, OutputIt out, T init)
+{
+    const size_t count = size_t(std::distance(first, last));
+    if (count == 0)
+        return init;
+    const size_t grainSize = std::max<size_t>(detail::getDefaultGrainSize(count), 4096);
+    const size_t blockCount = (count + grainSize - 1) / grainSize;
+    std::vector<T> offsets(blockCount + 1);
+    offsets[0] = init;
+    parallelForRange(
+        0,
+        count,
+        [&](size_t begin, size_t end)
+        {
+            T sum = T();
+            for (size_t i = begin; i < end; i++)
+                sum = sum + T(first[i]);
+            offsets[begin / grainSize + 1] = sum;
+        },
+        grainSize
+    );
+    for (size_t i = 0; i < blockCount; i++)
+        offsets[i + 1] = offsets[i] + offsets[i + 1];
+    parallelForRange(
+        0,
+        count,
+        [&](size_t begin, size_t end)
+        {
+            T sum = offsets[begin / grainSize];
+            for (size_t i = begin; i < end; i++)
+            {
+                T value = T(first[i]);
+                out[i] = sum;
+                sum = sum + value;
+            }
+        },
+        grainSize
+    );
+    return offsets[blockCount];
+}
+
+/**
+ * Sort [first, last) in parallel with the comparison comp.
+ * Blocks are sorted in parallel and then merged pairwise in parallel. Like std::sort, the order of equal elements
+ * is unspecified, but it only depends on the input and the thread count.
+ * @param[in] first Begin of the range, a random access iterator.
+ * @param[in] last End of the range.
+ * @param[in] comp Comparison function returning true if the first argument is ordered before the second.
+ */
+template<typename RandomIt, typename Compare>
+void parallelSort(RandomIt first, RandomIt last, Compare comp)
+{
+    const size_t count = size_t(last - first);
+    const size_t grainSize = std::max<size_t>(detail::getDefaultGrainSize(count), 4096);
+    if (count <= grainSize)
+    {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    parallelForRange(0, count, [&](size_t begin, size_t end) { std::sort(first + begin, first + end, comp); }, grainSize);
+    for (size_t width = grainSize; width < count; width *= 2)
+    {
+        const size_t pairCount = (count + 2 * width - 1) / (2 * width);
+        parallelFor(
+            0,
+            pairCount,
+            [&](size_t pair)
+            {
+                size_t begin = pair * 2 * width;
+                size_t middle = std::min(begin + width, count);
+                size_t end = std::min(begin + 2 * width, count);
+                if (middle < end)
+                    std::inplace_merge(first + begin, first + middle, first + end, comp);
+            },
+            1
+        );
+    }
+}
+
+/// Sort [first, last) in parallel in ascending order. See parallelSort(first, last, comp).
+template<typename RandomIt>
+void parallelSort(RandomIt first, RandomIt last)
+{
+    parallelSort(first, last, std::less<>());
+}
+
+/**
+ * Graph of CPU tasks with dependencies, executed on the process-wide thread pool.
+ * A task starts once all its dependencies have finished. The graph can be run any number of times.
+ */
+class FALCOR_API TaskGraph
+{
+public:
+    using TaskID = uint32_t;
+
+    /**
+     * Add a task to the graph.
+     * @param[in] name Name of the task, reported to the task observer.
+     * @param[in] func Function executing the task.
+     * @param[in] dependencies IDs of the tasks that have to finish before this task starts. These must have been added before.
+     * @return ID of the new task.
+     */
+    TaskID addTask(std::string name, std::function<void()> func, const std::vector<TaskID>& dependencies = {});
+
+    /// Get the number of tasks.
+    size_t getTaskCount() const { return mTasks.size(); }
+
+    /**
+     * Execute all tasks and wait for them to finish. The calling thread executes tasks as well.
+     * If tasks throw, the first exception is rethrown once all tasks that could run are done.
+     */
+    void run();
+
+private:
+    struct Task
+    {
+        std::string name;
+        std::function<void()> func;
+        std::vector<TaskID> dependencies;
+    };
+
+    std::vector<Task> mTasks;
+};
+
 class FALCOR_API TaskManager
 {
 public:
@@ -68,8 +371,12 @@ private:
     /// CPU task execution wrapped so it stores exception if the task throws
     void executeCpuTask(CpuTask&& task);
 
+    /// Submit a CPU task to the process-wide thread pool.
+    void submitCpuTask(CpuTask&& task);
+
 private:
-    BS::thread_pool mThreadPool;
+    bool mPaused = false;
+    std::vector<CpuTask> mPausedCpuTasks; ///< CPU tasks added while paused, submitted when finishing.
     std::atomic_size_t mCurrentlyRunning{0};
     std::atomic_size_t mCurrentlyScheduled{0};
 
@@ -27,16 +27,28 @@
  **************************************************************************/
 #include "Threading.h"
 #include "Core/Error.h"
+#include "Utils/Logger.h"
+
+#include <BS_thread_pool/BS_thread_pool.hpp>
 
 namespace Falcor
 {
+struct Threading::Task::State
+{
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool running = true;
+};
+
 namespace
 {
 struct ThreadingData
 {
     bool initialized = false;
-    std::vector<std::thread> threads;
-    uint32_t current;
+    std::unique_ptr<BS::thread_pool> pThreadPool;
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t runningTasks = 0;
 } gData; // TODO: REMOVEGLOBAL
 } // namespace
 
@@ -48,7 +60,7 @@ void Threading::start(uint32_t threadCount)
     std::lock_guard<std::mutex> lock(sThreadingInitMutex);
     if (sThreadingInitCount++ == 0)
     {
-        gData.threads.resize(threadCount);
+        gData.pThreadPool = std::make_unique<BS::thread_pool>(threadCount);
         gData.initialized = true;
     }
 }
@@ -59,9 +71,8 @@ void Threading::shutdown()
     uint32_t count = sThreadingInitCount--;
     if (count == 1)
     {
-        for (auto& t : gData.threads)
-            if (t.joinable())
-                t.join();
+        finish();
+        gData.pThreadPool.reset();
         gData.initialized = false;
     }
     else if (count == 0)
@@ -72,33 +83,69 @@ Threading::Task Threading::dispatchTask(const std::function<void(void)>& func)
 {
     FALCOR_ASSERT(gData.initialized);
 
-    std::thread& t = gData.threads[gData.current];
-    if (t.joinable())
-        t.join();
-    t = std::thread(func);
-    gData.current = (gData.current + 1) % gData.threads.size();
+    auto pState = std::make_shared<Task::State>();
+    {
+        std::lock_guard<std::mutex> lock(gData.mutex);
+        gData.runningTasks++;
+    }
 
-    return Task();
+    gData.pThreadPool->push_task(
+        [func, pState]()
+        {
+            // Mark the task as finished even if it throws, so that waiting for it does not hang.
+            struct FinishGuard
+            {
+                Task::State& state;
+                ~FinishGuard()
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(state.mutex);
+                        state.running = false;
+                    }
+                    state.finished.notify_all();
+                    {
+                        std::lock_guard<std::mutex> lock(gData.mutex);
+                        gData.runningTasks--;
+                    }
+                    gData.finished.notify_all();
+                }
+            } guard{*pState};
+
+            try
+            {
+                func();
+            }
+            catch (const std::exception& e)
+            {
+                logError("Threading task failed: {}", e.what());
+            }
+            catch (...)
+            {
+                logError("Threading task failed with an unknown exception.");
+            }
+        }
+    );
+
+    return Task(pState);
 }
 
 void Threading::finish()
 {
-    for (auto& t : gData.threads)
-    {
-        if (t.joinable())
-            t.join();
-    }
+    std::unique_lock<std::mutex> lock(gData.mutex);
+    gData.finished.wait(lock, []() { return gData.runningTasks == 0; });
 }
 
-Threading::Task::Task() {}
+Threading::Task::Task(std::shared_ptr<State> pState) : mpState(std::move(pState)) {}
 
 bool Threading::Task::isRunning()
 {
-    FALCOR_UNIMPLEMENTED();
+    std::lock_guard<std::mutex> lock(mpState->mutex);
+    return mpState->running;
 }
 
 void Threading::Task::finish()
 {
-    FALCOR_UNIMPLEMENTED();
+    std::unique_lock<std::mutex> lock(mpState->mutex);
+    mpState->finished.wait(lock, [this]() { return !mpState->running; });
 }
 } // namespace Falcor
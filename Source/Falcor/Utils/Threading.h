@@ -29,6 +29,7 @@
 #include "Core/Macros.h"
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <cstdint>
@@ -42,10 +43,8 @@ public:
 
     /**
      * Handle to a dispatched task
-     *
-     * TODO: Implementation
      */
-    class Task
+    class FALCOR_API Task
     {
     public:
         ///  Check if task is still executing
@@ -55,12 +54,16 @@ public:
         void finish();
 
     private:
-        Task();
+        struct State;
+        Task(std::shared_ptr<State> pState);
+        std::shared_ptr<State> mpState;
         friend class Threading;
     };
 
     /**
-     * Initializes the global thread pool
+     * Initializes the global thread pool.
+     * The pool is meant for tasks that block, e.g. on file I/O. It is separate from the process-wide ThreadPool used for
+     * parallel computation (see Utils/TaskManager.h), so that blocked tasks do not hold up parallelFor() and friends.
      * @param[in] threadCount Number of threads in the pool
      */
     static void start(uint32_t threadCount = kDefaultThreadCount);
@@ -81,7 +84,7 @@ public:
     static uint32_t getLogicalThreadCount() { return std::thread::hardware_concurrency(); }
 
     /**
-     * Starts a task on an available thread.
+     * Starts a task on an available thread. Exceptions thrown by the task are logged.
      * @return Handle to the task
      */
     static Task dispatchTask(const std::function<void(void)>& func);
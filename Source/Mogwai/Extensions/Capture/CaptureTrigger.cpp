@@ -120,18 +120,21 @@ namespace Mogwai
 
     void CaptureTrigger::endFrame(RenderContext* pRenderContext, const ref<Fbo>& pTargetFbo)
     {
-        if (!mCurrent.pGraph) return;
-        uint64_t frameId = mpRenderer->getGlobalClock().getFrame();
-        const auto& ranges = mGraphRanges.at(mCurrent.pGraph);
+        if (mCurrent.pGraph)
+        {
+            uint64_t frameId = mpRenderer->getGlobalClock().getFrame();
 
-        triggerFrame(pRenderContext, mCurrent.pGraph, frameId);
+            triggerFrame(pRenderContext, mCurrent.pGraph, frameId);
 
-        uint64_t end = mCurrent.range.first + mCurrent.range.second;
-        if (frameId + 1 == end)
-        {
-            endRange(mCurrent.pGraph, mCurrent.range);
-            mCurrent = {};
+            uint64_t end = mCurrent.range.first + mCurrent.range.second;
+            if (frameId + 1 == end)
+            {
+                endRange(mCurrent.pGraph, mCurrent.range);
+                mCurrent = {};
+            }
         }
+
+        update(pRenderContext);
     }
 
     void CaptureTrigger::activeGraphChanged(RenderGraph* pNewGraph, RenderGraph* pPrevGraph)
@@ -41,6 +41,14 @@ namespace Mogwai
         const std::string kUI = "ui";
         const std::string kOutputs = "outputs";
         const std::string kCapture = "capture";
+        const std::string kFlush = "flush";
+
+        /** Number of threads encoding and writing images. Half of the cores are left for rendering.
+        */
+        size_t getWriterThreadCount()
+        {
+            return std::max(1u, std::thread::hardware_concurrency() / 2);
+        }
 
         template<typename T>
         std::vector<typename T::value_type::first_type> getFirstOfPair(const T& pair)
@@ -63,6 +71,15 @@ namespace Mogwai
         : CaptureTrigger(pRenderer, "Frame Capture")
     {
         mpImageProcessing = std::make_unique<ImageProcessing>(pRenderer->getDevice());
+
+        // The writer queue is bounded to apply back-pressure on the render loop when the disk can't keep up.
+        const size_t threadCount = getWriterThreadCount();
+        mpImageWriter = std::make_unique<AsyncImageWriter>(threadCount, 2 * threadCount);
+    }
+
+    FrameCapture::~FrameCapture()
+    {
+        flush();
     }
 
     void FrameCapture::renderUI(Gui* pGui)
@@ -76,7 +93,21 @@ namespace Mogwai
             w.checkbox("Capture All Outputs", mCaptureAllOutputs);
             w.tooltip("Capture all available outputs instead of the marked ones only.");
 
+            w.checkbox("Asynchronous Capture", mAsyncCapture);
+            w.tooltip("Read back and write images in the background while rendering continues.\n"
+                "If disabled, each captured frame is written to disk before rendering the next frame.");
+            w.var("Max Frames In Flight", mMaxFramesInFlight, 1u, 16u);
+            w.tooltip("Number of captured frames whose GPU readback may be pending before the render loop waits.");
+
             if (w.button("Capture Current Frame")) capture();
+
+            const auto stats = mpImageWriter->getStats();
+            const uint64_t framesWritten = mFramesWritten.load();
+            const double framesPerSecond = stats.elapsedTime > 0.0 ? framesWritten / stats.elapsedTime : 0.0;
+            w.text(fmt::format("Frames written: {} ({:.2f} frames/s)", framesWritten, framesPerSecond));
+            w.text(fmt::format("Frames failed: {} ({} images)", mFramesFailed.load(), stats.imagesFailed));
+            w.text(fmt::format("Images pending: {}", mpImageWriter->getPendingCount()));
+            w.text(fmt::format("Writer stalls: {} ({:.2f} s)", stats.stallCount, stats.stallTime));
         }
     }
 
@@ -95,6 +126,7 @@ namespace Mogwai
         auto printGraph = [](FrameCapture* pFC, RenderGraph* pGraph) { pybind11::print(pFC->graphFramesStr(pGraph)); };
         frameCapture.def(kPrintFrames.c_str(), printGraph, "graph"_a);
         frameCapture.def(kCapture.c_str(), &FrameCapture::capture);
+        frameCapture.def(kFlush.c_str(), &FrameCapture::flush);
         auto printAllGraphs = [](FrameCapture* pFC)
         {
             std::string s;
@@ -111,6 +143,14 @@ namespace Mogwai
         frameCapture.def_property("captureAllOutputs",
             [](FrameCapture* pFC){ return pFC->mCaptureAllOutputs;},
             [](FrameCapture* pFC, bool all){ pFC->mCaptureAllOutputs = all; });
+
+        frameCapture.def_property("asyncCapture",
+            [](FrameCapture* pFC){ return pFC->mAsyncCapture;},
+            [](FrameCapture* pFC, bool async){ pFC->mAsyncCapture = async; });
+
+        frameCapture.def_property("maxFramesInFlight",
+            [](FrameCapture* pFC){ return pFC->mMaxFramesInFlight;},
+            [](FrameCapture* pFC, uint32_t count){ pFC->mMaxFramesInFlight = std::max(count, 1u); });
     }
 
     std::string FrameCapture::getScriptVar() const
@@ -144,9 +184,10 @@ namespace Mogwai
             pGraph->execute(pRenderContext);
         }
 
+        PendingFrame frame;
         for (uint32_t i = 0 ; i < pGraph->getOutputCount() ; i++)
         {
-            captureOutput(pRenderContext, pGraph, i);
+            captureOutput(pRenderContext, pGraph, i, frame);
         }
 
         if (mCaptureAllOutputs && !unmarkedOutputs.empty())
@@ -154,9 +195,102 @@ namespace Mogwai
             for (const auto& output : unmarkedOutputs) pGraph->unmarkOutput(output);
             pGraph->compile(pRenderContext);
         }
+
+        // Count the frame when the last of its images has been written. Frames with any failed image count as failed.
+        struct FrameStatus
+        {
+            std::atomic<size_t> remaining;
+            std::atomic<bool> failed = false;
+        };
+        auto pStatus = std::make_shared<FrameStatus>();
+        pStatus->remaining = frame.readbacks.size();
+        for (auto& readback : frame.readbacks)
+        {
+            readback.image.callback = [this, pStatus](bool success)
+            {
+                if (!success) pStatus->failed = true;
+                if (--pStatus->remaining == 0) (pStatus->failed ? mFramesFailed : mFramesWritten)++;
+            };
+        }
+        mPendingFrames.push_back(std::move(frame));
+
+        // Limit the number of frames in flight. This waits on the GPU for the oldest frame only.
+        while (mPendingFrames.size() > mMaxFramesInFlight)
+        {
+            retireFrame(mPendingFrames.front());
+            mPendingFrames.pop_front();
+        }
+
+        if (!mAsyncCapture) flush();
+    }
+
+    void FrameCapture::update(RenderContext* pRenderContext)
+    {
+        retireFrames(false);
+    }
+
+    void FrameCapture::flush()
+    {
+        retireFrames(true);
+        mpImageWriter->flush();
+    }
+
+    void FrameCapture::retireFrame(PendingFrame& frame)
+    {
+        for (auto& readback : frame.readbacks)
+        {
+            // Copy the data out of the readback buffer and recycle the buffer for later captures.
+            readback.image.data = readback.pTask->getData();
+            mStagingBuffers.push_back(readback.pTask->getStagingBuffer());
+            readback.pTask.reset();
+
+            // This blocks if the writer queue is full.
+            mpImageWriter->write(std::move(readback.image));
+        }
+    }
+
+    void FrameCapture::retireFrames(bool wait)
+    {
+        // Frames are retired in order so images of a frame are queued together.
+        while (!mPendingFrames.empty())
+        {
+            auto& frame = mPendingFrames.front();
+            bool ready = std::all_of(frame.readbacks.begin(), frame.readbacks.end(), [](const auto& r) { return r.pTask->isReady(); });
+            if (!ready && !wait) break;
+            retireFrame(frame);
+            mPendingFrames.pop_front();
+        }
+    }
+
+    void FrameCapture::readback(RenderContext* pRenderContext, const ref<Texture>& pTex, AsyncImageWriter::Image image, PendingFrame& frame)
+    {
+        // Handle the special case where we have an HDR texture with less then 3 channels (see Texture::captureToFile()).
+        ref<Texture> pSrc = pTex;
+        image.resourceFormat = pTex->getFormat();
+        if (getFormatType(image.resourceFormat) == FormatType::Float && getFormatChannelCount(image.resourceFormat) < 3)
+        {
+            pSrc = mpRenderer->getDevice()->createTexture2D(pTex->getWidth(), pTex->getHeight(), ResourceFormat::RGBA32Float, 1, 1, nullptr,
+                ResourceBindFlags::RenderTarget | ResourceBindFlags::ShaderResource);
+            pRenderContext->blit(pTex->getSRV(0, 1, 0, 1), pSrc->getRTV(0, 0, 1));
+            image.resourceFormat = ResourceFormat::RGBA32Float;
+        }
+        image.width = pSrc->getWidth();
+        image.height = pSrc->getHeight();
+        image.isTopDown = true;
+
+        // Reuse a readback buffer of a retired frame if available.
+        ref<Buffer> pStagingBuffer;
+        if (!mStagingBuffers.empty())
+        {
+            pStagingBuffer = std::move(mStagingBuffers.back());
+            mStagingBuffers.pop_back();
+        }
+
+        auto pTask = pRenderContext->asyncReadTextureSubresource(pSrc.get(), pSrc->getSubresourceIndex(0, 0), std::move(pStagingBuffer));
+        frame.readbacks.push_back({ pTask, std::move(image) });
     }
 
-    void FrameCapture::captureOutput(RenderContext* pRenderContext, RenderGraph* pGraph, const uint32_t outputIndex)
+    void FrameCapture::captureOutput(RenderContext* pRenderContext, RenderGraph* pGraph, const uint32_t outputIndex, PendingFrame& frame)
     {
         const std::string outputName = pGraph->getOutputName(outputIndex);
         const std::string basename = getOutputNamePrefix(outputName) + std::to_string(mpRenderer->getGlobalClock().getFrame());
@@ -241,14 +375,15 @@ namespace Mogwai
                 mpImageProcessing->copyColorChannel(pRenderContext, pOutput->getSRV(0, 1, 0, 1), pTex->getUAV(), mask);
             }
 
-            // Write output image.
+            // Read back output image. It is written once the readback has completed.
             auto ext = Bitmap::getFileExtFromResourceFormat(pTex->getFormat());
-            auto fileformat = Bitmap::getFormatFromFileExtension(ext);
-            std::string filename = basename + suffix + "." + ext;
-            Bitmap::ExportFlags flags = Bitmap::ExportFlags::None;
-            if (mask == TextureChannelFlags::RGBA) flags |= Bitmap::ExportFlags::ExportAlpha;
+            AsyncImageWriter::Image image;
+            image.fileFormat = Bitmap::getFormatFromFileExtension(ext);
+            if (image.fileFormat == Bitmap::FileFormat::DdsFile) FALCOR_THROW("Frame capture does not support saving to DDS.");
+            image.path = basename + suffix + "." + ext;
+            if (mask == TextureChannelFlags::RGBA) image.exportFlags |= Bitmap::ExportFlags::ExportAlpha;
 
-            pTex->captureToFile(0, 0, filename, fileformat, flags);
+            readback(pRenderContext, pTex, std::move(image), frame);
         }
     }
 
@@ -28,7 +28,10 @@
 #pragma once
 #include "../../Mogwai.h"
 #include "CaptureTrigger.h"
+#include "Utils/Image/AsyncImageWriter.h"
 #include "Utils/Image/ImageProcessing.h"
+#include <atomic>
+#include <deque>
 
 namespace Mogwai
 {
@@ -36,6 +39,7 @@ namespace Mogwai
     {
     public:
         static UniquePtr create(Renderer* pRenderer);
+        virtual ~FrameCapture();
         virtual void renderUI(Gui* pGui) override;
         virtual void registerScriptBindings(pybind11::module& m) override;
         virtual std::string getScriptVar() const override;
@@ -43,16 +47,46 @@ namespace Mogwai
         virtual void triggerFrame(RenderContext* pRenderContext, RenderGraph* pGraph, uint64_t frameID) override;
         void capture();
 
+        /** Block until all captured frames have been written to disk.
+        */
+        void flush();
+
+    protected:
+        virtual void update(RenderContext* pRenderContext) override;
+
     private:
         FrameCapture(Renderer* pRenderer);
 
+        /** Image read back from the GPU asynchronously. The image data is filled in once the readback completes.
+        */
+        struct PendingReadback
+        {
+            CopyContext::ReadTextureTask::SharedPtr pTask;
+            AsyncImageWriter::Image image;
+        };
+
+        struct PendingFrame
+        {
+            std::vector<PendingReadback> readbacks;
+        };
+
         using uint64_vec = std::vector<uint64_t>;
         void addFrames(const RenderGraph* pGraph, const uint64_vec& frames);
         void addFrames(const std::string& graphName, const uint64_vec& frames);
         std::string graphFramesStr(const RenderGraph* pGraph);
-        void captureOutput(RenderContext* pRenderContext, RenderGraph* pGraph, const uint32_t outputIndex);
+        void captureOutput(RenderContext* pRenderContext, RenderGraph* pGraph, const uint32_t outputIndex, PendingFrame& frame);
+        void readback(RenderContext* pRenderContext, const ref<Texture>& pTex, AsyncImageWriter::Image image, PendingFrame& frame);
+        void retireFrame(PendingFrame& frame);
+        void retireFrames(bool wait);
 
         bool mCaptureAllOutputs = false;
+        bool mAsyncCapture = true;          ///< Write frames on worker threads while rendering continues.
+        uint32_t mMaxFramesInFlight = 3;    ///< Number of frames with readbacks in flight before the render thread waits on the GPU.
         std::unique_ptr<ImageProcessing> mpImageProcessing;
+        std::unique_ptr<AsyncImageWriter> mpImageWriter;
+        std::deque<PendingFrame> mPendingFrames;
+        std::vector<ref<Buffer>> mStagingBuffers;   ///< Readback buffers of retired frames available for reuse.
+        std::atomic<uint64_t> mFramesWritten = 0;  ///< Number of frames with all images written, updated by the writer threads.
+        std::atomic<uint64_t> mFramesFailed = 0;   ///< Number of frames with any image that failed to write, updated by the writer threads.
     };
 }
@@ -53,7 +53,7 @@ int runMain(int argc, char** argv)
     args::Flag listTags(parser, "", "List tags", {"list-tags"});
     args::ValueFlag<std::string> testSuiteFilterFlag(parser, "regex", "Filter test suites to run.", {'s', "test-suite"});
     args::ValueFlag<std::string> testCaseFilterFlag(parser, "regex", "Filter test cases to run.", {'f', "test-case"});
-    args::ValueFlag<std::string> tagFilterFlag(parser, "tags", "Filter test cases by tags.", {'t', "tags"});
+    args::ValueFlag<std::string> tagFilterFlag(parser, "tags", "Filter test cases by tags (default: -benchmark).", {'t', "tags"});
     args::ValueFlag<std::string> xmlReportFlag(parser, "path", "XML report output file.", {'x', "xml-report"});
     args::ValueFlag<uint32_t> repeatFlag(parser, "N", "Number of times to repeat the test.", {'r', "repeat"});
     args::Flag enableDebugLayerFlag(parser, "", "Enable debug layer (enabled by default in Debug build).", {"enable-debug-layer"});
@@ -162,6 +162,10 @@ int runMain(int argc, char** argv)
         }
     }
 
+    // Benchmarks allocate large inputs and take long to run, only run them when requested by tag.
+    if (!tagFilterFlag)
+        options.tagFilter = "-benchmark";
+
     // Setup error diagnostics to not break on exceptions.
     // We might have unit tests that check for exceptions, so we want to throw
     // them without breaking into the debugger in order to let tests run
@@ -27,10 +27,12 @@
  **************************************************************************/
 #include "Testing/UnitTest.h"
 #include "Utils/Sampling/AliasTable.h"
+#include "Utils/Timing/CpuTimer.h"
 
 #include <hypothesis/hypothesis.h>
 
 #include <iostream>
+#include <random>
 
 namespace Falcor
 {
@@ -56,7 +58,8 @@ void testAliasTable(GPUUnitTestContext& ctx, uint32_t N, std::vector<float> spec
     }
 
     // Create alias table.
-    AliasTable aliasTable(pDevice, weights, rng);
+    AliasTable aliasTable(weights);
+    aliasTable.createBuffers(pDevice);
 
     // Compute weight sum.
     double weightSum = 0.0;
@@ -137,8 +140,128 @@ void testAliasTable(GPUUnitTestContext& ctx, uint32_t N, std::vector<float> spec
         }
     }
 }
+
+std::vector<float> createRandomWeights(uint32_t N, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> uniform;
+    std::vector<float> weights(N);
+    for (uint32_t i = 0; i < N; ++i)
+        weights[i] = uniform(rng);
+
+    // Add a few zero weights and a few large weights.
+    for (uint32_t i = 0; i < std::max(1u, N / 100); ++i)
+    {
+        weights[(size_t)(uniform(rng) * N)] = 0.f;
+        weights[(size_t)(uniform(rng) * N)] = 100.f * uniform(rng);
+    }
+    return weights;
+}
+
+/// Verifies the table by computing the exact probability of sampling each index from the table items.
+void verifyAliasTableItems(CPUUnitTestContext& ctx, const AliasTable& aliasTable, const std::vector<float>& weights)
+{
+    const uint32_t N = aliasTable.getCount();
+    std::vector<double> probabilities(N, 0.0);
+    std::vector<uint32_t> indexBCount(N, 0);
+    for (const auto& item : aliasTable.getItems())
+    {
+        ASSERT_LT(item.indexA, N);
+        ASSERT_LT(item.indexB, N);
+        EXPECT(item.threshold >= 0.f && item.threshold <= 1.f);
+        indexBCount[item.indexB]++;
+        probabilities[item.indexB] += item.threshold / double(N);
+        probabilities[item.indexA] += (1.0 - item.threshold) / double(N);
+    }
+
+    for (uint32_t i = 0; i < N; ++i)
+    {
+        EXPECT_EQ(indexBCount[i], 1u) << "i = " << i;
+        double expected = weights[i] / aliasTable.getWeightSum();
+        EXPECT_LE(std::abs(probabilities[i] - expected), 1e-6 * expected + 1e-12) << "i = " << i;
+        EXPECT_EQ(aliasTable.evalPdf(i), expected);
+    }
+}
 } // namespace
 
+CPU_TEST(AliasTable_CPU)
+{
+    std::mt19937 rng;
+    for (uint32_t N : {1u, 2u, 100u, 1000u, 65537u, 1000000u})
+    {
+        std::vector<float> weights = createRandomWeights(N, rng);
+        AliasTable aliasTable(weights);
+        EXPECT_EQ(aliasTable.getCount(), N);
+        verifyAliasTableItems(ctx, aliasTable, weights);
+    }
+
+    // Skewed weights, where a single item has most of the weight.
+    {
+        std::vector<float> weights(100000, 1.f);
+        weights[12345] = 1e6f;
+        AliasTable aliasTable(weights);
+        verifyAliasTableItems(ctx, aliasTable, weights);
+    }
+
+    // All zero weights fall back to uniform sampling.
+    {
+        AliasTable aliasTable(std::vector<float>(10, 0.f));
+        for (uint32_t i = 0; i < 10; ++i)
+            EXPECT_EQ(aliasTable.sample(i, 0.5f), i);
+    }
+
+    EXPECT_THROW((AliasTable(std::vector<float>())));
+}
+
+CPU_TEST(AliasTable_CPUSample)
+{
+    const uint32_t N = 1000;
+    std::mt19937 rng;
+    std::vector<float> weights = createRandomWeights(N, rng);
+    AliasTable aliasTable(weights);
+
+    // Build histogram from CPU samples.
+    const uint32_t samplesPerWeight = 10000;
+    std::uniform_real_distribution<float> uniform;
+    std::vector<double> obsFrequencies(N, 0.0);
+    for (uint32_t i = 0; i < N * samplesPerWeight; ++i)
+    {
+        uint32_t item = aliasTable.sample(float2(uniform(rng), uniform(rng)));
+        ASSERT_LT(item, N);
+        obsFrequencies[item]++;
+    }
+
+    // Verify histogram using a chi-square test.
+    std::vector<double> expFrequencies(N);
+    for (uint32_t i = 0; i < N; ++i)
+        expFrequencies[i] = aliasTable.evalPdf(i) * N * samplesPerWeight;
+
+    const auto& [success, report] = hypothesis::chi2_test(N, obsFrequencies.data(), expFrequencies.data(), N * samplesPerWeight, 5, 0.1);
+    if (!success)
+        std::cout << report << std::endl;
+    EXPECT(success);
+
+    // A table restored from its items must sample identically.
+    AliasTable restored(weights, aliasTable.getItems());
+    EXPECT_EQ(restored.getWeightSum(), aliasTable.getWeightSum());
+    for (uint32_t i = 0; i < N; ++i)
+        EXPECT_EQ(restored.sample(i, 0.5f), aliasTable.sample(i, 0.5f));
+    EXPECT_THROW((AliasTable(weights, {})));
+}
+
+CPU_TEST(AliasTable_Throughput, TAGS("benchmark"))
+{
+    std::mt19937 rng;
+    for (uint32_t N : {1000000u, 10000000u, 16000000u})
+    {
+        std::vector<float> weights = createRandomWeights(N, rng);
+        auto start = CpuTimer::getCurrentTimePoint();
+        AliasTable aliasTable(std::move(weights));
+        double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        EXPECT_EQ(aliasTable.getCount(), N);
+        logInfo("Alias table with {} entries: {:.1f} ms", N, ms);
+    }
+}
+
 GPU_TEST(AliasTable)
 {
     testAliasTable(ctx, 1, {1.f});
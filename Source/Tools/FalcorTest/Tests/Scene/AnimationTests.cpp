@@ -0,0 +1,171 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Scene.h"
+#include "Scene/Animation/Animation.h"
+#include "Scene/Animation/AnimationController.h"
+#include "Utils/Math/Common.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <cstring>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+const double kDuration = 10.0;
+
+/// Creates an animation translating along x by the keyframe time, with keyframes every second.
+ref<Animation> createAnimation(NodeID nodeID, float speed)
+{
+    ref<Animation> pAnimation = Animation::create("anim", nodeID, kDuration);
+    for (uint32_t i = 0; i <= (uint32_t)kDuration; i++)
+    {
+        Animation::Keyframe keyframe;
+        keyframe.time = (double)i;
+        keyframe.translation = float3(speed * (float)i, 0.f, 0.f);
+        pAnimation->addKeyframe(keyframe);
+    }
+    return pAnimation;
+}
+
+/// Creates a random hierarchy where each node's parent precedes it. Every animatedEveryN:th node is animated.
+Scene::SceneData createHierarchy(ref<Device> pDevice, uint32_t nodeCount, uint32_t animatedEveryN, uint32_t seed = 0)
+{
+    Scene::SceneData sceneData;
+    sceneData.pMaterials = std::make_unique<MaterialSystem>(pDevice);
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> u;
+    for (uint32_t i = 0; i < nodeCount; i++)
+    {
+        // Attach most nodes close to the previous ones to get deep and wide subtrees.
+        NodeID parent = (i == 0 || rng() % 64 == 0) ? NodeID::Invalid() : NodeID(i - 1 - rng() % std::min(i, 16u));
+        float4x4 transform = mul(math::matrixFromTranslation(float3(u(rng), u(rng), u(rng))), math::matrixFromScaling(float3(1.f + u(rng))));
+        sceneData.sceneGraph.emplace_back("node", parent, transform, float4x4::identity(), float4x4::identity());
+        if (i % animatedEveryN == 0) sceneData.animations.push_back(createAnimation(NodeID(i), u(rng)));
+    }
+    return sceneData;
+}
+
+/// Computes the global matrices serially from the local node transforms and the animations.
+std::vector<float4x4> computeGlobalMatrices(const std::vector<Scene::Node>& sceneGraph, const std::vector<ref<Animation>>& animations, double time)
+{
+    std::vector<float4x4> local(sceneGraph.size());
+    for (size_t i = 0; i < sceneGraph.size(); i++) local[i] = sceneGraph[i].transform;
+    for (const auto& pAnimation : animations) local[pAnimation->getNodeID().get()] = pAnimation->animate(time);
+
+    std::vector<float4x4> global(sceneGraph.size());
+    for (size_t i = 0; i < sceneGraph.size(); i++)
+    {
+        NodeID parent = sceneGraph[i].parent;
+        global[i] = parent == NodeID::Invalid() ? local[i] : mul(global[parent.get()], local[i]);
+    }
+    return global;
+}
+} // namespace
+
+CPU_TEST(Animation_Keyframes)
+{
+    ref<Animation> pAnimation = Animation::create("anim", NodeID(0), kDuration);
+    for (double time : {4.0, 0.0, 8.0, 2.0, 6.0, 10.0})
+    {
+        Animation::Keyframe keyframe;
+        keyframe.time = time;
+        keyframe.translation = float3((float)time, 0.f, 0.f);
+        pAnimation->addKeyframe(keyframe);
+    }
+
+    // Keyframes are sorted and replaced at equal times.
+    Animation::Keyframe keyframe;
+    keyframe.time = 2.0;
+    keyframe.translation = float3(3.f, 0.f, 0.f);
+    pAnimation->addKeyframe(keyframe);
+
+    auto keyframes = pAnimation->getKeyframes();
+    ASSERT_EQ(keyframes.size(), 6);
+    for (size_t i = 0; i < keyframes.size(); i++) EXPECT_EQ(keyframes[i].time, 2.0 * i);
+    EXPECT_EQ(pAnimation->getKeyframe(2.0).translation.x, 3.f);
+    EXPECT(pAnimation->doesKeyframeExists(6.0));
+    EXPECT(!pAnimation->doesKeyframeExists(5.0));
+
+    // Sample forwards, backwards and with large jumps to exercise both the cached cursor and the search.
+    const double kTimes[] = {0.0, 0.5, 1.0, 1.5, 9.0, 3.0, 2.0, 5.0, 5.5, 0.25, 10.0, 7.0};
+    for (double time : kTimes)
+    {
+        float expected = time <= 2.0 ? 1.5f * (float)time : (float)time;
+        float4x4 transform = pAnimation->animate(time);
+        EXPECT_LE(std::abs(transform[0][3] - expected), 1e-5f) << "time=" << time;
+    }
+}
+
+GPU_TEST(AnimationController_WorldMatrices)
+{
+    Scene::SceneData sceneData = createHierarchy(ctx.getDevice(), 10000, 7);
+    std::vector<Scene::Node> sceneGraph = sceneData.sceneGraph;
+    std::vector<ref<Animation>> animations = sceneData.animations;
+    ref<Scene> pScene = Scene::create(ctx.getDevice(), std::move(sceneData));
+
+    for (double time : {0.0, 0.25, 3.5, 1.0, 9.75})
+    {
+        pScene->update(ctx.getRenderContext(), time);
+
+        std::vector<float4x4> expected = computeGlobalMatrices(sceneGraph, animations, time);
+        const auto& globalMatrices = pScene->getAnimationController()->getGlobalMatrices();
+        ASSERT_EQ(globalMatrices.size(), expected.size());
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            if (std::memcmp(&globalMatrices[i], &expected[i], sizeof(float4x4)) != 0) mismatches++;
+        }
+        EXPECT_EQ(mismatches, 0) << "time=" << time;
+    }
+}
+
+GPU_TEST(AnimationController_UpdateThroughput, TAGS("benchmark"))
+{
+    const uint32_t kNodeCount = 250000;
+    const uint32_t kFrameCount = 100;
+
+    for (uint32_t animatedEveryN : {1u, 10u, 1000u})
+    {
+        ref<Scene> pScene = Scene::create(ctx.getDevice(), createHierarchy(ctx.getDevice(), kNodeCount, animatedEveryN));
+        pScene->update(ctx.getRenderContext(), 0.0);
+
+        auto start = CpuTimer::getCurrentTimePoint();
+        for (uint32_t frame = 1; frame <= kFrameCount; frame++)
+        {
+            pScene->update(ctx.getRenderContext(), frame / 60.0);
+        }
+        double frameMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kFrameCount;
+
+        logInfo("{} nodes, {} animated: Scene::update in {:.3f} ms per frame", kNodeCount, div_round_up(kNodeCount, animatedEveryN), frameMs);
+    }
+}
+} // namespace Falcor
@@ -0,0 +1,232 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Animation/CpuSkinning.h"
+#include "Utils/Math/MatrixMath.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <cstring>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+const uint32_t kNodeCount = 200;
+const uint32_t kMeshCount = 10;
+const uint32_t kVerticesPerMesh = 5000;
+
+/// Scene graph matrices in the form bound to the skinning pass.
+struct SkinningMatrices
+{
+    std::vector<float4x4> bone, inverseTransposeBone, world, inverseTransposeWorld, meshBind, meshInvBind;
+
+    CpuSkinning::Matrices get() const
+    {
+        return { bone.data(), inverseTransposeBone.data(), world.data(), inverseTransposeWorld.data(), meshBind.data(), meshInvBind.data() };
+    }
+};
+
+SkinningMatrices createMatrices(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> u(-1.f, 1.f);
+    auto createMatrix = [&]()
+    {
+        float4x4 m = math::matrixFromTranslation(float3(u(rng), u(rng), u(rng)));
+        m = mul(m, math::matrixFromRotation(3.f * u(rng), normalize(float3(u(rng), u(rng), u(rng)) + 0.01f)));
+        return mul(m, math::matrixFromScaling(float3(1.f + 0.2f * u(rng))));
+    };
+
+    SkinningMatrices m;
+    for (uint32_t i = 0; i < kNodeCount; i++)
+    {
+        m.bone.push_back(createMatrix());
+        m.inverseTransposeBone.push_back(transpose(inverse(m.bone.back())));
+        m.world.push_back(createMatrix());
+        m.inverseTransposeWorld.push_back(transpose(inverse(m.world.back())));
+        m.meshBind.push_back(createMatrix());
+        m.meshInvBind.push_back(inverse(m.meshBind.back()));
+    }
+    return m;
+}
+
+/// Creates skinned meshes where each mesh uses its own bind and skeleton matrices and a subset of the bones.
+void createSkinnedVertices(std::mt19937& rng, uint32_t meshCount, std::vector<SkinningVertexData>& skinningData, std::vector<PackedStaticVertexData>& staticVertices)
+{
+    std::uniform_real_distribution<float> u(-1.f, 1.f);
+    size_t vertexCount = size_t(meshCount) * kVerticesPerMesh;
+    skinningData.resize(vertexCount);
+    staticVertices.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        uint32_t mesh = uint32_t(i / kVerticesPerMesh) % kMeshCount;
+        auto randomBone = [&]() { return 2 * kMeshCount + (uint32_t)(rng() % 64); };
+
+        SkinningVertexData& s = skinningData[i];
+        s.boneID = uint4(randomBone(), randomBone(), randomBone(), randomBone());
+        float4 weights = abs(float4(u(rng), u(rng), u(rng), i % 3 == 0 ? u(rng) : 0.f));
+        s.boneWeight = weights / (weights.x + weights.y + weights.z + weights.w);
+        s.staticIndex = uint32_t(2 * i);
+        s.bindMatrixID = mesh;
+        s.skeletonMatrixID = kMeshCount + mesh;
+
+        StaticVertexData v;
+        v.position = float3(u(rng), u(rng), u(rng));
+        v.normal = normalize(float3(u(rng), u(rng), u(rng)));
+        v.tangent = float4(normalize(float3(u(rng), u(rng), u(rng))), i % 2 ? 1.f : -1.f);
+        v.texCrd = float2(u(rng), u(rng));
+        v.curveRadius = 0.f;
+        staticVertices[i].pack(v);
+    }
+}
+
+/// Skins a vertex the way Skinning.slang does.
+StaticVertexData skinReference(const SkinningVertexData& s, const PackedStaticVertexData& vertex, const SkinningMatrices& m)
+{
+    float4x4 boneMat = m.bone[s.boneID.x] * s.boneWeight.x + m.bone[s.boneID.y] * s.boneWeight.y + m.bone[s.boneID.z] * s.boneWeight.z + m.bone[s.boneID.w] * s.boneWeight.w;
+    boneMat = mul(boneMat, m.meshBind[s.bindMatrixID]);
+    boneMat = mul(transpose(m.inverseTransposeWorld[s.skeletonMatrixID]), boneMat);
+    boneMat = mul(m.meshInvBind[s.bindMatrixID], boneMat);
+
+    float4x4 invTransposeMat = m.inverseTransposeBone[s.boneID.x] * s.boneWeight.x + m.inverseTransposeBone[s.boneID.y] * s.boneWeight.y +
+                               m.inverseTransposeBone[s.boneID.z] * s.boneWeight.z + m.inverseTransposeBone[s.boneID.w] * s.boneWeight.w;
+    invTransposeMat = mul(transpose(m.world[s.skeletonMatrixID]), invTransposeMat);
+
+    StaticVertexData v = vertex.unpack();
+    v.position = mul(boneMat, float4(v.position, 1.f)).xyz();
+    v.tangent = float4(mul(float3x3(boneMat), v.tangent.xyz()), v.tangent.w);
+    v.normal = mul(float3x3(invTransposeMat), v.normal);
+    return v;
+}
+
+template<typename Func>
+void forEachCodePath(Func func)
+{
+    const bool wasEnabled = CpuSkinning::isSimdEnabled();
+    CpuSkinning::setSimdEnabled(false);
+    func();
+    if (CpuSkinning::isSimdSupported())
+    {
+        CpuSkinning::setSimdEnabled(true);
+        func();
+    }
+    CpuSkinning::setSimdEnabled(wasEnabled);
+}
+} // namespace
+
+CPU_TEST(CpuSkinning_MatchesReference)
+{
+    std::mt19937 rng(0);
+    SkinningMatrices matrices = createMatrices(rng);
+    std::vector<SkinningVertexData> skinningData;
+    std::vector<PackedStaticVertexData> staticVertices;
+    createSkinnedVertices(rng, kMeshCount, skinningData, staticVertices);
+    const size_t vertexCount = skinningData.size();
+
+    CpuSkinning skinning(skinningData, staticVertices);
+    ASSERT_EQ(skinning.getVertexCount(), vertexCount);
+    EXPECT_LE(skinning.getPaletteSize(), kMeshCount * 64);
+    for (size_t i = 0; i < vertexCount; i++) EXPECT_EQ(skinning.getStaticIndices()[i], skinningData[i].staticIndex);
+
+    skinning.updatePalette(matrices.get());
+
+    std::vector<std::vector<PackedStaticVertexData>> results;
+    forEachCodePath(
+        [&]()
+        {
+            std::vector<PackedStaticVertexData> vertices(vertexCount);
+            std::vector<float3> positions(vertexCount);
+            skinning.skinVertices(vertices.data());
+            skinning.skinPositions(positions.data());
+
+            float maxPositionError = 0.f;
+            float maxNormalError = 0.f;
+            float maxTangentError = 0.f;
+            size_t positionMismatches = 0;
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                // Compare after packing, which is lossy for normals and tangents.
+                StaticVertexData result = vertices[i].unpack();
+                StaticVertexData expected = PackedStaticVertexData(skinReference(skinningData[i], staticVertices[i], matrices)).unpack();
+                maxPositionError = std::max(maxPositionError, length(result.position - expected.position));
+                maxNormalError = std::max(maxNormalError, length(result.normal - expected.normal));
+                maxTangentError = std::max(maxTangentError, length(result.tangent - expected.tangent));
+                if (any(positions[i] != vertices[i].position)) positionMismatches++;
+            }
+            EXPECT_LE(maxPositionError, 1e-4f);
+            EXPECT_LE(maxNormalError, 2e-3f);
+            EXPECT_LE(maxTangentError, 1e-3f);
+            EXPECT_EQ(positionMismatches, 0);
+
+            results.push_back(std::move(vertices));
+        }
+    );
+
+    // The vectorized blending adds in the same order, so both code paths produce identical vertices.
+    if (results.size() == 2)
+    {
+        EXPECT(std::memcmp(results[0].data(), results[1].data(), vertexCount * sizeof(PackedStaticVertexData)) == 0);
+    }
+}
+
+CPU_TEST(CpuSkinning_Throughput, TAGS("benchmark"))
+{
+    std::mt19937 rng(0);
+    SkinningMatrices matrices = createMatrices(rng);
+    std::vector<SkinningVertexData> skinningData;
+    std::vector<PackedStaticVertexData> staticVertices;
+    createSkinnedVertices(rng, 200, skinningData, staticVertices);
+    const size_t vertexCount = skinningData.size();
+
+    CpuSkinning skinning(skinningData, std::move(staticVertices));
+    std::vector<PackedStaticVertexData> vertices(vertexCount);
+    std::vector<float3> positions(vertexCount);
+
+    auto start = CpuTimer::getCurrentTimePoint();
+    skinning.updatePalette(matrices.get());
+    logInfo("updatePalette: {} matrices, {:.3f} ms", skinning.getPaletteSize(), CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()));
+
+    auto measure = [&](const char* name, auto func)
+    {
+        func(); // Warm up.
+        auto start = CpuTimer::getCurrentTimePoint();
+        const int iterations = 4;
+        for (int i = 0; i < iterations; ++i)
+            func();
+        double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / iterations;
+        logInfo("{} ({}): {:.3f} ms, {:.1f} M vertices/s", name, CpuSkinning::isSimdEnabled() ? "simd" : "scalar", ms, vertexCount / (ms * 1e-3) / 1e6);
+    };
+
+    forEachCodePath(
+        [&]()
+        {
+            measure("skinVertices", [&]() { skinning.skinVertices(vertices.data()); });
+            measure("skinPositions", [&]() { skinning.skinPositions(positions.data()); });
+        }
+    );
+}
+} // namespace Falcor
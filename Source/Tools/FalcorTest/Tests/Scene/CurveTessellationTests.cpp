@@ -0,0 +1,263 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Curves/CurveTessellation.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+struct Groom
+{
+    std::vector<uint32_t> vertexCounts;
+    std::vector<float3> controlPoints;
+    std::vector<float> widths;
+    std::vector<float2> UVs;
+
+    uint32_t getStrandCount() const { return (uint32_t)vertexCounts.size(); }
+};
+
+/// Creates random strands going up along y, with some duplicate control points.
+Groom createGroom(uint32_t strandCount, uint32_t seed = 0)
+{
+    Groom groom;
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> u;
+    for (uint32_t i = 0; i < strandCount; i++)
+    {
+        uint32_t vertexCount = 4 + rng() % 12;
+        groom.vertexCounts.push_back(vertexCount);
+        float3 p(u(rng), 0.f, u(rng));
+        for (uint32_t j = 0; j < vertexCount; j++)
+        {
+            if (j < 2 || rng() % 8 != 0)
+                p += float3(0.1f * u(rng) - 0.05f, 0.1f, 0.1f * u(rng) - 0.05f);
+            groom.controlPoints.push_back(p);
+            groom.widths.push_back(0.01f + 0.01f * u(rng));
+            groom.UVs.push_back(float2(u(rng), u(rng)));
+        }
+    }
+    return groom;
+}
+
+/// Creates a groom with every keepOneEveryXStrands strand of another groom.
+Groom decimateGroom(const Groom& groom, uint32_t keepOneEveryXStrands)
+{
+    Groom decimated;
+    uint32_t pointOffset = 0;
+    for (uint32_t i = 0; i < groom.getStrandCount(); i++)
+    {
+        uint32_t vertexCount = groom.vertexCounts[i];
+        if (i % keepOneEveryXStrands == 0)
+        {
+            decimated.vertexCounts.push_back(vertexCount);
+            decimated.controlPoints.insert(decimated.controlPoints.end(), groom.controlPoints.begin() + pointOffset, groom.controlPoints.begin() + pointOffset + vertexCount);
+            decimated.widths.insert(decimated.widths.end(), groom.widths.begin() + pointOffset, groom.widths.begin() + pointOffset + vertexCount);
+            decimated.UVs.insert(decimated.UVs.end(), groom.UVs.begin() + pointOffset, groom.UVs.begin() + pointOffset + vertexCount);
+        }
+        pointOffset += vertexCount;
+    }
+    return decimated;
+}
+
+template<typename T>
+bool equal(const fast_vector<T>& a, const fast_vector<T>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const T& x, const T& y) { return all(x == y); });
+}
+
+template<>
+bool equal(const fast_vector<uint32_t>& a, const fast_vector<uint32_t>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template<>
+bool equal(const fast_vector<float>& a, const fast_vector<float>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+} // namespace
+
+CPU_TEST(CurveTessellation_LinearSweptSphere)
+{
+    const uint32_t kSubdivPerSegment = 4;
+    Groom groom = createGroom(1000);
+
+    auto result = CurveTessellation::convertToLinearSweptSphere(
+        groom.getStrandCount(),
+        groom.vertexCounts.data(),
+        groom.controlPoints.data(),
+        groom.widths.data(),
+        groom.UVs.data(),
+        1,
+        kSubdivPerSegment,
+        1,
+        1,
+        1.f,
+        float4x4::identity()
+    );
+
+    EXPECT_EQ(result.degree, 1u);
+    ASSERT_EQ(result.points.size(), result.radius.size());
+    ASSERT_EQ(result.points.size(), result.texCrds.size());
+    ASSERT_EQ(result.indices.size(), result.points.size() - groom.getStrandCount());
+
+    // Each strand starts and ends at its first and last control point, and has kSubdivPerSegment segments per unique control point.
+    uint32_t pointOffset = 0;
+    uint32_t resultPointOffset = 0;
+    uint32_t indexOffset = 0;
+    for (uint32_t i = 0; i < groom.getStrandCount(); i++)
+    {
+        uint32_t vertexCount = groom.vertexCounts[i];
+        uint32_t uniqueCount = 1;
+        for (uint32_t j = 0; j < vertexCount - 1; j++)
+        {
+            if (any(groom.controlPoints[pointOffset + j] != groom.controlPoints[pointOffset + j + 1]))
+                uniqueCount++;
+        }
+
+        uint32_t pointCount = kSubdivPerSegment * (uniqueCount - 1) + 1;
+        ASSERT_LE(resultPointOffset + pointCount, result.points.size());
+        EXPECT(all(result.points[resultPointOffset] == groom.controlPoints[pointOffset])) << "strand = " << i;
+        EXPECT_LT(length(result.points[resultPointOffset + pointCount - 1] - groom.controlPoints[pointOffset + vertexCount - 1]), 1e-5f) << "strand = " << i;
+        for (uint32_t j = 0; j < pointCount - 1; j++)
+            EXPECT_EQ(result.indices[indexOffset + j], resultPointOffset + j);
+
+        pointOffset += vertexCount;
+        resultPointOffset += pointCount;
+        indexOffset += pointCount - 1;
+    }
+    EXPECT_EQ(resultPointOffset, result.points.size());
+}
+
+CPU_TEST(CurveTessellation_Decimation)
+{
+    // Keeping one of every X strands must give the same result as tessellating those strands only.
+    const uint32_t kKeepOneEveryXStrands = 3;
+    const uint32_t kKeepOneEveryXVertices = 2;
+    Groom groom = createGroom(1000);
+    Groom decimated = decimateGroom(groom, kKeepOneEveryXStrands);
+    const float4x4 xform = math::matrixFromTranslation(float3(1.f, 2.f, 3.f));
+
+    auto sweptSphere = CurveTessellation::convertToLinearSweptSphere(
+        groom.getStrandCount(), groom.vertexCounts.data(), groom.controlPoints.data(), groom.widths.data(), groom.UVs.data(),
+        1, 4, kKeepOneEveryXStrands, kKeepOneEveryXVertices, 1.f, xform
+    );
+    auto refSweptSphere = CurveTessellation::convertToLinearSweptSphere(
+        decimated.getStrandCount(), decimated.vertexCounts.data(), decimated.controlPoints.data(), decimated.widths.data(), decimated.UVs.data(),
+        1, 4, 1, kKeepOneEveryXVertices, 1.f, xform
+    );
+    EXPECT(equal(sweptSphere.indices, refSweptSphere.indices));
+    EXPECT(equal(sweptSphere.points, refSweptSphere.points));
+    EXPECT(equal(sweptSphere.radius, refSweptSphere.radius));
+    EXPECT(equal(sweptSphere.texCrds, refSweptSphere.texCrds));
+
+    auto mesh = CurveTessellation::convertToPolytube(
+        groom.getStrandCount(), groom.vertexCounts.data(), groom.controlPoints.data(), groom.widths.data(), nullptr,
+        4, kKeepOneEveryXStrands, kKeepOneEveryXVertices, 1.f, 4
+    );
+    auto refMesh = CurveTessellation::convertToPolytube(
+        decimated.getStrandCount(), decimated.vertexCounts.data(), decimated.controlPoints.data(), decimated.widths.data(), nullptr,
+        4, 1, kKeepOneEveryXVertices, 1.f, 4
+    );
+    EXPECT(mesh.texCrds.empty());
+    EXPECT(equal(mesh.vertices, refMesh.vertices));
+    EXPECT(equal(mesh.normals, refMesh.normals));
+    EXPECT(equal(mesh.tangents, refMesh.tangents));
+    EXPECT(equal(mesh.radii, refMesh.radii));
+    EXPECT(equal(mesh.faceVertexCounts, refMesh.faceVertexCounts));
+    EXPECT(equal(mesh.faceVertexIndices, refMesh.faceVertexIndices));
+}
+
+CPU_TEST(CurveTessellation_Polytube)
+{
+    const uint32_t kPointCountPerCrossSection = 6;
+    Groom groom = createGroom(1000);
+
+    auto sweptSphere = CurveTessellation::convertToLinearSweptSphere(
+        groom.getStrandCount(), groom.vertexCounts.data(), groom.controlPoints.data(), groom.widths.data(), nullptr,
+        1, 4, 1, 1, 1.f, float4x4::identity()
+    );
+    auto mesh = CurveTessellation::convertToPolytube(
+        groom.getStrandCount(), groom.vertexCounts.data(), groom.controlPoints.data(), groom.widths.data(), groom.UVs.data(),
+        4, 1, 1, 1.f, kPointCountPerCrossSection
+    );
+
+    // Each tessellated point has a cross-section, and consecutive cross-sections are connected with two triangles per point.
+    const size_t pointCount = sweptSphere.points.size();
+    const size_t faceCount = 2 * kPointCountPerCrossSection * (pointCount - groom.getStrandCount());
+    EXPECT_EQ(mesh.vertices.size(), kPointCountPerCrossSection * pointCount);
+    EXPECT_EQ(mesh.normals.size(), mesh.vertices.size());
+    EXPECT_EQ(mesh.tangents.size(), mesh.vertices.size());
+    EXPECT_EQ(mesh.texCrds.size(), mesh.vertices.size());
+    EXPECT_EQ(mesh.radii.size(), mesh.vertices.size());
+    ASSERT_EQ(mesh.faceVertexCounts.size(), faceCount);
+    ASSERT_EQ(mesh.faceVertexIndices.size(), 3 * faceCount);
+
+    for (size_t f = 0; f < faceCount; f++)
+        EXPECT_EQ(mesh.faceVertexCounts[f], 3u);
+    for (size_t i = 0; i < mesh.faceVertexIndices.size(); i++)
+        EXPECT_LT(mesh.faceVertexIndices[i], mesh.vertices.size());
+    for (size_t v = 0; v < mesh.normals.size(); v++)
+        EXPECT_LT(std::abs(length(mesh.normals[v]) - 1.f), 1e-3f);
+}
+
+CPU_TEST(CurveTessellation_Throughput, TAGS("benchmark"))
+{
+    const uint32_t kStrandCount = 1000000;
+    Groom groom = createGroom(kStrandCount);
+
+    auto start = CpuTimer::getCurrentTimePoint();
+    auto sweptSphere = CurveTessellation::convertToLinearSweptSphere(
+        kStrandCount, groom.vertexCounts.data(), groom.controlPoints.data(), groom.widths.data(), groom.UVs.data(),
+        1, 4, 1, 1, 1.f, float4x4::identity()
+    );
+    double sweptSphereMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    size_t sweptSpherePointCount = sweptSphere.points.size();
+    sweptSphere = {};
+
+    start = CpuTimer::getCurrentTimePoint();
+    auto mesh = CurveTessellation::convertToPolytube(
+        kStrandCount, groom.vertexCounts.data(), groom.controlPoints.data(), groom.widths.data(), groom.UVs.data(),
+        4, 1, 1, 1.f, 4
+    );
+    double polytubeMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    logInfo(
+        "{} strands: {} swept sphere points in {:.1f} ms, {} polytube vertices in {:.1f} ms",
+        kStrandCount,
+        sweptSpherePointCount,
+        sweptSphereMs,
+        mesh.vertices.size(),
+        polytubeMs
+    );
+}
+} // namespace Falcor
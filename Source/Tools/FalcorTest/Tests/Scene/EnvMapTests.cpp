@@ -28,7 +28,12 @@
 #include "Testing/UnitTest.h"
 #include "Core/AssetResolver.h"
 #include "Scene/Lights/EnvMap.h"
+#include "Scene/Lights/EnvMapImportanceMap.h"
 #include "Rendering/Lights/EnvMapSampler.h"
+#include "Utils/Image/Bitmap.h"
+#include "Utils/Math/MathConstants.slangh"
+#include "Utils/Timing/CpuTimer.h"
+#include <random>
 
 namespace Falcor
 {
@@ -36,6 +41,27 @@ namespace
 {
 // TODO: This is not ideal, we should only access files in the runtime directory.
 const std::filesystem::path kEnvMapPath = getProjectDirectory() / "media/test_scenes/envmaps/20050806-03_hd.hdr";
+
+/// Creates an RGBA float lat-long environment map with a smooth gradient and a bright spot.
+Bitmap::UniqueConstPtr createTestEnvMap(uint32_t width, uint32_t height)
+{
+    std::vector<float> data(size_t(width) * height * 4);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            float u = (x + 0.5f) / width;
+            float v = (y + 0.5f) / height;
+            float spot = (std::abs(u - 0.3f) < 0.05f && std::abs(v - 0.25f) < 0.05f) ? 50.f : 0.f;
+            float* pTexel = &data[(size_t(y) * width + x) * 4];
+            pTexel[0] = 0.1f + u + spot;
+            pTexel[1] = 0.2f + v + spot;
+            pTexel[2] = 0.3f + u * v;
+            pTexel[3] = 1.f;
+        }
+    }
+    return Bitmap::create(width, height, ResourceFormat::RGBA32Float, reinterpret_cast<const uint8_t*>(data.data()));
+}
 } // namespace
 
 GPU_TEST(EnvMap)
@@ -65,4 +91,134 @@ GPU_TEST(EnvMap)
     EXPECT_EQ(w, h);
     EXPECT_EQ(w, 1 << (mipCount - 1));
 }
+
+CPU_TEST(EnvMapImportanceMap_Mips)
+{
+    auto pBitmap = createTestEnvMap(256, 128);
+    auto importanceMap = EnvMapImportanceMap::build(*pBitmap, 64, 16);
+
+    EXPECT_EQ(importanceMap.getDimension(), 64);
+    EXPECT_EQ(importanceMap.getSampleCount(), 16);
+    EXPECT_EQ(importanceMap.getMipCount(), 7);
+
+    // Each level must be the 2x2 average of the previous level.
+    for (uint32_t mip = 1; mip < importanceMap.getMipCount(); mip++)
+    {
+        uint32_t dim = importanceMap.getDimension() >> mip;
+        const float* pSrc = importanceMap.getMip(mip - 1);
+        const float* pDst = importanceMap.getMip(mip);
+        for (uint32_t y = 0; y < dim; y++)
+        {
+            for (uint32_t x = 0; x < dim; x++)
+            {
+                float expected = (pSrc[2 * y * 2 * dim + 2 * x] + pSrc[2 * y * 2 * dim + 2 * x + 1] + pSrc[(2 * y + 1) * 2 * dim + 2 * x] +
+                                  pSrc[(2 * y + 1) * 2 * dim + 2 * x + 1]) *
+                                 0.25f;
+                EXPECT_LE(std::abs(pDst[y * dim + x] - expected), 1e-5f * expected) << "mip=" << mip << " x=" << x << " y=" << y;
+            }
+        }
+    }
+
+    // The pdf must integrate to one over the sphere. All texels of the equal-area map have the same solid angle.
+    uint32_t dim = importanceMap.getDimension();
+    double integral = 0.0;
+    for (uint32_t i = 0; i < dim * dim; i++)
+        integral += importanceMap.getMip(0)[i] / importanceMap.getAverage() * M_1_4PI * (M_4PI / (dim * dim));
+    EXPECT_LE(std::abs(integral - 1.0), 1e-4);
+
+    // Unsupported parameters must throw.
+    EXPECT_THROW((EnvMapImportanceMap::build(*pBitmap, 48, 16)));
+    EXPECT_THROW((EnvMapImportanceMap::build(*pBitmap, 64, 12)));
+    EXPECT_THROW((EnvMapImportanceMap(64, 16, std::vector<float>(10))));
+}
+
+CPU_TEST(EnvMapImportanceMap_Sampling)
+{
+    auto pBitmap = createTestEnvMap(256, 128);
+    auto importanceMap = EnvMapImportanceMap::build(*pBitmap, 64, 16);
+
+    // Coarse histogram of the sampled directions in the octahedral map.
+    const uint32_t kHistogramMip = 3;
+    const uint32_t histogramDim = importanceMap.getDimension() >> kHistogramMip;
+    std::vector<uint32_t> histogram(histogramDim * histogramDim, 0);
+
+    const uint32_t kSampleCount = 200000;
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    uint32_t pdfMismatches = 0;
+    for (uint32_t i = 0; i < kSampleCount; i++)
+    {
+        auto s = importanceMap.sample(float2(dist(rng), dist(rng)));
+        EXPECT_GT(s.pdf, 0.f);
+        EXPECT_LE(std::abs(length(s.dir) - 1.f), 1e-4f);
+
+        // The pdf of a sample must match evalPdf() for the direction, except for directions on texel boundaries.
+        if (std::abs(importanceMap.evalPdf(s.dir) - s.pdf) > 1e-4f * s.pdf)
+            pdfMismatches++;
+
+        float2 p = ndir_to_oct_equal_area_unorm(s.dir);
+        uint32_t x = std::min(uint32_t(p.x * histogramDim), histogramDim - 1);
+        uint32_t y = std::min(uint32_t(p.y * histogramDim), histogramDim - 1);
+        histogram[y * histogramDim + x]++;
+    }
+    EXPECT_LE(pdfMismatches, kSampleCount / 1000);
+
+    // The sample distribution must be proportional to the importance map.
+    const float* pMip = importanceMap.getMip(kHistogramMip);
+    for (uint32_t i = 0; i < histogramDim * histogramDim; i++)
+    {
+        float expected = pMip[i] / importanceMap.getAverage() / (histogramDim * histogramDim) * kSampleCount;
+        if (expected < 1000.f)
+            continue;
+        EXPECT_LE(std::abs(histogram[i] - expected), 0.1f * expected) << "cell=" << i;
+    }
+}
+
+GPU_TEST(EnvMapImportanceMap_MatchesGPU)
+{
+    // Loading from file builds the importance map on the CPU.
+    ref<EnvMap> pEnvMap = EnvMap::createFromFile(ctx.getDevice(), kEnvMapPath);
+    ASSERT_NE(pEnvMap, nullptr);
+    ASSERT_NE(pEnvMap->getImportanceMap(), nullptr);
+    const auto& cpuMap = *pEnvMap->getImportanceMap();
+
+    // Creating an environment map from a texture builds the importance map on the GPU.
+    ref<EnvMap> pGpuEnvMap = EnvMap::create(ctx.getDevice(), pEnvMap->getEnvMap());
+    EXPECT_EQ(pGpuEnvMap->getImportanceMap(), nullptr);
+    EnvMapSampler gpuSampler(ctx.getDevice(), pGpuEnvMap);
+    auto pGpuMap = gpuSampler.getImportanceMap();
+    ASSERT_EQ(pGpuMap->getWidth(), cpuMap.getDimension());
+    ASSERT_EQ(pGpuMap->getMipCount(), cpuMap.getMipCount());
+
+    // Compare the base levels. Texture filtering on the GPU uses reduced precision interpolation weights.
+    std::vector<uint8_t> gpuData = ctx.getRenderContext()->readTextureSubresource(pGpuMap.get(), 0);
+    ASSERT_EQ(gpuData.size(), cpuMap.getDimension() * cpuMap.getDimension() * sizeof(float));
+    const float* pGpu = reinterpret_cast<const float*>(gpuData.data());
+    const float* pCpu = cpuMap.getMip(0);
+    for (uint32_t i = 0; i < cpuMap.getDimension() * cpuMap.getDimension(); i++)
+    {
+        float tolerance = 1e-2f * std::max(pCpu[i], cpuMap.getAverage());
+        EXPECT_LE(std::abs(pGpu[i] - pCpu[i]), tolerance) << "i=" << i;
+    }
+
+    // The sampler must upload the CPU-built importance map.
+    EnvMapSampler cpuSampler(ctx.getDevice(), pEnvMap);
+    std::vector<uint8_t> uploadedData = ctx.getRenderContext()->readTextureSubresource(cpuSampler.getImportanceMap().get(), 0);
+    ASSERT_EQ(uploadedData.size(), gpuData.size());
+    EXPECT(std::memcmp(uploadedData.data(), pCpu, uploadedData.size()) == 0);
+}
+
+CPU_TEST(EnvMapImportanceMap_Throughput, TAGS("benchmark"))
+{
+    // Build the default importance map from large environment maps.
+    for (uint2 size : {uint2(2048, 1024), uint2(4096, 2048)})
+    {
+        auto pBitmap = createTestEnvMap(size.x, size.y);
+        auto start = CpuTimer::getCurrentTimePoint();
+        auto importanceMap = EnvMapImportanceMap::build(*pBitmap);
+        double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        EXPECT_GT(importanceMap.getAverage(), 0.f);
+        logInfo("{}x{} environment map importance map: {:.1f} ms", size.x, size.y, ms);
+    }
+}
 } // namespace Falcor
@@ -0,0 +1,124 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/InstanceBoundsTree.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+AABB createBox(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> u(-100.f, 100.f);
+    float3 center(u(rng), u(rng), u(rng));
+    float3 extent = abs(float3(u(rng), u(rng), u(rng))) * 0.01f;
+    return AABB(center - extent, center + extent);
+}
+
+AABB computeUnion(const std::vector<AABB>& boxes)
+{
+    AABB result;
+    for (const auto& box : boxes) result |= box;
+    return result;
+}
+
+bool isEqual(const AABB& a, const AABB& b)
+{
+    return all(a.minPoint == b.minPoint) && all(a.maxPoint == b.maxPoint);
+}
+} // namespace
+
+CPU_TEST(InstanceBoundsTree_Update)
+{
+    std::mt19937 rng(1234);
+
+    InstanceBoundsTree tree;
+    tree.build(0, [](size_t) { return AABB(); });
+    EXPECT(!tree.getBounds().valid());
+
+    for (size_t count : {1, 2, 7, 64, 1000, 20000})
+    {
+        std::vector<AABB> boxes(count);
+        for (auto& box : boxes) box = createBox(rng);
+
+        tree.build(count, [&](size_t i) { return boxes[i]; });
+        EXPECT_EQ(tree.getInstanceCount(), count);
+        EXPECT(isEqual(tree.getBounds(), computeUnion(boxes)));
+
+        std::uniform_int_distribution<uint32_t> pick(0, uint32_t(count - 1));
+        for (size_t changedCount : {size_t(1), count / 10 + 1, count})
+        {
+            // Pick random instances, possibly with duplicates, and move them.
+            std::vector<uint32_t> ids(changedCount);
+            for (auto& id : ids)
+            {
+                id = pick(rng);
+                boxes[id] = createBox(rng);
+            }
+
+            tree.update(ids, [&](size_t i) { return boxes[i]; });
+            EXPECT(isEqual(tree.getBounds(), computeUnion(boxes)));
+            for (uint32_t id : ids) EXPECT(isEqual(tree.getInstanceBounds(id), boxes[id]));
+        }
+    }
+}
+
+CPU_TEST(InstanceBoundsTree_Throughput, TAGS("benchmark"))
+{
+    const size_t kInstanceCount = 500000;
+    const size_t kChangedCount = 1000;
+
+    std::mt19937 rng(1234);
+    std::vector<AABB> boxes(kInstanceCount);
+    for (auto& box : boxes) box = createBox(rng);
+    auto getBounds = [&](size_t i) { return boxes[i]; };
+
+    InstanceBoundsTree tree;
+    auto start = CpuTimer::getCurrentTimePoint();
+    tree.build(kInstanceCount, getBounds);
+    logInfo("build: {} instances, {:.3f} ms", kInstanceCount, CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()));
+
+    std::uniform_int_distribution<uint32_t> pick(0, uint32_t(kInstanceCount - 1));
+    std::vector<uint32_t> ids(kChangedCount);
+    for (auto& id : ids) id = pick(rng);
+
+    const int iterations = 100;
+    start = CpuTimer::getCurrentTimePoint();
+    for (int i = 0; i < iterations; i++)
+    {
+        std::vector<uint32_t> changed = ids;
+        tree.update(changed, getBounds);
+    }
+    double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / iterations;
+    logInfo("update: {} of {} instances, {:.3f} ms", kChangedCount, kInstanceCount, ms);
+
+    EXPECT(isEqual(tree.getBounds(), computeUnion(boxes)));
+}
+} // namespace Falcor
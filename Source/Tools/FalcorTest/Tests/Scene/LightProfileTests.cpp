@@ -0,0 +1,206 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Lights/LightProfile.h"
+#include "Utils/Math/Float16.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+const size_t kHeaderSize = 13;
+
+const char kTypeCProfile[] = R"(IESNA:LM-63-2002
+[TEST] Falcor unit test
+TILT=NONE
+1 1000 1 5 3 1 2 0.1 0.1 0
+1.0 1.0 100
+0 45 90 135 180
+0 45 90
+100 80 50 20 0
+100 70 40 10 0
+100 60 30 5 0
+)";
+
+// Same profile as above with tilt data, which does not affect the result.
+const char kTypeCProfileTilt[] = R"(IESNA:LM-63-1995
+TILT=INCLUDE
+1
+3
+0 45 90
+1.0 0.9 0.8
+1 1000 1 5 3 1 2 0.1 0.1 0
+1.0 1.0 100
+0 45 90 135 180
+0 45 90
+100 80 50 20 0
+100 70 40 10 0
+100 60 30 5 0
+)";
+
+const char kIsotropicProfile[] = R"(IESNA:LM-63-2002
+TILT=NONE
+1 1000 1 3 1 1 2 0.1 0.1 0
+1.0 1.0 100
+0 90 180
+0
+7 7 7
+)";
+
+// Type B profile with a fan-shaped beam in the vertical plane through the aiming direction.
+const char kTypeBProfile[] = R"(IESNA:LM-63-2002
+TILT=NONE
+1 1000 1 3 2 2 2 0.1 0.1 0
+1.0 1.0 100
+-90 0 90
+0 90
+0 10 0 0 10 0
+)";
+
+/// Returns the candela value at the given angle indices of a canonical table.
+float getCandelas(const std::vector<float>& data, uint32_t verticalIndex, uint32_t horizontalIndex)
+{
+    uint32_t numVerticalAngles = uint32_t(data[3]);
+    uint32_t numHorizontalAngles = uint32_t(data[4]);
+    return data[kHeaderSize + numVerticalAngles + numHorizontalAngles + horizontalIndex * numVerticalAngles + verticalIndex];
+}
+} // namespace
+
+CPU_TEST(LightProfile_Parse)
+{
+    std::vector<float> data = LightProfile::parseIesProfile(kTypeCProfile, true);
+    EXPECT_EQ(data.size(), kHeaderSize + 5 + 3 + 15);
+    EXPECT_EQ(data[0], 0.01f); // Normalization factor.
+    EXPECT_EQ(getCandelas(data, 1, 2), 60.f);
+
+    EXPECT(LightProfile::parseIesProfile(kTypeCProfileTilt, true) == data);
+    EXPECT_EQ(LightProfile::parseIesProfile(kTypeCProfile, false)[0], 1.f);
+
+    // Type B profiles are resampled to type C in 1 degree steps, the aiming direction is mapped to nadir.
+    std::vector<float> typeB = LightProfile::parseIesProfile(kTypeBProfile, false);
+    EXPECT_EQ(typeB[3], 181.f);
+    EXPECT_EQ(typeB[4], 361.f);
+    EXPECT_EQ(typeB[5], 1.f);
+    EXPECT_EQ(getCandelas(typeB, 0, 0), 10.f);
+    EXPECT_LE(std::abs(getCandelas(typeB, 60, 0) - 10.f / 3.f), 1e-4f);
+    EXPECT_EQ(getCandelas(typeB, 60, 90), 10.f); // Rotated about the horizontal axis, where the measured beam is constant.
+    EXPECT_EQ(getCandelas(typeB, 120, 0), 0.f);
+
+    EXPECT_THROW(LightProfile::parseIesProfile("IESNA:LM-63-2002\nTILT=NONE\n1 2 3\n", true));
+    EXPECT_THROW(LightProfile::parseIesProfile("Unknown\nTILT=NONE\n", true));
+    EXPECT_THROW(LightProfile::parseIesProfile("IESNA:LM-63-2002\nTILT=lamp.tlt\n", true));
+}
+
+CPU_TEST(LightProfile_BakeCPU)
+{
+    // The flux factor of an isotropic profile is the solid angle of the sphere.
+    LightProfile::BakedProfile baked = LightProfile::bakeIesProfile(LightProfile::parseIesProfile(kIsotropicProfile, true));
+    EXPECT_EQ(baked.texels.size(), 256 * 256);
+    EXPECT_LE(std::abs(baked.fluxFactor - 4.f * float(M_PI)), 1e-3f);
+    for (uint16_t texel : baked.texels)
+        EXPECT_EQ(math::float16ToFloat32(texel), 1.f);
+}
+
+GPU_TEST(LightProfile_BakeMatchesGPU)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    RenderContext* pRenderContext = ctx.getRenderContext();
+
+    for (const char* profile : {kTypeCProfile, kIsotropicProfile, kTypeBProfile})
+    {
+        const auto path = getRuntimeDirectory() / "test_light_profile.ies";
+        std::ofstream(path) << profile;
+
+        ref<LightProfile> pCpuProfile = LightProfile::createFromIesProfile(pDevice, path, true);
+        ref<LightProfile> pGpuProfile = LightProfile::createFromIesProfile(pDevice, path, true);
+        std::filesystem::remove(path);
+        ASSERT(pCpuProfile && pGpuProfile);
+
+        pCpuProfile->bake(pRenderContext);
+        pGpuProfile->bakeOnGpu(pRenderContext);
+
+        EXPECT_LE(std::abs(pCpuProfile->getFluxFactor() - pGpuProfile->getFluxFactor()), 1e-4f * pGpuProfile->getFluxFactor());
+
+        std::vector<uint8_t> cpuTexels = pRenderContext->readTextureSubresource(pCpuProfile->getTexture().get(), 0);
+        std::vector<uint8_t> gpuTexels = pRenderContext->readTextureSubresource(pGpuProfile->getTexture().get(), 0);
+        ASSERT_EQ(cpuTexels.size(), gpuTexels.size());
+        const uint16_t* pCpu = reinterpret_cast<const uint16_t*>(cpuTexels.data());
+        const uint16_t* pGpu = reinterpret_cast<const uint16_t*>(gpuTexels.data());
+        for (size_t i = 0; i < cpuTexels.size() / sizeof(uint16_t); i++)
+            EXPECT_LE(std::abs(math::float16ToFloat32(pCpu[i]) - math::float16ToFloat32(pGpu[i])), 1e-3f) << "i = " << i;
+
+        // Profiles with identical data share the baked texture.
+        pGpuProfile->bake(pRenderContext);
+        EXPECT_EQ(pGpuProfile->getTexture(), pCpuProfile->getTexture());
+    }
+}
+
+CPU_TEST(LightProfile_Throughput, TAGS("benchmark"))
+{
+    // Parse and bake many distinct profiles, as in a scene with a large number of luminaire types.
+    const uint32_t kProfileCount = 500;
+    const uint32_t kVerticalAngles = 37;
+    const uint32_t kHorizontalAngles = 73;
+
+    std::vector<std::string> profiles(kProfileCount);
+    for (uint32_t i = 0; i < kProfileCount; i++)
+    {
+        std::string& text = profiles[i];
+        text = fmt::format("IESNA:LM-63-2002\nTILT=NONE\n1 1000 1 {} {} 1 2 0.1 0.1 0\n1.0 1.0 100\n", kVerticalAngles, kHorizontalAngles);
+        for (uint32_t v = 0; v < kVerticalAngles; v++)
+            text += fmt::format("{} ", v * 5);
+        text += "\n";
+        for (uint32_t h = 0; h < kHorizontalAngles; h++)
+            text += fmt::format("{} ", h * 5);
+        text += "\n";
+        for (uint32_t h = 0; h < kHorizontalAngles; h++)
+        {
+            for (uint32_t v = 0; v < kVerticalAngles; v++)
+                text += fmt::format("{:.2f} ", 100.f + i + std::cos(v * 0.1f) * 50.f + std::sin(h * 0.2f) * 10.f);
+            text += "\n";
+        }
+    }
+
+    auto start = CpuTimer::getCurrentTimePoint();
+    std::vector<std::vector<float>> data(kProfileCount);
+    for (uint32_t i = 0; i < kProfileCount; i++)
+        data[i] = LightProfile::parseIesProfile(profiles[i], true);
+    double parseMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    start = CpuTimer::getCurrentTimePoint();
+    float fluxSum = 0.f;
+    for (uint32_t i = 0; i < kProfileCount; i++)
+        fluxSum += LightProfile::bakeIesProfile(data[i]).fluxFactor;
+    double bakeMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    EXPECT_GT(fluxSum, 0.f);
+    logInfo("{} light profiles: parse {:.1f} ms, bake {:.1f} ms", kProfileCount, parseMs, bakeMs);
+}
+} // namespace Falcor
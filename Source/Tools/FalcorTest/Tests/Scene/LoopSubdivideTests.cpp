@@ -0,0 +1,215 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "PBRTImporter/LoopSubdivide.h"
+#include <cmath>
+
+namespace Falcor
+{
+namespace
+{
+// Reference results were generated with the original serial pbrt implementation.
+
+const std::vector<float3> kTetrahedronPositions = {{0.f, 0.f, 0.f}, {1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}};
+const std::vector<uint32_t> kTetrahedronIndices = {0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3};
+
+// Open triangle fan with boundary edges and non-planar vertices.
+const std::vector<float3> kFanPositions = {
+    {0.f, 0.f, 0.2f}, {1.f, 0.f, 0.f}, {0.3f, 1.f, 0.1f}, {-0.8f, 0.6f, -0.1f}, {-0.8f, -0.6f, 0.f}, {0.3f, -1.f, 0.3f},
+};
+const std::vector<uint32_t> kFanIndices = {0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 5};
+
+struct Reference
+{
+    std::vector<float3> positions;
+    std::vector<float3> normals;
+    std::vector<uint32_t> indices;
+};
+
+const Reference kTetrahedronLevel1 = {
+    {
+        {0.200000003f, 0.199999988f, 0.200000018f},
+        {0.399999976f, 0.200000018f, 0.199999988f},
+        {0.199999988f, 0.399999976f, 0.200000018f},
+        {0.200000018f, 0.199999988f, 0.399999976f},
+        {0.177083328f, 0.322916657f, 0.177083328f},
+        {0.322916657f, 0.322916687f, 0.177083328f},
+        {0.322916687f, 0.177083328f, 0.177083328f},
+        {0.322916687f, 0.177083328f, 0.322916657f},
+        {0.177083328f, 0.177083328f, 0.322916687f},
+        {0.177083328f, 0.322916657f, 0.322916687f},
+    },
+    {
+        {0.0184180867f, 0.0184180811f, 0.0184180774f},
+        {-0.0184180867f, 0.f, 0.f},
+        {0.f, -0.0184180867f, 0.f},
+        {0.f, 0.f, -0.0184180867f},
+        {0.0873543099f, 0.f, 0.0873543546f},
+        {-0.0873542577f, -0.0873543024f, 0.f},
+        {0.f, 0.0873542652f, 0.0873543024f},
+        {-0.0873543024f, 0.f, -0.0873542577f},
+        {0.0873542503f, 0.0873543173f, 0.f},
+        {0.f, -0.0873542577f, -0.087354295f},
+    },
+    {0, 4, 6, 4, 2, 5, 6, 5, 1, 4, 5, 6, 0, 6, 8, 6, 1, 7, 8, 7, 3, 6, 7, 8,
+     0, 8, 4, 8, 3, 9, 4, 9, 2, 8, 9, 4, 1, 5, 7, 5, 2, 9, 7, 9, 3, 5, 9, 7},
+};
+
+const Reference kFanLevel1 = {
+    {
+        {0.227500007f, -0.175000012f, 0.182500005f},
+        {0.702500045f, 0.175000012f, 0.0525000021f},
+        {0.230000004f, 0.755000055f, 0.0475000031f},
+        {-0.607500076f, 0.460000038f, -0.0475000031f},
+        {-0.607500076f, -0.460000038f, 0.0350000001f},
+        {0.0550000034f, -0.755000055f, 0.230000004f},
+        {0.490000039f, 0.f, 0.105000004f},
+        {0.597500026f, 0.490000039f, 0.0500000007f},
+        {0.147916675f, 0.414583325f, 0.0875000134f},
+        {-0.232500032f, 0.745000064f, 0.f},
+        {-0.329166681f, 0.25000003f, 0.0479166694f},
+        {-0.745000005f, 0.f, -0.0375000015f},
+        {-0.328125f, -0.274999976f, 0.101041667f},
+        {-0.257499993f, -0.745000064f, 0.144999996f},
+        {0.147500008f, -0.49000001f, 0.237499997f},
+    },
+    {
+        {-0.00632476062f, -0.141754061f, -0.540571511f},
+        {-0.0322000012f, -0.0120875016f, -0.170625001f},
+        {0.00682083331f, -0.0373041779f, -0.303477138f},
+        {0.0789604336f, -0.0384635404f, -0.314983398f},
+        {0.0829635561f, -0.0187906399f, -0.298321962f},
+        {0.0452000052f, -0.011037508f, -0.167475f},
+        {-0.175691664f, -0.135241672f, -1.00606251f},
+        {-0.101895861f, -0.0916708559f, -1.00466049f},
+        {0.0503720343f, -0.276002347f, -2.07738209f},
+        {0.210600048f, -0.18122296f, -1.29386067f},
+        {0.445620298f, -0.268064529f, -2.33543825f},
+        {0.350458384f, -0.114709392f, -1.27918363f},
+        {0.477297366f, -0.203874007f, -2.05047417f},
+        {0.265139639f, -0.0568385497f, -0.986781538f},
+        {0.235516682f, -0.151275009f, -0.991850078f},
+    },
+    {0, 6, 8, 6, 1, 7, 8, 7, 2, 6, 7, 8, 0, 8, 10, 8, 2, 9, 10, 9, 3, 8, 9, 10,
+     0, 10, 12, 10, 3, 11, 12, 11, 4, 10, 11, 12, 0, 12, 14, 12, 4, 13, 14, 13, 5, 12, 13, 14},
+};
+
+/// Summary of a subdivided mesh for levels that are too large to list.
+struct Checksum
+{
+    uint32_t level;
+    size_t vertexCount;
+    size_t indexCount;
+    uint64_t indexHash;
+    float3 positionSum;
+    float3 normalSum;
+};
+
+const Checksum kTetrahedronChecksums[] = {
+    {2, 34, 192, 0x070228d650c61a15ull, {37.4400406f, 37.4134712f, 35.8699837f}, {-0.272381961f, 0.162284032f, 0.157279357f}},
+    {3, 130, 768, 0x8b7f9d8344d69ccdull, {142.519409f, 147.356613f, 143.362213f}, {0.366916925f, 0.1821215f, 0.437523514f}},
+};
+
+const Checksum kFanChecksums[] = {
+    {2, 45, 192, 0x2bb47802855136cdull, {-6.47406769f, 5.24572706f, 17.0652084f}, {9.39259434f, -7.6027627f, -71.2867889f}},
+    {3, 153, 768, 0xdb7a39aba3fe18b0ull, {-38.669693f, 38.9294853f, 58.9366341f}, {10.481081f, -8.10823154f, -75.7153244f}},
+};
+
+bool isClose(float3 a, float3 b, float tolerance)
+{
+    return all(abs(a - b) <= float3(tolerance) * max(float3(1.f), abs(b)));
+}
+
+/// FNV-1a hash of the indices.
+uint64_t hashIndices(const std::vector<uint32_t>& indices)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t index : indices)
+    {
+        hash ^= index;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/// Weighted sum of the values, so that the order of the values matters.
+float3 weightedSum(const std::vector<float3>& values)
+{
+    float3 sum(0.f);
+    for (size_t i = 0; i < values.size(); ++i)
+        sum += values[i] * float(i % 8 + 1);
+    return sum;
+}
+
+void testLevel1(CPUUnitTestContext& ctx, const std::vector<float3>& positions, const std::vector<uint32_t>& indices, const Reference& ref)
+{
+    pbrt::LoopSubdivideResult result = pbrt::loopSubdivide(1, positions, indices);
+    EXPECT_EQ(result.levels, 1u);
+    EXPECT(result.indices == ref.indices);
+    ASSERT_EQ(result.positions.size(), ref.positions.size());
+    ASSERT_EQ(result.normals.size(), ref.normals.size());
+    for (size_t i = 0; i < ref.positions.size(); ++i)
+    {
+        EXPECT(isClose(result.positions[i], ref.positions[i], 1e-5f)) << "vertex " << i;
+        EXPECT(isClose(result.normals[i], ref.normals[i], 1e-5f)) << "vertex " << i;
+    }
+}
+
+void testChecksums(
+    CPUUnitTestContext& ctx,
+    const std::vector<float3>& positions,
+    const std::vector<uint32_t>& indices,
+    fstd::span<const Checksum> checksums
+)
+{
+    for (const Checksum& checksum : checksums)
+    {
+        pbrt::LoopSubdivideResult result = pbrt::loopSubdivide(checksum.level, positions, indices);
+        EXPECT_EQ(result.levels, checksum.level);
+        EXPECT_EQ(result.positions.size(), checksum.vertexCount) << "level " << checksum.level;
+        EXPECT_EQ(result.normals.size(), checksum.vertexCount) << "level " << checksum.level;
+        EXPECT_EQ(result.indices.size(), checksum.indexCount) << "level " << checksum.level;
+        EXPECT_EQ(hashIndices(result.indices), checksum.indexHash) << "level " << checksum.level;
+        EXPECT(isClose(weightedSum(result.positions), checksum.positionSum, 1e-4f)) << "level " << checksum.level;
+        EXPECT(isClose(weightedSum(result.normals), checksum.normalSum, 1e-4f)) << "level " << checksum.level;
+    }
+}
+} // namespace
+
+CPU_TEST(LoopSubdivide_Tetrahedron)
+{
+    testLevel1(ctx, kTetrahedronPositions, kTetrahedronIndices, kTetrahedronLevel1);
+    testChecksums(ctx, kTetrahedronPositions, kTetrahedronIndices, kTetrahedronChecksums);
+}
+
+CPU_TEST(LoopSubdivide_OpenMesh)
+{
+    testLevel1(ctx, kFanPositions, kFanIndices, kFanLevel1);
+    testChecksums(ctx, kFanPositions, kFanIndices, kFanChecksums);
+}
+} // namespace Falcor
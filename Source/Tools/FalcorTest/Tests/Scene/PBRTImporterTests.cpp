@@ -0,0 +1,123 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/SceneBuilder.h"
+#include "Core/Platform/OS.h"
+#include <fstream>
+#include <map>
+#include <string>
+
+namespace Falcor
+{
+namespace
+{
+void writeFile(const std::filesystem::path& path, const std::string& text)
+{
+    std::ofstream file(path);
+    file << text;
+}
+
+std::string triangle(float x)
+{
+    return fmt::format("Shape \"trianglemesh\" \"point3 P\" [ {0} 0 0  {1} 0 0  {0} 1 0 ] \"integer indices\" [ 0 1 2 ]\n", x, x + 1.f);
+}
+} // namespace
+
+GPU_TEST(PBRTImporter_ImportInheritsMaterial)
+{
+    // Include and Import files are parsed in parallel into separate scenes. Shapes in them use the current unnamed
+    // material of the including file until they define their own.
+    std::filesystem::path directory = getTempFilePath();
+    std::filesystem::remove(directory);
+    std::filesystem::create_directories(directory);
+
+    writeFile(directory / "shapes.pbrt", triangle(0.f));
+    writeFile(
+        directory / "import.pbrt",
+        triangle(2.f) + "Material \"diffuse\" \"rgb reflectance\" [ 0 0 1 ]\n" + triangle(4.f)
+    );
+    writeFile(
+        directory / "main.pbrt",
+        "LookAt 0 0 5  0 0 0  0 1 0\n"
+        "Camera \"perspective\"\n"
+        "WorldBegin\n"
+        "Material \"diffuse\" \"rgb reflectance\" [ 1 0 0 ]\n"
+        "Material \"diffuse\" \"rgb reflectance\" [ 0 1 0 ]\n"
+        "Include \"shapes.pbrt\"\n"
+        "Import \"import.pbrt\"\n" +
+            triangle(6.f)
+    );
+
+    {
+        SceneBuilder builder(ctx.getDevice(), directory / "main.pbrt", Settings(), SceneBuilder::Flags::DontMergeMaterials);
+        ref<Scene> pScene = builder.getScene();
+        ASSERT(pScene);
+
+        std::map<std::string, uint32_t> instancesPerMaterial;
+        for (uint32_t i = 0; i < pScene->getGeometryInstanceCount(); ++i)
+        {
+            const auto& instance = pScene->getGeometryInstance(i);
+            instancesPerMaterial[pScene->getMaterial(MaterialID(instance.materialID))->getName()]++;
+        }
+        EXPECT_EQ(pScene->getGeometryInstanceCount(), 4u);
+        EXPECT_EQ(instancesPerMaterial["Unnamed1"], 3u);
+        EXPECT_EQ(instancesPerMaterial["Unnamed2"], 1u);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+GPU_TEST(PBRTImporter_ShareIdenticalMeshes)
+{
+    // Triangle meshes with identical content and material are added once and shared. Meshes that are offset by a tiny
+    // amount are not shared.
+    std::filesystem::path directory = getTempFilePath();
+    std::filesystem::remove(directory);
+    std::filesystem::create_directories(directory);
+
+    writeFile(
+        directory / "main.pbrt",
+        "LookAt 0 0 5  0 0 0  0 1 0\n"
+        "Camera \"perspective\"\n"
+        "WorldBegin\n"
+        "Material \"diffuse\" \"rgb reflectance\" [ 1 0 0 ]\n" +
+            triangle(0.f) + triangle(0.f) + triangle(0.f) + triangle(1e-6f) + triangle(1e-6f) + triangle(2.f)
+    );
+
+    {
+        SceneBuilder builder(ctx.getDevice(), directory / "main.pbrt", Settings());
+        ref<Scene> pScene = builder.getScene();
+        ASSERT(pScene);
+
+        EXPECT_EQ(pScene->getGeometryInstanceCount(), 6u);
+        EXPECT_EQ(pScene->getMeshCount(), 3u);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+} // namespace Falcor
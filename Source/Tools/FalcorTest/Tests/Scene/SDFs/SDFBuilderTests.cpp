@@ -0,0 +1,189 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/SDFs/SparseVoxelOctree/SDFSVO.h"
+#include "Scene/SDFs/SparseBrickSet/SDFSBS.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <cstring>
+
+namespace Falcor
+{
+namespace
+{
+/// Creates the corner values of an off-center sphere, in grid local space [-0.5, 0.5]^3.
+std::vector<float> createSphereValues(uint32_t gridWidth, float radius)
+{
+    const uint32_t gridWidthInValues = gridWidth + 1;
+    const float3 center(-0.07f, 0.f, 0.05f);
+    std::vector<float> values(size_t(gridWidthInValues) * gridWidthInValues * gridWidthInValues);
+    for (uint32_t z = 0; z < gridWidthInValues; z++)
+    {
+        for (uint32_t y = 0; y < gridWidthInValues; y++)
+        {
+            for (uint32_t x = 0; x < gridWidthInValues; x++)
+            {
+                float3 p = float3(x, y, z) / float(gridWidth) - 0.5f;
+                values[x + gridWidthInValues * (y + size_t(gridWidthInValues) * z)] = length(p - center) - radius;
+            }
+        }
+    }
+    return values;
+}
+
+void testSVO(GPUUnitTestContext& ctx, uint32_t gridWidth)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    std::vector<float> values = createSphereValues(gridWidth, 0.3f);
+
+    ref<SDFSVO> pGPUSVO = SDFSVO::create(pDevice);
+    pGPUSVO->setValues(values, gridWidth);
+    pGPUSVO->createResources(ctx.getRenderContext());
+
+    ref<SDFSVO> pCPUSVO = SDFSVO::create(pDevice);
+    pCPUSVO->setValues(values, gridWidth);
+    pCPUSVO->buildOctreeOnCPU();
+    std::vector<SDFSVOVoxel> cpuOctree = pCPUSVO->getCPUOctree();
+    ASSERT_GT(cpuOctree.size(), 0u);
+
+    // The uploaded octree must be identical to the octree built on the GPU.
+    pCPUSVO->createResources(ctx.getRenderContext());
+    EXPECT(pCPUSVO->getCPUOctree().empty());
+    EXPECT_EQ(pCPUSVO->getSVOIndexBitCount(), pGPUSVO->getSVOIndexBitCount());
+
+    std::vector<SDFSVOVoxel> gpuOctree = pGPUSVO->getSVOBuffer()->getElements<SDFSVOVoxel>(0, (uint32_t)cpuOctree.size());
+    std::vector<SDFSVOVoxel> uploadedOctree = pCPUSVO->getSVOBuffer()->getElements<SDFSVOVoxel>(0, (uint32_t)cpuOctree.size());
+    for (size_t i = 0; i < cpuOctree.size(); i++)
+    {
+        EXPECT_EQ(cpuOctree[i].relationData, gpuOctree[i].relationData) << "i = " << i;
+        EXPECT(all(cpuOctree[i].locationCode == gpuOctree[i].locationCode)) << "i = " << i;
+        EXPECT(all(cpuOctree[i].packedValues == gpuOctree[i].packedValues)) << "i = " << i;
+        EXPECT_EQ(cpuOctree[i].relationData, uploadedOctree[i].relationData) << "i = " << i;
+    }
+}
+
+void testSBS(GPUUnitTestContext& ctx, uint32_t gridWidth, uint32_t brickWidth, bool compressed)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    RenderContext* pRenderContext = ctx.getRenderContext();
+    std::vector<float> values = createSphereValues(gridWidth, 0.3f);
+
+    ref<SDFSBS> pGPUSBS = SDFSBS::create(pDevice, brickWidth, compressed);
+    pGPUSBS->setValues(values, gridWidth);
+    pGPUSBS->createResources(pRenderContext);
+
+    ref<SDFSBS> pCPUSBS = SDFSBS::create(pDevice, brickWidth, compressed);
+    pCPUSBS->setValues(values, gridWidth);
+    pCPUSBS->buildBricksOnCPU();
+    SDFSBS::CPUBricks bricks = pCPUSBS->getCPUBricks();
+    pCPUSBS->createResources(pRenderContext);
+
+    ASSERT_EQ(bricks.brickCount, pGPUSBS->getAABBCount());
+    ASSERT_EQ(pCPUSBS->getAABBCount(), pGPUSBS->getAABBCount());
+    ASSERT_GT(bricks.brickCount, 0u);
+
+    std::vector<uint8_t> indirection = pRenderContext->readTextureSubresource(pGPUSBS->getIndirectionTexture().get(), 0);
+    ASSERT_EQ(indirection.size(), bricks.indirection.size() * sizeof(uint32_t));
+    EXPECT(std::memcmp(indirection.data(), bricks.indirection.data(), indirection.size()) == 0);
+
+    std::vector<AABB> aabbs = pGPUSBS->getAABBBuffer()->getElements<AABB>(0, bricks.brickCount);
+    for (uint32_t i = 0; i < bricks.brickCount; i++)
+    {
+        EXPECT(all(aabbs[i].minPoint == bricks.brickAABBs[i].minPoint)) << "brick = " << i;
+        EXPECT(all(aabbs[i].maxPoint == bricks.brickAABBs[i].maxPoint)) << "brick = " << i;
+    }
+
+    // Compare the brick texture in the bricks, the remaining texels are not written by the GPU.
+    ref<Texture> pBrickTexture = pGPUSBS->getBrickTexture();
+    ASSERT_EQ(pBrickTexture->getWidth(), bricks.brickTextureDimensions.x);
+    ASSERT_EQ(pBrickTexture->getHeight(), bricks.brickTextureDimensions.y);
+    std::vector<uint8_t> brickTexture = pRenderContext->readTextureSubresource(pBrickTexture.get(), 0);
+    ASSERT_EQ(brickTexture.size(), bricks.brickTexture.size());
+
+    const uint32_t elementWidth = compressed ? 4 : 1;
+    const uint32_t elementSize = compressed ? sizeof(uint64_t) : 1;
+    const uint32_t rowPitch = bricks.brickTextureDimensions.x / elementWidth * elementSize;
+    const uint32_t brickWidthInValues = brickWidth + 1;
+    for (uint32_t brickID = 0; brickID < bricks.brickCount; brickID++)
+    {
+        uint2 brickTextureCoords = uint2(brickID % bricks.bricksPerAxis.x, brickID / bricks.bricksPerAxis.x) * uint2(brickWidthInValues * brickWidthInValues, brickWidthInValues);
+        for (uint32_t y = 0; y < brickWidthInValues; y += elementWidth)
+        {
+            size_t offset = (brickTextureCoords.y + y) / elementWidth * rowPitch + brickTextureCoords.x / elementWidth * elementSize;
+            size_t size = brickWidthInValues * brickWidthInValues / elementWidth * elementSize;
+            EXPECT(std::memcmp(brickTexture.data() + offset, bricks.brickTexture.data() + offset, size) == 0) << "brick = " << brickID << ", y = " << y;
+        }
+    }
+}
+} // namespace
+
+GPU_TEST(SDFSVO_CPUBuild)
+{
+    testSVO(ctx, 32);
+    testSVO(ctx, 128);
+}
+
+GPU_TEST(SDFSBS_CPUBuild)
+{
+    testSBS(ctx, 64, 7, false);
+    testSBS(ctx, 100, 3, false);
+}
+
+GPU_TEST(SDFSBS_CPUBuildCompressed)
+{
+    testSBS(ctx, 64, 7, true);
+    testSBS(ctx, 100, 3, true);
+}
+
+GPU_TEST(SDFBuilders_Throughput, TAGS("benchmark"))
+{
+    ref<Device> pDevice = ctx.getDevice();
+    const uint32_t kGridWidth = 256;
+    std::vector<float> values = createSphereValues(kGridWidth, 0.3f);
+
+    ref<SDFSVO> pSVO = SDFSVO::create(pDevice);
+    pSVO->setValues(values, kGridWidth);
+    auto start = CpuTimer::getCurrentTimePoint();
+    pSVO->buildOctreeOnCPU();
+    double svoMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    ref<SDFSBS> pSBS = SDFSBS::create(pDevice);
+    pSBS->setValues(values, kGridWidth);
+    start = CpuTimer::getCurrentTimePoint();
+    pSBS->buildBricksOnCPU();
+    double sbsMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    logInfo(
+        "SDF grid {}^3: SVO with {} voxels built in {:.1f} ms, SBS with {} bricks built in {:.1f} ms",
+        kGridWidth,
+        pSVO->getCPUOctree().size(),
+        svoMs,
+        pSBS->getCPUBricks().brickCount,
+        sbsMs
+    );
+}
+} // namespace Falcor
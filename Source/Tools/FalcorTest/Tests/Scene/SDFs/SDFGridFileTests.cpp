@@ -0,0 +1,200 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/SDFs/SDFGridFile.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+/// Creates the corner values of a sphere centered in the grid, in grid local space [-0.5, 0.5]^3.
+std::vector<float> createSphereValues(uint32_t gridWidth, float radius)
+{
+    const uint32_t gridWidthInValues = gridWidth + 1;
+    std::vector<float> values(size_t(gridWidthInValues) * gridWidthInValues * gridWidthInValues);
+    for (uint32_t z = 0; z < gridWidthInValues; z++)
+    {
+        for (uint32_t y = 0; y < gridWidthInValues; y++)
+        {
+            for (uint32_t x = 0; x < gridWidthInValues; x++)
+            {
+                float3 p = float3(x, y, z) / float(gridWidth) - 0.5f;
+                values[x + gridWidthInValues * (y + size_t(gridWidthInValues) * z)] = length(p) - radius;
+            }
+        }
+    }
+    return values;
+}
+
+void writeDenseFile(const std::filesystem::path& path, const std::vector<float>& values, uint32_t gridWidth)
+{
+    std::ofstream file(path, std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&gridWidth), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(float));
+}
+} // namespace
+
+CPU_TEST(SDFGridFile_ConvertDense)
+{
+    const uint32_t kGridWidth = 64;
+    const auto densePath = getRuntimeDirectory() / "test_sdf_grid_dense.sdfg";
+    const auto sparsePath = getRuntimeDirectory() / "test_sdf_grid_sparse.sdfg";
+
+    std::vector<float> values = createSphereValues(kGridWidth, 0.3f);
+    writeDenseFile(densePath, values, kGridWidth);
+    EXPECT(!SDFGridFile::isSparseFile(densePath));
+
+    ASSERT(SDFGridFile::convertDenseToSparse(densePath, sparsePath));
+    EXPECT(SDFGridFile::isSparseFile(sparsePath));
+    EXPECT_GE(std::filesystem::file_size(densePath), 10 * std::filesystem::file_size(sparsePath));
+
+    SDFGridFile::Header header;
+    std::vector<int8_t> normalizedValues;
+    ASSERT(SDFGridFile::readSparse(sparsePath, header, normalizedValues));
+    EXPECT_EQ(header.gridWidth, kGridWidth);
+    EXPECT_EQ(header.bandWidth, SDFGridFile::getDefaultBandWidth(kGridWidth));
+    EXPECT_GT(header.brickCount, 0u);
+    ASSERT_EQ(normalizedValues.size(), values.size());
+
+    // Only the quantization is lossy, the values match the quantized dense values exactly.
+    size_t mismatchCount = 0;
+    for (size_t v = 0; v < values.size(); v++)
+    {
+        if (normalizedValues[v] != SDFGridFile::quantize(values[v], header.bandWidth))
+            mismatchCount++;
+    }
+    EXPECT_EQ(mismatchCount, 0u);
+
+    std::filesystem::remove(densePath);
+    std::filesystem::remove(sparsePath);
+}
+
+CPU_TEST(SDFGridFile_WriteSparse)
+{
+    // Use a grid width that is not a multiple of the brick width, and a band that covers several voxels.
+    const uint32_t kGridWidth = 20;
+    const float kBandWidth = 0.1f;
+    const auto path = getRuntimeDirectory() / "test_sdf_grid_write_sparse.sdfg";
+
+    std::vector<float> values = createSphereValues(kGridWidth, 0.25f);
+    ASSERT(SDFGridFile::writeSparse(path, values, kGridWidth, kBandWidth));
+    EXPECT(!SDFGridFile::writeSparse(path, values, kGridWidth + 1, kBandWidth));
+
+    SDFGridFile::Header header;
+    std::vector<int8_t> normalizedValues;
+    ASSERT(SDFGridFile::readSparse(path, header, normalizedValues));
+    EXPECT_EQ(header.gridWidth, kGridWidth);
+    EXPECT_EQ(header.bandWidth, kBandWidth);
+    ASSERT_EQ(normalizedValues.size(), values.size());
+
+    size_t mismatchCount = 0;
+    for (size_t v = 0; v < values.size(); v++)
+    {
+        if (normalizedValues[v] != SDFGridFile::quantize(values[v], kBandWidth))
+            mismatchCount++;
+    }
+    EXPECT_EQ(mismatchCount, 0u);
+
+    std::filesystem::remove(path);
+}
+
+CPU_TEST(SDFGridFile_Invalid)
+{
+    const uint32_t kGridWidth = 32;
+    const auto path = getRuntimeDirectory() / "test_sdf_grid_invalid.sdfg";
+
+    SDFGridFile::Header header;
+    std::vector<int8_t> normalizedValues;
+    EXPECT(!SDFGridFile::readSparse(getRuntimeDirectory() / "test_sdf_grid_missing.sdfg", header, normalizedValues));
+
+    // Truncate a valid file.
+    ASSERT(SDFGridFile::writeSparse(path, createSphereValues(kGridWidth, 0.3f), kGridWidth));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    EXPECT(SDFGridFile::isSparseFile(path));
+    EXPECT(!SDFGridFile::readSparse(path, header, normalizedValues));
+
+    // Dense files are not sparse files.
+    writeDenseFile(path, createSphereValues(kGridWidth, 0.3f), kGridWidth);
+    EXPECT(!SDFGridFile::isSparseFile(path));
+    EXPECT(!SDFGridFile::readSparse(path, header, normalizedValues));
+
+    std::filesystem::remove(path);
+}
+
+CPU_TEST(SDFGridFile_Throughput, TAGS("benchmark"))
+{
+    // Compare loading and quantizing dense float files with decoding sparse files.
+    for (uint32_t gridWidth : {256u, 512u})
+    {
+        const auto densePath = getRuntimeDirectory() / fmt::format("test_sdf_grid_dense_{}.sdfg", gridWidth);
+        const auto sparsePath = getRuntimeDirectory() / fmt::format("test_sdf_grid_sparse_{}.sdfg", gridWidth);
+        writeDenseFile(densePath, createSphereValues(gridWidth, 0.3f), gridWidth);
+
+        auto start = CpuTimer::getCurrentTimePoint();
+        ASSERT(SDFGridFile::convertDenseToSparse(densePath, sparsePath));
+        double convertMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+        start = CpuTimer::getCurrentTimePoint();
+        std::vector<int8_t> denseValues;
+        {
+            std::ifstream file(densePath, std::ios::in | std::ios::binary);
+            uint32_t width = 0;
+            file.read(reinterpret_cast<char*>(&width), sizeof(uint32_t));
+            std::vector<float> values(size_t(width + 1) * (width + 1) * (width + 1));
+            file.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(float));
+            float bandWidth = SDFGridFile::getDefaultBandWidth(width);
+            denseValues.resize(values.size());
+            for (size_t v = 0; v < values.size(); v++)
+                denseValues[v] = SDFGridFile::quantize(values[v], bandWidth);
+        }
+        double denseMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+        start = CpuTimer::getCurrentTimePoint();
+        SDFGridFile::Header header;
+        std::vector<int8_t> sparseValues;
+        ASSERT(SDFGridFile::readSparse(sparsePath, header, sparseValues));
+        double sparseMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        EXPECT(sparseValues == denseValues);
+
+        logInfo(
+            "SDF grid {}^3: dense {:.1f} MB in {:.1f} ms, sparse {:.2f} MB in {:.1f} ms, conversion {:.1f} ms",
+            gridWidth,
+            std::filesystem::file_size(densePath) / 1e6,
+            denseMs,
+            std::filesystem::file_size(sparsePath) / 1e6,
+            sparseMs,
+            convertMs
+        );
+
+        std::filesystem::remove(densePath);
+        std::filesystem::remove(sparsePath);
+    }
+}
+} // namespace Falcor
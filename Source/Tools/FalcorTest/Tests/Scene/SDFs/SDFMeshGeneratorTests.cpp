@@ -0,0 +1,160 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/SDFs/SDFGridFile.h"
+#include "Scene/SDFs/SDFMeshGenerator.h"
+#include "Scene/TriangleMesh.h"
+#include "Utils/Timing/CpuTimer.h"
+
+namespace Falcor
+{
+namespace
+{
+void appendMesh(const TriangleMesh& mesh, const float3& offset, std::vector<float3>& positions, std::vector<uint32_t>& indices)
+{
+    uint32_t baseIndex = (uint32_t)positions.size();
+    for (const auto& vertex : mesh.getVertices())
+        positions.push_back(vertex.position + offset);
+    for (uint32_t index : mesh.getIndices())
+        indices.push_back(baseIndex + index);
+}
+
+float sdSphere(const float3& p, const float3& center, float radius)
+{
+    return length(p - center) - radius;
+}
+
+float sdBox(const float3& p, const float3& center, float halfExtent)
+{
+    float3 d = abs(p - center) - halfExtent;
+    return length(max(d, float3(0.f))) + std::min(std::max(std::max(d.x, d.y), d.z), 0.f);
+}
+} // namespace
+
+CPU_TEST(SDFMeshGenerator_Sphere)
+{
+    const float kRadius = 0.3f;
+    const uint32_t kGridWidth = 64;
+
+    std::vector<float3> positions;
+    std::vector<uint32_t> indices;
+    appendMesh(*TriangleMesh::createSphere(kRadius, 128, 64), float3(0.f), positions, indices);
+
+    SDFMeshGenerator generator(positions, indices);
+    SDFMeshGenerator::NarrowBand narrowBand = generator.generate(kGridWidth, 0.05f);
+    EXPECT_EQ(narrowBand.bandWidth, 0.05f);
+    EXPECT_LT(narrowBand.getBrickCount(), narrowBand.brickSlots.size());
+
+    // Distances within the band match the analytic sphere up to the tessellation error, the signs match everywhere.
+    std::vector<float> values = narrowBand.toDense();
+    ASSERT_EQ(values.size(), (kGridWidth + 1) * (kGridWidth + 1) * (kGridWidth + 1));
+    for (uint32_t z = 0; z <= kGridWidth; z++)
+    {
+        for (uint32_t y = 0; y <= kGridWidth; y++)
+        {
+            for (uint32_t x = 0; x <= kGridWidth; x++)
+            {
+                float3 p = float3(x, y, z) / float(kGridWidth) - 0.5f;
+                float expected = std::clamp(sdSphere(p, float3(0.f), kRadius), -narrowBand.bandWidth, narrowBand.bandWidth);
+                float value = values[x + (kGridWidth + 1) * (y + (kGridWidth + 1) * z)];
+                EXPECT_LE(std::abs(value - expected), 1e-3f) << "corner = (" << x << ", " << y << ", " << z << ")";
+                EXPECT_EQ(value, narrowBand.getValue(uint3(x, y, z)));
+            }
+        }
+    }
+
+    // Normalized values are the quantized dense values, a narrower normalization width saturates more values.
+    for (float normalizationWidth : {0.05f, 0.02f})
+    {
+        std::vector<int8_t> normalizedValues = narrowBand.toNormalized(normalizationWidth);
+        ASSERT_EQ(normalizedValues.size(), values.size());
+        for (size_t v = 0; v < values.size(); v++)
+        {
+            EXPECT_EQ(normalizedValues[v], SDFGridFile::quantize(values[v], normalizationWidth)) << "value = " << v;
+        }
+    }
+}
+
+CPU_TEST(SDFMeshGenerator_Signs)
+{
+    // Disjoint shapes with the thinnest narrow band, so that most signs are propagated outside of the band.
+    std::vector<float3> positions;
+    std::vector<uint32_t> indices;
+    appendMesh(*TriangleMesh::createCube(float3(0.4f)), float3(-0.2f, 0.f, 0.f), positions, indices);
+    appendMesh(*TriangleMesh::createSphere(0.15f, 64, 32), float3(0.25f, 0.1f, 0.f), positions, indices);
+
+    SDFMeshGenerator generator(positions, indices);
+    for (uint32_t gridWidth : {32u, 100u, 128u})
+    {
+        SDFMeshGenerator::NarrowBand narrowBand = generator.generate(gridWidth, 0.f);
+        EXPECT_EQ(narrowBand.bandWidth, 2.f / gridWidth);
+
+        for (uint32_t z = 0; z <= gridWidth; z++)
+        {
+            for (uint32_t y = 0; y <= gridWidth; y++)
+            {
+                for (uint32_t x = 0; x <= gridWidth; x++)
+                {
+                    float3 p = float3(x, y, z) / float(gridWidth) - 0.5f;
+                    float expected = std::min(sdBox(p, float3(-0.2f, 0.f, 0.f), 0.2f), sdSphere(p, float3(0.25f, 0.1f, 0.f), 0.15f));
+                    if (std::abs(expected) < 2e-3f)
+                        continue;
+                    EXPECT_EQ(narrowBand.getValue(uint3(x, y, z)) < 0.f, expected < 0.f)
+                        << "gridWidth = " << gridWidth << ", corner = (" << x << ", " << y << ", " << z << ")";
+                }
+            }
+        }
+    }
+
+    // Without a surface, all values are outside.
+    SDFMeshGenerator::NarrowBand empty = SDFMeshGenerator({}, {}).generate(16, 0.f);
+    EXPECT_EQ(empty.getBrickCount(), 0);
+    EXPECT_EQ(empty.getValue(uint3(8)), empty.bandWidth);
+}
+
+CPU_TEST(SDFMeshGenerator_Scaling, TAGS("benchmark"))
+{
+    std::vector<float3> positions;
+    std::vector<uint32_t> indices;
+    appendMesh(*TriangleMesh::createSphere(0.4f, 512, 256), float3(0.f), positions, indices);
+
+    auto start = CpuTimer::getCurrentTimePoint();
+    SDFMeshGenerator generator(positions, indices);
+    double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    logInfo("SDFMeshGenerator: BVH for {} triangles built in {:.1f} ms", generator.getTriangleCount(), ms);
+
+    for (uint32_t gridWidth : {256u, 512u, 1024u, 2048u})
+    {
+        start = CpuTimer::getCurrentTimePoint();
+        SDFMeshGenerator::NarrowBand narrowBand = generator.generate(gridWidth, 0.f);
+        ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        EXPECT_GT(narrowBand.getBrickCount(), 0);
+        logInfo("SDFMeshGenerator: grid width {}, {} bricks in {:.1f} ms", gridWidth, narrowBand.getBrickCount(), ms);
+    }
+}
+} // namespace Falcor
@@ -0,0 +1,216 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "MitsubaImporter/SerializedMesh.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+const uint32_t kHasNormals = 0x0001;
+const uint32_t kHasTexCoords = 0x0002;
+
+const std::vector<float3> kPositions = {{0.f, 0.f, 0.f}, {1.f, 0.f, 0.f}, {1.f, 1.f, 0.f}, {0.f, 1.f, 0.f}};
+const std::vector<float3> kNormals = {{0.f, 0.f, 1.f}, {0.f, 1.f, 0.f}, {1.f, 0.f, 0.f}, {0.f, 0.f, -1.f}};
+const std::vector<float2> kTexCoords = {{0.f, 0.f}, {1.f, 0.f}, {1.f, 1.f}, {0.f, 1.f}};
+const std::vector<uint32_t> kIndices = {0, 1, 2, 0, 2, 3};
+
+template<typename T>
+void append(std::vector<uint8_t>& data, const T& value)
+{
+    const uint8_t* pValue = reinterpret_cast<const uint8_t*>(&value);
+    data.insert(data.end(), pValue, pValue + sizeof(T));
+}
+
+template<typename T>
+void append(std::vector<uint8_t>& data, const std::vector<T>& values)
+{
+    const uint8_t* pValues = reinterpret_cast<const uint8_t*>(values.data());
+    data.insert(data.end(), pValues, pValues + values.size() * sizeof(T));
+}
+
+/// Creates the compressed data of a version 4 mesh, without the mesh header.
+std::vector<uint8_t> compressMesh(const std::string& name, uint32_t flags, const std::vector<uint32_t>& indices)
+{
+    std::vector<uint8_t> data;
+    append(data, flags);
+    data.insert(data.end(), name.begin(), name.end());
+    data.push_back(0);
+    append(data, uint64_t(kPositions.size()));
+    append(data, uint64_t(indices.size() / 3));
+    append(data, kPositions);
+    if (flags & kHasNormals)
+        append(data, kNormals);
+    if (flags & kHasTexCoords)
+        append(data, kTexCoords);
+    append(data, indices);
+
+    uLongf compressedSize = compressBound((uLong)data.size());
+    std::vector<uint8_t> compressed(compressedSize);
+    FALCOR_CHECK(compress(compressed.data(), &compressedSize, data.data(), (uLong)data.size()) == Z_OK, "Failed to compress mesh.");
+    compressed.resize(compressedSize);
+    return compressed;
+}
+
+/// Creates a version 4 .serialized file from the compressed meshes.
+std::vector<uint8_t> createFile(const std::vector<std::vector<uint8_t>>& meshes)
+{
+    std::vector<uint8_t> data;
+    std::vector<uint64_t> offsets;
+    for (const auto& mesh : meshes)
+    {
+        offsets.push_back(data.size());
+        append(data, uint16_t(0x041C));
+        append(data, uint16_t(4));
+        append(data, mesh);
+    }
+    append(data, offsets);
+    append(data, uint32_t(meshes.size()));
+    return data;
+}
+
+template<typename T>
+bool isEqual(const std::vector<T>& a, const std::vector<T>& b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const T& x, const T& y) { return all(x == y); });
+}
+
+std::filesystem::path writeFile(const std::vector<uint8_t>& data)
+{
+    const auto path = getRuntimeDirectory() / "test_mesh.serialized";
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return path;
+}
+} // namespace
+
+CPU_TEST(SerializedMesh_Load)
+{
+    const auto path = writeFile(createFile({
+        compressMesh("quad", kHasNormals | kHasTexCoords, kIndices),
+        compressMesh("plain", 0, kIndices),
+    }));
+
+    {
+        Mitsuba::SerializedFile file(path);
+        ASSERT_EQ(file.getMeshCount(), 2u);
+
+        Mitsuba::SerializedMesh mesh = file.loadMesh(0, false);
+        EXPECT_EQ(mesh.name, "quad");
+        EXPECT(isEqual(mesh.positions, kPositions));
+        EXPECT(isEqual(mesh.normals, kNormals));
+        EXPECT(isEqual(mesh.texCoords, kTexCoords));
+        EXPECT(mesh.indices == kIndices);
+        EXPECT(!mesh.faceNormals);
+
+        // Meshes without normals get smooth vertex normals.
+        mesh = file.loadMesh(1, false);
+        EXPECT_EQ(mesh.name, "plain");
+        EXPECT(isEqual(mesh.positions, kPositions));
+        EXPECT(mesh.texCoords.empty());
+        EXPECT(mesh.indices == kIndices);
+        ASSERT_EQ(mesh.normals.size(), kPositions.size());
+        for (const float3& n : mesh.normals)
+            EXPECT(all(n == float3(0.f, 0.f, 1.f))) << to_string(n);
+
+        // Face normals replace the stored vertex normals.
+        mesh = file.loadMesh(0, true);
+        EXPECT(mesh.faceNormals);
+        ASSERT_EQ(mesh.normals.size(), kIndices.size() / 3);
+        for (const float3& n : mesh.normals)
+            EXPECT(all(n == float3(0.f, 0.f, 1.f))) << to_string(n);
+
+        // Loading in parallel returns the meshes in request order.
+        auto meshes = Mitsuba::SerializedFile::loadMeshes({{&file, 1, false}, {&file, 0, false}});
+        ASSERT_EQ(meshes.size(), 2u);
+        EXPECT_EQ(meshes[0].name, "plain");
+        EXPECT_EQ(meshes[1].name, "quad");
+
+        EXPECT_THROW(file.loadMesh(2, false));
+    }
+
+    std::filesystem::remove(path);
+}
+
+CPU_TEST(SerializedMesh_Errors)
+{
+    const std::vector<uint8_t> mesh = compressMesh("quad", kHasNormals | kHasTexCoords, kIndices);
+    const std::vector<uint8_t> valid = createFile({mesh});
+    std::filesystem::path path;
+
+    // Too small to hold the file header and mesh count.
+    path = writeFile(std::vector<uint8_t>(valid.begin(), valid.begin() + 6));
+    EXPECT_THROW((Mitsuba::SerializedFile(path)));
+
+    // Invalid format identifier.
+    std::vector<uint8_t> data = valid;
+    data[0] = 0;
+    path = writeFile(data);
+    EXPECT_THROW((Mitsuba::SerializedFile(path)));
+
+    // Unsupported version.
+    data = valid;
+    data[2] = 5;
+    path = writeFile(data);
+    EXPECT_THROW((Mitsuba::SerializedFile(path)));
+
+    // Mesh offset pointing past the offset table.
+    data = valid;
+    const uint64_t badOffset = data.size();
+    std::memcpy(data.data() + data.size() - 12, &badOffset, sizeof(badOffset));
+    path = writeFile(data);
+    EXPECT_THROW((Mitsuba::SerializedFile(path)));
+
+    // Mesh count larger than the offset table.
+    data = valid;
+    const uint32_t badCount = 1000;
+    std::memcpy(data.data() + data.size() - 4, &badCount, sizeof(badCount));
+    path = writeFile(data);
+    EXPECT_THROW((Mitsuba::SerializedFile(path)));
+
+    // Truncated compressed data. The file opens but the mesh fails to load.
+    path = writeFile(createFile({std::vector<uint8_t>(mesh.begin(), mesh.begin() + mesh.size() / 2)}));
+    {
+        Mitsuba::SerializedFile file(path);
+        EXPECT_THROW(file.loadMesh(0, false));
+    }
+
+    // Vertex index out of range.
+    path = writeFile(createFile({compressMesh("quad", 0, {0, 1, 4})}));
+    {
+        Mitsuba::SerializedFile file(path);
+        EXPECT_THROW(file.loadMesh(0, false));
+    }
+
+    std::filesystem::remove(path);
+}
+} // namespace Falcor
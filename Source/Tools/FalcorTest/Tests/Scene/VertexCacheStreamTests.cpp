@@ -0,0 +1,253 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Animation/VertexCacheStream.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <cstring>
+#include <memory>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+/// Vertex record with the same layout as PackedStaticVertexData.
+struct Vertex
+{
+    float3 position;
+    uint32_t packedNormal;
+    uint32_t packedTangent[2];
+    float2 texCrd;
+};
+
+/// Creates keyframes of vertices moving smoothly over time, with some words changing between keyframes.
+std::vector<std::vector<Vertex>> createKeyframes(uint32_t vertexCount, uint32_t keyframeCount, std::vector<double>& timeSamples)
+{
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> u(-1.f, 1.f);
+
+    std::vector<Vertex> base(vertexCount);
+    for (auto& v : base)
+    {
+        v.position = float3(u(rng), u(rng), u(rng)) * 10.f;
+        v.packedNormal = rng();
+        v.packedTangent[0] = rng();
+        v.packedTangent[1] = rng();
+        v.texCrd = float2(u(rng), u(rng));
+    }
+
+    std::vector<std::vector<Vertex>> keyframes(keyframeCount, base);
+    timeSamples.resize(keyframeCount);
+    for (uint32_t k = 0; k < keyframeCount; k++)
+    {
+        timeSamples[k] = k / 24.0;
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            keyframes[k][i].position += float3(std::sin(k * 0.1f + i), std::cos(k * 0.07f + i), 0.01f * k);
+            if ((i + k) % 3 == 0) keyframes[k][i].packedNormal ^= k;
+        }
+    }
+    return keyframes;
+}
+} // namespace
+
+CPU_TEST(VertexCacheFile_RoundTrip)
+{
+    const uint32_t kVertexCount = 20000;
+    const uint32_t kKeyframeCount = 40;
+    const auto path = getRuntimeDirectory() / "test_vertex_cache.vcf";
+
+    std::vector<double> timeSamples;
+    auto keyframes = createKeyframes(kVertexCount, kKeyframeCount, timeSamples);
+    ASSERT(VertexCacheFile::write(path, timeSamples, keyframes, 16));
+
+    {
+        VertexCacheFile file(path);
+        ASSERT_EQ(file.getVertexCount(), kVertexCount);
+        ASSERT_EQ(file.getVertexStride(), sizeof(Vertex));
+        ASSERT_EQ(file.getKeyframeCount(), kKeyframeCount);
+        EXPECT(file.getTimeSamples() == timeSamples);
+
+        uint64_t compressedSize = 0;
+        for (uint32_t k = 0; k < kKeyframeCount; k++) compressedSize += file.getCompressedSize(k);
+        EXPECT_LE(compressedSize * 2, uint64_t(kVertexCount) * kKeyframeCount * sizeof(Vertex));
+
+        // Decode in and out of order to exercise both delta decoding and seeking.
+        const auto& header = file.getHeader();
+        float3 step = (header.boundsMax - header.boundsMin) / 65535.f;
+        VertexCacheFile::State state;
+        std::vector<Vertex> vertices(kVertexCount);
+        for (uint32_t k : { 0, 1, 2, 20, 5, 39, 17, 16, 16, 38 })
+        {
+            file.decodeKeyframe(k, state, vertices.data());
+
+            float maxError = 0.f;
+            size_t wordErrors = 0;
+            for (uint32_t i = 0; i < kVertexCount; i++)
+            {
+                float3 error = abs(vertices[i].position - keyframes[k][i].position) / step;
+                maxError = std::max({ maxError, error.x, error.y, error.z });
+                if (std::memcmp(&vertices[i].packedNormal, &keyframes[k][i].packedNormal, sizeof(Vertex) - sizeof(float3)) != 0) wordErrors++;
+            }
+            EXPECT_LE(maxError, 0.501f) << "keyframe " << k;
+            EXPECT_EQ(wordErrors, 0) << "keyframe " << k;
+        }
+    }
+
+    std::filesystem::remove(path);
+}
+
+CPU_TEST(VertexCacheStream_Playback)
+{
+    const uint32_t kVertexCount = 5000;
+    const uint32_t kKeyframeCount = 40;
+    const auto path = getRuntimeDirectory() / "test_vertex_cache_stream.vcf";
+
+    std::vector<double> timeSamples;
+    auto keyframes = createKeyframes(kVertexCount, kKeyframeCount, timeSamples);
+    ASSERT(VertexCacheFile::write(path, timeSamples, keyframes));
+
+    {
+        VertexCacheFile file(path);
+        VertexCacheStream stream(path, 4);
+
+        // The streamed keyframes must match decoding the keyframes directly.
+        size_t mismatches = 0;
+        uint32_t requestCount = 0;
+        uint32_t requestedKeyframeCount = 0;
+        auto play = [&](uint32_t first, uint32_t second)
+        {
+            auto [pFirst, pSecond] = stream.getKeyframes(first, second);
+            VertexCacheFile::State state;
+            std::vector<Vertex> vertices(kVertexCount);
+            file.decodeKeyframe(first, state, vertices.data());
+            if (std::memcmp(pFirst, vertices.data(), kVertexCount * sizeof(Vertex)) != 0) mismatches++;
+            file.decodeKeyframe(second, state, vertices.data());
+            if (std::memcmp(pSecond, vertices.data(), kVertexCount * sizeof(Vertex)) != 0) mismatches++;
+            requestCount++;
+            requestedKeyframeCount += first == second ? 1 : 2;
+        };
+
+        // Looped playback followed by seeks.
+        for (uint32_t loop = 0; loop < 2; loop++)
+        {
+            for (uint32_t k = 0; k < kKeyframeCount; k++) play(k, (k + 1) % kKeyframeCount);
+        }
+        play(10, 30);
+        play(30, 10);
+        play(5, 5);
+        EXPECT_EQ(mismatches, 0);
+
+        auto stats = stream.getStats();
+        EXPECT_EQ(stats.keyframesRequested, requestedKeyframeCount);
+        EXPECT_GE(stats.keyframesDecoded, kKeyframeCount);
+        EXPECT_LE(stats.stallCount, requestCount);
+        EXPECT_EQ(stats.decodedBytes, stats.keyframesDecoded * kVertexCount * sizeof(Vertex));
+        EXPECT_LE(stream.getMemoryUsageInBytes(), 8 * kVertexCount * sizeof(Vertex));
+
+        stream.resetStats();
+        EXPECT_EQ(stream.getStats().keyframesRequested, 0);
+    }
+
+    std::filesystem::remove(path);
+}
+
+CPU_TEST(VertexCacheStream_ManyStreams)
+{
+    // Streams share a few decode threads. Each must still deliver its keyframes, including streams destroyed while queued.
+    const uint32_t kVertexCount = 2000;
+    const uint32_t kKeyframeCount = 12;
+    const uint32_t kStreamCount = 32;
+    const auto path = getRuntimeDirectory() / "test_vertex_cache_streams.vcf";
+
+    std::vector<double> timeSamples;
+    auto keyframes = createKeyframes(kVertexCount, kKeyframeCount, timeSamples);
+    ASSERT(VertexCacheFile::write(path, timeSamples, keyframes));
+
+    {
+        VertexCacheFile file(path);
+        std::vector<std::vector<Vertex>> decoded(kKeyframeCount, std::vector<Vertex>(kVertexCount));
+        VertexCacheFile::State state;
+        for (uint32_t k = 0; k < kKeyframeCount; k++) file.decodeKeyframe(k, state, decoded[k].data());
+
+        std::vector<std::unique_ptr<VertexCacheStream>> streams;
+        for (uint32_t i = 0; i < kStreamCount; i++) streams.push_back(std::make_unique<VertexCacheStream>(path, 4));
+
+        size_t mismatches = 0;
+        for (uint32_t k = 0; k < kKeyframeCount; k++)
+        {
+            for (uint32_t i = 0; i < (uint32_t)streams.size(); i++)
+            {
+                uint32_t first = (k + i) % kKeyframeCount;
+                uint32_t second = (first + 1) % kKeyframeCount;
+                auto [pFirst, pSecond] = streams[i]->getKeyframes(first, second);
+                if (std::memcmp(pFirst, decoded[first].data(), kVertexCount * sizeof(Vertex)) != 0) mismatches++;
+                if (std::memcmp(pSecond, decoded[second].data(), kVertexCount * sizeof(Vertex)) != 0) mismatches++;
+            }
+            // Destroy some streams while their next keyframes are being decoded.
+            if (k == kKeyframeCount / 2) streams.resize(kStreamCount / 2);
+        }
+        EXPECT_EQ(mismatches, 0);
+    }
+
+    std::filesystem::remove(path);
+}
+
+CPU_TEST(VertexCacheStream_DecodeThroughput, TAGS("benchmark"))
+{
+    const uint32_t kVertexCount = 500000;
+    const uint32_t kKeyframeCount = 48;
+    const auto path = getRuntimeDirectory() / "test_vertex_cache_benchmark.vcf";
+
+    std::vector<double> timeSamples;
+    auto keyframes = createKeyframes(kVertexCount, kKeyframeCount, timeSamples);
+    ASSERT(VertexCacheFile::write(path, timeSamples, keyframes));
+    keyframes.clear();
+
+    {
+        VertexCacheStream stream(path);
+        uint64_t compressedSize = 0;
+        for (uint32_t k = 0; k < kKeyframeCount; k++) compressedSize += stream.getFile().getCompressedSize(k);
+
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        for (uint32_t k = 0; k < kKeyframeCount; k++) stream.getKeyframes(k, (k + 1) % kKeyframeCount);
+        double playbackTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint()) * 1e-3;
+
+        auto stats = stream.getStats();
+        logInfo(
+            "VertexCacheStream: {} vertices, {} keyframes, {:.1f} MB raw, {:.1f} MB compressed, playback {:.1f} ms/keyframe, "
+            "decode {:.1f} MB/s, {} stalls ({:.1f} ms), {:.1f} MB resident",
+            kVertexCount, kKeyframeCount, double(kVertexCount) * kKeyframeCount * sizeof(Vertex) / 1e6, compressedSize / 1e6,
+            playbackTime * 1e3 / kKeyframeCount, stats.getDecodedBytesPerSecond() / 1e6, stats.stallCount, stats.stallTime * 1e3,
+            stream.getMemoryUsageInBytes() / 1e6
+        );
+    }
+
+    std::filesystem::remove(path);
+}
+} // namespace Falcor
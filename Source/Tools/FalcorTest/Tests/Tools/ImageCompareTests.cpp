@@ -0,0 +1,168 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "ImageCompare/FLIP.h"
+#include "ImageCompare/ImageMetrics.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Falcor
+{
+namespace
+{
+// Reference FLIP errors were computed with a direct (non-separable) per-pixel port of FLIPPass.cs.slang.
+const float kTolerance = 1e-4f;
+
+const ErrorMetric& getFLIPMetric()
+{
+    const auto& metrics = getErrorMetrics();
+    auto it = std::find_if(metrics.begin(), metrics.end(), [](const ErrorMetric& metric) { return metric.name == "flip"; });
+    FALCOR_CHECK(it != metrics.end(), "FLIP metric not found.");
+    return *it;
+}
+
+void fill(Image& image, float value)
+{
+    std::fill_n(image.getData(), size_t(image.getWidth()) * image.getHeight() * 4, value);
+}
+
+/// Fills a smooth reference pattern and a test image with a brightened square and a darkened checkerboard.
+void fillPattern(Image& reference, Image& test, float scale)
+{
+    for (uint32_t y = 0; y < reference.getHeight(); y++)
+    {
+        for (uint32_t x = 0; x < reference.getWidth(); x++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                size_t i = (size_t(y) * reference.getWidth() + x) * 4 + c;
+                float r = 0.5f + 0.4f * std::sin(0.3f * x + 0.7f * y + c);
+                float t = r;
+                if (x >= 20 && x < 36 && y >= 12 && y < 28)
+                    t = std::min(r + 0.3f, 1.f);
+                if ((x / 4 + y / 4) % 2 == 0)
+                    t *= 0.9f;
+                reference.getData()[i] = r * scale;
+                test.getData()[i] = t * scale;
+            }
+        }
+    }
+}
+
+struct PixelError
+{
+    uint32_t x;
+    uint32_t y;
+    float error;
+};
+} // namespace
+
+CPU_TEST(FLIP_IdenticalImages)
+{
+    Image reference(64, 48);
+    Image test(64, 48);
+    fillPattern(reference, test, 1.f);
+
+    for (bool isHDR : {false, true})
+    {
+        FLIPOptions options;
+        options.isHDR = isHDR;
+        std::vector<float> errorMap(64 * 48, -1.f);
+        EXPECT_EQ(computeFLIP(reference, reference, options, errorMap.data()), 0.0);
+        for (float error : errorMap)
+            EXPECT_EQ(error, 0.f);
+    }
+}
+
+CPU_TEST(FLIP_UniformImages)
+{
+    // Constant images have no features, so the error is the redistributed color difference of black and white.
+    Image black(16, 16);
+    Image white(16, 16);
+    fill(black, 0.f);
+    fill(white, 1.f);
+
+    std::vector<float> errorMap(16 * 16);
+    EXPECT_LE(std::abs(computeFLIP(black, white, FLIPOptions{}, errorMap.data()) - 0.9673944), kTolerance);
+    for (float error : errorMap)
+        EXPECT_LE(std::abs(error - 0.9673944f), kTolerance);
+    EXPECT_LE(std::abs(computeFLIP(white, black, FLIPOptions{}) - 0.9673944), kTolerance);
+}
+
+CPU_TEST(FLIP_Pattern)
+{
+    Image reference(64, 48);
+    Image test(64, 48);
+    fillPattern(reference, test, 1.f);
+
+    std::vector<float> errorMap(64 * 48);
+    EXPECT_LE(std::abs(computeFLIP(reference, test, FLIPOptions{}, errorMap.data()) - 0.2186213), kTolerance);
+
+    const PixelError kPixels[] = {
+        {0, 0, 0.390367f}, {10, 5, 0.059987f}, {28, 20, 0.614277f}, {36, 12, 0.237767f}, {63, 47, 0.373173f},
+    };
+    for (const auto& pixel : kPixels)
+        EXPECT_LE(std::abs(errorMap[pixel.y * 64 + pixel.x] - pixel.error), kTolerance) << "x=" << pixel.x << " y=" << pixel.y;
+}
+
+CPU_TEST(FLIP_PatternHDR)
+{
+    // The reference luminance range spans two HDR-FLIP exposures.
+    Image reference(64, 48);
+    Image test(64, 48);
+    fillPattern(reference, test, 4.f);
+
+    FLIPOptions options;
+    options.isHDR = true;
+    std::vector<float> errorMap(64 * 48);
+    EXPECT_LE(std::abs(computeFLIP(reference, test, options, errorMap.data()) - 0.1658747), kTolerance);
+
+    const PixelError kPixels[] = {
+        {0, 0, 0.193105f}, {10, 5, 0.044206f}, {28, 20, 0.874362f}, {36, 12, 0.186300f}, {63, 47, 0.170480f},
+    };
+    for (const auto& pixel : kPixels)
+        EXPECT_LE(std::abs(errorMap[pixel.y * 64 + pixel.x] - pixel.error), kTolerance) << "x=" << pixel.x << " y=" << pixel.y;
+}
+
+CPU_TEST(FLIP_MetricIgnoresAlpha)
+{
+    Image reference(64, 48);
+    Image test(64, 48);
+    fillPattern(reference, test, 1.f);
+
+    const ErrorMetric& flip = getFLIPMetric();
+    const double error = flip.compare(reference, test, false, nullptr);
+    EXPECT_EQ(error, computeFLIP(reference, test, FLIPOptions{}));
+    EXPECT_EQ(flip.compare(reference, test, true, nullptr), error);
+
+    // Images that only differ in alpha have no FLIP error.
+    for (uint32_t i = 0; i < 64 * 48 * 4; i++)
+        test.getData()[i] = i % 4 == 3 ? 1.f - reference.getData()[i] : reference.getData()[i];
+    EXPECT_EQ(flip.compare(reference, test, true, nullptr), 0.0);
+}
+} // namespace Falcor
@@ -0,0 +1,263 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/AsyncImageWriter.h"
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <thread>
+
+namespace Falcor
+{
+namespace
+{
+AsyncImageWriter::Image createSyntheticImage(uint32_t width, uint32_t height, uint32_t seed)
+{
+    AsyncImageWriter::Image image;
+    image.width = width;
+    image.height = height;
+    image.resourceFormat = ResourceFormat::RGBA8Unorm;
+    image.data.resize(width * height * 4);
+    for (size_t i = 0; i < image.data.size(); ++i)
+        image.data[i] = uint8_t(i * 7 + seed);
+    return image;
+}
+
+void waitUntil(const std::atomic<uint32_t>& value, uint32_t expected)
+{
+    while (value.load() < expected)
+        std::this_thread::yield();
+}
+} // namespace
+
+CPU_TEST(AsyncImageWriter_WritesAllImages)
+{
+    const uint32_t kImageCount = 100;
+    std::atomic<uint32_t> writeCount = 0;
+    std::atomic<uint32_t> callbackCount = 0;
+
+    {
+        AsyncImageWriter writer(4, 4, [&](AsyncImageWriter::Image& image) { writeCount++; });
+
+        for (uint32_t i = 0; i < kImageCount; ++i)
+        {
+            auto image = createSyntheticImage(16, 16, i);
+            image.callback = [&](bool success)
+            {
+                EXPECT(success);
+                callbackCount++;
+            };
+            writer.write(std::move(image));
+        }
+
+        writer.flush();
+        EXPECT_EQ(writer.getPendingCount(), 0);
+        EXPECT_EQ(writeCount.load(), kImageCount);
+        EXPECT_EQ(callbackCount.load(), kImageCount);
+
+        auto stats = writer.getStats();
+        EXPECT_EQ(stats.imagesQueued, kImageCount);
+        EXPECT_EQ(stats.imagesWritten, kImageCount);
+        EXPECT_EQ(stats.imagesFailed, 0);
+        EXPECT_EQ(stats.bytesWritten, kImageCount * 16 * 16 * 4);
+    }
+
+    // Destroying the writer drains the queue.
+    writeCount = 0;
+    {
+        AsyncImageWriter writer(2, 2, [&](AsyncImageWriter::Image& image) { writeCount++; });
+        for (uint32_t i = 0; i < kImageCount; ++i)
+            writer.write(createSyntheticImage(4, 4, i));
+    }
+    EXPECT_EQ(writeCount.load(), kImageCount);
+}
+
+CPU_TEST(AsyncImageWriter_BackPressure)
+{
+    // Use a single worker that blocks until released to simulate a slow disk.
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<uint32_t> startedCount = 0;
+
+    AsyncImageWriter writer(
+        1,
+        2,
+        [&](AsyncImageWriter::Image& image)
+        {
+            startedCount++;
+            released.wait();
+        }
+    );
+
+    // The first image occupies the worker.
+    writer.write(createSyntheticImage(4, 4, 0));
+    waitUntil(startedCount, 1);
+
+    // Two images fit into the queue, the third one blocks the producer.
+    std::atomic<uint32_t> returnedCount = 0;
+    std::thread producer(
+        [&]()
+        {
+            for (uint32_t i = 1; i <= 3; ++i)
+            {
+                writer.write(createSyntheticImage(4, 4, i));
+                returnedCount++;
+            }
+        }
+    );
+
+    waitUntil(returnedCount, 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(returnedCount.load(), 2);
+    EXPECT_EQ(writer.getPendingCount(), 3);
+
+    release.set_value();
+    producer.join();
+    writer.flush();
+
+    auto stats = writer.getStats();
+    EXPECT_EQ(stats.imagesWritten, 4);
+    EXPECT_EQ(stats.stallCount, 1);
+    EXPECT(stats.stallTime > 0.0);
+}
+
+CPU_TEST(AsyncImageWriter_Failure)
+{
+    AsyncImageWriter writer(
+        2,
+        4,
+        [&](AsyncImageWriter::Image& image)
+        {
+            if (image.width == 1)
+                FALCOR_THROW("Synthetic failure");
+            if (image.width == 3)
+                throw 1; // Exceptions not derived from std::exception also fail the write.
+        }
+    );
+
+    std::atomic<uint32_t> failedCount = 0;
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        auto image = createSyntheticImage(i % 2 == 0 ? (i % 4 == 0 ? 1 : 3) : 2, 1, i);
+        image.callback = [&](bool success)
+        {
+            if (!success)
+                failedCount++;
+        };
+        writer.write(std::move(image));
+    }
+
+    writer.flush();
+    auto stats = writer.getStats();
+    EXPECT_EQ(stats.imagesWritten, 5);
+    EXPECT_EQ(stats.imagesFailed, 5);
+    EXPECT_EQ(failedCount.load(), 5);
+}
+
+CPU_TEST(AsyncImageWriter_PNG)
+{
+    const uint32_t kImageCount = 8;
+    const uint32_t kWidth = 64;
+    const uint32_t kHeight = 32;
+
+    std::vector<std::filesystem::path> paths;
+    {
+        AsyncImageWriter writer(4, 2);
+        for (uint32_t i = 0; i < kImageCount; ++i)
+        {
+            auto image = createSyntheticImage(kWidth, kHeight, i);
+            image.path = getRuntimeDirectory() / fmt::format("test_async_image_writer_{}.png", i);
+            image.fileFormat = Bitmap::FileFormat::PngFile;
+            image.exportFlags = Bitmap::ExportFlags::ExportAlpha;
+            paths.push_back(image.path);
+            writer.write(std::move(image));
+        }
+        writer.flush();
+        EXPECT_EQ(writer.getStats().imagesWritten, kImageCount);
+    }
+
+    for (uint32_t i = 0; i < kImageCount; ++i)
+    {
+        auto expected = createSyntheticImage(kWidth, kHeight, i);
+        auto bmp = Bitmap::createFromFile(paths[i], true /* top-down */);
+        ASSERT(bmp != nullptr);
+        ASSERT_EQ(bmp->getWidth(), kWidth);
+        ASSERT_EQ(bmp->getHeight(), kHeight);
+        ASSERT_EQ((uint32_t)bmp->getFormat(), (uint32_t)ResourceFormat::BGRA8Unorm);
+
+        // Loaded images are in BGRA order.
+        const uint8_t* data = bmp->getData();
+        for (uint32_t p = 0; p < kWidth * kHeight; ++p)
+        {
+            EXPECT_EQ(data[4 * p + 0], expected.data[4 * p + 2]);
+            EXPECT_EQ(data[4 * p + 1], expected.data[4 * p + 1]);
+            EXPECT_EQ(data[4 * p + 2], expected.data[4 * p + 0]);
+            EXPECT_EQ(data[4 * p + 3], expected.data[4 * p + 3]);
+        }
+
+        std::filesystem::remove(paths[i]);
+    }
+}
+
+CPU_TEST(AsyncImageWriter_Throughput, TAGS("benchmark"))
+{
+    // Encode synthetic HD frames to EXR and report the number of frames captured per second.
+    const uint32_t kFrameCount = 16;
+    const uint32_t kWidth = 1920;
+    const uint32_t kHeight = 1080;
+
+    std::vector<float> pixels(kWidth * kHeight * 4);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = float(i % 1024) / 1024.f;
+
+    for (size_t threadCount : {size_t(1), size_t(std::thread::hardware_concurrency())})
+    {
+        AsyncImageWriter writer(threadCount, 2 * threadCount);
+        for (uint32_t i = 0; i < kFrameCount; ++i)
+        {
+            AsyncImageWriter::Image image;
+            image.path = getRuntimeDirectory() / fmt::format("test_async_image_writer_{}.exr", i);
+            image.width = kWidth;
+            image.height = kHeight;
+            image.fileFormat = Bitmap::FileFormat::ExrFile;
+            image.resourceFormat = ResourceFormat::RGBA32Float;
+            image.data.resize(pixels.size() * sizeof(float));
+            std::memcpy(image.data.data(), pixels.data(), image.data.size());
+            image.callback = [path = image.path](bool success) { std::filesystem::remove(path); };
+            writer.write(std::move(image));
+        }
+        writer.flush();
+
+        auto stats = writer.getStats();
+        EXPECT_EQ(stats.imagesWritten, kFrameCount);
+        logInfo(
+            "AsyncImageWriter: {} threads, {:.2f} frames/s, stalled {:.3f} s", threadCount, stats.getImagesPerSecond(), stats.stallTime
+        );
+    }
+}
+} // namespace Falcor
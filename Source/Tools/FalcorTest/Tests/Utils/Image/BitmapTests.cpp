@@ -27,9 +27,33 @@
  **************************************************************************/
 #include "Testing/UnitTest.h"
 #include "Utils/Image/Bitmap.h"
+#include "Utils/Math/Float16.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <vector>
 
 namespace Falcor
 {
+namespace
+{
+/// Creates an RGBA float image with values that are exactly representable as half floats.
+std::vector<float> createExrTestImage(uint32_t width, uint32_t height)
+{
+    std::vector<float> data(width * height * 4);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            float* pTexel = &data[(y * width + x) * 4];
+            pTexel[0] = float(x) * 0.25f;
+            pTexel[1] = float(y) * 0.5f;
+            pTexel[2] = -float(x + y);
+            pTexel[3] = float((x + y) % 5) * 0.125f;
+        }
+    }
+    return data;
+}
+} // namespace
+
 GPU_TEST(Bitmap_LinearRamp_PNG)
 {
     const auto path = getRuntimeDirectory() / "test_linear_ramp.png";
@@ -74,4 +98,140 @@ GPU_TEST(Bitmap_LinearRamp_PNG)
     // Delete the test file.
     std::filesystem::remove(path);
 }
+
+CPU_TEST(Bitmap_EXR_Float16)
+{
+    const auto path = getRuntimeDirectory() / "test_exr_float16.exr";
+    const uint32_t width = 67;
+    const uint32_t height = 45;
+    std::vector<float> data = createExrTestImage(width, height);
+    Bitmap::saveImage(
+        path,
+        width,
+        height,
+        Bitmap::FileFormat::ExrFile,
+        Bitmap::ExportFlags::ExportAlpha | Bitmap::ExportFlags::Uncompressed | Bitmap::ExportFlags::ExrFloat16,
+        ResourceFormat::RGBA32Float,
+        true /* top-down */,
+        data.data()
+    );
+
+    // Half-float files are loaded without conversion to float. Test both memory layouts.
+    for (bool isTopDown : {true, false})
+    {
+        auto bmp = Bitmap::createFromFile(path, isTopDown);
+        ASSERT(bmp != nullptr);
+        EXPECT_EQ(bmp->getWidth(), width);
+        EXPECT_EQ(bmp->getHeight(), height);
+        EXPECT_EQ((uint32_t)bmp->getFormat(), (uint32_t)ResourceFormat::RGBA16Float);
+
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const uint32_t srcY = isTopDown ? y : height - 1 - y;
+            const uint16_t* pRow = reinterpret_cast<const uint16_t*>(bmp->getData() + y * bmp->getRowPitch());
+            for (uint32_t i = 0; i < width * 4; i++)
+                EXPECT_EQ(float16ToFloat32(pRow[i]), data[srcY * width * 4 + i]) << "y = " << y << " i = " << i;
+        }
+    }
+
+    std::filesystem::remove(path);
+}
+
+CPU_TEST(Bitmap_EXR_Window)
+{
+    const auto path = getRuntimeDirectory() / "test_exr_window.exr";
+    const uint32_t width = 67;
+    const uint32_t height = 45;
+    std::vector<float> data = createExrTestImage(width, height);
+    Bitmap::saveImage(
+        path,
+        width,
+        height,
+        Bitmap::FileFormat::ExrFile,
+        Bitmap::ExportFlags::ExportAlpha | Bitmap::ExportFlags::Uncompressed,
+        ResourceFormat::RGBA32Float,
+        true /* top-down */,
+        data.data()
+    );
+
+    // Load a region with swizzled channels and no alpha, reporting rows as they are decoded.
+    Bitmap::ExrLoadOptions options;
+    options.channels = {"B", "G", "R", ""};
+    options.windowOffset = uint2(5, 7);
+    options.windowSize = uint2(20, 30);
+    options.threadCount = 1;
+    uint32_t nextRow = 0;
+    options.rowCallback = [&](uint32_t firstRow, uint32_t rowCount)
+    {
+        EXPECT_EQ(firstRow, nextRow);
+        nextRow = firstRow + rowCount;
+    };
+
+    auto bmp = Bitmap::createFromExrFile(path, true /* top-down */, Bitmap::ImportFlags::None, options);
+    ASSERT(bmp != nullptr);
+    EXPECT_EQ(bmp->getWidth(), 20);
+    EXPECT_EQ(bmp->getHeight(), 30);
+    EXPECT_EQ((uint32_t)bmp->getFormat(), (uint32_t)ResourceFormat::RGBA32Float);
+    EXPECT_EQ(nextRow, 30);
+
+    for (uint32_t y = 0; y < 30; y++)
+    {
+        const float* pRow = reinterpret_cast<const float*>(bmp->getData() + y * bmp->getRowPitch());
+        for (uint32_t x = 0; x < 20; x++)
+        {
+            const float* pSrc = &data[((y + 7) * width + x + 5) * 4];
+            EXPECT_EQ(pRow[x * 4 + 0], pSrc[2]) << "x = " << x << " y = " << y;
+            EXPECT_EQ(pRow[x * 4 + 1], pSrc[1]) << "x = " << x << " y = " << y;
+            EXPECT_EQ(pRow[x * 4 + 2], pSrc[0]) << "x = " << x << " y = " << y;
+            EXPECT_EQ(pRow[x * 4 + 3], 1.f) << "x = " << x << " y = " << y;
+        }
+    }
+
+    // Regions outside the data window and files without any of the channels fail to load.
+    options.windowSize = uint2(width, 1);
+    EXPECT(Bitmap::createFromExrFile(path, true, Bitmap::ImportFlags::None, options) == nullptr);
+    options = {};
+    options.channels = {"X", "Y", "Z", ""};
+    EXPECT(Bitmap::createFromExrFile(path, true, Bitmap::ImportFlags::None, options) == nullptr);
+
+    std::filesystem::remove(path);
+}
+
+CPU_TEST(Bitmap_EXR_Throughput, TAGS("benchmark"))
+{
+    // Compare single-threaded and multithreaded decoding of large compressed EXRs.
+    // The 16K image is cropped vertically to keep the memory use of the test reasonable.
+    for (uint2 size : {uint2(8192, 4096), uint2(16384, 4096)})
+    {
+        const uint32_t width = size.x;
+        const uint32_t height = size.y;
+        const auto path = getRuntimeDirectory() / fmt::format("test_exr_throughput_{}.exr", width);
+        {
+            std::vector<float> data = createExrTestImage(width, height);
+            Bitmap::saveImage(
+                path,
+                width,
+                height,
+                Bitmap::FileFormat::ExrFile,
+                Bitmap::ExportFlags::ExportAlpha,
+                ResourceFormat::RGBA32Float,
+                true /* top-down */,
+                data.data()
+            );
+        }
+
+        for (uint32_t threadCount : {1u, 0u})
+        {
+            Bitmap::ExrLoadOptions options;
+            options.threadCount = threadCount;
+            auto start = CpuTimer::getCurrentTimePoint();
+            auto bmp = Bitmap::createFromExrFile(path, true, Bitmap::ImportFlags::None, options);
+            double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+            EXPECT(bmp != nullptr);
+            logInfo("{}x{} EXR ({}): {:.1f} ms", width, height, threadCount == 1 ? "single-threaded" : "multithreaded", ms);
+        }
+
+        std::filesystem::remove(path);
+    }
+}
 } // namespace Falcor
@@ -0,0 +1,344 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/PixelConversion.h"
+#include "Utils/Math/Float16.h"
+#include "Utils/Color/ColorHelpers.slang"
+#include "Utils/Timing/CpuTimer.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+/// Run a test with the scalar and, if supported, the vectorized kernels.
+template<typename F>
+void forEachCodePath(F func)
+{
+    const bool wasEnabled = PixelConversion::isSimdEnabled();
+    PixelConversion::setSimdEnabled(false);
+    func();
+    if (PixelConversion::isSimdSupported())
+    {
+        PixelConversion::setSimdEnabled(true);
+        func();
+    }
+    PixelConversion::setSimdEnabled(wasEnabled);
+}
+
+uint32_t asUint(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float asFloat(uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/// Float test values: a sweep over all bit patterns plus special values. The odd count exercises the scalar tail.
+std::vector<float> createFloatTestData()
+{
+    std::vector<float> values;
+    for (uint64_t bits = 0; bits <= 0xffffffff; bits += 4093)
+        values.push_back(asFloat((uint32_t)bits));
+    for (float v : {0.f, -0.f, 0.5f, 1.f, 2.f, 65504.f, 65520.f, std::numeric_limits<float>::infinity(), 1e-8f, 6.1e-5f, 5.9604645e-8f})
+    {
+        values.push_back(v);
+        values.push_back(-v);
+    }
+    values.push_back(asFloat(0x7fc00000)); // Quiet NaN
+    values.push_back(asFloat(0x7f800001)); // Signaling NaN
+    values.push_back(asFloat(0xff802000)); // NaN with payload
+    // Values halfway between halfs, including denormals.
+    for (uint32_t h = 0; h < 0x7c00; h += 7)
+    {
+        float a = math::float16ToFloat32(uint16_t(h));
+        float b = math::float16ToFloat32(uint16_t(h + 1));
+        values.push_back(0.5f * (a + b));
+    }
+    return values;
+}
+
+template<typename T>
+void testNormalizedToFloat32(const std::vector<T>& src)
+{
+    std::vector<float> dst(src.size());
+    PixelConversion::normalizedToFloat32(src.data(), dst.data(), src.size());
+    for (size_t i = 0; i < src.size(); ++i)
+        ASSERT_EQ(asUint(dst[i]), asUint(float(src[i]) / float(std::numeric_limits<T>::max())));
+}
+
+template<typename T>
+std::vector<T> createIntTestData(size_t count)
+{
+    std::mt19937 rng(1234);
+    std::vector<T> values(count);
+    for (auto& v : values)
+        v = T(rng());
+    values[0] = std::numeric_limits<T>::min();
+    values[1] = std::numeric_limits<T>::max();
+    values[2] = 0;
+    return values;
+}
+} // namespace
+
+CPU_TEST(PixelConversion_Float16ToFloat32)
+{
+    std::vector<uint16_t> src(0x10000 + 3);
+    for (size_t i = 0; i < src.size(); ++i)
+        src[i] = uint16_t(i);
+
+    forEachCodePath(
+        [&]()
+        {
+            std::vector<float> dst(src.size());
+            PixelConversion::float16ToFloat32(src.data(), dst.data(), src.size());
+            for (size_t i = 0; i < src.size(); ++i)
+                ASSERT_EQ(asUint(dst[i]), asUint(math::float16ToFloat32(src[i])));
+        }
+    );
+}
+
+CPU_TEST(PixelConversion_Float32ToFloat16)
+{
+    auto src = createFloatTestData();
+
+    forEachCodePath(
+        [&]()
+        {
+            std::vector<uint16_t> dst(src.size());
+            PixelConversion::float32ToFloat16(src.data(), dst.data(), src.size());
+            for (size_t i = 0; i < src.size(); ++i)
+                ASSERT_EQ(dst[i], math::float32ToFloat16(src[i]));
+        }
+    );
+}
+
+CPU_TEST(PixelConversion_NormalizedToFloat32)
+{
+    const size_t count = 100003;
+    auto u8 = createIntTestData<uint8_t>(count);
+    auto u16 = createIntTestData<uint16_t>(count);
+    auto u32 = createIntTestData<uint32_t>(count);
+    auto i16 = createIntTestData<int16_t>(count);
+    auto i32 = createIntTestData<int32_t>(count);
+
+    forEachCodePath(
+        [&]()
+        {
+            testNormalizedToFloat32(u8);
+            testNormalizedToFloat32(u16);
+            testNormalizedToFloat32(u32);
+            testNormalizedToFloat32(i16);
+            testNormalizedToFloat32(i32);
+        }
+    );
+}
+
+CPU_TEST(PixelConversion_Float32ToUnorm)
+{
+    auto src = createFloatTestData();
+    for (uint32_t i = 0; i <= 65535 * 4; ++i)
+        src.push_back(i / (65535.f * 4.f));
+
+    auto reference = [](float value, float maxValue)
+    {
+        value = value > 0.f ? std::min(value, 1.f) : 0.f;
+        return uint32_t(value * maxValue + 0.5f);
+    };
+
+    forEachCodePath(
+        [&]()
+        {
+            std::vector<uint8_t> dst8(src.size());
+            std::vector<uint16_t> dst16(src.size());
+            PixelConversion::float32ToUnorm8(src.data(), dst8.data(), src.size());
+            PixelConversion::float32ToUnorm16(src.data(), dst16.data(), src.size());
+            for (size_t i = 0; i < src.size(); ++i)
+            {
+                ASSERT_EQ(dst8[i], reference(src[i], 255.f));
+                ASSERT_EQ(dst16[i], reference(src[i], 65535.f));
+            }
+        }
+    );
+}
+
+CPU_TEST(PixelConversion_Srgb)
+{
+    std::vector<uint8_t> codes(256 + 5);
+    for (size_t i = 0; i < codes.size(); ++i)
+        codes[i] = uint8_t(i);
+    auto src = createFloatTestData();
+    for (uint32_t i = 0; i <= 100000; ++i)
+        src.push_back(i / 100000.f);
+
+    std::vector<uint8_t> encodedReference;
+    forEachCodePath(
+        [&]()
+        {
+            // Decode matches sRGBToLinear().
+            std::vector<float> linear(codes.size());
+            PixelConversion::srgb8ToLinearFloat32(codes.data(), linear.data(), codes.size());
+            for (size_t i = 0; i < codes.size(); ++i)
+                ASSERT_EQ(asUint(linear[i]), asUint(sRGBToLinear(codes[i] / 255.f)));
+
+            // Encode inverts decode.
+            std::vector<uint8_t> roundTrip(codes.size());
+            PixelConversion::linearFloat32ToSrgb8(linear.data(), roundTrip.data(), codes.size());
+            for (size_t i = 0; i < codes.size(); ++i)
+                ASSERT_EQ(roundTrip[i], codes[i]);
+
+            // Encode is within one code of rounding linearToSRGB() and identical for all code paths.
+            std::vector<uint8_t> encoded(src.size());
+            PixelConversion::linearFloat32ToSrgb8(src.data(), encoded.data(), src.size());
+            for (size_t i = 0; i < src.size(); ++i)
+            {
+                if (std::isnan(src[i]))
+                {
+                    ASSERT_EQ(encoded[i], 0);
+                    continue;
+                }
+                float value = std::clamp(src[i], 0.f, 1.f);
+                int expected = int(std::clamp(linearToSRGB(value), 0.f, 1.f) * 255.f + 0.5f);
+                ASSERT_LE(std::abs(int(encoded[i]) - expected), 1);
+            }
+            if (encodedReference.empty())
+                encodedReference = encoded;
+            else
+                EXPECT(encoded == encodedReference);
+        }
+    );
+}
+
+CPU_TEST(PixelConversion_ToRGBA32Float)
+{
+    const size_t pixelCount = 70001; // More than one parallel block.
+    auto src = createIntTestData<uint16_t>(pixelCount * 4);
+
+    forEachCodePath(
+        [&]()
+        {
+            for (uint32_t channelCount = 1; channelCount <= 4; ++channelCount)
+            {
+                std::vector<float> unorm(pixelCount * 4);
+                std::vector<float> half(pixelCount * 4);
+                PixelConversion::normalizedToRGBA32Float(src.data(), channelCount, unorm.data(), pixelCount);
+                PixelConversion::float16ToRGBA32Float(src.data(), channelCount, half.data(), pixelCount);
+                for (size_t i = 0; i < pixelCount; ++i)
+                {
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        uint16_t value = src[i * channelCount + c];
+                        float expectedUnorm = c < channelCount ? value / 65535.f : (c == 3 ? 1.f : 0.f);
+                        float expectedHalf = c < channelCount ? math::float16ToFloat32(value) : (c == 3 ? 1.f : 0.f);
+                        ASSERT_EQ(asUint(unorm[i * 4 + c]), asUint(expectedUnorm));
+                        ASSERT_EQ(asUint(half[i * 4 + c]), asUint(expectedHalf));
+                    }
+                }
+            }
+        }
+    );
+}
+
+CPU_TEST(PixelConversion_ChannelLayout)
+{
+    const size_t pixelCount = 1001;
+    std::vector<float> rgb(pixelCount * 3);
+    for (size_t i = 0; i < rgb.size(); ++i)
+        rgb[i] = float(i);
+    std::vector<uint8_t> rgba8(pixelCount * 4);
+    for (size_t i = 0; i < rgba8.size(); ++i)
+        rgba8[i] = uint8_t(i * 7);
+
+    forEachCodePath(
+        [&]()
+        {
+            std::vector<float> rgba(pixelCount * 4);
+            PixelConversion::expandRGBToRGBA(rgb.data(), rgba.data(), pixelCount, 0.5f);
+            std::vector<float> rgbRoundTrip(pixelCount * 3);
+            PixelConversion::dropAlpha(rgba.data(), rgbRoundTrip.data(), pixelCount);
+            for (size_t i = 0; i < pixelCount; ++i)
+                ASSERT_EQ(rgba[i * 4 + 3], 0.5f);
+            EXPECT(rgbRoundTrip == rgb);
+
+            // RGBA to BGRA with opaque alpha, in place.
+            std::vector<uint8_t> bgra8 = rgba8;
+            PixelConversion::swizzle8(bgra8.data(), bgra8.data(), pixelCount, {2, 1, 0, PixelConversion::kSwizzleOne});
+            for (size_t i = 0; i < pixelCount; ++i)
+            {
+                ASSERT_EQ(bgra8[i * 4 + 0], rgba8[i * 4 + 2]);
+                ASSERT_EQ(bgra8[i * 4 + 1], rgba8[i * 4 + 1]);
+                ASSERT_EQ(bgra8[i * 4 + 2], rgba8[i * 4 + 0]);
+                ASSERT_EQ(bgra8[i * 4 + 3], 255);
+            }
+        }
+    );
+}
+
+CPU_TEST(PixelConversion_Throughput, TAGS("benchmark"))
+{
+    const size_t count = 4 * 1024 * 1024;
+    std::vector<float> f32(count);
+    std::vector<uint16_t> f16(count);
+    std::vector<uint8_t> u8(count);
+    for (size_t i = 0; i < count; ++i)
+        f32[i] = float(i % 4096) / 4096.f;
+
+    auto measure = [&](const char* name, size_t bytes, auto func)
+    {
+        func(); // Warm up.
+        auto start = CpuTimer::getCurrentTimePoint();
+        const int iterations = 4;
+        for (int i = 0; i < iterations; ++i)
+            func();
+        double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / iterations;
+        double gbPerSecond = bytes / (ms * 1e-3) / 1e9;
+        logInfo("{} ({}): {:.3f} ms, {:.2f} GB/s", name, PixelConversion::isSimdEnabled() ? "simd" : "scalar", ms, gbPerSecond);
+    };
+
+    forEachCodePath(
+        [&]()
+        {
+            measure("float32ToFloat16", count * 6, [&]() { PixelConversion::float32ToFloat16(f32.data(), f16.data(), count); });
+            measure("float16ToFloat32", count * 6, [&]() { PixelConversion::float16ToFloat32(f16.data(), f32.data(), count); });
+            measure("float32ToUnorm8", count * 5, [&]() { PixelConversion::float32ToUnorm8(f32.data(), u8.data(), count); });
+            measure("linearFloat32ToSrgb8", count * 5, [&]() { PixelConversion::linearFloat32ToSrgb8(f32.data(), u8.data(), count); });
+            measure("srgb8ToLinearFloat32", count * 5, [&]() { PixelConversion::srgb8ToLinearFloat32(u8.data(), f32.data(), count); });
+        }
+    );
+}
+} // namespace Falcor
@@ -0,0 +1,346 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/TextureStreamer.h"
+#include <set>
+
+namespace Falcor
+{
+namespace
+{
+// Mip sizes of a 64x64 RGBA8 texture.
+const std::vector<uint64_t> kMipSizes = {16384, 4096, 1024, 256, 64, 16, 4};
+const uint64_t kTailBytes = 1024; // Mip tail is mips 3-6 (340 bytes).
+
+class FakeBackend : public TextureStreamer::Backend
+{
+public:
+    bool setResidentMips(TextureStreamer::TextureID id, uint32_t mostDetailedMip) override
+    {
+        if (failingIDs.count(id))
+            return false;
+        calls.emplace_back(id, mostDetailedMip);
+        return true;
+    }
+
+    bool isLoading(TextureStreamer::TextureID id) const override { return loadingIDs.count(id) > 0; }
+
+    std::vector<std::pair<TextureStreamer::TextureID, uint32_t>> calls;
+    std::set<TextureStreamer::TextureID> failingIDs;
+    std::set<TextureStreamer::TextureID> loadingIDs;
+};
+
+TextureStreamer::Config createConfig(uint64_t budgetInBytes = std::numeric_limits<uint64_t>::max())
+{
+    TextureStreamer::Config config;
+    config.budgetInBytes = budgetInBytes;
+    config.mipTailBytes = kTailBytes;
+    return config;
+}
+
+uint64_t getResidentBytes(uint32_t mostDetailedMip)
+{
+    uint64_t bytes = 0;
+    for (size_t mip = mostDetailedMip; mip < kMipSizes.size(); ++mip)
+        bytes += kMipSizes[mip];
+    return bytes;
+}
+} // namespace
+
+CPU_TEST(TextureStreamer_ComputeTailMip)
+{
+    EXPECT_EQ(TextureStreamer::computeTailMip(kMipSizes, kTailBytes), 3);
+    EXPECT_EQ(TextureStreamer::computeTailMip(kMipSizes, 1 << 20), 0);
+    EXPECT_EQ(TextureStreamer::computeTailMip(kMipSizes, 0), 6);
+    EXPECT_EQ(TextureStreamer::computeTailMip(std::vector<uint64_t>{}, kTailBytes), 0);
+}
+
+CPU_TEST(TextureStreamer_TailFirst)
+{
+    FakeBackend backend;
+    TextureStreamer streamer(backend, createConfig());
+
+    EXPECT(streamer.addTexture(7, kMipSizes));
+    ASSERT_EQ(backend.calls.size(), 1);
+    EXPECT_EQ(backend.calls[0].first, 7);
+    EXPECT_EQ(backend.calls[0].second, 3);
+    EXPECT_EQ(streamer.getResidentMip(7), 3);
+    EXPECT_EQ(streamer.getStats().residentBytes, getResidentBytes(3));
+
+    // Nothing is streamed without feedback.
+    EXPECT_EQ(streamer.update(), 0);
+    EXPECT_EQ(streamer.getResidentMip(7), 3);
+
+    // A texture whose mip tail can't be loaded is not added.
+    backend.failingIDs.insert(8);
+    EXPECT(!streamer.addTexture(8, kMipSizes));
+    EXPECT(!streamer.hasTexture(8));
+    EXPECT_EQ(streamer.getStats().failureCount, 1);
+
+    streamer.removeTexture(7);
+    EXPECT_EQ(streamer.getStats().textureCount, 0);
+    EXPECT_EQ(streamer.getStats().residentBytes, 0);
+}
+
+CPU_TEST(TextureStreamer_StreamOnRequest)
+{
+    FakeBackend backend;
+    TextureStreamer streamer(backend, createConfig());
+    streamer.addTexture(0, kMipSizes);
+
+    // One mip level is streamed per update until the requested level is resident.
+    streamer.requestMip(0, 1);
+    streamer.requestMip(0, 2);
+    EXPECT_EQ(streamer.update(), 1);
+    EXPECT_EQ(streamer.getResidentMip(0), 2);
+    EXPECT_EQ(streamer.update(), 1);
+    EXPECT_EQ(streamer.getResidentMip(0), 1);
+    EXPECT_EQ(streamer.update(), 0);
+    EXPECT_EQ(streamer.getResidentMip(0), 1);
+
+    // Requests are clamped to the mip tail.
+    streamer.requestMip(0, 100);
+    EXPECT_EQ(streamer.update(), 0);
+    EXPECT_EQ(streamer.getResidentMip(0), 1);
+
+    auto stats = streamer.getStats();
+    EXPECT_EQ(stats.uploadCount, 2);
+    EXPECT_EQ(stats.uploadedBytes, kMipSizes[1] + kMipSizes[2]);
+    EXPECT_EQ(stats.residentBytes, getResidentBytes(1));
+    EXPECT_EQ(stats.evictionCount, 0);
+}
+
+CPU_TEST(TextureStreamer_Priority)
+{
+    FakeBackend backend;
+    auto config = createConfig();
+    config.maxUploadsPerUpdate = 1;
+    TextureStreamer streamer(backend, config);
+    for (uint32_t id = 0; id < 3; ++id)
+        streamer.addTexture(id, kMipSizes);
+    backend.calls.clear();
+
+    // Texture 0 was requested in an earlier update, textures 1 and 2 in the latest one.
+    // Texture 2 is furthest from its requested mip, so it goes first.
+    streamer.requestMip(0, 0);
+    streamer.update();
+    streamer.requestMip(1, 2);
+    streamer.requestMip(2, 0);
+    streamer.update();
+    streamer.update();
+    streamer.update();
+
+    ASSERT_EQ(backend.calls.size(), 4);
+    EXPECT_EQ(backend.calls[0].first, 0); // Only request in the first update.
+    EXPECT_EQ(backend.calls[1].first, 2); // Most recent and largest difference.
+    EXPECT_EQ(backend.calls[2].first, 2); // Still the largest difference.
+    EXPECT_EQ(backend.calls[3].first, 1); // Same difference, lowest ID.
+}
+
+CPU_TEST(TextureStreamer_EvictLeastRecentlyUsed)
+{
+    FakeBackend backend;
+    TextureStreamer streamer(backend, createConfig(getResidentBytes(0) + getResidentBytes(3)));
+    streamer.addTexture(0, kMipSizes);
+    streamer.addTexture(1, kMipSizes);
+
+    // Stream texture 0 fully, filling the budget.
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        streamer.requestMip(0, 0);
+        streamer.update();
+    }
+    EXPECT_EQ(streamer.getResidentMip(0), 0);
+
+    // Texture 1 is now in use and texture 0 is not. Texture 0 only gives up as many mips as needed.
+    streamer.requestMip(1, 0);
+    streamer.update();
+    EXPECT_EQ(streamer.getResidentMip(0), 1);
+    EXPECT_EQ(streamer.getResidentMip(1), 2);
+
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        streamer.requestMip(1, 0);
+        streamer.update();
+    }
+    EXPECT_EQ(streamer.getResidentMip(0), 3);
+    EXPECT_EQ(streamer.getResidentMip(1), 0);
+
+    auto stats = streamer.getStats();
+    EXPECT_LE(stats.residentBytes, streamer.getConfig().budgetInBytes);
+    EXPECT_EQ(stats.evictionCount, 2);
+    EXPECT_EQ(stats.evictedBytes, getResidentBytes(0) - getResidentBytes(3));
+}
+
+CPU_TEST(TextureStreamer_KeepTexturesInUse)
+{
+    FakeBackend backend;
+    TextureStreamer streamer(backend, createConfig(getResidentBytes(0) + getResidentBytes(3)));
+    streamer.addTexture(0, kMipSizes);
+    streamer.addTexture(1, kMipSizes);
+
+    // Both textures are used every update. They are streamed in lockstep until the next level doesn't fit.
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        streamer.requestMip(0, 0);
+        streamer.requestMip(1, 0);
+        streamer.update();
+    }
+
+    auto stats = streamer.getStats();
+    EXPECT_EQ(streamer.getResidentMip(0), 1);
+    EXPECT_EQ(streamer.getResidentMip(1), 1);
+    EXPECT_LE(stats.residentBytes, streamer.getConfig().budgetInBytes);
+    EXPECT_EQ(stats.evictionCount, 0);
+}
+
+CPU_TEST(TextureStreamer_TrimOverResident)
+{
+    FakeBackend backend;
+    TextureStreamer streamer(backend, createConfig(getResidentBytes(0) + getResidentBytes(2)));
+    streamer.addTexture(0, kMipSizes);
+    streamer.addTexture(1, kMipSizes);
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        streamer.requestMip(0, 0);
+        streamer.update();
+    }
+    EXPECT_EQ(streamer.getResidentMip(0), 0);
+
+    // Texture 0 is still in use but now only needs mip 2. It is trimmed to make room for texture 1.
+    streamer.requestMip(0, 2);
+    streamer.requestMip(1, 2);
+    streamer.update();
+    EXPECT_EQ(streamer.getResidentMip(0), 0);
+    EXPECT_EQ(streamer.getResidentMip(1), 2);
+
+    streamer.requestMip(0, 2);
+    streamer.requestMip(1, 0);
+    streamer.update();
+    EXPECT_EQ(streamer.getResidentMip(0), 1);
+    EXPECT_EQ(streamer.getResidentMip(1), 1);
+
+    // Reducing the budget evicts textures not in use.
+    auto config = streamer.getConfig();
+    config.budgetInBytes = getResidentBytes(3) * 2;
+    streamer.setConfig(config);
+    streamer.update();
+    EXPECT_EQ(streamer.getResidentMip(0), 3);
+    EXPECT_EQ(streamer.getResidentMip(1), 3);
+}
+
+CPU_TEST(TextureStreamer_UploadCost)
+{
+    // Streaming in a level uploads the whole chain from that level, which counts against the upload limit.
+    FakeBackend backend;
+    auto config = createConfig();
+    config.maxUploadBytesPerUpdate = 2 * getResidentBytes(2) - 1;
+    TextureStreamer streamer(backend, config);
+    streamer.addTexture(0, kMipSizes);
+    streamer.addTexture(1, kMipSizes);
+
+    streamer.requestMip(0, 2);
+    streamer.requestMip(1, 2);
+    EXPECT_EQ(streamer.update(), 1);
+    EXPECT_EQ(streamer.update(), 1);
+    EXPECT_EQ(streamer.getResidentMip(0), 2);
+    EXPECT_EQ(streamer.getResidentMip(1), 2);
+}
+
+CPU_TEST(TextureStreamer_RequestsExpire)
+{
+    FakeBackend backend;
+    auto config = createConfig();
+    config.requestLifetime = 2;
+    TextureStreamer streamer(backend, config);
+    streamer.addTexture(0, kMipSizes);
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        streamer.requestMip(0, 0);
+        streamer.update();
+    }
+    EXPECT_EQ(streamer.getResidentMip(0), 0);
+
+    // Once the request has expired, the texture is trimmed by a reduced budget and not streamed in again.
+    for (uint32_t i = 0; i < 5; ++i)
+        streamer.update();
+    config.budgetInBytes = getResidentBytes(3);
+    streamer.setConfig(config);
+    streamer.update();
+    EXPECT_EQ(streamer.getResidentMip(0), 3);
+
+    config.budgetInBytes = std::numeric_limits<uint64_t>::max();
+    streamer.setConfig(config);
+    for (uint32_t i = 0; i < 3; ++i)
+        EXPECT_EQ(streamer.update(), 0);
+    EXPECT_EQ(streamer.getResidentMip(0), 3);
+}
+
+CPU_TEST(TextureStreamer_WaitForLoads)
+{
+    FakeBackend backend;
+    TextureStreamer streamer(backend, createConfig());
+    streamer.addTexture(0, kMipSizes);
+
+    // The next mip level is only streamed in once the previous load has finished.
+    streamer.requestMip(0, 0);
+    EXPECT_EQ(streamer.update(), 1);
+    backend.loadingIDs.insert(0);
+    streamer.requestMip(0, 0);
+    EXPECT_EQ(streamer.update(), 0);
+    EXPECT_EQ(streamer.getResidentMip(0), 2);
+    backend.loadingIDs.clear();
+    streamer.requestMip(0, 0);
+    EXPECT_EQ(streamer.update(), 1);
+    EXPECT_EQ(streamer.getResidentMip(0), 1);
+}
+
+CPU_TEST(TextureStreamer_MarkFailed)
+{
+    FakeBackend backend;
+    TextureStreamer streamer(backend, createConfig());
+    streamer.addTexture(0, kMipSizes);
+
+    streamer.requestMip(0, 0);
+    streamer.update();
+    EXPECT_EQ(streamer.getResidentMip(0), 2);
+
+    // An asynchronous load failed. The texture falls back to its mip tail until requested again.
+    streamer.markFailed(0);
+    EXPECT_EQ(streamer.getResidentMip(0), 3);
+    EXPECT_EQ(streamer.getStats().residentBytes, getResidentBytes(3));
+    EXPECT_EQ(streamer.getStats().failureCount, 1);
+    EXPECT_EQ(streamer.update(), 0);
+
+    streamer.requestMip(0, 0);
+    EXPECT_EQ(streamer.update(), 1);
+    EXPECT_EQ(streamer.getResidentMip(0), 2);
+}
+} // namespace Falcor
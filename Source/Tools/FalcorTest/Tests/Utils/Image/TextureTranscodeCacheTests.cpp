@@ -0,0 +1,153 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/TextureTranscodeCache.h"
+#include "Utils/Image/TextureManager.h"
+
+namespace Falcor
+{
+namespace
+{
+std::vector<uint8_t> createRGBA(uint32_t width, uint32_t height, uint8_t alpha)
+{
+    std::vector<uint8_t> data(4 * width * height);
+    for (uint32_t i = 0; i < width * height; ++i)
+    {
+        data[4 * i + 0] = (uint8_t)(i * 7);
+        data[4 * i + 1] = (uint8_t)(i * 13);
+        data[4 * i + 2] = (uint8_t)(i * 29);
+        data[4 * i + 3] = alpha;
+    }
+    return data;
+}
+
+std::filesystem::path writePNG(const std::string& name, uint32_t width, uint32_t height, uint8_t alpha)
+{
+    auto path = getRuntimeDirectory() / name;
+    auto data = createRGBA(width, height, alpha);
+    Bitmap::saveImage(
+        path, width, height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::ExportAlpha, ResourceFormat::RGBA8Unorm, true, data.data()
+    );
+    return path;
+}
+} // namespace
+
+CPU_TEST(TextureTranscodeCache_SelectCompressionMode)
+{
+    auto opaque = createRGBA(8, 8, 255);
+    auto translucent = createRGBA(8, 8, 128);
+
+    auto mode = [](uint32_t width, uint32_t height, ResourceFormat format, const std::vector<uint8_t>& data)
+    { return TextureTranscodeCache::selectCompressionMode(*Bitmap::create(width, height, format, data.data())); };
+
+    EXPECT(mode(8, 8, ResourceFormat::RGBA8Unorm, opaque) == ImageIO::CompressionMode::BC1);
+    EXPECT(mode(8, 8, ResourceFormat::BGRA8Unorm, translucent) == ImageIO::CompressionMode::BC7);
+    EXPECT(mode(8, 8, ResourceFormat::BGRX8Unorm, translucent) == ImageIO::CompressionMode::BC1);
+    EXPECT(mode(16, 8, ResourceFormat::RG8Unorm, opaque) == ImageIO::CompressionMode::BC5);
+    EXPECT(mode(32, 8, ResourceFormat::R8Unorm, opaque) == ImageIO::CompressionMode::None);
+    EXPECT(mode(2, 32, ResourceFormat::RGBA8Unorm, opaque) == ImageIO::CompressionMode::None); // Not a multiple of 4.
+    EXPECT(mode(4, 4, ResourceFormat::RGBA16Float, opaque) == ImageIO::CompressionMode::None);
+}
+
+CPU_TEST(TextureTranscodeCache_HitMiss)
+{
+    const auto cacheDir = getRuntimeDirectory() / "test_texture_transcode_cache";
+    std::filesystem::remove_all(cacheDir);
+
+    const auto path = writePNG("test_transcode.png", 64, 32, 255);
+    const auto copyPath = getRuntimeDirectory() / "test_transcode_copy.png";
+    std::filesystem::copy_file(path, copyPath, std::filesystem::copy_options::overwrite_existing);
+    const auto oddPath = writePNG("test_transcode_odd.png", 30, 30, 255);
+
+    TextureTranscodeCache cache(cacheDir);
+
+    // First lookup transcodes.
+    auto cachePath = cache.getOrCreate(path, true, Bitmap::ImportFlags::None);
+    EXPECT(!cachePath.empty());
+    EXPECT(std::filesystem::exists(cachePath));
+    EXPECT_EQ(cache.getStats().misses, 1);
+
+    // Same content hits, independent of the file name.
+    EXPECT(cache.getOrCreate(path, true, Bitmap::ImportFlags::None) == cachePath);
+    EXPECT(cache.getOrCreate(copyPath, true, Bitmap::ImportFlags::None) == cachePath);
+    EXPECT_EQ(cache.getStats().hits, 2);
+
+    // sRGB state is part of the key.
+    auto linearPath = cache.getOrCreate(path, false, Bitmap::ImportFlags::None);
+    EXPECT(!linearPath.empty());
+    EXPECT(linearPath != cachePath);
+    EXPECT_EQ(cache.getStats().misses, 2);
+
+    // Images that would be cropped are skipped, also on later lookups.
+    EXPECT(cache.getOrCreate(oddPath, true, Bitmap::ImportFlags::None).empty());
+    EXPECT(cache.getOrCreate(oddPath, true, Bitmap::ImportFlags::None).empty());
+    EXPECT_EQ(cache.getStats().skipped, 2);
+    EXPECT_EQ(cache.getStats().failures, 0);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(copyPath);
+    std::filesystem::remove(oddPath);
+    std::filesystem::remove_all(cacheDir);
+}
+
+GPU_TEST(TextureTranscodeCache_TextureManager)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    const auto cacheDir = getRuntimeDirectory() / "test_texture_manager_transcode_cache";
+    std::filesystem::remove_all(cacheDir);
+    const auto opaquePath = writePNG("test_transcode_opaque.png", 64, 64, 255);
+    const auto translucentPath = writePNG("test_transcode_translucent.png", 64, 64, 128);
+
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        TextureManager textureManager(pDevice, 10);
+        textureManager.setTranscodeCacheEnabled(true, cacheDir);
+
+        auto opaqueHandle = textureManager.loadTexture(opaquePath, true, true, ResourceBindFlags::ShaderResource, false);
+        auto translucentHandle = textureManager.loadTexture(translucentPath, true, false, ResourceBindFlags::ShaderResource, false);
+        auto opaque = textureManager.getTexture(opaqueHandle);
+        auto translucent = textureManager.getTexture(translucentHandle);
+        ASSERT(opaque != nullptr);
+        ASSERT(translucent != nullptr);
+
+        EXPECT_EQ((uint32_t)opaque->getFormat(), (uint32_t)ResourceFormat::BC1UnormSrgb);
+        EXPECT_EQ((uint32_t)translucent->getFormat(), (uint32_t)ResourceFormat::BC7Unorm);
+        EXPECT_EQ(opaque->getMipCount(), 7);
+        EXPECT(opaque->getSourcePath() == opaquePath);
+
+        auto stats = textureManager.getStats();
+        EXPECT_EQ(stats.transcodeCacheMisses, pass == 0 ? 2 : 0);
+        EXPECT_EQ(stats.transcodeCacheHits, pass == 0 ? 0 : 2);
+    }
+
+    std::filesystem::remove(opaquePath);
+    std::filesystem::remove(translucentPath);
+    std::filesystem::remove_all(cacheDir);
+}
+} // namespace Falcor
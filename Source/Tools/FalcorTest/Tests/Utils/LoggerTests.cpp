@@ -0,0 +1,191 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Logger.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+/// Logs to the log file only while in scope and restores the logger settings afterwards.
+class FileOnlyLogger
+{
+public:
+    FileOnlyLogger(uint32_t repeatLimit)
+        : mVerbosity(Logger::getVerbosity()), mOutputs(Logger::getOutputs()), mRepeatLimit(Logger::getRepeatLimit())
+    {
+        Logger::setVerbosity(Logger::Level::Info);
+        Logger::setOutputs(Logger::OutputFlags::File);
+        Logger::setRepeatLimit(repeatLimit);
+    }
+
+    ~FileOnlyLogger()
+    {
+        Logger::flush();
+        Logger::setVerbosity(mVerbosity);
+        Logger::setOutputs(mOutputs);
+        Logger::setRepeatLimit(mRepeatLimit);
+    }
+
+private:
+    Logger::Level mVerbosity;
+    Logger::OutputFlags mOutputs;
+    uint32_t mRepeatLimit;
+};
+
+/// Returns the lines of the log file starting with a prefix.
+std::vector<std::string> readLogLines(const std::string& prefix)
+{
+    Logger::flush();
+    std::vector<std::string> lines;
+    std::ifstream file(Logger::getLogFilePath());
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.compare(0, prefix.size(), prefix) == 0)
+            lines.push_back(line);
+    }
+    return lines;
+}
+} // namespace
+
+CPU_TEST(Logger_ConcurrentThreads)
+{
+    const size_t kThreadCount = 8;
+    const size_t kMessageCount = 5000; // More than fits in a thread's buffer.
+    const std::string prefix = "(Info) Logger_ConcurrentThreads ";
+
+    {
+        FileOnlyLogger logger(0);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < kThreadCount; t++)
+        {
+            threads.emplace_back(
+                [t]()
+                {
+                    for (size_t i = 0; i < kMessageCount; i++)
+                        logInfo("Logger_ConcurrentThreads {} {}", t, i);
+                }
+            );
+        }
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    // Every message is written once, and the messages of each thread are in order.
+    std::vector<std::string> lines = readLogLines(prefix);
+    EXPECT_EQ(lines.size(), kThreadCount * kMessageCount);
+    std::vector<size_t> nextIndex(kThreadCount, 0);
+    for (const auto& line : lines)
+    {
+        size_t t = 0, i = 0;
+        EXPECT_EQ(std::sscanf(line.c_str() + prefix.size(), "%zu %zu", &t, &i), 2);
+        if (t >= kThreadCount)
+            continue;
+        EXPECT_EQ(i, nextIndex[t]);
+        nextIndex[t] = i + 1;
+    }
+}
+
+CPU_TEST(Logger_RepeatLimit)
+{
+    const uint32_t kRepeatLimit = 10;
+    const std::string message = "Logger_RepeatLimit message";
+
+    {
+        FileOnlyLogger logger(kRepeatLimit);
+        for (size_t i = 0; i < 50; i++)
+            logInfo(message);
+        Logger::flush();
+
+        // Repeats are counted per second, the number of dropped messages is reported when the second has passed.
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        Logger::flush();
+        logInfo(message);
+    }
+
+    EXPECT_EQ(readLogLines("(Info) " + message).size(), size_t(kRepeatLimit + 1));
+    EXPECT_EQ(readLogLines("(Info) Suppressed 40 repeats of: " + message).size(), size_t(1));
+}
+
+CPU_TEST(Logger_Once)
+{
+    const std::string message = "Logger_Once message";
+    {
+        FileOnlyLogger logger(0);
+        for (size_t i = 0; i < 10; i++)
+            logWarningOnce(message);
+    }
+    EXPECT_EQ(readLogLines("(Warning) " + message).size(), size_t(1));
+}
+
+CPU_TEST(Logger_Benchmark, TAGS("benchmark"))
+{
+    const size_t kMessageCount = 100000;
+    const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    FileOnlyLogger logger(0);
+    for (uint32_t threadCount : {1u, 4u, hardwareThreads, 4 * hardwareThreads})
+    {
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back(
+                [=]()
+                {
+                    for (size_t i = t; i < kMessageCount; i += threadCount)
+                        logInfo("Logger_Benchmark {} {}", t, i);
+                }
+            );
+        }
+        for (auto& thread : threads)
+            thread.join();
+        double logTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+        Logger::flush();
+        double totalTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+
+        logInfo(
+            "Logger_Benchmark: {} messages from {} threads logged in {:.2f} ms, written in {:.2f} ms ({:.0f} ns per message).",
+            kMessageCount,
+            threadCount,
+            logTime,
+            totalTime,
+            totalTime * 1e6 / kMessageCount
+        );
+    }
+}
+} // namespace Falcor
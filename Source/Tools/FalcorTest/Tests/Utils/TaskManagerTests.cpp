@@ -0,0 +1,280 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/TaskManager.h"
+#include "Utils/Threading.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <algorithm>
+#include <atomic>
+#include <execution>
+#include <numeric>
+#include <stdexcept>
+
+namespace Falcor
+{
+CPU_TEST(ParallelFor_CoversRange)
+{
+    for (size_t count : {0, 1, 7, 1000, 100000})
+    {
+        for (size_t grainSize : {0, 1, 3, 4096})
+        {
+            std::vector<std::atomic<uint32_t>> visits(count);
+            parallelFor(0, count, [&](size_t i) { visits[i]++; }, grainSize);
+            EXPECT(std::all_of(visits.begin(), visits.end(), [](const auto& v) { return v.load() == 1; }));
+        }
+    }
+
+    std::vector<std::atomic<uint32_t>> visits(1000);
+    parallelForRange(
+        100,
+        900,
+        [&](size_t first, size_t end)
+        {
+            EXPECT_LE(end - first, size_t(64));
+            for (size_t i = first; i < end; i++)
+                visits[i]++;
+        },
+        64
+    );
+    for (size_t i = 0; i < visits.size(); i++)
+        EXPECT_EQ(visits[i].load(), (i >= 100 && i < 900) ? 1u : 0u);
+}
+
+CPU_TEST(ParallelFor_Nested)
+{
+    // Nested loops run on the calling threads of the inner loops, so they complete even if every worker is busy.
+    const size_t kOuterCount = 64;
+    const size_t kInnerCount = 1000;
+    std::atomic<size_t> sum{0};
+    parallelFor(
+        0,
+        kOuterCount,
+        [&](size_t)
+        {
+            parallelFor(0, kInnerCount, [&](size_t i) { sum += i; }, 16);
+        },
+        1
+    );
+    EXPECT_EQ(sum.load(), kOuterCount * kInnerCount * (kInnerCount - 1) / 2);
+}
+
+CPU_TEST(ParallelFor_Exception)
+{
+    bool thrown = false;
+    try
+    {
+        parallelFor(0, 1000, [](size_t i) { if (i == 500) throw std::runtime_error("failure"); }, 10);
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    EXPECT(thrown);
+}
+
+CPU_TEST(ParallelReduce_Sum)
+{
+    std::vector<uint64_t> values(100000);
+    std::iota(values.begin(), values.end(), 1);
+
+    uint64_t sum = parallelReduce(
+        0,
+        values.size(),
+        uint64_t(0),
+        [&](size_t first, size_t end) { return std::accumulate(values.begin() + first, values.begin() + end, uint64_t(0)); },
+        [](uint64_t a, uint64_t b) { return a + b; },
+        1000
+    );
+    EXPECT_EQ(sum, uint64_t(100000) * 100001 / 2);
+    EXPECT_EQ(parallelReduce(5, 5, 42, [](size_t, size_t) { return 0; }, [](int a, int b) { return a + b; }, 1), 42);
+}
+
+CPU_TEST(ParallelExclusiveScan)
+{
+    for (size_t count : {0, 1, 4095, 4096, 100000})
+    {
+        std::vector<uint32_t> values(count);
+        for (size_t i = 0; i < count; i++)
+            values[i] = uint32_t(i * 7 % 13);
+        std::vector<uint32_t> expected(count);
+        std::exclusive_scan(values.begin(), values.end(), expected.begin(), 5u);
+
+        std::vector<uint32_t> result(count);
+        uint32_t total = parallelExclusiveScan(values.begin(), values.end(), result.begin(), 5u);
+        EXPECT(result == expected);
+        EXPECT_EQ(total, count > 0 ? expected.back() + values.back() : 5u);
+
+        // In-place scan.
+        parallelExclusiveScan(values.begin(), values.end(), values.begin(), 5u);
+        EXPECT(values == expected);
+    }
+}
+
+CPU_TEST(ParallelSort)
+{
+    for (size_t count : {0, 1, 4097, 100000})
+    {
+        std::vector<uint32_t> values(count);
+        for (size_t i = 0; i < count; i++)
+            values[i] = uint32_t(i * 2654435761u % 1000);
+        std::vector<uint32_t> expected = values;
+        std::sort(expected.begin(), expected.end());
+
+        parallelSort(values.begin(), values.end());
+        EXPECT(values == expected);
+
+        parallelSort(values.begin(), values.end(), std::greater<>());
+        EXPECT(std::equal(values.begin(), values.end(), expected.rbegin()));
+    }
+}
+
+CPU_TEST(TaskGraph_Dependencies)
+{
+    // Diamond-shaped graphs in sequence: a -> (b, c) -> d -> ...
+    TaskGraph graph;
+    std::atomic<uint32_t> step{0};
+    std::vector<uint32_t> order(400);
+    auto record = [&](size_t i) { return [&, i]() { order[i] = step++; }; };
+
+    TaskGraph::TaskID prev = graph.addTask("root", record(0));
+    for (size_t i = 1; i + 2 < order.size(); i += 3)
+    {
+        auto b = graph.addTask("b", record(i), {prev});
+        auto c = graph.addTask("c", record(i + 1), {prev});
+        prev = graph.addTask("d", record(i + 2), {b, c});
+    }
+    EXPECT_EQ(graph.getTaskCount(), size_t(400));
+
+    for (int run = 0; run < 2; run++)
+    {
+        step = 0;
+        graph.run();
+        EXPECT_EQ(step.load(), 400u);
+        for (size_t i = 1; i + 2 < order.size(); i += 3)
+        {
+            EXPECT(order[i] > order[i - 1]);
+            EXPECT(order[i + 1] > order[i - 1]);
+            EXPECT(order[i + 2] > order[i]);
+            EXPECT(order[i + 2] > order[i + 1]);
+        }
+    }
+}
+
+CPU_TEST(TaskGraph_Exception)
+{
+    TaskGraph graph;
+    bool independentRan = false;
+    bool dependentRan = false;
+    auto failing = graph.addTask("failing", []() { throw std::runtime_error("failure"); });
+    graph.addTask("independent", [&]() { independentRan = true; });
+    graph.addTask("dependent", [&]() { dependentRan = true; }, {failing});
+
+    bool thrown = false;
+    try
+    {
+        graph.run();
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    EXPECT(thrown);
+    EXPECT(independentRan);
+    EXPECT(!dependentRan);
+}
+
+CPU_TEST(ThreadPool_TaskObserver)
+{
+    std::mutex mutex;
+    std::vector<std::string> names;
+    ThreadPool::get().setTaskObserver(
+        [&](const char* name, double durationMs)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            names.push_back(name);
+            EXPECT_GE(durationMs, 0.0);
+        }
+    );
+
+    parallelFor(0, 100, [](size_t) {}, 10, "loop");
+    parallelFor(0, 100, [](size_t) {}, 10);
+    TaskGraph graph;
+    graph.addTask("task", []() {});
+    graph.run();
+    ThreadPool::get().setTaskObserver({});
+
+    std::sort(names.begin(), names.end());
+    EXPECT(names == std::vector<std::string>({"loop", "task"}));
+}
+
+CPU_TEST(Threading_DispatchTaskException)
+{
+    // A throwing task is still reported as finished.
+    Threading::Task task = Threading::dispatchTask([]() { throw std::runtime_error("failure"); });
+    task.finish();
+    EXPECT(!task.isRunning());
+    Threading::finish();
+}
+
+CPU_TEST(ParallelFor_SchedulingOverhead, TAGS("benchmark"))
+{
+    // Measure the cost of dispatching and joining loops with trivial bodies.
+    const int iterations = 2000;
+    for (size_t chunkCount : {1, 16, 256})
+    {
+        std::atomic<size_t> sum{0};
+        auto start = CpuTimer::getCurrentTimePoint();
+        for (int i = 0; i < iterations; i++)
+            parallelFor(0, chunkCount, [&](size_t j) { sum.fetch_add(j, std::memory_order_relaxed); }, 1);
+        double us = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) * 1e3 / iterations;
+        logInfo("parallelFor: {} chunks, {:.2f} us per loop", chunkCount, us);
+
+        std::vector<size_t> indices(chunkCount);
+        std::iota(indices.begin(), indices.end(), 0);
+        start = CpuTimer::getCurrentTimePoint();
+        for (int i = 0; i < iterations; i++)
+            std::for_each(std::execution::par, indices.begin(), indices.end(), [&](size_t j) { sum.fetch_add(j, std::memory_order_relaxed); });
+        us = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) * 1e3 / iterations;
+        logInfo("std::for_each(par): {} chunks, {:.2f} us per loop", chunkCount, us);
+    }
+
+    std::atomic<uint32_t> count{0};
+    auto start = CpuTimer::getCurrentTimePoint();
+    for (int i = 0; i < iterations / 10; i++)
+    {
+        TaskGraph graph;
+        auto root = graph.addTask("root", [&]() { count++; });
+        for (int j = 0; j < 16; j++)
+            graph.addTask("leaf", [&]() { count++; }, {root});
+        graph.run();
+    }
+    double us = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) * 1e3 / (iterations / 10);
+    logInfo("TaskGraph: 17 tasks, {:.2f} us per run", us);
+    EXPECT_EQ(count.load(), uint32_t(iterations / 10 * 17));
+}
+} // namespace Falcor
@@ -0,0 +1,550 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "FLIP.h"
+#include "Utils/Math/Common.h"
+#include "Utils/Math/Vector.h"
+#include "Utils/TaskManager.h"
+#include "Utils/Color/ColorHelpers.slang"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace Falcor;
+
+namespace
+{
+/// Tiles are processed in parallel. Each tile also filters a border of the filter radius around it.
+const uint32_t kTileWidth = 256;
+const uint32_t kTileHeight = 64;
+
+/// Maximum number of exposures evaluated by HDR-FLIP. Same as the range exposed by the FLIPPass UI.
+const uint32_t kMaxExposures = 20;
+
+const float kPi = 3.14159265358979323846f;
+const float kSqrt1_2 = 0.70710678118654752440f;
+
+// FLIP constants (see FLIPPass.cs.slang).
+const float kQc = 0.7f;
+const float kPc = 0.4f;
+const float kPt = 0.95f;
+const float kW = 0.082f;
+const float kQf = 0.5f;
+
+/// Number of horizontally filtered planes per image.
+const size_t kFilteredPlaneCount = 7;
+
+/// Returns the rational polynomial coefficients of the ACES and Hable tone mappers.
+/// For Reinhard the coefficients are only used for computing the exposure parameters.
+std::array<float, 6> getToneMapperCoefficients(FLIPToneMapper toneMapper)
+{
+    switch (toneMapper)
+    {
+    case FLIPToneMapper::ACES:
+        // 0.6 is pre-exposure cancellation.
+        return {0.6f * 0.6f * 2.51f, 0.6f * 0.03f, 0.0f, 0.6f * 0.6f * 2.43f, 0.6f * 0.59f, 0.14f};
+    case FLIPToneMapper::Hable:
+        // Includes white scale and exposure bias.
+        return {0.231683f, 0.013791f, 0.0f, 0.18f, 0.3f, 0.018f};
+    case FLIPToneMapper::Reinhard:
+        return {0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f};
+    }
+    throw std::runtime_error("Unknown tone mapper");
+}
+
+float3 toneMap(float3 color, FLIPToneMapper toneMapper, const std::array<float, 6>& k)
+{
+    if (toneMapper == FLIPToneMapper::Reinhard)
+    {
+        float Y = luminance(color);
+        return float3(
+            std::clamp(color.x / (Y + 1.f), 0.f, 1.f), std::clamp(color.y / (Y + 1.f), 0.f, 1.f), std::clamp(color.z / (Y + 1.f), 0.f, 1.f)
+        );
+    }
+
+    auto map = [&k](float c)
+    {
+        float nom = k[0] * c * c + k[1] * c + k[2];
+        float denom = k[3] * c * c + k[4] * c + k[5];
+        if (std::isinf(denom))
+            denom = 1.f; // Avoid inf / inf division.
+        return std::clamp(nom / denom, 0.f, 1.f);
+    };
+    return float3(map(color.x), map(color.y), map(color.z));
+}
+
+float HyAB(float3 a, float3 b)
+{
+    float3 diff = a - b;
+    return std::fabs(diff.x) + std::sqrt(diff.y * diff.y + diff.z * diff.z);
+}
+
+float3 Hunt(float3 color)
+{
+    float huntValue = 0.01f * color.x;
+    return float3(color.x, huntValue * color.y, huntValue * color.z);
+}
+
+float3 saturate(float3 c)
+{
+    return float3(std::clamp(c.x, 0.f, 1.f), std::clamp(c.y, 0.f, 1.f), std::clamp(c.z, 0.f, 1.f));
+}
+
+/**
+ * Filter kernels and constants derived from the FLIP options.
+ * The CSF and feature kernels of FLIPPass are sums of products of 1D functions, which allows filtering separably.
+ * All kernels have 2 * radius + 1 taps and are applied as correlations with clamped addressing, like in FLIPPass.
+ */
+struct FLIPParameters
+{
+    int radius;
+    std::vector<float> csfA;     ///< Normalized CSF Gaussian of the achromatic channel.
+    std::vector<float> csfRG;    ///< Normalized CSF Gaussian of the red-green channel.
+    std::vector<float> csfBY1;   ///< Normalized first CSF Gaussian of the blue-yellow channel.
+    std::vector<float> csfBY2;   ///< Normalized second CSF Gaussian of the blue-yellow channel.
+    float weightBY1;             ///< Relative weight of the first blue-yellow Gaussian.
+    float weightBY2;             ///< Relative weight of the second blue-yellow Gaussian.
+    std::vector<float> gaussian; ///< Feature detection Gaussian (unnormalized).
+    std::vector<float> point;    ///< Point detection kernel including the 2D normalization.
+    std::vector<float> edge;     ///< Edge detection kernel including the 2D normalization.
+    float maxDistance;
+
+    bool isHDR;
+    FLIPToneMapper toneMapper;
+    std::array<float, 6> toneMapperCoefficients;
+};
+
+FLIPParameters createParameters(const FLIPOptions& options)
+{
+    FLIPParameters params;
+
+    const float ppd = options.monitorDistanceMeters * (options.monitorWidthPixels / options.monitorWidthMeters) * (kPi / 180.f);
+    const float dx = 1.f / ppd;
+
+    // Use radius of the spatial filter kernel, as it is always greater than or equal to the radius of the feature detection kernel.
+    params.radius = int(std::ceil(3.f * std::sqrt(0.04f / (2.f * kPi * kPi)) * ppd));
+    const int size = 2 * params.radius + 1;
+
+    // The 2D CSF kernel a * sqrt(pi / b) * exp(-pi^2 * (x^2 + y^2) * dx^2 / b) is the product of two 1D Gaussians.
+    // Returns the sum of the 2D kernel and stores the normalized 1D Gaussian.
+    auto createCSFKernel = [&](float a, float b, std::vector<float>& kernel)
+    {
+        kernel.resize(size);
+        double sum = 0.0;
+        for (int i = 0; i < size; ++i)
+        {
+            float p = (i - params.radius) * dx;
+            kernel[i] = std::exp(-p * p * kPi * kPi / b);
+            sum += kernel[i];
+        }
+        for (float& w : kernel)
+            w = float(w / sum);
+        return a * std::sqrt(kPi / b) * sum * sum;
+    };
+    createCSFKernel(1.f, 0.0047f, params.csfA);
+    createCSFKernel(1.f, 0.0053f, params.csfRG);
+    double sumBY1 = createCSFKernel(34.1f, 0.04f, params.csfBY1);
+    double sumBY2 = createCSFKernel(13.5f, 0.025f, params.csfBY2);
+    params.weightBY1 = float(sumBY1 / (sumBY1 + sumBY2));
+    params.weightBY2 = float(sumBY2 / (sumBY1 + sumBY2));
+
+    // Feature kernels. FLIPPass normalizes by sums over the 2D kernels, which factor into the 1D sum times the Gaussian sum.
+    const float sigmaFeatures = 0.5f * kW * ppd;
+    const float sigmaFeaturesSquared = sigmaFeatures * sigmaFeatures;
+    params.gaussian.resize(size);
+    params.point.resize(size);
+    params.edge.resize(size);
+    double gaussianSum = 0.0;
+    double positiveKernelSum = 0.0;
+    double negativeKernelSum = 0.0;
+    double edgeKernelSum = 0.0;
+    for (int i = 0; i < size; ++i)
+    {
+        float x = float(i - params.radius);
+        float g = std::exp(-(x * x) / (2.f * sigmaFeaturesSquared));
+        params.gaussian[i] = g;
+        params.point[i] = (x * x / sigmaFeaturesSquared - 1.f) * g;
+        params.edge[i] = -x * g;
+        gaussianSum += g;
+        positiveKernelSum += std::max(params.point[i], 0.f);
+        negativeKernelSum += std::max(-params.point[i], 0.f);
+        edgeKernelSum += std::max(params.edge[i], 0.f);
+    }
+    for (int i = 0; i < size; ++i)
+    {
+        params.point[i] = float(params.point[i] / ((params.point[i] >= 0.f ? positiveKernelSum : negativeKernelSum) * gaussianSum));
+        params.edge[i] = float(params.edge[i] / (edgeKernelSum * gaussianSum));
+    }
+
+    params.maxDistance =
+        std::pow(HyAB(Hunt(linearRGBToCIELab(float3(0.f, 1.f, 0.f))), Hunt(linearRGBToCIELab(float3(0.f, 0.f, 1.f)))), kQc);
+
+    params.isHDR = options.isHDR;
+    params.toneMapper = options.toneMapper;
+    params.toneMapperCoefficients = getToneMapperCoefficients(options.toneMapper);
+
+    return params;
+}
+
+float3 getLinearColor(const Image& image, uint32_t x, uint32_t y)
+{
+    const float* texel = image.getData() + (size_t(y) * image.getWidth() + x) * 4;
+    float3 color(texel[0], texel[1], texel[2]);
+    return image.isHDR() ? color : sRGBToLinear(color);
+}
+
+/// Returns the HDR-FLIP exposures computed from the median and maximum luminance of the reference image.
+std::vector<float> computeExposures(const Image& reference, const FLIPParameters& params)
+{
+    const uint32_t width = reference.getWidth();
+    const uint32_t height = reference.getHeight();
+
+    std::vector<float> luminances(size_t(width) * height);
+    parallelFor(
+        0,
+        height,
+        [&](uint32_t y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+                luminances[size_t(y) * width + x] = luminance(getLinearColor(reference, x, y));
+        }
+    );
+    luminances.erase(std::remove_if(luminances.begin(), luminances.end(), [](float Y) { return !std::isfinite(Y); }), luminances.end());
+    if (luminances.empty())
+        return {0.f};
+
+    const size_t mid = luminances.size() / 2;
+    std::nth_element(luminances.begin(), luminances.begin() + mid, luminances.end());
+    float Ymedian = luminances[mid];
+    if ((luminances.size() & 1) == 0)
+        Ymedian = (*std::max_element(luminances.begin(), luminances.begin() + mid) + Ymedian) * 0.5f;
+    float Ymax = *std::max_element(luminances.begin() + mid, luminances.end());
+    if (Ymax <= 0.f)
+        return {0.f};
+    Ymedian = std::max(Ymedian, std::numeric_limits<float>::min());
+
+    // Solve a * x^2 + b * x + c = 0 for the exposure mapping the tone mapped value to 0.85.
+    const auto& k = params.toneMapperCoefficients;
+    const float t = 0.85f;
+    const float a = k[0] - t * k[3];
+    const float b = k[1] - t * k[4];
+    const float c = k[2] - t * k[5];
+    float xMax;
+    if (a == 0.f)
+    {
+        xMax = -c / b;
+    }
+    else
+    {
+        float d1 = -0.5f * (b / a);
+        float d2 = std::sqrt((d1 * d1) - (c / a));
+        xMax = d1 + d2;
+    }
+
+    const float startExposure = std::log2(xMax / Ymax);
+    const float stopExposure = std::log2(xMax / Ymedian);
+    const uint32_t numExposures = uint32_t(std::clamp(std::ceil(stopExposure - startExposure), 2.f, float(kMaxExposures)));
+    const float exposureDelta = (stopExposure - startExposure) / (numExposures - 1.f);
+
+    std::vector<float> exposures(numExposures);
+    for (uint32_t i = 0; i < numExposures; ++i)
+        exposures[i] = startExposure + i * exposureDelta;
+    return exposures;
+}
+
+/// Correlates each row of src with the kernel. Rows of src are width + kernel.size() - 1 values wide.
+void filterRows(
+    const float* src,
+    size_t srcPitch,
+    float* dst,
+    size_t dstPitch,
+    uint32_t width,
+    uint32_t rows,
+    const std::vector<float>& kernel
+)
+{
+    for (uint32_t y = 0; y < rows; ++y)
+    {
+        const float* s = src + y * srcPitch;
+        float* d = dst + y * dstPitch;
+        std::fill_n(d, width, 0.f);
+        // Loop over taps first so the inner loop is a contiguous multiply-add the compiler vectorizes.
+        for (size_t k = 0; k < kernel.size(); ++k)
+        {
+            const float w = kernel[k];
+            for (uint32_t x = 0; x < width; ++x)
+                d[x] += w * s[x + k];
+        }
+    }
+}
+
+/// Correlates the columns of src with the kernel and writes a single row.
+void filterColumns(const float* src, size_t srcPitch, float* dst, uint32_t width, const std::vector<float>& kernel)
+{
+    std::fill_n(dst, width, 0.f);
+    for (size_t k = 0; k < kernel.size(); ++k)
+    {
+        const float w = kernel[k];
+        const float* s = src + k * srcPitch;
+        for (uint32_t x = 0; x < width; ++x)
+            dst[x] += w * s[x];
+    }
+}
+
+/**
+ * Per-image scratch memory of a tile.
+ */
+struct TilePlanes
+{
+    std::vector<float> ycxcz[3];                      ///< Input color in YCxCz, including the filter border.
+    std::vector<float> lum;                           ///< Normalized luminance for feature detection, including the filter border.
+    std::vector<float> filtered[kFilteredPlaneCount]; ///< Horizontally filtered planes, including the vertical filter border.
+    std::vector<float> row[8];                        ///< Vertically filtered values of the current row.
+};
+
+/// Indices into TilePlanes::filtered.
+enum FilteredPlane
+{
+    kFilteredY,
+    kFilteredCx,
+    kFilteredBY1,
+    kFilteredBY2,
+    kFilteredLumGaussian,
+    kFilteredLumPoint,
+    kFilteredLumEdge,
+};
+
+/// Indices into TilePlanes::row.
+enum RowValue
+{
+    kRowY,
+    kRowCx,
+    kRowBY1,
+    kRowBY2,
+    kRowPointX,
+    kRowPointY,
+    kRowEdgeX,
+    kRowEdgeY,
+};
+
+/**
+ * Loads the tile including the filter border, converts it to YCxCz and filters it horizontally.
+ */
+void prepareTile(
+    const Image& image,
+    const FLIPParameters& params,
+    float exposure,
+    int x0,
+    int y0,
+    uint32_t tileWidth,
+    uint32_t tileHeight,
+    TilePlanes& planes
+)
+{
+    const int r = params.radius;
+    const uint32_t paddedWidth = tileWidth + 2 * r;
+    const uint32_t paddedHeight = tileHeight + 2 * r;
+    const int maxX = int(image.getWidth()) - 1;
+    const int maxY = int(image.getHeight()) - 1;
+    const float exposureScale = std::exp2(exposure);
+
+    for (uint32_t y = 0; y < paddedHeight; ++y)
+    {
+        uint32_t srcY = uint32_t(std::clamp(y0 - r + int(y), 0, maxY));
+        for (uint32_t x = 0; x < paddedWidth; ++x)
+        {
+            uint32_t srcX = uint32_t(std::clamp(x0 - r + int(x), 0, maxX));
+            float3 color = getLinearColor(image, srcX, srcY);
+            if (params.isHDR)
+            {
+                color = float3(std::max(color.x, 0.f), std::max(color.y, 0.f), std::max(color.z, 0.f));
+                color = toneMap(color * exposureScale, params.toneMapper, params.toneMapperCoefficients);
+            }
+            else
+            {
+                color = saturate(color);
+            }
+            float3 ycxcz = linearRGBToYCxCz(color);
+
+            size_t i = size_t(y) * paddedWidth + x;
+            planes.ycxcz[0][i] = ycxcz.x;
+            planes.ycxcz[1][i] = ycxcz.y;
+            planes.ycxcz[2][i] = ycxcz.z;
+            planes.lum[i] = (ycxcz.x + 16.f) / 116.f; // Normalized Y from YCxCz.
+        }
+    }
+
+    auto filter = [&](const std::vector<float>& src, FilteredPlane dst, const std::vector<float>& kernel)
+    { filterRows(src.data(), paddedWidth, planes.filtered[dst].data(), tileWidth, tileWidth, paddedHeight, kernel); };
+    filter(planes.ycxcz[0], kFilteredY, params.csfA);
+    filter(planes.ycxcz[1], kFilteredCx, params.csfRG);
+    filter(planes.ycxcz[2], kFilteredBY1, params.csfBY1);
+    filter(planes.ycxcz[2], kFilteredBY2, params.csfBY2);
+    filter(planes.lum, kFilteredLumGaussian, params.gaussian);
+    filter(planes.lum, kFilteredLumPoint, params.point);
+    filter(planes.lum, kFilteredLumEdge, params.edge);
+}
+
+/**
+ * Filters row y of a prepared tile vertically.
+ */
+void filterTileRow(const FLIPParameters& params, uint32_t tileWidth, uint32_t y, TilePlanes& planes)
+{
+    auto filter = [&](FilteredPlane src, RowValue dst, const std::vector<float>& kernel)
+    { filterColumns(planes.filtered[src].data() + size_t(y) * tileWidth, tileWidth, planes.row[dst].data(), tileWidth, kernel); };
+    filter(kFilteredY, kRowY, params.csfA);
+    filter(kFilteredCx, kRowCx, params.csfRG);
+    filter(kFilteredBY1, kRowBY1, params.csfBY1);
+    filter(kFilteredBY2, kRowBY2, params.csfBY2);
+    filter(kFilteredLumPoint, kRowPointX, params.gaussian);
+    filter(kFilteredLumGaussian, kRowPointY, params.point);
+    filter(kFilteredLumEdge, kRowEdgeX, params.gaussian);
+    filter(kFilteredLumGaussian, kRowEdgeY, params.edge);
+}
+
+float redistributeErrors(const FLIPParameters& params, float colorDifference, float featureDifference)
+{
+    float error = std::pow(colorDifference, kQc);
+
+    // Normalization.
+    float perceptualCutoff = kPc * params.maxDistance;
+
+    if (error < perceptualCutoff)
+        error *= (kPt / perceptualCutoff);
+    else
+        error = kPt + ((error - perceptualCutoff) / (params.maxDistance - perceptualCutoff)) * (1.0f - kPt);
+
+    return std::pow(error, (1.0f - featureDifference));
+}
+
+float computeLDRFLIP(const FLIPParameters& params, const TilePlanes& reference, const TilePlanes& test, uint32_t x)
+{
+    auto getFilteredColor = [&](const TilePlanes& planes)
+    {
+        float Cz = params.weightBY1 * planes.row[kRowBY1][x] + params.weightBY2 * planes.row[kRowBY2][x];
+        return saturate(YCxCzToLinearRGB(float3(planes.row[kRowY][x], planes.row[kRowCx][x], Cz)));
+    };
+    auto getGradientLength = [&](const TilePlanes& planes, RowValue gradientX, RowValue gradientY)
+    { return std::sqrt(planes.row[gradientX][x] * planes.row[gradientX][x] + planes.row[gradientY][x] * planes.row[gradientY][x]); };
+
+    // Color pipeline.
+    float colorDiff =
+        HyAB(Hunt(linearRGBToCIELab(getFilteredColor(reference))), Hunt(linearRGBToCIELab(getFilteredColor(test))));
+
+    // Feature pipeline.
+    float edgeDifference = std::fabs(getGradientLength(reference, kRowEdgeX, kRowEdgeY) - getGradientLength(test, kRowEdgeX, kRowEdgeY));
+    float pointDifference =
+        std::fabs(getGradientLength(reference, kRowPointX, kRowPointY) - getGradientLength(test, kRowPointX, kRowPointY));
+    float featureDiff = std::pow(std::max(pointDifference, edgeDifference) * kSqrt1_2, kQf);
+
+    return redistributeErrors(params, colorDiff, featureDiff);
+}
+} // namespace
+
+double computeFLIP(const Image& reference, const Image& test, const FLIPOptions& options, float* errorMap)
+{
+    if (reference.getWidth() != test.getWidth() || reference.getHeight() != test.getHeight())
+        throw std::runtime_error("Cannot compare images with different resolutions");
+
+    const uint32_t width = reference.getWidth();
+    const uint32_t height = reference.getHeight();
+    if (width == 0 || height == 0)
+        return 0.0;
+
+    const FLIPParameters params = createParameters(options);
+    const std::vector<float> exposures = params.isHDR ? computeExposures(reference, params) : std::vector<float>{0.f};
+
+    const uint32_t tilesX = div_round_up(width, kTileWidth);
+    const uint32_t tilesY = div_round_up(height, kTileHeight);
+    std::vector<double> tileSums(size_t(tilesX) * tilesY);
+
+    parallelFor(
+        0,
+        tilesX * tilesY,
+        [&](uint32_t tileIndex)
+        {
+            const uint32_t x0 = (tileIndex % tilesX) * kTileWidth;
+            const uint32_t y0 = (tileIndex / tilesX) * kTileHeight;
+            const uint32_t tileWidth = std::min(kTileWidth, width - x0);
+            const uint32_t tileHeight = std::min(kTileHeight, height - y0);
+            const size_t paddedWidth = tileWidth + 2 * params.radius;
+            const size_t paddedHeight = tileHeight + 2 * params.radius;
+
+            TilePlanes planes[2];
+            for (auto& p : planes)
+            {
+                for (auto& plane : p.ycxcz)
+                    plane.resize(paddedWidth * paddedHeight);
+                p.lum.resize(paddedWidth * paddedHeight);
+                for (auto& plane : p.filtered)
+                    plane.resize(tileWidth * paddedHeight);
+                for (auto& row : p.row)
+                    row.resize(tileWidth);
+            }
+
+            // HDR-FLIP is the maximum LDR-FLIP over a range of exposures.
+            std::vector<float> tileError(size_t(tileWidth) * tileHeight, 0.f);
+            for (size_t e = 0; e < exposures.size(); ++e)
+            {
+                prepareTile(reference, params, exposures[e], x0, y0, tileWidth, tileHeight, planes[0]);
+                prepareTile(test, params, exposures[e], x0, y0, tileWidth, tileHeight, planes[1]);
+                for (uint32_t y = 0; y < tileHeight; ++y)
+                {
+                    filterTileRow(params, tileWidth, y, planes[0]);
+                    filterTileRow(params, tileWidth, y, planes[1]);
+                    float* dst = tileError.data() + size_t(y) * tileWidth;
+                    for (uint32_t x = 0; x < tileWidth; ++x)
+                    {
+                        float value = computeLDRFLIP(params, planes[0], planes[1], x);
+                        if (!params.isHDR || value > dst[x])
+                            dst[x] = value;
+                    }
+                }
+            }
+
+            double sum = 0.0;
+            for (uint32_t y = 0; y < tileHeight; ++y)
+            {
+                const float* src = tileError.data() + size_t(y) * tileWidth;
+                for (uint32_t x = 0; x < tileWidth; ++x)
+                    sum += src[x];
+                if (errorMap)
+                    std::copy_n(src, tileWidth, errorMap + size_t(y0 + y) * width + x0);
+            }
+            tileSums[tileIndex] = sum;
+        }
+    );
+
+    double sum = 0.0;
+    for (double tileSum : tileSums)
+        sum += tileSum;
+    return sum / (double(width) * height);
+}
@@ -0,0 +1,66 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Image.h"
+
+#include <cstdint>
+
+/**
+ * Tone mappers assumed by HDR-FLIP. Matches FLIPToneMapperType of the FLIPPass render pass.
+ */
+enum class FLIPToneMapper : uint32_t
+{
+    ACES,
+    Hable,
+    Reinhard,
+};
+
+/**
+ * Options for computing FLIP on the CPU. The defaults match the defaults of the FLIPPass render pass.
+ */
+struct FLIPOptions
+{
+    bool isHDR = false;                               ///< Use HDR-FLIP (maximum LDR-FLIP over a range of exposures).
+    FLIPToneMapper toneMapper = FLIPToneMapper::ACES; ///< Tone mapper used by HDR-FLIP.
+    uint32_t monitorWidthPixels = 3840;               ///< Horizontal resolution of the viewing monitor.
+    float monitorWidthMeters = 0.7f;                  ///< Width of the viewing monitor in meters.
+    float monitorDistanceMeters = 0.7f;               ///< Distance of the viewer to the monitor in meters.
+};
+
+/**
+ * Compute the FLIP error between a reference and a test image.
+ * This is a CPU implementation of the FLIPPass render pass (with input clamping enabled). The color and feature
+ * filters are evaluated separably on tiles that are processed in parallel.
+ * Images that are not HDR (see Image::isHDR()) are assumed to be sRGB encoded and are converted to linear RGB.
+ * @param[in] reference Reference image.
+ * @param[in] test Test image. Must have the same resolution as the reference image.
+ * @param[in] options FLIP options.
+ * @param[out] errorMap Optional buffer of width * height values receiving the per-pixel FLIP error.
+ * @return Returns the mean FLIP error.
+ */
+double computeFLIP(const Image& reference, const Image& test, const FLIPOptions& options, float* errorMap = nullptr);
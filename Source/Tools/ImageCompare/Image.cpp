@@ -0,0 +1,154 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Image.h"
+
+#include <FreeImage.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include <cstring>
+
+std::shared_ptr<Image> Image::loadFromFile(const std::filesystem::path& path)
+{
+    FREE_IMAGE_FORMAT fifFormat = FIF_UNKNOWN;
+
+    auto pathStr = path.string();
+
+    // Determine file format.
+    fifFormat = FreeImage_GetFileType(pathStr.c_str(), 0);
+    if (fifFormat == FIF_UNKNOWN)
+        fifFormat = FreeImage_GetFIFFromFilename(pathStr.c_str());
+    if (fifFormat == FIF_UNKNOWN)
+        throw std::runtime_error("Unknown image format");
+    if (!FreeImage_FIFSupportsReading(fifFormat))
+        throw std::runtime_error("Unsupported image format");
+
+    // Read image.
+    FIBITMAP* srcBitmap = FreeImage_Load(fifFormat, pathStr.c_str());
+    if (!srcBitmap)
+        throw std::runtime_error("Cannot read image");
+
+    FREE_IMAGE_TYPE srcType = FreeImage_GetImageType(srcBitmap);
+    bool isHDR = srcType == FIT_FLOAT || srcType == FIT_RGBF || srcType == FIT_RGBAF;
+
+    // Convert to RGBA32F.
+    FIBITMAP* floatBitmap = FreeImage_ConvertToRGBAF(srcBitmap);
+    FreeImage_Unload(srcBitmap);
+    if (!floatBitmap)
+        throw std::runtime_error("Cannot convert to RGBA float format");
+
+    // Create image.
+    auto image = create(FreeImage_GetWidth(floatBitmap), FreeImage_GetHeight(floatBitmap));
+    image->mIsHDR = isHDR;
+    int bytesPerPixel = 4 * sizeof(float);
+    FreeImage_ConvertToRawBits(
+        reinterpret_cast<BYTE*>(image->getData()),
+        floatBitmap,
+        bytesPerPixel * image->getWidth(),
+        bytesPerPixel * 8,
+        FI_RGBA_RED_MASK,
+        FI_RGBA_GREEN_MASK,
+        FI_RGBA_BLUE_MASK,
+        true
+    );
+    FreeImage_Unload(floatBitmap);
+
+    return image;
+}
+
+void Image::saveToFile(const std::filesystem::path& path, bool writeAlpha) const
+{
+    FREE_IMAGE_FORMAT fifFormat = FIF_UNKNOWN;
+
+    auto pathStr = path.string();
+
+    // Determine file format.
+    fifFormat = FreeImage_GetFIFFromFilename(pathStr.c_str());
+    if (fifFormat == FIF_UNKNOWN)
+        throw std::runtime_error("Unknown image format");
+    if (!FreeImage_FIFSupportsWriting(fifFormat))
+        throw std::runtime_error("Unsupported image format");
+
+    bool writeFloat = fifFormat == FIF_EXR || fifFormat == FIF_PFM || fifFormat == FIF_HDR;
+    if (fifFormat != FIF_EXR && fifFormat != FIF_PNG)
+        writeAlpha = false;
+
+    // Create bitmap.
+    FIBITMAP* bitmap;
+    const float* src = getData();
+    if (writeFloat)
+    {
+        bitmap = FreeImage_AllocateT(writeAlpha ? FIT_RGBAF : FIT_RGBF, mWidth, mHeight);
+        for (uint32_t y = 0; y < mHeight; y++)
+        {
+            float* dst = reinterpret_cast<float*>(FreeImage_GetScanLine(bitmap, mHeight - y - 1));
+            if (writeAlpha)
+            {
+                std::memcpy(dst, src, mWidth * 4 * sizeof(float));
+                src += mWidth * 4;
+            }
+            else
+            {
+                for (uint32_t x = 0; x < mWidth; ++x)
+                {
+                    dst[0] = src[0];
+                    dst[1] = src[1];
+                    dst[2] = src[2];
+                    dst += 3;
+                    src += 4;
+                }
+            }
+        }
+    }
+    else
+    {
+        bitmap = FreeImage_Allocate(mWidth, mHeight, writeAlpha ? 32 : 24);
+        for (uint32_t y = 0; y < mHeight; y++)
+        {
+            uint8_t* dst = reinterpret_cast<uint8_t*>(FreeImage_GetScanLine(bitmap, mHeight - y - 1));
+            for (uint32_t x = 0; x < mWidth; ++x)
+            {
+                dst[2] = std::clamp(int(src[0] * 255.f), 0, 255);
+                dst[1] = std::clamp(int(src[1] * 255.f), 0, 255);
+                dst[0] = std::clamp(int(src[2] * 255.f), 0, 255);
+                if (writeAlpha)
+                    dst[3] = std::clamp(int(src[3] * 255.f), 0, 255);
+                dst += writeAlpha ? 4 : 3;
+                src += 4;
+            }
+        }
+    }
+
+    // Write image.
+    bool success = FreeImage_Save(fifFormat, bitmap, pathStr.c_str());
+    FreeImage_Unload(bitmap);
+    if (!success)
+        throw std::runtime_error("Cannot write image");
+}
@@ -0,0 +1,65 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+/**
+ * RGBA32F image stored in top-down row order.
+ */
+class Image
+{
+public:
+    Image(uint32_t width, uint32_t height)
+        : mWidth(width), mHeight(height), mData(std::make_unique<float[]>(size_t(width) * height * 4))
+    {}
+
+    uint32_t getWidth() const { return mWidth; }
+    uint32_t getHeight() const { return mHeight; }
+    const float* getData() const { return mData.get(); }
+    float* getData() { return mData.get(); }
+
+    /**
+     * Returns true if the image was loaded from a floating-point file format (e.g. EXR, PFM, HDR).
+     * Other images hold the normalized (sRGB encoded) values of the file.
+     */
+    bool isHDR() const { return mIsHDR; }
+
+    static std::shared_ptr<Image> create(uint32_t width, uint32_t height) { return std::make_shared<Image>(width, height); }
+
+    static std::shared_ptr<Image> loadFromFile(const std::filesystem::path& path);
+
+    void saveToFile(const std::filesystem::path& path, bool writeAlpha = true) const;
+
+private:
+    uint32_t mWidth;
+    uint32_t mHeight;
+    bool mIsHDR = false;
+    std::unique_ptr<float[]> mData;
+};
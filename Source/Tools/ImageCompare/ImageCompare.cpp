@@ -25,26 +25,31 @@
  # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
-#include <FreeImage.h>
+#include "Image.h"
+#include "ImageMetrics.h"
+#include "Utils/TaskManager.h"
+
 #include <args.hxx>
+#include <nlohmann/json.hpp>
 
 #include <iostream>
+#include <fstream>
 #include <memory>
 #include <string>
 #include <vector>
+#include <set>
 #include <stdexcept>
-#include <map>
-#include <functional>
+#include <limits>
+#include <algorithm>
 #include <filesystem>
 
 #include <cmath>
-#include <cstring>
 
-template<typename T>
-T sqr(T x)
-{
-    return x * x;
-}
+/// Image file extensions compared in batch mode.
+static const std::vector<std::string> kImageExtensions = {".png", ".jpg", ".tga", ".bmp", ".pfm", ".exr", ".hdr"};
+
+/// Suffix of heat maps written in batch mode. Files with this suffix are not compared.
+static const std::string kHeatMapSuffix = ".error.png";
 
 template<typename T>
 T lerp(T a, T b, T t)
@@ -52,220 +57,6 @@ T lerp(T a, T b, T t)
     return a + t * (b - a);
 }
 
-template<typename T>
-T clamp(T x, T lo, T hi)
-{
-    return std::max(lo, std::min(hi, x));
-}
-
-class Image
-{
-public:
-    Image(uint32_t width, uint32_t height) : mWidth(width), mHeight(height), mData(std::make_unique<float[]>(width * height * 4)) {}
-
-    uint32_t getWidth() const { return mWidth; }
-    uint32_t getHeight() const { return mHeight; }
-    const float* getData() const { return mData.get(); }
-    float* getData() { return mData.get(); }
-
-    static std::shared_ptr<Image> create(uint32_t width, uint32_t height) { return std::make_shared<Image>(width, height); }
-
-    static std::shared_ptr<Image> loadFromFile(const std::filesystem::path& path)
-    {
-        FREE_IMAGE_FORMAT fifFormat = FIF_UNKNOWN;
-
-        auto pathStr = path.string();
-
-        // Determine file format.
-        fifFormat = FreeImage_GetFileType(pathStr.c_str(), 0);
-        if (fifFormat == FIF_UNKNOWN)
-            fifFormat = FreeImage_GetFIFFromFilename(pathStr.c_str());
-        if (fifFormat == FIF_UNKNOWN)
-            throw std::runtime_error("Unknown image format");
-        if (!FreeImage_FIFSupportsReading(fifFormat))
-            throw std::runtime_error("Unsupported image format");
-
-        // Read image.
-        FIBITMAP* srcBitmap = FreeImage_Load(fifFormat, pathStr.c_str());
-        if (!srcBitmap)
-            throw std::runtime_error("Cannot read image");
-
-        // Convert to RGBA32F.
-        FIBITMAP* floatBitmap = FreeImage_ConvertToRGBAF(srcBitmap);
-        FreeImage_Unload(srcBitmap);
-        if (!floatBitmap)
-            throw std::runtime_error("Cannot convert to RGBA float format");
-
-        // Create image.
-        auto image = create(FreeImage_GetWidth(floatBitmap), FreeImage_GetHeight(floatBitmap));
-        int bytesPerPixel = 4 * sizeof(float);
-        FreeImage_ConvertToRawBits(
-            reinterpret_cast<BYTE*>(image->getData()),
-            floatBitmap,
-            bytesPerPixel * image->getWidth(),
-            bytesPerPixel * 8,
-            FI_RGBA_RED_MASK,
-            FI_RGBA_GREEN_MASK,
-            FI_RGBA_BLUE_MASK,
-            true
-        );
-        FreeImage_Unload(floatBitmap);
-
-        return image;
-    }
-
-    void saveToFile(const std::filesystem::path& path, bool writeAlpha = true) const
-    {
-        FREE_IMAGE_FORMAT fifFormat = FIF_UNKNOWN;
-
-        auto pathStr = path.string();
-
-        // Determine file format.
-        fifFormat = FreeImage_GetFIFFromFilename(pathStr.c_str());
-        if (fifFormat == FIF_UNKNOWN)
-            throw std::runtime_error("Unknown image format");
-        if (!FreeImage_FIFSupportsWriting(fifFormat))
-            throw std::runtime_error("Unsupported image format");
-
-        bool writeFloat = fifFormat == FIF_EXR || fifFormat == FIF_PFM || fifFormat == FIF_HDR;
-        if (fifFormat != FIF_EXR && fifFormat != FIF_PNG)
-            writeAlpha = false;
-
-        // Create bitmap.
-        FIBITMAP* bitmap;
-        const float* src = getData();
-        if (writeFloat)
-        {
-            bitmap = FreeImage_AllocateT(writeAlpha ? FIT_RGBAF : FIT_RGBF, mWidth, mHeight);
-            for (uint32_t y = 0; y < mHeight; y++)
-            {
-                float* dst = reinterpret_cast<float*>(FreeImage_GetScanLine(bitmap, mHeight - y - 1));
-                if (writeAlpha)
-                {
-                    std::memcpy(dst, src, mWidth * 4 * sizeof(float));
-                    src += mWidth * 4;
-                }
-                else
-                {
-                    for (uint32_t x = 0; x < mWidth; ++x)
-                    {
-                        dst[0] = src[0];
-                        dst[1] = src[1];
-                        dst[2] = src[2];
-                        dst += 3;
-                        src += 4;
-                    }
-                }
-            }
-        }
-        else
-        {
-            bitmap = FreeImage_Allocate(mWidth, mHeight, writeAlpha ? 32 : 24);
-            for (uint32_t y = 0; y < mHeight; y++)
-            {
-                uint8_t* dst = reinterpret_cast<uint8_t*>(FreeImage_GetScanLine(bitmap, mHeight - y - 1));
-                for (uint32_t x = 0; x < mWidth; ++x)
-                {
-                    dst[2] = clamp(int(src[0] * 255.f), 0, 255);
-                    dst[1] = clamp(int(src[1] * 255.f), 0, 255);
-                    dst[0] = clamp(int(src[2] * 255.f), 0, 255);
-                    if (writeAlpha)
-                        dst[3] = clamp(int(src[3] * 255.f), 0, 255);
-                    dst += writeAlpha ? 4 : 3;
-                    src += 4;
-                }
-            }
-        }
-
-        // Write image.
-        FreeImage_Save(fifFormat, bitmap, pathStr.c_str());
-        FreeImage_Unload(bitmap);
-    }
-
-private:
-    uint32_t mWidth;
-    uint32_t mHeight;
-    std::unique_ptr<float[]> mData;
-};
-
-struct MSE
-{
-    double operator()(const float* a, const float* b, size_t count) const
-    {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i)
-            error += sqr(a[i] - b[i]);
-        return error / count;
-    }
-};
-
-struct RMSE
-{
-    double operator()(const float* a, const float* b, size_t count) const
-    {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i)
-            error += sqr(a[i] - b[i]) / (sqr(a[i]) + 1e-3);
-        return error / count;
-    }
-};
-
-struct MAE
-{
-    double operator()(const float* a, const float* b, size_t count) const
-    {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i)
-            error += std::fabs(sqr(a[i] - b[i]));
-        return error / count;
-    }
-};
-
-struct MAPE
-{
-    double operator()(const float* a, const float* b, size_t count) const
-    {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i)
-            error += std::fabs((a[i] - b[i]) / (a[i] + 1e-3));
-        return 100.0 * error / count;
-    }
-};
-
-template<typename Metric>
-double compare(const Image& imageA, const Image& imageB, bool alpha, float* errorMap)
-{
-    Metric metric;
-    double sum = 0.0;
-    const float* a = imageA.getData();
-    const float* b = imageB.getData();
-    size_t count = imageA.getWidth() * imageA.getHeight();
-    for (size_t i = 0; i < count; ++i)
-    {
-        double error = metric(a, b, alpha ? 4 : 3);
-        if (errorMap)
-            *errorMap++ = float(error);
-        sum += error;
-        a += 4;
-        b += 4;
-    }
-    return sum / count;
-}
-
-struct ErrorMetric
-{
-    std::string name;
-    std::string desc;
-    std::function<double(const Image& imageA, const Image& imageB, bool alpha, float* errorMap)> compare;
-};
-
-static const std::vector<ErrorMetric> errorMetrics = {
-    {"mse", "Mean Squared Error", compare<MSE>},
-    {"rmse", "Relative Mean Squared Error", compare<RMSE>},
-    {"mae", "Mean Absolute Error", compare<MAE>},
-    {"mape", "Mean Absolute Percentage Error", compare<MAPE>},
-};
-
 static std::shared_ptr<Image> generateHeatMap(uint32_t width, uint32_t height, const float* errorMap)
 {
     auto writeColor = [](float t, float* dst)
@@ -278,19 +69,20 @@ static std::shared_ptr<Image> generateHeatMap(uint32_t width, uint32_t height, c
             {1.f, 0.f, 0.f}, // red
         };
 
-        int c = clamp(int(std::floor(t * 4.f)), 0, 3);
+        int c = std::clamp(int(std::floor(t * 4.f)), 0, 3);
         for (size_t i = 0; i < 3; ++i)
             *dst++ = lerp(colors[c][i], colors[c + 1][i], t * 4.f - c);
         *dst++ = 1.f;
     };
 
-    const auto [minValue, maxValue] = std::minmax_element(errorMap, errorMap + width * height);
+    const size_t pixelCount = size_t(width) * height;
+    const auto [minValue, maxValue] = std::minmax_element(errorMap, errorMap + pixelCount);
     const float range = std::max(1e-5f, *maxValue - *minValue);
     auto image = Image::create(width, height);
     float* dst = image->getData();
-    for (size_t i = 0; i < width * height; ++i)
+    for (size_t i = 0; i < pixelCount; ++i)
     {
-        float t = clamp((errorMap[i] - *minValue) / range, 0.f, 1.f);
+        float t = std::clamp((errorMap[i] - *minValue) / range, 0.f, 1.f);
         writeColor(t, dst);
         dst += 4;
     }
@@ -298,82 +90,214 @@ static std::shared_ptr<Image> generateHeatMap(uint32_t width, uint32_t height, c
     return image;
 }
 
-static bool compareImages(
+struct CompareResult
+{
+    bool success = false;
+    double error = std::numeric_limits<double>::quiet_NaN();
+    std::string message;               ///< Reason if the images could not be compared.
+    std::filesystem::path heatMapPath; ///< Path of the written heat map (empty if none was written).
+};
+
+static CompareResult compareImages(
     const std::filesystem::path& pathA,
     const std::filesystem::path& pathB,
-    ErrorMetric metric,
+    const ErrorMetric& metric,
     float threshold,
     bool alpha,
-    const std::filesystem::path& heatMapPath
+    const std::filesystem::path& heatMapPath,
+    bool heatMapOnlyOnFailure
 )
 {
-    auto loadImage = [](const std::filesystem::path& path)
+    CompareResult result;
+
+    try
     {
+        // Load images.
+        std::shared_ptr<Image> imageA, imageB;
         try
         {
-            return Image::loadFromFile(path);
+            imageA = Image::loadFromFile(pathA);
+            imageB = Image::loadFromFile(pathB);
         }
         catch (const std::runtime_error& e)
         {
-            std::cerr << "Cannot load image from '" << path.string() << "' (Error: " << e.what() << ")." << std::endl;
-            return std::shared_ptr<Image>{};
+            result.message = "Cannot load image from '" + (imageA ? pathB : pathA).string() + "' (Error: " + e.what() + ").";
+            return result;
         }
-    };
 
-    auto saveImage = [](const Image& image, const std::filesystem::path& path)
-    {
-        try
+        // Check resolution.
+        if (imageA->getWidth() != imageB->getWidth() || imageA->getHeight() != imageB->getHeight())
         {
-            image.saveToFile(path);
+            result.message = "Cannot compare images with different resolutions.";
+            return result;
         }
-        catch (const std::runtime_error& e)
+
+        uint32_t width = imageA->getWidth();
+        uint32_t height = imageA->getHeight();
+
+        // Compare images.
+        std::unique_ptr<float[]> errorMap = heatMapPath.empty() ? nullptr : std::make_unique<float[]>(size_t(width) * height);
+        result.error = metric.compare(*imageA, *imageB, alpha, errorMap.get());
+
+        // Treat nans and infs as errors.
+        result.success = !std::isnan(result.error) && !std::isinf(result.error) && result.error <= threshold;
+
+        // Generate heat map.
+        if (errorMap && !(heatMapOnlyOnFailure && result.success))
         {
-            std::cerr << "Cannot save image to '" << path.string() << "' (Error: " << e.what() << ")." << std::endl;
+            auto heatMap = generateHeatMap(width, height, errorMap.get());
+            try
+            {
+                std::error_code ec;
+                if (heatMapPath.has_parent_path())
+                    std::filesystem::create_directories(heatMapPath.parent_path(), ec);
+                heatMap->saveToFile(heatMapPath);
+                result.heatMapPath = heatMapPath;
+            }
+            catch (const std::runtime_error& e)
+            {
+                std::cerr << "Cannot save image to '" << heatMapPath.string() << "' (Error: " << e.what() << ")." << std::endl;
+            }
         }
-    };
+    }
+    catch (const std::exception& e)
+    {
+        result.success = false;
+        result.message = e.what();
+    }
 
-    // Load images.
-    auto imageA = loadImage(pathA);
-    if (!imageA)
-        return false;
-    auto imageB = loadImage(pathB);
-    if (!imageB)
-        return false;
+    return result;
+}
 
-    // Check resolution.
-    if (imageA->getWidth() != imageB->getWidth() || imageA->getHeight() != imageB->getHeight())
+/// Returns the paths of all images in a directory tree, relative to the directory.
+static std::set<std::filesystem::path> collectImages(const std::filesystem::path& dir)
+{
+    std::set<std::filesystem::path> images;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dir))
     {
-        std::cerr << "Cannot compare images with different resolutions." << std::endl;
-        return false;
+        if (!entry.is_regular_file())
+            continue;
+        const auto& path = entry.path();
+        std::string filename = path.filename().string();
+        if (filename.size() >= kHeatMapSuffix.size() &&
+            filename.compare(filename.size() - kHeatMapSuffix.size(), kHeatMapSuffix.size(), kHeatMapSuffix) == 0)
+            continue;
+        std::string extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+        if (std::find(kImageExtensions.begin(), kImageExtensions.end(), extension) == kImageExtensions.end())
+            continue;
+        images.insert(std::filesystem::relative(path, dir));
     }
+    return images;
+}
 
-    uint32_t width = imageA->getWidth();
-    uint32_t height = imageB->getHeight();
+/**
+ * Compares all images of two directory trees. Images are paired by their relative path and compared concurrently.
+ * Heat maps are only written for failing pairs. Writes a JSON report to reportPath, or to stdout if it is empty.
+ * @return Returns true if all pairs passed.
+ */
+static bool compareDirectories(
+    const std::filesystem::path& dirA,
+    const std::filesystem::path& dirB,
+    const ErrorMetric& metric,
+    float threshold,
+    bool alpha,
+    const std::filesystem::path& heatMapDir,
+    const std::filesystem::path& reportPath,
+    uint32_t threadCount
+)
+{
+    for (const auto& dir : {dirA, dirB})
+    {
+        if (!std::filesystem::is_directory(dir))
+        {
+            std::cerr << "Directory '" << dir.string() << "' does not exist." << std::endl;
+            return false;
+        }
+    }
 
-    // Compare images.
-    std::unique_ptr<float[]> errorMap = heatMapPath.empty() ? nullptr : std::make_unique<float[]>(width * height);
-    double error = metric.compare(*imageA, *imageB, alpha, errorMap.get());
+    const auto imagesA = collectImages(dirA);
+    const auto imagesB = collectImages(dirB);
+    std::vector<std::filesystem::path> images;
+    std::set_union(imagesA.begin(), imagesA.end(), imagesB.begin(), imagesB.end(), std::back_inserter(images));
+
+    // One image pair per task, the metrics split each comparison into tiles on the same pool.
+    if (threadCount > 0)
+        Falcor::ThreadPool::get().setThreadCount(threadCount);
+    std::vector<CompareResult> results(images.size());
+    Falcor::parallelFor(
+        0,
+        images.size(),
+        [&](size_t i)
+        {
+            const auto& image = images[i];
+            if (!imagesA.count(image))
+            {
+                results[i].message = "Missing image in '" + dirA.string() + "'.";
+                return;
+            }
+            if (!imagesB.count(image))
+            {
+                results[i].message = "Missing image in '" + dirB.string() + "'.";
+                return;
+            }
+            std::filesystem::path heatMapPath = heatMapDir.empty() ? "" : heatMapDir / (image.string() + kHeatMapSuffix);
+            results[i] = compareImages(dirA / image, dirB / image, metric, threshold, alpha, heatMapPath, true);
+        },
+        1
+    );
 
-    // Generate heat map.
-    if (errorMap)
+    // Generate report.
+    nlohmann::ordered_json report;
+    report["reference"] = dirA.string();
+    report["test"] = dirB.string();
+    report["metric"] = metric.name;
+    report["threshold"] = threshold;
+    report["alpha"] = alpha;
+
+    size_t passedCount = 0;
+    nlohmann::ordered_json imageReports = nlohmann::ordered_json::array();
+    for (size_t i = 0; i < images.size(); ++i)
     {
-        auto heatMap = generateHeatMap(width, height, errorMap.get());
-        saveImage(*heatMap, heatMapPath);
+        const auto& result = results[i];
+        nlohmann::ordered_json imageReport;
+        imageReport["name"] = images[i].generic_string();
+        imageReport["success"] = result.success;
+        imageReport["error"] = result.error; // NaN is written as null.
+        if (!result.message.empty())
+            imageReport["message"] = result.message;
+        if (!result.heatMapPath.empty())
+            imageReport["heatMap"] = result.heatMapPath.string();
+        imageReports.push_back(imageReport);
+        if (result.success)
+            passedCount++;
     }
+    report["passed"] = passedCount;
+    report["failed"] = images.size() - passedCount;
+    report["images"] = std::move(imageReports);
 
-    std::cout << error << std::endl;
-
-    // Treat nans and infs as errors.
-    if (std::isnan(error) || std::isinf(error))
-        return false;
+    if (reportPath.empty())
+    {
+        std::cout << report.dump(4) << std::endl;
+    }
+    else
+    {
+        std::ofstream stream(reportPath);
+        if (!stream)
+        {
+            std::cerr << "Cannot write report to '" << reportPath.string() << "'." << std::endl;
+            return false;
+        }
+        stream << report.dump(4) << std::endl;
+    }
 
-    return error <= threshold;
+    return passedCount == images.size();
 }
 
 static void printMetrics(std::ostream& stream = std::cout)
 {
     stream << "Available error metrics:" << std::endl;
-    for (const auto& metric : errorMetrics)
+    for (const auto& metric : getErrorMetrics())
     {
         stream << "  " << metric.name << " - " << metric.desc << std::endl;
     }
@@ -388,9 +312,14 @@ int main(int argc, char** argv)
     args::ValueFlag<std::string> metricFlag(parser, "metric", "The error metric.", {'m'});
     args::ValueFlag<float> thresholdFlag(parser, "threshold", "The error threshold.", {'t'});
     args::Flag alphaFlag(parser, "", "Include alpha channel.", {'a'});
-    args::ValueFlag<std::string> heatMapFlag(parser, "filename", "Generate error heat map.", {'e'});
-    args::Positional<std::string> image1(parser, "image1", "The first image.", args::Options::Required);
-    args::Positional<std::string> image2(parser, "image2", "The second image.", args::Options::Required);
+    args::ValueFlag<std::string> heatMapFlag(
+        parser, "filename", "Generate error heat map. In batch mode, the directory for heat maps of failing images.", {'e'}
+    );
+    args::Flag batchFlag(parser, "", "Batch mode. Compare all images in two directory trees.", {'b'});
+    args::ValueFlag<std::string> reportFlag(parser, "filename", "Batch mode JSON report (default: stdout).", {'r'});
+    args::ValueFlag<uint32_t> threadsFlag(parser, "threads", "Number of worker threads (default: one less than the number of cores).", {'j'});
+    args::Positional<std::string> image1(parser, "image1", "The first (reference) image or directory.", args::Options::Required);
+    args::Positional<std::string> image2(parser, "image2", "The second image or directory.", args::Options::Required);
     args::CompletionFlag completionFlag(parser, {"complete"});
 
     try
@@ -426,6 +355,7 @@ int main(int argc, char** argv)
         return 0;
     }
 
+    const auto& errorMetrics = getErrorMetrics();
     ErrorMetric metric = errorMetrics.front();
     if (metricFlag)
     {
@@ -441,13 +371,32 @@ int main(int argc, char** argv)
         metric = *it;
     }
 
-    bool success = compareImages(
-        args::get(image1),
-        args::get(image2),
-        metric,
-        thresholdFlag ? args::get(thresholdFlag) : 0.f,
-        alphaFlag ? args::get(alphaFlag) : false,
-        heatMapFlag ? args::get(heatMapFlag) : ""
-    );
-    return success ? 0 : 1;
+    float threshold = thresholdFlag ? args::get(thresholdFlag) : 0.f;
+    bool alpha = alphaFlag ? args::get(alphaFlag) : false;
+    std::filesystem::path heatMapPath = heatMapFlag ? args::get(heatMapFlag) : "";
+
+    if (batchFlag)
+    {
+        bool success = compareDirectories(
+            args::get(image1),
+            args::get(image2),
+            metric,
+            threshold,
+            alpha,
+            heatMapPath,
+            reportFlag ? args::get(reportFlag) : "",
+            threadsFlag ? args::get(threadsFlag) : 0
+        );
+        return success ? 0 : 1;
+    }
+
+    CompareResult result = compareImages(args::get(image1), args::get(image2), metric, threshold, alpha, heatMapPath, false);
+    if (!result.message.empty())
+    {
+        std::cerr << result.message << std::endl;
+        return 1;
+    }
+
+    std::cout << result.error << std::endl;
+    return result.success ? 0 : 1;
 }
@@ -0,0 +1,265 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "ImageMetrics.h"
+#include "FLIP.h"
+#include "Utils/Math/Common.h"
+#include "Utils/TaskManager.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define IMAGE_METRICS_SSE 1
+#include <immintrin.h>
+#else
+#define IMAGE_METRICS_SSE 0
+#endif
+
+using namespace Falcor;
+
+namespace
+{
+/// Number of image rows per parallel task.
+const uint32_t kRowsPerTile = 16;
+
+template<typename T>
+T sqr(T x)
+{
+    return x * x;
+}
+
+/// How the per-pixel errors are reduced to the image error.
+enum class Reduction
+{
+    Mean,
+    RootMean,
+    Max,
+};
+
+// Each metric computes per-channel errors. The per-pixel error is the mean over the channels (or the maximum for
+// kMaxOverChannels metrics), and the image error is the reduction of the per-pixel errors.
+
+struct MSE
+{
+    static constexpr bool kMaxOverChannels = false;
+    static constexpr Reduction kReduction = Reduction::Mean;
+    static float eval(float a, float b) { return sqr(a - b); }
+#if IMAGE_METRICS_SSE
+    static __m128 eval(__m128 a, __m128 b)
+    {
+        __m128 d = _mm_sub_ps(a, b);
+        return _mm_mul_ps(d, d);
+    }
+#endif
+};
+
+struct RootMSE : MSE
+{
+    static constexpr Reduction kReduction = Reduction::RootMean;
+};
+
+struct RelativeMSE
+{
+    static constexpr bool kMaxOverChannels = false;
+    static constexpr Reduction kReduction = Reduction::Mean;
+    static float eval(float a, float b) { return sqr(a - b) / (sqr(a) + 1e-3f); }
+#if IMAGE_METRICS_SSE
+    static __m128 eval(__m128 a, __m128 b)
+    {
+        __m128 d = _mm_sub_ps(a, b);
+        return _mm_div_ps(_mm_mul_ps(d, d), _mm_add_ps(_mm_mul_ps(a, a), _mm_set1_ps(1e-3f)));
+    }
+#endif
+};
+
+#if IMAGE_METRICS_SSE
+__m128 abs(__m128 v)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.f), v);
+}
+#endif
+
+struct MAE
+{
+    static constexpr bool kMaxOverChannels = false;
+    static constexpr Reduction kReduction = Reduction::Mean;
+    static float eval(float a, float b) { return std::fabs(a - b); }
+#if IMAGE_METRICS_SSE
+    static __m128 eval(__m128 a, __m128 b) { return abs(_mm_sub_ps(a, b)); }
+#endif
+};
+
+struct MAPE
+{
+    static constexpr bool kMaxOverChannels = false;
+    static constexpr Reduction kReduction = Reduction::Mean;
+    static constexpr double kScale = 100.0;
+    static float eval(float a, float b) { return std::fabs((a - b) / (a + 1e-3f)); }
+#if IMAGE_METRICS_SSE
+    static __m128 eval(__m128 a, __m128 b) { return abs(_mm_div_ps(_mm_sub_ps(a, b), _mm_add_ps(a, _mm_set1_ps(1e-3f)))); }
+#endif
+};
+
+struct MaxAbs : MAE
+{
+    static constexpr bool kMaxOverChannels = true;
+    static constexpr Reduction kReduction = Reduction::Max;
+};
+
+template<typename Metric, typename = void>
+struct HasScale : std::false_type
+{};
+
+template<typename Metric>
+struct HasScale<Metric, std::void_t<decltype(Metric::kScale)>> : std::true_type
+{};
+
+template<typename Metric>
+constexpr double getScale()
+{
+    if constexpr (HasScale<Metric>::value)
+        return Metric::kScale;
+    else
+        return 1.0;
+}
+
+/// Maximum that propagates NaNs, so invalid pixels fail the comparison.
+float maxNaN(float a, float b)
+{
+    return (a > b || std::isnan(a)) ? a : b;
+}
+
+template<typename Metric>
+float evalPixel(const float* a, const float* b, uint32_t channelCount)
+{
+#if IMAGE_METRICS_SSE
+    // Evaluate all four channels at once and mask out alpha if it is excluded.
+    const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(channelCount == 4 ? -1 : 0, -1, -1, -1));
+    __m128 e = _mm_and_ps(Metric::eval(_mm_loadu_ps(a), _mm_loadu_ps(b)), mask);
+    if constexpr (Metric::kMaxOverChannels)
+    {
+        if (_mm_movemask_ps(_mm_cmpunord_ps(e, e)))
+            return std::numeric_limits<float>::quiet_NaN();
+        e = _mm_max_ps(e, _mm_movehl_ps(e, e));
+        e = _mm_max_ss(e, _mm_shuffle_ps(e, e, 1));
+        return _mm_cvtss_f32(e);
+    }
+    else
+    {
+        e = _mm_add_ps(e, _mm_movehl_ps(e, e));
+        e = _mm_add_ss(e, _mm_shuffle_ps(e, e, 1));
+        return _mm_cvtss_f32(e) / channelCount;
+    }
+#else
+    float error = 0.f;
+    for (uint32_t i = 0; i < channelCount; ++i)
+        error = Metric::kMaxOverChannels ? maxNaN(error, Metric::eval(a[i], b[i])) : error + Metric::eval(a[i], b[i]);
+    return Metric::kMaxOverChannels ? error : error / channelCount;
+#endif
+}
+
+template<typename Metric>
+double compare(const Image& reference, const Image& test, bool alpha, float* errorMap)
+{
+    if (reference.getWidth() != test.getWidth() || reference.getHeight() != test.getHeight())
+        throw std::runtime_error("Cannot compare images with different resolutions");
+
+    const uint32_t width = reference.getWidth();
+    const uint32_t height = reference.getHeight();
+    const uint32_t channelCount = alpha ? 4 : 3;
+    const uint32_t tileCount = div_round_up(height, kRowsPerTile);
+
+    // Reduce per tile and combine the tiles in order to get deterministic results.
+    std::vector<double> tileResults(tileCount);
+    parallelFor(
+        0,
+        tileCount,
+        [&](uint32_t tile)
+        {
+            const size_t first = size_t(tile) * kRowsPerTile * width;
+            const size_t last = size_t(std::min(height, (tile + 1) * kRowsPerTile)) * width;
+            const float* a = reference.getData() + first * 4;
+            const float* b = test.getData() + first * 4;
+            double result = 0.0;
+            for (size_t i = first; i < last; ++i, a += 4, b += 4)
+            {
+                float error = evalPixel<Metric>(a, b, channelCount);
+                if (errorMap)
+                    errorMap[i] = error;
+                if constexpr (Metric::kReduction == Reduction::Max)
+                    result = maxNaN(error, float(result));
+                else
+                    result += error;
+            }
+            tileResults[tile] = result;
+        }
+    );
+
+    double result = 0.0;
+    for (double tileResult : tileResults)
+    {
+        if constexpr (Metric::kReduction == Reduction::Max)
+            result = maxNaN(float(tileResult), float(result));
+        else
+            result += tileResult;
+    }
+
+    const double pixelCount = double(width) * height;
+    if constexpr (Metric::kReduction == Reduction::Mean)
+        result /= pixelCount;
+    else if constexpr (Metric::kReduction == Reduction::RootMean)
+        result = std::sqrt(result / pixelCount);
+    return getScale<Metric>() * result;
+}
+
+double compareFLIP(const Image& reference, const Image& test, bool /* alpha */, float* errorMap)
+{
+    // FLIP only considers color, so the alpha channel is always ignored. Use HDR-FLIP if any of the images has high dynamic range.
+    FLIPOptions options;
+    options.isHDR = reference.isHDR() || test.isHDR();
+    return computeFLIP(reference, test, options, errorMap);
+}
+} // namespace
+
+const std::vector<ErrorMetric>& getErrorMetrics()
+{
+    static const std::vector<ErrorMetric> errorMetrics = {
+        {"mse", "Mean Squared Error", compare<MSE>},
+        {"rmse", "Relative Mean Squared Error", compare<RelativeMSE>},
+        {"rootmse", "Root Mean Squared Error", compare<RootMSE>},
+        {"mae", "Mean Absolute Error", compare<MAE>},
+        {"mape", "Mean Absolute Percentage Error", compare<MAPE>},
+        {"maxabs", "Maximum Absolute Error", compare<MaxAbs>},
+        {"flip", "Mean FLIP error (HDR-FLIP for floating-point images)", compareFLIP},
+    };
+    return errorMetrics;
+}
@@ -30,7 +30,7 @@
 #include "Core/API/Device.h"
 #include "Utils/Logger.h"
 #include "Utils/StringUtils.h"
-#include "Utils/NumericRange.h"
+#include "Utils/TaskManager.h"
 #include "Utils/Timing/TimeReport.h"
 #include "Utils/Math/Common.h"
 #include "Utils/Math/FalcorMath.h"
@@ -46,8 +46,9 @@
 
 #include <pybind11/pybind11.h>
 
-#include <execution>
+#include <atomic>
 #include <fstream>
+#include <future>
 
 namespace Falcor
 {
@@ -562,103 +563,201 @@ void loadBones(const aiMesh* pAiMesh, const ImporterData& data, std::vector<floa
     }
 }
 
-void createMeshes(ImporterData& data)
+/**
+ * Vertex and index data converted from Assimp's layout for a single mesh.
+ * This only depends on the aiScene and can be produced while materials and the scene graph are being created.
+ */
+struct MeshGeometry
 {
-    const aiScene* pScene = data.pScene;
-    const bool loadTangents = is_set(data.builder.getFlags(), SceneBuilder::Flags::UseOriginalTangentSpace);
+    const aiMesh* pAiMesh = nullptr; ///< Source mesh or nullptr if the mesh is ignored.
+    std::vector<uint32_t> indices;
+    std::vector<float2> texCrds;
+    std::vector<float4> tangents;
+};
 
-    std::vector<const aiMesh*> meshes;
+std::vector<MeshGeometry> convertMeshGeometry(const aiScene* pScene, bool loadTangents)
+{
+    std::vector<MeshGeometry> geometry(pScene->mNumMeshes);
     for (uint32_t i = 0; i < pScene->mNumMeshes; ++i)
     {
         const aiMesh* pMesh = pScene->mMeshes[i];
         if (!pMesh->HasFaces())
         {
             logWarning("AssimpImporter: Mesh '{}' has no faces, ignoring.", pMesh->mName.C_Str());
-            meshes.push_back(nullptr);
             continue;
         }
         if (pMesh->mFaces->mNumIndices != 3)
         {
             logWarning("AssimpImporter: Mesh '{}' is not a triangle mesh, ignoring.", pMesh->mName.C_Str());
-            meshes.push_back(nullptr);
             continue;
         }
-        meshes.push_back(pMesh);
+        geometry[i].pAiMesh = pMesh;
     }
 
-    // Pre-process meshes.
-    std::vector<SceneBuilder::ProcessedMesh> processedMeshes(meshes.size());
-    auto range = NumericRange<size_t>(0, meshes.size());
-    std::for_each(
-        std::execution::par,
-        range.begin(),
-        range.end(),
+    parallelFor(
+        0,
+        geometry.size(),
         [&](size_t i)
         {
-            const aiMesh* pAiMesh = meshes[i];
+            MeshGeometry& g = geometry[i];
+            const aiMesh* pAiMesh = g.pAiMesh;
             if (!pAiMesh)
                 return;
-            const uint32_t perFaceIndexCount = pAiMesh->mFaces[0].mNumIndices;
-
-            SceneBuilder::Mesh mesh;
-            mesh.name = pAiMesh->mName.C_Str();
-            mesh.faceCount = pAiMesh->mNumFaces;
-
-            // Temporary memory for the vertex and index data.
-            std::vector<uint32_t> indexList;
-            std::vector<float2> texCrds;
-            std::vector<float4> tangents;
-            std::vector<uint4> boneIds;
-            std::vector<float4> boneWeights;
-
-            // Indices
-            createIndexList(pAiMesh, indexList);
-            FALCOR_ASSERT(indexList.size() <= std::numeric_limits<uint32_t>::max());
-            mesh.indexCount = (uint32_t)indexList.size();
-            mesh.pIndices = indexList.data();
-            mesh.topology = Vao::Topology::TriangleList;
-
-            // Vertices
-            FALCOR_ASSERT(pAiMesh->mVertices);
-            mesh.vertexCount = pAiMesh->mNumVertices;
-            static_assert(sizeof(pAiMesh->mVertices[0]) == sizeof(mesh.positions.pData[0]));
-            static_assert(sizeof(pAiMesh->mNormals[0]) == sizeof(mesh.normals.pData[0]));
-            mesh.positions.pData = reinterpret_cast<float3*>(pAiMesh->mVertices);
-            mesh.positions.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
-            mesh.normals.pData = reinterpret_cast<float3*>(pAiMesh->mNormals);
-            mesh.normals.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+
+            createIndexList(pAiMesh, g.indices);
+            FALCOR_ASSERT(g.indices.size() <= std::numeric_limits<uint32_t>::max());
 
             if (pAiMesh->HasTextureCoords(0))
             {
-                createTexCrdList(pAiMesh->mTextureCoords[0], pAiMesh->mNumVertices, texCrds);
-                FALCOR_ASSERT(!texCrds.empty());
-                mesh.texCrds.pData = texCrds.data();
-                mesh.texCrds.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+                createTexCrdList(pAiMesh->mTextureCoords[0], pAiMesh->mNumVertices, g.texCrds);
+                FALCOR_ASSERT(!g.texCrds.empty());
             }
 
             if (loadTangents && pAiMesh->HasTangentsAndBitangents())
             {
-                createTangentList(pAiMesh->mTangents, pAiMesh->mBitangents, pAiMesh->mNormals, pAiMesh->mNumVertices, tangents);
-                FALCOR_ASSERT(!tangents.empty());
-                mesh.tangents.pData = tangents.data();
-                mesh.tangents.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+                createTangentList(pAiMesh->mTangents, pAiMesh->mBitangents, pAiMesh->mNormals, pAiMesh->mNumVertices, g.tangents);
+                FALCOR_ASSERT(!g.tangents.empty());
             }
+        }
+    );
+
+    return geometry;
+}
 
-            if (pAiMesh->HasBones())
+/**
+ * Mesh geometry conversion running as a task on the shared thread pool.
+ * If no worker has started the conversion by the time the geometry is needed, the waiting thread runs it instead,
+ * so the wait never depends on a free worker. The destructor waits as well, as the conversion reads the aiScene.
+ */
+class MeshGeometryTask
+{
+public:
+    MeshGeometryTask(const aiScene* pScene, bool loadTangents)
+        : mpState(std::make_shared<State>([pScene, loadTangents]() { return convertMeshGeometry(pScene, loadTangents); }))
+    {
+        mFuture = mpState->task.get_future();
+        ThreadPool::get().submit([pState = mpState]() { pState->tryRun(); });
+    }
+
+    ~MeshGeometryTask()
+    {
+        if (mFuture.valid())
+        {
+            mpState->tryRun();
+            mFuture.wait();
+        }
+    }
+
+    std::vector<MeshGeometry> get()
+    {
+        mpState->tryRun();
+        return mFuture.get();
+    }
+
+private:
+    struct State
+    {
+        State(std::function<std::vector<MeshGeometry>()> func) : task(std::move(func)) {}
+
+        std::packaged_task<std::vector<MeshGeometry>()> task;
+        std::atomic<bool> claimed{false};
+
+        void tryRun()
+        {
+            if (!claimed.exchange(true))
+                task();
+        }
+    };
+
+    std::shared_ptr<State> mpState;
+    std::future<std::vector<MeshGeometry>> mFuture;
+};
+
+void createMeshes(ImporterData& data, std::vector<MeshGeometry>& geometry)
+{
+    // Pre-process meshes.
+    // Bone data depends on the scene graph and is packed here, in the same parallel pass as the mesh processing.
+    std::vector<SceneBuilder::ProcessedMesh> processedMeshes(geometry.size());
+    std::vector<std::exception_ptr> exceptions(geometry.size());
+    parallelFor(
+        0,
+        geometry.size(),
+        [&](size_t i)
+        {
+            MeshGeometry& g = geometry[i];
+            const aiMesh* pAiMesh = g.pAiMesh;
+            if (!pAiMesh)
+                return;
+
+            try
             {
-                loadBones(pAiMesh, data, boneWeights, boneIds);
-                mesh.boneIDs.pData = boneIds.data();
-                mesh.boneIDs.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
-                mesh.boneWeights.pData = boneWeights.data();
-                mesh.boneWeights.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
-            }
+                SceneBuilder::Mesh mesh;
+                mesh.name = pAiMesh->mName.C_Str();
+                mesh.faceCount = pAiMesh->mNumFaces;
+
+                // Temporary memory for the bone data.
+                std::vector<uint4> boneIds;
+                std::vector<float4> boneWeights;
+
+                // Indices
+                mesh.indexCount = (uint32_t)g.indices.size();
+                mesh.pIndices = g.indices.data();
+                mesh.topology = Vao::Topology::TriangleList;
+
+                // Vertices
+                FALCOR_ASSERT(pAiMesh->mVertices);
+                mesh.vertexCount = pAiMesh->mNumVertices;
+                static_assert(sizeof(pAiMesh->mVertices[0]) == sizeof(mesh.positions.pData[0]));
+                static_assert(sizeof(pAiMesh->mNormals[0]) == sizeof(mesh.normals.pData[0]));
+                mesh.positions.pData = reinterpret_cast<float3*>(pAiMesh->mVertices);
+                mesh.positions.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+                mesh.normals.pData = reinterpret_cast<float3*>(pAiMesh->mNormals);
+                mesh.normals.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+
+                if (!g.texCrds.empty())
+                {
+                    mesh.texCrds.pData = g.texCrds.data();
+                    mesh.texCrds.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+                }
 
-            mesh.pMaterial = data.materialMap.at(pAiMesh->mMaterialIndex);
+                if (!g.tangents.empty())
+                {
+                    mesh.tangents.pData = g.tangents.data();
+                    mesh.tangents.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+                }
+
+                if (pAiMesh->HasBones())
+                {
+                    loadBones(pAiMesh, data, boneWeights, boneIds);
+                    mesh.boneIDs.pData = boneIds.data();
+                    mesh.boneIDs.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+                    mesh.boneWeights.pData = boneWeights.data();
+                    mesh.boneWeights.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+                }
+
+                mesh.pMaterial = data.materialMap.at(pAiMesh->mMaterialIndex);
 
-            processedMeshes[i] = data.builder.processMesh(mesh);
+                processedMeshes[i] = data.builder.processMesh(mesh);
+            }
+            catch (...)
+            {
+                exceptions[i] = std::current_exception();
+            }
+
+            // Release the converted data early, it has been copied into the processed mesh.
+            g.indices = {};
+            g.texCrds = {};
+            g.tangents = {};
         }
     );
 
+    // Exceptions cannot propagate out of the parallel loop, rethrow the first one here.
+    for (const auto& e : exceptions)
+    {
+        if (e)
+            std::rethrow_exception(e);
+    }
+
     // Add meshes to the scene.
     // We retain a deterministic order of the meshes in the global scene buffer by adding
     // them sequentially after being processed in parallel.
@@ -666,7 +765,7 @@ void createMeshes(ImporterData& data)
     data.meshMap.resize(processedMeshes.size(), MeshID::Invalid());
     for (size_t i = 0; i < processedMeshes.size(); ++i)
     {
-        if (!meshes[i])
+        if (!geometry[i].pAiMesh)
             continue;
         data.meshMap[i] = data.builder.addProcessedMesh(processedMeshes[i]);
     }
@@ -1168,13 +1267,22 @@ void importInternal(const void* buffer, size_t byteSize, const std::filesystem::
 
     // dumpAssimpData(data);
 
+    // Convert mesh geometry on a pool task while materials and the scene graph are created.
+    // Material textures are loaded asynchronously as soon as each material is created, so they overlap with
+    // the geometry conversion as well.
+    const bool loadTangents = is_set(builderFlags, SceneBuilder::Flags::UseOriginalTangentSpace);
+    MeshGeometryTask geometryTask(pScene, loadTangents);
+
     createAllMaterials(data, searchPath, importMode);
     timeReport.measure("Creating materials");
 
     createSceneGraph(data);
     timeReport.measure("Creating scene graph");
 
-    createMeshes(data);
+    std::vector<MeshGeometry> geometry = geometryTask.get();
+    timeReport.measure("Converting mesh geometry");
+
+    createMeshes(data, geometry);
     addMeshInstances(data, data.pScene->mRootNode);
     timeReport.measure("Creating meshes");
 
@@ -28,15 +28,20 @@
 #include "MitsubaImporter.h"
 #include "Parser.h"
 #include "Tables.h"
+#include "SerializedMesh.h"
 #include "Utils/Math/Common.h"
 #include "Utils/Math/FalcorMath.h"
 #include "Utils/Math/MathHelpers.h"
+#include "Utils/Timing/TimeReport.h"
 #include "Scene/Material/PBRT/PBRTDiffuseMaterial.h"
 #include "Scene/Material/PBRT/PBRTDielectricMaterial.h"
 #include "Scene/Material/PBRT/PBRTConductorMaterial.h"
 
 #include <pybind11/pybind11.h>
 
+#include <map>
+#include <memory>
+#include <tuple>
 #include <unordered_map>
 
 namespace Falcor
@@ -80,10 +85,23 @@ Transform transformFromMatrix4x4(const float4x4& m)
 
 struct BuilderContext
 {
+    using SerializedMeshKey = std::tuple<std::string, uint32_t, bool>; // filename, shape index, face normals
+
     SceneBuilder& builder;
     std::unordered_map<std::string, XMLObject>& instances;
     std::unordered_set<std::string> warnings;
 
+    std::map<std::string, std::unique_ptr<SerializedFile>> serializedFiles;
+    std::map<SerializedMeshKey, std::shared_ptr<SerializedMesh>> serializedMeshes; ///< Preloaded meshes, removed when used.
+
+    const SerializedFile& getSerializedFile(const std::string& filename)
+    {
+        auto& pFile = serializedFiles[filename];
+        if (!pFile)
+            pFile = std::make_unique<SerializedFile>(filename);
+        return *pFile;
+    }
+
     void forEachReference(const XMLObject& inst, Class cls, std::function<void(const XMLObject&)> func)
     {
         for (const auto& [name, id] : inst.props.getNamedReferences())
@@ -114,6 +132,7 @@ struct BuilderContext
 struct ShapeInfo
 {
     ref<TriangleMesh> pMesh;
+    std::shared_ptr<SerializedMesh> pSerializedMesh;
     float4x4 transform;
     ref<Material> pMaterial;
 };
@@ -490,6 +509,28 @@ ShapeInfo buildShape(BuilderContext& ctx, const XMLObject& inst)
             shape.pMesh->setName(inst.id);
         shape.transform = toWorld;
     }
+    else if (inst.type == "serialized")
+    {
+        auto filename = props.getString("filename");
+        auto shapeIndex = (uint32_t)props.getInt("shape_index", 0);
+        auto faceNormals = props.getBool("face_normals", false);
+
+        // Use the preloaded mesh if available, otherwise load it now.
+        auto it = ctx.serializedMeshes.find({filename, shapeIndex, faceNormals});
+        if (it != ctx.serializedMeshes.end())
+        {
+            shape.pSerializedMesh = std::move(it->second);
+            ctx.serializedMeshes.erase(it);
+        }
+        else
+        {
+            shape.pSerializedMesh =
+                std::make_shared<SerializedMesh>(ctx.getSerializedFile(filename).loadMesh(shapeIndex, faceNormals));
+        }
+        if (shape.pSerializedMesh->name.empty())
+            shape.pSerializedMesh->name = inst.id;
+        shape.transform = toWorld;
+    }
     else if (inst.type == "sphere")
     {
         auto center = props.getFloat3("center", float3(0.f));
@@ -723,6 +764,65 @@ EmitterInfo buildEmitter(BuilderContext& ctx, const XMLObject& inst)
     return emitter;
 }
 
+/**
+ * Load the meshes of all 'serialized' shapes in the scene in parallel.
+ * The meshes are stored in the context and picked up by buildShape().
+ */
+void preloadSerializedMeshes(BuilderContext& ctx, const XMLObject& inst)
+{
+    FALCOR_ASSERT(inst.cls == Class::Scene);
+
+    std::vector<BuilderContext::SerializedMeshKey> keys;
+    std::vector<SerializedFile::MeshRequest> requests;
+
+    for (const auto& [name, id] : inst.props.getNamedReferences())
+    {
+        const auto& child = ctx.instances[id];
+        if (child.cls != Class::Shape || child.type != "serialized")
+            continue;
+
+        BuilderContext::SerializedMeshKey key{
+            child.props.getString("filename"),
+            (uint32_t)child.props.getInt("shape_index", 0),
+            child.props.getBool("face_normals", false),
+        };
+        if (ctx.serializedMeshes.count(key) > 0)
+            continue;
+        ctx.serializedMeshes[key] = nullptr;
+
+        requests.push_back({&ctx.getSerializedFile(std::get<0>(key)), std::get<1>(key), std::get<2>(key)});
+        keys.push_back(std::move(key));
+    }
+
+    auto meshes = SerializedFile::loadMeshes(requests);
+    for (size_t i = 0; i < meshes.size(); ++i)
+        ctx.serializedMeshes[keys[i]] = std::make_shared<SerializedMesh>(std::move(meshes[i]));
+}
+
+/**
+ * Add a mesh loaded from a .serialized file to the scene builder.
+ * The attribute arrays are referenced directly without conversion.
+ */
+MeshID addSerializedMesh(BuilderContext& ctx, const SerializedMesh& serializedMesh, const ref<Material>& pMaterial)
+{
+    using AttributeFrequency = SceneBuilder::Mesh::AttributeFrequency;
+
+    SceneBuilder::Mesh mesh;
+    mesh.name = serializedMesh.name;
+    mesh.faceCount = (uint32_t)(serializedMesh.indices.size() / 3);
+    mesh.vertexCount = (uint32_t)serializedMesh.positions.size();
+    mesh.indexCount = (uint32_t)serializedMesh.indices.size();
+    mesh.pIndices = serializedMesh.indices.data();
+    mesh.topology = Vao::Topology::TriangleList;
+    mesh.pMaterial = pMaterial;
+    mesh.positions = {serializedMesh.positions.data(), AttributeFrequency::Vertex};
+    mesh.normals = {serializedMesh.normals.data(), serializedMesh.faceNormals ? AttributeFrequency::Uniform : AttributeFrequency::Vertex};
+    if (!serializedMesh.texCoords.empty())
+        mesh.texCrds = {serializedMesh.texCoords.data(), AttributeFrequency::Vertex};
+
+    return ctx.builder.addMesh(mesh);
+}
+
 void buildScene(BuilderContext& ctx, const XMLObject& inst)
 {
     FALCOR_ASSERT(inst.cls == Class::Scene);
@@ -780,6 +880,13 @@ void buildScene(BuilderContext& ctx, const XMLObject& inst)
                 auto meshID = ctx.builder.addTriangleMesh(shape.pMesh, shape.pMaterial);
                 ctx.builder.addMeshInstance(nodeID, meshID);
             }
+            else if (shape.pSerializedMesh && shape.pMaterial)
+            {
+                SceneBuilder::Node node{id, shape.transform};
+                auto nodeID = ctx.builder.addNode(node);
+                auto meshID = addSerializedMesh(ctx, *shape.pSerializedMesh, shape.pMaterial);
+                ctx.builder.addMeshInstance(nodeID, meshID);
+            }
         }
         break;
         }
@@ -804,6 +911,8 @@ void MitsubaImporter::importScene(
 
     try
     {
+        TimeReport timeReport;
+
         pugi::xml_document doc;
         auto result = doc.load_file(path.c_str(), pugi::parse_default | pugi::parse_comments);
         if (!result)
@@ -816,9 +925,15 @@ void MitsubaImporter::importScene(
         pugi::xml_node root = doc.document_element();
         size_t argCounter = 0;
         auto sceneID = Mitsuba::parseXML(src, ctx, root, Mitsuba::Tag::Invalid, props, argCounter).second;
+        timeReport.measure("Parsing mitsuba scene");
 
         Mitsuba::BuilderContext builderCtx{builder, ctx.instances};
+        Mitsuba::preloadSerializedMeshes(builderCtx, builderCtx.instances[sceneID]);
+        timeReport.measure("Loading serialized meshes");
+
         Mitsuba::buildScene(builderCtx, builderCtx.instances[sceneID]);
+        timeReport.measure("Building mitsuba scene");
+        timeReport.printToLog();
     }
     catch (const RuntimeError& e)
     {
@@ -0,0 +1,322 @@
+/***************************************************************************
+ # Copyright (c) 2015-24, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "SerializedMesh.h"
+#include "Core/Error.h"
+#include "Utils/StringFormatters.h"
+#include "Utils/Math/VectorMath.h"
+#include "Utils/TaskManager.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <limits>
+
+namespace Falcor
+{
+namespace Mitsuba
+{
+namespace
+{
+// File format identifier and supported versions.
+// Version 3 uses 32-bit offsets in the offset table, version 4 uses 64-bit offsets and adds mesh names.
+const uint16_t kFormatID = 0x041C;
+const uint16_t kVersionV3 = 3;
+const uint16_t kVersionV4 = 4;
+
+// Mesh flags.
+const uint32_t kHasNormals = 0x0001;
+const uint32_t kHasTexCoords = 0x0002;
+const uint32_t kHasColors = 0x0008;
+const uint32_t kFaceNormals = 0x0010;
+const uint32_t kDoublePrecision = 0x2000;
+
+// Note: The file format is little-endian, which matches all platforms we support.
+template<typename T>
+T readValue(const uint8_t* pData)
+{
+    T value;
+    std::memcpy(&value, pData, sizeof(T));
+    return value;
+}
+
+/**
+ * Reads a zlib stream directly into caller provided memory.
+ */
+class InflateStream
+{
+public:
+    InflateStream(const std::filesystem::path& path, const uint8_t* pData, uint64_t size) : mPath(path)
+    {
+        if (inflateInit(&mStream) != Z_OK)
+            FALCOR_THROW("Failed to initialize zlib while reading '{}'.", mPath);
+        mpNext = pData;
+        mRemaining = size;
+    }
+
+    ~InflateStream() { inflateEnd(&mStream); }
+
+    void read(void* pDst, uint64_t size)
+    {
+        uint8_t* pOut = reinterpret_cast<uint8_t*>(pDst);
+        const uint64_t kMaxChunk = std::numeric_limits<uInt>::max();
+
+        while (size > 0)
+        {
+            if (mStream.avail_in == 0)
+            {
+                if (mRemaining == 0)
+                    FALCOR_THROW("Unexpected end of compressed data in '{}'.", mPath);
+                mStream.next_in = const_cast<Bytef*>(mpNext);
+                mStream.avail_in = (uInt)std::min(mRemaining, kMaxChunk);
+                mpNext += mStream.avail_in;
+                mRemaining -= mStream.avail_in;
+            }
+
+            uInt chunk = (uInt)std::min(size, kMaxChunk);
+            mStream.next_out = pOut;
+            mStream.avail_out = chunk;
+            int ret = inflate(&mStream, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END)
+                FALCOR_THROW("Failed to decompress data in '{}' (error: {}).", mPath, ret);
+
+            if (ret == Z_STREAM_END && mStream.avail_out != 0)
+                FALCOR_THROW("Unexpected end of compressed data in '{}'.", mPath);
+
+            uInt written = chunk - mStream.avail_out;
+            pOut += written;
+            size -= written;
+        }
+    }
+
+    template<typename T>
+    T read()
+    {
+        T value;
+        read(&value, sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    void readArray(std::vector<T>& data, uint64_t count, bool doublePrecision)
+    {
+        data.resize(count);
+        if (!doublePrecision)
+        {
+            read(data.data(), count * sizeof(T));
+        }
+        else
+        {
+            // Double precision data needs to be converted to float.
+            constexpr size_t kComponents = sizeof(T) / sizeof(float);
+            std::vector<double> tmp(count * kComponents);
+            read(tmp.data(), tmp.size() * sizeof(double));
+            float* pDst = reinterpret_cast<float*>(data.data());
+            std::transform(tmp.begin(), tmp.end(), pDst, [](double v) { return (float)v; });
+        }
+    }
+
+    void skip(uint64_t size)
+    {
+        std::vector<uint8_t> tmp(std::min<uint64_t>(size, 1 << 20));
+        while (size > 0)
+        {
+            uint64_t chunk = std::min<uint64_t>(size, tmp.size());
+            read(tmp.data(), chunk);
+            size -= chunk;
+        }
+    }
+
+private:
+    const std::filesystem::path& mPath;
+    z_stream mStream = {};
+    const uint8_t* mpNext = nullptr;
+    uint64_t mRemaining = 0;
+};
+
+void computeFaceNormals(SerializedMesh& mesh)
+{
+    const size_t faceCount = mesh.indices.size() / 3;
+    mesh.normals.resize(faceCount);
+    for (size_t i = 0; i < faceCount; ++i)
+    {
+        const float3& p0 = mesh.positions[mesh.indices[i * 3 + 0]];
+        const float3& p1 = mesh.positions[mesh.indices[i * 3 + 1]];
+        const float3& p2 = mesh.positions[mesh.indices[i * 3 + 2]];
+        float3 n = cross(p1 - p0, p2 - p0);
+        float len = length(n);
+        mesh.normals[i] = len > 0.f ? n / len : float3(0.f, 0.f, 1.f);
+    }
+}
+
+void computeVertexNormals(SerializedMesh& mesh)
+{
+    // Area-weighted average of the face normals.
+    mesh.normals.assign(mesh.positions.size(), float3(0.f));
+    for (size_t i = 0; i < mesh.indices.size(); i += 3)
+    {
+        uint32_t i0 = mesh.indices[i + 0], i1 = mesh.indices[i + 1], i2 = mesh.indices[i + 2];
+        float3 n = cross(mesh.positions[i1] - mesh.positions[i0], mesh.positions[i2] - mesh.positions[i0]);
+        mesh.normals[i0] += n;
+        mesh.normals[i1] += n;
+        mesh.normals[i2] += n;
+    }
+    for (auto& n : mesh.normals)
+    {
+        float len = length(n);
+        n = len > 0.f ? n / len : float3(0.f, 0.f, 1.f);
+    }
+}
+} // namespace
+
+SerializedFile::SerializedFile(const std::filesystem::path& path) : mPath(path)
+{
+    if (!mFile.open(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::RandomAccess))
+        FALCOR_THROW("Failed to open serialized mesh file '{}'.", path);
+
+    const uint8_t* pData = reinterpret_cast<const uint8_t*>(mFile.getData());
+    const uint64_t fileSize = mFile.getSize();
+
+    if (fileSize < 8)
+        FALCOR_THROW("Serialized mesh file '{}' is too small.", path);
+
+    if (readValue<uint16_t>(pData) != kFormatID)
+        FALCOR_THROW("Serialized mesh file '{}' has an invalid format identifier.", path);
+    mVersion = readValue<uint16_t>(pData + 2);
+    if (mVersion != kVersionV3 && mVersion != kVersionV4)
+        FALCOR_THROW("Serialized mesh file '{}' has unsupported version {}.", path, mVersion);
+
+    // The offset table is stored at the end of the file, followed by the mesh count.
+    const uint64_t meshCount = readValue<uint32_t>(pData + fileSize - 4);
+    const uint64_t offsetSize = mVersion == kVersionV4 ? sizeof(uint64_t) : sizeof(uint32_t);
+    if (meshCount == 0 || meshCount * offsetSize > fileSize - 4)
+        FALCOR_THROW("Serialized mesh file '{}' has an invalid offset table.", path);
+    const uint64_t tableOffset = fileSize - 4 - meshCount * offsetSize;
+
+    mMeshRanges.resize(meshCount);
+    for (uint64_t i = 0; i < meshCount; ++i)
+    {
+        const uint8_t* pEntry = pData + tableOffset + i * offsetSize;
+        mMeshRanges[i].offset = offsetSize == sizeof(uint64_t) ? readValue<uint64_t>(pEntry) : readValue<uint32_t>(pEntry);
+    }
+    for (uint64_t i = 0; i < meshCount; ++i)
+    {
+        uint64_t end = i + 1 < meshCount ? mMeshRanges[i + 1].offset : tableOffset;
+        if (mMeshRanges[i].offset + 4 > end)
+            FALCOR_THROW("Serialized mesh file '{}' has an invalid offset table.", path);
+        mMeshRanges[i].size = end - mMeshRanges[i].offset;
+    }
+}
+
+SerializedMesh SerializedFile::loadMesh(uint32_t meshIndex, bool faceNormals) const
+{
+    if (meshIndex >= mMeshRanges.size())
+        FALCOR_THROW("Serialized mesh file '{}' has no mesh with index {} ({} meshes).", mPath, meshIndex, mMeshRanges.size());
+
+    const MeshRange& range = mMeshRanges[meshIndex];
+    const uint8_t* pData = reinterpret_cast<const uint8_t*>(mFile.getData()) + range.offset;
+
+    if (readValue<uint16_t>(pData) != kFormatID)
+        FALCOR_THROW("Serialized mesh file '{}' has an invalid header for mesh {}.", mPath, meshIndex);
+    const uint16_t version = readValue<uint16_t>(pData + 2);
+
+    InflateStream stream(mPath, pData + 4, range.size - 4);
+    SerializedMesh mesh;
+
+    const uint32_t flags = stream.read<uint32_t>();
+    const bool doublePrecision = (flags & kDoublePrecision) != 0;
+
+    if (version >= kVersionV4)
+    {
+        for (char c = stream.read<char>(); c != 0; c = stream.read<char>())
+            mesh.name.push_back(c);
+    }
+
+    const uint64_t vertexCount = stream.read<uint64_t>();
+    const uint64_t triangleCount = stream.read<uint64_t>();
+    if (vertexCount > std::numeric_limits<uint32_t>::max() || triangleCount * 3 > std::numeric_limits<uint32_t>::max())
+        FALCOR_THROW("Mesh {} in '{}' is too large ({} vertices, {} triangles).", meshIndex, mPath, vertexCount, triangleCount);
+
+    stream.readArray(mesh.positions, vertexCount, doublePrecision);
+    if (flags & kHasNormals)
+        stream.readArray(mesh.normals, vertexCount, doublePrecision);
+    if (flags & kHasTexCoords)
+        stream.readArray(mesh.texCoords, vertexCount, doublePrecision);
+    if (flags & kHasColors)
+        stream.skip(vertexCount * 3 * (doublePrecision ? sizeof(double) : sizeof(float)));
+    stream.readArray(mesh.indices, triangleCount * 3, false);
+    for (uint32_t index : mesh.indices)
+    {
+        if (index >= vertexCount)
+            FALCOR_THROW("Mesh {} in '{}' has vertex index {} out of range ({} vertices).", meshIndex, mPath, index, vertexCount);
+    }
+
+    mesh.faceNormals = faceNormals || (flags & kFaceNormals) != 0;
+    if (mesh.faceNormals)
+        computeFaceNormals(mesh);
+    else if (mesh.normals.empty())
+        computeVertexNormals(mesh);
+
+    return mesh;
+}
+
+std::vector<SerializedMesh> SerializedFile::loadMeshes(const std::vector<MeshRequest>& requests)
+{
+    std::vector<SerializedMesh> meshes(requests.size());
+    std::vector<std::exception_ptr> exceptions(requests.size());
+
+    // Store the exceptions and rethrow the one of the first failing request, so that the error does not depend on the scheduling.
+    parallelFor(
+        0,
+        requests.size(),
+        [&](size_t i)
+        {
+            try
+            {
+                meshes[i] = requests[i].pFile->loadMesh(requests[i].meshIndex, requests[i].faceNormals);
+            }
+            catch (...)
+            {
+                exceptions[i] = std::current_exception();
+            }
+        }
+    );
+
+    for (const auto& exception : exceptions)
+    {
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+
+    return meshes;
+}
+
+} // namespace Mitsuba
+
+} // namespace Falcor
@@ -0,0 +1,115 @@
+/***************************************************************************
+ # Copyright (c) 2015-24, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Utils/Math/VectorTypes.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Falcor
+{
+namespace Mitsuba
+{
+/**
+ * Triangle mesh loaded from a Mitsuba .serialized file.
+ * The attribute arrays use the layout of SceneBuilder::Mesh so they can be referenced directly.
+ */
+struct SerializedMesh
+{
+    std::string name;
+    std::vector<float3> positions;
+    std::vector<float3> normals;   ///< Vertex normals, or face normals if `faceNormals` is set.
+    std::vector<float2> texCoords; ///< Empty if the mesh has no texture coordinates.
+    std::vector<uint32_t> indices;
+    bool faceNormals = false;
+};
+
+/**
+ * Reader for Mitsuba .serialized files.
+ *
+ * A .serialized file stores a sequence of zlib-compressed meshes followed by a table
+ * of the mesh offsets. The file is memory mapped and only the offset table is read on open.
+ * Meshes are decompressed on demand directly into the attribute arrays of a SerializedMesh.
+ * Loading meshes is thread-safe, see loadMeshes() for loading many meshes in parallel.
+ */
+class SerializedFile
+{
+public:
+    /**
+     * Open a .serialized file and read the mesh offset table.
+     * Throws if the file cannot be opened or is not a valid .serialized file.
+     * @param[in] path File path.
+     */
+    SerializedFile(const std::filesystem::path& path);
+
+    const std::filesystem::path& getPath() const { return mPath; }
+
+    /// Get the number of meshes in the file.
+    uint32_t getMeshCount() const { return (uint32_t)mMeshRanges.size(); }
+
+    /**
+     * Load a mesh.
+     * If the mesh has no vertex normals, smooth vertex normals are generated.
+     * @param[in] meshIndex Index of the mesh in the file (Mitsuba's `shape_index`).
+     * @param[in] faceNormals Generate face normals instead of using vertex normals.
+     * @return The loaded mesh.
+     */
+    SerializedMesh loadMesh(uint32_t meshIndex, bool faceNormals) const;
+
+    struct MeshRequest
+    {
+        const SerializedFile* pFile;
+        uint32_t meshIndex;
+        bool faceNormals;
+    };
+
+    /**
+     * Load a list of meshes in parallel. The meshes can be from different files.
+     * @param[in] requests Meshes to load.
+     * @return The loaded meshes, in the same order as the requests.
+     */
+    static std::vector<SerializedMesh> loadMeshes(const std::vector<MeshRequest>& requests);
+
+private:
+    struct MeshRange
+    {
+        uint64_t offset; ///< Offset of the mesh header in bytes.
+        uint64_t size;   ///< Size of the mesh including the header in bytes.
+    };
+
+    std::filesystem::path mPath;
+    MemoryMappedFile mFile;
+    uint16_t mVersion = 0;
+    std::vector<MeshRange> mMeshRanges;
+};
+
+} // namespace Mitsuba
+
+} // namespace Falcor
@@ -145,7 +145,7 @@ const MaterialSceneEntity& BasicScene::getMaterial(const MaterialRef& materialRe
     }
 }
 
-const SceneEntity& BasicScene::getAreaLight(int lightIndex)
+const SceneEntity& BasicScene::getAreaLight(int lightIndex) const
 {
     FALCOR_ASSERT(lightIndex >= 0 && lightIndex < mAreaLights.size());
     return mAreaLights[lightIndex];
@@ -214,6 +214,10 @@ std::string BasicScene::toString() const
 
 BasicSceneBuilder::BasicSceneBuilder(BasicScene& scene) : mScene(scene) {}
 
+BasicSceneBuilder::BasicSceneBuilder(std::unique_ptr<BasicScene> pImportScene)
+    : mpImportScene(std::move(pImportScene)), mScene(*mpImportScene)
+{}
+
 void BasicSceneBuilder::onReverseOrientation(FileLoc loc)
 {
     VERIFY_WORLD("ReverseOrientation");
@@ -479,6 +483,117 @@ void BasicSceneBuilder::onEndOfFiles()
     mScene.addInstances(mInstances);
 }
 
+std::unique_ptr<ParserTarget> BasicSceneBuilder::createImportTarget(FileLoc loc)
+{
+    // Files outside the world block or inside object definitions are parsed in place.
+    if (mCurrentBlock != BlockState::WorldBlock || mpActiveInstanceDefinition)
+        return nullptr;
+
+    auto pImportScene = std::make_unique<BasicScene>(mScene.getSearchPath());
+    auto pBuilder = std::unique_ptr<BasicSceneBuilder>(new BasicSceneBuilder(std::move(pImportScene)));
+    pBuilder->mCurrentBlock = mCurrentBlock;
+    pBuilder->mGraphicsState = mGraphicsState;
+    pBuilder->mNamedCoordinateSystems = mNamedCoordinateSystems;
+    pBuilder->mNamedMaterialNames = mNamedMaterialNames;
+    pBuilder->mMediumNames = mMediumNames;
+    pBuilder->mFloatTextureNames = mFloatTextureNames;
+    pBuilder->mSpectrumTextureNames = mSpectrumTextureNames;
+    pBuilder->mInstanceNames = mInstanceNames;
+
+    // An unnamed current material is referenced by index into this scene. Copy it to the start of the imported
+    // scene, so that the indices of the imported scene only refer to its own materials.
+    if (const uint32_t* pIndex = std::get_if<uint32_t>(&mGraphicsState.currentMaterial))
+    {
+        pBuilder->mInheritedMaterials.push_back(*pIndex);
+        pBuilder->mGraphicsState.currentMaterial = pBuilder->mScene.addMaterial(mScene.getMaterials()[*pIndex]);
+    }
+    return pBuilder;
+}
+
+void BasicSceneBuilder::mergeImportTarget(ParserTarget& importTarget, FileLoc loc)
+{
+    auto& imported = dynamic_cast<BasicSceneBuilder&>(importTarget);
+    const BasicScene& importedScene = *imported.mpImportScene;
+
+    if (!imported.mStack.empty())
+    {
+        throwError(loc, "Missing end to AttributeBegin in imported file.");
+    }
+
+    // Unnamed materials and area lights are referenced by index and need to be rebased.
+    // Inherited materials map back to the materials of this scene they were copied from.
+    const std::vector<uint32_t>& inheritedMaterials = imported.mInheritedMaterials;
+    const uint32_t materialOffset = (uint32_t)mScene.getMaterials().size() - (uint32_t)inheritedMaterials.size();
+    const int areaLightOffset = (int)mScene.getAreaLightCount();
+
+    const auto& importedMaterials = importedScene.getMaterials();
+    for (size_t i = inheritedMaterials.size(); i < importedMaterials.size(); ++i)
+    {
+        auto material = importedMaterials[i];
+        material.name = fmt::format("Unnamed{}", mUnamedMaterialIndex++);
+        mScene.addMaterial(std::move(material));
+    }
+    for (uint32_t i = 0; i < importedScene.getAreaLightCount(); ++i)
+    {
+        mScene.addAreaLight(importedScene.getAreaLight(i));
+    }
+
+    auto rebaseShape = [&](ShapeSceneEntity& shape)
+    {
+        if (uint32_t* pIndex = std::get_if<uint32_t>(&shape.materialRef))
+            *pIndex = *pIndex < inheritedMaterials.size() ? inheritedMaterials[*pIndex] : *pIndex + materialOffset;
+        if (shape.lightIndex >= 0)
+            shape.lightIndex += areaLightOffset;
+    };
+
+    // Named entities defined before the import were copied to the imported builder, so any name
+    // that is already defined here was defined after the 'Import' directive in the parent file.
+    for (const auto& [name, material] : importedScene.getNamedMaterials())
+    {
+        if (!mNamedMaterialNames.insert(name).second)
+            throwError(material.loc, "Redefining named material '{}'.", name);
+        mScene.addNamedMaterial(name, material);
+    }
+    for (const auto& medium : importedScene.getMedia())
+    {
+        if (!mMediumNames.insert(medium.name).second)
+            throwError(medium.loc, "Redefining named medium '{}'.", medium.name);
+        mScene.addMedium(medium);
+    }
+    for (const auto& [name, texture] : importedScene.getFloatTextures())
+    {
+        if (!mFloatTextureNames.insert(name).second)
+            throwError(texture.loc, "Redefining texture '{}'.", name);
+        mScene.addFloatTexture(name, texture);
+    }
+    for (const auto& [name, texture] : importedScene.getSpectrumTextures())
+    {
+        if (!mSpectrumTextureNames.insert(name).second)
+            throwError(texture.loc, "Redefining texture '{}'.", name);
+        mScene.addSpectrumTexture(name, texture);
+    }
+    for (const auto& light : importedScene.getLights())
+    {
+        mScene.addLight(light);
+    }
+    for (const auto& [name, definition] : importedScene.getInstanceDefinitions())
+    {
+        if (!mInstanceNames.insert(name).second)
+            throwError(definition.loc, "{}: trying to redefine an object instance.", name);
+        InstanceDefinitionSceneEntity rebased = definition;
+        for (auto& shape : rebased.shapes)
+            rebaseShape(shape);
+        mScene.addInstanceDefinition(std::move(rebased));
+    }
+
+    for (auto& shape : imported.mShapes)
+    {
+        rebaseShape(shape);
+        mShapes.push_back(std::move(shape));
+    }
+    std::move(imported.mInstances.begin(), imported.mInstances.end(), std::back_inserter(mInstances));
+}
+
 void BasicSceneBuilder::onOption(const std::string& name, const std::string& value, FileLoc loc)
 {
     // Options:
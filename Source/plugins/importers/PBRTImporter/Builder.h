@@ -269,7 +269,10 @@ public:
      */
     const MaterialSceneEntity& getMaterial(const MaterialRef& materialRef) const;
 
-    const SceneEntity& getAreaLight(int lightIndex);
+    const SceneEntity& getAreaLight(int lightIndex) const;
+    uint32_t getAreaLightCount() const { return (uint32_t)mAreaLights.size(); }
+
+    const std::filesystem::path& getSearchPath() const { return mSearchPath; }
 
     std::filesystem::path resolvePath(const std::filesystem::path& path) const;
 
@@ -387,7 +390,16 @@ public:
 
     void onEndOfFiles() override;
 
+    std::unique_ptr<ParserTarget> createImportTarget(FileLoc loc) override;
+    void mergeImportTarget(ParserTarget& importTarget, FileLoc loc) override;
+
 private:
+    /**
+     * Create a builder for an imported file. The builder adds entities to its own scene,
+     * which are merged into the parent scene in mergeImportTarget().
+     */
+    BasicSceneBuilder(std::unique_ptr<BasicScene> pImportScene);
+
     float4x4 getTransform() const { return mGraphicsState.ctm[0]; }
 
     static constexpr int kStartTransformBits = 1 << 0;
@@ -426,6 +438,7 @@ private:
         Float transformStartTime = 0, transformEndTime = 1;
     };
 
+    std::unique_ptr<BasicScene> mpImportScene; ///< Scene owned by builders created for imported files.
     BasicScene& mScene;
 
     enum class BlockState
@@ -459,6 +472,9 @@ private:
     std::unique_ptr<ActiveInstanceDefinition> mpActiveInstanceDefinition;
 
     uint32_t mUnamedMaterialIndex = 0;
+    /// Parent material indices of the materials an imported scene starts with. These are inherited through the
+    /// current material and are not added to the parent scene again in mergeImportTarget().
+    std::vector<uint32_t> mInheritedMaterials;
     std::set<std::string> mNamedMaterialNames;
     std::set<std::string> mMediumNames;
     std::set<std::string> mFloatTextureNames;
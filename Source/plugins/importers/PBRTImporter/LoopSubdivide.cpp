@@ -33,129 +33,32 @@
 
 #include "LoopSubdivide.h"
 #include "Core/Error.h"
+#include "Utils/TaskManager.h"
 
 #include <algorithm>
-#include <map>
-#include <memory>
-#include <memory_resource>
-#include <set>
+#include <limits>
+#include <unordered_map>
 
 #include <cmath>
 
 namespace Falcor::pbrt
 {
 
-struct SDFace;
-struct SDVertex;
-
-#define NEXT(i) (((i) + 1) % 3)
-#define PREV(i) (((i) + 2) % 3)
-
-struct SDVertex
+namespace
 {
-    SDVertex(const float3& p = float3(0.f)) : p(p) {}
+constexpr uint32_t kInvalid = std::numeric_limits<uint32_t>::max();
 
-    int valence();
-    void oneRing(float3* p);
+/// Number of vertices or faces processed by one parallel task. Each task reuses its scratch memory.
+constexpr size_t kBlockSize = 1024;
 
-    float3 p;
-    SDFace* startFace = nullptr;
-    SDVertex* child = nullptr;
-    bool regular = false;
-    bool boundary = false;
-};
-
-struct SDFace
+inline uint32_t nextHalfEdge(uint32_t h)
 {
-    SDFace()
-    {
-        for (uint32_t i = 0; i < 3; ++i)
-        {
-            v[i] = nullptr;
-            f[i] = nullptr;
-        }
-        for (uint32_t i = 0; i < 4; ++i)
-        {
-            children[i] = nullptr;
-        }
-    }
-
-    uint32_t vnum(SDVertex* vert) const
-    {
-        for (int i = 0; i < 3; ++i)
-        {
-            if (v[i] == vert)
-                return i;
-        }
-        FALCOR_THROW("Basic logic error in SDFace::vnum().");
-    }
-
-    SDFace* nextFace(SDVertex* vert) const { return f[vnum(vert)]; }
-    SDFace* prevFace(SDVertex* vert) const { return f[PREV(vnum(vert))]; }
-    SDVertex* nextVert(SDVertex* vert) const { return v[NEXT(vnum(vert))]; }
-    SDVertex* prevVert(SDVertex* vert) const { return v[PREV(vnum(vert))]; }
-    SDVertex* otherVert(SDVertex* v0, SDVertex* v1)
-    {
-        for (uint32_t i = 0; i < 3; ++i)
-        {
-            if (v[i] != v0 && v[i] != v1)
-                return v[i];
-        }
-        FALCOR_THROW("Basic logic error in SDFace::otherVert()");
-    }
-
-    SDVertex* v[3];
-    SDFace* f[3];
-    SDFace* children[4];
-};
-
-struct SDEdge
-{
-    SDEdge(SDVertex* v0 = nullptr, SDVertex* v1 = nullptr)
-    {
-        v[0] = std::min(v0, v1);
-        v[1] = std::max(v0, v1);
-        f[0] = f[1] = nullptr;
-        f0edgeNum = -1;
-    }
-
-    bool operator<(const SDEdge& e2) const
-    {
-        if (v[0] == e2.v[0])
-            return v[1] < e2.v[1];
-        return v[0] < e2.v[0];
-    }
-
-    SDVertex* v[2];
-    SDFace* f[2];
-    int f0edgeNum;
-};
-
-static float3 weightOneRing(SDVertex* vert, float beta);
-static float3 weightBoundary(SDVertex* vert, float beta);
+    return h % 3 == 2 ? h - 2 : h + 1;
+}
 
-inline int SDVertex::valence()
+inline uint32_t prevHalfEdge(uint32_t h)
 {
-    SDFace* f = startFace;
-    if (!boundary)
-    {
-        // Compute valence of interior vertex.
-        int nf = 1;
-        while ((f = f->nextFace(this)) != startFace)
-            ++nf;
-        return nf;
-    }
-    else
-    {
-        // Compute valence of boundary vertex
-        int nf = 1;
-        while ((f = f->nextFace(this)) != nullptr)
-            ++nf;
-        f = startFace;
-        while ((f = f->prevFace(this)) != nullptr)
-            ++nf;
-        return nf + 1;
-    }
+    return h % 3 == 0 ? h + 2 : h - 1;
 }
 
 inline float beta(uint32_t valence)
@@ -171,372 +74,431 @@ inline float loopGamma(uint32_t valence)
     return 1.f / (valence + 3.f / (8.f * beta(valence)));
 }
 
-LoopSubdivideResult loopSubdivide(uint32_t levels, fstd::span<const float3> positions, fstd::span<const uint32_t> indices)
+/**
+ * Run func(begin, end) over [0, count) in parallel, split into blocks of kBlockSize.
+ */
+template<typename Func>
+void parallelForBlocks(size_t count, Func func)
 {
-    std::vector<SDVertex*> vertices;
-    std::vector<SDFace*> faces;
+    parallelForRange(0, count, func, kBlockSize);
+}
 
-    // Allocate vertices and faces.
-    std::unique_ptr<SDVertex[]> vertexBuffer = std::make_unique<SDVertex[]>(positions.size());
-    for (size_t i = 0; i < positions.size(); ++i)
-    {
-        vertexBuffer[i] = SDVertex(positions[i]);
-        vertices.push_back(&vertexBuffer[i]);
-    }
-    size_t faceCount = indices.size() / 3;
-    std::unique_ptr<SDFace[]> fs = std::make_unique<SDFace[]>(faceCount);
-    for (size_t i = 0; i < faceCount; ++i)
+/**
+ * Triangle mesh stored as flat half-edge arrays.
+ * Half-edge h = 3 * face + k goes from corner k to corner k + 1 of the face, so the vertex indices double as
+ * the half-edge origins and the next/prev half-edges follow from the index alone.
+ */
+struct HalfEdgeMesh
+{
+    std::vector<float3> positions;
+    std::vector<uint32_t> indices;         ///< Origin vertex per half-edge.
+    std::vector<uint32_t> twins;           ///< Opposite half-edge or kInvalid on the boundary.
+    std::vector<uint32_t> vertexHalfEdges; ///< Outgoing half-edge the one-ring starts from or kInvalid for unreferenced vertices.
+    std::vector<uint8_t> boundary;         ///< Vertex is on the boundary.
+
+    size_t getVertexCount() const { return positions.size(); }
+    size_t getHalfEdgeCount() const { return indices.size(); }
+    uint32_t getDest(uint32_t h) const { return indices[nextHalfEdge(h)]; }
+
+    /**
+     * Gather the one-ring of vertex v.
+     * The order matches pbrt: interior rings rotate from the start half-edge, boundary rings run from one
+     * boundary neighbor to the other.
+     */
+    void getOneRing(uint32_t v, std::vector<uint32_t>& ring) const
     {
-        faces.push_back(&fs[i]);
-    }
+        ring.clear();
+        uint32_t start = vertexHalfEdges[v];
+        if (start == kInvalid)
+            return;
 
-    // Set face to vertex pointers.
-    {
-        const uint32_t* vp = indices.data();
-        for (size_t i = 0; i < faceCount; ++i, vp += 3)
+        if (!boundary[v])
         {
-            SDFace* f = faces[i];
-            for (uint32_t j = 0; j < 3; ++j)
+            uint32_t h = start;
+            do
             {
-                SDVertex* v = vertices[vp[j]];
-                f->v[j] = v;
-                v->startFace = f;
-            }
+                ring.push_back(getDest(h));
+                h = nextHalfEdge(twins[h]);
+            } while (h != start);
         }
-    }
-
-    // Set neighbor pointers in faces.
-    std::set<SDEdge> edges;
-    for (size_t i = 0; i < faceCount; ++i)
-    {
-        SDFace* f = faces[i];
-        for (uint32_t edgeNum = 0; edgeNum < 3; ++edgeNum)
+        else
         {
-            // Update neighbor pointer for edgeNum.
-            int v0 = edgeNum, v1 = NEXT(edgeNum);
-            SDEdge e(f->v[v0], f->v[v1]);
-            if (edges.find(e) == edges.end())
+            uint32_t h = start;
+            while (twins[h] != kInvalid)
+                h = nextHalfEdge(twins[h]);
+            ring.push_back(getDest(h));
+            do
             {
-                // Handle new edge.
-                e.f[0] = f;
-                e.f0edgeNum = edgeNum;
-                edges.insert(e);
-            }
-            else
-            {
-                // Handle previously seen edge.
-                e = *edges.find(e);
-                e.f[0]->f[e.f0edgeNum] = f;
-                f->f[edgeNum] = e.f[0];
-                edges.erase(e);
-            }
+                uint32_t prev = prevHalfEdge(h);
+                ring.push_back(indices[prev]);
+                h = twins[prev];
+            } while (h != kInvalid);
         }
     }
 
-    // Finish vertex initialization.
-    for (size_t i = 0; i < positions.size(); ++i)
+    float3 weightOneRing(uint32_t v, const std::vector<uint32_t>& ring, float beta) const
     {
-        SDVertex* v = vertices[i];
-        SDFace* f = v->startFace;
-        do
-        {
-            f = f->nextFace(v);
-        } while ((f != nullptr) && f != v->startFace);
-        v->boundary = (f == nullptr);
-        if (!v->boundary && v->valence() == 6)
-            v->regular = true;
-        else if (v->boundary && v->valence() == 4)
-            v->regular = true;
-        else
-            v->regular = false;
+        uint32_t valence = (uint32_t)ring.size();
+        float3 p = (1 - valence * beta) * positions[v];
+        for (uint32_t i = 0; i < valence; ++i)
+            p += beta * positions[ring[i]];
+        return p;
     }
 
-    // Refine LoopSubdiv into triangles.
-    std::vector<SDFace*> f = faces;
-    std::vector<SDVertex*> v = vertices;
-
-    std::pmr::monotonic_buffer_resource buffer;
-    std::pmr::polymorphic_allocator<SDVertex> vertexAllocator(&buffer);
-    std::pmr::polymorphic_allocator<SDFace> faceAllocator(&buffer);
+    float3 weightBoundary(uint32_t v, const std::vector<uint32_t>& ring, float beta) const
+    {
+        float3 p = (1 - 2 * beta) * positions[v];
+        p += beta * positions[ring.front()];
+        p += beta * positions[ring.back()];
+        return p;
+    }
+};
 
-    for (size_t i = 0; i < levels; ++i)
+HalfEdgeMesh createHalfEdgeMesh(fstd::span<const float3> positions, fstd::span<const uint32_t> indices)
+{
+    FALCOR_CHECK(indices.size() % 3 == 0, "Index count must be a multiple of 3, got {}.", indices.size());
+    FALCOR_CHECK(indices.size() < kInvalid, "Too many indices ({}).", indices.size());
+
+    HalfEdgeMesh mesh;
+    mesh.positions.assign(positions.begin(), positions.end());
+    mesh.indices.assign(indices.begin(), indices.end());
+    mesh.twins.resize(indices.size(), kInvalid);
+    mesh.vertexHalfEdges.resize(positions.size(), kInvalid);
+    mesh.boundary.resize(positions.size(), 0);
+
+    // Set start half-edges, the last face referencing a vertex wins.
+    for (uint32_t h = 0; h < (uint32_t)indices.size(); ++h)
     {
-        // Update f and v for next level of subdivision.
-        std::vector<SDFace*> newFaces;
-        std::vector<SDVertex*> newVertices;
+        FALCOR_CHECK(indices[h] < positions.size(), "Vertex index {} is out of range.", indices[h]);
+        mesh.vertexHalfEdges[indices[h]] = h;
+    }
 
-        // Allocate next level of children in mesh tree.
-        for (SDVertex* vertex : v)
+    // Pair up half-edges. Edges seen a third time (non-manifold) start a new pair.
+    std::unordered_map<uint64_t, uint32_t> openEdges;
+    openEdges.reserve(indices.size());
+    for (uint32_t h = 0; h < (uint32_t)indices.size(); ++h)
+    {
+        uint64_t v0 = mesh.indices[h];
+        uint64_t v1 = mesh.getDest(h);
+        uint64_t key = (std::min(v0, v1) << 32) | std::max(v0, v1);
+        auto [it, inserted] = openEdges.try_emplace(key, h);
+        if (!inserted)
         {
-            vertex->child = vertexAllocator.allocate(1);
-            vertex->child->regular = vertex->regular;
-            vertex->child->boundary = vertex->boundary;
-            newVertices.push_back(vertex->child);
+            mesh.twins[it->second] = h;
+            mesh.twins[h] = it->second;
+            openEdges.erase(it);
         }
-        for (SDFace* face : f)
+    }
+
+    // Classify boundary vertices.
+    parallelForBlocks(
+        mesh.getVertexCount(),
+        [&](size_t begin, size_t end)
         {
-            for (uint32_t k = 0; k < 4; ++k)
+            for (size_t v = begin; v < end; ++v)
             {
-                face->children[k] = faceAllocator.allocate(1);
-                newFaces.push_back(face->children[k]);
+                uint32_t start = mesh.vertexHalfEdges[v];
+                if (start == kInvalid)
+                    continue;
+                uint32_t h = start;
+                do
+                {
+                    h = mesh.twins[h] != kInvalid ? nextHalfEdge(mesh.twins[h]) : kInvalid;
+                } while (h != kInvalid && h != start);
+                mesh.boundary[v] = h == kInvalid;
             }
         }
+    );
 
-        // Update vertex positions and create new edge vertices.
+    return mesh;
+}
 
-        // Update vertex positions for even vertices.
-        for (SDVertex* vertex : v)
+float getMaxEdgeLength(const HalfEdgeMesh& mesh)
+{
+    const size_t halfEdgeCount = mesh.getHalfEdgeCount();
+    std::vector<float> blockMax((halfEdgeCount + kBlockSize - 1) / kBlockSize, 0.f);
+    parallelForBlocks(
+        halfEdgeCount,
+        [&](size_t begin, size_t end)
         {
-            if (!vertex->boundary)
-            {
-                // Apply one-ring rule for even vertex.
-                if (vertex->regular)
-                    vertex->child->p = weightOneRing(vertex, 1.f / 16.f);
-                else
-                    vertex->child->p = weightOneRing(vertex, beta(vertex->valence()));
-            }
-            else
+            float maxLength = 0.f;
+            for (uint32_t h = (uint32_t)begin; h < (uint32_t)end; ++h)
+                maxLength = std::max(maxLength, length(mesh.positions[mesh.getDest(h)] - mesh.positions[mesh.indices[h]]));
+            blockMax[begin / kBlockSize] = maxLength;
+        }
+    );
+    return blockMax.empty() ? 0.f : *std::max_element(blockMax.begin(), blockMax.end());
+}
+
+/**
+ * Apply one level of Loop subdivision.
+ * Each face is split into four children stored at 4 * face + [0..3], where child k keeps corner k of the parent
+ * and child 3 is the center face. Even (original) vertices keep their index, odd (edge) vertices are appended in
+ * the order pbrt creates them, so the result is identical to the pointer-based implementation.
+ */
+HalfEdgeMesh subdivide(const HalfEdgeMesh& mesh)
+{
+    const uint32_t vertexCount = (uint32_t)mesh.getVertexCount();
+    const uint32_t halfEdgeCount = (uint32_t)mesh.getHalfEdgeCount();
+    const uint32_t faceCount = halfEdgeCount / 3;
+    FALCOR_CHECK(halfEdgeCount <= kInvalid / 4, "Subdivided mesh is too large.");
+
+    // Assign odd vertices to edges. The first half-edge of an edge owns its vertex.
+    auto isOwner = [&](uint32_t h) { return mesh.twins[h] == kInvalid || h < mesh.twins[h]; };
+    std::vector<uint32_t> owners(halfEdgeCount);
+    parallelForBlocks(
+        halfEdgeCount,
+        [&](size_t begin, size_t end)
+        {
+            for (uint32_t h = (uint32_t)begin; h < (uint32_t)end; ++h)
+                owners[h] = isOwner(h) ? 1 : 0;
+        }
+    );
+    std::vector<uint32_t> oddVertices(halfEdgeCount);
+    const uint32_t newVertexCount = parallelExclusiveScan(owners.begin(), owners.end(), oddVertices.begin(), vertexCount);
+    parallelForBlocks(
+        halfEdgeCount,
+        [&](size_t begin, size_t end)
+        {
+            for (uint32_t h = (uint32_t)begin; h < (uint32_t)end; ++h)
             {
-                // Apply boundary rule for even vertex.
-                vertex->child->p = weightBoundary(vertex, 1.f / 8.f);
+                if (!isOwner(h))
+                    oddVertices[h] = oddVertices[mesh.twins[h]];
             }
         }
-
-        // Compute new odd edge vertices.
-        std::map<SDEdge, SDVertex*> edgeVerts;
-        for (SDFace* face : f)
+    );
+
+    HalfEdgeMesh result;
+    result.positions.resize(newVertexCount);
+    result.indices.resize(4 * halfEdgeCount);
+    result.twins.resize(4 * halfEdgeCount);
+    result.vertexHalfEdges.resize(newVertexCount);
+    result.boundary.resize(newVertexCount);
+
+    // Update vertex positions for even vertices.
+    parallelForBlocks(
+        vertexCount,
+        [&](size_t begin, size_t end)
         {
-            for (uint32_t k = 0; k < 3; ++k)
+            std::vector<uint32_t> ring;
+            for (uint32_t v = (uint32_t)begin; v < (uint32_t)end; ++v)
             {
-                // Compute odd vertex on kth edge.
-                SDEdge edge(face->v[k], face->v[NEXT(k)]);
-                SDVertex* vert = edgeVerts[edge];
-                if (vert == nullptr)
+                uint32_t start = mesh.vertexHalfEdges[v];
+                result.boundary[v] = mesh.boundary[v];
+                if (start == kInvalid)
                 {
-                    // Create and initialize new odd vertex
-                    vert = vertexAllocator.allocate(1);
-                    newVertices.push_back(vert);
-                    vert->regular = true;
-                    vert->boundary = (face->f[k] == nullptr);
-                    vert->startFace = face->children[3];
-
-                    // Apply edge rules to compute new vertex position
-                    if (vert->boundary)
-                    {
-                        vert->p = 0.5f * edge.v[0]->p;
-                        vert->p += 0.5f * edge.v[1]->p;
-                    }
-                    else
-                    {
-                        vert->p = 3.f / 8.f * edge.v[0]->p;
-                        vert->p += 3.f / 8.f * edge.v[1]->p;
-                        vert->p += 1.f / 8.f * face->otherVert(edge.v[0], edge.v[1])->p;
-                        vert->p += 1.f / 8.f * face->f[k]->otherVert(edge.v[0], edge.v[1])->p;
-                    }
-                    edgeVerts[edge] = vert;
+                    result.positions[v] = mesh.positions[v];
+                    result.vertexHalfEdges[v] = kInvalid;
+                    continue;
                 }
-            }
-        }
 
-        // Update new mesh topology.
+                mesh.getOneRing(v, ring);
+                if (!mesh.boundary[v])
+                    result.positions[v] = mesh.weightOneRing(v, ring, beta((uint32_t)ring.size())); // Apply one-ring rule.
+                else
+                    result.positions[v] = mesh.weightBoundary(v, ring, 1.f / 8.f); // Apply boundary rule.
 
-        // Update even vertex face pointers.
-        for (SDVertex* vertex : v)
-        {
-            int vertNum = vertex->startFace->vnum(vertex);
-            vertex->child->startFace = vertex->startFace->children[vertNum];
+                // Start from the child face at the same corner.
+                uint32_t face = start / 3, k = start % 3;
+                result.vertexHalfEdges[v] = 3 * (4 * face + k) + k;
+            }
         }
+    );
 
-        // Update face neighbor pointers.
-        for (SDFace* face : f)
+    // Compute new odd edge vertices.
+    parallelForBlocks(
+        halfEdgeCount,
+        [&](size_t begin, size_t end)
         {
-            for (uint32_t j = 0; j < 3; ++j)
+            for (uint32_t h = (uint32_t)begin; h < (uint32_t)end; ++h)
             {
-                // Update children f pointers for siblings.
-                face->children[3]->f[j] = face->children[NEXT(j)];
-                face->children[j]->f[NEXT(j)] = face->children[3];
-
-                // Update children f pointers for neighbor children.
-                SDFace* f2 = face->f[j];
-                face->children[j]->f[j] = f2 != nullptr ? f2->children[f2->vnum(face->v[j])] : nullptr;
-                f2 = face->f[PREV(j)];
-                face->children[j]->f[PREV(j)] = f2 != nullptr ? f2->children[f2->vnum(face->v[j])] : nullptr;
+                if (!isOwner(h))
+                    continue;
+
+                const uint32_t v = oddVertices[h];
+                const uint32_t twin = mesh.twins[h];
+                const float3& p0 = mesh.positions[mesh.indices[h]];
+                const float3& p1 = mesh.positions[mesh.getDest(h)];
+                float3 p;
+                if (twin == kInvalid)
+                {
+                    p = 0.5f * p0;
+                    p += 0.5f * p1;
+                }
+                else
+                {
+                    p = 3.f / 8.f * p0;
+                    p += 3.f / 8.f * p1;
+                    p += 1.f / 8.f * mesh.positions[mesh.indices[prevHalfEdge(h)]];
+                    p += 1.f / 8.f * mesh.positions[mesh.indices[prevHalfEdge(twin)]];
+                }
+                result.positions[v] = p;
+                result.boundary[v] = twin == kInvalid;
+
+                // Start from the center child face of the owning face.
+                uint32_t face = h / 3, k = h % 3;
+                result.vertexHalfEdges[v] = 3 * (4 * face + 3) + k;
             }
         }
+    );
 
-        // Update face vertex pointers.
-        for (SDFace* face : f)
+    // Update new mesh topology.
+    parallelForBlocks(
+        faceCount,
+        [&](size_t begin, size_t end)
         {
-            for (uint32_t j = 0; j < 3; ++j)
+            for (uint32_t face = (uint32_t)begin; face < (uint32_t)end; ++face)
             {
-                // Update child vertex pointer to new even vertex
-                face->children[j]->v[j] = face->v[j]->child;
-
-                // Update child vertex pointer to new odd vertex
-                SDVertex* vert = edgeVerts[SDEdge(face->v[j], face->v[NEXT(j)])];
-                face->children[j]->v[NEXT(j)] = vert;
-                face->children[NEXT(j)]->v[j] = vert;
-                face->children[3]->v[j] = vert;
+                const uint32_t center = 4 * face + 3;
+                for (uint32_t j = 0; j < 3; ++j)
+                {
+                    const uint32_t h = 3 * face + j;
+                    const uint32_t prev = prevHalfEdge(h);
+                    const uint32_t child = 4 * face + j;
+                    const uint32_t jNext = (j + 1) % 3, jPrev = (j + 2) % 3;
+
+                    // Child j keeps the parent corner j and connects it to the odd vertices of the two adjacent edges.
+                    result.indices[3 * child + j] = mesh.indices[h];
+                    result.indices[3 * child + jNext] = oddVertices[h];
+                    result.indices[3 * child + jPrev] = oddVertices[prev];
+                    result.indices[3 * center + j] = oddVertices[h];
+
+                    // First half of parent edge j pairs with the second half of the twin edge in the neighbor.
+                    if (uint32_t twin = mesh.twins[h]; twin != kInvalid)
+                        result.twins[3 * child + j] = 3 * (4 * (twin / 3) + (twin % 3 + 1) % 3) + twin % 3;
+                    else
+                        result.twins[3 * child + j] = kInvalid;
+
+                    // Second half of parent edge j - 1 pairs with the first half of the twin edge in the neighbor.
+                    if (uint32_t twin = mesh.twins[prev]; twin != kInvalid)
+                        result.twins[3 * child + jPrev] = 3 * (4 * (twin / 3) + twin % 3) + twin % 3;
+                    else
+                        result.twins[3 * child + jPrev] = kInvalid;
+
+                    // Interior edge between child j and the center child.
+                    result.twins[3 * child + jNext] = 3 * center + jPrev;
+                    result.twins[3 * center + jPrev] = 3 * child + jNext;
+                }
             }
         }
+    );
 
-        // Prepare for next level of subdivision
-        f = newFaces;
-        v = newVertices;
-    }
+    return result;
+}
 
-    // Push vertices to limit surface.
-    std::vector<float3> pLimit(v.size());
-    for (size_t i = 0; i < v.size(); ++i)
-    {
-        if (v[i]->boundary)
-            pLimit[i] = weightBoundary(v[i], 1.f / 5.f);
-        else
-            pLimit[i] = weightOneRing(v[i], loopGamma(v[i]->valence()));
-    }
-    for (size_t i = 0; i < v.size(); ++i)
+/**
+ * Compute the vertex normal on the limit surface from the cross product of the limit tangents.
+ */
+float3 computeLimitNormal(const HalfEdgeMesh& mesh, uint32_t v, const std::vector<uint32_t>& ring)
+{
+    const uint32_t valence = (uint32_t)ring.size();
+    if (valence == 0)
+        return float3(0.f);
+
+    const float3& p = mesh.positions[v];
+    auto pRing = [&](uint32_t j) { return mesh.positions[ring[j]]; };
+
+    float3 S(0.f);
+    float3 T(0.f);
+    if (!mesh.boundary[v])
     {
-        v[i]->p = pLimit[i];
+        // Compute tangents of interior face
+        for (uint32_t j = 0; j < valence; ++j)
+        {
+            S += std::cos(2.f * float(M_PI) * j / valence) * pRing(j);
+            T += std::sin(2.f * float(M_PI) * j / valence) * pRing(j);
+        }
     }
-
-    // Compute vertex tangents on limit surface.
-    std::vector<float3> Ns;
-    Ns.reserve(v.size());
-    std::vector<float3> pRing(16, float3());
-    for (SDVertex* vertex : v)
+    else
     {
-        float3 S(0.f);
-        float3 T(0.f);
-        uint32_t valence = vertex->valence();
-        if (valence > pRing.size())
-            pRing.resize(valence);
-        vertex->oneRing(&pRing[0]);
-        if (!vertex->boundary)
+        // Compute tangents of boundary face
+        S = pRing(valence - 1) - pRing(0);
+        if (valence == 2)
         {
-            // Compute tangents of interior face
-            for (uint32_t j = 0; j < valence; ++j)
-            {
-                S += std::cos(2.f * float(M_PI) * j / valence) * float3(pRing[j]);
-                T += std::sin(2.f * float(M_PI) * j / valence) * float3(pRing[j]);
-            }
+            T = float3(pRing(0) + pRing(1) - 2.f * p);
         }
-        else
+        else if (valence == 3)
         {
-            // Compute tangents of boundary face
-            S = pRing[valence - 1] - pRing[0];
-            if (valence == 2)
-            {
-                T = float3(pRing[0] + pRing[1] - 2.f * vertex->p);
-            }
-            else if (valence == 3)
-            {
-                T = pRing[1] - vertex->p;
-            }
-            else if (valence == 4) // regular
-            {
-                T = float3(-1.f * pRing[0] + 2.f * pRing[1] + 2.f * pRing[2] + -1.f * pRing[3] + -2.f * vertex->p);
-            }
-            else
-            {
-                float theta = float(M_PI) / float(valence - 1);
-                T = float3(std::sin(theta) * (pRing[0] + pRing[valence - 1]));
-                for (uint32_t k = 1; k < valence - 1; ++k)
-                {
-                    float wt = (2 * std::cos(theta) - 2) * std::sin((k)*theta);
-                    T += float3(wt * pRing[k]);
-                }
-                T = -T;
-            }
+            T = pRing(1) - p;
         }
-        Ns.push_back(cross(S, T));
-    }
-
-    // Create triangle mesh from subdivision mesh
-    {
-        size_t ntris = f.size();
-        std::vector<uint32_t> verts(3 * ntris);
-        uint32_t* vp = verts.data();
-        uint32_t totVerts = (uint32_t)v.size();
-        std::map<SDVertex*, uint32_t> usedVerts;
-        for (uint32_t i = 0; i < totVerts; ++i)
+        else if (valence == 4) // regular
         {
-            usedVerts[v[i]] = i;
+            T = float3(-1.f * pRing(0) + 2.f * pRing(1) + 2.f * pRing(2) + -1.f * pRing(3) + -2.f * p);
         }
-        for (size_t i = 0; i < ntris; ++i)
+        else
         {
-            for (uint32_t j = 0; j < 3; ++j)
+            float theta = float(M_PI) / float(valence - 1);
+            T = float3(std::sin(theta) * (pRing(0) + pRing(valence - 1)));
+            for (uint32_t k = 1; k < valence - 1; ++k)
             {
-                *vp = usedVerts[f[i]->v[j]];
-                ++vp;
+                float wt = (2 * std::cos(theta) - 2) * std::sin((k)*theta);
+                T += float3(wt * pRing(k));
             }
+            T = -T;
         }
-
-        LoopSubdivideResult result;
-        result.positions = std::move(pLimit);
-        result.normals = std::move(Ns);
-        result.indices = std::move(verts);
-        return result;
     }
+    return cross(S, T);
 }
 
-static float3 weightOneRing(SDVertex* vert, float beta)
-{
-    // Put vert one-ring in pRing.
-    uint32_t valence = vert->valence();
-    FALCOR_ASSERT(valence < 16);
-    float3 pRing[16];
-
-    vert->oneRing(pRing);
-    float3 p = (1 - valence * beta) * vert->p;
-    for (uint32_t i = 0; i < valence; ++i)
-    {
-        p += beta * pRing[i];
-    }
-    return p;
-}
+} // namespace
 
-void SDVertex::oneRing(float3* p_)
+LoopSubdivideResult loopSubdivide(uint32_t levels, fstd::span<const float3> positions, fstd::span<const uint32_t> indices, float maxEdgeLength)
 {
-    if (!boundary)
+    HalfEdgeMesh mesh = createHalfEdgeMesh(positions, indices);
+
+    // Refine LoopSubdiv into triangles.
+    uint32_t level = 0;
+    for (; level < levels; ++level)
     {
-        // Get one-ring vertices for interior vertex.
-        SDFace* face = startFace;
-        do
-        {
-            *p_++ = face->nextVert(this)->p;
-            face = face->nextFace(this);
-        } while (face != startFace);
+        // In adaptive mode, stop once all edges are short enough.
+        if (maxEdgeLength > 0.f && getMaxEdgeLength(mesh) <= maxEdgeLength)
+            break;
+        mesh = subdivide(mesh);
     }
-    else
-    {
-        // Get one-ring vertices for boundary vertex.
-        SDFace* face = startFace;
-        SDFace* f2;
-        while ((f2 = face->nextFace(this)) != nullptr)
+
+    // Push vertices to limit surface.
+    const size_t vertexCount = mesh.getVertexCount();
+    std::vector<float3> pLimit(vertexCount);
+    parallelForBlocks(
+        vertexCount,
+        [&](size_t begin, size_t end)
         {
-            face = f2;
+            std::vector<uint32_t> ring;
+            for (uint32_t v = (uint32_t)begin; v < (uint32_t)end; ++v)
+            {
+                mesh.getOneRing(v, ring);
+                if (ring.empty())
+                    pLimit[v] = mesh.positions[v];
+                else if (mesh.boundary[v])
+                    pLimit[v] = mesh.weightBoundary(v, ring, 1.f / 5.f);
+                else
+                    pLimit[v] = mesh.weightOneRing(v, ring, loopGamma((uint32_t)ring.size()));
+            }
         }
-        *p_++ = face->nextVert(this)->p;
-        do
+    );
+    mesh.positions = std::move(pLimit);
+
+    // Compute vertex normals on limit surface.
+    std::vector<float3> normals(vertexCount);
+    parallelForBlocks(
+        vertexCount,
+        [&](size_t begin, size_t end)
         {
-            *p_++ = face->prevVert(this)->p;
-            face = face->prevFace(this);
-        } while (face != nullptr);
-    }
-}
-
-static float3 weightBoundary(SDVertex* vert, float beta)
-{
-    // Put vert one-ring in pRing.
-    uint32_t valence = vert->valence();
-    FALCOR_ASSERT(valence < 16);
-    float3 pRing[16];
-
-    vert->oneRing(pRing);
-    float3 p = (1 - 2 * beta) * vert->p;
-    p += beta * pRing[0];
-    p += beta * pRing[valence - 1];
-    return p;
+            std::vector<uint32_t> ring;
+            for (uint32_t v = (uint32_t)begin; v < (uint32_t)end; ++v)
+            {
+                mesh.getOneRing(v, ring);
+                normals[v] = computeLimitNormal(mesh, v, ring);
+            }
+        }
+    );
+
+    LoopSubdivideResult result;
+    result.positions = std::move(mesh.positions);
+    result.normals = std::move(normals);
+    result.indices = std::move(mesh.indices);
+    result.levels = level;
+    return result;
 }
 
 } // namespace Falcor::pbrt
@@ -44,8 +44,24 @@ struct LoopSubdivideResult
     std::vector<float3> positions;
     std::vector<float3> normals;
     std::vector<uint32_t> indices;
+    uint32_t levels = 0; ///< Number of subdivision levels that were applied.
 };
 
-LoopSubdivideResult loopSubdivide(uint32_t levels, fstd::span<const float3> positions, fstd::span<const uint32_t> vertices);
+/**
+ * Subdivide a triangle mesh using Loop subdivision and push the vertices to the limit surface.
+ * Each level is processed in parallel.
+ * @param[in] levels Maximum number of subdivision levels.
+ * @param[in] positions Vertex positions.
+ * @param[in] indices Triangle vertex indices.
+ * @param[in] maxEdgeLength If positive, subdivision stops before a level when no edge of the mesh is longer than this.
+ *                          Use 0 to always subdivide to the given number of levels.
+ * @return The subdivided mesh.
+ */
+LoopSubdivideResult loopSubdivide(
+    uint32_t levels,
+    fstd::span<const float3> positions,
+    fstd::span<const uint32_t> indices,
+    float maxEdgeLength = 0.f
+);
 
 } // namespace Falcor::pbrt
@@ -71,6 +71,7 @@
 #include "Utils/Timing/TimeReport.h"
 #include "Utils/Math/FalcorMath.h"
 #include "Utils/Math/FNVHash.h"
+#include "Utils/CryptoUtils.h"
 #include "Scene/Importer.h"
 #include "Scene/Material/Material.h"
 #include "Scene/Material/StandardMaterial.h"
@@ -86,6 +87,8 @@
 
 #include <pybind11/pybind11.h>
 
+#include <algorithm>
+#include <cstring>
 #include <unordered_map>
 
 namespace Falcor
@@ -201,10 +204,70 @@ struct CurveAggregate
     std::vector<float> widths;     ///< Concatenated list of widths of all strands.
 };
 
+/**
+ * Holds the geometry of an object definition (ObjectBegin/ObjectEnd).
+ * The geometry is created once and shared by all instances of the object.
+ * Geometry is grouped by transform so that each instance only needs a single node per group.
+ */
 struct InstanceDefinition
 {
-    std::vector<std::pair<MeshID, float4x4>> meshes;  // List of meshID + transform
-    std::vector<std::pair<CurveID, float4x4>> curves; // List of curveID + transfrom
+    struct Group
+    {
+        float4x4 transform = float4x4::identity();
+        std::vector<MeshID> meshes;
+        std::vector<CurveID> curves;
+    };
+
+    struct TransformHash
+    {
+        std::size_t operator()(const float4x4& transform) const { return fnvHashArray64(&transform, sizeof(transform)); }
+    };
+
+    std::vector<Group> groups;
+    std::unordered_map<float4x4, size_t, TransformHash> groupIndices; ///< Index of the group for each transform.
+    uint64_t triangleCount = 0;
+
+    Group& getGroup(const float4x4& transform)
+    {
+        auto [it, inserted] = groupIndices.try_emplace(transform, groups.size());
+        if (inserted)
+            groups.push_back(Group{transform});
+        return groups[it->second];
+    }
+};
+
+/**
+ * Identifies triangle meshes that were added to the scene builder.
+ * Used to detect meshes with identical content, which are then shared instead of being added again.
+ * Only a SHA-1 digest of the content and the sizes are kept to not hold on to the mesh data.
+ * Meshes with the same key are compared against the mesh data in the scene builder before they are shared.
+ */
+struct UniqueMesh
+{
+    /// SHA-1 digest of the vertices and indices, vertex count, index count, front face winding and material.
+    using Key = std::tuple<SHA1::MD, size_t, size_t, bool, const Falcor::Material*>;
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const
+        {
+            std::size_t hash;
+            std::memcpy(&hash, std::get<0>(key).data(), sizeof(hash));
+            return hash;
+        }
+    };
+};
+
+/**
+ * Statistics about instancing and mesh sharing.
+ */
+struct InstancingStats
+{
+    uint64_t instanceCount = 0;          ///< Number of object instances.
+    uint64_t instanceNodeCount = 0;      ///< Number of scene graph nodes created for object instances.
+    uint64_t uniqueMeshCount = 0;        ///< Number of meshes added to the scene builder.
+    uint64_t sharedMeshCount = 0;        ///< Number of meshes that were replaced by an identical mesh.
+    uint64_t uniqueTriangleCount = 0;    ///< Number of triangles in meshes added to the scene builder.
+    uint64_t instancedTriangleCount = 0; ///< Number of triangles after instancing.
 };
 
 struct BuilderContext
@@ -226,9 +289,13 @@ struct BuilderContext
 
     std::map<std::string, InstanceDefinition> instanceDefinitions;
 
+    std::unordered_map<UniqueMesh::Key, std::vector<MeshID>, UniqueMesh::KeyHash> uniqueMeshes; ///< Unique meshes by content.
+    InstancingStats instancingStats;
+
     size_t curveCount = 0;
 
     bool usePBRTMaterials = false;
+    float loopSubdivMaxEdgeLength = 0.f; ///< World space edge length at which loop subdivision stops early (0 = disabled).
 
     Falcor::ref<Falcor::Material> getMaterial(const MaterialRef& materialRef)
     {
@@ -1614,8 +1681,19 @@ Shape createShape(BuilderContext& ctx, const ShapeSceneEntity& entity)
         if (P.empty())
             throwError(entity.loc, "Missing vertex positions in 'P'.");
 
-        auto result =
-            loopSubdivide(levels, P, fstd::span<const uint32_t>(reinterpret_cast<const uint32_t*>(indices.data()), indices.size()));
+        // In adaptive mode, convert the world space edge length to object space using the largest scale of the transform.
+        float maxEdgeLength = 0.f;
+        if (ctx.loopSubdivMaxEdgeLength > 0.f)
+        {
+            const float4x4& M = entity.transform;
+            float scale = std::max({length(M.getCol(0).xyz()), length(M.getCol(1).xyz()), length(M.getCol(2).xyz())});
+            if (scale > 0.f)
+                maxEdgeLength = ctx.loopSubdivMaxEdgeLength / scale;
+        }
+
+        auto result = loopSubdivide(
+            levels, P, fstd::span<const uint32_t>(reinterpret_cast<const uint32_t*>(indices.data()), indices.size()), maxEdgeLength
+        );
 
         Falcor::TriangleMesh::VertexList vertexList(result.positions.size());
         for (size_t i = 0; i < result.positions.size(); ++i)
@@ -1754,6 +1832,39 @@ std::variant<Falcor::MeshID, Falcor::CurveID> createCurveGeometry(BuilderContext
     }
 }
 
+/**
+ * Add a triangle mesh to the scene builder.
+ * If a mesh with identical content and material has been added before, the existing mesh is returned instead.
+ */
+Falcor::MeshID addUniqueTriangleMesh(BuilderContext& ctx, const Shape& shape)
+{
+    const auto& vertices = shape.pTriangleMesh->getVertices();
+    const auto& indices = shape.pTriangleMesh->getIndices();
+    const bool frontFaceCW = shape.pTriangleMesh->getFrontFaceCW();
+
+    SHA1 sha1;
+    sha1.update(vertices.data(), vertices.size() * sizeof(vertices[0]));
+    sha1.update(indices.data(), indices.size() * sizeof(indices[0]));
+    UniqueMesh::Key key{sha1.finalize(), vertices.size(), indices.size(), frontFaceCW, shape.pMaterial.get()};
+
+    // Confirm the content of meshes with the same key to never share different meshes.
+    auto& meshIDs = ctx.uniqueMeshes[key];
+    for (MeshID meshID : meshIDs)
+    {
+        if (ctx.builder.compareTriangleMesh(meshID, *shape.pTriangleMesh))
+        {
+            ctx.instancingStats.sharedMeshCount++;
+            return meshID;
+        }
+    }
+
+    auto meshID = ctx.builder.addTriangleMesh(shape.pTriangleMesh, shape.pMaterial);
+    meshIDs.push_back(meshID);
+    ctx.instancingStats.uniqueMeshCount++;
+    ctx.instancingStats.uniqueTriangleCount += indices.size() / 3;
+    return meshID;
+}
+
 InstanceDefinition createInstanceDefinition(BuilderContext& ctx, const InstanceDefinitionSceneEntity& entity)
 {
     InstanceDefinition instanceDefinition;
@@ -1764,8 +1875,9 @@ InstanceDefinition createInstanceDefinition(BuilderContext& ctx, const InstanceD
         auto shape = createShape(ctx, shapeEntity);
         if (shape.pTriangleMesh)
         {
-            auto meshID = ctx.builder.addTriangleMesh(shape.pTriangleMesh, shape.pMaterial);
-            instanceDefinition.meshes.emplace_back(meshID, shape.transform);
+            auto meshID = addUniqueTriangleMesh(ctx, shape);
+            instanceDefinition.getGroup(shape.transform).meshes.push_back(meshID);
+            instanceDefinition.triangleCount += shape.pTriangleMesh->getIndices().size() / 3;
         }
 
         // Create curves from curve aggregates assembled during the processing step above.
@@ -1774,11 +1886,11 @@ InstanceDefinition createInstanceDefinition(BuilderContext& ctx, const InstanceD
             auto meshOrCurveID = createCurveGeometry(ctx, curveAggregate);
             if (auto meshID = std::get_if<Falcor::MeshID>(&meshOrCurveID))
             {
-                instanceDefinition.meshes.emplace_back(*meshID, curveAggregate.transform);
+                instanceDefinition.getGroup(curveAggregate.transform).meshes.push_back(*meshID);
             }
             else if (auto curveID = std::get_if<Falcor::CurveID>(&meshOrCurveID))
             {
-                instanceDefinition.curves.emplace_back(*curveID, curveAggregate.transform);
+                instanceDefinition.getGroup(curveAggregate.transform).curves.push_back(*curveID);
             }
             else
             {
@@ -1849,8 +1961,9 @@ void buildScene(BuilderContext& ctx)
         if (shape.pTriangleMesh)
         {
             auto nodeID = ctx.builder.addNode({entity.name, shape.transform});
-            auto meshID = ctx.builder.addTriangleMesh(shape.pTriangleMesh, shape.pMaterial);
+            auto meshID = addUniqueTriangleMesh(ctx, shape);
             ctx.builder.addMeshInstance(nodeID, meshID);
+            ctx.instancingStats.instancedTriangleCount += shape.pTriangleMesh->getIndices().size() / 3;
         }
     }
 
@@ -1874,7 +1987,7 @@ void buildScene(BuilderContext& ctx)
     }
     ctx.curveAggregates.clear();
 
-    auto getInstanceDefinition = [&ctx](const InstanceSceneEntity& entity)
+    auto getInstanceDefinition = [&ctx](const InstanceSceneEntity& entity) -> const InstanceDefinition&
     {
         auto it = ctx.instanceDefinitions.find(entity.name);
         if (it == ctx.instanceDefinitions.end())
@@ -1890,18 +2003,40 @@ void buildScene(BuilderContext& ctx)
     };
 
     // Create instanced shapes.
+    // The geometry of each object definition is shared, instances only add a node per transform group.
     for (const auto& entity : ctx.scene.getInstances())
     {
         const auto& instanceDefinition = getInstanceDefinition(entity);
         auto instanceTransform = entity.transform;
 
-        // Instantiate meshes.
-        for (const auto& [meshID, transform] : instanceDefinition.meshes)
+        for (const auto& group : instanceDefinition.groups)
         {
-            auto nodeID = ctx.builder.addNode({"instance", mul(instanceTransform, transform)});
-            ctx.builder.addMeshInstance(nodeID, meshID);
+            auto nodeID = ctx.builder.addNode({"instance", mul(instanceTransform, group.transform)});
+            for (auto meshID : group.meshes)
+                ctx.builder.addMeshInstance(nodeID, meshID);
+            for (auto curveID : group.curves)
+                ctx.builder.addCurveInstance(nodeID, curveID);
         }
-    }
+
+        ctx.instancingStats.instanceCount++;
+        ctx.instancingStats.instanceNodeCount += instanceDefinition.groups.size();
+        ctx.instancingStats.instancedTriangleCount += instanceDefinition.triangleCount;
+    }
+
+    const auto& stats = ctx.instancingStats;
+    logInfo(
+        "PBRTImporter: Created {} object instances ({} nodes) of {} object definitions.",
+        stats.instanceCount,
+        stats.instanceNodeCount,
+        ctx.instanceDefinitions.size()
+    );
+    logInfo(
+        "PBRTImporter: Added {} unique meshes ({} shared), {} unique triangles, {} instanced triangles.",
+        stats.uniqueMeshCount,
+        stats.sharedMeshCount,
+        stats.uniqueTriangleCount,
+        stats.instancedTriangleCount
+    );
 }
 
 } // namespace pbrt
@@ -1930,6 +2065,7 @@ void PBRTImporter::importScene(
 
         pbrt::BuilderContext ctx{pbrtScene, builder};
         ctx.usePBRTMaterials = builder.getSettings().getOption("PBRTImporter:usePBRTMaterials", false);
+        ctx.loopSubdivMaxEdgeLength = builder.getSettings().getOption("PBRTImporter:loopSubdivMaxEdgeLength", 0.f);
         pbrt::buildScene(ctx);
         timeReport.measure("Building pbrt scene");
         timeReport.printToLog();
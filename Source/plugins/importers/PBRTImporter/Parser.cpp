@@ -36,10 +36,14 @@
 #include "Core/Error.h"
 #include "Core/Platform/OS.h"
 #include "Utils/Logger.h"
+#include "Utils/TaskManager.h"
 
 #include <fast_float/fast_float.h>
 
 #include <atomic>
+#include <future>
+#include <mutex>
+#include <set>
 #include <utility>
 #include <charconv>
 
@@ -107,9 +111,7 @@ std::unique_ptr<Tokenizer> Tokenizer::createFromString(std::string str)
 
 Tokenizer::Tokenizer(std::string str, const std::filesystem::path& path) : mPath(path), mContents(std::move(str))
 {
-    auto pFilename = std::make_unique<std::string>(path.string());
-    mLoc = FileLoc(*pFilename);
-    getFilenames().push_back(std::move(pFilename));
+    mLoc = FileLoc(registerFilename(path));
 
     mPos = mContents.data();
     mEnd = mPos + mContents.size();
@@ -117,6 +119,24 @@ Tokenizer::Tokenizer(std::string str, const std::filesystem::path& path) : mPath
         throwError("File is encoded with UTF-16, which is not currently supported.");
 }
 
+void Tokenizer::rewind()
+{
+    mLoc = FileLoc(mLoc.filename);
+    mPos = mContents.data();
+}
+
+std::string_view Tokenizer::registerFilename(const std::filesystem::path& path)
+{
+    static std::mutex mutex;
+    static std::vector<std::unique_ptr<std::string>> filenames;
+
+    auto pFilename = std::make_unique<std::string>(path.string());
+    std::string_view filename = *pFilename;
+    std::lock_guard<std::mutex> lock(mutex);
+    filenames.push_back(std::move(pFilename));
+    return filename;
+}
+
 bool Tokenizer::isUTF16(const void* ptr, size_t len) const
 {
     auto c = reinterpret_cast<const unsigned char*>(ptr);
@@ -448,14 +468,79 @@ static ParsedParameterVector parseParameters(Next nextToken, Unget ungetToken)
     return parameterVector;
 }
 
-void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
+/**
+ * A file that is parsed on a worker thread into a separate target.
+ * Imports found while parsing the file are recorded as children and merged into the job's target.
+ * The job is run by whichever thread claims it first, the worker thread or the thread waiting for it.
+ */
+struct ImportJob
+{
+    FileLoc loc;
+    std::filesystem::path searchPath;
+    std::unique_ptr<Tokenizer> pTokenizer;
+    std::unique_ptr<ParserTarget> pTarget;
+    std::atomic<bool> claimed{false};
+    std::promise<void> finished;
+    std::future<void> future = finished.get_future();
+    std::vector<std::shared_ptr<ImportJob>> children;
+};
+
+using ImportJobList = std::vector<std::shared_ptr<ImportJob>>;
+
+static bool tryRunImportJob(ImportJob& job);
+
+/**
+ * Check if a file only contains shapes and self-contained attribute blocks.
+ * Such files don't modify the graphics state of the including file and can be parsed in parallel just like 'Import'.
+ * The tokenizer is rewound to the start of the file before returning.
+ */
+static bool isShapeOnlyFile(Tokenizer& tokenizer)
+{
+    // Directives that only modify the graphics state and are allowed inside attribute blocks.
+    static const std::set<std::string_view> kAttributeDirectives = {
+        "Attribute", "AreaLightSource", "ConcatTransform", "CoordSysTransform", "Identity", "Material", "MediumInterface",
+        "NamedMaterial", "ReverseOrientation", "Rotate", "Scale", "Transform", "Translate",
+    };
+
+    bool shapeOnly = true;
+    int depth = 0;
+
+    while (shapeOnly)
+    {
+        std::optional<Token> tok = tokenizer.next();
+        if (!tok.has_value())
+            break;
+
+        // All directives start with an upper case letter, skip parameters, comments and values.
+        char c = tok->token[0];
+        if (c < 'A' || c > 'Z')
+            continue;
+
+        if (tok->token == "Shape")
+            continue;
+        else if (tok->token == "AttributeBegin" || tok->token == "TransformBegin")
+            ++depth;
+        else if (tok->token == "AttributeEnd" || tok->token == "TransformEnd")
+            shapeOnly = --depth >= 0;
+        else
+            shapeOnly = depth > 0 && kAttributeDirectives.count(tok->token) > 0;
+    }
+
+    tokenizer.rewind();
+    return shapeOnly && depth == 0;
+}
+
+static void parse(
+    ParserTarget& target,
+    std::unique_ptr<Tokenizer> tokenizer,
+    const std::filesystem::path& searchPath,
+    ImportJobList& importJobs
+)
 {
     static std::atomic<bool> warnedTransformBeginEndDeprecated{false};
 
     logInfo("PBRTImporter: Started parsing '{}'.", tokenizer->getPath().string());
 
-    auto searchPath = tokenizer->getPath().parent_path();
-
     std::vector<std::unique_ptr<Tokenizer>> fileStack;
     fileStack.push_back(std::move(tokenizer));
 
@@ -518,6 +603,28 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
         (target.*apiFunc)(n, std::move(parameterVector), loc);
     };
 
+    /**
+     * Helper function that parses a file on a worker thread into a new target created by the current target.
+     * Returns false if the target does not support this, in which case the file needs to be parsed in place.
+     */
+    auto parseAsync = [&](std::unique_ptr<Tokenizer>& pTokenizer, FileLoc loc) -> bool
+    {
+        std::unique_ptr<ParserTarget> pImportTarget = target.createImportTarget(loc);
+        if (!pImportTarget)
+            return false;
+
+        auto pJob = std::make_shared<ImportJob>();
+        pJob->loc = loc;
+        pJob->searchPath = searchPath;
+        pJob->pTokenizer = std::move(pTokenizer);
+        pJob->pTarget = std::move(pImportTarget);
+
+        // Jobs never wait on other jobs, nested imports are recorded in the job's children and merged later.
+        ThreadPool::get().submit([pJob]() { tryRunImportJob(*pJob); });
+        importJobs.push_back(std::move(pJob));
+        return true;
+    };
+
     auto syntaxError = [&](const Token& t)
     {
         if (t.token == "WorldEnd")
@@ -628,18 +735,20 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
             {
                 basicParamListEntrypoint(&ParserTarget::onIntegrator, tok->loc);
             }
-            else if (tok->token == "Include")
+            else if (tok->token == "Include" || tok->token == "Import")
             {
                 Token filenameToken = *nextToken(TokenRequired);
                 std::string filename = toString(dequoteString(filenameToken));
                 auto path = searchPath / filename;
                 std::unique_ptr<Tokenizer> includeTokenizer = Tokenizer::createFromFile(path);
-                logInfo("PBRTImporter: Started parsing '{}'.", includeTokenizer->getPath().string());
-                fileStack.push_back(std::move(includeTokenizer));
-            }
-            else if (tok->token == "Import")
-            {
-                throwError(tok->loc, "'Import' directive not supported yet.");
+
+                // Included files are parsed in place unless they only contain shapes.
+                bool isImport = tok->token == "Import" || isShapeOnlyFile(*includeTokenizer);
+                if (!isImport || !parseAsync(includeTokenizer, tok->loc))
+                {
+                    logInfo("PBRTImporter: Started parsing '{}'.", includeTokenizer->getPath().string());
+                    fileStack.push_back(std::move(includeTokenizer));
+                }
             }
             else if (tok->token == "Identity")
             {
@@ -876,18 +985,91 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
     }
 }
 
-void parseFile(ParserTarget& target, const std::filesystem::path& path)
+/**
+ * Run an import job unless another thread has already claimed it.
+ * @return True if the job was run on the calling thread.
+ */
+static bool tryRunImportJob(ImportJob& job)
+{
+    if (job.claimed.exchange(true))
+        return false;
+
+    try
+    {
+        parse(*job.pTarget, std::move(job.pTokenizer), job.searchPath, job.children);
+        job.finished.set_value();
+    }
+    catch (...)
+    {
+        job.finished.set_exception(std::current_exception());
+    }
+    return true;
+}
+
+/**
+ * Wait for import jobs and merge them into the target in the order they appear in the scene files.
+ * Nested imports are merged into their parent job's target first, making the result independent of scheduling.
+ * Jobs that have not started yet are run on the calling thread, so waiting never depends on a free worker thread.
+ */
+static void mergeImports(ParserTarget& target, ImportJobList& importJobs)
+{
+    for (auto& pJob : importJobs)
+    {
+        tryRunImportJob(*pJob);
+        pJob->future.get();
+        mergeImports(*pJob->pTarget, pJob->children);
+        target.mergeImportTarget(*pJob->pTarget, pJob->loc);
+        pJob->pTarget.reset();
+    }
+}
+
+/**
+ * Skip the import jobs that have not started yet and wait for the running ones, including their nested imports.
+ * Running jobs write to targets created by the parser targets, so they need to finish before an error is propagated.
+ */
+static void cancelImports(ImportJobList& importJobs)
+{
+    for (auto& pJob : importJobs)
+    {
+        if (!pJob->claimed.exchange(true))
+        {
+            pJob->pTokenizer.reset();
+            pJob->pTarget.reset();
+            continue;
+        }
+        // Jobs that were already merged have no future left to wait for.
+        if (pJob->future.valid())
+            pJob->future.wait();
+        cancelImports(pJob->children);
+    }
+}
+
+static void parseTopLevel(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
 {
-    auto tokenizer = Tokenizer::createFromFile(path);
-    parse(target, std::move(tokenizer));
+    auto searchPath = tokenizer->getPath().parent_path();
+    ImportJobList importJobs;
+
+    try
+    {
+        parse(target, std::move(tokenizer), searchPath, importJobs);
+        mergeImports(target, importJobs);
+    }
+    catch (...)
+    {
+        cancelImports(importJobs);
+        throw;
+    }
     target.onEndOfFiles();
 }
 
+void parseFile(ParserTarget& target, const std::filesystem::path& path)
+{
+    parseTopLevel(target, Tokenizer::createFromFile(path));
+}
+
 void parseString(ParserTarget& target, std::string str)
 {
-    auto tokenizer = Tokenizer::createFromString(std::move(str));
-    parse(target, std::move(tokenizer));
-    target.onEndOfFiles();
+    parseTopLevel(target, Tokenizer::createFromString(std::move(str)));
 }
 
 } // namespace Falcor::pbrt
@@ -99,6 +99,19 @@ public:
     virtual void onObjectInstance(const std::string& name, FileLoc loc) = 0;
 
     virtual void onEndOfFiles() = 0;
+
+    /**
+     * Create a separate target for parsing an imported file on a worker thread.
+     * The new target starts out with a copy of the current graphics state.
+     * @return The new target or nullptr if the file needs to be parsed in place (like 'Include').
+     */
+    virtual std::unique_ptr<ParserTarget> createImportTarget(FileLoc loc) = 0;
+
+    /**
+     * Merge a target created by createImportTarget() back into this target.
+     * This is always called on the thread that owns this target and in the order the imports appear in the file.
+     */
+    virtual void mergeImportTarget(ParserTarget& importTarget, FileLoc loc) = 0;
 };
 
 void parseFile(ParserTarget& target, const std::filesystem::path& path);
@@ -129,16 +142,17 @@ public:
 
     const std::filesystem::path& getPath() const { return mPath; }
 
+    /**
+     * Rewind the tokenizer to the start of the file.
+     */
+    void rewind();
+
 private:
     /**
-     * Static list of filenames to allow file locations (FileLoc::filename) to be valid
-     * even after the tokenizer is destroyed.
+     * Register a filename in a static list to allow file locations (FileLoc::filename) to be valid
+     * even after the tokenizer is destroyed. This is thread-safe as files may be tokenized in parallel.
      */
-    static std::vector<std::unique_ptr<std::string>>& getFilenames()
-    {
-        static std::vector<std::unique_ptr<std::string>> filenames;
-        return filenames;
-    }
+    static std::string_view registerFilename(const std::filesystem::path& path);
 
     bool isUTF16(const void* ptr, size_t len) const;
 